@@ -29,7 +29,10 @@
 #include "app_common.h"
 #include "app_aws.h"
 #include "app_oled.h"
-#include "cJSON.h"
+#include "app_telemetry.h"
+#include "app_journal.h"
+#include "app_usb_msd.h"
+#include "app_json.h"
 #include "iot_network_wolfssl.h"
 
 // *****************************************************************************
@@ -39,7 +42,7 @@ char g_Aws_ClientID[CLIENT_IDENTIFIER_MAX_LENGTH];
 
 // *****************************************************************************
 
-/* Publish to cloud every 'PUBLISH_FREQUENCY_MS' milliseconds */
+/* Check the telemetry flush policy every 'PUBLISH_FREQUENCY_MS' milliseconds */
 static void pubTimerCallback(uintptr_t context) {
     appAwsData.publishToCloud = true;
 }
@@ -98,31 +101,13 @@ static void MqttCallback( void * param1,
         
         APP_AWS_DBG(SYS_ERROR_DEBUG, "%.*s \r\n",pPublish->u.message.info.payloadLength, pPayload);
     
-        cJSON *messageJson = cJSON_Parse(pPayload);
-        if (messageJson == NULL) {
-            const char *error_ptr = cJSON_GetErrorPtr();
-            if (error_ptr != NULL) {
-                APP_AWS_DBG(SYS_ERROR_ERROR, "Message JSON parse Error. Error before: %s \r\n", error_ptr);
-            }
-            cJSON_Delete(messageJson);
+        /* Read the desired state in place; the payload is not NUL terminated */
+        bool desiredState;
+        if (!APP_JSON_GetBool(pPayload, pPublish->u.message.info.payloadLength, "state.toggle", &desiredState)) {
+            APP_AWS_DBG(SYS_ERROR_ERROR, "Message JSON parse Error. No state.toggle \r\n");
             return;
         }
 
-        //Get the desired state
-        cJSON *state = cJSON_GetObjectItem(messageJson, "state");
-        if (!state) {
-            cJSON_Delete(messageJson);
-            return;
-        }
-        
-        //Get the toggle state
-        cJSON *toggle = cJSON_GetObjectItem(state, "toggle");
-        if (!toggle) {
-            cJSON_Delete(messageJson);
-            return;
-        }
-
-        bool desiredState = (bool)toggle->valueint;
         if (desiredState) {
             APP_AWS_PRNT("LED ON \r\n");
             APP_manageLed(LED_YELLOW, LED_S_BLINK_STARTING_ON, BLINK_MODE_SINGLE);
@@ -130,7 +115,6 @@ static void MqttCallback( void * param1,
             APP_AWS_PRNT("LED OFF \r\n");
             APP_manageLed(LED_YELLOW, LED_S_BLINK_STARTING_OFF, BLINK_MODE_SINGLE);
         }
-        cJSON_Delete(messageJson);
         
         /* Publish LED state to shadow/update/ */
         appAwsData.shadowUpdate = true;
@@ -140,81 +124,145 @@ static void MqttCallback( void * param1,
 
 // *****************************************************************************
 
+/* Shadow updates go out right away; the journal backlog is replayed before
+ * newer telemetry so that samples reach the cloud in order. */
+typedef enum
+{
+    APP_AWS_LANE_SHADOW,
+    APP_AWS_LANE_BACKLOG,
+    APP_AWS_LANE_TELEMETRY
+} APP_AWS_PUBLISH_LANE;
+
+/* Payload writer context of publishMessage() */
+typedef struct
+{
+    APP_AWS_PUBLISH_LANE lane;
+    APP_TELEMETRY_FORMAT format;
+    uint32_t sampleCount;
+    size_t payloadLength;
+} APP_AWS_PAYLOAD_CONTEXT;
+
+/* Writes the shadow update or a telemetry batch straight into the MQTT packet. */
+static size_t writePublishPayload(void * pContext, uint8_t * pBuffer, size_t bufferSize)
+{
+    APP_AWS_PAYLOAD_CONTEXT * pPayload = (APP_AWS_PAYLOAD_CONTEXT *) pContext;
+    int status;
+    
+    if((pPayload->lane == APP_AWS_LANE_SHADOW)
+            || ((pPayload->lane == APP_AWS_LANE_TELEMETRY) && (pPayload->format == APP_TELEMETRY_FORMAT_SINGLE))){
+        if(pPayload->lane == APP_AWS_LANE_SHADOW)
+            status = snprintf((char *) pBuffer, bufferSize, APP_AWS_SHADOW_MSG_TEMPLATE, !LED_YELLOW_Get());
+        else{
+            /* The latest reading supersedes the samples queued since the last tick */
+            pPayload->sampleCount = APP_TELEMETRY_Count();
+#if 1
+            status = snprintf((char *) pBuffer, bufferSize,
+                    APP_AWS_TELEMETRY_MSG_TEMPLATE, 
+                    APP_readTemp(),
+                    APP_readLight());
+#else
+            /*Graduation step to include an additional sensor data. 
+            Comment out the above code block by changing the '#if 1' to '#if 0'*/
+            status = snprintf((char *) pBuffer, bufferSize,
+                    APP_AWS_TELEMETRY_MSG_GRAD_TEMPLATE, 
+                    APP_readTemp(),
+                    APP_readLight(),
+                    !SWITCH1_Get());
+#endif
+        }
+        /* Errors and truncation fail the publish. */
+        if((status < 0) || ((size_t) status >= bufferSize))
+            pPayload->payloadLength = bufferSize + 1;
+        else
+            pPayload->payloadLength = (size_t) status;
+    }
+    else if(pPayload->lane == APP_AWS_LANE_BACKLOG)
+        pPayload->payloadLength = APP_JOURNAL_Write((char *) pBuffer, bufferSize, &pPayload->sampleCount);
+    else
+        pPayload->payloadLength = APP_TELEMETRY_Write((char *) pBuffer, bufferSize, &pPayload->sampleCount);
+    
+    if(pPayload->payloadLength > bufferSize)
+        APP_AWS_DBG(SYS_ERROR_ERROR, "Failed to generate MQTT PUBLISH payload for PUBLISH \r\n");
+    return pPayload->payloadLength;
+}
+
+/* Moves full records of samples from RAM to the flash journal while MQTT is
+ * down, and while a backlog is still being replayed */
+static void journalSpill(void)
+{
+    static APP_TELEMETRY_SAMPLE samples[APP_JOURNAL_RECORD_SAMPLES];
+    uint32_t count;
+    
+    if(!appUSBMSDData.fsMounted){
+        APP_JOURNAL_Close();
+        return;
+    }
+    if(!APP_JOURNAL_Open())
+        return;
+    if(MQTT_IS_CONNECTED && APP_JOURNAL_Backlog() == 0)
+        return;
+    if(APP_TELEMETRY_Count() < APP_JOURNAL_RECORD_SAMPLES)
+        return;
+    count = APP_TELEMETRY_Take(samples, APP_JOURNAL_RECORD_SAMPLES);
+    if(!APP_JOURNAL_Append(samples, count))
+        APP_AWS_DBG(SYS_ERROR_ERROR, "Dropped %u samples \r\n", count);
+}
+
 /* Transmit all messages and wait for them to be received on topic filters */
-static int publishMessage()
+static int publishMessage(APP_AWS_PUBLISH_LANE lane)
 {
-    int status = 0;
+    int status = 1;
     IotMqttError_t publishStatus = IOT_MQTT_STATUS_PENDING;
     IotMqttPublishInfo_t publishInfo = IOT_MQTT_PUBLISH_INFO_INITIALIZER;
     IotMqttCallbackInfo_t publishComplete = IOT_MQTT_CALLBACK_INFO_INITIALIZER;
-    char pPublishPayload[ APP_AWS_MAX_MSG_LLENGTH ];   
+    APP_AWS_PAYLOAD_CONTEXT payload = {lane, APP_TELEMETRY_FormatGet(), 0, 0};
     char pubTopic[APP_AWS_TOPIC_NAME_MAX_LEN];
     const char * pPublishTopics[ PUBLISH_TOPIC_COUNT ] =
     {
         pubTopic,
     };
     
-    if(appAwsData.shadowUpdate)
+    if(lane == APP_AWS_LANE_SHADOW)
         snprintf(pPublishTopics[0], APP_AWS_TOPIC_NAME_MAX_LEN, APP_AWS_SHADOW_UPDATE_TOPIC_TEMPLATE, g_Aws_ClientID);
-    else
+    else if((lane == APP_AWS_LANE_TELEMETRY) && (payload.format == APP_TELEMETRY_FORMAT_SINGLE))
         snprintf(pPublishTopics[0], APP_AWS_TOPIC_NAME_MAX_LEN, "%s/sensors", g_Aws_ClientID);
+    else
+        snprintf(pPublishTopics[0], APP_AWS_TOPIC_NAME_MAX_LEN, "%s/sensors%s", g_Aws_ClientID,
+                (payload.format == APP_TELEMETRY_FORMAT_CBOR) ? APP_TELEMETRY_CBOR_TOPIC_SUFFIX : APP_TELEMETRY_BATCH_TOPIC_SUFFIX);
 
     publishComplete.function = operationCompleteCallback;
     publishComplete.pCallbackContext = NULL;
 
-    /* Set the common members of the publish info. */
+    /* Set the common members of the publish info. The payload is written
+     * by writePublishPayload() directly into the MQTT packet. */
     publishInfo.qos = IOT_MQTT_QOS_1;
     publishInfo.topicNameLength = strlen(pPublishTopics[0]);
-    publishInfo.pPayload = pPublishPayload;
     publishInfo.retryMs = PUBLISH_RETRY_MS;
     publishInfo.retryLimit = PUBLISH_RETRY_LIMIT;
     publishInfo.pTopicName = pPublishTopics[0];
     
     APP_AWS_DBG(SYS_ERROR_INFO, "Publishing message\r\n");
 
-    /* Generate the payload for the PUBLISH. */
-    if(appAwsData.shadowUpdate){
-        status = snprintf( pPublishPayload, APP_AWS_MAX_MSG_LLENGTH, APP_AWS_SHADOW_MSG_TEMPLATE, !LED_YELLOW_Get());
+    if(lane == APP_AWS_LANE_SHADOW)
         appAwsData.shadowUpdate = false;
-    }
-    else
-#if 1
-        status = snprintf( pPublishPayload, APP_AWS_MAX_MSG_LLENGTH,
-                APP_AWS_TELEMETRY_MSG_TEMPLATE, 
-                APP_readTemp(),
-                APP_readLight());
-#else
-        /*Graduation step to include an additional sensor data. 
-        Comment out the above code block by changing the '#if 1' to '#if 0'*/
-        status = snprintf( pPublishPayload, APP_AWS_MAX_MSG_LLENGTH,
-                APP_AWS_TELEMETRY_MSG_GRAD_TEMPLATE, 
-                APP_readTemp(),
-                APP_readLight(),
-                !SWITCH1_Get());
-#endif
-    
-
-    /* Check for errors from snprintf. */
-    if( status < 0 ){
-        APP_AWS_DBG(SYS_ERROR_ERROR, "Failed to generate MQTT PUBLISH payload for PUBLISH \r\n");
-        return status;
-    }
-    else{
-        publishInfo.payloadLength = ( size_t ) status;
-        status = 1;
-    }
 
     /* PUBLISH a message. This is an asynchronous function that notifies of
      * completion through a callback. */
-    publishStatus = IotMqtt_PublishAsync( appAwsData.mqttConnection,
-                                          &publishInfo,
-                                          ( 0x80000000 ),
-                                          &publishComplete,
-                                          NULL );
+    publishStatus = IotMqtt_PublishInPlaceAsync( appAwsData.mqttConnection,
+                                                 &publishInfo,
+                                                 writePublishPayload,
+                                                 &payload,
+                                                 ( 0x80000000 ),
+                                                 &publishComplete,
+                                                 NULL );
     if( publishStatus != IOT_MQTT_STATUS_PENDING ){
         APP_AWS_DBG(SYS_ERROR_ERROR, "MQTT PUBLISH returned error %s \r\n", IotMqtt_strerror( publishStatus ) );
         status = 0;
     }
+    else if(lane == APP_AWS_LANE_BACKLOG)
+        APP_JOURNAL_Commit(payload.sampleCount);
+    else if(lane == APP_AWS_LANE_TELEMETRY)
+        APP_TELEMETRY_Commit(payload.sampleCount, payload.payloadLength);
     appAwsData.pendingMessages++;
 
     return status;
@@ -239,6 +287,8 @@ void APP_AWS_Initialize( void )
 
 void APP_AWS_Tasks ( void )
 {
+    journalSpill();
+
     switch ( appAwsData.awsCloudTaskState )
     {
         /* AWS cloud task initial state. */
@@ -281,6 +331,8 @@ void APP_AWS_Tasks ( void )
             if(WIFI_IS_CONNECTED && IP_ADDR_IS_OBTAINED && NTP_IS_DONE){
                 IotMqttError_t connectStatus = IOT_MQTT_STATUS_PENDING;
                 int status = 0;
+                uint32_t connectStart = 0;
+                IotNetworkConnectTimings_t connectTimings;
                 struct IotNetworkServerInfo serverInfo = {0};
                 IotMqttNetworkInfo_t networkInfo = IOT_MQTT_NETWORK_INFO_INITIALIZER;
                 IotMqttConnectInfo_t connectInfo = IOT_MQTT_CONNECT_INFO_INITIALIZER;
@@ -340,6 +392,7 @@ void APP_AWS_Tasks ( void )
                             connectInfo.clientIdentifierLength );
                 
                 APP_manageLed(LED_GREEN, LED_F_BLINK, BLINK_MODE_PERIODIC);
+                connectStart = SYS_TIME_CounterGet();
                 connectStatus = IotMqtt_Connect( &networkInfo,
                                                  &connectInfo,
                                                  MQTT_TIMEOUT_MS,
@@ -353,7 +406,14 @@ void APP_AWS_Tasks ( void )
                     vTaskDelay(1000 / portTICK_PERIOD_MS);
                 }
                 else{
+                    uint32_t connectMs = SYS_TIME_CountToMS(SYS_TIME_CounterGet() - connectStart);
+
+                    /* The MQTT stage is whatever the network stages did not account for. */
+                    IotNetworkWolfSSL_GetConnectTimings(&connectTimings);
                     APP_AWS_PRNT("MQTT connected \r\n");
+                    APP_AWS_PRNT("Connect time %u ms (DNS %u, TCP %u, TLS %u, CONNACK %u) \r\n",
+                                 connectMs, connectTimings.dnsMs, connectTimings.tcpMs, connectTimings.tlsMs,
+                                 connectMs - connectTimings.dnsMs - connectTimings.tcpMs - connectTimings.tlsMs);
                     APP_manageLed(LED_GREEN, LED_ON, BLINK_MODE_INVALID);
                     APP_OLEDNotify(APP_OLED_PARAM_CLOUD, true);
                     appAwsData.awsCloudTaskState = APP_AWS_CLOUD_MQTT_SUBSCRIBE_TO_TOPIC;
@@ -422,10 +482,20 @@ void APP_AWS_Tasks ( void )
             
             if (MQTT_IS_CONNECTED){
                 if(appAwsData.publishToCloud == true){
-                    int status = 0;
-
-                    /* Publish messages. */
-                    status = publishMessage();
+                    int status = 1;
+
+                    /* Publish the shadow update right away; then the journal
+                     * backlog, one PUBLISH per tick; telemetry only once its
+                     * batch is due. A backlog that cannot be read now does
+                     * not hold the telemetry back. */
+                    if(appAwsData.shadowUpdate)
+                        status = publishMessage(APP_AWS_LANE_SHADOW);
+                    else if(APP_JOURNAL_Backlog() > 0 && APP_JOURNAL_Load()){
+                        if(appAwsData.pendingMessages < APP_JOURNAL_DRAIN_MAX_PENDING)
+                            status = publishMessage(APP_AWS_LANE_BACKLOG);
+                    }
+                    else if(APP_TELEMETRY_FlushDue())
+                        status = publishMessage(APP_AWS_LANE_TELEMETRY);
                     if (status == 0){
                         APP_AWS_DBG(SYS_ERROR_ERROR, "Publish message failed \r\n");
                         appAwsData.awsCloudTaskState = APP_AWS_CLOUD_ERROR;
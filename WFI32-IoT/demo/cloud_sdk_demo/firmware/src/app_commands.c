@@ -45,6 +45,8 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 #include "app_usb_msd.h"
 #include "app_oled.h"
 #include "app_ps.h"
+#include "app_telemetry.h"
+#include "app_journal.h"
 #include "config.h"
 #include <wolfssl/ssl.h>
 #include "task.h"
@@ -53,6 +55,8 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 #include "wdrv_pic32mzw_common.h"
 #include "wdrv_pic32mzw_assoc.h"
 #include "system/debug/sys_debug.h"
+#include "iot_network_wolfssl.h"
+#include "net_pres/pres/net_pres_enc_glue.h"
 
 //******************************************************************************
 
@@ -66,6 +70,9 @@ static void _APP_Commands_SelfTester(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char
 static void _APP_Commands_SetDebugLevel(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv);
 static void _APP_Commands_SetPowerMode(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv);
 static void _APP_Commands_Reboot(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv);
+static void _APP_Commands_NetLatency(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv);
+static void _APP_Commands_TlsStats(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv);
+static void _APP_Commands_Telemetry(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv);
 void _APP_Commands_Start(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv);
 
 //******************************************************************************
@@ -79,6 +86,9 @@ static const SYS_CMD_DESCRIPTOR appCmdTbl[] = {
     {"self_tester", _APP_Commands_SelfTester, ": Show board self tester status"},
     {"debug", _APP_Commands_SetDebugLevel, ": Set debug level"},
     {"reboot", _APP_Commands_Reboot, ": System reboot"},
+    {"net_latency", _APP_Commands_NetLatency, ": Network receive latency histogram"},
+    {"tls_stats", _APP_Commands_TlsStats, ": TLS full/resumed handshake statistics"},
+    {"telemetry", _APP_Commands_Telemetry, ": Telemetry batching and journal stats [count age_ms bytes | single | json | cbor]"},
 	{"start", _APP_Commands_Start, ": Start Cloud or OTA"},
 };
 
@@ -135,6 +145,87 @@ void _APP_Commands_Reboot(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv) {
     APP_SoftResetDevice();
 }
 
+void _APP_Commands_NetLatency(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv) {
+    const void* cmdIoParam = pCmdIO->cmdIoParam;
+    const uint32_t limits[IOT_NETWORK_LATENCY_BUCKET_COUNT - 1] = IOT_NETWORK_LATENCY_BUCKET_LIMITS_US;
+    IotNetworkLatencyHistogram_t histogram;
+    uint8_t i;
+
+    if ((argc == 2) && (!strcmp((const char*)argv[1], "reset"))) {
+        IotNetworkWolfSSL_ResetReceiveLatency();
+        APP_CMD_PRNT("Network latency histogram cleared\r\n");
+        return;
+    }
+
+    IotNetworkWolfSSL_GetReceiveLatency(&histogram);
+    APP_CMD_PRNT("Signal to callback latency (%u samples, max %u us)\r\n", histogram.samples, histogram.maxUs);
+    for (i = 0; i < IOT_NETWORK_LATENCY_BUCKET_COUNT - 1; i++)
+        APP_CMD_PRNT("  <= %6u us: %u\r\n", limits[i], histogram.count[i]);
+    APP_CMD_PRNT("  >  %6u us: %u\r\n", limits[i - 1], histogram.count[i]);
+}
+
+void _APP_Commands_TlsStats(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv) {
+    const void* cmdIoParam = pCmdIO->cmdIoParam;
+    NET_PRES_TLS_SESSION_STATS stats;
+
+    if ((argc == 2) && (!strcmp((const char*)argv[1], "flush"))) {
+        NET_PRES_EncGlue_SessionCacheFlush();
+        APP_CMD_PRNT("TLS session cache flushed\r\n");
+        return;
+    }
+
+    NET_PRES_EncGlue_SessionStatsGet(&stats);
+    APP_CMD_PRNT("Full handshakes: %u, avg %u ms\r\n", stats.fullHandshakes,
+            stats.fullHandshakes ? stats.fullTotalMs / stats.fullHandshakes : 0);
+    APP_CMD_PRNT("Resumed handshakes: %u, avg %u ms\r\n", stats.resumedHandshakes,
+            stats.resumedHandshakes ? stats.resumedTotalMs / stats.resumedHandshakes : 0);
+    if (stats.keyPrefetches) {
+        // each hit takes a key generation out of the handshake
+        uint32_t keyMs = stats.keyPrefetchTotalMs / stats.keyPrefetches;
+        APP_CMD_PRNT("Key prefetches: %u, avg %u ms, hits %u, misses %u\r\n", stats.keyPrefetches,
+                keyMs, stats.keyPrefetchHits, stats.keyPrefetchMisses);
+        APP_CMD_PRNT("Saved per full handshake: avg %u ms\r\n",
+                stats.fullHandshakes ? stats.keyPrefetchHits * keyMs / stats.fullHandshakes : 0);
+    }
+}
+
+void _APP_Commands_Telemetry(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv) {
+    const void* cmdIoParam = pCmdIO->cmdIoParam;
+    APP_TELEMETRY_POLICY policy;
+    APP_TELEMETRY_STATS stats;
+    APP_JOURNAL_STATS journalStats;
+
+    if (argc == 4) {
+        policy.count = atoi(argv[1]);
+        policy.ageMs = atoi(argv[2]);
+        policy.bytes = atoi(argv[3]);
+        APP_TELEMETRY_PolicySet(&policy);
+    }
+    else if ((argc == 2) && (!strcmp((const char*)argv[1], "single")))
+        APP_TELEMETRY_FormatSet(APP_TELEMETRY_FORMAT_SINGLE);
+    else if ((argc == 2) && (!strcmp((const char*)argv[1], "json")))
+        APP_TELEMETRY_FormatSet(APP_TELEMETRY_FORMAT_JSON);
+    else if ((argc == 2) && (!strcmp((const char*)argv[1], "cbor")))
+        APP_TELEMETRY_FormatSet(APP_TELEMETRY_FORMAT_CBOR);
+
+    APP_TELEMETRY_PolicyGet(&policy);
+    APP_TELEMETRY_StatsGet(&stats);
+    APP_CMD_PRNT("Flush policy: %u samples, %u ms, %u bytes (0 = off)\r\n", policy.count, policy.ageMs, policy.bytes);
+    APP_CMD_PRNT("Payload format: %s\r\n", (APP_TELEMETRY_FormatGet() == APP_TELEMETRY_FORMAT_SINGLE) ? "single sample" :
+            (APP_TELEMETRY_FormatGet() == APP_TELEMETRY_FORMAT_CBOR) ? "CBOR batch" : "JSON batch");
+    APP_CMD_PRNT("Samples: %u queued, %u dropped\r\n", stats.samples, stats.dropped);
+    APP_CMD_PRNT("Batches: %u, %u samples, %u payload bytes\r\n", stats.batches, stats.batchedSamples, stats.payloadBytes);
+    if (stats.batchedSamples) {
+        /* Each batch also pays the MQTT header, the TLS record of the PUBLISH and the PUBACK */
+        APP_CMD_PRNT("Bytes on air per sample: ~%u\r\n",
+                (stats.payloadBytes + stats.batches * APP_TELEMETRY_BATCH_OVERHEAD_BYTES) / stats.batchedSamples);
+    }
+    APP_JOURNAL_StatsGet(&journalStats);
+    APP_CMD_PRNT("Journal: %u records backlog, %u appended, %u replayed, %u overwritten, %u corrupted\r\n",
+            APP_JOURNAL_Backlog(), journalStats.appended, journalStats.replayed,
+            journalStats.overwritten, journalStats.corrupted);
+}
+
 void _APP_Commands_GetRSSI(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv) {
     const void* cmdIoParam = pCmdIO->cmdIoParam;
     if (WIFI_IS_CONNECTED) {
@@ -23,6 +23,7 @@
 
 #include "app_common.h"
 #include "app_ctrl.h"
+#include "app_telemetry.h"
 #include <math.h>
 
 // *****************************************************************************
@@ -461,6 +462,7 @@ void APP_CTRL_Initialize ( void )
     memset((void*)&appCtrlData.rtccData, 0 , sizeof(appCtrlData.rtccData));
     ledInit();
     sensorsInit();
+    APP_TELEMETRY_Initialize();
     
     /* Start a periodic timer to handle periodic events*/
     appCtrlData.timeHandle = SYS_TIME_CallbackRegisterMS(timeCallback, 
@@ -686,6 +688,8 @@ void APP_CTRL_Tasks ( void )
             /* OPT3001 Light reading operation done */
             if(appCtrlData.i2c.transferStatus == I2C_TRANSFER_STATUS_SUCCESS){
                 i2cReadRegComp(OPT3001_I2C_ADDRESS, OPT3001_REG_RESULT);
+                /* Queue the sample for the next telemetry batch */
+                APP_TELEMETRY_Push(appCtrlData.mcp9808.temperature, appCtrlData.opt3001.light);
                 appCtrlData.ctrlTaskState = APP_CTRL_CHECK;
             }
             else if(appCtrlData.i2c.transferStatus == I2C_TRANSFER_STATUS_ERROR){
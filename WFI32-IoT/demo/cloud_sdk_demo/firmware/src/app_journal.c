@@ -0,0 +1,321 @@
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_journal.c
+
+  Summary:
+    Store-and-forward telemetry journal on the SPI flash volume.
+
+  Description:
+    The journal file is preallocated once and then kept open, so appends only
+    rewrite whole sectors in place. The file never changes size and is not
+    synced, and only closed when the volume goes away, so neither the FAT nor
+    the directory entry is rewritten; those share erase blocks with the config
+    and certificate files. The
+    replay cursor lives in the last sector of the same file and is saved once
+    every few replayed records; if it is lost or torn, every valid record
+    still in the journal is replayed again (at-least-once delivery).
+ *******************************************************************************/
+
+#include <string.h>
+#include "app_journal.h"
+#include "system/fs/sys_fs.h"
+
+// *****************************************************************************
+
+typedef struct
+{
+    uint32_t seq;
+    uint32_t seqInverted;
+    uint8_t reserved[APP_JOURNAL_RECORD_SIZE - 8];
+} APP_JOURNAL_CURSOR;
+
+/* Records, then the cursor sector */
+#define APP_JOURNAL_CURSOR_SLOT     APP_JOURNAL_RECORDS
+#define APP_JOURNAL_FILE_SIZE       ((APP_JOURNAL_RECORDS + 1) * APP_JOURNAL_RECORD_SIZE)
+
+typedef enum
+{
+    APP_JOURNAL_READ_OK,
+    APP_JOURNAL_READ_INVALID,   /* CRC or sequence mismatch */
+    APP_JOURNAL_READ_IO_ERROR   /* volume busy or unavailable; retry later */
+} APP_JOURNAL_READ_RESULT;
+
+static bool opened;
+static SYS_FS_HANDLE journalFd = SYS_FS_HANDLE_INVALID;
+static uint32_t headSeq;        /* sequence number of the next record */
+static uint32_t tailSeq;        /* sequence number of the oldest unsent record */
+static uint32_t cursorSeq;      /* tailSeq as last saved */
+
+static APP_JOURNAL_RECORD appendRecord;
+static APP_JOURNAL_RECORD replayRecord;
+static APP_JOURNAL_CURSOR cursorSector;
+static bool replayLoaded;
+static uint32_t replayPos;      /* samples of replayRecord already published */
+
+static APP_JOURNAL_STATS stats;
+
+// *****************************************************************************
+
+static uint32_t crc32(const uint8_t * pData, size_t len)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    uint8_t bit;
+
+    while(len--){
+        crc ^= *pData++;
+        for(bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+    return ~crc;
+}
+
+static bool recordValid(const APP_JOURNAL_RECORD * pRecord)
+{
+    return pRecord->magic == APP_JOURNAL_MAGIC
+            && pRecord->count > 0
+            && pRecord->count <= APP_JOURNAL_RECORD_SAMPLES
+            && pRecord->crc == crc32((const uint8_t *) pRecord, offsetof(APP_JOURNAL_RECORD, crc));
+}
+
+static bool slotSeek(uint32_t slot)
+{
+    return SYS_FS_FileSeek(journalFd, slot * APP_JOURNAL_RECORD_SIZE, SYS_FS_SEEK_SET) >= 0;
+}
+
+static APP_JOURNAL_READ_RESULT recordRead(uint32_t seq, APP_JOURNAL_RECORD * pRecord)
+{
+    if(!slotSeek(seq % APP_JOURNAL_RECORDS)
+            || SYS_FS_FileRead(journalFd, pRecord, APP_JOURNAL_RECORD_SIZE) != APP_JOURNAL_RECORD_SIZE)
+        return APP_JOURNAL_READ_IO_ERROR;
+    return (recordValid(pRecord) && pRecord->seq == seq) ? APP_JOURNAL_READ_OK : APP_JOURNAL_READ_INVALID;
+}
+
+/* Whole, aligned sectors bypass the file buffer and go straight to the media,
+ * so no sync is needed (a sync would also rewrite the directory entry) */
+static bool recordWrite(const APP_JOURNAL_RECORD * pRecord)
+{
+    return slotSeek(pRecord->seq % APP_JOURNAL_RECORDS)
+            && SYS_FS_FileWrite(journalFd, pRecord, APP_JOURNAL_RECORD_SIZE) == APP_JOURNAL_RECORD_SIZE;
+}
+
+/* Creates the journal at its full size, with all records and the cursor
+ * invalid, and returns it opened for update */
+static SYS_FS_HANDLE journalCreate(void)
+{
+    SYS_FS_HANDLE fd;
+    uint32_t i;
+    bool ret = true;
+
+    fd = SYS_FS_FileOpen(APP_JOURNAL_FILE_NAME, SYS_FS_FILE_OPEN_WRITE);
+    if(fd == SYS_FS_HANDLE_INVALID)
+        return SYS_FS_HANDLE_INVALID;
+    memset(&appendRecord, 0, sizeof(appendRecord));
+    for(i = 0; i <= APP_JOURNAL_RECORDS && ret; i++)
+        ret = (SYS_FS_FileWrite(fd, &appendRecord, APP_JOURNAL_RECORD_SIZE) == APP_JOURNAL_RECORD_SIZE);
+    SYS_FS_FileClose(fd);
+    return ret ? SYS_FS_FileOpen(APP_JOURNAL_FILE_NAME, SYS_FS_FILE_OPEN_READ_PLUS) : SYS_FS_HANDLE_INVALID;
+}
+
+static uint32_t cursorRead(void)
+{
+    if(!slotSeek(APP_JOURNAL_CURSOR_SLOT)
+            || SYS_FS_FileRead(journalFd, &cursorSector, APP_JOURNAL_RECORD_SIZE) != APP_JOURNAL_RECORD_SIZE
+            || cursorSector.seq != ~cursorSector.seqInverted)
+        return 0;
+    return cursorSector.seq;
+}
+
+static void cursorWrite(uint32_t seq)
+{
+    memset(&cursorSector, 0, sizeof(cursorSector));
+    cursorSector.seq = seq;
+    cursorSector.seqInverted = ~seq;
+    if(!slotSeek(APP_JOURNAL_CURSOR_SLOT)
+            || SYS_FS_FileWrite(journalFd, &cursorSector, APP_JOURNAL_RECORD_SIZE) != APP_JOURNAL_RECORD_SIZE){
+        APP_JOURNAL_DBG(SYS_ERROR_ERROR, "Failed to save replay cursor\r\n");
+        return;
+    }
+    cursorSeq = seq;
+}
+
+/* Saves the cursor once every APP_JOURNAL_CURSOR_INTERVAL records, and when
+ * the backlog is empty so that nothing is replayed after a restart */
+static void cursorAdvance(void)
+{
+    if(tailSeq - cursorSeq >= APP_JOURNAL_CURSOR_INTERVAL || tailSeq == headSeq)
+        cursorWrite(tailSeq);
+}
+
+// *****************************************************************************
+
+/* Opens the journal, creating it if it does not exist, and recovers head and
+ * tail from the newest valid record and the replay cursor. The file stays
+ * open until APP_JOURNAL_Close(). Needs a mounted volume. */
+bool APP_JOURNAL_Open(void)
+{
+    SYS_FS_HANDLE fd;
+    uint32_t slot, maxSeq = 0, cursor;
+
+    if(opened)
+        return true;
+
+    /* Any error other than a missing file (volume busy, no free handle) must
+     * not recreate the journal, which would truncate the backlog */
+    fd = SYS_FS_FileOpen(APP_JOURNAL_FILE_NAME, SYS_FS_FILE_OPEN_READ_PLUS);
+    if(fd == SYS_FS_HANDLE_INVALID){
+        if(SYS_FS_Error() == SYS_FS_ERROR_NO_FILE)
+            fd = journalCreate();
+    }
+    else if(SYS_FS_FileSize(fd) != APP_JOURNAL_FILE_SIZE){
+        /* Left by a build with another journal layout */
+        SYS_FS_FileClose(fd);
+        fd = journalCreate();
+    }
+    if(fd == SYS_FS_HANDLE_INVALID){
+        APP_JOURNAL_DBG(SYS_ERROR_ERROR, "Failed to open %s\r\n", APP_JOURNAL_FILE_NAME);
+        return false;
+    }
+    journalFd = fd;
+
+    for(slot = 0; slot < APP_JOURNAL_RECORDS; slot++){
+        if(SYS_FS_FileRead(journalFd, &appendRecord, APP_JOURNAL_RECORD_SIZE) != APP_JOURNAL_RECORD_SIZE){
+            APP_JOURNAL_DBG(SYS_ERROR_ERROR, "Failed to read %s\r\n", APP_JOURNAL_FILE_NAME);
+            SYS_FS_FileClose(journalFd);
+            journalFd = SYS_FS_HANDLE_INVALID;
+            return false;
+        }
+        if(recordValid(&appendRecord) && appendRecord.seq > maxSeq)
+            maxSeq = appendRecord.seq;
+    }
+
+    /* Sequence numbers start at 1 so that zeroed records never match */
+    cursor = cursorRead();
+    headSeq = maxSeq + 1;
+    tailSeq = (headSeq > APP_JOURNAL_RECORDS) ? headSeq - APP_JOURNAL_RECORDS : 1;
+    if(cursor > tailSeq)
+        tailSeq = (cursor < headSeq) ? cursor : headSeq;
+    cursorSeq = tailSeq;
+    replayLoaded = false;
+    opened = true;
+
+    APP_JOURNAL_DBG(SYS_ERROR_INFO, "Journal opened, %u records to replay\r\n", headSeq - tailSeq);
+    return true;
+}
+
+/* Saves the cursor and releases the journal file, e.g. when the volume goes
+ * away. The next APP_JOURNAL_Open() recovers the state again. */
+void APP_JOURNAL_Close(void)
+{
+    if(!opened)
+        return;
+    if(cursorSeq != tailSeq)
+        cursorWrite(tailSeq);
+    SYS_FS_FileClose(journalFd);
+    journalFd = SYS_FS_HANDLE_INVALID;
+    replayLoaded = false;
+    opened = false;
+}
+
+/* Appends one record; when the journal is full the oldest record is lost */
+bool APP_JOURNAL_Append(const APP_TELEMETRY_SAMPLE * pSamples, uint32_t count)
+{
+    if(count == 0 || count > APP_JOURNAL_RECORD_SAMPLES)
+        return false;
+    if(!APP_JOURNAL_Open())
+        return false;
+
+    memset(&appendRecord, 0, sizeof(appendRecord));
+    appendRecord.magic = APP_JOURNAL_MAGIC;
+    appendRecord.count = count;
+    appendRecord.seq = headSeq;
+    memcpy(appendRecord.samples, pSamples, count * sizeof(APP_TELEMETRY_SAMPLE));
+    appendRecord.crc = crc32((const uint8_t *) &appendRecord, offsetof(APP_JOURNAL_RECORD, crc));
+
+    if(!recordWrite(&appendRecord)){
+        APP_JOURNAL_DBG(SYS_ERROR_ERROR, "Failed to write record %u\r\n", headSeq);
+        return false;
+    }
+    if(headSeq - tailSeq >= APP_JOURNAL_RECORDS){
+        tailSeq++;
+        stats.overwritten++;
+    }
+    headSeq++;
+    stats.appended++;
+    return true;
+}
+
+/* Records not yet fully published */
+uint32_t APP_JOURNAL_Backlog(void)
+{
+    return opened ? headSeq - tailSeq : 0;
+}
+
+/* Loads the oldest valid backlog record for replay, skipping corrupted ones.
+ * Returns false when there is nothing to send now: no valid record is left,
+ * or the volume could not be read and the record is retried on a later call. */
+bool APP_JOURNAL_Load(void)
+{
+    uint32_t skipped = 0;
+    APP_JOURNAL_READ_RESULT res;
+
+    while(!replayLoaded && tailSeq < headSeq){
+        res = recordRead(tailSeq, &replayRecord);
+        if(res == APP_JOURNAL_READ_OK){
+            replayLoaded = true;
+            replayPos = 0;
+        }
+        else if(res == APP_JOURNAL_READ_IO_ERROR)
+            break;
+        else{
+            APP_JOURNAL_DBG(SYS_ERROR_WARNING, "Skipping corrupted record %u\r\n", tailSeq);
+            stats.corrupted++;
+            tailSeq++;
+            skipped++;
+        }
+    }
+    if(skipped)
+        cursorAdvance();
+    return replayLoaded;
+}
+
+/* PUBLISH payload writer for the backlog; formats the next samples of the
+ * record loaded by APP_JOURNAL_Load(). They stay in the journal until
+ * APP_JOURNAL_Commit(). */
+size_t APP_JOURNAL_Write(char * pBuffer, size_t bufferSize, uint32_t * pCount)
+{
+    *pCount = 0;
+    if(!replayLoaded)
+        return bufferSize + 1;
+
+    return APP_TELEMETRY_Encode(pBuffer, bufferSize, &replayRecord.samples[replayPos],
+            replayRecord.count - replayPos, pCount);
+}
+
+/* Called once the PUBLISH carrying 'count' backlog samples is queued */
+void APP_JOURNAL_Commit(uint32_t count)
+{
+    if(!replayLoaded)
+        return;
+    replayPos += count;
+    if(replayPos >= replayRecord.count){
+        replayLoaded = false;
+        stats.replayed++;
+        if(replayRecord.seq + 1 > tailSeq)
+            tailSeq = replayRecord.seq + 1;
+        cursorAdvance();
+    }
+}
+
+void APP_JOURNAL_StatsGet(APP_JOURNAL_STATS * pStats)
+{
+    *pStats = stats;
+}
+
+/*******************************************************************************
+ End of File
+ */
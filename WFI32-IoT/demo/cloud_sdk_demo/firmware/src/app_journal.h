@@ -0,0 +1,103 @@
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_journal.h
+
+  Summary:
+    Store-and-forward telemetry journal on the SPI flash volume.
+
+  Description:
+    While MQTT is down, telemetry samples are parked in a fixed-size journal
+    file on the SST26 FAT volume instead of RAM. Records are one FAT sector
+    each and protected by a CRC-32. Record n always lives in slot
+    n % APP_JOURNAL_RECORDS, so writes rotate evenly over the whole file. The
+    flash is erased in 4 KB blocks, so a power cut costs at most the records
+    sharing the erase block being written. Once connected, the backlog is
+    replayed oldest first at a limited rate.
+*******************************************************************************/
+
+#ifndef _APP_JOURNAL_H
+#define _APP_JOURNAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "configuration.h"
+#include "app_telemetry.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+/* Debug wrappers */
+#define APP_JOURNAL_DBG(level,fmt,...) SYS_DEBUG_PRINT(level,"[APP_JOURNAL] "fmt,##__VA_ARGS__)
+#define APP_JOURNAL_PRNT(fmt,...) SYS_CONSOLE_PRINT("[APP_JOURNAL] "fmt, ##__VA_ARGS__)
+
+// *****************************************************************************
+
+#define APP_JOURNAL_FILE_NAME           "/mnt/myDrive1/telemetry.jnl"
+
+/* One record per FAT sector; 64 records keep ~43 minutes of 2 s samples */
+#define APP_JOURNAL_RECORD_SIZE         512
+#define APP_JOURNAL_RECORDS             64
+#define APP_JOURNAL_RECORD_SAMPLES      ((APP_JOURNAL_RECORD_SIZE - 12) / sizeof(APP_TELEMETRY_SAMPLE))
+#define APP_JOURNAL_MAGIC               0x4A54
+
+/* Backlog replay: at most one PUBLISH per publish tick, and only while few
+ * PUBACKs are pending */
+#define APP_JOURNAL_DRAIN_MAX_PENDING   2
+
+/* Replayed records between two cursor saves; at most this many are sent
+ * again after a power cut */
+#define APP_JOURNAL_CURSOR_INTERVAL     8
+
+// *****************************************************************************
+
+typedef struct
+{
+    uint16_t magic;
+    uint16_t count;
+    uint32_t seq;
+    APP_TELEMETRY_SAMPLE samples[APP_JOURNAL_RECORD_SAMPLES];
+    uint8_t reserved[APP_JOURNAL_RECORD_SIZE - 12 - APP_JOURNAL_RECORD_SAMPLES * sizeof(APP_TELEMETRY_SAMPLE)];
+    uint32_t crc;   /* CRC-32 of all preceding bytes */
+} APP_JOURNAL_RECORD;
+
+typedef struct
+{
+    uint32_t appended;      /* records written */
+    uint32_t replayed;      /* records fully published */
+    uint32_t overwritten;   /* records lost to a full journal */
+    uint32_t corrupted;     /* records skipped on a CRC or sequence mismatch */
+} APP_JOURNAL_STATS;
+
+// *****************************************************************************
+
+bool APP_JOURNAL_Open(void);
+void APP_JOURNAL_Close(void);
+bool APP_JOURNAL_Append(const APP_TELEMETRY_SAMPLE * pSamples, uint32_t count);
+uint32_t APP_JOURNAL_Backlog(void);
+bool APP_JOURNAL_Load(void);
+size_t APP_JOURNAL_Write(char * pBuffer, size_t bufferSize, uint32_t * pCount);
+void APP_JOURNAL_Commit(uint32_t count);
+void APP_JOURNAL_StatsGet(APP_JOURNAL_STATS * pStats);
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif /* _APP_JOURNAL_H */
+
+/*******************************************************************************
+ End of File
+ */
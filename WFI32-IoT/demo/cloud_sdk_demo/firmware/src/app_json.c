@@ -0,0 +1,390 @@
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_json.c
+
+  Summary:
+    Allocation-free JSON path queries.
+
+  Description:
+    Strings, numbers and literals are checked strictly. Containers that are
+    skipped are only checked for balanced brackets and well-formed strings,
+    which is all that is needed to step over them.
+ *******************************************************************************/
+
+#include <string.h>
+#include "app_json.h"
+
+// *****************************************************************************
+
+static const char * skipSpace(const char * p, const char * end)
+{
+    while(p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+        p++;
+    return p;
+}
+
+static bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static int hexValue(char c)
+{
+    if(isDigit(c))
+        return c - '0';
+    if(c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if(c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+/* p is on the opening quote; returns the end of the string */
+static const char * scanString(const char * p, const char * end)
+{
+    int i;
+
+    for(p++; p < end; p++){
+        if(*p == '"')
+            return p + 1;
+        if((unsigned char) *p < 0x20)
+            return NULL;
+        if(*p != '\\')
+            continue;
+        if(++p == end)
+            return NULL;
+        if(*p == 'u'){
+            for(i = 0; i < 4; i++)
+                if(++p == end || hexValue(*p) < 0)
+                    return NULL;
+        }
+        else if(strchr("\"\\/bfnrt", *p) == NULL || *p == '\0')
+            return NULL;
+    }
+    return NULL;
+}
+
+static const char * scanNumber(const char * p, const char * end)
+{
+    if(p < end && *p == '-')
+        p++;
+    if(p == end || !isDigit(*p))
+        return NULL;
+    if(*p == '0')
+        p++;
+    else
+        while(p < end && isDigit(*p))
+            p++;
+    if(p < end && *p == '.'){
+        if(++p == end || !isDigit(*p))
+            return NULL;
+        while(p < end && isDigit(*p))
+            p++;
+    }
+    if(p < end && (*p == 'e' || *p == 'E')){
+        p++;
+        if(p < end && (*p == '+' || *p == '-'))
+            p++;
+        if(p == end || !isDigit(*p))
+            return NULL;
+        while(p < end && isDigit(*p))
+            p++;
+    }
+    return p;
+}
+
+static const char * scanLiteral(const char * p, const char * end, const char * pLiteral)
+{
+    size_t len = strlen(pLiteral);
+
+    if((size_t)(end - p) < len || memcmp(p, pLiteral, len) != 0)
+        return NULL;
+    return p + len;
+}
+
+/* p is on the opening bracket; returns the end of the matching bracket */
+static const char * scanContainer(const char * p, const char * end)
+{
+    uint32_t objects = 0;   /* one bit per level, set for objects */
+    uint32_t depth = 0;
+
+    do{
+        if(*p == '"'){
+            p = scanString(p, end);
+            if(p == NULL)
+                return NULL;
+            continue;
+        }
+        if(*p == '{' || *p == '['){
+            if(depth == APP_JSON_MAX_DEPTH)
+                return NULL;
+            objects = (objects << 1) | (*p == '{');
+            depth++;
+        }
+        else if(*p == '}' || *p == ']'){
+            if((objects & 1) != (*p == '}'))
+                return NULL;
+            objects >>= 1;
+            depth--;
+        }
+        p++;
+    } while(depth > 0 && p < end);
+
+    return depth ? NULL : p;
+}
+
+/* Returns the end of the value at p, and optionally describes it */
+static const char * scanValue(const char * p, const char * end, APP_JSON_VALUE * pValue)
+{
+    const char * pStart = p;
+    APP_JSON_TYPE type;
+
+    if(p >= end)
+        return NULL;
+    switch(*p){
+        case '{':
+            type = APP_JSON_TYPE_OBJECT;
+            p = scanContainer(p, end);
+            break;
+        case '[':
+            type = APP_JSON_TYPE_ARRAY;
+            p = scanContainer(p, end);
+            break;
+        case '"':
+            type = APP_JSON_TYPE_STRING;
+            p = scanString(p, end);
+            break;
+        case 't':
+            type = APP_JSON_TYPE_TRUE;
+            p = scanLiteral(p, end, "true");
+            break;
+        case 'f':
+            type = APP_JSON_TYPE_FALSE;
+            p = scanLiteral(p, end, "false");
+            break;
+        case 'n':
+            type = APP_JSON_TYPE_NULL;
+            p = scanLiteral(p, end, "null");
+            break;
+        default:
+            type = APP_JSON_TYPE_NUMBER;
+            p = scanNumber(p, end);
+            break;
+    }
+    if(p != NULL && pValue != NULL){
+        pValue->type = type;
+        if(type == APP_JSON_TYPE_STRING){
+            pValue->pValue = pStart + 1;
+            pValue->length = p - pStart - 2;
+        }
+        else{
+            pValue->pValue = pStart;
+            pValue->length = p - pStart;
+        }
+    }
+    return p;
+}
+
+/* p is on an object; returns the value of its first member named pKey */
+static const char * findMember(const char * p, const char * end, const char * pKey, size_t keyLength)
+{
+    const char * pName;
+    size_t nameLength;
+
+    if(p >= end || *p != '{')
+        return NULL;
+    p = skipSpace(p + 1, end);
+    if(p < end && *p == '}')
+        return NULL;
+
+    while(p < end && *p == '"'){
+        pName = p + 1;
+        p = scanString(p, end);
+        if(p == NULL)
+            return NULL;
+        nameLength = p - pName - 1;
+        p = skipSpace(p, end);
+        if(p == end || *p != ':')
+            return NULL;
+        p = skipSpace(p + 1, end);
+        if(nameLength == keyLength && memcmp(pName, pKey, keyLength) == 0)
+            return p;
+        p = scanValue(p, end, NULL);
+        if(p == NULL)
+            return NULL;
+        p = skipSpace(p, end);
+        if(p == end || *p != ',')
+            return NULL;
+        p = skipSpace(p + 1, end);
+    }
+    return NULL;
+}
+
+/* p is on an array; returns its element at index */
+static const char * findElement(const char * p, const char * end, uint32_t index)
+{
+    if(p >= end || *p != '[')
+        return NULL;
+    p = skipSpace(p + 1, end);
+    if(p < end && *p == ']')
+        return NULL;
+
+    while(index--){
+        p = scanValue(p, end, NULL);
+        if(p == NULL)
+            return NULL;
+        p = skipSpace(p, end);
+        if(p == end || *p != ',')
+            return NULL;
+        p = skipSpace(p + 1, end);
+    }
+    return p;
+}
+
+// *****************************************************************************
+
+/* Paths are member names separated by '.', with "[n]" for array elements,
+ * e.g. "state.toggle" or "ota[0].files[1].URL". Member names in the document
+ * are compared without unescaping. */
+bool APP_JSON_Find(const char * pDoc, size_t docLength, const char * pPath, APP_JSON_VALUE * pValue)
+{
+    const char * end = pDoc + docLength;
+    const char * p = skipSpace(pDoc, end);
+    size_t keyLength;
+    uint32_t index;
+
+    while(p != NULL && *pPath != '\0'){
+        if(*pPath == '['){
+            if(!isDigit(*++pPath))
+                return false;
+            for(index = 0; isDigit(*pPath); pPath++)
+                index = index * 10 + (*pPath - '0');
+            if(*pPath++ != ']')
+                return false;
+            p = findElement(p, end, index);
+        }
+        else{
+            keyLength = strcspn(pPath, ".[");
+            p = findMember(p, end, pPath, keyLength);
+            pPath += keyLength;
+        }
+        if(*pPath == '.')
+            pPath++;
+    }
+    return p != NULL && scanValue(p, end, pValue) != NULL;
+}
+
+/* Accepts true/false and numbers, as cJSON's valueint did */
+bool APP_JSON_GetBool(const char * pDoc, size_t docLength, const char * pPath, bool * pResult)
+{
+    APP_JSON_VALUE value;
+    int32_t number;
+
+    if(!APP_JSON_Find(pDoc, docLength, pPath, &value))
+        return false;
+    if(value.type == APP_JSON_TYPE_TRUE || value.type == APP_JSON_TYPE_FALSE){
+        *pResult = (value.type == APP_JSON_TYPE_TRUE);
+        return true;
+    }
+    if(!APP_JSON_GetInt(pDoc, docLength, pPath, &number))
+        return false;
+    *pResult = (number != 0);
+    return true;
+}
+
+/* Fractions are truncated; exponents and out of range values fail */
+bool APP_JSON_GetInt(const char * pDoc, size_t docLength, const char * pPath, int32_t * pResult)
+{
+    APP_JSON_VALUE value;
+    const char * p;
+    const char * end;
+    bool negative;
+    int64_t number = 0;
+
+    if(!APP_JSON_Find(pDoc, docLength, pPath, &value) || value.type != APP_JSON_TYPE_NUMBER)
+        return false;
+    p = value.pValue;
+    end = p + value.length;
+    negative = (*p == '-');
+    if(negative)
+        p++;
+    for(; p < end && isDigit(*p); p++){
+        number = number * 10 + (*p - '0');
+        if(number > (int64_t) INT32_MAX + 1)
+            return false;
+    }
+    if(memchr(p, 'e', end - p) != NULL || memchr(p, 'E', end - p) != NULL)
+        return false;
+    if(negative)
+        number = -number;
+    if(number > INT32_MAX)
+        return false;
+    *pResult = (int32_t) number;
+    return true;
+}
+
+/* Unescapes the string into pBuffer; fails if it does not fit with its NUL */
+bool APP_JSON_GetString(const char * pDoc, size_t docLength, const char * pPath, char * pBuffer, size_t bufferSize)
+{
+    APP_JSON_VALUE value;
+    const char * p;
+    const char * end;
+    size_t len = 0;
+    uint32_t code;
+    int i;
+
+    if(bufferSize == 0 || !APP_JSON_Find(pDoc, docLength, pPath, &value) || value.type != APP_JSON_TYPE_STRING)
+        return false;
+
+    for(p = value.pValue, end = p + value.length; p < end; p++){
+        if(len + 1 >= bufferSize)
+            return false;
+        if(*p != '\\'){
+            pBuffer[len++] = *p;
+            continue;
+        }
+        switch(*++p){
+            case 'b': pBuffer[len++] = '\b'; break;
+            case 'f': pBuffer[len++] = '\f'; break;
+            case 'n': pBuffer[len++] = '\n'; break;
+            case 'r': pBuffer[len++] = '\r'; break;
+            case 't': pBuffer[len++] = '\t'; break;
+            case 'u':
+                for(code = 0, i = 0; i < 4; i++)
+                    code = (code << 4) | hexValue(*++p);
+                /* UTF-8 without surrogate pairs, which are not expected here */
+                if(code >= 0xD800 && code <= 0xDFFF)
+                    return false;
+                if(code >= 0x800){
+                    if(len + 3 >= bufferSize)
+                        return false;
+                    pBuffer[len++] = 0xE0 | (code >> 12);
+                    pBuffer[len++] = 0x80 | ((code >> 6) & 0x3F);
+                    pBuffer[len++] = 0x80 | (code & 0x3F);
+                }
+                else if(code >= 0x80){
+                    if(len + 2 >= bufferSize)
+                        return false;
+                    pBuffer[len++] = 0xC0 | (code >> 6);
+                    pBuffer[len++] = 0x80 | (code & 0x3F);
+                }
+                else
+                    pBuffer[len++] = code;
+                break;
+            default:
+                pBuffer[len++] = *p;
+                break;
+        }
+    }
+    pBuffer[len] = '\0';
+    return true;
+}
+
+/*******************************************************************************
+ End of File
+ */
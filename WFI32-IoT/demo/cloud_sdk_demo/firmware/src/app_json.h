@@ -0,0 +1,81 @@
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_json.h
+
+  Summary:
+    Allocation-free JSON path queries.
+
+  Description:
+    Looks up one value of a JSON document by path, e.g. "state.toggle" or
+    "ota[0].URL", in a single pass over the document and without copying or
+    allocating. Members and elements that are not on the path are skipped
+    without being parsed. The document does not need to be NUL terminated, so
+    MQTT payloads can be queried in the receive buffer.
+*******************************************************************************/
+
+#ifndef _APP_JSON_H
+#define _APP_JSON_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+
+/* Deepest nesting the scanner accepts */
+#define APP_JSON_MAX_DEPTH      32
+
+// *****************************************************************************
+
+typedef enum
+{
+    APP_JSON_TYPE_INVALID = 0,
+    APP_JSON_TYPE_OBJECT,
+    APP_JSON_TYPE_ARRAY,
+    APP_JSON_TYPE_STRING,
+    APP_JSON_TYPE_NUMBER,
+    APP_JSON_TYPE_TRUE,
+    APP_JSON_TYPE_FALSE,
+    APP_JSON_TYPE_NULL
+} APP_JSON_TYPE;
+
+typedef struct
+{
+    APP_JSON_TYPE type;
+    /* Points into the document; strings exclude the quotes and are not
+     * unescaped */
+    const char * pValue;
+    size_t length;
+} APP_JSON_VALUE;
+
+// *****************************************************************************
+
+bool APP_JSON_Find(const char * pDoc, size_t docLength, const char * pPath, APP_JSON_VALUE * pValue);
+bool APP_JSON_GetBool(const char * pDoc, size_t docLength, const char * pPath, bool * pResult);
+bool APP_JSON_GetInt(const char * pDoc, size_t docLength, const char * pPath, int32_t * pResult);
+bool APP_JSON_GetString(const char * pDoc, size_t docLength, const char * pPath, char * pBuffer, size_t bufferSize);
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif /* _APP_JSON_H */
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,328 @@
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_telemetry.c
+
+  Summary:
+    Sensor sample batching for cloud telemetry.
+
+  Description:
+    Single-producer/single-consumer ring of sensor samples. APP_CTRL pushes a
+    sample after every sensor read and APP_AWS drains the ring into one
+    PUBLISH per batch. Only the producer moves the head and only the consumer
+    moves the tail, so no lock is needed between the two tasks.
+ *******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "app_telemetry.h"
+#include "system/time/sys_time.h"
+#include "cbor.h"
+
+// *****************************************************************************
+
+#define APP_TELEMETRY_RING_MASK     (APP_TELEMETRY_RING_SIZE - 1)
+
+static APP_TELEMETRY_SAMPLE ring[APP_TELEMETRY_RING_SIZE];
+static uint32_t ringHead;
+static uint32_t ringTail;
+
+static APP_TELEMETRY_POLICY policy;
+static APP_TELEMETRY_STATS stats;
+static volatile APP_TELEMETRY_FORMAT format;
+
+// *****************************************************************************
+
+/* Each side reads the index it owns plainly. The other side's index is
+ * loaded with acquire and the own index stored with release, so a slot is
+ * never read before the sample in it is complete, nor overwritten before
+ * it has been read. */
+static uint32_t ringLoad(const uint32_t * pIndex)
+{
+    return __atomic_load_n(pIndex, __ATOMIC_ACQUIRE);
+}
+
+static void ringStore(uint32_t * pIndex, uint32_t value)
+{
+    __atomic_store_n(pIndex, value, __ATOMIC_RELEASE);
+}
+
+static uint32_t uptimeMs(void)
+{
+    return (uint32_t)((SYS_TIME_Counter64Get() * 1000) / SYS_TIME_FrequencyGet());
+}
+
+/* Encoded size of a CBOR unsigned or negative integer */
+static size_t cborUintSize(uint32_t value)
+{
+    return value < 24 ? 1 : value <= 0xFF ? 2 : value <= 0xFFFF ? 3 : 5;
+}
+
+static size_t cborIntSize(int32_t value)
+{
+    return cborUintSize(value < 0 ? (uint32_t) (-1 - value) : (uint32_t) value);
+}
+
+static size_t cborSampleSize(const APP_TELEMETRY_SAMPLE * pSample, uint32_t t0)
+{
+    return 1 + cborUintSize(pSample->timeMs - t0) + cborIntSize(pSample->temperature)
+            + cborUintSize(pSample->light);
+}
+
+/* Map header, "t0" and its value, "s" and the array header */
+static size_t cborHeaderSize(uint32_t t0, uint32_t count)
+{
+    return 1 + 3 + cborUintSize(t0) + 2 + cborUintSize(count);
+}
+
+/* Length of a batch holding the first 'count' queued samples */
+static size_t batchLength(uint32_t count)
+{
+    uint32_t tail = ringTail;
+    const APP_TELEMETRY_SAMPLE * pFirst = &ring[tail & APP_TELEMETRY_RING_MASK];
+    size_t len;
+    uint32_t i;
+
+    if(format == APP_TELEMETRY_FORMAT_CBOR){
+        len = cborHeaderSize(pFirst->timeMs, count);
+        for(i = 0; i < count; i++)
+            len += cborSampleSize(&ring[(tail + i) & APP_TELEMETRY_RING_MASK], pFirst->timeMs);
+        return len;
+    }
+
+    len = snprintf(NULL, 0, APP_TELEMETRY_BATCH_HEADER_TEMPLATE, (unsigned long) pFirst->timeMs);
+    for(i = 0; i < count; i++){
+        const APP_TELEMETRY_SAMPLE * pSample = &ring[(tail + i) & APP_TELEMETRY_RING_MASK];
+        len += snprintf(NULL, 0, APP_TELEMETRY_SAMPLE_TEMPLATE,
+                (unsigned long) (pSample->timeMs - pFirst->timeMs),
+                pSample->temperature,
+                (unsigned long) pSample->light) + (i > 0);
+    }
+    return len + sizeof(APP_TELEMETRY_BATCH_TRAILER) - 1;
+}
+
+/* CBOR flavour of encodeBatch(). Sizes are exact, so the number of samples
+ * that fit is known before the array header is written. */
+static size_t encodeBatchCbor(uint8_t * pBuffer, size_t bufferSize,
+        const APP_TELEMETRY_SAMPLE * pBase, uint32_t start, uint32_t mask,
+        uint32_t count, uint32_t * pCount)
+{
+    uint32_t t0 = pBase[start & mask].timeMs;
+    CborEncoder encoder, map, samples, sample;
+    CborError err;
+    size_t len = 0;
+    uint32_t i;
+
+    /* The array header is sized for the samples taken so far */
+    for(i = 0; i < count; i++){
+        size_t sampleSize = cborSampleSize(&pBase[(start + i) & mask], t0);
+        if(cborHeaderSize(t0, i + 1) + len + sampleSize > bufferSize)
+            break;
+        len += sampleSize;
+    }
+    if(i == 0)
+        return bufferSize + 1;
+
+    cbor_encoder_init(&encoder, pBuffer, bufferSize, 0);
+    err = cbor_encoder_create_map(&encoder, &map, 2);
+    err |= cbor_encode_text_stringz(&map, "t0");
+    err |= cbor_encode_uint(&map, t0);
+    err |= cbor_encode_text_stringz(&map, "s");
+    err |= cbor_encoder_create_array(&map, &samples, i);
+    for(count = i, i = 0; i < count; i++){
+        const APP_TELEMETRY_SAMPLE * pSample = &pBase[(start + i) & mask];
+
+        err |= cbor_encoder_create_array(&samples, &sample, 3);
+        err |= cbor_encode_uint(&sample, pSample->timeMs - t0);
+        err |= cbor_encode_int(&sample, pSample->temperature);
+        err |= cbor_encode_uint(&sample, pSample->light);
+        err |= cbor_encoder_close_container(&samples, &sample);
+    }
+    err |= cbor_encoder_close_container(&map, &samples);
+    err |= cbor_encoder_close_container(&encoder, &map);
+    if(err != CborNoError)
+        return bufferSize + 1;
+
+    *pCount = count;
+    return cbor_encoder_get_buffer_size(&encoder, pBuffer);
+}
+
+/* Formats as many of samples pBase[(start + i) & mask] as fit in pBuffer.
+ * Returns the payload length, or bufferSize + 1 if not even one sample fits. */
+static size_t encodeBatch(char * pBuffer, size_t bufferSize,
+        const APP_TELEMETRY_SAMPLE * pBase, uint32_t start, uint32_t mask,
+        uint32_t count, uint32_t * pCount)
+{
+    const APP_TELEMETRY_SAMPLE * pFirst = &pBase[start & mask];
+    size_t len, room;
+    int n;
+    uint32_t i;
+
+    *pCount = 0;
+    if(count == 0)
+        return bufferSize + 1;
+    if(format == APP_TELEMETRY_FORMAT_CBOR)
+        return encodeBatchCbor((uint8_t *) pBuffer, bufferSize, pBase, start, mask, count, pCount);
+    if(bufferSize < sizeof(APP_TELEMETRY_BATCH_TRAILER))
+        return bufferSize + 1;
+
+    /* Keep room for the trailer while adding samples; the NUL snprintf()
+     * appends may go where the trailer will be */
+    room = bufferSize - (sizeof(APP_TELEMETRY_BATCH_TRAILER) - 1);
+    n = snprintf(pBuffer, room + 1, APP_TELEMETRY_BATCH_HEADER_TEMPLATE, (unsigned long) pFirst->timeMs);
+    if(n < 0 || (size_t) n > room)
+        return bufferSize + 1;
+    len = n;
+
+    for(i = 0; i < count; i++){
+        const APP_TELEMETRY_SAMPLE * pSample = &pBase[(start + i) & mask];
+        size_t mark = len;
+
+        if(i > 0)
+            pBuffer[len++] = ',';
+        n = snprintf(pBuffer + len, room + 1 - len, APP_TELEMETRY_SAMPLE_TEMPLATE,
+                (unsigned long) (pSample->timeMs - pFirst->timeMs),
+                pSample->temperature,
+                (unsigned long) pSample->light);
+        if(n < 0 || len + n > room){
+            len = mark;
+            break;
+        }
+        len += n;
+    }
+    if(i == 0)
+        return bufferSize + 1;
+
+    memcpy(pBuffer + len, APP_TELEMETRY_BATCH_TRAILER, sizeof(APP_TELEMETRY_BATCH_TRAILER) - 1);
+    *pCount = i;
+    return len + sizeof(APP_TELEMETRY_BATCH_TRAILER) - 1;
+}
+
+// *****************************************************************************
+
+void APP_TELEMETRY_Initialize(void)
+{
+    ringStore(&ringHead, 0);
+    ringStore(&ringTail, 0);
+    policy.count = APP_TELEMETRY_FLUSH_COUNT;
+    policy.ageMs = APP_TELEMETRY_FLUSH_AGE_MS;
+    policy.bytes = APP_TELEMETRY_FLUSH_BYTES;
+    format = APP_TELEMETRY_FORMAT_DEFAULT;
+    memset(&stats, 0, sizeof(stats));
+}
+
+/* Producer side; called from APP_CTRL after a sensor read */
+void APP_TELEMETRY_Push(int16_t temperature, uint32_t light)
+{
+    uint32_t head = ringHead;
+    APP_TELEMETRY_SAMPLE * pSample;
+
+    if((head - ringLoad(&ringTail)) >= APP_TELEMETRY_RING_SIZE){
+        stats.dropped++;
+        return;
+    }
+    pSample = &ring[head & APP_TELEMETRY_RING_MASK];
+    pSample->timeMs = uptimeMs();
+    pSample->temperature = temperature;
+    pSample->light = light;
+    ringStore(&ringHead, head + 1);
+    stats.samples++;
+}
+
+/* Consumer side; true once any threshold of the flush policy is reached.
+ * Single samples go out on every publish tick. */
+bool APP_TELEMETRY_FlushDue(void)
+{
+    uint32_t count = ringLoad(&ringHead) - ringTail;
+
+    if(format == APP_TELEMETRY_FORMAT_SINGLE)
+        return true;
+    if(count == 0)
+        return false;
+    if(policy.count && count >= policy.count)
+        return true;
+    if(policy.ageMs && (uptimeMs() - ring[ringTail & APP_TELEMETRY_RING_MASK].timeMs) >= policy.ageMs)
+        return true;
+    if(policy.bytes && batchLength(count) >= policy.bytes)
+        return true;
+    return false;
+}
+
+/* Formats as many queued samples as fit in pBuffer. The samples stay queued
+ * until APP_TELEMETRY_Commit(), so a failed PUBLISH loses nothing. */
+size_t APP_TELEMETRY_Write(char * pBuffer, size_t bufferSize, uint32_t * pCount)
+{
+    uint32_t tail = ringTail;
+
+    return encodeBatch(pBuffer, bufferSize, ring, tail, APP_TELEMETRY_RING_MASK,
+            ringLoad(&ringHead) - tail, pCount);
+}
+
+/* Formats samples that are not in the ring, e.g. replayed from the journal.
+ * These always go out as a batch, in JSON unless CBOR is selected. */
+size_t APP_TELEMETRY_Encode(char * pBuffer, size_t bufferSize,
+        const APP_TELEMETRY_SAMPLE * pSamples, uint32_t count, uint32_t * pCount)
+{
+    return encodeBatch(pBuffer, bufferSize, pSamples, 0, UINT32_MAX, count, pCount);
+}
+
+/* Drops the samples carried by a queued PUBLISH */
+void APP_TELEMETRY_Commit(uint32_t count, size_t payloadLength)
+{
+    ringStore(&ringTail, ringTail + count);
+    stats.batches++;
+    stats.batchedSamples += count;
+    stats.payloadBytes += payloadLength;
+}
+
+/* Queued samples */
+uint32_t APP_TELEMETRY_Count(void)
+{
+    return ringLoad(&ringHead) - ringTail;
+}
+
+/* Moves up to 'max' of the oldest samples out of the ring, e.g. into the journal */
+uint32_t APP_TELEMETRY_Take(APP_TELEMETRY_SAMPLE * pSamples, uint32_t max)
+{
+    uint32_t tail = ringTail, count = ringLoad(&ringHead) - tail, i;
+
+    if(count > max)
+        count = max;
+    for(i = 0; i < count; i++)
+        pSamples[i] = ring[(tail + i) & APP_TELEMETRY_RING_MASK];
+    ringStore(&ringTail, tail + count);
+    return count;
+}
+
+void APP_TELEMETRY_PolicySet(const APP_TELEMETRY_POLICY * pPolicy)
+{
+    policy = *pPolicy;
+}
+
+void APP_TELEMETRY_PolicyGet(APP_TELEMETRY_POLICY * pPolicy)
+{
+    *pPolicy = policy;
+}
+
+void APP_TELEMETRY_StatsGet(APP_TELEMETRY_STATS * pStats)
+{
+    *pStats = stats;
+}
+
+void APP_TELEMETRY_FormatSet(APP_TELEMETRY_FORMAT newFormat)
+{
+    format = newFormat;
+}
+
+APP_TELEMETRY_FORMAT APP_TELEMETRY_FormatGet(void)
+{
+    return format;
+}
+
+/*******************************************************************************
+ End of File
+ */
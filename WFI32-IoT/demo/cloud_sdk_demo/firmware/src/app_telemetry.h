@@ -0,0 +1,133 @@
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_telemetry.h
+
+  Summary:
+    Sensor sample batching for cloud telemetry.
+
+  Description:
+    Sensor samples read by APP_CTRL are queued in a ring buffer. By default
+    APP_AWS publishes the latest reading on every publish tick, in the
+    single-sample format the demo webpage graphs. When batching is selected,
+    the queue is published as one compact array payload once the flush policy
+    (sample count, age of the oldest sample or payload size) is met. Batches
+    are encoded as JSON or, to save payload bytes and TLS work, as CBOR, and
+    go to their own topics. Shadow updates do not go through this queue.
+*******************************************************************************/
+
+#ifndef _APP_TELEMETRY_H
+#define _APP_TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "configuration.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+/* Debug wrappers */
+#define APP_TELEMETRY_DBG(level,fmt,...) SYS_DEBUG_PRINT(level,"[APP_TELEMETRY] "fmt,##__VA_ARGS__)
+#define APP_TELEMETRY_PRNT(fmt,...) SYS_CONSOLE_PRINT("[APP_TELEMETRY] "fmt, ##__VA_ARGS__)
+
+// *****************************************************************************
+
+/* Queued samples; a power of 2 that holds a journal record. When full, new
+ * samples are dropped. */
+#define APP_TELEMETRY_RING_SIZE             64
+
+/* Default flush policy; a batch is published when any threshold is reached */
+#define APP_TELEMETRY_FLUSH_COUNT           8
+#define APP_TELEMETRY_FLUSH_AGE_MS          15000
+#define APP_TELEMETRY_FLUSH_BYTES           160
+
+/* Batch payload: {"t0":<ms>,"s":[[<dt ms>,<temp C>,<light lux>],...]} */
+#define APP_TELEMETRY_BATCH_HEADER_TEMPLATE "{\"t0\":%lu,\"s\":["
+#define APP_TELEMETRY_SAMPLE_TEMPLATE       "[%lu,%d,%lu]"
+#define APP_TELEMETRY_BATCH_TRAILER         "]}"
+
+/* Batches are published on the sensor topic with these suffixes, so that
+ * consumers of <thing>/sensors keep getting single samples. CBOR batches
+ * carry the same map as JSON ones. */
+#define APP_TELEMETRY_BATCH_TOPIC_SUFFIX    "/batch"
+#define APP_TELEMETRY_CBOR_TOPIC_SUFFIX     "/cbor"
+
+/* Payload format used after boot */
+#define APP_TELEMETRY_FORMAT_DEFAULT        APP_TELEMETRY_FORMAT_SINGLE
+
+/* Rough per-batch cost besides the payload: MQTT fixed header and topic,
+ * TLS 1.2 AES-GCM record overhead (29 bytes) for the PUBLISH and its PUBACK */
+#define APP_TELEMETRY_BATCH_OVERHEAD_BYTES  128
+
+// *****************************************************************************
+
+typedef enum
+{
+    APP_TELEMETRY_FORMAT_JSON = 0,
+    APP_TELEMETRY_FORMAT_CBOR,
+    /* No batching: one APP_AWS_TELEMETRY_MSG_TEMPLATE object per publish tick */
+    APP_TELEMETRY_FORMAT_SINGLE
+} APP_TELEMETRY_FORMAT;
+
+typedef struct
+{
+    uint32_t timeMs;
+    int16_t temperature;
+    uint32_t light;
+} APP_TELEMETRY_SAMPLE;
+
+typedef struct
+{
+    /* Flush thresholds; 0 disables a threshold */
+    uint32_t count;
+    uint32_t ageMs;
+    uint32_t bytes;
+} APP_TELEMETRY_POLICY;
+
+typedef struct
+{
+    uint32_t samples;           /* samples queued */
+    uint32_t dropped;           /* samples lost to a full ring */
+    uint32_t batches;           /* batches published */
+    uint32_t batchedSamples;    /* samples carried by those batches */
+    uint32_t payloadBytes;      /* payload bytes of those batches */
+} APP_TELEMETRY_STATS;
+
+// *****************************************************************************
+
+void APP_TELEMETRY_Initialize(void);
+void APP_TELEMETRY_Push(int16_t temperature, uint32_t light);
+bool APP_TELEMETRY_FlushDue(void);
+size_t APP_TELEMETRY_Write(char * pBuffer, size_t bufferSize, uint32_t * pCount);
+size_t APP_TELEMETRY_Encode(char * pBuffer, size_t bufferSize,
+        const APP_TELEMETRY_SAMPLE * pSamples, uint32_t count, uint32_t * pCount);
+void APP_TELEMETRY_Commit(uint32_t count, size_t payloadLength);
+uint32_t APP_TELEMETRY_Count(void);
+uint32_t APP_TELEMETRY_Take(APP_TELEMETRY_SAMPLE * pSamples, uint32_t max);
+void APP_TELEMETRY_PolicySet(const APP_TELEMETRY_POLICY * pPolicy);
+void APP_TELEMETRY_PolicyGet(APP_TELEMETRY_POLICY * pPolicy);
+void APP_TELEMETRY_StatsGet(APP_TELEMETRY_STATS * pStats);
+void APP_TELEMETRY_FormatSet(APP_TELEMETRY_FORMAT format);
+APP_TELEMETRY_FORMAT APP_TELEMETRY_FormatGet(void);
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif /* _APP_TELEMETRY_H */
+
+/*******************************************************************************
+ End of File
+ */
@@ -19,7 +19,7 @@
 #include "app.h"
 #include "app_common.h"
 #include "app_usb_msd.h"
-#include "cJSON.h"
+#include "app_json.h"
 #include "wdrv_pic32mzw_client_api.h"
 #include "wolfcrypt/asn.h"
 #include "atca_basic.h"
@@ -292,32 +292,16 @@ static int8_t readCloudConfigFile() {
             }
             
             /*Parse the file */
-            cJSON *messageJson = cJSON_Parse(configString);
-            if (messageJson == NULL) {
-                const char *error_ptr = cJSON_GetErrorPtr();            
-                if (error_ptr != NULL) {
-                    APP_USB_MSD_DBG(SYS_ERROR_ERROR, "Message JSON parse Error. Error before: %s \r\n", error_ptr);
-            }
-                cJSON_Delete(messageJson);
-                return -1;
-            }
-            
-            cJSON *endpoint = cJSON_GetObjectItem(messageJson, "Endpoint");
-            if (!endpoint || endpoint->type !=cJSON_String ) {
+            if (!APP_JSON_GetString(configString, rSize, "Endpoint", g_Cloud_Endpoint, sizeof(g_Cloud_Endpoint))) {
                 APP_USB_MSD_DBG(SYS_ERROR_ERROR, "JSON endpoint parsing error\r\n");
-                cJSON_Delete(messageJson);
                 return -1;
             }
-            snprintf(g_Cloud_Endpoint, sizeof(g_Cloud_Endpoint), "%s", endpoint->valuestring);
 #ifdef AWS_CLOUD_DEMO
             //Get the ClientID
-            cJSON *clientID = cJSON_GetObjectItem(messageJson, "ClientID");
-            if (!clientID || endpoint->type !=cJSON_String ) {
+            if (!APP_JSON_GetString(configString, rSize, "ClientID", g_Aws_ClientID, sizeof(g_Aws_ClientID))) {
                 APP_USB_MSD_DBG(SYS_ERROR_ERROR, "JSON ClientID parsing error\r\n");
-                cJSON_Delete(messageJson);
                 return -1;
             }
-            snprintf(g_Aws_ClientID, sizeof(g_Aws_ClientID), "%s", clientID->valuestring);
 #endif
         }
         else
@@ -124,7 +124,7 @@ extern "C" {
 #define SYS_FS_VOLUME_NUMBER              (1U)
 
 #define SYS_FS_AUTOMOUNT_ENABLE           false
-#define SYS_FS_MAX_FILES                  (2U)
+#define SYS_FS_MAX_FILES                  (3U)
 #define SYS_FS_MAX_FILE_SYSTEM_TYPE       (1U)
 #define SYS_FS_MEDIA_MAX_BLOCK_SIZE       (512U)
 #define SYS_FS_MEDIA_MANAGER_BUFFER_SIZE  (2048U)
@@ -287,6 +287,7 @@ extern "C" {
 #define HAVE_TLS_EXTENSIONS
 #define HAVE_SUPPORTED_CURVES
 #define HAVE_SNI
+#define HAVE_SESSION_TICKET
 #define NO_ERROR_STRINGS
 #define NO_OLD_TLS
 #define USE_FAST_MATH
@@ -316,6 +317,15 @@ extern "C" {
 #define TCPIP_TCP_EXTERN_PACKET_PROCESS   false
 #define TCPIP_TCP_DISABLE_CRYPTO_USAGE		        	    false
 
+/* RX buffers tuned at run time within a budget shared by all sockets: */
+/* busy sockets double their buffer, idle ones drop to the minimum size */
+#define TCPIP_TCP_RX_AUTO_TUNE                  true
+#define TCPIP_TCP_RX_AUTO_BUDGET                14600
+#define TCPIP_TCP_RX_AUTO_MIN_SIZE              536
+#define TCPIP_TCP_RX_AUTO_MAX_SIZE              11680
+#define TCPIP_TCP_RX_AUTO_INTERVAL              250
+#define TCPIP_TCP_RX_AUTO_IDLE_TMO              2000
+
 
 
 /*** ARP Configuration ***/
@@ -424,7 +434,7 @@ extern "C" {
 #define TCPIP_DNS_CLIENT_MAX_SELECT_INTERFACES		4
 #define TCPIP_DNS_CLIENT_DELETE_OLD_ENTRIES			true
 #define TCPIP_DNS_CLIENT_CONSOLE_CMD               	true
-#define TCPIP_DNS_CLIENT_USER_NOTIFICATION   false
+#define TCPIP_DNS_CLIENT_USER_NOTIFICATION   true
 
 
 
@@ -566,6 +576,17 @@ extern "C" {
 
 #define TCPIP_PACKET_LOG_ENABLE     0
 
+/*** TCPIP packet pools ***/
+/* Block size covers the packet descriptor, the segment and its cache aligned load; */
+/* classes in increasing block size. 0 blocks disables a class */
+#define TCPIP_PKT_POOL_ENABLE                   true
+#define TCPIP_PKT_POOL_SMALL_BLOCK_SIZE         384
+#define TCPIP_PKT_POOL_SMALL_BLOCKS             8
+#define TCPIP_PKT_POOL_TX_BLOCK_SIZE            768
+#define TCPIP_PKT_POOL_TX_BLOCKS                2
+#define TCPIP_PKT_POOL_RX_BLOCK_SIZE            1728
+#define TCPIP_PKT_POOL_RX_BLOCKS                6
+
 /* TCP/IP stack event notification */
 #define TCPIP_STACK_USE_EVENT_NOTIFICATION
 #define TCPIP_STACK_USER_NOTIFICATION   true
@@ -663,6 +684,7 @@ extern "C" {
 #define WOLFSSL_ATECC_ECDH_IOENC
 #define HAVE_PK_CALLBACKS
 #define WOLFSSL_ATECC508A_NOIDLE
+#define WOLFSSL_ATECC_KEY_PREFETCH
 // ---------- FUNCTIONAL CONFIGURATION END ----------
 
 /* Maximum instances of MSD function driver */
@@ -115,6 +115,17 @@ typedef void ( *DRV_BA414E_CALLBACK )
     uintptr_t context
 );
 
+// Scheduling class of a client's operations. When the engine is free, it runs
+// the pending operation of the highest class, the oldest one within a class.
+// Running operations are never preempted.
+typedef enum
+{
+    DRV_BA414E_PRIORITY_HIGH = 0,      // latency sensitive, e.g. TLS handshakes
+    DRV_BA414E_PRIORITY_NORMAL,        // default of a newly opened client
+    DRV_BA414E_PRIORITY_LOW,           // background work
+    DRV_BA414E_PRIORITY_COUNT
+} DRV_BA414E_PRIORITY;
+
 // PIC32MZW1 hardware module operand size.
 // Domains with smaller operands must be rounded up to the specified bit sizes
 typedef enum
@@ -469,6 +480,47 @@ DRV_HANDLE DRV_BA414E_Open( const SYS_MODULE_INDEX index,
 */
 void DRV_BA414E_Close( const DRV_HANDLE handle);
 
+// *****************************************************************************
+/* Function:
+    void DRV_BA414E_PrioritySet( const DRV_HANDLE handle,
+        DRV_BA414E_PRIORITY priority)
+
+  Summary:
+    Sets the scheduling class of a client's operations.
+    <p><b>Implementation:</b> Static</p>
+
+  Description:
+    Operations of all clients wait in the driver until the engine is free.
+    The next one to run is taken from the highest priority class that has
+    one pending, in submission order within the class. A client opened with
+    DRV_BA414E_Open starts at DRV_BA414E_PRIORITY_NORMAL.
+
+  Precondition:
+    DRV_BA414E_Open must have been called to obtain a valid opened
+    device handle.
+
+  Parameters:
+    handle       - A valid open-instance handle, returned from the driver's
+                   open routine
+
+    priority     - Class of the operations submitted from now on
+
+  Returns:
+    None.
+
+  Example:
+    <code>
+    DRV_HANDLE handle;  // Returned from DRV_BA414E_Open
+
+    DRV_BA414E_PrioritySet(handle, DRV_BA414E_PRIORITY_HIGH);
+    </code>
+
+  Remarks:
+    The class of an operation already pending is changed as well. An
+    operation that already runs is not affected.
+*/
+void DRV_BA414E_PrioritySet( const DRV_HANDLE handle, DRV_BA414E_PRIORITY priority);
+
 // *****************************************************************************
 /* Function:
     DRV_BA414E_OP_RESULT DRV_BA414E_ECDSA_Sign(     const DRV_HANDLE handle,
@@ -382,9 +382,9 @@ static void DRV_BA414E_copyFromScm2(void* pdata,
         
 }
 
-static void DRV_BA414E_scmClear(void)
+static void DRV_BA414E_scmClearFrom(uint8_t slotNum)
 {
-    uint32_t addr = (DRV_BA414E_SCMEM_BASE);
+    uint32_t addr = DRV_BA414E_getSlotAddr(slotNum);
 
     while ( addr < (DRV_BA414E_SCMEM_END) ) {
         *(uint32_t*)(addr) = 0x0;
@@ -392,6 +392,59 @@ static void DRV_BA414E_scmClear(void)
     }
 }
 
+static void DRV_BA414E_scmClear(void)
+{
+    DRV_BA414E_scmClearFrom(0);
+    opData.scmDomainValid = 0;
+}
+
+// The curve parameters take the first slots in both the ECDSA and the ECC
+// primitive layouts. They stay in the crypto memory between operations on the
+// same curve, whichever client those come from; only the operand slots after
+// them are cleared.
+static void DRV_BA414E_LoadDomain(const DRV_BA414E_ECC_DOMAIN * domain)
+{
+    const uint8_t * params[BA414E_ECC_DOMAIN_SLOTS] = {
+        domain->primeField, domain->order, domain->generatorX,
+        domain->generatorY, domain->a, domain->b
+    };
+    uint32_t len = domain->keySize;
+    uint8_t slot;
+
+    if ((opData.scmDomainValid == 1) && (opData.scmDomainKeySize == len) &&
+        (opData.scmDomainOpSize == domain->opSize))
+    {
+        for (slot = 0; slot < BA414E_ECC_DOMAIN_SLOTS; slot++)
+        {
+            if (memcmp(opData.scmDomain[slot], params[slot], len) != 0)
+            {
+                break;
+            }
+        }
+        if (slot == BA414E_ECC_DOMAIN_SLOTS)
+        {
+            DRV_BA414E_scmClearFrom(BA414E_ECC_DOMAIN_SLOTS);
+            return;
+        }
+    }
+
+    DRV_BA414E_scmClear();
+    for (slot = 0; slot < BA414E_ECC_DOMAIN_SLOTS; slot++)
+    {
+        DRV_BA414E_copyToScm4(params[slot], len, slot, 0, 0, 0);
+    }
+    if (len <= DRV_BA414E_MAX_KEY_SIZE)
+    {
+        for (slot = 0; slot < BA414E_ECC_DOMAIN_SLOTS; slot++)
+        {
+            memcpy(opData.scmDomain[slot], params[slot], len);
+        }
+        opData.scmDomainKeySize = len;
+        opData.scmDomainOpSize = domain->opSize;
+        opData.scmDomainValid = 1;
+    }
+}
+
 static void DRV_BA414E_ucmemInit(void)
 {
     uint32_t i, j;
@@ -559,6 +612,7 @@ DRV_HANDLE DRV_BA414E_Open( const SYS_MODULE_INDEX index,
                 {
                     clientData[found].inUse = 1;
                     clientData[found].ioIntent = ioIntent;
+                    clientData[found].priority = DRV_BA414E_PRIORITY_NORMAL;
                     ret = (DRV_HANDLE)&(clientData[found]);
                 }
 #if defined(DRV_BA414E_RTOS_STACK_SIZE)
@@ -588,6 +642,15 @@ void DRV_BA414E_Close( const DRV_HANDLE handle)
     }           
 }
 
+void DRV_BA414E_PrioritySet( const DRV_HANDLE handle, DRV_BA414E_PRIORITY priority)
+{
+    if ((handle != DRV_HANDLE_INVALID) && (priority < DRV_BA414E_PRIORITY_COUNT))
+    {
+        DRV_BA414E_ClientData * cd = (DRV_BA414E_ClientData*)handle;
+        cd->priority = priority;
+    }
+}
+
 
 SYS_STATUS DRV_BA414E_Status( SYS_MODULE_OBJ object)
 {
@@ -649,7 +712,6 @@ void DRV_BA414E_PrepareEcdsaSign(DRV_BA414E_ClientData * cd)
 {
     uint32_t len = cd->ecdsaSignParams.domain->keySize;
 
-    DRV_BA414E_scmClear();
     BA414E_PKCOMMANDbits cmd = {{0}};
     cmd.s.OPERATION = BA414E_OPC_ECC_ECDSA_SIGN;
     cmd.s.OPSIZE = cd->ecdsaSignParams.domain->opSize;
@@ -658,12 +720,7 @@ void DRV_BA414E_PrepareEcdsaSign(DRV_BA414E_ClientData * cd)
     PKCONFIG = 0;
     
     
-    DRV_BA414E_copyToScm4(cd->ecdsaSignParams.domain->primeField, len, BA414E_ECDSA_SLOT_P, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->ecdsaSignParams.domain->order, len, BA414E_ECDSA_SLOT_N, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->ecdsaSignParams.domain->generatorX, len, BA414E_ECDSA_SLOT_GX, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->ecdsaSignParams.domain->generatorY, len, BA414E_ECDSA_SLOT_GY, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->ecdsaSignParams.domain->a, len, BA414E_ECDSA_SLOT_A, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->ecdsaSignParams.domain->b, len, BA414E_ECDSA_SLOT_B, 0, 0, 0);    
+    DRV_BA414E_LoadDomain(cd->ecdsaSignParams.domain);
     
     DRV_BA414E_copyToScm4(cd->ecdsaSignParams.privateKey, len, BA414E_ECDSA_SLOT_PRIV_KEY, 0, 0, 0);    
     DRV_BA414E_copyToScm4(cd->ecdsaSignParams.k, len, BA414E_ECDSA_SLOT_K, 0, 0, 0);    
@@ -679,7 +736,6 @@ void DRV_BA414E_PrepareEcdsaVerify(DRV_BA414E_ClientData * cd)
 {
     uint32_t len = cd->ecdsaVerifyParams.domain->keySize;
 
-    DRV_BA414E_scmClear();
     BA414E_PKCOMMANDbits cmd = {{0}};
     cmd.s.OPERATION = BA414E_OPC_ECC_ECDSA_VERIFY;
     cmd.s.OPSIZE = cd->ecdsaVerifyParams.domain->opSize;
@@ -687,12 +743,7 @@ void DRV_BA414E_PrepareEcdsaVerify(DRV_BA414E_ClientData * cd)
     PKCOMMAND = cmd.v;
     PKCONFIG = 0;
         
-    DRV_BA414E_copyToScm4(cd->ecdsaVerifyParams.domain->primeField, len, BA414E_ECDSA_SLOT_P, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->ecdsaVerifyParams.domain->order, len, BA414E_ECDSA_SLOT_N, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->ecdsaVerifyParams.domain->generatorX, len, BA414E_ECDSA_SLOT_GX, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->ecdsaVerifyParams.domain->generatorY, len, BA414E_ECDSA_SLOT_GY, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->ecdsaVerifyParams.domain->a, len, BA414E_ECDSA_SLOT_A, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->ecdsaVerifyParams.domain->b, len, BA414E_ECDSA_SLOT_B, 0, 0, 0);    
+    DRV_BA414E_LoadDomain(cd->ecdsaVerifyParams.domain);
     
     DRV_BA414E_copyToScm4(cd->ecdsaVerifyParams.publicKeyX, len, BA414E_ECDSA_SLOT_X0, 0, 0, 0);    
     DRV_BA414E_copyToScm4(cd->ecdsaVerifyParams.publicKeyY, len, BA414E_ECDSA_SLOT_Y0, 0, 0, 0);
@@ -711,7 +762,6 @@ void DRV_BA414E_PrimEccPointDouble(DRV_BA414E_ClientData * cd)
 {
     uint32_t len = cd->eccPointDoubleParams.domain->keySize;
 
-    DRV_BA414E_scmClear();
     BA414E_PKCOMMANDbits cmd = {{0}};
     cmd.s.OPERATION = BA414E_OPC_PRIM_ECC_POINT_DOUBLE;
     cmd.s.OPSIZE = cd->eccPointDoubleParams.domain->opSize;
@@ -722,12 +772,7 @@ void DRV_BA414E_PrimEccPointDouble(DRV_BA414E_ClientData * cd)
     PKCONFIG = cfg.v;
     PKCOMMAND = cmd.v;
     
-    DRV_BA414E_copyToScm4(cd->eccPointDoubleParams.domain->primeField, len, BA414E_ECCP_SLOT_P, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->eccPointDoubleParams.domain->order, len, BA414E_ECCP_SLOT_N, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->eccPointDoubleParams.domain->generatorX, len, BA414E_ECCP_SLOT_GX, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->eccPointDoubleParams.domain->generatorY, len, BA414E_ECCP_SLOT_GY, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->eccPointDoubleParams.domain->a, len, BA414E_ECCP_SLOT_A, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->eccPointDoubleParams.domain->b, len, BA414E_ECCP_SLOT_B, 0, 0, 0);    
+    DRV_BA414E_LoadDomain(cd->eccPointDoubleParams.domain);
     
     DRV_BA414E_copyToScm4(cd->eccPointDoubleParams.p1X, len, BA414E_ECCP_SLOT_P1X, 0, 0, 0);    
     DRV_BA414E_copyToScm4(cd->eccPointDoubleParams.p1Y, len, BA414E_ECCP_SLOT_P1Y, 0, 0, 0);    
@@ -743,7 +788,6 @@ void DRV_BA414E_PrimEccPointAddition(DRV_BA414E_ClientData * cd)
 {
     uint32_t len = cd->eccPointDoubleParams.domain->keySize;
 
-    DRV_BA414E_scmClear();
     BA414E_PKCOMMANDbits cmd = {{0}};
     cmd.s.OPERATION = BA414E_OPC_PRIM_ECC_POINT_ADDITION;
     cmd.s.OPSIZE = cd->eccPointAdditionParams.domain->opSize;
@@ -755,12 +799,7 @@ void DRV_BA414E_PrimEccPointAddition(DRV_BA414E_ClientData * cd)
     PKCONFIG = cfg.v;
     PKCOMMAND = cmd.v;
     
-    DRV_BA414E_copyToScm4(cd->eccPointAdditionParams.domain->primeField, len, BA414E_ECCP_SLOT_P, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->eccPointAdditionParams.domain->order, len, BA414E_ECCP_SLOT_N, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->eccPointAdditionParams.domain->generatorX, len, BA414E_ECCP_SLOT_GX, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->eccPointAdditionParams.domain->generatorY, len, BA414E_ECCP_SLOT_GY, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->eccPointAdditionParams.domain->a, len, BA414E_ECCP_SLOT_A, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->eccPointAdditionParams.domain->b, len, BA414E_ECCP_SLOT_B, 0, 0, 0);    
+    DRV_BA414E_LoadDomain(cd->eccPointAdditionParams.domain);
     
     DRV_BA414E_copyToScm4(cd->eccPointAdditionParams.p1X, len, BA414E_ECCP_SLOT_P1X, 0, 0, 0);    
     DRV_BA414E_copyToScm4(cd->eccPointAdditionParams.p1Y, len, BA414E_ECCP_SLOT_P1Y, 0, 0, 0);    
@@ -778,7 +817,6 @@ void DRV_BA414E_PrimEccPointMultiplication(DRV_BA414E_ClientData * cd)
 {
     uint32_t len = cd->eccPointDoubleParams.domain->keySize;
 
-    DRV_BA414E_scmClear();
     BA414E_PKCOMMANDbits cmd = {{0}};
     cmd.s.OPERATION = BA414E_OPC_PRIM_ECC_POINT_MULTI;
     cmd.s.OPSIZE = cd->eccPointAdditionParams.domain->opSize;
@@ -790,12 +828,7 @@ void DRV_BA414E_PrimEccPointMultiplication(DRV_BA414E_ClientData * cd)
     PKCONFIG = cfg.v;
     PKCOMMAND = cmd.v;
     
-    DRV_BA414E_copyToScm4(cd->eccPointMultiplicationParams.domain->primeField, len, BA414E_ECCP_SLOT_P, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->eccPointMultiplicationParams.domain->order, len, BA414E_ECCP_SLOT_N, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->eccPointMultiplicationParams.domain->generatorX, len, BA414E_ECCP_SLOT_GX, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->eccPointMultiplicationParams.domain->generatorY, len, BA414E_ECCP_SLOT_GY, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->eccPointMultiplicationParams.domain->a, len, BA414E_ECCP_SLOT_A, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->eccPointMultiplicationParams.domain->b, len, BA414E_ECCP_SLOT_B, 0, 0, 0);    
+    DRV_BA414E_LoadDomain(cd->eccPointMultiplicationParams.domain);
     
     DRV_BA414E_copyToScm4(cd->eccPointMultiplicationParams.p1X, len, BA414E_ECCP_SLOT_P1X, 0, 0, 0);    
     DRV_BA414E_copyToScm4(cd->eccPointMultiplicationParams.p1Y, len, BA414E_ECCP_SLOT_P1Y, 0, 0, 0);    
@@ -813,7 +846,6 @@ void DRV_BA414E_PrimEccCheckPointOnCurve(DRV_BA414E_ClientData * cd)
 {
     uint32_t len = cd->eccPointDoubleParams.domain->keySize;
 
-    DRV_BA414E_scmClear();
     BA414E_PKCOMMANDbits cmd = {{0}};
     cmd.s.OPERATION = BA414E_OPC_PRIM_ECC_POINT_CHECK_POINT_ON_CURVE;
     cmd.s.OPSIZE = cd->eccPointAdditionParams.domain->opSize;
@@ -823,12 +855,7 @@ void DRV_BA414E_PrimEccCheckPointOnCurve(DRV_BA414E_ClientData * cd)
     PKCONFIG = cfg.v;
     PKCOMMAND = cmd.v;
     
-    DRV_BA414E_copyToScm4(cd->eccCheckPointOnCurveParams.domain->primeField, len, BA414E_ECCP_SLOT_P, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->eccCheckPointOnCurveParams.domain->order, len, BA414E_ECCP_SLOT_N, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->eccCheckPointOnCurveParams.domain->generatorX, len, BA414E_ECCP_SLOT_GX, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->eccCheckPointOnCurveParams.domain->generatorY, len, BA414E_ECCP_SLOT_GY, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->eccCheckPointOnCurveParams.domain->a, len, BA414E_ECCP_SLOT_A, 0, 0, 0);    
-    DRV_BA414E_copyToScm4(cd->eccCheckPointOnCurveParams.domain->b, len, BA414E_ECCP_SLOT_B, 0, 0, 0);    
+    DRV_BA414E_LoadDomain(cd->eccCheckPointOnCurveParams.domain);
     
     DRV_BA414E_copyToScm4(cd->eccCheckPointOnCurveParams.p1X, len, BA414E_ECCP_SLOT_P1X, 0, 0, 0);    
     DRV_BA414E_copyToScm4(cd->eccCheckPointOnCurveParams.p1Y, len, BA414E_ECCP_SLOT_P1Y, 0, 0, 0);    
@@ -1162,6 +1189,10 @@ void DRV_BA414E_Process(DRV_BA414E_ClientData * cd)
     SYS_INT_SourceDisable(INT_SOURCE_CRYPTO1_FAULT);
     SYS_INT_SourceStatusClear(INT_SOURCE_CRYPTO1);
     SYS_INT_SourceStatusClear(INT_SOURCE_CRYPTO1_FAULT);
+    if (opData.errorInterrupt == 1)
+    {   // don't trust the curve parameters left by a faulted operation
+        opData.scmDomainValid = 0;
+    }
     switch(cd->currentOp)
     {
         case DRV_BA414E_OP_ECDSA_SIGN:
@@ -1197,6 +1228,28 @@ void DRV_BA414E_Process(DRV_BA414E_ClientData * cd)
 
 }
 
+// Picks the next operation: the highest priority class first, and the
+// oldest submission within a class
+static DRV_BA414E_ClientData * DRV_BA414E_NextClient(void)
+{
+    DRV_BA414E_ClientData * next = NULL;
+    int counter;
+    for (counter = 0; counter < DRV_BA414E_NUM_CLIENTS; counter++)
+    {
+        DRV_BA414E_ClientData * cd = &clientData[counter];
+        if (cd->currentOp == DRV_BA414E_OP_NONE)
+        {
+            continue;
+        }
+        if ((next == NULL) || (cd->priority < next->priority) ||
+            ((cd->priority == next->priority) && ((int32_t)(cd->seq - next->seq) < 0)))
+        {
+            next = cd;
+        }
+    }
+    return next;
+}
+
 void DRV_BA414E_Tasks(SYS_MODULE_OBJ obj)
 {
     if (obj == (SYS_MODULE_OBJ)&opData)
@@ -1212,31 +1265,22 @@ void DRV_BA414E_Tasks(SYS_MODULE_OBJ obj)
 #if defined(DRV_BA414E_RTOS_STACK_SIZE)
                 OSAL_SEM_Pend(&opData.clientAction, OSAL_WAIT_FOREVER);
 #endif
-                int counter;
-                for (counter = 0; counter < DRV_BA414E_NUM_CLIENTS; counter++)
+#if defined(DRV_BA414E_RTOS_STACK_SIZE)
+                OSAL_SEM_Pend(&opData.clientListSema, OSAL_WAIT_FOREVER);
+#endif
+                opData.currentClient = DRV_BA414E_NextClient();
+#if defined(DRV_BA414E_RTOS_STACK_SIZE)
+                OSAL_SEM_Post(&opData.clientListSema);
+#endif
+                if (opData.currentClient != NULL)
                 {
-                    if (clientData[counter].currentOp != DRV_BA414E_OP_NONE)
-                    {                        
-                        opData.state = DRV_BA414E_PREPARING;
-                        opData.currentClient = &clientData[counter];
-                        break;
-                    }
+                    opData.state = DRV_BA414E_PREPARING;
                 }
             }
             break;
             case DRV_BA414E_PREPARING:
-            {
-                int counter;
-                for (counter = 0; counter < DRV_BA414E_NUM_CLIENTS; counter++)
-                {
-                    if (clientData[counter].currentOp != DRV_BA414E_OP_NONE)
-                    {
-                        opData.state = DRV_BA414E_WAITING;
-                        DRV_BA414E_Prepare(&clientData[counter]);
-                        break;
-                    }
-                }                
-            }   
+                opData.state = DRV_BA414E_WAITING;
+                DRV_BA414E_Prepare(opData.currentClient);
             break;
             case DRV_BA414E_WAITING:
 #if defined(DRV_BA414E_RTOS_STACK_SIZE)
@@ -1268,8 +1312,6 @@ void DRV_BA414_BlockingCallback(DRV_BA414E_OP_RESULT result, uintptr_t context)
 
 DRV_BA414E_OP_RESULT DRV_BA414_BlockingHelper(DRV_BA414E_ClientData * cd)
 {
-    cd->context = (uintptr_t)cd;
-    cd->callback = DRV_BA414_BlockingCallback;
 #if defined(DRV_BA414E_RTOS_STACK_SIZE)
     OSAL_SEM_Post(&opData.clientAction);
     OSAL_SEM_Pend(&cd->clientBlock, OSAL_WAIT_FOREVER);
@@ -1277,6 +1319,37 @@ DRV_BA414E_OP_RESULT DRV_BA414_BlockingHelper(DRV_BA414E_ClientData * cd)
     return cd->blockingResult;
 }
 
+static DRV_BA414E_OP_RESULT DRV_BA414E_Submit(DRV_BA414E_ClientData * cd,
+        DRV_BA414E_OPERATIONS op, DRV_BA414E_CALLBACK callback, uintptr_t context)
+{
+    if ((cd->ioIntent & DRV_IO_INTENT_NONBLOCKING) != DRV_IO_INTENT_NONBLOCKING)
+    {
+        callback = DRV_BA414_BlockingCallback;
+        context = (uintptr_t)cd;
+    }
+    // Clients submit from their own tasks; the sequence number and the
+    // operation are published together, under the lock the scheduler
+    // takes to pick the next operation
+#if defined(DRV_BA414E_RTOS_STACK_SIZE)
+    OSAL_SEM_Pend(&opData.clientListSema, OSAL_WAIT_FOREVER);
+#endif
+    cd->seq = opData.nextSeq++;
+    cd->callback = callback;
+    cd->context = context;
+    cd->currentOp = op;
+#if defined(DRV_BA414E_RTOS_STACK_SIZE)
+    OSAL_SEM_Post(&opData.clientListSema);
+#endif
+    if ((cd->ioIntent & DRV_IO_INTENT_NONBLOCKING) == DRV_IO_INTENT_NONBLOCKING)
+    {
+#if defined(DRV_BA414E_RTOS_STACK_SIZE)
+        OSAL_SEM_Post(&opData.clientAction);
+#endif
+        return DRV_BA414E_OP_PENDING;
+    }
+    return DRV_BA414_BlockingHelper(cd);
+}
+
 DRV_BA414E_OP_RESULT DRV_BA414E_ECDSA_Sign(
     const DRV_HANDLE handle,
     const DRV_BA414E_ECC_DOMAIN * domain,
@@ -1305,20 +1378,7 @@ DRV_BA414E_OP_RESULT DRV_BA414E_ECDSA_Sign(
             cd->ecdsaSignParams.k = k;
             cd->ecdsaSignParams.msgHash = msgHash;
             cd->ecdsaSignParams.msgHashSz = msgHashSz;
-            cd->currentOp = DRV_BA414E_OP_ECDSA_SIGN;
-            if ((cd->ioIntent & DRV_IO_INTENT_NONBLOCKING) == DRV_IO_INTENT_NONBLOCKING)
-            {
-                cd->callback = callback;
-                cd->context = context;
-#if defined(DRV_BA414E_RTOS_STACK_SIZE)
-                OSAL_SEM_Post(&opData.clientAction);
-#endif
-                ret = DRV_BA414E_OP_PENDING;
-            }
-            else
-            {
-                ret = DRV_BA414_BlockingHelper(cd);
-            }
+            ret = DRV_BA414E_Submit(cd, DRV_BA414E_OP_ECDSA_SIGN, callback, context);
         }
     }
     return ret;
@@ -1355,20 +1415,7 @@ DRV_BA414E_OP_RESULT DRV_BA414E_ECDSA_Verify(
             cd->ecdsaVerifyParams.publicKeyY = publicKeyY;
             cd->ecdsaVerifyParams.msgHash = msgHash;
             cd->ecdsaVerifyParams.msgHashSz = msgHashSz;
-            cd->currentOp = DRV_BA414E_OP_ECDSA_VERIFY;
-            if ((cd->ioIntent & DRV_IO_INTENT_NONBLOCKING) == DRV_IO_INTENT_NONBLOCKING)
-            {
-                cd->callback = callback;
-                cd->context = context;
-#if defined(DRV_BA414E_RTOS_STACK_SIZE)
-                OSAL_SEM_Post(&opData.clientAction);
-#endif
-                ret = DRV_BA414E_OP_PENDING;
-            }
-            else
-            {
-                ret = DRV_BA414_BlockingHelper(cd);
-            }
+            ret = DRV_BA414E_Submit(cd, DRV_BA414E_OP_ECDSA_VERIFY, callback, context);
         }
     }
     return ret;
@@ -1400,20 +1447,7 @@ DRV_BA414E_OP_RESULT DRV_BA414E_PRIM_EccPointDouble(
             cd->eccPointDoubleParams.outY = outY;
             cd->eccPointDoubleParams.p1X = p1X;
             cd->eccPointDoubleParams.p1Y = p1Y;
-            cd->currentOp = DRV_BA414E_OP_PRIM_ECC_POINT_DOUBLE;
-            if ((cd->ioIntent & DRV_IO_INTENT_NONBLOCKING) == DRV_IO_INTENT_NONBLOCKING)
-            {
-                cd->callback = callback;
-                cd->context = context;
-#if defined(DRV_BA414E_RTOS_STACK_SIZE)
-                OSAL_SEM_Post(&opData.clientAction);
-#endif
-                ret = DRV_BA414E_OP_PENDING;
-            }
-            else
-            {
-                ret = DRV_BA414_BlockingHelper(cd);
-            }
+            ret = DRV_BA414E_Submit(cd, DRV_BA414E_OP_PRIM_ECC_POINT_DOUBLE, callback, context);
         }
     }   
     return ret;
@@ -1448,20 +1482,7 @@ DRV_BA414E_OP_RESULT DRV_BA414E_PRIM_EccPointAddition(
             cd->eccPointAdditionParams.p1Y = p1Y;
             cd->eccPointAdditionParams.p2X = p2X;
             cd->eccPointAdditionParams.p2Y = p2Y;
-            cd->currentOp = DRV_BA414E_OP_PRIM_ECC_POINT_ADDITION;
-            if ((cd->ioIntent & DRV_IO_INTENT_NONBLOCKING) == DRV_IO_INTENT_NONBLOCKING)
-            {
-                cd->callback = callback;
-                cd->context = context;
-#if defined(DRV_BA414E_RTOS_STACK_SIZE)
-                OSAL_SEM_Post(&opData.clientAction);
-#endif
-                ret = DRV_BA414E_OP_PENDING;
-            }
-            else
-            {
-                ret = DRV_BA414_BlockingHelper(cd);
-            }
+            ret = DRV_BA414E_Submit(cd, DRV_BA414E_OP_PRIM_ECC_POINT_ADDITION, callback, context);
         }
     }   
     return ret;    
@@ -1493,20 +1514,7 @@ DRV_BA414E_OP_RESULT DRV_BA414E_PRIM_EccPointMultiplication(
             cd->eccPointMultiplicationParams.p1X = p1X;
             cd->eccPointMultiplicationParams.p1Y = p1Y;
             cd->eccPointMultiplicationParams.k = k;
-            cd->currentOp = DRV_BA414E_OP_PRIM_ECC_POINT_MULTIPLICATION;
-            if ((cd->ioIntent & DRV_IO_INTENT_NONBLOCKING) == DRV_IO_INTENT_NONBLOCKING)
-            {
-                cd->callback = callback;
-                cd->context = context;
-#if defined(DRV_BA414E_RTOS_STACK_SIZE)
-                OSAL_SEM_Post(&opData.clientAction);
-#endif
-                ret = DRV_BA414E_OP_PENDING;
-            }
-            else
-            {
-                ret = DRV_BA414_BlockingHelper(cd);
-            }
+            ret = DRV_BA414E_Submit(cd, DRV_BA414E_OP_PRIM_ECC_POINT_MULTIPLICATION, callback, context);
         }
     }   
     return ret;
@@ -1533,20 +1541,7 @@ DRV_BA414E_OP_RESULT DRV_BA414E_PRIM_EccCheckPointOnCurve(
             cd->eccCheckPointOnCurveParams.domain = domain;
             cd->eccCheckPointOnCurveParams.p1X = p1X;
             cd->eccCheckPointOnCurveParams.p1Y = p1Y;
-            cd->currentOp = DRV_BA414E_OP_PRIM_ECC_CHECK_POINT_ON_CURVE;
-            if ((cd->ioIntent & DRV_IO_INTENT_NONBLOCKING) == DRV_IO_INTENT_NONBLOCKING)
-            {
-                cd->callback = callback;
-                cd->context = context;
-#if defined(DRV_BA414E_RTOS_STACK_SIZE)
-                OSAL_SEM_Post(&opData.clientAction);
-#endif
-                ret = DRV_BA414E_OP_PENDING;
-            }
-            else
-            {
-                ret = DRV_BA414_BlockingHelper(cd);
-            }
+            ret = DRV_BA414E_Submit(cd, DRV_BA414E_OP_PRIM_ECC_CHECK_POINT_ON_CURVE, callback, context);
         }
     }   
     return ret;
@@ -1577,20 +1572,7 @@ DRV_BA414E_OP_RESULT DRV_BA414E_PRIM_ModAddition(
             cd->modOperationParams.p = p;
             cd->modOperationParams.a = a;
             cd->modOperationParams.b = b;
-            cd->currentOp = DRV_BA414E_OP_PRIM_MOD_ADDITION;
-            if ((cd->ioIntent & DRV_IO_INTENT_NONBLOCKING) == DRV_IO_INTENT_NONBLOCKING)
-            {
-                cd->callback = callback;
-                cd->context = context;
-#if defined(DRV_BA414E_RTOS_STACK_SIZE)
-                OSAL_SEM_Post(&opData.clientAction);
-#endif
-                ret = DRV_BA414E_OP_PENDING;
-            }
-            else
-            {
-                ret = DRV_BA414_BlockingHelper(cd);
-            }
+            ret = DRV_BA414E_Submit(cd, DRV_BA414E_OP_PRIM_MOD_ADDITION, callback, context);
         }
     }   
     return ret;
@@ -1621,20 +1603,7 @@ DRV_BA414E_OP_RESULT DRV_BA414E_PRIM_ModSubtraction(
             cd->modOperationParams.p = p;
             cd->modOperationParams.a = a;
             cd->modOperationParams.b = b;
-            cd->currentOp = DRV_BA414E_OP_PRIM_MOD_SUBTRACTION;
-            if ((cd->ioIntent & DRV_IO_INTENT_NONBLOCKING) == DRV_IO_INTENT_NONBLOCKING)
-            {
-                cd->callback = callback;
-                cd->context = context;
-#if defined(DRV_BA414E_RTOS_STACK_SIZE)
-                OSAL_SEM_Post(&opData.clientAction);
-#endif
-                ret = DRV_BA414E_OP_PENDING;
-            }
-            else
-            {
-                ret = DRV_BA414_BlockingHelper(cd);
-            }
+            ret = DRV_BA414E_Submit(cd, DRV_BA414E_OP_PRIM_MOD_SUBTRACTION, callback, context);
         }
     }   
     return ret;
@@ -1665,20 +1634,7 @@ DRV_BA414E_OP_RESULT DRV_BA414E_PRIM_ModMultiplication(
             cd->modOperationParams.p = p;
             cd->modOperationParams.a = a;
             cd->modOperationParams.b = b;
-            cd->currentOp = DRV_BA414E_OP_PRIM_MOD_MULTIPLICATION;
-            if ((cd->ioIntent & DRV_IO_INTENT_NONBLOCKING) == DRV_IO_INTENT_NONBLOCKING)
-            {
-                cd->callback = callback;
-                cd->context = context;
-#if defined(DRV_BA414E_RTOS_STACK_SIZE)
-                OSAL_SEM_Post(&opData.clientAction);
-#endif
-                ret = DRV_BA414E_OP_PENDING;
-            }
-            else
-            {
-                ret = DRV_BA414_BlockingHelper(cd);
-            }
+            ret = DRV_BA414E_Submit(cd, DRV_BA414E_OP_PRIM_MOD_MULTIPLICATION, callback, context);
         }
     }   
     return ret;  
@@ -1708,20 +1664,7 @@ DRV_BA414E_OP_RESULT DRV_BA414E_PRIM_ModExponentiation(
             cd->modExpParams.n = n;
             cd->modExpParams.M = M;
             cd->modExpParams.e = e;
-            cd->currentOp = DRV_BA414E_OP_PRIM_MOD_EXP;
-            if ((cd->ioIntent & DRV_IO_INTENT_NONBLOCKING) == DRV_IO_INTENT_NONBLOCKING)
-            {
-                cd->callback = callback;
-                cd->context = context;
-#if defined(DRV_BA414E_RTOS_STACK_SIZE)
-                OSAL_SEM_Post(&opData.clientAction);
-#endif
-                ret = DRV_BA414E_OP_PENDING;
-            }
-            else
-            {
-                ret = DRV_BA414_BlockingHelper(cd);
-            }
+            ret = DRV_BA414E_Submit(cd, DRV_BA414E_OP_PRIM_MOD_EXP, callback, context);
         }
     }   
     return ret;  
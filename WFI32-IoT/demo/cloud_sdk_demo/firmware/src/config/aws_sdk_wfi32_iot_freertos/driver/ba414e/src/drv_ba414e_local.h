@@ -79,6 +79,8 @@ SUBSTITUTE  GOODS,  TECHNOLOGY,  SERVICES,  OR  ANY  CLAIMS  BY  THIRD   PARTIES
 #define DRV_BA414E_ALIGNMENT_MASK          0x3
 // Microcode memory size
 #define DRV_BA414E_MAX_uCODE_SIZE          1432
+// Slots holding the ECC domain parameters, P, N, GX, GY, A and B in that order
+#define BA414E_ECC_DOMAIN_SLOTS            6
         
         
         
@@ -217,7 +219,9 @@ typedef struct
     
     DRV_IO_INTENT ioIntent;
     DRV_BA414E_OPERATIONS currentOp : 8;
+    DRV_BA414E_PRIORITY priority : 8;
     uint8_t inUse;
+    uint32_t seq;           // submission order of currentOp
 }DRV_BA414E_ClientData;
         
 typedef struct 
@@ -234,6 +238,12 @@ typedef struct
     uint8_t doneInterrupt;
     uint8_t errorInterrupt;
     uint32_t lastStatus;
+    uint32_t nextSeq;
+    // curve parameters held in the crypto memory, as given by the client
+    uint8_t scmDomainValid;
+    DRV_BA414E_OPERAND_SIZE scmDomainOpSize : 8;
+    uint16_t scmDomainKeySize;
+    uint8_t scmDomain[BA414E_ECC_DOMAIN_SLOTS][DRV_BA414E_MAX_KEY_SIZE];
 }DRV_BA414E_OperationalData;
         
 
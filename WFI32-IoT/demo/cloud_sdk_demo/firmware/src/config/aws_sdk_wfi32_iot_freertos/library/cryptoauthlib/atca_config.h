@@ -31,6 +31,19 @@
 #define ATCA_POLLING_MAX_TIME_MSEC        2500
 #endif
 
+/** Learn how long each command runs on the device and wait about that long
+   before the first poll, then poll every ATCA_POLLING_ADAPTIVE_STEP_MSEC */
+#if !defined(ATCA_POLLING_ADAPTIVE) && !defined(ATCA_NO_POLL)
+#define ATCA_POLLING_ADAPTIVE
+#endif
+#ifndef ATCA_POLLING_ADAPTIVE_STEP_MSEC
+#define ATCA_POLLING_ADAPTIVE_STEP_MSEC   1
+#endif
+/** Number of distinct commands whose execution time is learned */
+#ifndef ATCA_POLLING_ADAPTIVE_OPCODES
+#define ATCA_POLLING_ADAPTIVE_OPCODES     16
+#endif
+
 /** Define if the library is not to use malloc/free */
 #ifndef ATCA_NO_HEAP
 #define ATCA_NO_HEAP
@@ -193,6 +206,11 @@
 #define atca_delay_ms   hal_rtos_delay_ms
 #define atca_delay_us   hal_delay_us
 
+/** Task notification index the I2C HAL blocks on while a transfer is ongoing */
+#ifndef ATCA_RTOS_NOTIFY_INDEX
+#define ATCA_RTOS_NOTIFY_INDEX  (1)
+#endif
+
 /* \brief How long to wait after an initial wake failure for the POST to
  *         complete.
  * If Power-on self test (POST) is enabled, the self test will run on waking
@@ -208,12 +226,14 @@
 #define PLIB_I2C_ERROR          I2C_ERROR
 #define PLIB_I2C_ERROR_NONE     I2C_ERROR_NONE
 #define PLIB_I2C_TRANSFER_SETUP I2C_TRANSFER_SETUP
+#define PLIB_I2C_CALLBACK       I2C_CALLBACK
 
 typedef bool (* atca_i2c_plib_read)( uint16_t, uint8_t *, size_t );
 typedef bool (* atca_i2c_plib_write)( uint16_t, uint8_t *, size_t );
 typedef bool (* atca_i2c_plib_is_busy)( void );
 typedef PLIB_I2C_ERROR (* atca_i2c_error_get)( void );
 typedef bool (* atca_i2c_plib_transfer_setup)(PLIB_I2C_TRANSFER_SETUP* setup, uint32_t srcClkFreq);
+typedef void (* atca_i2c_plib_callback_register)(PLIB_I2C_CALLBACK callback, uintptr_t context);
 
 typedef struct atca_plib_i2c_api
 {
@@ -222,6 +242,7 @@ typedef struct atca_plib_i2c_api
     atca_i2c_plib_is_busy           is_busy;
     atca_i2c_error_get              error_get;
     atca_i2c_plib_transfer_setup    transfer_setup;
+    atca_i2c_plib_callback_register callback_register;
 } atca_plib_i2c_api_t;
 
 
@@ -105,6 +105,11 @@ ATCA_STATUS initATCADevice(ATCAIfaceCfg *cfg, ATCADevice ca_dev)
         return status;
     }
 
+#ifdef ATCA_POLLING_ADAPTIVE
+    /* What was learned may not hold for the device now configured */
+    memset(ca_dev->exec_times, 0, sizeof(ca_dev->exec_times));
+#endif
+
     return ATCA_SUCCESS;
 }
 
@@ -141,6 +141,16 @@ typedef enum
 } ATCADeviceState;
 
 
+#ifdef ATCA_POLLING_ADAPTIVE
+/** \brief Learned execution time of a command, see calib_execute_command()
+ */
+typedef struct
+{
+    uint8_t  opcode;
+    uint16_t wait;                      /**< Wait before the first poll in 1/8 ms, 0 if unused */
+} atca_exec_time_t;
+#endif
+
 /** \brief atca_device is the C object backing ATCADevice.  See the atca_device.h file for
  * details on the ATCADevice methods
  */
@@ -160,6 +170,10 @@ struct atca_device
 
     uint16_t options;                   /**< Nested command details parameter */
 
+#ifdef ATCA_POLLING_ADAPTIVE
+    atca_exec_time_t exec_times[ATCA_POLLING_ADAPTIVE_OPCODES]; /**< Learned command execution times */
+#endif
+
 };
 
 typedef struct atca_device * ATCADevice;
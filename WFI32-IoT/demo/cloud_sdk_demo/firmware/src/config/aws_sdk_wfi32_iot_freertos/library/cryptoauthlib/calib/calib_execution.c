@@ -449,6 +449,65 @@ ATCA_STATUS calib_execute_receive(ATCADevice device, uint8_t device_address, uin
     return status;
 }
 
+#ifdef ATCA_POLLING_ADAPTIVE
+/** \brief Finds what was learned of a command, taking a free entry for a
+ *         command not seen yet.
+ *  \param[in] device  Device the command runs on
+ *  \param[in] opcode  Opcode value of the command
+ *  \return the entry of the command, NULL if there is none left for it
+ */
+static atca_exec_time_t* calib_exec_time_find(ATCADevice device, uint8_t opcode)
+{
+    atca_exec_time_t* free_entry = NULL;
+    int i;
+
+    for (i = 0; i < ATCA_POLLING_ADAPTIVE_OPCODES; i++)
+    {
+        if (0 == device->exec_times[i].wait)
+        {
+            if (NULL == free_entry)
+            {
+                free_entry = &device->exec_times[i];
+            }
+        }
+        else if (opcode == device->exec_times[i].opcode)
+        {
+            return &device->exec_times[i];
+        }
+    }
+
+    if (NULL != free_entry)
+    {
+        free_entry->opcode = opcode;
+    }
+
+    return free_entry;
+}
+
+/** \brief Learns from how long a command was waited for. A command that was
+ *         ready at the first poll may have been ready earlier, so the wait is
+ *         shortened a little; one that was not is waited for as long as it
+ *         took next time.
+ *  \param[in] exec_time  Entry of the command
+ *  \param[in] waited     Milliseconds waited until the response was read
+ *  \param[in] polls      Number of polls the device did not answer
+ */
+static void calib_exec_time_learn(atca_exec_time_t* exec_time, uint32_t waited, uint32_t polls)
+{
+    if ((0 == polls) && (0 != exec_time->wait))
+    {
+        if (exec_time->wait > (ATCA_POLLING_INIT_TIME_MSEC << 3))
+        {
+            exec_time->wait--;
+        }
+    }
+    else
+    {
+        exec_time->wait = (uint16_t)(waited << 3);
+    }
+}
+#endif
+
 /** \brief Wakes up device, sends the packet, waits for command completion,
  *         receives response, and puts the device into the idle state.
  *
@@ -467,6 +526,12 @@ ATCA_STATUS calib_execute_command(ATCAPacket* packet, ATCADevice device)
     uint16_t rxsize;
     uint8_t device_address = atcab_get_device_address(device);
     int retries = 1;
+#ifdef ATCA_POLLING_ADAPTIVE
+    atca_exec_time_t* exec_time;
+    uint32_t polling_time;
+    uint32_t waited;
+    uint32_t polls = 0;
+#endif
 
     do
     {
@@ -481,6 +546,24 @@ ATCA_STATUS calib_execute_command(ATCAPacket* packet, ATCADevice device)
         execution_or_wait_time = ATCA_POLLING_INIT_TIME_MSEC;
         max_delay_count = ATCA_POLLING_MAX_TIME_MSEC / ATCA_POLLING_FREQUENCY_TIME_MSEC;
 
+    #ifdef ATCA_POLLING_ADAPTIVE
+        // Wait about as long as the command took before, then poll closely
+        polling_time = ATCA_POLLING_FREQUENCY_TIME_MSEC;
+        exec_time = calib_exec_time_find(device, packet->opcode);
+        if ((NULL != exec_time) && (0 != exec_time->wait))
+        {
+            execution_or_wait_time = exec_time->wait >> 3;
+            polling_time = ATCA_POLLING_ADAPTIVE_STEP_MSEC;
+            // Give up after no more polls than without what was learned
+            max_delay_count = 0;
+            if (execution_or_wait_time < ATCA_POLLING_MAX_TIME_MSEC)
+            {
+                max_delay_count = (ATCA_POLLING_MAX_TIME_MSEC - execution_or_wait_time) / ATCA_POLLING_FREQUENCY_TIME_MSEC;
+            }
+        }
+        waited = execution_or_wait_time;
+    #endif
+
     #if ATCA_CA2_SUPPORT
         if ((ATCA_SWI_GPIO_IFACE == device->mIface.mIfaceCFG->iface_type) && (atcab_is_ca2_device(device->mIface.mIfaceCFG->devtype)))
         {
@@ -554,7 +637,11 @@ ATCA_STATUS calib_execute_command(ATCAPacket* packet, ATCADevice device)
                 break;
             }
 
-#ifndef ATCA_NO_POLL
+#ifdef ATCA_POLLING_ADAPTIVE
+            atca_delay_ms(polling_time);
+            waited += polling_time;
+            polls++;
+#elif !defined(ATCA_NO_POLL)
             // delay for polling frequency time
             atca_delay_ms(ATCA_POLLING_FREQUENCY_TIME_MSEC);
 #endif
@@ -566,6 +653,13 @@ ATCA_STATUS calib_execute_command(ATCAPacket* packet, ATCADevice device)
             break;
         }
 
+#ifdef ATCA_POLLING_ADAPTIVE
+        if (NULL != exec_time)
+        {
+            calib_exec_time_learn(exec_time, waited, polls);
+        }
+#endif
+
         // Check response size
         if (rxsize < 4)
         {
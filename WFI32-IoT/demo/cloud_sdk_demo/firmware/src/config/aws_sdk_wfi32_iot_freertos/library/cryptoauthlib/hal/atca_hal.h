@@ -205,6 +205,11 @@ ATCA_STATUS hal_destroy_mutex(void * pMutex);
 ATCA_STATUS hal_lock_mutex(void * pMutex);
 ATCA_STATUS hal_unlock_mutex(void * pMutex);
 
+/** \brief Task notification API, lets a HAL sleep until an interrupt ends */
+void* hal_rtos_notify_prepare(void);
+ATCA_STATUS hal_rtos_notify_wait(uint32_t ms);
+void hal_rtos_notify_from_isr(void* task);
+
 #if !defined(ATCA_NO_HEAP) && defined(ATCA_TESTS_ENABLED)
 void hal_test_set_memory_f(void* (*malloc_func)(size_t), void (*free_func)(void*));
 #endif
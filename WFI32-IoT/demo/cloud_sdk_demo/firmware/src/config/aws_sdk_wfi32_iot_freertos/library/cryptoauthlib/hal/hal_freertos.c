@@ -154,5 +154,56 @@ ATCA_STATUS hal_unlock_mutex(void * pMutex)
     }
 }
 
+/**
+ * \brief Readies the calling task to be woken by hal_rtos_notify_from_isr(),
+ *        dropping a notification a timed out wait may have left behind.
+ *        Call it before starting the operation the interrupt will signal.
+ *
+ * \return The task to pass to hal_rtos_notify_from_isr(), NULL if the
+ *         scheduler is not running and the caller has to poll instead.
+ */
+void* hal_rtos_notify_prepare(void)
+{
+#if INCLUDE_xTaskGetSchedulerState
+    if (taskSCHEDULER_RUNNING != xTaskGetSchedulerState())
+    {
+        return NULL;
+    }
+#endif
+
+    (void)ulTaskNotifyTakeIndexed(ATCA_RTOS_NOTIFY_INDEX, pdTRUE, 0);
+
+    return xTaskGetCurrentTaskHandle();
+}
+
+/**
+ * \brief Blocks the calling task until it is notified or the delay expires
+ *
+ * \param[in] delay  Number of milliseconds to wait at most
+ *
+ * \return ATCA_SUCCESS if notified, otherwise ATCA_TIMEOUT.
+ */
+ATCA_STATUS hal_rtos_notify_wait(uint32_t delay)
+{
+    if (0 == ulTaskNotifyTakeIndexed(ATCA_RTOS_NOTIFY_INDEX, pdTRUE, pdMS_TO_TICKS(delay) + 1))
+    {
+        return ATCA_TIMEOUT;
+    }
+
+    return ATCA_SUCCESS;
+}
+
+/**
+ * \brief Wakes a task blocked in hal_rtos_notify_wait(), from an interrupt
+ *
+ * \param[in] task  Task returned by hal_rtos_notify_prepare()
+ */
+void hal_rtos_notify_from_isr(void* task)
+{
+    BaseType_t taskWoken = pdFALSE;
+
+    vTaskNotifyGiveIndexedFromISR((TaskHandle_t)task, ATCA_RTOS_NOTIFY_INDEX, &taskWoken);
+    portEND_SWITCHING_ISR(taskWoken);
+}
 
 /** @} */
@@ -37,7 +37,8 @@ atca_plib_i2c_api_t i2c2_plib_i2c_api = {
     .write = I2C2_Write,
     .is_busy = I2C2_IsBusy,
     .error_get = I2C2_ErrorGet,
-    .transfer_setup = I2C2_TransferSetup
+    .transfer_setup = I2C2_TransferSetup,
+    .callback_register = I2C2_CallbackRegister
 };
 
 
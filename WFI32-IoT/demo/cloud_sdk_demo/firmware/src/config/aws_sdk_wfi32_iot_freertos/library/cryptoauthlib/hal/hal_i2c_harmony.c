@@ -75,7 +75,34 @@ ATCA_STATUS hal_i2c_discover_devices(int bus_num, ATCAIfaceCfg cfg[], int *found
     return ATCA_UNIMPLEMENTED;
 }
 
-static ATCA_STATUS hal_i2c_wait(atca_plib_i2c_api_t* plib, uint32_t rate, uint16_t length)
+/* A bus, and the task blocked on its current transfer. The plib calls
+   hal_i2c_transfer_done() from its interrupt when a transfer ends, so the
+   task sleeps through the transfer instead of polling for its end */
+typedef struct
+{
+    atca_plib_i2c_api_t* plib;
+    void* volatile       waiter;
+} hal_i2c_harmony_bus_t;
+
+#ifndef HAL_I2C_HARMONY_MAX_BUSES
+#define HAL_I2C_HARMONY_MAX_BUSES   2
+#endif
+
+static hal_i2c_harmony_bus_t hal_i2c_buses[HAL_I2C_HARMONY_MAX_BUSES];
+
+static void hal_i2c_transfer_done(uintptr_t context)
+{
+    hal_i2c_harmony_bus_t* bus = (hal_i2c_harmony_bus_t*)context;
+    void* waiter = bus->waiter;
+
+    if (NULL != waiter)
+    {
+        bus->waiter = NULL;
+        hal_rtos_notify_from_isr(waiter);
+    }
+}
+
+static ATCA_STATUS hal_i2c_wait(hal_i2c_harmony_bus_t* bus, uint32_t rate, uint16_t length)
 {
     ATCA_STATUS status = ATCA_SUCCESS;
 
@@ -89,12 +116,20 @@ static ATCA_STATUS hal_i2c_wait(atca_plib_i2c_api_t* plib, uint32_t rate, uint16
     timeout /= rate;
     timeout += 1;   /* Make sure the timeout value is non zero */
 
-    while ((true == plib->is_busy()) && (timeout--))
+    /* Sleep until the plib reports the end of the transfer, then only make
+       sure the bus is released */
+    if (NULL != bus->waiter)
+    {
+        (void)hal_rtos_notify_wait(timeout / 1000 + 1);
+        bus->waiter = NULL;
+    }
+
+    while ((true == bus->plib->is_busy()) && (timeout--))
     {
         atca_delay_us(1);
     }
 
-    if (0 == timeout)
+    if (true == bus->plib->is_busy())
     {
         status = ATCA_COMM_FAIL;
     }
@@ -102,6 +137,49 @@ static ATCA_STATUS hal_i2c_wait(atca_plib_i2c_api_t* plib, uint32_t rate, uint16
     return status;
 }
 
+/* Runs a read or a write to the end and checks how it went */
+static ATCA_STATUS hal_i2c_transfer(hal_i2c_harmony_bus_t* bus, uint32_t rate, bool read, uint8_t address, uint8_t* data, uint16_t length)
+{
+    ATCA_STATUS status = ATCA_COMM_FAIL;
+    bool started;
+
+    /* Get ready for the notification before it can possibly come */
+    if (NULL != bus->plib->callback_register)
+    {
+        bus->waiter = hal_rtos_notify_prepare();
+    }
+
+    if (read)
+    {
+        started = bus->plib->read(address >> 1, data, length);
+    }
+    else
+    {
+        started = bus->plib->write(address >> 1, data, length);
+    }
+
+    if (true == started)
+    {
+        /* Wait for the I2C transfer to complete */
+        status = hal_i2c_wait(bus, rate, length);
+
+        if (ATCA_SUCCESS == status)
+        {
+            /* Transfer complete. Check if the transfer was successful */
+            if (bus->plib->error_get() != PLIB_I2C_ERROR_NONE)
+            {
+                status = ATCA_COMM_FAIL;
+            }
+        }
+    }
+    else
+    {
+        bus->waiter = NULL;
+    }
+
+    return status;
+}
+
 
 /** \brief
     - this HAL implementation assumes you've included the START Twi libraries in your project, otherwise,
@@ -122,6 +200,46 @@ static ATCA_STATUS hal_i2c_wait(atca_plib_i2c_api_t* plib, uint32_t rate, uint16
 
 ATCA_STATUS hal_i2c_init(ATCAIface iface, ATCAIfaceCfg *cfg)
 {
+    atca_plib_i2c_api_t * plib;
+    hal_i2c_harmony_bus_t* bus = NULL;
+    int i;
+
+    if ((NULL == iface) || (NULL == cfg))
+    {
+        return ATCA_BAD_PARAM;
+    }
+
+    if (NULL == (plib = (atca_plib_i2c_api_t*)cfg->cfg_data))
+    {
+        return ATCA_BAD_PARAM;
+    }
+
+    /* Devices on the same bus share it */
+    for (i = 0; i < HAL_I2C_HARMONY_MAX_BUSES; i++)
+    {
+        if ((plib == hal_i2c_buses[i].plib) || (NULL == hal_i2c_buses[i].plib))
+        {
+            bus = &hal_i2c_buses[i];
+            break;
+        }
+    }
+
+    if (NULL == bus)
+    {
+        return ATCA_TRACE(ATCA_ALLOC_FAILURE, "too many i2c buses");
+    }
+
+    if (NULL == bus->plib)
+    {
+        bus->plib = plib;
+        if (NULL != plib->callback_register)
+        {
+            plib->callback_register(hal_i2c_transfer_done, (uintptr_t)bus);
+        }
+    }
+
+    iface->hal_data = bus;
+
     return ATCA_SUCCESS;
 }
 
@@ -145,39 +263,22 @@ ATCA_STATUS hal_i2c_post_init(ATCAIface iface)
 ATCA_STATUS hal_i2c_send(ATCAIface iface, uint8_t address, uint8_t *txdata, int txlength)
 {
     ATCAIfaceCfg* cfg = atgetifacecfg(iface);
-    atca_plib_i2c_api_t * plib;
+    hal_i2c_harmony_bus_t* bus = (hal_i2c_harmony_bus_t*)atgetifacehaldat(iface);
     ATCA_STATUS status = ATCA_COMM_FAIL;
 
-    if (!cfg)
-    {
-        return ATCA_BAD_PARAM;
-    }
-
-    plib = (atca_plib_i2c_api_t*)cfg->cfg_data;
-    if (!plib)
+    if (!cfg || !bus)
     {
         return ATCA_BAD_PARAM;
     }
 
     /* Wait for the I2C bus to be ready */
-    status = hal_i2c_wait(plib, cfg->atcai2c.baud, 30);
+    status = hal_i2c_wait(bus, cfg->atcai2c.baud, 30);
 
     if (ATCA_SUCCESS == status)
     {
-        status = ATCA_COMM_FAIL;
-        if (plib->write(address >> 1, txdata, txlength) == true)
+        if (ATCA_SUCCESS != (status = hal_i2c_transfer(bus, cfg->atcai2c.baud, false, address, txdata, (uint16_t)txlength)))
         {
-            /* Wait for the I2C transfer to complete */
-            status = hal_i2c_wait(plib, cfg->atcai2c.baud, txlength);
-
-            if (ATCA_SUCCESS == status)
-            {
-                /* Transfer complete. Check if the transfer was successful */
-                if (plib->error_get() != PLIB_I2C_ERROR_NONE)
-                {
-                    status = ATCA_TRACE(ATCA_COMM_FAIL, "plib->write failed");
-                }
-            }
+            status = ATCA_TRACE(status, "plib->write failed");
         }
     }
 
@@ -196,32 +297,20 @@ ATCA_STATUS hal_i2c_receive(ATCAIface iface, uint8_t address, uint8_t *rxdata, u
 {
     ATCA_STATUS status = ATCA_COMM_FAIL;
     ATCAIfaceCfg* cfg = atgetifacecfg(iface);
-    atca_plib_i2c_api_t * plib;
+    hal_i2c_harmony_bus_t* bus = (hal_i2c_harmony_bus_t*)atgetifacehaldat(iface);
 
     if ((NULL == cfg) || (NULL == rxlength) || (NULL == rxdata))
     {
         return ATCA_TRACE(ATCA_BAD_PARAM, "NULL pointer encountered");
     }
 
-    if (NULL == (plib = (atca_plib_i2c_api_t*)cfg->cfg_data))
+    if (NULL == bus)
     {
         return ATCA_TRACE(ATCA_BAD_PARAM, "NULL pointer encountered");
     }
 
     /* Read given length bytes from device */
-    status = ATCA_COMM_FAIL;
-    if (plib->read(address >> 1, rxdata, *rxlength) == true)
-    {
-        /* Wait for the I2C transfer to complete */
-        if (ATCA_SUCCESS == (status = hal_i2c_wait(plib, cfg->atcai2c.baud, *rxlength)))
-        {
-            /* Transfer complete. Check if the transfer was successful */
-            if (plib->error_get() != PLIB_I2C_ERROR_NONE)
-            {
-                status = ATCA_COMM_FAIL;
-            }
-        }
-    }
+    status = hal_i2c_transfer(bus, cfg->atcai2c.baud, true, address, rxdata, *rxlength);
     if (ATCA_SUCCESS != status)
     {
         status = ATCA_TRACE(status, "plib->read - failed");
@@ -237,16 +326,10 @@ ATCA_STATUS hal_i2c_receive(ATCAIface iface, uint8_t address, uint8_t *rxdata, u
 ATCA_STATUS change_i2c_speed(ATCAIface iface, uint32_t speed)
 {
     ATCAIfaceCfg* cfg = atgetifacecfg(iface);
-    atca_plib_i2c_api_t * plib;
+    hal_i2c_harmony_bus_t* bus = (hal_i2c_harmony_bus_t*)atgetifacehaldat(iface);
     ATCA_STATUS status = ATCA_COMM_FAIL;
 
-    if (!cfg)
-    {
-        return ATCA_BAD_PARAM;
-    }
-
-    plib = (atca_plib_i2c_api_t*)cfg->cfg_data;
-    if (!plib)
+    if (!cfg || !bus)
     {
         return ATCA_BAD_PARAM;
     }
@@ -255,11 +338,11 @@ ATCA_STATUS change_i2c_speed(ATCAIface iface, uint32_t speed)
     setup.clkSpeed = speed;
 
     /* Make sure I2C is not busy before changing the I2C clock speed */
-    status = hal_i2c_wait(plib, cfg->atcai2c.baud, 30);
+    status = hal_i2c_wait(bus, cfg->atcai2c.baud, 30);
 
     if (ATCA_SUCCESS == status)
     {
-        (void)plib->transfer_setup(&setup, 0);
+        (void)bus->plib->transfer_setup(&setup, 0);
     }
 
     return status;
@@ -132,6 +132,10 @@ static const void* tcpPktHandlerParam;
 
 static uint32_t             sysTickFreq;            // the system tick counter frequency; frequently used 
 
+#if (TCPIP_TCP_RX_AUTO_TUNE != 0)
+static uint32_t             tcpRxAutoTime;          // time of the next RX buffer tuning
+#endif  // (TCPIP_TCP_RX_AUTO_TUNE != 0)
+
 /****************************************************************************
   Section:
     Function Prototypes
@@ -247,6 +251,16 @@ static bool         _TCPNeedSend(TCB_STUB* pSkt);
 
 static void         _TCPSetHalfFlushFlag(TCB_STUB* pSkt);
 
+#if (TCPIP_TCP_RX_AUTO_TUNE != 0)
+static uint32_t     _TcpRxAutoBudgetUsed(void);
+
+static uint16_t     _TcpRxAutoOpenSize(void);
+
+static void         _TcpRxAutoTune(void);
+
+static bool         _TcpRxAutoResize(TCB_STUB* pSkt, uint16_t rxSize);
+#endif  // (TCPIP_TCP_RX_AUTO_TUNE != 0)
+
 static bool         _TCPSetSourceAddress(TCB_STUB* pSkt, IP_ADDRESS_TYPE addType, IP_MULTI_ADDRESS* localAddress)
 {
     if(localAddress == 0)
@@ -1100,6 +1114,7 @@ static TCP_SOCKET _TCP_Open(IP_ADDRESS_TYPE addType, TCP_OPEN_TYPE opType, TCP_P
     TCP_SOCKET hTCP;
     TCP_PORT   localPort, remotePort;     
     uint8_t    *txBuff, *rxBuff;
+    uint16_t   rxSize;
 
     if(opType == TCP_OPEN_CLIENT)
     {
@@ -1148,9 +1163,15 @@ static TCP_SOCKET _TCP_Open(IP_ADDRESS_TYPE addType, TCP_OPEN_TYPE opType, TCP_P
         return INVALID_SOCKET;
     }
 
+#if (TCPIP_TCP_RX_AUTO_TUNE != 0)
+    rxSize = _TcpRxAutoOpenSize();
+#else
+    rxSize = tcpDefRxSize;
+#endif  // (TCPIP_TCP_RX_AUTO_TUNE != 0)
+
     pSkt = (TCB_STUB*)TCPIP_HEAP_Calloc(tcpHeapH, 1, sizeof(*pSkt));
     txBuff = (uint8_t*)TCPIP_HEAP_Malloc(tcpHeapH, tcpDefTxSize + 1);
-    rxBuff = (uint8_t*)TCPIP_HEAP_Malloc(tcpHeapH, tcpDefRxSize + 1);
+    rxBuff = (uint8_t*)TCPIP_HEAP_Malloc(tcpHeapH, rxSize + 1);
 
     if(pSkt == 0 || txBuff == 0 || rxBuff == 0)
     {   // out of memory
@@ -1165,7 +1186,7 @@ static TCP_SOCKET _TCP_Open(IP_ADDRESS_TYPE addType, TCP_OPEN_TYPE opType, TCP_P
         return INVALID_SOCKET;
     }
 
-    _TcpSocketInitialize(pSkt, hTCP, txBuff, tcpDefTxSize, rxBuff, tcpDefRxSize);
+    _TcpSocketInitialize(pSkt, hTCP, txBuff, tcpDefTxSize, rxBuff, rxSize);
     // Shared Data Lock
     if (OSAL_SEM_Post(&tcpSemaphore) != OSAL_RESULT_TRUE)
     {
@@ -3760,8 +3781,203 @@ static void TCPIP_TCP_Tick(void)
         }
     }
 
+#if (TCPIP_TCP_RX_AUTO_TUNE != 0)
+    _TcpRxAutoTune();
+#endif  // (TCPIP_TCP_RX_AUTO_TUNE != 0)
+}
+
+#if (TCPIP_TCP_RX_AUTO_TUNE != 0)
+// RX memory the sockets hold or are about to switch to
+static uint32_t _TcpRxAutoBudgetUsed(void)
+{
+    TCP_SOCKET hTCP;
+    TCB_STUB*  pSkt;
+    uint16_t   rxSize;
+    uint32_t   budgetUsed = 0;
+
+    for(hTCP = 0; hTCP < TcpSockets; hTCP++)
+    {
+        pSkt = TCBStubs[hTCP];
+        if(pSkt)
+        {
+            rxSize = pSkt->rxEnd - pSkt->rxStart;
+            budgetUsed += pSkt->rxAutoTarget > rxSize ? pSkt->rxAutoTarget : rxSize;
+        }
+    }
+
+    return budgetUsed;
+}
+
+// RX buffer size for a new socket:
+// the default size, as much as TCPIP_TCP_RX_AUTO_BUDGET allows
+static uint16_t _TcpRxAutoOpenSize(void)
+{
+    uint32_t budgetUsed = _TcpRxAutoBudgetUsed();
+    uint32_t budgetAvlbl = budgetUsed < TCPIP_TCP_RX_AUTO_BUDGET ? TCPIP_TCP_RX_AUTO_BUDGET - budgetUsed : 0;
+
+    if(budgetAvlbl >= tcpDefRxSize)
+    {
+        return tcpDefRxSize;
+    }
+
+    return budgetAvlbl > TCPIP_TCP_RX_AUTO_MIN_SIZE ? (uint16_t)budgetAvlbl : TCPIP_TCP_RX_AUTO_MIN_SIZE;
+}
+
+// a window once advertised to the peer must not be taken back (RFC 1122 4.2.2.16):
+// only sockets that have no peer or whose peer can no longer send are shrunk
+static bool _TcpRxAutoCanShrink(TCB_STUB* pSkt)
+{
+    switch(pSkt->smState)
+    {
+        case TCPIP_TCP_STATE_LISTEN:
+        case TCPIP_TCP_STATE_CLOSING:
+        case TCPIP_TCP_STATE_TIME_WAIT:
+        case TCPIP_TCP_STATE_CLOSE_WAIT:
+        case TCPIP_TCP_STATE_LAST_ACK:
+        case TCPIP_TCP_STATE_CLIENT_WAIT_DISCONNECT:
+        case TCPIP_TCP_STATE_CLIENT_WAIT_CONNECT:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+// RX buffer tuning, called from the TCP tick
+// every TCPIP_TCP_RX_AUTO_INTERVAL:
+//  - an established socket that received at least its buffer size in the interval
+//    gets a buffer twice as large, up to its rxAutoMax and to what is left of TCPIP_TCP_RX_AUTO_BUDGET
+//  - a socket that received nothing for TCPIP_TCP_RX_AUTO_IDLE_TMO goes back to TCPIP_TCP_RX_AUTO_MIN_SIZE
+//  - if the budget cut a growing socket short, the sockets that received nothing
+//    in the interval go back to TCPIP_TCP_RX_AUTO_MIN_SIZE without waiting for the idle timeout
+// Only the sockets _TcpRxAutoCanShrink() allows are shrunk.
+// A socket with rxAutoMax == 0 got its size from TCP_OPTION_RX_BUFF and is left alone.
+// The new buffer is put in place only when the RX FIFO is empty,
+// so no data needs to be moved and the user never reads from a buffer that is replaced.
+static void _TcpRxAutoTune(void)
+{
+    TCP_SOCKET hTCP;
+    TCB_STUB*  pSkt;
+    uint16_t   rxSize, reserved;
+    uint32_t   newSize, budgetUsed, budgetAvlbl;
+    bool       budgetShort;
+    uint32_t   currTick = SYS_TMR_TickCountGet();
+
+    if((int32_t)(currTick - tcpRxAutoTime) >= 0)
+    {   // new tuning interval
+        tcpRxAutoTime = currTick + (TCPIP_TCP_RX_AUTO_INTERVAL * sysTickFreq) / 1000;
+        budgetUsed = _TcpRxAutoBudgetUsed();
+        budgetShort = false;
+
+        for(hTCP = 0; hTCP < TcpSockets; hTCP++)
+        {
+            pSkt = TCBStubs[hTCP];
+            if(pSkt == 0 || pSkt->rxAutoMax == 0)
+            {
+                continue;
+            }
+
+            rxSize = pSkt->rxEnd - pSkt->rxStart;
+            newSize = 0;
+            if(pSkt->smState == TCPIP_TCP_STATE_ESTABLISHED && pSkt->rxAutoBytes >= rxSize && rxSize < pSkt->rxAutoMax)
+            {   // the window limited this socket; grow it
+                newSize = 2 * (uint32_t)rxSize;
+                if(newSize > pSkt->rxAutoMax)
+                {
+                    newSize = pSkt->rxAutoMax;
+                }
+                reserved = pSkt->rxAutoTarget > rxSize ? pSkt->rxAutoTarget : rxSize;
+                budgetAvlbl = budgetUsed - reserved < TCPIP_TCP_RX_AUTO_BUDGET ? TCPIP_TCP_RX_AUTO_BUDGET - (budgetUsed - reserved) : 0;
+                if(newSize > budgetAvlbl)
+                {
+                    newSize = budgetAvlbl;
+                    budgetShort = true;
+                }
+
+                if(newSize < rxSize + TCP_MIN_BUFF_CHANGE)
+                {   // not worth it
+                    newSize = 0;
+                }
+                else
+                {
+                    budgetUsed += newSize - reserved;
+                }
+            }
+            else if(pSkt->rxAutoBytes == 0 && rxSize > TCPIP_TCP_RX_AUTO_MIN_SIZE && _TcpRxAutoCanShrink(pSkt))
+            {
+                if((currTick - pSkt->rxAutoTime) >= (TCPIP_TCP_RX_AUTO_IDLE_TMO * sysTickFreq) / 1000)
+                {   // idle; give the memory back
+                    newSize = TCPIP_TCP_RX_AUTO_MIN_SIZE;
+                }
+            }
+
+            pSkt->rxAutoTarget = (uint16_t)newSize;
+        }
+
+        for(hTCP = 0; hTCP < TcpSockets; hTCP++)
+        {
+            pSkt = TCBStubs[hTCP];
+            if(pSkt == 0)
+            {
+                continue;
+            }
+
+            if(budgetShort && pSkt->rxAutoBytes == 0 && pSkt->rxAutoTarget == 0 && pSkt->rxAutoMax != 0
+                    && pSkt->rxEnd - pSkt->rxStart > TCPIP_TCP_RX_AUTO_MIN_SIZE && _TcpRxAutoCanShrink(pSkt))
+            {   // reclaim the memory of the quiet sockets
+                pSkt->rxAutoTarget = TCPIP_TCP_RX_AUTO_MIN_SIZE;
+            }
+            pSkt->rxAutoBytes = 0;
+        }
+    }
+
+    for(hTCP = 0; hTCP < TcpSockets; hTCP++)
+    {
+        pSkt = TCBStubs[hTCP];
+        if(pSkt != 0 && pSkt->rxAutoTarget != 0)
+        {
+            if(pSkt->rxHead == pSkt->rxTail && pSkt->sHoleSize == -1)
+            {   // RX FIFO empty and no out of order data
+                _TcpRxAutoResize(pSkt, pSkt->rxAutoTarget);
+                pSkt->rxAutoTarget = 0;
+            }
+        }
+    }
 }
 
+// replaces the empty RX buffer of a socket with one of rxSize bytes
+// advertises the larger window if the buffer grew
+// on allocation failure the old buffer is kept
+static bool _TcpRxAutoResize(TCB_STUB* pSkt, uint16_t rxSize)
+{
+    uint8_t* oldRxBuff = pSkt->rxStart;
+    uint16_t oldRxSize = pSkt->rxEnd - pSkt->rxStart;
+    uint8_t* newRxBuff = (uint8_t*)TCPIP_HEAP_Malloc(tcpHeapH, rxSize + 1);
+
+    if(newRxBuff == 0)
+    {
+        return false;
+    }
+
+    // the user thread checks rxHead against rxTail
+    OSAL_CRITSECT_DATA_TYPE status = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+    pSkt->rxStart = newRxBuff;
+    pSkt->rxEnd = newRxBuff + rxSize;
+    pSkt->rxHead = newRxBuff;
+    pSkt->rxTail = newRxBuff;
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, status);
+
+    TCPIP_HEAP_Free(tcpHeapH, oldRxBuff);
+
+    if(rxSize > oldRxSize && pSkt->smState == TCPIP_TCP_STATE_ESTABLISHED)
+    {   // let the remote node know about the larger window
+        _TcpSend(pSkt, ACK, SENDTCP_RESET_TIMERS);
+    }
+
+    return true;
+}
+#endif  // (TCPIP_TCP_RX_AUTO_TUNE != 0)
+
 
 #if defined (TCPIP_STACK_USE_IPV6)
 static TCPIP_MAC_PKT_ACK_RES TCPIP_TCP_ProcessIPv6(TCPIP_MAC_PACKET* pRxPkt)
@@ -4527,6 +4743,10 @@ static void _TcpSocketInitialize(TCB_STUB* pSkt, TCP_SOCKET hTCP, uint8_t* txBuf
     // option is received from remote node)
     pSkt->wRemoteMSS = TCP_MIN_DEFAULT_MTU;
 
+#if (TCPIP_TCP_RX_AUTO_TUNE != 0)
+    pSkt->rxAutoMax = TCPIP_TCP_RX_AUTO_MAX_SIZE;
+#endif  // (TCPIP_TCP_RX_AUTO_TUNE != 0)
+
     TCBStubs[hTCP] = pSkt;  // store it
     
 }
@@ -4563,6 +4783,11 @@ static void _TcpSocketSetIdleState(TCB_STUB* pSkt)
     pSkt->remoteWindow = 1;
     pSkt->maxRemoteWindow = 1;
 
+#if (TCPIP_TCP_RX_AUTO_TUNE != 0)
+    pSkt->rxAutoBytes = 0;
+    pSkt->rxAutoTarget = 0;
+    pSkt->rxAutoTime = SYS_TMR_TickCountGet();
+#endif  // (TCPIP_TCP_RX_AUTO_TUNE != 0)
 
     // Note : no result of the explicit binding is maintained!
     pSkt->remotePort = 0;
@@ -5395,6 +5620,10 @@ static void _TcpHandleSeg(TCB_STUB* pSkt, TCP_HEADER* h, uint16_t tcpLen, TCPIP_
             {   // successfully copied data
                 pSkt->RemoteSEQ += (uint32_t)len;
                 pSkt->rxHead = newRxHead;
+#if (TCPIP_TCP_RX_AUTO_TUNE != 0)
+                pSkt->rxAutoBytes += len;
+                pSkt->rxAutoTime = SYS_TMR_TickCountGet();
+#endif  // (TCPIP_TCP_RX_AUTO_TUNE != 0)
 
                 // we have some new data in the socket
                 if(pSkt->smState == TCPIP_TCP_STATE_ESTABLISHED || pSkt->smState == TCPIP_TCP_STATE_FIN_WAIT_1 || pSkt->smState == TCPIP_TCP_STATE_FIN_WAIT_2)
@@ -6319,8 +6548,24 @@ bool TCPIP_TCP_OptionsSet(TCP_SOCKET hTCP, TCP_SOCKET_OPTION option, void* optPa
                 {
                    return false;
                 } 
+#if (TCPIP_TCP_RX_AUTO_TUNE != 0)
+                // an explicit size takes the socket out of the tuning
+                pSkt->rxAutoMax = 0;
+                pSkt->rxAutoTarget = 0;
+#endif  // (TCPIP_TCP_RX_AUTO_TUNE != 0)
                 return TCPIP_TCP_FifoSizeAdjust(hTCP, (uint16_t)((unsigned int)optParam), 0, TCP_ADJUST_RX_ONLY | TCP_ADJUST_PRESERVE_RX);
 
+#if (TCPIP_TCP_RX_AUTO_TUNE != 0)
+            case TCP_OPTION_RX_BUFF_MAX:
+                if((size_t)optParam > TCP_MAX_RX_BUFF_SIZE)
+                {
+                   return false;
+                } 
+                pSkt->rxAutoMax = (size_t)optParam < TCP_MIN_RX_BUFF_SIZE ? TCP_MIN_RX_BUFF_SIZE : (uint16_t)((unsigned int)optParam);
+                pSkt->rxAutoTarget = 0;
+                return true;
+#endif  // (TCPIP_TCP_RX_AUTO_TUNE != 0)
+
             case TCP_OPTION_TX_BUFF:
                 if((size_t)optParam > TCP_MAX_TX_BUFF_SIZE)
                 {
@@ -6386,6 +6631,12 @@ bool TCPIP_TCP_OptionsGet(TCP_SOCKET hTCP, TCP_SOCKET_OPTION option, void* optPa
                 *(uint16_t*)optParam = pSkt->rxEnd - pSkt->rxStart;
                 return true;
 
+#if (TCPIP_TCP_RX_AUTO_TUNE != 0)
+            case TCP_OPTION_RX_BUFF_MAX:
+                *(uint16_t*)optParam = pSkt->rxAutoMax;
+                return true;
+#endif  // (TCPIP_TCP_RX_AUTO_TUNE != 0)
+
             case TCP_OPTION_TX_BUFF:
                 *(uint16_t*)optParam = pSkt->txEnd - pSkt->txStart + 1;
                 return true;
@@ -227,6 +227,12 @@ typedef struct
     TCPIP_TCP_SIGNAL_FUNCTION sigHandler;           // socket signal handler
     const void*         sigParam;                   // socket signal parameter
     uint8_t             keepAliveLim;               // current limit
+#if (TCPIP_TCP_RX_AUTO_TUNE != 0)
+    uint32_t            rxAutoBytes;                // bytes received in the current tuning interval
+    uint32_t            rxAutoTime;                 // when data was last received; the idle reference
+    uint16_t            rxAutoMax;                  // largest RX buffer the tuning gives this socket
+    uint16_t            rxAutoTarget;               // RX buffer size to switch to when the RX FIFO is empty; 0 if none
+#endif  // (TCPIP_TCP_RX_AUTO_TUNE != 0)
     uint8_t ttl;                                    // socket TTL value
     uint8_t tos;                                    // socket TOS value
     union
@@ -292,6 +292,10 @@ static const char* _CommandPktLogModuleNames[] =
 static void _Command_PktInfo(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv);
 #endif  // defined(TCPIP_PACKET_ALLOCATION_TRACE_ENABLE)
 
+#if (_TCPIP_PKT_POOL_ENABLE != 0)
+static void _Command_PktPool(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv);
+#endif  // (_TCPIP_PKT_POOL_ENABLE != 0)
+
 #if defined(TCPIP_STACK_USE_INTERNAL_HEAP_POOL)
 static void _Command_HeapList(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv);
 #endif  // defined(TCPIP_STACK_USE_INTERNAL_HEAP_POOL)
@@ -587,6 +591,9 @@ static const SYS_CMD_DESCRIPTOR    tcpipCmdTbl[]=
 #if defined(TCPIP_PACKET_ALLOCATION_TRACE_ENABLE)
     {"pktinfo",     _Command_PktInfo,              ": Check PKT allocation"},
 #endif  // defined(TCPIP_PACKET_ALLOCATION_TRACE_ENABLE)
+#if (_TCPIP_PKT_POOL_ENABLE != 0)
+    {"pktpool",     _Command_PktPool,              ": Check PKT pool usage"},
+#endif  // (_TCPIP_PKT_POOL_ENABLE != 0)
 #if defined(TCPIP_STACK_USE_INTERNAL_HEAP_POOL)
     {"heaplist",    _Command_HeapList,             ": List heap"},
 #endif  // defined(TCPIP_STACK_USE_INTERNAL_HEAP_POOL)
@@ -5867,6 +5874,34 @@ static void _Command_PktInfo(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv)
 }
 #endif  // defined(TCPIP_PACKET_ALLOCATION_TRACE_ENABLE)
 
+#if (_TCPIP_PKT_POOL_ENABLE != 0)
+static void _Command_PktPool(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv)
+{
+    TCPIP_PKT_POOL_CLASS poolClass;
+    TCPIP_PKT_POOL_INFO  pInfo;
+    static const char* poolClassStr[TCPIP_PKT_POOL_CLASSES] = 
+    {
+        "small",        // TCPIP_PKT_POOL_CLASS_SMALL
+        "tx",           // TCPIP_PKT_POOL_CLASS_TX
+        "rx",           // TCPIP_PKT_POOL_CLASS_RX
+    };
+
+    const void* cmdIoParam = pCmdIO->cmdIoParam;
+
+    for(poolClass = 0; poolClass < TCPIP_PKT_POOL_CLASSES; poolClass++)
+    {
+        if(!TCPIP_PKT_PoolGetInfo(poolClass, &pInfo))
+        {
+            (*pCmdIO->pCmdApi->msg)(cmdIoParam, "No packet pool available\r\n");
+            return;
+        }
+
+        (*pCmdIO->pCmdApi->print)(cmdIoParam, "PKT pool %5s: size: %4d, blocks: %2d, free: %2d, minFree: %2d, allocs: %6d, fallbacks: %4d\r\n",
+                poolClassStr[poolClass], pInfo.blockSize, pInfo.nBlocks, pInfo.nFree, pInfo.minFree, pInfo.nAllocs, pInfo.nFallbacks);
+    }
+}
+#endif  // (_TCPIP_PKT_POOL_ENABLE != 0)
+
 #if defined(TCPIP_STACK_USE_INTERNAL_HEAP_POOL)
 static void _Command_HeapList(SYS_CMD_DEVICE_NODE* pCmdIO, int argc, char** argv)
 {
@@ -75,6 +75,39 @@ Microchip or any third party.
 
 static TCPIP_STACK_HEAP_HANDLE    pktMemH = 0;
 
+#if (_TCPIP_PKT_POOL_ENABLE != 0)
+// a free pool block
+typedef struct _tag_TCPIP_PKT_POOL_NODE
+{
+    struct _tag_TCPIP_PKT_POOL_NODE*    next;
+}TCPIP_PKT_POOL_NODE;
+
+// a pool size class
+typedef struct
+{
+    TCPIP_PKT_POOL_NODE*    freeList;       // available blocks
+    uint8_t*                blockStart;     // the blocks of this class: [blockStart, blockEnd)
+    uint8_t*                blockEnd;
+    TCPIP_PKT_POOL_INFO     info;           // usage
+}TCPIP_PKT_POOL_DCPT;
+
+// configured block size and number, per class
+static const uint16_t _pktPoolConfig[TCPIP_PKT_POOL_CLASSES][2] =
+{
+    {TCPIP_PKT_POOL_SMALL_BLOCK_SIZE,   TCPIP_PKT_POOL_SMALL_BLOCKS},   // TCPIP_PKT_POOL_CLASS_SMALL
+    {TCPIP_PKT_POOL_TX_BLOCK_SIZE,      TCPIP_PKT_POOL_TX_BLOCKS},      // TCPIP_PKT_POOL_CLASS_TX
+    {TCPIP_PKT_POOL_RX_BLOCK_SIZE,      TCPIP_PKT_POOL_RX_BLOCKS},      // TCPIP_PKT_POOL_CLASS_RX
+};
+
+static TCPIP_PKT_POOL_DCPT  _pktPoolTbl[TCPIP_PKT_POOL_CLASSES];
+
+static void*                _pktPoolAllocPtr;   // pool memory, as allocated from the heap
+static uint8_t*             _pktPoolStart;      // cache aligned start of the blocks
+static uint8_t*             _pktPoolEnd;
+
+static void                 _TCPIP_PKT_PoolCreate(TCPIP_STACK_HEAP_HANDLE heapH);
+#endif  // (_TCPIP_PKT_POOL_ENABLE != 0)
+
 #if defined(TCPIP_PACKET_ALLOCATION_TRACE_ENABLE)
 static TCPIP_PKT_TRACE_ENTRY    _pktTraceTbl[TCPIP_PKT_TRACE_SIZE];
 
@@ -139,6 +172,10 @@ bool TCPIP_PKT_Initialize(TCPIP_STACK_HEAP_HANDLE heapH, const TCPIP_NETWORK_CON
         // success
         pktMemH = heapH;
 
+#if (_TCPIP_PKT_POOL_ENABLE != 0)
+        _TCPIP_PKT_PoolCreate(heapH);
+#endif  // (_TCPIP_PKT_POOL_ENABLE != 0)
+
 #if defined(TCPIP_PACKET_ALLOCATION_TRACE_ENABLE)
         memset(_pktTraceTbl, 0, sizeof(_pktTraceTbl));
         memset(&_pktTraceInfo, 0, sizeof(_pktTraceInfo));
@@ -169,9 +206,181 @@ bool TCPIP_PKT_Initialize(TCPIP_STACK_HEAP_HANDLE heapH, const TCPIP_NETWORK_CON
 
 void TCPIP_PKT_Deinitialize(void)
 {
+#if (_TCPIP_PKT_POOL_ENABLE != 0)
+    if(_pktPoolAllocPtr != 0)
+    {   // the pool goes back to the heap it came from, which the stack deletes next
+        // blocks still out are reclaimed with it: like the packets taken from the heap,
+        // they cannot be used or freed once the stack is down
+        int poolIx, nOut = 0;
+        TCPIP_PKT_POOL_DCPT* pPool = _pktPoolTbl;
+        for(poolIx = 0; poolIx < TCPIP_PKT_POOL_CLASSES; poolIx++, pPool++)
+        {
+            nOut += pPool->info.nBlocks - pPool->info.nFree;
+        }
+
+        if(nOut != 0)
+        {
+            SYS_ERROR_PRINT(SYS_ERROR_WARNING, "PKT Deinit: %d pool blocks not returned! \r\n", nOut);
+        }
+
+        TCPIP_HEAP_Free(pktMemH, _pktPoolAllocPtr);
+        _pktPoolAllocPtr = 0;
+        _pktPoolStart = _pktPoolEnd = 0;
+        memset(_pktPoolTbl, 0, sizeof(_pktPoolTbl));
+    }
+#endif  // (_TCPIP_PKT_POOL_ENABLE != 0)
+
     pktMemH = 0;
 }
 
+#if (_TCPIP_PKT_POOL_ENABLE != 0)
+// creates the pool blocks, all in one heap allocation
+// failure is not fatal: the packets are taken from the heap
+static void _TCPIP_PKT_PoolCreate(TCPIP_STACK_HEAP_HANDLE heapH)
+{
+    int poolIx, blkIx;
+    size_t blockSize, poolSize;
+    uint8_t* pBlock;
+    TCPIP_PKT_POOL_DCPT* pPool;
+
+    poolSize = 0;
+    for(poolIx = 0; poolIx < TCPIP_PKT_POOL_CLASSES; poolIx++)
+    {
+        blockSize = ((_pktPoolConfig[poolIx][0] + TCPIP_SEGMENT_CACHE_ALIGN_SIZE - 1) / TCPIP_SEGMENT_CACHE_ALIGN_SIZE) * TCPIP_SEGMENT_CACHE_ALIGN_SIZE;
+        poolSize += blockSize * _pktPoolConfig[poolIx][1];
+    }
+
+    if(poolSize == 0)
+    {
+        return;
+    }
+
+    // extra cache line so that each block starts on a cache line boundary
+    _pktPoolAllocPtr = TCPIP_HEAP_Malloc(heapH, poolSize + TCPIP_SEGMENT_CACHE_ALIGN_SIZE);
+    if(_pktPoolAllocPtr == 0)
+    {
+        return;
+    }
+
+    _pktPoolStart = (uint8_t*)((((uint32_t)_pktPoolAllocPtr + TCPIP_SEGMENT_CACHE_ALIGN_SIZE - 1) / TCPIP_SEGMENT_CACHE_ALIGN_SIZE) * TCPIP_SEGMENT_CACHE_ALIGN_SIZE);
+    _pktPoolEnd = _pktPoolStart + poolSize;
+
+    pBlock = _pktPoolStart;
+    pPool = _pktPoolTbl;
+    for(poolIx = 0; poolIx < TCPIP_PKT_POOL_CLASSES; poolIx++, pPool++)
+    {
+        blockSize = ((_pktPoolConfig[poolIx][0] + TCPIP_SEGMENT_CACHE_ALIGN_SIZE - 1) / TCPIP_SEGMENT_CACHE_ALIGN_SIZE) * TCPIP_SEGMENT_CACHE_ALIGN_SIZE;
+        memset(pPool, 0, sizeof(*pPool));
+        pPool->blockStart = pBlock;
+        for(blkIx = 0; blkIx < _pktPoolConfig[poolIx][1]; blkIx++, pBlock += blockSize)
+        {
+            ((TCPIP_PKT_POOL_NODE*)pBlock)->next = pPool->freeList;
+            pPool->freeList = (TCPIP_PKT_POOL_NODE*)pBlock;
+        }
+        pPool->blockEnd = pBlock;
+        pPool->info.blockSize = blockSize;
+        pPool->info.nBlocks = pPool->info.nFree = pPool->info.minFree = _pktPoolConfig[poolIx][1];
+    }
+}
+
+bool TCPIP_PKT_PoolGetInfo(TCPIP_PKT_POOL_CLASS poolClass, TCPIP_PKT_POOL_INFO* pInfo)
+{
+    if(_pktPoolAllocPtr == 0 || poolClass < 0 || poolClass >= TCPIP_PKT_POOL_CLASSES)
+    {
+        return false;
+    }
+
+    if(pInfo)
+    {
+        OSAL_CRITSECT_DATA_TYPE status = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+        *pInfo = _pktPoolTbl[poolClass].info;
+        OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, status);
+    }
+
+    return true;
+}
+#else
+bool TCPIP_PKT_PoolGetInfo(TCPIP_PKT_POOL_CLASS poolClass, TCPIP_PKT_POOL_INFO* pInfo)
+{
+    return false;
+}
+#endif  // (_TCPIP_PKT_POOL_ENABLE != 0)
+
+// allocates the memory for a packet or segment
+// from the smallest pool class that fits allocLen, or from the heap
+// The MAC drivers allocate RX packets from their own context, hence the critical section
+static void* _TCPIP_PKT_BlockAlloc(uint16_t allocLen, int moduleId, int lineNo)
+{
+#if (_TCPIP_PKT_POOL_ENABLE != 0)
+    int poolIx;
+    TCPIP_PKT_POOL_DCPT* pPool = _pktPoolTbl;
+    for(poolIx = 0; poolIx < TCPIP_PKT_POOL_CLASSES; poolIx++, pPool++)
+    {
+        if(allocLen <= pPool->info.blockSize)
+        {
+            OSAL_CRITSECT_DATA_TYPE status = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+            TCPIP_PKT_POOL_NODE* pNode = pPool->freeList;
+            if(pNode != 0)
+            {
+                pPool->freeList = pNode->next;
+                if(--pPool->info.nFree < pPool->info.minFree)
+                {
+                    pPool->info.minFree = pPool->info.nFree;
+                }
+                pPool->info.nAllocs++;
+            }
+            else
+            {
+                pPool->info.nFallbacks++;
+            }
+            OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, status);
+
+            if(pNode != 0)
+            {
+                return pNode;
+            }
+            break;
+        }
+    }
+#endif  // (_TCPIP_PKT_POOL_ENABLE != 0)
+
+#if defined(TCPIP_STACK_DRAM_DEBUG_ENABLE)
+    return TCPIP_HEAP_MallocDebug(pktMemH, allocLen, moduleId, lineNo);
+#else
+    return TCPIP_HEAP_Malloc(pktMemH, allocLen);
+#endif  // defined(TCPIP_STACK_DRAM_DEBUG_ENABLE)
+}
+
+// returns a packet or segment memory to its pool or to the heap
+static void _TCPIP_PKT_BlockFree(void* pBlock, int moduleId)
+{
+#if (_TCPIP_PKT_POOL_ENABLE != 0)
+    if((uint8_t*)pBlock >= _pktPoolStart && (uint8_t*)pBlock < _pktPoolEnd)
+    {
+        int poolIx;
+        TCPIP_PKT_POOL_DCPT* pPool = _pktPoolTbl;
+        for(poolIx = 0; poolIx < TCPIP_PKT_POOL_CLASSES; poolIx++, pPool++)
+        {
+            if((uint8_t*)pBlock < pPool->blockEnd)
+            {
+                OSAL_CRITSECT_DATA_TYPE status = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+                ((TCPIP_PKT_POOL_NODE*)pBlock)->next = pPool->freeList;
+                pPool->freeList = (TCPIP_PKT_POOL_NODE*)pBlock;
+                pPool->info.nFree++;
+                OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, status);
+                return;
+            }
+        }
+    }
+#endif  // (_TCPIP_PKT_POOL_ENABLE != 0)
+
+#if defined(TCPIP_STACK_DRAM_DEBUG_ENABLE)
+    TCPIP_HEAP_FreeDebug(pktMemH, pBlock, moduleId);
+#else
+    TCPIP_HEAP_Free(pktMemH, pBlock);
+#endif  // defined(TCPIP_STACK_DRAM_DEBUG_ENABLE)
+}
+
 
 // acknowledges a packet
 void _TCPIP_PKT_PacketAcknowledge(TCPIP_MAC_PACKET* pPkt, TCPIP_MAC_PKT_ACK_RES ackRes, TCPIP_STACK_MODULE moduleId)
@@ -330,11 +539,7 @@ static __inline__ TCPIP_MAC_PACKET* __attribute__((always_inline)) _TCPIP_PKT_Pa
     // total allocation size
     allocLen = pktUpLen + sizeof(*pSeg) + segAllocSize;
 
-#if defined(TCPIP_STACK_DRAM_DEBUG_ENABLE) 
-    pPkt = (TCPIP_MAC_PACKET*)TCPIP_HEAP_MallocDebug(pktMemH, allocLen, moduleId, __LINE__);
-#else
-    pPkt = (TCPIP_MAC_PACKET*)TCPIP_HEAP_Malloc(pktMemH, allocLen);
-#endif  // defined(TCPIP_STACK_DRAM_DEBUG_ENABLE) 
+    pPkt = (TCPIP_MAC_PACKET*)_TCPIP_PKT_BlockAlloc(allocLen, moduleId, __LINE__);
 
     if(pPkt)
     {   
@@ -379,19 +584,11 @@ static __inline__ void __attribute__((always_inline)) _TCPIP_PKT_PacketFreeInt(T
             pNSeg = pSeg->next;
             if((pSeg->segFlags & TCPIP_MAC_SEG_FLAG_STATIC) == 0)
             {
-#if defined(TCPIP_STACK_DRAM_DEBUG_ENABLE) 
-                TCPIP_HEAP_FreeDebug(pktMemH, pSeg, moduleId);
-#else
-                TCPIP_HEAP_Free(pktMemH, pSeg);
-#endif  // defined(TCPIP_STACK_DRAM_DEBUG_ENABLE) 
+                _TCPIP_PKT_BlockFree(pSeg, moduleId);
             }
         }
 
-#if defined(TCPIP_STACK_DRAM_DEBUG_ENABLE) 
-        TCPIP_HEAP_FreeDebug(pktMemH, pPkt, moduleId);
-#else
-        TCPIP_HEAP_Free(pktMemH, pPkt);
-#endif  // defined(TCPIP_STACK_DRAM_DEBUG_ENABLE) 
+        _TCPIP_PKT_BlockFree(pPkt, moduleId);
     }
 }
 
@@ -441,11 +638,7 @@ static __inline__ TCPIP_MAC_DATA_SEGMENT* __attribute__((always_inline)) _TCPIP_
     allocLen = sizeof(*pSeg) + segAllocSize;
 
 
-#if defined(TCPIP_STACK_DRAM_DEBUG_ENABLE) 
-    pSeg = (TCPIP_MAC_DATA_SEGMENT*)TCPIP_HEAP_MallocDebug(pktMemH, allocLen, moduleId, __LINE__);
-#else
-    pSeg = (TCPIP_MAC_DATA_SEGMENT*)TCPIP_HEAP_Malloc(pktMemH, allocLen);
-#endif  // defined(TCPIP_STACK_DRAM_DEBUG_ENABLE) 
+    pSeg = (TCPIP_MAC_DATA_SEGMENT*)_TCPIP_PKT_BlockAlloc(allocLen, moduleId, __LINE__);
 
 
     if(pSeg)
@@ -468,11 +661,7 @@ static __inline__ void __attribute__((always_inline)) _TCPIP_PKT_SegmentFreeInt(
 {
     if( (pSeg->segFlags & TCPIP_MAC_SEG_FLAG_STATIC) == 0)
     {
-#if defined(TCPIP_STACK_DRAM_DEBUG_ENABLE) 
-        TCPIP_HEAP_FreeDebug(pktMemH, pSeg, moduleId);
-#else
-        TCPIP_HEAP_Free(pktMemH, pSeg);
-#endif  // defined(TCPIP_STACK_DRAM_DEBUG_ENABLE) 
+        _TCPIP_PKT_BlockFree(pSeg, moduleId);
     }
 
 }
@@ -688,7 +877,7 @@ TCPIP_MAC_PACKET* _TCPIP_PKT_PacketAlloc(uint16_t pktLen, uint16_t segLoadLen, T
     // total allocation size
     allocLen = pktUpLen + sizeof(*pSeg) + segAllocSize;
 
-    pPkt = (TCPIP_MAC_PACKET*)TCPIP_HEAP_Malloc(pktMemH, allocLen);
+    pPkt = (TCPIP_MAC_PACKET*)_TCPIP_PKT_BlockAlloc(allocLen, 0, __LINE__);
 
     if(pPkt)
     {   
@@ -765,11 +954,11 @@ void _TCPIP_PKT_PacketFree(TCPIP_MAC_PACKET* pPkt)
             pNSeg = pSeg->next;
             if((pSeg->segFlags & TCPIP_MAC_SEG_FLAG_STATIC) == 0)
             {
-                TCPIP_HEAP_Free(pktMemH, pSeg);
+                _TCPIP_PKT_BlockFree(pSeg, 0);
             }
         }
 
-        TCPIP_HEAP_Free(pktMemH, pPkt);
+        _TCPIP_PKT_BlockFree(pPkt, 0);
     }
 }
 
@@ -788,7 +977,7 @@ TCPIP_MAC_DATA_SEGMENT* _TCPIP_PKT_SegmentAlloc(uint16_t loadLen, TCPIP_MAC_SEGM
     // total allocation size
     allocLen = sizeof(*pSeg) + segAllocSize;
 
-    pSeg = (TCPIP_MAC_DATA_SEGMENT*)TCPIP_HEAP_Malloc(pktMemH, allocLen);
+    pSeg = (TCPIP_MAC_DATA_SEGMENT*)_TCPIP_PKT_BlockAlloc(allocLen, 0, __LINE__);
 
     if(pSeg)
     {
@@ -810,7 +999,7 @@ void _TCPIP_PKT_SegmentFree(TCPIP_MAC_DATA_SEGMENT* pSeg)
 {
     if( (pSeg->segFlags & TCPIP_MAC_SEG_FLAG_STATIC) == 0)
     {
-        TCPIP_HEAP_Free(pktMemH, pSeg);
+        _TCPIP_PKT_BlockFree(pSeg, 0);
     }
 }
 #endif  // defined(TCPIP_PACKET_ALLOCATION_TRACE_ENABLE)
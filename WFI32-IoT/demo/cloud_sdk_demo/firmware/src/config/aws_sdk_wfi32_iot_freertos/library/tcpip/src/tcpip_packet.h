@@ -85,6 +85,38 @@ typedef struct
 // currently: tcp, udp, icmp, arp, ipv6
 #define TCPIP_PKT_TRACE_SIZE        8
 
+// packet pools
+// Packets and segments are taken from fixed size blocks reserved at TCPIP_PKT_Initialize,
+// the smallest class that fits the allocation.
+// Allocations that no class fits or whose class is exhausted go to the heap.
+// only if TCPIP_PKT_POOL_ENABLE is enabled
+#if defined(TCPIP_PKT_POOL_ENABLE) && (TCPIP_PKT_POOL_ENABLE != 0)
+#define _TCPIP_PKT_POOL_ENABLE      1
+#else
+#define _TCPIP_PKT_POOL_ENABLE      0
+#endif
+
+// pool size classes
+typedef enum
+{
+    TCPIP_PKT_POOL_CLASS_SMALL,     // TCP headers and ACKs, ARP, ICMP
+    TCPIP_PKT_POOL_CLASS_TX,        // UDP datagrams
+    TCPIP_PKT_POOL_CLASS_RX,        // MTU sized frames from the MAC
+
+    TCPIP_PKT_POOL_CLASSES
+}TCPIP_PKT_POOL_CLASS;
+
+// pool usage of a size class
+typedef struct
+{
+    uint16_t    blockSize;          // largest allocation served by this class, bytes
+    uint16_t    nBlocks;            // blocks in this class
+    uint16_t    nFree;              // blocks currently available
+    uint16_t    minFree;            // lowest nFree so far
+    uint32_t    nAllocs;            // allocations served by this class
+    uint32_t    nFallbacks;         // allocations that went to the heap because the class was exhausted
+}TCPIP_PKT_POOL_INFO;
+
 // module and packet logging flags
 // only if TCPIP_PACKET_LOG_ENABLE is enabled
 //
@@ -335,6 +367,11 @@ int     TCPIP_PKT_TraceGetEntriesNo(TCPIP_PKT_TRACE_INFO* pTraceInfo);
 // returns true if the entry is active - has valid data
 bool    TCPIP_PKT_TraceGetEntry(int entryIx, TCPIP_PKT_TRACE_ENTRY* tEntry);
 
+// populates the usage info of a pool size class
+// returns false if the pools are not enabled/created
+// or the class is not valid
+bool    TCPIP_PKT_PoolGetInfo(TCPIP_PKT_POOL_CLASS poolClass, TCPIP_PKT_POOL_INFO* pInfo);
+
 
 // logs a TX packet info
 void    TCPIP_PKT_FlightLogTx(TCPIP_MAC_PACKET* pPkt, TCPIP_STACK_MODULE moduleId);
@@ -250,6 +250,8 @@ typedef enum
                                     // If 0, the socket will use the default global IPv4 TTL setting.
                                     // This option allows the user to specify a different TTL value.
     TCP_OPTION_TOS,                 // Sets the Type of Service (TOS) for IPv4 packets sent by the socket
+    TCP_OPTION_RX_BUFF_MAX,         // Largest size the RX buffer is tuned to; TCPIP_TCP_RX_AUTO_TUNE only.
+                                    // 0 when TCP_OPTION_RX_BUFF has fixed the RX buffer size.
 } TCP_SOCKET_OPTION;
 
 
@@ -753,10 +755,17 @@ bool  TCPIP_TCP_RemoteBind(TCP_SOCKET hTCP, IP_ADDRESS_TYPE addType, TCP_PORT re
                       - TCP_OPTION_DELAY_SEND_ALL_ACK   - boolean to enable/disable the DELAY Send All ACK data functionality
                       - TCP_OPTION_TX_TTL              - 8-bit value of TTL
                       - TCP_OPTION_TOS                 - 8-bit value of the TOS
+                      - TCP_OPTION_RX_BUFF_MAX         - largest size the RX buffer is tuned to (<= 65535 bytes)
 
   Returns:
     - true  - Indicates success
     - false - Indicates failure
+
+  Remarks:
+    With TCPIP_TCP_RX_AUTO_TUNE enabled, the RX buffer size of a socket is tuned
+    at run time up to its TCP_OPTION_RX_BUFF_MAX (TCPIP_TCP_RX_AUTO_MAX_SIZE by default).
+    Setting TCP_OPTION_RX_BUFF fixes the size and takes the socket out of the tuning;
+    setting TCP_OPTION_RX_BUFF_MAX afterwards puts it back.
   */
 bool  TCPIP_TCP_OptionsSet(TCP_SOCKET hTCP, TCP_SOCKET_OPTION option, void* optParam);
 
@@ -795,6 +804,7 @@ bool  TCPIP_TCP_OptionsSet(TCP_SOCKET hTCP, TCP_SOCKET_OPTION option, void* optP
                       - TCP_OPTION_DELAY_SEND_ALL_ACK   - pointer to boolean to return current DELAY Send All ACK status
                       - TCP_OPTION_TX_TTL               - pointer to an 8 bit value to receive the TTL value
                       - TCP_OPTION_TOS                  - pointer to an 8 bit value to receive the TOS
+                      - TCP_OPTION_RX_BUFF_MAX          - pointer to a 16 bit value to receive the RX buffer tuning limit
 
   Returns:
     - true  - Indicates success
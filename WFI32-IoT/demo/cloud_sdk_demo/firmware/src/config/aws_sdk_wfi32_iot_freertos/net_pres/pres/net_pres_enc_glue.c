@@ -38,6 +38,12 @@ Microchip or any third party.
 #include "net_pres/pres/net_pres_certstore.h"
 
 #include "config.h"
+#include "osal/osal.h"
+#include "system/time/sys_time.h"
+#if defined(NET_PRES_TLS_SESSION_PERSIST)
+#include "system/fs/sys_fs.h"
+#endif
+#include "library/tcpip/tcpip.h"
 #include "wolfssl/ssl.h"
 #include "wolfssl/wolfcrypt/logging.h"
 #include "wolfssl/wolfcrypt/random.h"
@@ -78,6 +84,299 @@ NET_PRES_EncProviderObject net_pres_EncProviderStreamClient0 =
 };
 	
 net_pres_wolfsslInfo net_pres_wolfSSLInfoStreamClient0;
+
+// TLS client session cache, keyed by the server address and port.
+// Resuming a session skips the ECDHE key exchange and the certificate chain
+// verification, i.e. the ATECC608 and BA414E work of a full handshake.
+// All connections send the same SNI, so the host name can't tell the MQTT
+// broker from the OTA server.
+typedef struct
+{
+    IP_MULTI_ADDRESS address;
+    uint16_t addressType;
+    TCP_PORT port;
+}net_pres_tlsSessionKey;
+
+typedef struct
+{
+    net_pres_tlsSessionKey key;
+    WOLFSSL_SESSION* session;
+}net_pres_tlsSessionEntry;
+
+// connection being opened or negotiated, found by its WOLFSSL object
+typedef struct
+{
+    WOLFSSL* ssl;
+    net_pres_tlsSessionKey key;
+    bool keyValid;
+    uint32_t start;         // handshake start, for the statistics
+}net_pres_tlsConnection;
+
+static net_pres_tlsSessionEntry _net_pres_tlsSessions[NET_PRES_TLS_SESSION_CACHE_SIZE];
+static uint8_t _net_pres_tlsSessionNext = 0;
+static NET_PRES_TLS_SESSION_STATS _net_pres_tlsSessionStats;
+// Open0 and Connect0 run in the NET_PRES task but Close0 also runs in the
+// task closing the socket, so the connection table and the negotiating
+// count are only changed inside a critical section
+static net_pres_tlsConnection _net_pres_tlsConnections[NET_PRES_NUM_SOCKETS];
+// sessions opened that have not finished their handshake yet
+static uint32_t _net_pres_tlsNegotiating = 0;
+#if defined(WOLFSSL_ATECC_KEY_PREFETCH)
+// after a failed prefetch, the device is left alone until this counter value
+static bool _net_pres_tlsPrefetchHold = false;
+static uint32_t _net_pres_tlsPrefetchRetry = 0;
+#endif  // defined(WOLFSSL_ATECC_KEY_PREFETCH)
+
+static bool _NET_PRES_TlsSessionKeyGet(uintptr_t transHandle, net_pres_tlsSessionKey* pKey)
+{
+    TCP_SOCKET_INFO info;
+
+    // the transport is connected before the provider is opened
+    if (!TCPIP_TCP_SocketInfoGet((TCP_SOCKET)transHandle, &info))
+    {
+        return false;
+    }
+    memset(pKey, 0, sizeof(*pKey));
+    pKey->addressType = info.addressType;
+    pKey->port = info.remotePort;
+    if (info.addressType == IP_ADDRESS_TYPE_IPV6)
+    {
+        pKey->address.v6Add = info.remoteIPaddress.v6Add;
+    }
+    else
+    {
+        pKey->address.v4Add = info.remoteIPaddress.v4Add;
+    }
+    return true;
+}
+
+static net_pres_tlsSessionEntry* _NET_PRES_TlsSessionFind(const net_pres_tlsSessionKey* pKey)
+{
+    int ix;
+    for (ix = 0; ix < NET_PRES_TLS_SESSION_CACHE_SIZE; ix++)
+    {
+        if (_net_pres_tlsSessions[ix].session != NULL && memcmp(&_net_pres_tlsSessions[ix].key, pKey, sizeof(*pKey)) == 0)
+        {
+            return &_net_pres_tlsSessions[ix];
+        }
+    }
+    return NULL;
+}
+
+static void _NET_PRES_TlsSessionDrop(net_pres_tlsSessionEntry* pEntry)
+{
+    wolfSSL_SESSION_free(pEntry->session);
+    pEntry->session = NULL;
+    memset(&pEntry->key, 0, sizeof(pEntry->key));
+}
+
+// call inside the critical section
+static net_pres_tlsConnection* _NET_PRES_TlsConnectionFind(WOLFSSL* ssl)
+{
+    int ix;
+    for (ix = 0; ix < NET_PRES_NUM_SOCKETS; ix++)
+    {
+        if (_net_pres_tlsConnections[ix].ssl == ssl)
+        {
+            return &_net_pres_tlsConnections[ix];
+        }
+    }
+    return NULL;
+}
+
+// takes a free slot for ssl; the connection counts as negotiating until released
+static net_pres_tlsConnection* _NET_PRES_TlsConnectionClaim(WOLFSSL* ssl)
+{
+    OSAL_CRITSECT_DATA_TYPE critStatus = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+    net_pres_tlsConnection* pConn = _NET_PRES_TlsConnectionFind(NULL);
+    if (pConn != NULL)
+    {
+        pConn->ssl = ssl;
+        pConn->keyValid = false;
+        _net_pres_tlsNegotiating++;
+    }
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, critStatus);
+    return pConn;
+}
+
+// frees the slot of ssl, if it still has one, and returns a copy of it
+static bool _NET_PRES_TlsConnectionRelease(WOLFSSL* ssl, net_pres_tlsConnection* pCopy)
+{
+    OSAL_CRITSECT_DATA_TYPE critStatus = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+    net_pres_tlsConnection* pConn = _NET_PRES_TlsConnectionFind(ssl);
+    if (pConn != NULL)
+    {
+        if (pCopy != NULL)
+        {
+            *pCopy = *pConn;
+        }
+        pConn->ssl = NULL;
+        _net_pres_tlsNegotiating--;
+    }
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, critStatus);
+    return pConn != NULL;
+}
+
+// returns the session key of ssl once, so a failed handshake drops its entry once
+static bool _NET_PRES_TlsConnectionKeyTake(WOLFSSL* ssl, net_pres_tlsSessionKey* pKey)
+{
+    bool keyValid = false;
+    OSAL_CRITSECT_DATA_TYPE critStatus = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+    net_pres_tlsConnection* pConn = _NET_PRES_TlsConnectionFind(ssl);
+    if (pConn != NULL && pConn->keyValid)
+    {
+        *pKey = pConn->key;
+        pConn->keyValid = false;
+        keyValid = true;
+    }
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, critStatus);
+    return keyValid;
+}
+
+#if defined(NET_PRES_TLS_SESSION_PERSIST)
+// file layout: the session key (sizeof(net_pres_tlsSessionKey) bytes), then the DER session
+static void _NET_PRES_TlsSessionSave(const net_pres_tlsSessionEntry* pEntry)
+{
+    unsigned char* der = NULL;
+    int derLen = wolfSSL_i2d_SSL_SESSION(pEntry->session, &der);
+    if (derLen <= 0)
+    {
+        return;
+    }
+    SYS_FS_HANDLE fd = SYS_FS_FileOpen(NET_PRES_TLS_SESSION_FILE_NAME, SYS_FS_FILE_OPEN_WRITE);
+    if (fd != SYS_FS_HANDLE_INVALID)
+    {
+        SYS_FS_FileWrite(fd, &pEntry->key, sizeof(pEntry->key));
+        SYS_FS_FileWrite(fd, der, derLen);
+        SYS_FS_FileClose(fd);
+    }
+    XFREE(der, NULL, DYNAMIC_TYPE_OPENSSL);
+}
+
+static void _NET_PRES_TlsSessionLoad(void)
+{
+    static bool loaded = false;
+    uint8_t* der;
+    const unsigned char* p;
+    int32_t fileSize;
+    net_pres_tlsSessionEntry* pEntry = &_net_pres_tlsSessions[0];
+
+    if (loaded)
+    {
+        return;
+    }
+    loaded = true;
+
+    SYS_FS_HANDLE fd = SYS_FS_FileOpen(NET_PRES_TLS_SESSION_FILE_NAME, SYS_FS_FILE_OPEN_READ);
+    if (fd == SYS_FS_HANDLE_INVALID)
+    {
+        return;
+    }
+    // the DER session takes the rest of the file; tickets and peer certificates make it grow
+    fileSize = SYS_FS_FileSize(fd);
+    if (fileSize > (int32_t)sizeof(pEntry->key) &&
+        SYS_FS_FileRead(fd, &pEntry->key, sizeof(pEntry->key)) == sizeof(pEntry->key))
+    {
+        size_t derSize = (size_t)fileSize - sizeof(pEntry->key);
+        der = (uint8_t*)XMALLOC(derSize, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+        if (der != NULL)
+        {
+            if (SYS_FS_FileRead(fd, der, derSize) == derSize)
+            {
+                p = der;
+                pEntry->session = wolfSSL_d2i_SSL_SESSION(NULL, &p, (long)derSize);
+            }
+            XFREE(der, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+        }
+    }
+    SYS_FS_FileClose(fd);
+    if (pEntry->session == NULL)
+    {
+        memset(&pEntry->key, 0, sizeof(pEntry->key));
+    }
+}
+#endif  // defined(NET_PRES_TLS_SESSION_PERSIST)
+
+static void _NET_PRES_TlsSessionStore(WOLFSSL* ssl, const net_pres_tlsSessionKey* pKey)
+{
+    net_pres_tlsSessionEntry* pEntry = _NET_PRES_TlsSessionFind(pKey);
+    WOLFSSL_SESSION* session = wolfSSL_get1_session(ssl);
+
+    if (session == NULL)
+    {
+        return;
+    }
+    if (pEntry == NULL)
+    {   // round robin replacement
+        pEntry = &_net_pres_tlsSessions[_net_pres_tlsSessionNext];
+        _net_pres_tlsSessionNext = (_net_pres_tlsSessionNext + 1) % NET_PRES_TLS_SESSION_CACHE_SIZE;
+    }
+    if (pEntry->session != NULL)
+    {
+        wolfSSL_SESSION_free(pEntry->session);
+    }
+    pEntry->session = session;
+    pEntry->key = *pKey;
+#if defined(NET_PRES_TLS_SESSION_PERSIST)
+    _NET_PRES_TlsSessionSave(pEntry);
+#endif  // defined(NET_PRES_TLS_SESSION_PERSIST)
+}
+
+void NET_PRES_EncGlue_SessionStatsGet(NET_PRES_TLS_SESSION_STATS * pStats)
+{
+    *pStats = _net_pres_tlsSessionStats;
+#if defined(WOLFSSL_ATECC_KEY_PREFETCH)
+    word32 hits, misses;
+    atmel_ecc_prefetch_stats(&hits, &misses);
+    pStats->keyPrefetchHits = hits;
+    pStats->keyPrefetchMisses = misses;
+#endif  // defined(WOLFSSL_ATECC_KEY_PREFETCH)
+}
+
+void NET_PRES_EncGlue_IdleTasks(void)
+{
+#if defined(WOLFSSL_ATECC_KEY_PREFETCH)
+    // the key is made ahead of the next full handshake; making it while
+    // one runs would only stretch that handshake
+    if (!net_pres_wolfSSLInfoStreamClient0.isInited || _net_pres_tlsNegotiating != 0)
+    {
+        return;
+    }
+    if (_net_pres_tlsPrefetchHold)
+    {
+        if ((int32_t)(SYS_TIME_CounterGet() - _net_pres_tlsPrefetchRetry) < 0)
+        {
+            return;
+        }
+        _net_pres_tlsPrefetchHold = false;
+    }
+
+    uint32_t start = SYS_TIME_CounterGet();
+    int ret = atmel_ecc_prefetch_key();
+    if (ret > 0)
+    {
+        _net_pres_tlsSessionStats.keyPrefetches++;
+        _net_pres_tlsSessionStats.keyPrefetchTotalMs += SYS_TIME_CountToMS(SYS_TIME_CounterGet() - start);
+    }
+    else if (ret < 0)
+    {
+        _net_pres_tlsPrefetchHold = true;
+        _net_pres_tlsPrefetchRetry = SYS_TIME_CounterGet() + SYS_TIME_MSToCount(NET_PRES_TLS_KEY_PREFETCH_RETRY_MS);
+    }
+#endif  // defined(WOLFSSL_ATECC_KEY_PREFETCH)
+}
+
+void NET_PRES_EncGlue_SessionCacheFlush(void)
+{
+    int ix;
+    for (ix = 0; ix < NET_PRES_TLS_SESSION_CACHE_SIZE; ix++)
+    {
+        if (_net_pres_tlsSessions[ix].session != NULL)
+        {
+            _NET_PRES_TlsSessionDrop(&_net_pres_tlsSessions[ix]);
+        }
+    }
+}
 	
 int NET_PRES_EncGlue_StreamClientReceiveCb0(void *sslin, char *buf, int sz, void *ctx)
 {
@@ -150,8 +449,13 @@ bool NET_PRES_EncProviderStreamClientInit0(NET_PRES_TransportObject * transObjec
 bool NET_PRES_EncProviderStreamClientDeinit0(void)
 {
    atmel_finish();
+    NET_PRES_EncGlue_SessionCacheFlush();
     wolfSSL_CTX_free(net_pres_wolfSSLInfoStreamClient0.context);
     net_pres_wolfSSLInfoStreamClient0.isInited = false;
+    OSAL_CRITSECT_DATA_TYPE critStatus = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+    memset(_net_pres_tlsConnections, 0, sizeof(_net_pres_tlsConnections));
+    _net_pres_tlsNegotiating = 0;
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, critStatus);
     _net_pres_wolfsslUsers--;
     if (_net_pres_wolfsslUsers == 0)
     {
@@ -161,6 +465,7 @@ bool NET_PRES_EncProviderStreamClientDeinit0(void)
 }
 bool NET_PRES_EncProviderStreamClientOpen0(uintptr_t transHandle, void * providerData)
 {
+        net_pres_tlsConnection* pConn;
         WOLFSSL* ssl = wolfSSL_new(net_pres_wolfSSLInfoStreamClient0.context);
         if (ssl == NULL)
         {
@@ -173,8 +478,32 @@ bool NET_PRES_EncProviderStreamClientOpen0(uintptr_t transHandle, void * provide
         }
         if (wolfSSL_UseSNI(ssl, WOLFSSL_SNI_HOST_NAME, g_Cloud_Endpoint, strlen(g_Cloud_Endpoint)) != WOLFSSL_SUCCESS)
         {
+            wolfSSL_free(ssl);
+            return false;
+        }
+#if defined(HAVE_SESSION_TICKET)
+        wolfSSL_UseSessionTicket(ssl);
+#endif
+#if defined(NET_PRES_TLS_SESSION_PERSIST)
+        _NET_PRES_TlsSessionLoad();
+#endif  // defined(NET_PRES_TLS_SESSION_PERSIST)
+        // the slot belongs to this connection until it is released
+        pConn = _NET_PRES_TlsConnectionClaim(ssl);
+        if (pConn == NULL)
+        {
+            wolfSSL_free(ssl);
             return false;
         }
+        pConn->start = SYS_TIME_CounterGet();
+        pConn->keyValid = _NET_PRES_TlsSessionKeyGet(transHandle, &pConn->key);
+        if (pConn->keyValid)
+        {
+            net_pres_tlsSessionEntry* pEntry = _NET_PRES_TlsSessionFind(&pConn->key);
+            if (pEntry != NULL)
+            {   // offer the cached session; wolfSSL falls back to a full handshake if the server declines
+                wolfSSL_set_session(ssl, pEntry->session);
+            }
+        }
         memcpy(providerData, &ssl, sizeof(WOLFSSL*));
         return true;
 }
@@ -185,11 +514,33 @@ bool NET_PRES_EncProviderStreamClientIsInited0(void)
 NET_PRES_EncSessionStatus NET_PRES_EncProviderClientConnect0(void * providerData)
 {
     WOLFSSL* ssl;
+    net_pres_tlsConnection conn;
+    net_pres_tlsSessionKey key;
     memcpy(&ssl, providerData, sizeof(WOLFSSL*));
     int result = wolfSSL_connect(ssl);
     switch (result)
     {
         case SSL_SUCCESS:
+            // the handshake state is only needed until the connection is open
+            if (!_NET_PRES_TlsConnectionRelease(ssl, &conn))
+            {   // already reported open
+                return NET_PRES_ENC_SS_OPEN;
+            }
+            uint32_t elapsedMs = SYS_TIME_CountToMS(SYS_TIME_CounterGet() - conn.start);
+            if (wolfSSL_session_reused(ssl))
+            {
+                _net_pres_tlsSessionStats.resumedHandshakes++;
+                _net_pres_tlsSessionStats.resumedTotalMs += elapsedMs;
+            }
+            else
+            {
+                _net_pres_tlsSessionStats.fullHandshakes++;
+                _net_pres_tlsSessionStats.fullTotalMs += elapsedMs;
+            }
+            if (conn.keyValid)
+            {
+                _NET_PRES_TlsSessionStore(ssl, &conn.key);
+            }
             return NET_PRES_ENC_SS_OPEN;
         default:
         {
@@ -200,7 +551,17 @@ NET_PRES_EncSessionStatus NET_PRES_EncProviderClientConnect0(void * providerData
                 case SSL_ERROR_WANT_WRITE:
                     return NET_PRES_ENC_SS_CLIENT_NEGOTIATING;
                 default:
+                {   // don't offer this server a session it may have rejected again
+                    if (_NET_PRES_TlsConnectionKeyTake(ssl, &key))
+                    {
+                        net_pres_tlsSessionEntry* pEntry = _NET_PRES_TlsSessionFind(&key);
+                        if (pEntry != NULL)
+                        {
+                            _NET_PRES_TlsSessionDrop(pEntry);
+                        }
+                    }
                     return NET_PRES_ENC_SS_FAILED;
+                }
             }
         }
     }
@@ -209,6 +570,8 @@ NET_PRES_EncSessionStatus NET_PRES_EncProviderConnectionClose0(void * providerDa
 {
     WOLFSSL* ssl;
     memcpy(&ssl, providerData, sizeof(WOLFSSL*));
+    // frees the slot if the connection closed before its handshake completed
+    _NET_PRES_TlsConnectionRelease(ssl, NULL);
     wolfSSL_free(ssl);
     return NET_PRES_ENC_SS_CLOSED;
 }
@@ -57,6 +57,42 @@ int32_t NET_PRES_EncProviderPeek0(void * providerData, uint8_t * buffer, uint16_
 int32_t NET_PRES_EncProviderOutputSize0(void * providerData, int32_t inSize);
 int32_t NET_PRES_EncProviderMaxOutputSize0(void * providerData);
 #define NET_PRES_SNI_HOST_NAME		"microchip.com"
+
+// Number of TLS client sessions kept for resumption, one per server address and port
+#ifndef NET_PRES_TLS_SESSION_CACHE_SIZE
+#define NET_PRES_TLS_SESSION_CACHE_SIZE     2
+#endif
+
+// Time the ATECC608 is left alone after a failed ephemeral key prefetch
+#ifndef NET_PRES_TLS_KEY_PREFETCH_RETRY_MS
+#define NET_PRES_TLS_KEY_PREFETCH_RETRY_MS  1000
+#endif
+
+// Define NET_PRES_TLS_SESSION_PERSIST (requires HAVE_EXT_CACHE or OPENSSL_EXTRA in
+// the wolfSSL configuration) to keep the most recent session in this file so that
+// it survives a reset or deep sleep
+#ifndef NET_PRES_TLS_SESSION_FILE_NAME
+#define NET_PRES_TLS_SESSION_FILE_NAME      "/mnt/myDrive1/tlssess.bin"
+#endif
+
+typedef struct
+{
+    uint32_t fullHandshakes;        // handshakes that negotiated a new session
+    uint32_t resumedHandshakes;     // handshakes that resumed a cached session
+    uint32_t fullTotalMs;           // total time spent in full handshakes
+    uint32_t resumedTotalMs;        // total time spent in resumed handshakes
+    uint32_t keyPrefetches;         // ephemeral keys generated between handshakes
+    uint32_t keyPrefetchTotalMs;    // total time spent generating them
+    uint32_t keyPrefetchHits;       // handshakes that took a prefetched key
+    uint32_t keyPrefetchMisses;     // handshakes that had to generate their key
+}NET_PRES_TLS_SESSION_STATS;
+
+void NET_PRES_EncGlue_SessionStatsGet(NET_PRES_TLS_SESSION_STATS * pStats);
+void NET_PRES_EncGlue_SessionCacheFlush(void);
+// Background work of the provider, run from the NET_PRES task between calls
+// to NET_PRES_Tasks: prefetches the next ephemeral ECDHE key when no
+// handshake is in progress
+void NET_PRES_EncGlue_IdleTasks(void);
 #ifdef __CPLUSPLUS
 }
 #endif
@@ -27,27 +27,31 @@
 
 #include "../system/ota/framework/http_client/http_client.h"
 #include "definitions.h"
+#include "system/ota/framework/ota_ring.h"
 
 //#include "config/pic32mz_w1_curiosity_freertos/net_pres/pres/net_pres.h"
-#define DOWNLOADER_BUFFER_SIZE 4096
+
+/* Receive flow control: the HTTP client stops reading once less than a TCP
+   segment is free, and carries on when the ring has drained to half */
+#define DOWNLOADER_RX_PAUSE_SPACE   1460
+#define DOWNLOADER_RX_RESUME_LEVEL  (DOWNLOADER_BUFFER_SIZE / 2)
 
 typedef struct {
     HTTP_CLIENT_HANDLE httpHandle;
     HTTP_CLIENT_ERRORS httpErrorState;
-    uint32_t downloadPause;
+    bool     rxPaused;
     size_t   downloadFileSize;
     size_t   downloadedSize;
+    size_t   rangeStart;
     uint8_t *buf;
-    uint32_t bufIn;
-    uint32_t bufOut;
-    uint32_t bufLevel;
+    /* Filled by the HTTP client, drained by DOWNLOADER_Read/Peek/Release */
+    OTA_RING ring;
 } DOWNLOADER_HTTP_CLIENT;
 
 static DOWNLOADER_HTTP_CLIENT downloader;
 size_t field_content_length;
 extern bool HTTP_Client_SetRxReady(HTTP_CLIENT_HANDLE handle, bool ready);
 static int DOWNLOADER_BufPut(uint8_t *buf, int size);
-static int DOWNLOADER_BufGet(uint8_t *buf, int reqSize);
 
 static void DOWNLOADER_HTTPClient_EventHandler(HTTP_CLIENT_HANDLE httpHandle, uintptr_t eventHandle, HTTP_CLIENT_EVENTS event, void *pEventData, size_t eventDataLength)
 {
@@ -81,11 +85,21 @@ static void DOWNLOADER_HTTPClient_EventHandler(HTTP_CLIENT_HANDLE httpHandle, ui
         case HTTP_CLIENT_EVENT_HEADER_RECEIVED:
         {
             HTTP_CLIENT_RESPONSE_MSG *pRspMsg = (HTTP_CLIENT_RESPONSE_MSG*)pEventData;
-            if (200 == pRspMsg->httpStatusCode)
+            if (downloader.rangeStart == 0 && 200 == pRspMsg->httpStatusCode)
             {
                 downloader.downloadFileSize = pRspMsg->fieldContentLength;
                 field_content_length = pRspMsg->fieldContentLength;
             }
+            /* A resumed download must carry on exactly where it was asked to;
+               the file length is the total from Content-Range */
+            else if (downloader.rangeStart != 0 && 206 == pRspMsg->httpStatusCode
+                    && pRspMsg->fieldContentRangeValid
+                    && pRspMsg->fieldContentRangeStart == downloader.rangeStart
+                    && pRspMsg->fieldContentRangeTotal != 0)
+            {
+                downloader.downloadFileSize = pRspMsg->fieldContentRangeTotal;
+                field_content_length = pRspMsg->fieldContentRangeTotal;
+            }
             else
             {
                 SYS_CONSOLE_PRINT("SYS_OTA : Request rejected by client :code: %d \r\n", pRspMsg->httpStatusCode);
@@ -95,8 +109,25 @@ static void DOWNLOADER_HTTPClient_EventHandler(HTTP_CLIENT_HANDLE httpHandle, ui
             break;
         }
 
+        case HTTP_CLIENT_EVENT_PAYLOAD_BUFFER:
+        {
+            /* The payload is received straight into the ring */
+            HTTP_CLIENT_PAYLOAD_BUFFER *pBuffer = (HTTP_CLIENT_PAYLOAD_BUFFER*)pEventData;
+            if (downloader.buf != NULL)
+            {
+                pBuffer->bufferLength = OTA_RING_Reserve(&downloader.ring, &pBuffer->pBuffer);
+            }
+            break;
+        }
+
         case HTTP_CLIENT_EVENT_PAYLOAD_RECEIVED:
         {
+            /* Nothing of a rejected response is kept, not even what came
+               in with its headers */
+            if (downloader.downloadFileSize == 0)
+            {
+                break;
+            }
             downloader.downloadedSize += eventDataLength;
             DOWNLOADER_BufPut(pEventData, eventDataLength);           
             break;
@@ -156,8 +187,7 @@ static int DOWNLOADER_HTTPClient_Abort(void)
 }
 static int DOWNLOADER_BufPut(uint8_t *buf, int size)
 {
-    int r = size;
-    int copyLen = 0;
+    uint8_t *span;
     
     if (downloader.buf == NULL)
     {
@@ -167,98 +197,25 @@ static int DOWNLOADER_BufPut(uint8_t *buf, int size)
     #ifdef SYS_OTA_APPDEBUG_ENABLED
     SYS_CONSOLE_PRINT("SYS_OTA : PUT:%d\r\n", size);
     #endif
-    if (size > (DOWNLOADER_BUFFER_SIZE - downloader.bufLevel))
+    /* Payload received in place only has to be handed over; the rest (what
+       came in with the headers) is copied */
+    if (OTA_RING_Reserve(&downloader.ring, &span) >= size && span == buf)
     {
-        SYS_CONSOLE_PRINT("SYS_OTA : Buffer over-run %d - %d\r\n",
-        DOWNLOADER_BUFFER_SIZE, downloader.bufLevel);
-        return -1;
+        OTA_RING_Commit(&downloader.ring, size);
     }
-        
-    downloader.bufLevel += size;
-    if (downloader.bufIn < downloader.bufOut)
-    {
-        if ((DOWNLOADER_BUFFER_SIZE - downloader.bufIn) > size)
-        {
-            memcpy(&downloader.buf[downloader.bufIn], buf, size);
-            downloader.bufIn += size;
-            
-            if (downloader.bufIn == DOWNLOADER_BUFFER_SIZE)
-            {
-                downloader.bufIn = 0;
-            }
-            return r;
-        }
-        copyLen = DOWNLOADER_BUFFER_SIZE - downloader.bufIn; 
-        memcpy(&downloader.buf[downloader.bufIn], buf, copyLen);
-        downloader.bufIn = 0;
-        size -= copyLen;
-        buf += copyLen;
-    }
-    
-    memcpy(&downloader.buf[downloader.bufIn], buf, size);
-    downloader.downloadPause = 1;
-    HTTP_Client_SetRxReady(downloader.httpHandle, false);
-    return r;
-}
-
-static int DOWNLOADER_BufGet(uint8_t *buf, int reqSize)
-{
-    int r = 0;
-    //SYS_CONSOLE_PRINT("reqSize : %d \n\r",reqSize);
-    if (downloader.buf == NULL)
+    else if (OTA_RING_Write(&downloader.ring, buf, size) != size)
     {
+        SYS_CONSOLE_PRINT("SYS_OTA : Buffer over-run %d - %d\r\n",
+        DOWNLOADER_BUFFER_SIZE, OTA_RING_Level(&downloader.ring));
         return -1;
     }
-
-    if (downloader.bufLevel != 0)
-    {
-        int copyLen = 0;
-        
-        
-        if (reqSize > downloader.bufLevel)
-        {
-            reqSize = downloader.bufLevel;
-        }
-        
-        r = reqSize;
-        
-        if (downloader.bufOut > downloader.bufIn)
-        {
-            copyLen = reqSize;
-            if ((DOWNLOADER_BUFFER_SIZE - downloader.bufOut) < reqSize)
-            {
-                copyLen = DOWNLOADER_BUFFER_SIZE - downloader.bufOut;
-            }
-            
-            memcpy(buf, &downloader.buf[downloader.bufOut], copyLen);
-            downloader.bufOut   += copyLen;
-            
-            if (downloader.bufOut == DOWNLOADER_BUFFER_SIZE)
-            {
-                downloader.bufOut = 0;
-            }
-            buf     += copyLen;
-            reqSize -= copyLen;
-        }
-        
-        if (reqSize)
-        {
-            memcpy(buf, &downloader.buf[downloader.bufOut], reqSize);
-            downloader.bufOut += reqSize;
-        }
-        
-        downloader.bufLevel -= r;
     
-        if (downloader.bufLevel == 0)
-        {
-            downloader.bufOut = 0;
-            downloader.bufIn  = 0;
-            downloader.downloadPause = 0;
-            HTTP_Client_SetRxReady(downloader.httpHandle, true);
-        }
+    if (!downloader.rxPaused && OTA_RING_Space(&downloader.ring) < DOWNLOADER_RX_PAUSE_SPACE)
+    {
+        downloader.rxPaused = true;
+        HTTP_Client_SetRxReady(downloader.httpHandle, false);
     }
-    
-    return r;
+    return size;
 }
 
 void DOWNLOADER_Initialize(void)
@@ -276,9 +233,16 @@ void DOWNLOADER_Deinitialize(void)
 }
 
 DRV_HANDLE DOWNLOADER_Open(void * param)
+{
+    return DOWNLOADER_OpenRange(param, 0);
+}
+
+DRV_HANDLE DOWNLOADER_OpenRange(void * param, uint32_t offset)
 {
     downloader.httpHandle = HTTP_CLIENT_HANDLE_INVALID;
     downloader.httpErrorState = HTTP_CLIENT_ERROR_NONE;
+    downloader.rangeStart = offset;
+    downloader.downloadFileSize = 0;
         
     downloader.buf = (uint8_t *)OSAL_Malloc(DOWNLOADER_BUFFER_SIZE);
     if (downloader.buf == NULL)
@@ -287,16 +251,18 @@ DRV_HANDLE DOWNLOADER_Open(void * param)
         
         return DRV_HANDLE_INVALID;
     }
-    downloader.bufIn         = 0;
-    downloader.bufOut        = 0;
-    downloader.bufLevel      = 0;
-    downloader.downloadPause = 0;
+    OTA_RING_Init(&downloader.ring, downloader.buf, DOWNLOADER_BUFFER_SIZE);
+    downloader.rxPaused = false;
     
     downloader.httpHandle = HTTP_Client_Get(param, DOWNLOADER_HTTPClient_EventHandler, (uintptr_t) NULL);
     if (downloader.httpHandle == HTTP_CLIENT_HANDLE_INVALID)
     {
         return DRV_HANDLE_INVALID;
     }
+    if (offset != 0)
+    {
+        HTTP_Client_SetRange(downloader.httpHandle, offset);
+    }
 
     return (DRV_HANDLE)&downloader;
 
@@ -308,11 +274,43 @@ int DOWNLOADER_Read(DRV_HANDLE handle, unsigned char* buf, int bufSize)
     {
         return -1;
     }
-    if (downloader.httpHandle == HTTP_CLIENT_HANDLE_INVALID)
+    if (downloader.buf == NULL)
+    {
+        return -1;
+    }
+    /* What was received before the connection closed can still be read */
+    if (OTA_RING_Level(&downloader.ring) == 0)
+    {
+        return (downloader.httpHandle == HTTP_CLIENT_HANDLE_INVALID) ? -1 : 0;
+    }
+    return OTA_RING_Read(&downloader.ring, buf, bufSize);
+}
+
+int DOWNLOADER_Peek(DRV_HANDLE handle, int offset, int size, unsigned char** buf)
+{
+    if (handle == DRV_HANDLE_INVALID || handle != (DRV_HANDLE)&downloader || downloader.buf == NULL)
     {
         return -1;
     }
-    return DOWNLOADER_BufGet(buf, bufSize);
+    /* A span across the end of the ring never becomes contiguous */
+    if (OTA_RING_Peek(&downloader.ring, offset, buf) >= size)
+    {
+        return size;
+    }
+    if (downloader.httpHandle == HTTP_CLIENT_HANDLE_INVALID
+            || ((downloader.ring.tail + offset) & downloader.ring.mask) + size > DOWNLOADER_BUFFER_SIZE)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+void DOWNLOADER_Release(DRV_HANDLE handle, int size)
+{
+    if (handle != DRV_HANDLE_INVALID && handle == (DRV_HANDLE)&downloader && downloader.buf != NULL)
+    {
+        OTA_RING_Release(&downloader.ring, size);
+    }
 }
 
 void DOWNLOADER_Close(DRV_HANDLE handle)
@@ -326,7 +324,7 @@ void DOWNLOADER_Close(DRV_HANDLE handle)
             OSAL_Free(downloader.buf);
         }
         downloader.buf = NULL;
-        downloader.downloadPause = 0;
+        downloader.rxPaused = false;
     }
 }
 
@@ -334,9 +332,12 @@ void DOWNLOADER_Tasks(void)
 {
     if (downloader.httpHandle != HTTP_CLIENT_HANDLE_INVALID)
     {
-        if (downloader.downloadPause == 0)
+        /* The connection is still served while paused; it only stops reading */
+        if (downloader.rxPaused && OTA_RING_Level(&downloader.ring) <= DOWNLOADER_RX_RESUME_LEVEL)
         {
-            downloader.httpHandle = HTTP_Client_Task(downloader.httpHandle);
+            downloader.rxPaused = false;
+            HTTP_Client_SetRxReady(downloader.httpHandle, true);
         }
+        downloader.httpHandle = HTTP_Client_Task(downloader.httpHandle);
     }
 }
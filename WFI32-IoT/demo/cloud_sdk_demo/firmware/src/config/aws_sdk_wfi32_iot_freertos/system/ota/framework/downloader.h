@@ -59,6 +59,13 @@ extern "C" {
 #endif
 
 //#define APP_USR_CONTEXT 1
+
+/* Download buffer, a power of two. The image is buffered from its start, so
+   each flash sector of it lies in one piece and can be programmed straight
+   from the buffer */
+#ifndef DOWNLOADER_BUFFER_SIZE
+#define DOWNLOADER_BUFFER_SIZE 16384
+#endif
 // *****************************************************************************
 /*
   Function:
@@ -159,6 +166,34 @@ void DOWNLOADER_Deinitialize(void);
 DRV_HANDLE DOWNLOADER_Open(void * param);
 
 
+// *****************************************************************************
+/*
+  Function:
+    DRV_HANDLE DOWNLOADER_OpenRange(void * param, uint32_t offset);
+
+  Summary:
+    Open OTA Image Downloader library part way into the image.
+
+  Description:
+    As DOWNLOADER_Open, but asks the server for the image from offset on
+    (HTTP Range request), to resume an interrupted download. The download
+    fails unless the server answers with exactly that range. The file size
+    reported is still the size of the whole image.
+
+  Precondition:
+    None.
+
+  Parameters:
+    param  - Image URL.
+    offset - First byte of the image to download; 0 downloads all of it.
+
+  Returns:
+    Driver handle.
+*/
+// *****************************************************************************
+DRV_HANDLE DOWNLOADER_OpenRange(void * param, uint32_t offset);
+
+
 // *****************************************************************************
 /*
   Function:
@@ -184,6 +219,64 @@ DRV_HANDLE DOWNLOADER_Open(void * param);
 // *****************************************************************************  
 int DOWNLOADER_Read(DRV_HANDLE handle, unsigned char* buffer, int maxsize);
 
+// *****************************************************************************
+/*
+  Function:
+    int DOWNLOADER_Peek(DRV_HANDLE handle, int offset, int size,
+                        unsigned char** buffer);
+
+  Summary:
+    Look at N bytes of the OTA image stream where they are buffered.
+
+  Description:
+    Finds size bytes of the stream, offset bytes past the oldest byte not
+    released yet, without copying or consuming them. The bytes stay valid,
+    and are not overwritten, until DOWNLOADER_Release gives them back; the
+    caller may go on peeking further in the meantime.
+
+  Precondition:
+    DOWNLOADER_Open.
+
+  Parameters:
+    handle - Driver handle.
+    offset - Bytes to skip.
+    size   - Bytes wanted; the span must not cross the end of the
+             DOWNLOADER_BUFFER_SIZE buffer, which a sector aligned span of
+             the image never does.
+    buffer - Receives the start of the bytes.
+
+  Returns:
+    size once all of them are buffered, 0 while they are still coming in,
+    -1 if the download ended before them.
+*/
+// *****************************************************************************
+int DOWNLOADER_Peek(DRV_HANDLE handle, int offset, int size, unsigned char** buffer);
+
+// *****************************************************************************
+/*
+  Function:
+    void DOWNLOADER_Release(DRV_HANDLE handle, int size);
+
+  Summary:
+    Consume N bytes of the OTA image stream.
+
+  Description:
+    Frees the oldest size bytes looked at with DOWNLOADER_Peek, so more of
+    the image can be received into their place.
+
+  Precondition:
+    DOWNLOADER_Open.
+
+  Parameters:
+    handle - Driver handle.
+    size   - Bytes to release.
+
+  Returns:
+    None.
+*/
+// *****************************************************************************
+void DOWNLOADER_Release(DRV_HANDLE handle, int size);
+
 // *****************************************************************************
 /*
   Function:
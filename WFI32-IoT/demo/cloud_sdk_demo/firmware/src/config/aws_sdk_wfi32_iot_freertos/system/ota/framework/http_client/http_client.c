@@ -37,6 +37,7 @@
 #define HTTP_CLIENT_MAX_PATH_LEN        256
 #define HTTP_CLIENT_BUFFER_SIZE         1460
 #define HTTP_CLIENT_SOCKET_CONN_TIMEOUT 360000
+#define HTTP_CLIENT_SOCKET_RECV_TIMEOUT 30000
 #define HTTP_TCP_RX_WINDOW_SIZE         11680
 
 typedef enum {
@@ -81,6 +82,7 @@ typedef struct {
     uint32_t lastDNSReqTimeMs;
     uint32_t socketTimer;
     bool clientRxReady;
+    size_t rangeStart;
 } HTTP_CLIENT_DCPT;
 
 
@@ -216,6 +218,36 @@ bool HTTP_Client_ParseURI(const char *pURIText, URI *pURI) {
     return true;
 }
 
+static void HTTP_Client_ParseContentRange(char *pValue, int valueLength, HTTP_CLIENT_RESPONSE_MSG *pRsp) {
+    char *pEnd = &pValue[valueLength];
+    char *p;
+
+    // Content-Range = "bytes" SP first-byte-pos "-" last-byte-pos "/" ( complete-length / "*" )
+
+    if ((valueLength < 6) || (0 != strncmp(pValue, "bytes ", 6))) {
+        return;
+    }
+
+    p = &pValue[6];
+
+    if ((p >= pEnd) || (*p < '0') || (*p > '9')) {
+        return;
+    }
+
+    pRsp->fieldContentRangeStart = strtoul(p, &p, 10);
+
+    while ((p < pEnd) && ('/' != *p)) {
+        p++;
+    }
+
+    if (++p >= pEnd) {
+        return;
+    }
+
+    pRsp->fieldContentRangeTotal = ('*' == *p) ? 0 : strtoul(p, NULL, 10);
+    pRsp->fieldContentRangeValid = true;
+}
+
 static bool HTTP_Client_ParseHeaderFields(char *pHeaders, size_t headerLength, HTTP_CLIENT_RESPONSE_MSG *pRsp) {
     char *pField;
 
@@ -299,6 +331,8 @@ static bool HTTP_Client_ParseHeaderFields(char *pHeaders, size_t headerLength, H
 
         if ((14 == fieldNameLength) && (0 == strncmp(pFieldName, "Content-Length", 14))) {
             pRsp->fieldContentLength = strtoul(pFieldValue, NULL, 10);
+        } else if ((13 == fieldNameLength) && (0 == strncmp(pFieldName, "Content-Range", 13))) {
+            HTTP_Client_ParseContentRange(pFieldValue, fieldValueLength, pRsp);
         }
     }
 
@@ -695,10 +729,31 @@ bool HTTP_Client_SetRxReady(HTTP_CLIENT_HANDLE handle, bool ready) {
         return false;
     }
 
+    // The time spent paused does not count towards the receive timeout
+
+    if ((true == ready) && (false == pDcpt->clientRxReady)) {
+        pDcpt->socketTimer = HttpGetSysTimeMs();
+    }
+
     pDcpt->clientRxReady = ready;
     return true;
 }
 
+bool HTTP_Client_SetRange(HTTP_CLIENT_HANDLE handle, size_t rangeStart) {
+    HTTP_CLIENT_DCPT *pDcpt = (HTTP_CLIENT_DCPT*) handle;
+
+    if ((NULL == pDcpt) || (false == pDcpt->isValid)) {
+        return false;
+    }
+
+    if (pDcpt->state >= HTTP_CLIENT_STATE_REQUEST_SENT) {
+        return false;
+    }
+
+    pDcpt->rangeStart = rangeStart;
+    return true;
+}
+
 HTTP_CLIENT_HANDLE HTTP_Client_Task(HTTP_CLIENT_HANDLE handle) {
     HTTP_CLIENT_DCPT *pDcpt = (HTTP_CLIENT_DCPT*) handle;
 
@@ -797,7 +852,11 @@ HTTP_CLIENT_HANDLE HTTP_Client_Task(HTTP_CLIENT_HANDLE handle) {
             if (NULL != pSendBuffer) {
                 int sendLength;
 
-                sendLength = snprintf(pSendBuffer, HTTP_CLIENT_BUFFER_SIZE, "GET %s HTTP/1.1\r\nHost: %s\r\n\r\n", pDcpt->uri.path, pDcpt->uri.authorityHost);
+                if (0 != pDcpt->rangeStart) {
+                    sendLength = snprintf(pSendBuffer, HTTP_CLIENT_BUFFER_SIZE, "GET %s HTTP/1.1\r\nHost: %s\r\nRange: bytes=%u-\r\n\r\n", pDcpt->uri.path, pDcpt->uri.authorityHost, (unsigned int) pDcpt->rangeStart);
+                } else {
+                    sendLength = snprintf(pSendBuffer, HTTP_CLIENT_BUFFER_SIZE, "GET %s HTTP/1.1\r\nHost: %s\r\n\r\n", pDcpt->uri.path, pDcpt->uri.authorityHost);
+                }
 
                 if (NET_PRES_SocketWriteIsReady(pDcpt->socket, sendLength, 0)) {
                     if (0 == NET_PRES_SocketWrite(pDcpt->socket, pSendBuffer, sendLength)) {
@@ -805,6 +864,7 @@ HTTP_CLIENT_HANDLE HTTP_Client_Task(HTTP_CLIENT_HANDLE handle) {
                         pDcpt->state = HTTP_CLIENT_STATE_CLOSE;
                     } else {
                         pDcpt->state = HTTP_CLIENT_STATE_REQUEST_SENT;
+                        pDcpt->socketTimer = HttpGetSysTimeMs();
                         if (NULL != pDcpt->pClientEventHandler) {
                             pDcpt->pClientEventHandler((HTTP_CLIENT_HANDLE) pDcpt, pDcpt->eventHandle, HTTP_CLIENT_EVENT_GET_SENT, pSendBuffer, sendLength);
                         }
@@ -824,14 +884,47 @@ HTTP_CLIENT_HANDLE HTTP_Client_Task(HTTP_CLIENT_HANDLE handle) {
             uint16_t readDataLength;
 
             while (NET_PRES_SocketReadIsReady(pDcpt->socket) > 0) {
+                HTTP_CLIENT_PAYLOAD_BUFFER payloadBuffer = {pDcpt->recvBuffer, HTTP_CLIENT_BUFFER_SIZE};
+
                 if (pDcpt->clientRxReady == false) {
                     break;
                 }
 
-                readDataLength = NET_PRES_SocketRead(pDcpt->socket, pDcpt->recvBuffer, HTTP_CLIENT_BUFFER_SIZE);
+                /* Once the headers are in, the client may take the payload
+                 into its own buffer rather than have it copied out of ours */
+
+                if ((true == pDcpt->isResponseComplete) && (NULL != pDcpt->pClientEventHandler)) {
+                    pDcpt->pClientEventHandler((HTTP_CLIENT_HANDLE) pDcpt, pDcpt->eventHandle, HTTP_CLIENT_EVENT_PAYLOAD_BUFFER, &payloadBuffer, sizeof (HTTP_CLIENT_PAYLOAD_BUFFER));
+
+                    if (0 == payloadBuffer.bufferLength) {
+                        break;
+                    }
+
+                    if (payloadBuffer.bufferLength > UINT16_MAX) {
+                        payloadBuffer.bufferLength = UINT16_MAX;
+                    }
+                }
+
+                readDataLength = NET_PRES_SocketRead(pDcpt->socket, payloadBuffer.pBuffer, payloadBuffer.bufferLength);
 
                 if (readDataLength > 0) {
-                    HTTP_Client_SocketReceveProcess(handle, pDcpt->recvBuffer, readDataLength);
+                    pDcpt->socketTimer = HttpGetSysTimeMs();
+                    HTTP_Client_SocketReceveProcess(handle, payloadBuffer.pBuffer, readDataLength);
+                }
+            }
+
+            /* A connection that closes or stalls before the whole response
+             has arrived is reported, so the caller can retry or resume it */
+
+            if ((HTTP_CLIENT_STATE_REQUEST_SENT == pDcpt->state) && (true == pDcpt->clientRxReady)) {
+                if (false == NET_PRES_SocketIsConnected(pDcpt->socket)) {
+                    pDcpt->errorCode = HTTP_CLIENT_ERROR_RECV_FAILED;
+                    pDcpt->state = HTTP_CLIENT_STATE_CLOSE;
+                    SYS_CONSOLE_PRINT("Socket closed by peer\n\r");
+                } else if ((HttpGetSysTimeMs() - pDcpt->socketTimer) > HTTP_CLIENT_SOCKET_RECV_TIMEOUT) {
+                    pDcpt->errorCode = HTTP_CLIENT_ERROR_RECV_FAILED;
+                    pDcpt->state = HTTP_CLIENT_STATE_CLOSE;
+                    SYS_CONSOLE_PRINT("Socket receive timeout\n\r");
                 }
             }
 
@@ -51,7 +51,8 @@ typedef enum
     HTTP_CLIENT_EVENT_PAYLOAD_RECEIVED,
     HTTP_CLIENT_EVENT_PAYLOAD_END,
     HTTP_CLIENT_EVENT_ERROR,
-    HTTP_CLIENT_EVENT_CLOSE
+    HTTP_CLIENT_EVENT_CLOSE,
+    HTTP_CLIENT_EVENT_PAYLOAD_BUFFER
 } HTTP_CLIENT_EVENTS;
 
 typedef enum
@@ -72,13 +73,28 @@ typedef struct
     uint8_t     httpVerMin;
     uint16_t    httpStatusCode;
     size_t      fieldContentLength;
+    // Content-Range of a 206 response; the total is 0 if the server sent "*"
+    bool        fieldContentRangeValid;
+    size_t      fieldContentRangeStart;
+    size_t      fieldContentRangeTotal;
 } HTTP_CLIENT_RESPONSE_MSG;
 
+// Event data of HTTP_CLIENT_EVENT_PAYLOAD_BUFFER, sent before each read of the
+// payload. A handler that sets pBuffer has the payload read straight into it,
+// at most bufferLength bytes; a length of 0 holds the payload back for now
+typedef struct
+{
+    uint8_t     *pBuffer;
+    size_t      bufferLength;
+} HTTP_CLIENT_PAYLOAD_BUFFER;
+
 typedef void (*HTTP_CLIENT_EVENT_HANDLER)(HTTP_CLIENT_HANDLE handle, uintptr_t eventHandle, HTTP_CLIENT_EVENTS event, void *pEventData, size_t eventDataLength);
 
 void HTTP_Client_Init(void);
 HTTP_CLIENT_HANDLE HTTP_Client_Get(const char *pGetURL, HTTP_CLIENT_EVENT_HANDLER pClientEventHandler, uintptr_t eventHandle);
 HTTP_CLIENT_HANDLE HTTP_Client_Open(HTTP_CLIENT_EVENT_HANDLER pClientEventHandler, uintptr_t eventHandle);
+// Asks for the resource from rangeStart on; call after HTTP_Client_Get, before the first HTTP_Client_Task
+bool HTTP_Client_SetRange(HTTP_CLIENT_HANDLE handle, size_t rangeStart);
 void HTTP_Client_Close(HTTP_CLIENT_HANDLE handle);
 void HTTP_Client_SocketReceveProcess(HTTP_CLIENT_HANDLE handle, uint8_t *pRecvBuffer, size_t recvBufferLength);
 void HTTP_Client_Cancel(HTTP_CLIENT_HANDLE handle);
@@ -57,8 +57,24 @@ typedef struct
     uint32_t buf[NVM_FLASH_PAGESIZE/sizeof(uint32_t)];
 }INT_FLASH_DATA;
 
+typedef struct
+{
+    bool        erase;
+    uint32_t    addr;
+    uint8_t*    buf;
+    uint32_t    len;
+}INT_FLASH_JOB;
+
 static INT_FLASH_DATA  __attribute__((coherent, aligned(32))) int_flash;
-static volatile bool OpDone = false;
+static volatile bool OpDone = true;
+
+/* Queued jobs; tickets are issued from head and retired at tail */
+static INT_FLASH_JOB flash_queue[INT_FLASH_QUEUE_DEPTH];
+static uint32_t flash_queue_head = 0;
+static uint32_t flash_queue_tail = 0;
+static bool flash_queue_error = false;
+/* Whether the operation last started by the queue is a page erase */
+static bool flash_queue_erasing = false;
 
 #if (OTA_NVM_INT_CALLBACK_ENABLE == false)
 OSAL_MUTEX_HANDLE_TYPE mutex_nvm_g;
@@ -203,6 +219,159 @@ bool INT_Flash_Busy()
     return false;
 }
 
+//---------------------------------------------------------------------------
+static bool INT_Flash_OpBusy(void)
+{
+#if (OTA_NVM_INT_CALLBACK_ENABLE == true)
+    return (OpDone == false);
+#else
+    return NVM_IsBusy();
+#endif
+}
+
+//---------------------------------------------------------------------------
+/* Starts the next page erase or row write of a job and advances it */
+static bool INT_Flash_OpStart(INT_FLASH_JOB* job)
+{
+    bool started;
+    uint32_t step = job->erase ? NVM_FLASH_PAGESIZE : NVM_FLASH_ROWSIZE;
+
+#if (OTA_NVM_INT_CALLBACK_ENABLE == true)
+    OpDone = false;
+    if (job->erase)
+    {
+        started = NVM_PageErase(job->addr);
+    }
+    else
+    {
+        memcpy(int_flash.buf, job->buf, NVM_FLASH_ROWSIZE);
+        started = NVM_RowWrite(int_flash.buf, job->addr);
+    }
+    if (started == false)
+    {
+        OpDone = true;
+    }
+#else
+    if (OSAL_MUTEX_Lock(&mutex_nvm_g, OSAL_WAIT_FOREVER) != OSAL_RESULT_TRUE)
+    {
+        return false;
+    }
+    /* Another client may have started an operation since the caller checked */
+    while( NVM_IsBusy() ) ;
+    if (job->erase)
+    {
+        started = NVM_PageErase(job->addr);
+    }
+    else
+    {
+        memcpy(int_flash.buf, job->buf, NVM_FLASH_ROWSIZE);
+        started = NVM_RowWrite(int_flash.buf, job->addr);
+    }
+    OSAL_MUTEX_Unlock(&mutex_nvm_g);
+#endif
+
+    if (started)
+    {
+        flash_queue_erasing = job->erase;
+        if (job->erase == false)
+        {
+            job->buf += step;
+        }
+        job->addr += step;
+        job->len  -= step;
+    }
+    return started;
+}
+
+//---------------------------------------------------------------------------
+static uint32_t INT_Flash_Queue(bool erase, uint32_t addr, uint8_t* buf, uint32_t len)
+{
+    INT_FLASH_JOB* job;
+
+    if (flash_queue_error || (flash_queue_head - flash_queue_tail) == INT_FLASH_QUEUE_DEPTH)
+    {
+        return 0;
+    }
+
+    job = &flash_queue[flash_queue_head % INT_FLASH_QUEUE_DEPTH];
+    job->erase = erase;
+    job->addr  = addr + NVM_FLASH_START_ADDRESS;
+    job->buf   = buf;
+    job->len   = len;
+
+    /* Tickets start at 1, so callers can use 0 for "nothing queued" */
+    return ++flash_queue_head;
+}
+
+//---------------------------------------------------------------------------
+uint32_t INT_Flash_QueueErase(uint32_t addr, uint32_t len)
+{
+    return INT_Flash_Queue(true, addr, NULL, len);
+}
+
+//---------------------------------------------------------------------------
+uint32_t INT_Flash_QueueWrite(uint32_t addr, uint8_t* buf, uint32_t len)
+{
+    return INT_Flash_Queue(false, addr, buf, len);
+}
+
+//---------------------------------------------------------------------------
+bool INT_Flash_QueueDone(uint32_t ticket)
+{
+    return ((int32_t)(flash_queue_tail - ticket) >= 0);
+}
+
+//---------------------------------------------------------------------------
+INT_FLASH_QUEUE_STATUS INT_Flash_QueueTasks(void)
+{
+    INT_FLASH_JOB* job;
+
+    if (flash_queue_error)
+    {
+        return INT_FLASH_QUEUE_ERROR;
+    }
+
+    while (flash_queue_tail != flash_queue_head)
+    {
+        /* A row write is short next to the period this is called at, so it
+           is waited for and a sector is programmed in one call; a page erase
+           is left to complete in the background */
+        if (INT_Flash_OpBusy())
+        {
+            if (flash_queue_erasing)
+            {
+                return INT_FLASH_QUEUE_BUSY;
+            }
+            while (INT_Flash_OpBusy()) ;
+        }
+
+        job = &flash_queue[flash_queue_tail % INT_FLASH_QUEUE_DEPTH];
+        if (job->len == 0)
+        {
+            /* The last page or row of this job has completed */
+            flash_queue_tail++;
+            continue;
+        }
+
+        if (INT_Flash_OpStart(job) == false)
+        {
+            flash_queue_error = true;
+            return INT_FLASH_QUEUE_ERROR;
+        }
+    }
+    return INT_FLASH_QUEUE_IDLE;
+}
+
+//---------------------------------------------------------------------------
+void INT_Flash_QueueFlush(void)
+{
+    /* Let the page or row in progress finish before its job is dropped */
+    while (INT_Flash_OpBusy()) ;
+
+    flash_queue_tail = flash_queue_head;
+    flash_queue_error = false;
+}
+
 //---------------------------------------------------------------------------
 uint32_t INT_Flash_Capacity(void)
 {
@@ -51,6 +51,7 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 
 //#include "driver/driver_common.h"
 #include <stdbool.h>
+#include <stdint.h>
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -58,6 +59,18 @@ extern "C" {
 
 
 #define     OTA_NVM_INT_CALLBACK_ENABLE     false
+
+/* Number of erase and write jobs that can be queued */
+#ifndef INT_FLASH_QUEUE_DEPTH
+#define     INT_FLASH_QUEUE_DEPTH           4
+#endif
+
+typedef enum
+{
+    INT_FLASH_QUEUE_IDLE = 0,
+    INT_FLASH_QUEUE_BUSY,
+    INT_FLASH_QUEUE_ERROR
+} INT_FLASH_QUEUE_STATUS;
 // *****************************************************************************
 /* Function:
     INT_Flash_Initialize(void);
@@ -195,6 +208,77 @@ bool INT_Flash_Erase(uint32_t addr, uint32_t pages);
 //DRV_CLIENT_STATUS INT_Flash_ClientStatus(void);
 bool INT_Flash_Busy(void);
 
+//*************************************************************************
+/* Function:
+    uint32_t INT_Flash_QueueErase(uint32_t addr, uint32_t len)
+    uint32_t INT_Flash_QueueWrite(uint32_t addr, uint8_t* buf, uint32_t len)
+
+  Summary:
+    Queue an erase or write without waiting for the flash.
+
+  Description:
+    The job is carried out page by page (erase) or row by row (write) by
+    INT_Flash_QueueTasks, in the order jobs were queued, so a sector can be
+    programmed while the caller fills the next one. buf must not change until
+    the write job is done.
+
+  Note:
+    addr is the same offset as for INT_Flash_Write and INT_Flash_Erase. len
+    must be a multiple of the page size (erase) or row size (write).
+
+  Returns:
+    A ticket for INT_Flash_QueueDone, or 0 if the queue is full or has failed.
+*/
+uint32_t INT_Flash_QueueErase(uint32_t addr, uint32_t len);
+uint32_t INT_Flash_QueueWrite(uint32_t addr, uint8_t* buf, uint32_t len);
+
+//*************************************************************************
+/* Function:
+    bool INT_Flash_QueueDone(uint32_t ticket)
+
+  Summary:
+    Check whether a queued job has completed.
+
+  Returns:
+    true once the job and all jobs queued before it have completed. Ticket 0
+    is always done.
+*/
+bool INT_Flash_QueueDone(uint32_t ticket);
+
+//*************************************************************************
+/* Function:
+    INT_FLASH_QUEUE_STATUS INT_Flash_QueueTasks(void)
+
+  Summary:
+    Advance the queued jobs.
+
+  Description:
+    Starts the next page erase or row write whenever the previous one has
+    completed. Row writes are waited for, so the rows of a job are all
+    written in one call; a page erase returns while it is in progress. Must
+    be called periodically while jobs are queued.
+
+  Returns:
+    INT_FLASH_QUEUE_IDLE - All queued jobs have completed.
+    INT_FLASH_QUEUE_BUSY - Jobs are still in progress.
+    INT_FLASH_QUEUE_ERROR - An operation failed; nothing more is started
+                            until INT_Flash_QueueFlush is called.
+*/
+INT_FLASH_QUEUE_STATUS INT_Flash_QueueTasks(void);
+
+//*************************************************************************
+/* Function:
+    void INT_Flash_QueueFlush(void)
+
+  Summary:
+    Drop all queued jobs.
+
+  Description:
+    Waits for the operation in progress, if any, then discards the remaining
+    jobs and clears the error state.
+*/
+void INT_Flash_QueueFlush(void);
+
 //*************************************************************************
 /* Function:
     uint32_t INT_Flash_Capacity(void)
@@ -49,6 +49,10 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 #include "osal/osal.h"
 #include "crypto/crypto.h"
 #include "system/ota/framework/csv/csv.h"
+#ifdef SYS_OTA_PATCH_ENABLE
+#include <ctype.h>
+#include "system/ota/framework/ota_patch.h"
+#endif
 
 #define OTA_DEBUG   1
 #define OTA_MAIN_CODE   2
@@ -130,6 +134,10 @@ static OTA_DATA __attribute__((coherent, aligned(128))) ota;
 
 static OTA_PARAMS ota_params;
 
+#ifdef SYS_OTA_PATCH_ENABLE
+static OTA_PATCH_STREAM ota_patch;
+#endif
+
 extern size_t field_content_length;
 
 #ifdef SYS_OTA_SECURE_BOOT_ENABLED
@@ -339,6 +347,79 @@ void OTA_StoreFactoryImageSignature(void *buf) {
     None
  */
 //---------------------------------------------------------------------------
+#ifdef SYS_OTA_PATCH_ENABLE
+void OTA_GetPatchStatus(OTA_PARAMS *result) {
+    result->patch_progress_status = OTA_PatchProgressStatus();
+}
+
+// *****************************************************************************
+// *****************************************************************************
+// Section:  To convert a manifest digest
+// *****************************************************************************
+// *****************************************************************************
+//---------------------------------------------------------------------------
+/*
+  static bool OTA_DigestFromString(const char *str, uint8_t *digest)
+
+  Description:
+   To convert a hex digest string from the manifest to binary
+
+  Task Parameters:
+    str    - 64 hex characters
+    digest - 32 byte buffer
+  Return:
+    true - if str is a valid digest
+ */
+//---------------------------------------------------------------------------
+static bool OTA_DigestFromString(const char *str, uint8_t *digest) {
+    char hex[3] = {0};
+    int i;
+
+    for (i = 0; i < OTA_CRYPT_SHA256_DIGEST_SIZE; i++) {
+        /* Stops at the terminator of a short string */
+        if (!isxdigit((unsigned char) str[2 * i]) || !isxdigit((unsigned char) str[2 * i + 1])) {
+            return false;
+        }
+        memcpy(hex, &str[2 * i], 2);
+        digest[i] = (uint8_t) strtol(hex, NULL, 16);
+    }
+    return true;
+}
+
+// *****************************************************************************
+// *****************************************************************************
+// Section:  To search base image of a patch
+// *****************************************************************************
+// *****************************************************************************
+//---------------------------------------------------------------------------
+/*
+  SYS_STATUS OTA_Search_ImageVersion(uint32_t ver, char *digest)
+
+  Description:
+   A patch is applied to the running image, so that is the only base
+   version which can be found
+
+  Task Parameters:
+    ver    - base version from the manifest
+    digest - base image digest from the manifest
+  Return:
+    SYS_STATUS_READY if the running image is that version
+ */
+//---------------------------------------------------------------------------
+SYS_STATUS OTA_Search_ImageVersion(uint32_t ver, char *digest) {
+    uint8_t base_digest[OTA_CRYPT_SHA256_DIGEST_SIZE];
+
+    if (ver != SYS_OTA_APP_VER_NUM || !OTA_DigestFromString(digest, base_digest)) {
+        return SYS_STATUS_ERROR;
+    }
+    /* The header only carries the size and digest of an image installed by OTA */
+    if (APP_IMG_BOOT_CTL->sz == 0 || APP_IMG_BOOT_CTL->sz == 0xFFFFFFFF
+            || memcmp(base_digest, (const void *) APP_IMG_BOOT_CTL->digest, sizeof (base_digest)) != 0) {
+        return SYS_STATUS_ERROR;
+    }
+    return SYS_STATUS_READY;
+}
+#endif
 
 // *****************************************************************************
 // *****************************************************************************
@@ -503,6 +584,104 @@ static SYS_STATUS OTA_Task_FactoryReset(void) {
     return SYS_STATUS_BUSY;
 }
 
+#ifdef SYS_OTA_PATCH_ENABLE
+// *****************************************************************************
+// *****************************************************************************
+// Section: Download and apply a patch
+// *****************************************************************************
+// *****************************************************************************
+//---------------------------------------------------------------------------
+/*
+  SYS_STATUS OTA_Task_DownloadPatch(void)
+  
+  Description:
+    Rebuild the new image from the running one and the patch while the
+    patch downloads. The patch is never stored; the image is written to
+    the staging slot and checked against the target digest.
+  
+  Task Parameters:
+    None
+  
+  Return:
+    A SYS_STATUS code describing the current status.
+ */
+//---------------------------------------------------------------------------
+
+typedef enum {
+    TASK_STATE_P_INIT = 0,
+    TASK_STATE_P_WAIT_LENGTH,
+    TASK_STATE_P_APPLY
+} OTA_PATCH_TASK_STATE;
+
+static SYS_STATUS OTA_Task_DownloadPatch(void) {
+    uint8_t digest[OTA_CRYPT_SHA256_DIGEST_SIZE];
+    SYS_STATUS status;
+
+    switch (ota.task.state) {
+        case TASK_STATE_P_INIT:
+        {
+            uint32_t src_len = APP_IMG_BOOT_CTL->sz;
+
+            if (src_len == 0 || src_len == 0xFFFFFFFF) {
+                SYS_CONSOLE_PRINT("SYS OTA : Base image size unknown\r\n");
+                return SYS_STATUS_ERROR;
+            }
+            if ((SYS_OTA_PATCH_STAGING_ADDRESS < SYS_OTA_PATCH_SOURCE_ADDRESS + src_len)
+                    && (SYS_OTA_PATCH_SOURCE_ADDRESS < SYS_OTA_PATCH_STAGING_ADDRESS + SYS_OTA_PATCH_STAGING_SIZE)) {
+                SYS_CONSOLE_PRINT("SYS OTA : Patch staging slot overlaps the base image\r\n");
+                return SYS_STATUS_ERROR;
+            }
+            if (OTA_PatchStreamOpen(&ota_patch, SYS_OTA_PATCH_SOURCE_ADDRESS, src_len,
+                    SYS_OTA_PATCH_STAGING_ADDRESS, SYS_OTA_PATCH_STAGING_SIZE, 0) != SYS_STATUS_READY) {
+                return SYS_STATUS_ERROR;
+            }
+            ota.task.state = TASK_STATE_P_WAIT_LENGTH;
+            break;
+        }
+        case TASK_STATE_P_WAIT_LENGTH:
+        {
+            /* The patcher has to know where the patch ends */
+            if (field_content_length == 0) {
+                if (DOWNLOADER_Read(ota.downloader, ota_patch.rx, 0) < 0) {
+                    SYS_CONSOLE_PRINT("SYS OTA : Patch download error\r\n");
+                    OTA_PatchStreamAbort(&ota_patch);
+                    return SYS_STATUS_ERROR;
+                }
+                break;
+            }
+            ota_patch.patch_len = field_content_length;
+            ota_params.server_image_length = field_content_length;
+            ota.task.state = TASK_STATE_P_APPLY;
+            break;
+        }
+        case TASK_STATE_P_APPLY:
+        {
+            /* Aborted by the patcher on error */
+            status = OTA_PatchStreamTask(&ota_patch, ota.downloader);
+            ota_params.total_data_downloaded = ota_patch.patch_pos;
+            if (status != SYS_STATUS_READY) {
+                return status;
+            }
+            OTA_PatchStreamAbort(&ota_patch);
+            if (!OTA_DigestFromString(ota_params.serv_app_digest_string, digest)
+                    || memcmp(digest, ota_patch.digest, sizeof (digest)) != 0) {
+                SYS_CONSOLE_PRINT("SYS OTA : Patched image digest mismatch\r\n");
+                ota.ota_result = OTA_RESULT_PATCH_IMAGE_DIGEST_VERIFY_FAILED;
+                return SYS_STATUS_ERROR;
+            }
+            OTA_SetImageDigest(ota_patch.dst_len, ota_patch.digest);
+            return SYS_STATUS_READY;
+        }
+        default:
+        {
+            SYS_ASSERT(false, "Unknown task state");
+            return SYS_STATUS_ERROR;
+        }
+    }
+    return SYS_STATUS_BUSY;
+}
+#endif
+
 // *****************************************************************************
 // *****************************************************************************
 // Section: To register user call back function
@@ -639,6 +818,12 @@ SYS_STATUS OTA_Start(OTA_PARAMS *param) {
     }
 #endif
     ota_isTls_request = OTA_IsTls_Request(param->ota_server_url);
+#ifdef SYS_OTA_PATCH_ENABLE
+    /* The patch length is taken from the response to this request */
+    if (param->patch_request == true) {
+        field_content_length = 0;
+    }
+#endif
     ota.downloader = DOWNLOADER_Open(param->ota_server_url);
     if (ota.downloader == DRV_HANDLE_INVALID) {
 
@@ -653,6 +838,14 @@ SYS_STATUS OTA_Start(OTA_PARAMS *param) {
 #endif    
 	memcpy(ota_params.ota_server_url, param->ota_server_url, strlen(param->ota_server_url) + 1);
     ota_params.version = param->version;
+#ifdef SYS_OTA_PATCH_ENABLE
+    ota_params.patch_request = param->patch_request;
+    ota_params.patch_base_version = param->patch_base_version;
+    ota_params.server_image_length = 0;
+    ota_params.total_data_downloaded = 0;
+    ota.ota_result = OTA_RESULT_NONE;
+    ota.task.state = TASK_STATE_P_INIT;
+#endif
     ota.current_task = OTA_TASK_DOWNLOAD_IMAGE;
     
     ota.status = SYS_STATUS_BUSY;
@@ -856,6 +1049,12 @@ void OTA_Tasks(void) {
                 ota.task.state = OTA_TASK_INIT;
             }
             OTA_Task_UpdateUser();
+#ifdef SYS_OTA_PATCH_ENABLE
+            /* As for downloaded files, the bootloader takes over the staging slot */
+            if (ota.ota_result == OTA_RESULT_PATCH_EVENT_COMPLETED) {
+                OTA_UpdateBootctl();
+            }
+#endif
             break;
         }
         case OTA_TASK_IDLE:
@@ -887,6 +1086,26 @@ void OTA_Tasks(void) {
         case OTA_TASK_DOWNLOAD_IMAGE:
         {
             ota.ota_idle = false;
+#ifdef SYS_OTA_PATCH_ENABLE
+            if (ota_params.patch_request == true) {
+                ota.status = OTA_Task_DownloadPatch();
+                if (ota.status == SYS_STATUS_BUSY) {
+                    break;
+                }
+                if(ota_isTls_request == true){
+                    OTA_SetCachePolicy(true);
+                }
+                if (ota.status == SYS_STATUS_READY) {
+                    ota.ota_result = OTA_RESULT_PATCH_EVENT_COMPLETED;
+                } else if (ota.ota_result != OTA_RESULT_PATCH_IMAGE_DIGEST_VERIFY_FAILED) {
+                    SYS_CONSOLE_PRINT("SYS OTA : Patch error\r\n");
+                    ota.ota_result = OTA_RESULT_PATCH_IMAGE_FAILED;
+                }
+                ota.current_task = OTA_TASK_UPDATE_USER;
+                ota.task.state = OTA_TASK_INIT;
+                break;
+            }
+#endif
 			ota.status = SYS_STATUS_READY;
             if (ota.status == SYS_STATUS_READY) {
                 if(ota_isTls_request == true){
@@ -1041,6 +1260,16 @@ typedef struct {
 
 OTA_SIGN_IMAGE_TASK_CONTEXT *ctx = (void*) ota.task.context;
 
+static bool ota_image_digest_set = false;
+static uint32_t ota_image_size;
+static uint8_t ota_image_digest[sizeof(((FIRMWARE_IMAGE_HEADER*)0)->digest)];
+
+void OTA_SetImageDigest(uint32_t size, const uint8_t *digest) {
+    ota_image_size = size;
+    memcpy(ota_image_digest, digest, sizeof (ota_image_digest));
+    ota_image_digest_set = true;
+}
+
 void OTA_UpdateBootctl() {
     ctx->buf = (uint8_t*) OSAL_Malloc(FLASH_SECTOR_SIZE);
     SYS_CONSOLE_PRINT("SYS OTA : Update boot ctrl\r\n");
@@ -1052,6 +1281,13 @@ void OTA_UpdateBootctl() {
     ctx->img.order = 0xFF;
     ctx->img.type = IMG_TYPE_PRODUCTION;
     ctx->img.boot_addr = (0xb0000200 + (uint32_t)SYS_OTA_JUMP_TO_ADDRESS);
+    if (ota_image_digest_set) {
+        ctx->img.sz = ota_image_size;
+        memcpy(ctx->img.digest, ota_image_digest, sizeof (ctx->img.digest));
+    } else {
+        ctx->img.sz = 0xFFFFFFFF;
+        memset(ctx->img.digest, 0xFF, sizeof (ctx->img.digest));
+    }
     INT_Flash_Erase(APP_IMG_BOOT_CTL_WR, FLASH_SECTOR_SIZE);
     memcpy(ctx->buf, &ctx->img, sizeof (FIRMWARE_IMAGE_HEADER));
     INT_Flash_Write(APP_IMG_BOOT_CTL_WR, ctx->buf, FLASH_SECTOR_SIZE);
@@ -218,6 +218,27 @@ typedef struct OTA_PARAMS {
 // *****************************************************************************
 void OTA_UpdateBootctl();
 // *****************************************************************************
+/*
+  Function:
+    void OTA_SetImageDigest(uint32_t size, const uint8_t *digest)
+
+  Summary:
+    To record the size and SHA-256 digest of the downloaded image.
+
+  Description:
+    Stored in the image header by the next OTA_UpdateBootctl, so that the
+    bootloader does not need to compute the digest to know what to expect.
+
+  Parameters:
+    size - image size in bytes.
+    digest - 32 byte SHA-256 digest of the image.
+
+  Returns:
+    None.
+*/
+// *****************************************************************************
+void OTA_SetImageDigest(uint32_t size, const uint8_t *digest);
+// *****************************************************************************
 /*
   Function:
     OTA_GetDownloadStatus(OTA_PARAMS *result)
@@ -567,10 +588,12 @@ bool OTA_IsIdle(void) ;
     SYS_STATUS OTA_Search_ImageVersion(uint32_t ver, char *digest);
 
   Summary:
-    To search a particular image version in OTA DB.
+    To search the base image of a patch.
 
   Description:
-    To check if a particular image version is present in OTA DB or not.
+    A patch is applied to the running image, so this checks that the
+    running image is the given version and that the digest recorded in
+    its boot control header matches.
 
   Precondition:
     None.
@@ -580,7 +603,7 @@ bool OTA_IsIdle(void) ;
     digest - digest of base image
 
   Returns:
-    SYS_STATUS code.
+    SYS_STATUS_READY if found, SYS_STATUS_ERROR otherwise.
 */
 // *****************************************************************************
 SYS_STATUS OTA_Search_ImageVersion(uint32_t ver, char *digest);
@@ -0,0 +1,248 @@
+/*******************************************************************************
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    ota_lz.h
+
+  Summary:
+    Interface for the compressed OTA image container.
+
+  Description:
+    An OTA image may be shipped either raw or wrapped in a small LZ77
+    container. The container is produced by tools/hex2bin (-c) and is
+    decompressed on the fly while the image is programmed, so the raw image
+    never has to be held in RAM or in external flash.
+
+    Container layout (little-endian):
+
+      offset  size  field
+      0       4     magic "OTAZ"
+      4       1     version (OTA_LZ_VERSION)
+      5       1     window bits (back-reference window is 1 << bits bytes)
+      6       2     reserved, 0
+      8       4     raw image length
+      12      4     compressed stream length
+
+    The stream is a sequence of LZ4 style sequences:
+
+      token      high nibble: literal count, low nibble: match length - 4.
+                 A nibble of 15 is followed by extra length bytes which are
+                 added to it, a byte of 255 meaning another byte follows.
+      literals   literal count bytes copied as is.
+      offset     2 bytes, distance of the match back into the window (1..).
+      match      match length bytes copied from the window.
+
+    The stream ends as soon as the raw image length has been produced, so the
+    last sequence may stop after its literals. Digests and signatures always
+    cover the raw image, so a compressed image verifies exactly like a raw one.
+ *******************************************************************************/
+
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+Copyright (c) 2020-2021 released Microchip Technology Inc.  All rights reserved.
+
+Microchip licenses to you the right to use, modify, copy and distribute
+Software only when embedded on a Microchip microcontroller or digital signal
+controller that is integrated into your product or third party product
+(pursuant to the sublicense terms in the accompanying license agreement).
+
+You should refer to the license agreement accompanying this Software for
+additional information regarding your rights and obligations.
+
+SOFTWARE AND DOCUMENTATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF
+MERCHANTABILITY, TITLE, NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE.
+IN NO EVENT SHALL MICROCHIP OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER
+CONTRACT, NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR
+OTHER LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE OR
+CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT OF
+SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+(INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+ *******************************************************************************/
+// DOM-IGNORE-END
+
+#ifndef _OTA_LZ_H
+#define _OTA_LZ_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+#define     OTA_LZ_HEADER_SIZE          16
+#define     OTA_LZ_VERSION              1
+#define     OTA_LZ_MIN_MATCH            4
+
+/* Largest back-reference window accepted by the decoder. The decoder keeps
+   the last window of output in RAM, so this bounds its memory use */
+#ifndef OTA_LZ_WINDOW_BITS_MAX
+#define     OTA_LZ_WINDOW_BITS_MAX      12
+#endif
+#define     OTA_LZ_WINDOW_SIZE          (1UL << OTA_LZ_WINDOW_BITS_MAX)
+
+// *****************************************************************************
+/* OTA compressed container header.
+
+  Summary:
+    Decoded form of the container header.
+
+  Remarks:
+   None.
+*/
+typedef struct {
+    uint32_t raw_len;               /* Length of the decompressed image */
+    uint32_t packed_len;            /* Length of the stream after the header */
+    uint8_t  window_bits;           /* log2 of the back-reference window */
+} OTA_LZ_HEADER;
+
+// *****************************************************************************
+/* OTA decompressor state.
+
+  Summary:
+    Position of the decompressor inside the sequence stream.
+
+  Remarks:
+   None.
+*/
+typedef enum {
+    OTA_LZ_STATE_TOKEN = 0,         /* Expecting the token of the next sequence */
+    OTA_LZ_STATE_LITERAL_LENGTH,    /* Expecting extra literal length bytes */
+    OTA_LZ_STATE_LITERALS,          /* Copying literals from the stream */
+    OTA_LZ_STATE_OFFSET_LO,         /* Expecting the low byte of the offset */
+    OTA_LZ_STATE_OFFSET_HI,         /* Expecting the high byte of the offset */
+    OTA_LZ_STATE_MATCH_LENGTH,      /* Expecting extra match length bytes */
+    OTA_LZ_STATE_MATCH,             /* Copying a match from the window */
+    OTA_LZ_STATE_DONE,
+    OTA_LZ_STATE_ERROR
+} OTA_LZ_STATE;
+
+// *****************************************************************************
+/* OTA decompressor context.
+
+  Summary:
+    State of one streaming decompression.
+
+  Description:
+    Input and output may be supplied in pieces of any size; the decompressor
+    stops whenever it runs out of either and resumes on the next call.
+
+  Remarks:
+    The window buffer is provided by the caller and must hold at least
+    1 << window_bits bytes.
+*/
+typedef struct {
+    OTA_LZ_STATE state;
+    uint32_t raw_len;               /* Bytes the stream decompresses to */
+    uint32_t out_len;               /* Bytes produced so far */
+    uint32_t literals;              /* Literals left in the current sequence */
+    uint32_t match;                 /* Match bytes left in the current sequence */
+    uint32_t offset;                /* Offset of the current match */
+    uint8_t  *window;               /* Last window_mask + 1 bytes of output */
+    uint32_t window_mask;
+    uint32_t window_pos;
+} OTA_LZ_CTX;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Routines
+// *****************************************************************************
+// *****************************************************************************
+
+//---------------------------------------------------------------------------
+/*
+  Function:
+    bool OTA_LZ_HeaderParse(const uint8_t *buf, uint32_t len, OTA_LZ_HEADER *hdr)
+
+  Summary:
+    Checks whether an image starts with a compressed container header.
+
+  Description:
+    Decodes the container header at the start of buf.
+
+  Parameters:
+    buf - First bytes of the image.
+    len - Number of bytes in buf.
+    hdr - Receives the decoded header.
+
+  Returns:
+    true if buf holds a supported container header, false for a raw image.
+ */
+//---------------------------------------------------------------------------
+bool OTA_LZ_HeaderParse(const uint8_t *buf, uint32_t len, OTA_LZ_HEADER *hdr);
+
+//---------------------------------------------------------------------------
+/*
+  Function:
+    bool OTA_LZ_Init(OTA_LZ_CTX *lz, const OTA_LZ_HEADER *hdr, uint8_t *window, uint32_t window_size)
+
+  Summary:
+    Starts decompressing a container.
+
+  Parameters:
+    lz          - Decompressor context.
+    hdr         - Header returned by OTA_LZ_HeaderParse.
+    window      - Window buffer.
+    window_size - Size of the window buffer.
+
+  Returns:
+    true if the container can be decoded with the given window buffer.
+ */
+//---------------------------------------------------------------------------
+bool OTA_LZ_Init(OTA_LZ_CTX *lz, const OTA_LZ_HEADER *hdr, uint8_t *window, uint32_t window_size);
+
+//---------------------------------------------------------------------------
+/*
+  Function:
+    int32_t OTA_LZ_Decompress(OTA_LZ_CTX *lz, const uint8_t *in, uint32_t *in_len, uint8_t *out, uint32_t out_len)
+
+  Summary:
+    Decompresses as much as fits.
+
+  Description:
+    Consumes the stream bytes in "in" until either they are used up, out_len
+    bytes have been produced or the end of the image is reached.
+
+  Parameters:
+    lz      - Decompressor context.
+    in      - Stream bytes following those consumed by earlier calls.
+    in_len  - In: bytes available in "in". Out: bytes consumed.
+    out     - Output buffer.
+    out_len - Size of the output buffer.
+
+  Returns:
+    Number of bytes written to out, or -1 if the stream is corrupt.
+ */
+//---------------------------------------------------------------------------
+int32_t OTA_LZ_Decompress(OTA_LZ_CTX *lz, const uint8_t *in, uint32_t *in_len, uint8_t *out, uint32_t out_len);
+
+//---------------------------------------------------------------------------
+/*
+  Function:
+    bool OTA_LZ_Done(const OTA_LZ_CTX *lz)
+
+  Summary:
+    Returns true once the whole raw image has been produced.
+ */
+//---------------------------------------------------------------------------
+bool OTA_LZ_Done(const OTA_LZ_CTX *lz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _OTA_LZ_H
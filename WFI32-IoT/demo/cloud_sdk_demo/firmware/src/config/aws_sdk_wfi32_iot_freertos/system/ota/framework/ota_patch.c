@@ -47,6 +47,8 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 #include "system_definitions.h"
 #include "osal/osal.h"
 #include "system/ota/framework/patch/janpatch.h"
+#include "system/ota/framework/int_flash.h"
+#include "system/ota/framework/downloader.h"
 #include "ota_patch.h"
 
 #ifdef SYS_OTA_PATCH_ENABLE
@@ -107,6 +109,408 @@ SYS_STATUS OTA_ProcessPatch(OTA_PATCH_PARAMS_t *patch_param) {
     return SYS_STATUS_READY;
 }
 
+//---------------------------------------------------------------------------
+/*
+  Streaming patcher.
+
+  Applies a janpatch (JojoDiff) patch while it is being received: the source
+  image is read from internal flash and the target image is programmed
+  straight into the staging slot, a sector at a time. Compared to
+  OTA_ProcessPatch there is no patch or target file, so the image is not
+  copied through the file system twice.
+ */
+//---------------------------------------------------------------------------
+
+#define OTA_PATCH_SOURCE_PAGE_NONE  0xFFFFFFFF
+
+static uint8_t *OTA_PatchStreamOut(OTA_PATCH_STREAM *ps)
+{
+    return &ps->out_buf[ps->out_index * FLASH_SECTOR_SIZE];
+}
+
+/* Queue the sector being filled for programming and move to the next buffer */
+static bool OTA_PatchStreamSubmit(OTA_PATCH_STREAM *ps)
+{
+    uint8_t *out = OTA_PatchStreamOut(ps);
+    uint32_t ticket;
+
+    if (ps->out_erased == false) {
+        if (INT_Flash_QueueErase(ps->out_addr, FLASH_SECTOR_SIZE) == 0) {
+            return false;
+        }
+        ps->out_erased = true;
+    }
+    memset(&out[ps->out_len], 0xFF, FLASH_SECTOR_SIZE - ps->out_len);
+    ticket = INT_Flash_QueueWrite(ps->out_addr, out, FLASH_SECTOR_SIZE);
+    if (ticket == 0) {
+        return false;
+    }
+    OTA_CRYPT_SHA256_DataAdd(&ps->sha256, out, ps->out_len);
+
+    ps->out_ticket[ps->out_index] = ticket;
+    ps->out_index = (ps->out_index + 1) % OTA_PATCH_TARGET_BUFFERS;
+    ps->out_addr += FLASH_SECTOR_SIZE;
+    ps->out_len = 0;
+    ps->out_erased = false;
+    return true;
+}
+
+/* To check that at least one target byte can be produced */
+static bool OTA_PatchStreamOutReady(OTA_PATCH_STREAM *ps)
+{
+    if (ps->out_len == FLASH_SECTOR_SIZE && !OTA_PatchStreamSubmit(ps)) {
+        return false;
+    }
+    /* The buffer is reused once its previous sector is programmed */
+    return INT_Flash_QueueDone(ps->out_ticket[ps->out_index]);
+}
+
+static bool OTA_PatchStreamPut(OTA_PATCH_STREAM *ps, uint8_t c)
+{
+    if (ps->dst_len >= ps->dst_size) {
+        SYS_CONSOLE_PRINT("OTA Patch : Target exceeds slot size\r\n");
+        return false;
+    }
+    OTA_PatchStreamOut(ps)[ps->out_len++] = c;
+    ps->dst_len++;
+    return true;
+}
+
+/* To get the cached source page holding src_pos, reading it on a miss */
+static OTA_PATCH_SOURCE_PAGE *OTA_PatchStreamSource(OTA_PATCH_STREAM *ps)
+{
+    uint32_t page = (uint32_t)ps->src_pos / OTA_PATCH_SOURCE_PAGE_SIZE;
+    OTA_PATCH_SOURCE_PAGE *entry = &ps->src_cache[0];
+    int i;
+
+    for (i = 0; i < OTA_PATCH_SOURCE_CACHE_PAGES; i++) {
+        if (ps->src_cache[i].page == page) {
+            entry = &ps->src_cache[i];
+            entry->used = ++ps->src_clock;
+            return entry;
+        }
+        if (ps->src_cache[i].used < entry->used) {
+            entry = &ps->src_cache[i];
+        }
+    }
+
+    entry->len = ps->src_len - page * OTA_PATCH_SOURCE_PAGE_SIZE;
+    if (entry->len > OTA_PATCH_SOURCE_PAGE_SIZE) {
+        entry->len = OTA_PATCH_SOURCE_PAGE_SIZE;
+    }
+    if (!INT_Flash_Read(ps->src_addr + page * OTA_PATCH_SOURCE_PAGE_SIZE, entry->buf, entry->len)) {
+        entry->page = OTA_PATCH_SOURCE_PAGE_NONE;
+        return NULL;
+    }
+    entry->page = page;
+    entry->used = ++ps->src_clock;
+    return entry;
+}
+
+/* EQL: copy a run of source bytes, bounded by the source page and target sector */
+static bool OTA_PatchStreamEqual(OTA_PATCH_STREAM *ps)
+{
+    OTA_PATCH_SOURCE_PAGE *entry;
+    uint32_t off, n;
+
+    if (ps->src_pos < 0 || (uint32_t)ps->src_pos >= ps->src_len) {
+        SYS_CONSOLE_PRINT("OTA Patch : Copy beyond source image\r\n");
+        return false;
+    }
+    if (ps->dst_len >= ps->dst_size) {
+        SYS_CONSOLE_PRINT("OTA Patch : Target exceeds slot size\r\n");
+        return false;
+    }
+    entry = OTA_PatchStreamSource(ps);
+    if (entry == NULL) {
+        return false;
+    }
+
+    off = (uint32_t)ps->src_pos % OTA_PATCH_SOURCE_PAGE_SIZE;
+    n = entry->len - off;
+    if (n > ps->len) {
+        n = ps->len;
+    }
+    if (n > FLASH_SECTOR_SIZE - ps->out_len) {
+        n = FLASH_SECTOR_SIZE - ps->out_len;
+    }
+    if (n > ps->dst_size - ps->dst_len) {
+        n = ps->dst_size - ps->dst_len;
+    }
+    memcpy(&OTA_PatchStreamOut(ps)[ps->out_len], &entry->buf[off], n);
+    ps->out_len += n;
+    ps->dst_len += n;
+    ps->src_pos += n;
+    ps->len -= n;
+    if (ps->len == 0) {
+        ps->state = OTA_PATCH_STREAM_OP;
+    }
+    return true;
+}
+
+static bool OTA_PatchStreamOpcode(OTA_PATCH_STREAM *ps, uint8_t c)
+{
+    ps->op = c;
+    switch (c) {
+        case JANPATCH_OPERATION_MOD:
+        case JANPATCH_OPERATION_INS:
+            ps->state = OTA_PATCH_STREAM_DATA;
+            return true;
+        case JANPATCH_OPERATION_EQL:
+        case JANPATCH_OPERATION_DEL:
+        case JANPATCH_OPERATION_BKT:
+            ps->state = OTA_PATCH_STREAM_LENGTH;
+            return true;
+        default:
+            SYS_CONSOLE_PRINT("OTA Patch : Unknown operation %02x\r\n", c);
+            return false;
+    }
+}
+
+/* To apply EQL/DEL/BKT once their length is known */
+static bool OTA_PatchStreamOperand(OTA_PATCH_STREAM *ps)
+{
+    ps->state = OTA_PATCH_STREAM_OP;
+    switch (ps->op) {
+        case JANPATCH_OPERATION_EQL:
+            if (ps->len != 0) {
+                ps->state = OTA_PATCH_STREAM_EQUAL;
+            }
+            return true;
+        case JANPATCH_OPERATION_DEL:
+            ps->src_pos += ps->len;
+            return true;
+        default:
+            ps->src_pos -= ps->len;
+            return (ps->src_pos >= 0);
+    }
+}
+
+/* To decode one patch byte; produces at most one target byte */
+static bool OTA_PatchStreamByte(OTA_PATCH_STREAM *ps, uint8_t c)
+{
+    switch (ps->state) {
+        case OTA_PATCH_STREAM_OP:
+            if (c != JANPATCH_OPERATION_ESC) {
+                SYS_CONSOLE_PRINT("OTA Patch : Expected operation, got %02x\r\n", c);
+                return false;
+            }
+            ps->state = OTA_PATCH_STREAM_OPCODE;
+            return true;
+
+        case OTA_PATCH_STREAM_OPCODE:
+            return OTA_PatchStreamOpcode(ps, c);
+
+        case OTA_PATCH_STREAM_LENGTH:
+            /* 1..252 in one byte, 253..508 in two, then 16 and 32 bit big endian */
+            if (c <= 251) {
+                ps->len = c + 1;
+                return OTA_PatchStreamOperand(ps);
+            }
+            ps->len = 0;
+            ps->len_base = (c == 252) ? 253 : 0;
+            ps->len_bytes = (c == 252) ? 1 : (c == 253) ? 2 : 4;
+            if (c == 255) {
+                return false;
+            }
+            ps->state = OTA_PATCH_STREAM_LENGTH_MORE;
+            return true;
+
+        case OTA_PATCH_STREAM_LENGTH_MORE:
+            ps->len = (ps->len << 8) | c;
+            if (--ps->len_bytes == 0) {
+                ps->len += ps->len_base;
+                return OTA_PatchStreamOperand(ps);
+            }
+            return true;
+
+        case OTA_PATCH_STREAM_DATA:
+            if (c == JANPATCH_OPERATION_ESC) {
+                ps->state = OTA_PATCH_STREAM_DATA_ESC;
+                return true;
+            }
+            if (ps->op == JANPATCH_OPERATION_MOD) {
+                ps->src_pos++;
+            }
+            return OTA_PatchStreamPut(ps, c);
+
+        case OTA_PATCH_STREAM_DATA_ESC:
+            if (c >= JANPATCH_OPERATION_BKT && c <= JANPATCH_OPERATION_MOD) {
+                /* A lone escape ends the data and starts the next operation */
+                return OTA_PatchStreamOpcode(ps, c);
+            }
+            ps->state = OTA_PATCH_STREAM_DATA;
+            if (c != JANPATCH_OPERATION_ESC) {
+                /* Escape not followed by an operation is data as well */
+                ps->pending = c;
+                ps->state = OTA_PATCH_STREAM_DATA_LITERAL;
+            }
+            if (ps->op == JANPATCH_OPERATION_MOD) {
+                ps->src_pos += (c == JANPATCH_OPERATION_ESC) ? 1 : 2;
+            }
+            return OTA_PatchStreamPut(ps, JANPATCH_OPERATION_ESC);
+
+        default:
+            return false;
+    }
+}
+
+SYS_STATUS OTA_PatchStreamOpen(OTA_PATCH_STREAM *ps, uint32_t src_addr, uint32_t src_len,
+                               uint32_t dst_addr, uint32_t dst_size, uint32_t patch_len)
+{
+    int i;
+
+    memset(ps, 0, sizeof(*ps));
+    ps->out_buf = (uint8_t *)OSAL_Malloc(OTA_PATCH_TARGET_BUFFERS * FLASH_SECTOR_SIZE);
+    if (ps->out_buf == NULL) {
+        ps->state = OTA_PATCH_STREAM_ERROR;
+        return SYS_STATUS_ERROR;
+    }
+    for (i = 0; i < OTA_PATCH_SOURCE_CACHE_PAGES; i++) {
+        ps->src_cache[i].page = OTA_PATCH_SOURCE_PAGE_NONE;
+    }
+    ps->state = OTA_PATCH_STREAM_OP;
+    ps->src_addr = src_addr;
+    ps->src_len = src_len;
+    ps->dst_addr = dst_addr;
+    ps->dst_size = dst_size;
+    ps->out_addr = dst_addr;
+    ps->patch_len = patch_len;
+    OTA_CRYPT_SHA256_Initialize(&ps->sha256);
+    INT_Flash_Open();
+    patch_progress_status = 0;
+    return SYS_STATUS_READY;
+}
+
+int32_t OTA_PatchStreamWrite(OTA_PATCH_STREAM *ps, const uint8_t *buf, uint32_t len)
+{
+    uint32_t used = 0;
+    bool ok = true;
+
+    if (ps->state == OTA_PATCH_STREAM_ERROR || ps->state == OTA_PATCH_STREAM_DONE) {
+        return -1;
+    }
+    while (ok && OTA_PatchStreamOutReady(ps)) {
+        if (ps->state == OTA_PATCH_STREAM_EQUAL) {
+            ok = OTA_PatchStreamEqual(ps);
+        }
+        else if (ps->state == OTA_PATCH_STREAM_DATA_LITERAL) {
+            ps->state = OTA_PATCH_STREAM_DATA;
+            ok = OTA_PatchStreamPut(ps, ps->pending);
+        }
+        else if (used < len) {
+            ok = OTA_PatchStreamByte(ps, buf[used++]);
+        }
+        else {
+            break;
+        }
+    }
+    if (!ok) {
+        ps->state = OTA_PATCH_STREAM_ERROR;
+        return -1;
+    }
+
+    ps->patch_pos += used;
+    if (ps->patch_len != 0 && (ps->patch_pos * 100ULL / ps->patch_len) != ps->progress) {
+        ps->progress = ps->patch_pos * 100ULL / ps->patch_len;
+        OTA_PatchProgress(ps->progress);
+    }
+    return used;
+}
+
+SYS_STATUS OTA_PatchStreamFinish(OTA_PATCH_STREAM *ps)
+{
+    int i;
+
+    if (ps->state == OTA_PATCH_STREAM_DONE) {
+        return SYS_STATUS_READY;
+    }
+    /* Source copies of the last operation may still be pending */
+    if (OTA_PatchStreamWrite(ps, NULL, 0) < 0) {
+        return SYS_STATUS_ERROR;
+    }
+    switch (ps->state) {
+        case OTA_PATCH_STREAM_EQUAL:
+        case OTA_PATCH_STREAM_DATA_LITERAL:
+            return SYS_STATUS_BUSY;
+        case OTA_PATCH_STREAM_LENGTH:
+        case OTA_PATCH_STREAM_LENGTH_MORE:
+            SYS_CONSOLE_PRINT("OTA Patch : Patch truncated\r\n");
+            ps->state = OTA_PATCH_STREAM_ERROR;
+            return SYS_STATUS_ERROR;
+        default:
+            break;
+    }
+    if (ps->out_len != 0 && !OTA_PatchStreamSubmit(ps)) {
+        return SYS_STATUS_BUSY;
+    }
+    for (i = 0; i < OTA_PATCH_TARGET_BUFFERS; i++) {
+        if (!INT_Flash_QueueDone(ps->out_ticket[i])) {
+            return SYS_STATUS_BUSY;
+        }
+    }
+    OTA_CRYPT_SHA256_Finalize(&ps->sha256, ps->digest);
+    ps->state = OTA_PATCH_STREAM_DONE;
+    OTA_PatchProgress(100);
+    return SYS_STATUS_READY;
+}
+
+void OTA_PatchStreamAbort(OTA_PATCH_STREAM *ps)
+{
+    if (ps->state != OTA_PATCH_STREAM_DONE) {
+        INT_Flash_QueueFlush();
+        ps->state = OTA_PATCH_STREAM_ERROR;
+    }
+    if (ps->out_buf != NULL) {
+        OSAL_Free(ps->out_buf);
+        ps->out_buf = NULL;
+    }
+    INT_Flash_Close();
+}
+
+SYS_STATUS OTA_PatchStreamTask(OTA_PATCH_STREAM *ps, DRV_HANDLE downloader)
+{
+    SYS_STATUS status = SYS_STATUS_BUSY;
+    int32_t n;
+
+    if (INT_Flash_QueueTasks() == INT_FLASH_QUEUE_ERROR) {
+        SYS_CONSOLE_PRINT("OTA Patch : Flash programming error\r\n");
+        status = SYS_STATUS_ERROR;
+    }
+    else if (ps->rx_pos == ps->rx_len && ps->patch_pos == ps->patch_len) {
+        status = OTA_PatchStreamFinish(ps);
+    }
+    else {
+        if (ps->rx_pos == ps->rx_len) {
+            n = ps->patch_len - ps->patch_pos;
+            if (n > OTA_PATCH_BUFFER_SIZE) {
+                n = OTA_PATCH_BUFFER_SIZE;
+            }
+            n = DOWNLOADER_Read(downloader, ps->rx, n);
+            if (n < 0) {
+                SYS_CONSOLE_PRINT("OTA Patch : Patch download error\r\n");
+                status = SYS_STATUS_ERROR;
+            }
+            ps->rx_len = (n > 0) ? n : 0;
+            ps->rx_pos = 0;
+        }
+        if (status != SYS_STATUS_ERROR && ps->rx_pos < ps->rx_len) {
+            n = OTA_PatchStreamWrite(ps, &ps->rx[ps->rx_pos], ps->rx_len - ps->rx_pos);
+            if (n < 0) {
+                status = SYS_STATUS_ERROR;
+            }
+            else {
+                ps->rx_pos += n;
+            }
+        }
+    }
+
+    if (status == SYS_STATUS_ERROR) {
+        OTA_PatchStreamAbort(ps);
+    }
+    return status;
+}
+
 #endif
 
 
@@ -46,6 +46,9 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 #include "system_config.h"
 #include "system_definitions.h"
 #include "osal/osal.h"
+#include "driver/driver_common.h"
+#include "system/ota/framework/ota_config.h"
+#include "system/ota/framework/sha256.h"
 
 
 
@@ -55,6 +58,25 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 // *****************************************************************************
 // *****************************************************************************
 #define     OTA_PATCH_BUFFER_SIZE       1024
+
+/* Source image reads of the streaming patcher go through a small page cache,
+   since EQL and BKT operations seek around the base image */
+#define     OTA_PATCH_SOURCE_PAGE_SIZE      512
+#define     OTA_PATCH_SOURCE_CACHE_PAGES    2
+
+/* Target sectors being filled / programmed by the streaming patcher */
+#define     OTA_PATCH_TARGET_BUFFERS        2
+
+/* Internal flash offsets used by the OTA download task: the base image is
+   the running one, the target is rebuilt in the slot the bootloader jumps to,
+   which must not overlap it */
+#ifndef SYS_OTA_PATCH_SOURCE_ADDRESS
+#define     SYS_OTA_PATCH_SOURCE_ADDRESS    (APP_IMG_BOOT_ADDR - 0xb0000000)
+#endif
+#ifndef SYS_OTA_PATCH_STAGING_ADDRESS
+#define     SYS_OTA_PATCH_STAGING_ADDRESS   SYS_OTA_JUMP_TO_ADDRESS
+#define     SYS_OTA_PATCH_STAGING_SIZE      SYS_OTA_SLOT_0_SIZE
+#endif
 // *****************************************************************************
 /* OTA patch structure.
 
@@ -78,6 +100,97 @@ typedef struct OTA_PATCH_ELEMENTS {
     char target_file[100];
 } OTA_PATCH_PARAMS_t;
 
+// *****************************************************************************
+/* OTA streaming patch decoder state.
+
+  Summary:
+    Position of the streaming patcher inside the patch operation stream.
+
+  Remarks:
+   None.
+*/
+typedef enum {
+    OTA_PATCH_STREAM_OP = 0,        /* Expecting the escape byte of the next operation */
+    OTA_PATCH_STREAM_OPCODE,        /* Expecting the operation code */
+    OTA_PATCH_STREAM_LENGTH,        /* Expecting the first length byte of EQL/DEL/BKT */
+    OTA_PATCH_STREAM_LENGTH_MORE,   /* Expecting the remaining length bytes */
+    OTA_PATCH_STREAM_EQUAL,         /* Copying bytes from the source image */
+    OTA_PATCH_STREAM_DATA,          /* Copying MOD/INS data from the patch */
+    OTA_PATCH_STREAM_DATA_ESC,      /* Escape byte seen inside MOD/INS data */
+    OTA_PATCH_STREAM_DATA_LITERAL,  /* Escaped data byte waiting for target space */
+    OTA_PATCH_STREAM_DONE,
+    OTA_PATCH_STREAM_ERROR
+} OTA_PATCH_STREAM_STATE;
+
+// *****************************************************************************
+/* OTA streaming patch source cache page.
+
+  Summary:
+    One cached page of the source image.
+
+  Remarks:
+   None.
+*/
+typedef struct {
+    uint32_t page;                  /* Page index, 0xFFFFFFFF if unused */
+    uint32_t len;                   /* Valid bytes in buf */
+    uint32_t used;                  /* Last use, for replacement */
+    uint8_t  buf[OTA_PATCH_SOURCE_PAGE_SIZE];
+} OTA_PATCH_SOURCE_PAGE;
+
+// *****************************************************************************
+/* OTA streaming patch context.
+
+  Summary:
+    State of one streaming patch operation.
+
+  Description:
+    The patch (janpatch / JojoDiff format) is pushed in as it arrives, the
+    source image is read from internal flash and the target image is written
+    sector by sector into the staging slot through the INT_Flash queue. No
+    file system access is involved.
+
+  Remarks:
+   The context must stay at the same address until the patch has finished
+   or has been aborted.
+*/
+typedef struct {
+    OTA_PATCH_STREAM_STATE state;
+    uint8_t  op;                    /* Operation being decoded */
+    uint8_t  pending;               /* Escaped data byte for DATA_LITERAL */
+    uint8_t  len_bytes;             /* Length bytes still to be read */
+    uint32_t len_base;              /* Added to the length once it is read */
+    uint32_t len;                   /* Operation length / EQL bytes left */
+    uint32_t patch_len;             /* Total patch size, 0 if unknown */
+    uint32_t patch_pos;             /* Patch bytes consumed */
+    uint8_t  progress;
+
+    /* Source image in internal flash */
+    uint32_t src_addr;
+    uint32_t src_len;
+    int32_t  src_pos;
+    uint32_t src_clock;
+    OTA_PATCH_SOURCE_PAGE src_cache[OTA_PATCH_SOURCE_CACHE_PAGES];
+
+    /* Target image in the staging slot */
+    uint32_t dst_addr;
+    uint32_t dst_size;
+    uint32_t dst_len;               /* Target bytes produced */
+    uint32_t out_addr;              /* Slot offset of the sector being filled */
+    uint32_t out_len;               /* Bytes in the sector being filled */
+    uint8_t  out_index;
+    bool     out_erased;            /* Erase of out_addr already queued */
+    uint32_t out_ticket[OTA_PATCH_TARGET_BUFFERS];
+    uint8_t  *out_buf;
+    OTA_CRYPT_SHA256_CTX sha256;
+    uint8_t  digest[OTA_CRYPT_SHA256_DIGEST_SIZE];
+
+    /* Patch receive buffer for OTA_PatchStreamTask */
+    uint8_t  rx[OTA_PATCH_BUFFER_SIZE];
+    uint32_t rx_len;
+    uint32_t rx_pos;
+} OTA_PATCH_STREAM;
+
 
 // *****************************************************************************
 /*
@@ -119,6 +232,131 @@ SYS_STATUS OTA_ProcessPatch(OTA_PATCH_PARAMS_t *patch_param);
 // *****************************************************************************
 uint8_t OTA_PatchProgressStatus(void);
 
+// *****************************************************************************
+/*
+  Function:
+    SYS_STATUS OTA_PatchStreamOpen(OTA_PATCH_STREAM *ps, uint32_t src_addr,
+        uint32_t src_len, uint32_t dst_addr, uint32_t dst_size, uint32_t patch_len)
+
+  Summary:
+    To start a streaming patch operation.
+
+  Description:
+    Prepares ps to rebuild the target image from the source image at
+    src_addr (src_len bytes) and a patch of patch_len bytes. The target is
+    written to the slot at dst_addr, which must be sector aligned and hold
+    at most dst_size bytes. Addresses are internal flash offsets as used by
+    INT_Flash_Read.
+
+  Parameters:
+    ps        - Patch context.
+    src_addr  - Source image offset in internal flash.
+    src_len   - Source image size.
+    dst_addr  - Staging slot offset in internal flash.
+    dst_size  - Staging slot size.
+    patch_len - Patch size, 0 if not known (OTA_PatchStreamTask needs it).
+
+  Returns:
+    SYS_STATUS_READY on success, SYS_STATUS_ERROR if the target buffers
+    cannot be allocated.
+*/
+// *****************************************************************************
+SYS_STATUS OTA_PatchStreamOpen(OTA_PATCH_STREAM *ps, uint32_t src_addr, uint32_t src_len,
+                               uint32_t dst_addr, uint32_t dst_size, uint32_t patch_len);
+
+// *****************************************************************************
+/*
+  Function:
+    int32_t OTA_PatchStreamWrite(OTA_PATCH_STREAM *ps, const uint8_t *buf, uint32_t len)
+
+  Summary:
+    To push patch data into a streaming patch operation.
+
+  Description:
+    Decodes as much of buf as possible. Decoding stops early when both
+    target sectors are still being programmed; the caller passes the
+    remaining bytes again later. INT_Flash_QueueTasks must be run meanwhile.
+    A call with len 0 only advances pending source copies.
+
+  Parameters:
+    ps  - Patch context.
+    buf - Patch data.
+    len - Number of bytes in buf.
+
+  Returns:
+    Number of bytes consumed, or -1 if the patch is malformed or does not
+    fit the source / target.
+*/
+// *****************************************************************************
+int32_t OTA_PatchStreamWrite(OTA_PATCH_STREAM *ps, const uint8_t *buf, uint32_t len);
+
+// *****************************************************************************
+/*
+  Function:
+    SYS_STATUS OTA_PatchStreamFinish(OTA_PATCH_STREAM *ps)
+
+  Summary:
+    To complete a streaming patch operation after the last patch byte.
+
+  Description:
+    Writes the last, 0xFF padded, target sector and waits for programming
+    to complete. On completion ps->dst_len holds the target size and
+    ps->digest its SHA-256 digest.
+
+  Parameters:
+    ps - Patch context.
+
+  Returns:
+    SYS_STATUS_BUSY until done, then SYS_STATUS_READY, or SYS_STATUS_ERROR.
+*/
+// *****************************************************************************
+SYS_STATUS OTA_PatchStreamFinish(OTA_PATCH_STREAM *ps);
+
+// *****************************************************************************
+/*
+  Function:
+    void OTA_PatchStreamAbort(OTA_PATCH_STREAM *ps)
+
+  Summary:
+    To abandon a streaming patch operation.
+
+  Description:
+    Drops queued flash jobs and releases the target buffers. Also used to
+    release a finished operation.
+
+  Parameters:
+    ps - Patch context.
+
+  Returns:
+    None.
+*/
+// *****************************************************************************
+void OTA_PatchStreamAbort(OTA_PATCH_STREAM *ps);
+
+// *****************************************************************************
+/*
+  Function:
+    SYS_STATUS OTA_PatchStreamTask(OTA_PATCH_STREAM *ps, DRV_HANDLE downloader)
+
+  Summary:
+    To download and apply a patch in one pass.
+
+  Description:
+    Reads the patch from an open downloader and feeds it to the streaming
+    patcher while the flash queue programs the target, so the patch is
+    never stored. Must be called periodically.
+
+  Parameters:
+    ps         - Patch context opened with a known patch_len.
+    downloader - Handle from DOWNLOADER_Open.
+
+  Returns:
+    SYS_STATUS_BUSY while in progress, SYS_STATUS_READY once the target
+    is complete, SYS_STATUS_ERROR on failure (the operation is aborted).
+*/
+// *****************************************************************************
+SYS_STATUS OTA_PatchStreamTask(OTA_PATCH_STREAM *ps, DRV_HANDLE downloader);
+
 
 
 
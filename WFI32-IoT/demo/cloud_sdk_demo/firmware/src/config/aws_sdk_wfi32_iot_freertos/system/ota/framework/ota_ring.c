@@ -0,0 +1,165 @@
+/*******************************************************************************
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    ota_ring.c
+
+  Summary:
+    Single-producer/single-consumer byte ring for the OTA downloader.
+
+  Description:
+    See ota_ring.h.
+ *******************************************************************************/
+
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+Copyright (c) 2020-2021 released Microchip Technology Inc.  All rights reserved.
+
+Microchip licenses to you the right to use, modify, copy and distribute
+Software only when embedded on a Microchip microcontroller or digital signal
+controller that is integrated into your product or third party product
+(pursuant to the sublicense terms in the accompanying license agreement).
+
+You should refer to the license agreement accompanying this Software for
+additional information regarding your rights and obligations.
+
+SOFTWARE AND DOCUMENTATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF
+MERCHANTABILITY, TITLE, NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE.
+IN NO EVENT SHALL MICROCHIP OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER
+CONTRACT, NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR
+OTHER LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE OR
+CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT OF
+SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+(INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+ *******************************************************************************/
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <string.h>
+#include "ota_ring.h"
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/* The index a side owns is read plainly; the other side's index is loaded
+   with acquire and its own stored with release, so ring memory is never
+   seen before the index that hands it over */
+static uint32_t ota_ring_load(const uint32_t *index) {
+    return __atomic_load_n(index, __ATOMIC_ACQUIRE);
+}
+
+static void ota_ring_store(uint32_t *index, uint32_t value) {
+    __atomic_store_n(index, value, __ATOMIC_RELEASE);
+}
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Routines
+// *****************************************************************************
+// *****************************************************************************
+
+bool OTA_RING_Init(OTA_RING *ring, uint8_t *buf, uint32_t size) {
+    if (size == 0 || (size & (size - 1)) != 0) {
+        return false;
+    }
+    ring->buf = buf;
+    ring->mask = size - 1;
+    ring->head = 0;
+    ring->tail = 0;
+    return true;
+}
+
+uint32_t OTA_RING_Level(const OTA_RING *ring) {
+    return ota_ring_load(&ring->head) - ota_ring_load(&ring->tail);
+}
+
+uint32_t OTA_RING_Space(const OTA_RING *ring) {
+    return ring->mask + 1 - OTA_RING_Level(ring);
+}
+
+uint32_t OTA_RING_Reserve(OTA_RING *ring, uint8_t **span) {
+    uint32_t pos = ring->head & ring->mask;
+    uint32_t len = ring->mask + 1 - (ring->head - ota_ring_load(&ring->tail));
+
+    if (len > ring->mask + 1 - pos) {
+        len = ring->mask + 1 - pos;
+    }
+    *span = &ring->buf[pos];
+    return len;
+}
+
+void OTA_RING_Commit(OTA_RING *ring, uint32_t len) {
+    ota_ring_store(&ring->head, ring->head + len);
+}
+
+uint32_t OTA_RING_Write(OTA_RING *ring, const uint8_t *data, uint32_t len) {
+    uint32_t done = 0;
+
+    /* At most twice: up to the end of the ring, then from its start */
+    while (done < len) {
+        uint8_t *span;
+        uint32_t n = OTA_RING_Reserve(ring, &span);
+
+        if (n == 0) {
+            break;
+        }
+        if (n > len - done) {
+            n = len - done;
+        }
+        memcpy(span, &data[done], n);
+        OTA_RING_Commit(ring, n);
+        done += n;
+    }
+    return done;
+}
+
+uint32_t OTA_RING_Peek(OTA_RING *ring, uint32_t offset, uint8_t **span) {
+    uint32_t level = ota_ring_load(&ring->head) - ring->tail;
+    uint32_t pos = (ring->tail + offset) & ring->mask;
+    uint32_t len;
+
+    if (offset >= level) {
+        return 0;
+    }
+    len = level - offset;
+    if (len > ring->mask + 1 - pos) {
+        len = ring->mask + 1 - pos;
+    }
+    *span = &ring->buf[pos];
+    return len;
+}
+
+void OTA_RING_Release(OTA_RING *ring, uint32_t len) {
+    ota_ring_store(&ring->tail, ring->tail + len);
+}
+
+uint32_t OTA_RING_Read(OTA_RING *ring, uint8_t *data, uint32_t len) {
+    uint32_t done = 0;
+
+    while (done < len) {
+        uint8_t *span;
+        uint32_t n = OTA_RING_Peek(ring, 0, &span);
+
+        if (n == 0) {
+            break;
+        }
+        if (n > len - done) {
+            n = len - done;
+        }
+        memcpy(&data[done], span, n);
+        OTA_RING_Release(ring, n);
+        done += n;
+    }
+    return done;
+}
@@ -0,0 +1,231 @@
+/*******************************************************************************
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    ota_ring.h
+
+  Summary:
+    Single-producer/single-consumer byte ring for the OTA downloader.
+
+  Description:
+    The producer (HTTP client) reserves free space, receives into it and
+    commits what it received; the consumer peeks at committed bytes where
+    they lie and releases them once it is done with them. Data is never
+    copied through an intermediate buffer, and memory the consumer has not
+    released yet - a flash sector being programmed from it, for example -
+    is never overwritten.
+
+    Each index is written by one side only, so one producer and one consumer
+    may run in different threads (or a thread and an interrupt) without a
+    lock. Spans are contiguous; a reservation or a peek stops at the end of
+    the ring, and the rest is returned by the next call.
+ *******************************************************************************/
+
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+Copyright (c) 2020-2021 released Microchip Technology Inc.  All rights reserved.
+
+Microchip licenses to you the right to use, modify, copy and distribute
+Software only when embedded on a Microchip microcontroller or digital signal
+controller that is integrated into your product or third party product
+(pursuant to the sublicense terms in the accompanying license agreement).
+
+You should refer to the license agreement accompanying this Software for
+additional information regarding your rights and obligations.
+
+SOFTWARE AND DOCUMENTATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF
+MERCHANTABILITY, TITLE, NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE.
+IN NO EVENT SHALL MICROCHIP OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER
+CONTRACT, NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR
+OTHER LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE OR
+CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT OF
+SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+(INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+ *******************************************************************************/
+// DOM-IGNORE-END
+
+#ifndef _OTA_RING_H
+#define _OTA_RING_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+
+// *****************************************************************************
+/* OTA ring.
+
+  Summary:
+    State of one ring.
+
+  Description:
+    head and tail count the bytes committed and released since the ring was
+    initialized; they wrap around at 2^32, and only their difference and
+    their position modulo the ring size are used.
+
+  Remarks:
+    The ring size must be a power of two.
+*/
+typedef struct {
+    uint8_t  *buf;
+    uint32_t mask;                  /* Ring size - 1 */
+    uint32_t head;                  /* Written by the producer only */
+    uint32_t tail;                  /* Written by the consumer only */
+} OTA_RING;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Routines
+// *****************************************************************************
+// *****************************************************************************
+
+//---------------------------------------------------------------------------
+/*
+  Function:
+    bool OTA_RING_Init(OTA_RING *ring, uint8_t *buf, uint32_t size)
+
+  Summary:
+    Makes an empty ring of a buffer.
+
+  Parameters:
+    ring - Ring.
+    buf  - Ring memory.
+    size - Size of buf; a power of two.
+
+  Returns:
+    false if size is not a power of two.
+ */
+//---------------------------------------------------------------------------
+bool OTA_RING_Init(OTA_RING *ring, uint8_t *buf, uint32_t size);
+
+//---------------------------------------------------------------------------
+/*
+  Function:
+    uint32_t OTA_RING_Level(const OTA_RING *ring)
+    uint32_t OTA_RING_Space(const OTA_RING *ring)
+
+  Summary:
+    Bytes committed and not released yet, and bytes free.
+
+  Remarks:
+    Either side may call these; the other side can only make the level
+    seen by the consumer grow, and the space seen by the producer grow.
+ */
+//---------------------------------------------------------------------------
+uint32_t OTA_RING_Level(const OTA_RING *ring);
+uint32_t OTA_RING_Space(const OTA_RING *ring);
+
+//---------------------------------------------------------------------------
+/*
+  Function:
+    uint32_t OTA_RING_Reserve(OTA_RING *ring, uint8_t **span)
+
+  Summary:
+    Producer: finds free space to receive into.
+
+  Parameters:
+    ring - Ring.
+    span - Receives the start of the free space.
+
+  Returns:
+    Contiguous bytes free at *span; 0 if the ring is full.
+ */
+//---------------------------------------------------------------------------
+uint32_t OTA_RING_Reserve(OTA_RING *ring, uint8_t **span);
+
+//---------------------------------------------------------------------------
+/*
+  Function:
+    void OTA_RING_Commit(OTA_RING *ring, uint32_t len)
+
+  Summary:
+    Producer: hands the first len bytes of the last reservation to the
+    consumer.
+ */
+//---------------------------------------------------------------------------
+void OTA_RING_Commit(OTA_RING *ring, uint32_t len);
+
+//---------------------------------------------------------------------------
+/*
+  Function:
+    uint32_t OTA_RING_Write(OTA_RING *ring, const uint8_t *data, uint32_t len)
+
+  Summary:
+    Producer: copies data in and commits it.
+
+  Returns:
+    Bytes written; less than len if the ring filled up.
+ */
+//---------------------------------------------------------------------------
+uint32_t OTA_RING_Write(OTA_RING *ring, const uint8_t *data, uint32_t len);
+
+//---------------------------------------------------------------------------
+/*
+  Function:
+    uint32_t OTA_RING_Peek(OTA_RING *ring, uint32_t offset, uint8_t **span)
+
+  Summary:
+    Consumer: finds committed bytes without releasing them.
+
+  Description:
+    Looks offset bytes past the oldest byte not released, so the consumer
+    can go on reading while it holds on to earlier data.
+
+  Parameters:
+    ring   - Ring.
+    offset - Bytes to skip.
+    span   - Receives the start of the bytes found.
+
+  Returns:
+    Contiguous bytes committed at *span; 0 if there are none yet.
+ */
+//---------------------------------------------------------------------------
+uint32_t OTA_RING_Peek(OTA_RING *ring, uint32_t offset, uint8_t **span);
+
+//---------------------------------------------------------------------------
+/*
+  Function:
+    void OTA_RING_Release(OTA_RING *ring, uint32_t len)
+
+  Summary:
+    Consumer: gives the oldest len bytes back to the producer.
+ */
+//---------------------------------------------------------------------------
+void OTA_RING_Release(OTA_RING *ring, uint32_t len);
+
+//---------------------------------------------------------------------------
+/*
+  Function:
+    uint32_t OTA_RING_Read(OTA_RING *ring, uint8_t *data, uint32_t len)
+
+  Summary:
+    Consumer: copies up to len bytes out and releases them.
+
+  Returns:
+    Bytes read.
+ */
+//---------------------------------------------------------------------------
+uint32_t OTA_RING_Read(OTA_RING *ring, uint8_t *data, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _OTA_RING_H
@@ -39,6 +39,34 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 /****************************** MACROS ******************************/
 #define OTA_SHA256_BLOCK_SIZE 32            // SHA256 outputs a 32 byte digest
 
+/* Hash backends behind the OTA_CRYPT_SHA256_* interface below.
+ *
+ * OTA_SHA256_BACKEND_C       - portable C implementation in sha256.c.
+ * OTA_SHA256_BACKEND_PIC32MZ - streams the message through the crypto engine
+ *                              buffer descriptor ring (wolfCrypt PIC32MZ large
+ *                              hash, needs WOLFSSL_PIC32MZ_HASH). A context
+ *                              only runs on the engine when
+ *                              OTA_CRYPT_SHA256_DataSizeSet() is called before
+ *                              the first DataAdd; everything else falls back
+ *                              to the C backend.
+ *
+ * The application defaults to the C backend: the engine is shared with the
+ * TLS stack and a large hash keeps it locked from the first DataAdd until
+ * Finalize, which would stall TLS for the whole download.
+ */
+#define OTA_SHA256_BACKEND_C            0
+#define OTA_SHA256_BACKEND_PIC32MZ      1
+
+#ifndef OTA_SHA256_BACKEND
+#define OTA_SHA256_BACKEND              OTA_SHA256_BACKEND_C
+#endif
+
+#if (OTA_SHA256_BACKEND == OTA_SHA256_BACKEND_PIC32MZ)
+#include "configuration.h"
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/wolfcrypt/sha256.h>
+#endif
+
 /**************************** DATA TYPES ****************************/
 //typedef unsigned char BYTE;             // 8-bit byte
 //typedef unsigned int  WORD;             // 32-bit word, change to "long" for 16-bit machines
@@ -48,18 +76,29 @@ typedef struct {
 	uint32_t datalen;
 	unsigned long long bitlen;
 	uint32_t state[8];
+} OTA_SHA256_SW_CTX;
+
+typedef struct {
+	uint32_t hw_len;          // Message length handed to the engine, 0 when on the C backend
+	union {
+		OTA_SHA256_SW_CTX sw;
+#if (OTA_SHA256_BACKEND == OTA_SHA256_BACKEND_PIC32MZ)
+		wc_Sha256 hw;
+#endif
+	} u;
 } OTA_SHA256_CTX;
 
 /*********************** FUNCTION DECLARATIONS **********************/
 void ota_sha256_init(OTA_SHA256_CTX *ctx);
+void ota_sha256_size_set(OTA_SHA256_CTX *ctx, uint32_t len);
 void ota_sha256_update(OTA_SHA256_CTX *ctx, const uint8_t data[], size_t len);
-void ota_sha256_final(OTA_SHA256_CTX *ctx, uint8_t hash[]);
+int ota_sha256_final(OTA_SHA256_CTX *ctx, uint8_t hash[]);
 
 
 #define OTA_CRYPT_SHA256_CTX                        OTA_SHA256_CTX
 #define OTA_CRYPT_SHA256_DIGEST_SIZE 				32
 #define OTA_CRYPT_SHA256_Initialize(ctx)			ota_sha256_init(ctx)
-#define OTA_CRYPT_SHA256_DataSizeSet(ctx, len)
+#define OTA_CRYPT_SHA256_DataSizeSet(ctx, len)		ota_sha256_size_set(ctx, len)
 #define OTA_CRYPT_SHA256_DataAdd(ctx, buf, len)		ota_sha256_update(ctx, buf, len)
 #define OTA_CRYPT_SHA256_Finalize(ctx, digest)		ota_sha256_final(ctx, digest)
 
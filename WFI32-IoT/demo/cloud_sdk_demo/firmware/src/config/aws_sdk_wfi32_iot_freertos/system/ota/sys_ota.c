@@ -53,6 +53,7 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 #include "system/../wolfssl/wolfcrypt/tfm.h"
 #include "system/../wolfssl/wolfcrypt/asn_public.h"
 #include <wolfssl/wolfcrypt/coding.h>
+#include <ctype.h>
 
 // *****************************************************************************
 // *****************************************************************************
@@ -148,16 +149,37 @@ static bool SYS_OTA_NVM_Read
     uint8_t* buff, 
     uint32_t len
 );
-static bool SYS_OTA_NVM_Write
+static bool SYS_OTA_Download_Probe
 (
-    uint32_t addr, 
-    uint8_t* buff, 
+    OTA_FILE_DOWNLOAD_TASK_CONTEXT *cntx,
+    const uint8_t *header
+);
+static int SYS_OTA_Download_Decompress
+(
+    OTA_FILE_DOWNLOAD_TASK_CONTEXT *cntx,
+    DRV_HANDLE downloader,
+    uint8_t *buf,
     uint32_t len
 );
+static bool SYS_OTA_NVM_EraseAhead
+(
+    OTA_FILE_DOWNLOAD_TASK_CONTEXT *cntx,
+    uint32_t addr
+);
 static bool SYS_OTA_CheckSlot
 (
     int slot_number
 );
+static uint32_t SYS_OTA_File_CursorLoad
+(
+    OTA_FILE_DOWNLOAD_TASK_CONTEXT *cntx,
+    uint32_t slot_address
+);
+static void SYS_OTA_File_CursorSave
+(
+    OTA_FILE_DOWNLOAD_TASK_CONTEXT *cntx,
+    const SYS_OTA_FILE_RESUME_POINT *point
+);
 
 static bool SYS_OTA_Download_File
 (
@@ -168,6 +190,10 @@ static bool SYS_OTA_Get_File_Data
 (
     cJSON *file_data
 );
+static bool SYS_OTA_Get_File_Digest
+(
+    cJSON *file_data
+);
  
 void SYS_OTA_Print_Server_Data
 (
@@ -332,6 +358,13 @@ void _OTACallback(uint32_t event, void * data, void *cookies) {
             sys_otaData.state = SYS_OTA_UPDATE_USER;
             break;
         }
+        case OTA_RESULT_PATCH_IMAGE_FAILED:
+        {
+            sys_otaData.otaFwInProgress = false;
+            sys_otaData.state = SYS_OTA_UPDATE_USER;
+            SYS_OTA_SetOtaServicStatus(SYS_OTA_DOWNLOAD_FAILED);
+            break;
+        }
 #endif
         
         case OTA_RESULT_IMAGE_DOWNLOAD_START:
@@ -591,6 +624,9 @@ static bool SYS_OTA_ParseJsonContent(cJSON *config_json) {
             }
             
 #ifdef SYS_OTA_PATCH_ENABLE
+            /* A patch offered by an earlier manifest does not apply to this one */
+            sys_otaData.patch_request = false;
+            ota_params.patch_request = false;
             if(patch_array != NULL)
             {
                 int patch_array_count = OTA_cJSON_GetArraySize(patch_array);
@@ -1312,6 +1348,40 @@ static bool SYS_OTA_Parse_JSON
     return false;
 }
 
+/* Get the optional hex "digest" of a file; the file is verified against it when present */
+static bool SYS_OTA_Get_File_Digest
+(
+    cJSON *file_data
+)
+{
+    cJSON *file_digest = OTA_cJSON_GetObjectItem(file_data, "digest");
+    char hex[3] = {0};
+    
+    memset(g_SysFileData.file_digest_string, '\0', sizeof(g_SysFileData.file_digest_string));
+    if(file_digest == NULL)
+    {
+        return true;
+    }
+    if(!OTA_cJSON_IsString(file_digest) || file_digest->valuestring == NULL
+            || strlen(file_digest->valuestring) != sizeof(g_SysFileData.file_digest_string))
+    {
+        SYS_CONSOLE_PRINT("\tERROR!!! - File Digest \r\n");
+        return false;
+    }
+    memcpy(g_SysFileData.file_digest_string, file_digest->valuestring, sizeof(g_SysFileData.file_digest_string));
+    
+    for(int i = 0; i < sizeof(g_formulated_digest); i++){
+        memcpy(hex, &g_SysFileData.file_digest_string[2 * i], 2);
+        if(!isxdigit((unsigned char) hex[0]) || !isxdigit((unsigned char) hex[1])){
+            SYS_CONSOLE_PRINT("\tERROR!!! - File Digest \r\n");
+            memset(g_SysFileData.file_digest_string, '\0', sizeof(g_SysFileData.file_digest_string));
+            return false;
+        }
+        g_formulated_digest[i] = (uint8_t) strtol(hex, NULL, 16);
+    }
+    return true;
+}
+
 /* Get Key data from server */
 static bool SYS_OTA_Get_Key_Data
 (
@@ -1349,6 +1419,10 @@ static bool SYS_OTA_Get_Key_Data
     memset(g_SysFileData.file_url,'\0', OTA_URL_SIZE);
     memcpy(g_SysFileData.file_url, (char *)file_URL->valuestring, strlen(file_URL->valuestring));
 	
+    if(!SYS_OTA_Get_File_Digest(cert_data))
+    {
+        return false;
+    }
 
     g_key_present = true;
     g_secure_download = true;
@@ -1406,9 +1480,7 @@ static bool SYS_OTA_Get_File_Data
     memset(g_SysFileData.file_url,'\0', OTA_URL_SIZE);
     memcpy(g_SysFileData.file_url, (char *)file_URL->valuestring, strlen(file_URL->valuestring));
  
-    
-
-    return true;
+    return SYS_OTA_Get_File_Digest(file_data);
 }        
 
 /* To Read from NVM */
@@ -1428,24 +1500,232 @@ static bool SYS_OTA_NVM_Read
     return false;
 }
 
-/* To Write to NVM */
-static bool SYS_OTA_NVM_Write
+/* To queue erases up to SYS_OTA_FILE_ERASE_AHEAD sectors past addr, within the file */
+static bool SYS_OTA_NVM_EraseAhead
 (
-    uint32_t addr, 
-    uint8_t* buff, 
+    OTA_FILE_DOWNLOAD_TASK_CONTEXT *cntx,
+    uint32_t addr
+)
+{
+    uint32_t slot_start = g_SysFileData.slot_info.slot_address[g_SysFileData.slot_number];
+    uint32_t slot_end = slot_start + g_SysFileData.slot_info.slot_size[g_SysFileData.slot_number];
+    uint32_t end = addr + (SYS_OTA_FILE_ERASE_AHEAD + 1) * FLASH_SECTOR_SIZE;
+    
+    if(end > slot_start + cntx->image_len){
+        /* Erase cycle is always 4KB aligned*/
+        end = slot_start + ((cntx->image_len + FLASH_SECTOR_SIZE - 1) & ~(FLASH_SECTOR_SIZE - 1));
+    }
+    if(end > slot_end){
+        end = slot_end;
+    }
+    while(cntx->erase_addr < end){
+        if(INT_Flash_QueueErase(cntx->erase_addr, FLASH_SECTOR_SIZE) == 0){
+            break;
+        }
+        cntx->erase_addr += FLASH_SECTOR_SIZE;
+    }
+    /* The sector at addr must be erased before it is written */
+    return (cntx->erase_addr > addr);
+}
+
+/* To switch to decompression if the file starts with a compressed container header */
+static bool SYS_OTA_Download_Probe
+(
+    OTA_FILE_DOWNLOAD_TASK_CONTEXT *cntx,
+    const uint8_t *header
+)
+{
+    OTA_LZ_HEADER hdr;
+    
+    if(!OTA_LZ_HeaderParse(header, OTA_LZ_HEADER_SIZE, &hdr)){
+        return true;
+    }
+    if(hdr.raw_len == 0 || hdr.raw_len > g_SysFileData.slot_info.slot_size[g_SysFileData.slot_number]){
+        SYS_CONSOLE_PRINT(TERM_RED"\tImage size is Greater than slot size\r\n"TERM_RESET);
+        return false;
+    }
+    cntx->lz = (OTA_FILE_LZ_CONTEXT *)OSAL_Malloc(sizeof(OTA_FILE_LZ_CONTEXT));
+    if(cntx->lz == NULL){
+        return false;
+    }
+    if(!OTA_LZ_Init(&cntx->lz->ctx, &hdr, cntx->lz->window, sizeof(cntx->lz->window))){
+        SYS_CONSOLE_PRINT(TERM_RED"\tUnsupported compressed file\r\n"TERM_RESET);
+        return false;
+    }
+    /* The image is decompressed into sector buffers of its own */
+    cntx->buf = (uint8_t *)OSAL_Malloc(SYS_OTA_FILE_DOWNLOAD_BUFFERS * FLASH_SECTOR_SIZE);
+    if(cntx->buf == NULL){
+        return false;
+    }
+    cntx->lz->in_pos = 0;
+    cntx->lz->in_len = 0;
+    cntx->lz->rx_len = OTA_LZ_HEADER_SIZE;
+    cntx->image_len = hdr.raw_len;
+    SYS_CONSOLE_PRINT("\tCompressed file -> Image length : %d\r\n", hdr.raw_len);
+    return true;
+}
+
+/* To download and decompress up to len bytes of the image; returns the bytes produced or -1 */
+static int SYS_OTA_Download_Decompress
+(
+    OTA_FILE_DOWNLOAD_TASK_CONTEXT *cntx,
+    DRV_HANDLE downloader,
+    uint8_t *buf,
     uint32_t len
 )
 {
-    INT_Flash_Open();
+    OTA_FILE_LZ_CONTEXT *lz = cntx->lz;
+    uint32_t got = 0;
     
-    /* Erase cycle is always 4KB aligned*/
-    if(INT_Flash_Erase(addr, 4096U)){
-        if(INT_Flash_Write(addr, buff, len)){
-            INT_Flash_Close();
-            return true;
+    while(got < len && !OTA_LZ_Done(&lz->ctx)){
+        uint32_t in_len = lz->in_len - lz->in_pos;
+        int32_t out_len;
+        
+        /* A long match may still be pending when all input has been consumed */
+        out_len = OTA_LZ_Decompress(&lz->ctx, &lz->in[lz->in_pos], &in_len, &buf[got], len - got);
+        if(out_len < 0){
+            SYS_CONSOLE_PRINT(TERM_RED"\tCorrupt compressed file\r\n"TERM_RESET);
+            return -1;
+        }
+        lz->in_pos += in_len;
+        got += out_len;
+        if(got < len && !OTA_LZ_Done(&lz->ctx) && lz->in_pos == lz->in_len){
+            uint32_t req_len = cntx->total_len - lz->rx_len;
+            int rx_len;
+            
+            if(req_len == 0){
+                SYS_CONSOLE_PRINT(TERM_RED"\tTruncated compressed file\r\n"TERM_RESET);
+                return -1;
+            }
+            if(req_len > SYS_OTA_FILE_LZ_INPUT_SIZE){
+                req_len = SYS_OTA_FILE_LZ_INPUT_SIZE;
+            }
+            rx_len = DOWNLOADER_Read(downloader, lz->in, req_len);
+            if(rx_len <= 0){
+                return (rx_len < 0) ? -1 : (int)got;
+            }
+            lz->in_pos = 0;
+            lz->in_len = rx_len;
+            lz->rx_len += rx_len;
         }
-    } 
-    return false;
+    }
+    return got;
+}
+
+/* To compute the CRC-32 of the download cursor */
+static uint32_t SYS_OTA_Crc32
+(
+    const uint8_t *data,
+    size_t len
+)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    uint8_t bit;
+    
+    while(len--){
+        crc ^= *data++;
+        for(bit = 0; bit < 8; bit++){
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+#define SYS_OTA_FILE_CURSOR_MAGIC   0x52435444      /* "DTCR" */
+
+static SYS_OTA_FILE_CURSOR g_cursor;
+
+/* To find where the download of the current file can resume; returns 0 to start over */
+static uint32_t SYS_OTA_File_CursorLoad
+(
+    OTA_FILE_DOWNLOAD_TASK_CONTEXT *cntx,
+    uint32_t slot_address
+)
+{
+    SYS_FS_HANDLE fd;
+    OTA_CRYPT_SHA256_CTX sha256;
+    uint8_t digest[2][OTA_CRYPT_SHA256_DIGEST_SIZE];
+    uint8_t buf[1024];
+    uint32_t len;
+    size_t rd;
+    
+    fd = SYS_FS_FileOpen(SYS_OTA_FILE_CURSOR_NAME, SYS_FS_FILE_OPEN_READ);
+    if(fd == SYS_FS_HANDLE_INVALID){
+        return 0;
+    }
+    rd = SYS_FS_FileRead(fd, &g_cursor, sizeof(g_cursor));
+    SYS_FS_FileClose(fd);
+    
+    len = g_cursor.point.copied_len;
+    if(rd != sizeof(g_cursor)
+            || g_cursor.magic != SYS_OTA_FILE_CURSOR_MAGIC
+            || g_cursor.crc != SYS_OTA_Crc32((const uint8_t *)&g_cursor, offsetof(SYS_OTA_FILE_CURSOR, crc))
+            || g_cursor.slot_address != slot_address
+            || strncmp(g_cursor.url, g_SysFileData.file_url, sizeof(g_cursor.url)) != 0
+            || memcmp(g_cursor.digest, g_SysFileData.file_digest_string, sizeof(g_cursor.digest)) != 0
+            || g_cursor.total_len > g_SysFileData.slot_info.slot_size[g_SysFileData.slot_number]
+            || len == 0 || len >= g_cursor.total_len || (len % FLASH_SECTOR_SIZE) != 0){
+        /* Left by a download of another file, or torn */
+        SYS_FS_FileRemove(SYS_OTA_FILE_CURSOR_NAME);
+        return 0;
+    }
+    
+    /* The slot must still hold what was programmed: hashing it again has to
+       end up in the saved hash state */
+    OTA_CRYPT_SHA256_Initialize(&sha256);
+    for(uint32_t addr = 0; addr < len; addr += sizeof(buf)){
+        if(!SYS_OTA_NVM_Read(slot_address + addr, buf, sizeof(buf))){
+            return 0;
+        }
+        OTA_CRYPT_SHA256_DataAdd(&sha256, buf, sizeof(buf));
+    }
+    cntx->sha256 = g_cursor.point.sha256;
+    OTA_CRYPT_SHA256_Finalize(&sha256, digest[0]);
+    OTA_CRYPT_SHA256_Finalize(&g_cursor.point.sha256, digest[1]);
+    if(memcmp(digest[0], digest[1], sizeof(digest[0])) != 0){
+        SYS_CONSOLE_PRINT(TERM_YELLOW"\tSlot does not match the download cursor\r\n"TERM_RESET);
+        OTA_CRYPT_SHA256_Initialize(&cntx->sha256);
+        SYS_FS_FileRemove(SYS_OTA_FILE_CURSOR_NAME);
+        return 0;
+    }
+    
+    cntx->copied_len = len;
+    cntx->saved_len = len;
+    cntx->total_len = g_cursor.total_len;
+    cntx->image_len = g_cursor.total_len;
+    cntx->probed = true;
+    return len;
+}
+
+/* To save the point a download resumes from after a reset */
+static void SYS_OTA_File_CursorSave
+(
+    OTA_FILE_DOWNLOAD_TASK_CONTEXT *cntx,
+    const SYS_OTA_FILE_RESUME_POINT *point
+)
+{
+    SYS_FS_HANDLE fd;
+    
+    memset(&g_cursor, 0, sizeof(g_cursor));
+    g_cursor.magic = SYS_OTA_FILE_CURSOR_MAGIC;
+    g_cursor.slot_address = g_SysFileData.slot_info.slot_address[g_SysFileData.slot_number];
+    g_cursor.total_len = cntx->total_len;
+    strncpy(g_cursor.url, g_SysFileData.file_url, sizeof(g_cursor.url) - 1);
+    memcpy(g_cursor.digest, g_SysFileData.file_digest_string, sizeof(g_cursor.digest));
+    g_cursor.point = *point;
+    g_cursor.crc = SYS_OTA_Crc32((const uint8_t *)&g_cursor, offsetof(SYS_OTA_FILE_CURSOR, crc));
+    
+    /* Marked as saved even on failure, so a missing file system is not retried every sector */
+    cntx->saved_len = point->copied_len;
+    fd = SYS_FS_FileOpen(SYS_OTA_FILE_CURSOR_NAME, SYS_FS_FILE_OPEN_WRITE);
+    if(fd == SYS_FS_HANDLE_INVALID){
+        #ifdef SYS_OTA_APPDEBUG_ENABLED
+        SYS_CONSOLE_PRINT("\tUnable to save download cursor\r\n");
+        #endif
+        return;
+    }
+    SYS_FS_FileWrite(fd, &g_cursor, sizeof(g_cursor));
+    SYS_FS_FileClose(fd);
 }
 
 /* To check the Slot */
@@ -1488,44 +1768,83 @@ static bool SYS_OTA_CheckSlot
     int rx_len = 0;
     static OTA_FILE_DOWNLOAD_TASK_CONTEXT cntx;
     static SYS_OTA_FILE_DOWNLOAD_STATE download_status = SYS_OTA_FILE_OPEN;
-    static DRV_HANDLE downloader2;
+    static DRV_HANDLE downloader2 = DRV_HANDLE_INVALID;
     static uint32_t Slot_address = 0;
     
+    /* Sectors are erased and programmed in the background while the next one downloads */
+    if(download_status != SYS_OTA_FILE_OPEN && INT_Flash_QueueTasks() == INT_FLASH_QUEUE_ERROR){
+        SYS_CONSOLE_PRINT(TERM_RED"\tNVM Write Error \r\n"TERM_RESET);
+        g_SysFileData.error = true;
+        download_status = SYS_OTA_FILE_DOWNLOAD_DONE;
+    }
+    
     switch (download_status) {
         case SYS_OTA_FILE_OPEN:
         {
-            cntx.buf_len = 0; 
-            cntx.copied_len = 0;
+            memset(&cntx, 0, sizeof(cntx));
             cntx.total_len = g_SysFileData.slot_info.file_size_in_slot[g_SysFileData.slot_number];
+            cntx.image_len = cntx.total_len;
             field_content_length = 0;
             
-			/* Create the buffer */
-            cntx.buf = (uint8_t *)OSAL_Malloc(FLASH_SECTOR_SIZE);
-            if(cntx.buf == NULL){
-                g_SysFileData.error = true; 
-                break;
-            }
-            downloader2 = DOWNLOADER_Open(file_URL);
+            Slot_address = g_SysFileData.slot_info.slot_address[g_SysFileData.slot_number];
+            OTA_CRYPT_SHA256_Initialize(&cntx.sha256);
+            
+            /* Carry on from where an earlier attempt at this file stopped */
+            Slot_address += SYS_OTA_File_CursorLoad(&cntx, Slot_address);
+            cntx.erase_addr = Slot_address;
+            
+            downloader2 = DOWNLOADER_OpenRange(file_URL, cntx.copied_len);
             if (downloader2 == DRV_HANDLE_INVALID) {
                 SYS_CONSOLE_PRINT(TERM_RED"SYS_OTA_FILE_ERROR : Unable to open File URL \r\n"TERM_RESET);
                 g_SysFileData.error = true;
                 break;
             }
 			
-            Slot_address = g_SysFileData.slot_info.slot_address[g_SysFileData.slot_number];
+            INT_Flash_Open();
             SYS_CONSOLE_PRINT("FILE: %d -> Downloading to Slot : %d Address : %X Total_len : %d\r\n",g_SysFileData.file_index,g_SysFileData.slot_number,Slot_address, g_SysFileData.slot_info.file_size_in_slot[g_SysFileData.slot_number]);
+            if(cntx.copied_len != 0){
+                SYS_CONSOLE_PRINT("\tResuming download at %d\r\n", cntx.copied_len);
+            }
             download_status = SYS_OTA_FILE_DOWNLOAD;
             break;
         }
         
         case SYS_OTA_FILE_DOWNLOAD:
         {
-            int req_len = cntx.total_len - cntx.copied_len;
+            int req_len = cntx.image_len - cntx.copied_len;
             if (req_len > FLASH_SECTOR_SIZE) {
                 req_len = FLASH_SECTOR_SIZE;
             }
-            /* Download 4KB of file (if file size is more than 4KB)*/
-            rx_len = DOWNLOADER_Read(downloader2, &cntx.buf[cntx.buf_len], ( req_len - cntx.buf_len )); 
+            /* The first bytes tell a compressed file from a raw one */
+            if (!cntx.probed && req_len > OTA_LZ_HEADER_SIZE) {
+                req_len = OTA_LZ_HEADER_SIZE;
+            }
+            SYS_OTA_NVM_EraseAhead(&cntx, Slot_address);
+            
+            /* Wait for the buffer while its previous sector is still being written */
+            if(!INT_Flash_QueueDone(cntx.buf_ticket[cntx.buf_index])){
+                break;
+            }
+            /* That sector is programmed: the downloader may reuse the memory a raw
+               file was programmed from, and the download can resume after it */
+            if(cntx.buf_held[cntx.buf_index] != 0){
+                DOWNLOADER_Release(downloader2, cntx.buf_held[cntx.buf_index]);
+                cntx.ring_offset -= cntx.buf_held[cntx.buf_index];
+                cntx.buf_held[cntx.buf_index] = 0;
+            }
+            if(cntx.pending[cntx.buf_index].copied_len >= cntx.saved_len + SYS_OTA_FILE_CURSOR_INTERVAL * FLASH_SECTOR_SIZE){
+                SYS_OTA_File_CursorSave(&cntx, &cntx.pending[cntx.buf_index]);
+            }
+            
+            /* Download 4KB of file (if file size is more than 4KB), or as much
+               of a compressed file as decompresses to 4KB. A raw file is not
+               copied; it is programmed from where the downloader received it */
+            if(cntx.lz != NULL){
+                cntx.sector = &cntx.buf[cntx.buf_index * FLASH_SECTOR_SIZE];
+                rx_len = SYS_OTA_Download_Decompress(&cntx, downloader2, &cntx.sector[cntx.buf_len], ( req_len - cntx.buf_len ));
+            } else {
+                rx_len = DOWNLOADER_Peek(downloader2, cntx.ring_offset, req_len, &cntx.sector);
+            }
             #ifdef SYS_OTA_APPDEBUG_ENABLED
             if(rx_len != 0){
                 SYS_CONSOLE_PRINT("\tTASK_STATE_D_DOWNLOAD :: rx_len : %d\r\n",rx_len);
@@ -1533,6 +1852,17 @@ static bool SYS_OTA_CheckSlot
             #endif
             if (rx_len <= 0) {
                 if (rx_len < 0) {
+                    /* A compressed file can only start over, as the decompressor
+                       state is not kept */
+                    if(cntx.lz == NULL && cntx.retries < SYS_OTA_FILE_RESUME_RETRIES){
+                        SYS_CONSOLE_PRINT(TERM_YELLOW"\tDownload interrupted at %d\r\n"TERM_RESET, cntx.copied_len);
+                        download_status = SYS_OTA_FILE_RESUME;
+                        break;
+                    }
+                    /* The server may not support ranges; the next attempt starts over */
+                    if(cntx.retries != 0){
+                        SYS_FS_FileRemove(SYS_OTA_FILE_CURSOR_NAME);
+                    }
                     g_SysFileData.error = true;
                     SYS_CONSOLE_PRINT(TERM_RED"\tSYS OTA FILE ERROR : File Downloading error\r\n"TERM_RESET);
                 }
@@ -1541,7 +1871,17 @@ static bool SYS_OTA_CheckSlot
             cntx.buf_len += rx_len;
             if(field_content_length != 0)
             {
+                /* The file must not have changed since the download started */
+                if(cntx.copied_len != 0 && cntx.lz == NULL && field_content_length != cntx.total_len){
+                    SYS_CONSOLE_PRINT(TERM_RED"\tFile size changed, download can not resume\r\n"TERM_RESET);
+                    SYS_FS_FileRemove(SYS_OTA_FILE_CURSOR_NAME);
+                    g_SysFileData.error = true;
+                    break;
+                }
                 cntx.total_len = field_content_length;
+                if(cntx.lz == NULL){
+                    cntx.image_len = field_content_length;
+                }
                 g_SysFileData.slot_info.file_size_in_slot[g_SysFileData.slot_number] = field_content_length;
                 /*To Check if actual size of file is greater than slot size */
                 if(field_content_length > g_SysFileData.slot_info.slot_size[g_SysFileData.slot_number]){
@@ -1551,6 +1891,21 @@ static bool SYS_OTA_CheckSlot
                 }
             }
             
+            if (!cntx.probed && cntx.buf_len == OTA_LZ_HEADER_SIZE) {
+                cntx.probed = true;
+                if(!SYS_OTA_Download_Probe(&cntx, cntx.sector)){
+                    g_SysFileData.error = true;
+                    break;
+                }
+                /* The container header is not part of the image; a raw file
+                   is looked at again as a whole sector */
+                if(cntx.lz != NULL){
+                    DOWNLOADER_Release(downloader2, OTA_LZ_HEADER_SIZE);
+                }
+                cntx.buf_len = 0;
+                break;
+            }
+            
             /* Stop download when buffer is full */
             if (cntx.buf_len == req_len) {
                 download_status = SYS_OTA_FILE_WRITE_TO_NVM;
@@ -1561,18 +1916,39 @@ static bool SYS_OTA_CheckSlot
 		 /*Write to NVM */
         case SYS_OTA_FILE_WRITE_TO_NVM:
         {
-            /* Write 4KB of file to NVM*/
-            while(NVM_IsBusy());
-            if(SYS_OTA_NVM_Write (Slot_address, cntx.buf, FLASH_SECTOR_SIZE ) != true ){
-                SYS_CONSOLE_PRINT(TERM_RED"\tNVM Write Error \r\n"TERM_RESET);
-                g_SysFileData.error = true;
+            /* Queue 4KB of file for NVM; retried while the queue is full */
+            if(!SYS_OTA_NVM_EraseAhead(&cntx, Slot_address)){
+                break;
+            }
+            cntx.buf_ticket[cntx.buf_index] = INT_Flash_QueueWrite(Slot_address, cntx.sector, FLASH_SECTOR_SIZE);
+            if(cntx.buf_ticket[cntx.buf_index] == 0){
                 break;
             }
             
+            /* Hash the sector while it is programmed, so the file is not read back afterwards.
+               The final length is only settled once the first response carried Content-Length */
+            if(cntx.copied_len == 0){
+                OTA_CRYPT_SHA256_DataSizeSet(&cntx.sha256, cntx.image_len);
+            }
+            OTA_CRYPT_SHA256_DataAdd(&cntx.sha256, cntx.sector, cntx.buf_len);
+            
+            /* The downloader keeps a raw sector until it is programmed */
+            if(cntx.lz == NULL){
+                cntx.buf_held[cntx.buf_index] = cntx.buf_len;
+                cntx.ring_offset += cntx.buf_len;
+            }
             cntx.copied_len += cntx.buf_len;
             cntx.buf_len = 0;
+            cntx.retries = 0;
+            /* Only the C hash backend keeps its whole state in the context,
+               which the cursor needs to resume after a reset */
+            if(cntx.lz == NULL && cntx.sha256.hw_len == 0){
+                cntx.pending[cntx.buf_index].copied_len = cntx.copied_len;
+                cntx.pending[cntx.buf_index].sha256 = cntx.sha256;
+            }
+            cntx.buf_index = (cntx.buf_index + 1) % SYS_OTA_FILE_DOWNLOAD_BUFFERS;
            
-            if(cntx.copied_len < cntx.total_len){
+            if(cntx.copied_len < cntx.image_len){
                 download_status = SYS_OTA_FILE_DOWNLOAD;
                 Slot_address += FLASH_SECTOR_SIZE;
                 break;
@@ -1581,19 +1957,99 @@ static bool SYS_OTA_CheckSlot
             break;
         }
         
+        case SYS_OTA_FILE_RESUME:
+        {
+            SYS_OTA_FILE_RESUME_POINT point;
+            
+            /* All that was hashed is queued for NVM; once it is programmed the
+               download carries on from its end, as soon as there is a network */
+            if(INT_Flash_QueueTasks() != INT_FLASH_QUEUE_IDLE || SYS_OTA_ConnectedToNtwrk() == false){
+                break;
+            }
+            DOWNLOADER_Close(downloader2);
+            downloader2 = DRV_HANDLE_INVALID;
+            memset(cntx.buf_held, 0, sizeof(cntx.buf_held));
+            cntx.ring_offset = 0;
+            
+            if(cntx.sha256.hw_len == 0 && cntx.copied_len > cntx.saved_len){
+                point.copied_len = cntx.copied_len;
+                point.sha256 = cntx.sha256;
+                SYS_OTA_File_CursorSave(&cntx, &point);
+            }
+            cntx.buf_len = 0;
+            cntx.retries++;
+            field_content_length = 0;
+            Slot_address = g_SysFileData.slot_info.slot_address[g_SysFileData.slot_number] + cntx.copied_len;
+            
+            SYS_CONSOLE_PRINT("\tResuming download at %d (attempt %d)\r\n", cntx.copied_len, cntx.retries);
+            downloader2 = DOWNLOADER_OpenRange(file_URL, cntx.copied_len);
+            if (downloader2 == DRV_HANDLE_INVALID) {
+                SYS_CONSOLE_PRINT(TERM_RED"SYS_OTA_FILE_ERROR : Unable to open File URL \r\n"TERM_RESET);
+                g_SysFileData.error = true;
+                break;
+            }
+            download_status = SYS_OTA_FILE_DOWNLOAD;
+            break;
+        }
+        
         case SYS_OTA_FILE_DOWNLOAD_DONE:
         {
+            /* Wait for the last sectors to be written */
+            if(g_SysFileData.error || INT_Flash_QueueTasks() != INT_FLASH_QUEUE_IDLE){
+                break;
+            }
+            INT_Flash_Close();
             DOWNLOADER_Close(downloader2);
-            SYS_CONSOLE_PRINT("\tDownloaded length %d\r\n",g_SysFileData.slot_info.file_size_in_slot[g_SysFileData.slot_number]);
+            downloader2 = DRV_HANDLE_INVALID;
             
-            OSAL_Free(cntx.buf);
-            cntx.buf = NULL;
+            OTA_CRYPT_SHA256_Finalize(&cntx.sha256, g_SysFileData.slot_info.file_digest_in_slot[g_SysFileData.slot_number]);
+            /* Complete or corrupt, the file is not resumed again */
+            if(cntx.saved_len != 0){
+                SYS_FS_FileRemove(SYS_OTA_FILE_CURSOR_NAME);
+            }
+            if(g_SysFileData.file_digest_string[0] != '\0'
+                    && memcmp(g_SysFileData.slot_info.file_digest_in_slot[g_SysFileData.slot_number], g_formulated_digest, sizeof(g_formulated_digest)) != 0){
+                SYS_CONSOLE_PRINT(TERM_RED"\tSYS OTA FILE ERROR : File Digest mismatch\r\n"TERM_RESET);
+                g_SysFileData.error = true;
+                break;
+            }
+            
+            if(cntx.buf != NULL){
+                OSAL_Free(cntx.buf);
+                cntx.buf = NULL;
+            }
+            if(cntx.lz != NULL){
+                OSAL_Free(cntx.lz);
+                cntx.lz = NULL;
+            }
+            /* The slot holds the decompressed image */
+            g_SysFileData.slot_info.file_size_in_slot[g_SysFileData.slot_number] = cntx.image_len;
             download_status = SYS_OTA_FILE_OPEN;
+            SYS_CONSOLE_PRINT("\tDownloaded length %d\r\n",g_SysFileData.slot_info.file_size_in_slot[g_SysFileData.slot_number]);
 			File_Dnld_Status = SYS_OTA_PARSE_JSON;
 			g_SysFileData.file_index++;
             break;
         }
     }
+    
+    /* The download is abandoned on error; drop its queued sectors before freeing the buffers */
+    if(g_SysFileData.error){
+        INT_Flash_QueueFlush();
+        INT_Flash_Close();
+        if(downloader2 != DRV_HANDLE_INVALID){
+            DOWNLOADER_Close(downloader2);
+            downloader2 = DRV_HANDLE_INVALID;
+        }
+        if(cntx.buf != NULL){
+            OSAL_Free(cntx.buf);
+            cntx.buf = NULL;
+        }
+        if(cntx.lz != NULL){
+            OSAL_Free(cntx.lz);
+            cntx.lz = NULL;
+        }
+        download_status = SYS_OTA_FILE_OPEN;
+    }
     return false;
 }     
  
@@ -1667,6 +2123,12 @@ static void SYS_OTA_File_Download_Tasks
         case SYS_OTA_DOWNLOAD_DONE:
         {
             SYS_CONSOLE_PRINT(TERM_GREEN"SYS_OTA_FILE : Files Downloaded Successfully\r\n"TERM_RESET);
+            /* Record the digest of the image the bootloader jumps to in its header */
+            for(int i = 0; i < SYS_OTA_NUM_OF_SLOTS; i++){
+                if(g_SysFileData.slot_info.slot_address[i] == SYS_OTA_JUMP_TO_ADDRESS){
+                    OTA_SetImageDigest(g_SysFileData.slot_info.file_size_in_slot[i], g_SysFileData.slot_info.file_digest_in_slot[i]);
+                }
+            }
             g_SysFileData.error = false;
             g_SysFileData.file_index = 0;
 			File_Dnld_Status = SYS_OTA_PARSE_JSON;
@@ -66,6 +66,7 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 #include "system/ota/framework/ota_image.h"
 #include "system/ota/framework/int_flash.h"
 #include "system/ota/framework/sha256.h"
+#include "system/ota/framework/ota_lz.h"
 #include "system/ota/framework/http_client/http_client.h"
 #include "system/ota/framework/ota_database_parser.h"
 // DOM-IGNORE-BEGIN
@@ -185,6 +186,8 @@ extern "C" {
         uint32_t slot_address[SYS_OTA_NUM_OF_SLOTS];
         uint32_t slot_size[SYS_OTA_NUM_OF_SLOTS];
         uint32_t file_size_in_slot[SYS_OTA_NUM_OF_SLOTS];
+        /* SHA-256 of the file, computed while it was downloaded */
+        uint8_t file_digest_in_slot[SYS_OTA_NUM_OF_SLOTS][OTA_CRYPT_SHA256_DIGEST_SIZE];
         
     }SYS_OTA_SLOT_INFO;
     
@@ -203,14 +206,107 @@ extern "C" {
 
     }SYS_OTA_FILE_DATA;
 
+    /* Sector buffers for file download; one downloads while the others are
+       programmed */
+#ifndef SYS_OTA_FILE_DOWNLOAD_BUFFERS
+#define SYS_OTA_FILE_DOWNLOAD_BUFFERS   2
+#endif
+
+    /* A raw file is programmed from the downloader buffer, which has to hold
+       those sectors, the one downloading and a TCP segment besides */
+#if (DOWNLOADER_BUFFER_SIZE < (SYS_OTA_FILE_DOWNLOAD_BUFFERS + 1) * FLASH_SECTOR_SIZE + 1460)
+#error "DOWNLOADER_BUFFER_SIZE is too small for SYS_OTA_FILE_DOWNLOAD_BUFFERS"
+#endif
+
+    /* Sectors erased ahead of the one being downloaded */
+#ifndef SYS_OTA_FILE_ERASE_AHEAD
+#define SYS_OTA_FILE_ERASE_AHEAD        1
+#endif
+
+    /* Download buffer feeding the decompressor for compressed files */
+#ifndef SYS_OTA_FILE_LZ_INPUT_SIZE
+#define SYS_OTA_FILE_LZ_INPUT_SIZE      1024
+#endif
+
+    /* Download cursor of an uncompressed file; an interrupted download resumes
+       from the last sector saved in it, after a reset too */
+#ifndef SYS_OTA_FILE_CURSOR_NAME
+#define SYS_OTA_FILE_CURSOR_NAME        "/mnt/myDrive1/ota_cursor.bin"
+#endif
+
+    /* Programmed sectors between cursor updates */
+#ifndef SYS_OTA_FILE_CURSOR_INTERVAL
+#define SYS_OTA_FILE_CURSOR_INTERVAL    16
+#endif
+
+    /* Attempts to resume a download that fail before another sector is received */
+#ifndef SYS_OTA_FILE_RESUME_RETRIES
+#define SYS_OTA_FILE_RESUME_RETRIES     5
+#endif
+
+    /* File length downloaded and hashed up to a sector boundary */
+  typedef struct {
+
+      uint32_t copied_len;
+      OTA_CRYPT_SHA256_CTX sha256;
+
+  }SYS_OTA_FILE_RESUME_POINT;
+
+  typedef struct {
+
+      uint32_t magic;
+      uint32_t slot_address;
+      uint32_t total_len;
+      char url[OTA_URL_SIZE];
+      char digest[64];
+      SYS_OTA_FILE_RESUME_POINT point;
+      uint32_t crc;
+
+  }SYS_OTA_FILE_CURSOR;
+
+    /* Decompressor of a compressed file and its buffers, allocated together */
+  typedef struct {
+
+      OTA_LZ_CTX ctx;
+      uint32_t in_pos;
+      uint32_t in_len;
+      /* File bytes received, including the container header */
+      uint32_t rx_len;
+      uint8_t in[SYS_OTA_FILE_LZ_INPUT_SIZE];
+      uint8_t window[OTA_LZ_WINDOW_SIZE];
+
+  }OTA_FILE_LZ_CONTEXT;
+
      /* File download task context */
   typedef struct {
 
-      CRYPT_SHA256_CTX sha256;
+      OTA_CRYPT_SHA256_CTX sha256;
+      /* Sector buffers of a compressed file; a raw file is programmed from
+         the downloader buffer */
       uint8_t *buf;
+      uint8_t *sector;
       uint32_t buf_len;
       uint32_t copied_len;
       uint32_t total_len;
+      /* Sector buffer being downloaded and the NVM write ticket of each */
+      uint8_t buf_index;
+      uint32_t buf_ticket[SYS_OTA_FILE_DOWNLOAD_BUFFERS];
+      /* Bytes of a raw file the downloader keeps for each buffer until its
+         sector is programmed, and their total */
+      uint32_t buf_held[SYS_OTA_FILE_DOWNLOAD_BUFFERS];
+      uint32_t ring_offset;
+      /* End of the slot region erased or queued for erase */
+      uint32_t erase_addr;
+      /* Length of the image in the slot; differs from total_len for a
+         compressed file, which is decompressed while it downloads */
+      uint32_t image_len;
+      bool probed;
+      OTA_FILE_LZ_CONTEXT *lz;
+      /* Resume point reached once each buffer's sector is programmed, and
+         the length in the saved cursor */
+      SYS_OTA_FILE_RESUME_POINT pending[SYS_OTA_FILE_DOWNLOAD_BUFFERS];
+      uint32_t saved_len;
+      uint8_t retries;
 
   }OTA_FILE_DOWNLOAD_TASK_CONTEXT;
     
@@ -252,6 +348,8 @@ extern "C" {
         
         SYS_OTA_FILE_WRITE_TO_NVM,
                 
+        SYS_OTA_FILE_RESUME,
+                
         SYS_OTA_FILE_DOWNLOAD_DONE,
         
     } SYS_OTA_FILE_DOWNLOAD_STATE;
@@ -306,6 +404,8 @@ extern "C" {
   
   void OTA_UpdateBootctl(void);
 
+  void OTA_SetImageDigest(uint32_t size, const uint8_t *digest);
+
   void SYS_OTA_SystemReset(void);
 
 
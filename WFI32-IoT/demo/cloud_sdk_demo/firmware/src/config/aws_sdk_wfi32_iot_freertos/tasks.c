@@ -53,6 +53,7 @@
 #include "configuration.h"
 #include "definitions.h"
 #include "sys_tasks.h"
+#include "net_pres/pres/net_pres_enc_glue.h"
 
 
 // *****************************************************************************
@@ -131,6 +132,7 @@ void _NET_PRES_Tasks(  void *pvParameters  )
     while(1)
     {
         NET_PRES_Tasks(sysObj.netPres);
+        NET_PRES_EncGlue_IdleTasks();
         vTaskDelay(1 / portTICK_PERIOD_MS);
     }
 }
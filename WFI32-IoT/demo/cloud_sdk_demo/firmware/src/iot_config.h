@@ -37,6 +37,8 @@
 #define SUBSCRIBE_TOPIC_COUNT                    ( 1 )
 #define PUBLISH_RETRY_LIMIT                      ( 10 )
 #define PUBLISH_RETRY_MS                         ( 1000 )
+#define IOT_MQTT_PUBLISH_ARENA_SLOTS             ( 4 )     //one per in-flight QoS 1 telemetry/shadow message
+#define IOT_MQTT_PUBLISH_ARENA_SLOT_SIZE         ( 256 )   //fixed header + APP_AWS_TOPIC_NAME_MAX_LEN + APP_AWS_MAX_MSG_LLENGTH
 
 /* Enable asserts in the libraries. */
 #define IOT_CONTAINERS_ENABLE_ASSERTS           ( 0 )
@@ -48,6 +48,7 @@
  * - @functionname{mqtt_function_unsubscribeasync}
  * - @functionname{mqtt_function_unsubscribesync}
  * - @functionname{mqtt_function_publishasync}
+ * - @functionname{mqtt_function_publishinplaceasync}
  * - @functionname{mqtt_function_publishsync}
  * - @functionname{mqtt_function_wait}
  * - @functionname{mqtt_function_strerror}
@@ -66,6 +67,7 @@
  * @functionpage{IotMqtt_UnsubscribeAsync,mqtt,unsubscribeasync}
  * @functionpage{IotMqtt_UnsubscribeSync,mqtt,unsubscribesync}
  * @functionpage{IotMqtt_PublishAsync,mqtt,publishasync}
+ * @functionpage{IotMqtt_PublishInPlaceAsync,mqtt,publishinplaceasync}
  * @functionpage{IotMqtt_PublishSync,mqtt,publishsync}
  * @functionpage{IotMqtt_Wait,mqtt,wait}
  * @functionpage{IotMqtt_strerror,mqtt,strerror}
@@ -666,6 +668,42 @@ IotMqttError_t IotMqtt_PublishAsync( IotMqttConnection_t mqttConnection,
                                      IotMqttOperation_t * const pPublishOperation );
 /* @[declare_mqtt_publishasync] */
 
+/**
+ * @brief Publish a message whose payload is written directly into the
+ * PUBLISH packet.
+ *
+ * This function behaves like @ref mqtt_function_publishasync, but instead of
+ * copying `pPublishInfo->pPayload` into a newly allocated packet, it reserves
+ * a slot of a static packet arena and lets `payloadWriter` fill in the payload
+ * behind the packet header. The slot is released once the packet is no longer
+ * needed, i.e. after the send of a QoS 0 message or the PUBACK of a QoS 1
+ * message. When every slot is busy, a heap buffer is used instead.
+ *
+ * The payload can be at most #IOT_MQTT_PUBLISH_ARENA_SLOT_SIZE bytes minus the
+ * packet header.
+ *
+ * @param[in] mqttConnection The MQTT connection to use for the publish.
+ * @param[in] pPublishInfo MQTT publish parameters. The `pPayload` and
+ * `payloadLength` members are ignored.
+ * @param[in] payloadWriter Called once to write the payload.
+ * @param[in] pWriterContext Passed to `payloadWriter`.
+ * @param[in] flags Flags which modify the behavior of this function. See @ref mqtt_constants_flags.
+ * @param[in] pCallbackInfo Asynchronous notification of this function's completion (`NULL` to disable).
+ * @param[out] pPublishOperation Set to a handle by which this operation may be
+ * referenced after this function returns.
+ *
+ * @return Same as @ref mqtt_function_publishasync.
+ */
+/* @[declare_mqtt_publishinplaceasync] */
+IotMqttError_t IotMqtt_PublishInPlaceAsync( IotMqttConnection_t mqttConnection,
+                                            const IotMqttPublishInfo_t * pPublishInfo,
+                                            IotMqttPayloadWriter_t payloadWriter,
+                                            void * pWriterContext,
+                                            uint32_t flags,
+                                            const IotMqttCallbackInfo_t * pCallbackInfo,
+                                            IotMqttOperation_t * const pPublishOperation );
+/* @[declare_mqtt_publishinplaceasync] */
+
 /**
  * @brief Publish a message to the given topic name with a timeout.
  *
@@ -400,6 +400,24 @@ typedef struct IotMqttPublishInfo
     uint32_t retryLimit;      /**< @brief How many times to attempt retransmission. */
 } IotMqttPublishInfo_t;
 
+/**
+ * @ingroup mqtt_datatypes_paramstructs
+ * @brief Writes a PUBLISH payload directly into its packet buffer.
+ *
+ * @paramfor @ref mqtt_function_publishinplaceasync
+ *
+ * @param[in] pContext The `pWriterContext` passed to
+ * @ref mqtt_function_publishinplaceasync.
+ * @param[out] pBuffer Where the payload is written.
+ * @param[in] bufferSize Space available at `pBuffer`.
+ *
+ * @return The number of payload bytes written. A value greater than
+ * `bufferSize` fails the PUBLISH with #IOT_MQTT_BAD_PARAMETER.
+ */
+typedef size_t ( * IotMqttPayloadWriter_t )( void * pContext,
+                                             uint8_t * pBuffer,
+                                             size_t bufferSize );
+
 /**
  * @ingroup mqtt_datatypes_paramstructs
  * @brief Parameter to an MQTT callback function.
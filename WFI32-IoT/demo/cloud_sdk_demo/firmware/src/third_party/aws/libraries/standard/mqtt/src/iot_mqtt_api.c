@@ -205,6 +205,22 @@ static IotMqttError_t _subscriptionCommon( IotMqttOperationType_t operation,
                                            const IotMqttCallbackInfo_t * pCallbackInfo,
                                            IotMqttOperation_t * const pOperationReference );
 
+/**
+ * @brief The common component of both @ref mqtt_function_publishasync and @ref
+ * mqtt_function_publishinplaceasync.
+ *
+ * `payloadWriter` is `NULL` for @ref mqtt_function_publishasync. See @ref
+ * mqtt_function_publishinplaceasync for a description of the other parameters
+ * and return values.
+ */
+static IotMqttError_t _publishCommon( IotMqttConnection_t mqttConnection,
+                                      const IotMqttPublishInfo_t * pPublishInfo,
+                                      IotMqttPayloadWriter_t payloadWriter,
+                                      void * pWriterContext,
+                                      uint32_t flags,
+                                      const IotMqttCallbackInfo_t * pCallbackInfo,
+                                      IotMqttOperation_t * const pPublishOperation );
+
 /**
  * @cond DOXYGEN_IGNORE
  * Doxygen should ignore this section.
@@ -314,6 +330,9 @@ static void _mqttSubscription_tryDestroy( void * pData )
     /* Unsubscribed flag should be set. */
     IotMqtt_Assert( pSubscription->unsubscribed == true );
 
+    /* The subscription was removed from the list, so remove it from the trie. */
+    _IotMqtt_RemoveSubscriptionTopicNodes( pSubscription );
+
     /* Free the subscription if it has no references. */
     if( pSubscription->references == 0 )
     {
@@ -545,6 +564,7 @@ static _mqttConnection_t * _createMqttConnection( bool awsIotMqttMode,
 
     /* Create the new connection's subscription and operation lists. */
     IotListDouble_Create( &( pMqttConnection->subscriptionList ) );
+    IotListDouble_Create( &( pMqttConnection->subscriptionTrie ) );
     IotListDouble_Create( &( pMqttConnection->pendingProcessing ) );
     IotListDouble_Create( &( pMqttConnection->pendingResponse ) );
 
@@ -1616,15 +1636,19 @@ IotMqttError_t IotMqtt_UnsubscribeSync( IotMqttConnection_t mqttConnection,
 
 /*-----------------------------------------------------------*/
 
-IotMqttError_t IotMqtt_PublishAsync( IotMqttConnection_t mqttConnection,
-                                     const IotMqttPublishInfo_t * pPublishInfo,
-                                     uint32_t flags,
-                                     const IotMqttCallbackInfo_t * pCallbackInfo,
-                                     IotMqttOperation_t * const pPublishOperation )
+static IotMqttError_t _publishCommon( IotMqttConnection_t mqttConnection,
+                                      const IotMqttPublishInfo_t * pPublishInfo,
+                                      IotMqttPayloadWriter_t payloadWriter,
+                                      void * pWriterContext,
+                                      uint32_t flags,
+                                      const IotMqttCallbackInfo_t * pCallbackInfo,
+                                      IotMqttOperation_t * const pPublishOperation )
 {
     IOT_FUNCTION_ENTRY( IotMqttError_t, IOT_MQTT_SUCCESS );
     _mqttOperation_t * pOperation = NULL;
     uint8_t ** pPacketIdentifierHigh = NULL;
+    IotMqttPublishInfo_t headerInfo = { 0 };
+    const IotMqttPublishInfo_t * pValidateInfo = pPublishInfo;
 
     /* Check that IotMqtt_Init was called. */
     if( _checkInit() == false )
@@ -1636,9 +1660,38 @@ IotMqttError_t IotMqtt_PublishAsync( IotMqttConnection_t mqttConnection,
         EMPTY_ELSE_MARKER;
     }
 
+    /* A payload written in place does not exist yet, so only the header
+     * parameters can be validated. */
+    if( payloadWriter != NULL )
+    {
+        headerInfo = *pPublishInfo;
+        headerInfo.pPayload = NULL;
+        headerInfo.payloadLength = 0;
+        pValidateInfo = &headerInfo;
+
+        #if IOT_MQTT_ENABLE_SERIALIZER_OVERRIDES == 1
+            /* In-place packets come from the built-in serializer and can't be
+             * released by a free packet override. */
+            if( mqttConnection->pSerializer != NULL )
+            {
+                IotLogError( "In-place PUBLISH is not supported with serializer overrides." );
+
+                IOT_SET_AND_GOTO_CLEANUP( IOT_MQTT_BAD_PARAMETER );
+            }
+            else
+            {
+                EMPTY_ELSE_MARKER;
+            }
+        #endif
+    }
+    else
+    {
+        EMPTY_ELSE_MARKER;
+    }
+
     /* Check that the PUBLISH information is valid. */
     if( _IotMqtt_ValidatePublish( mqttConnection->awsIotMqttMode,
-                                  pPublishInfo ) == false )
+                                  pValidateInfo ) == false )
     {
         IOT_SET_AND_GOTO_CLEANUP( IOT_MQTT_BAD_PARAMETER );
     }
@@ -1730,11 +1783,24 @@ IotMqttError_t IotMqtt_PublishAsync( IotMqttConnection_t mqttConnection,
     }
 
     /* Generate a PUBLISH packet from pPublishInfo. */
-    status = _getMqttPublishSerializer( mqttConnection->pSerializer )( pPublishInfo,
-                                                                       &( pOperation->u.operation.pMqttPacket ),
-                                                                       &( pOperation->u.operation.packetSize ),
-                                                                       &( pOperation->u.operation.packetIdentifier ),
-                                                                       pPacketIdentifierHigh );
+    if( payloadWriter != NULL )
+    {
+        status = _IotMqtt_SerializePublishInPlace( pPublishInfo,
+                                                   payloadWriter,
+                                                   pWriterContext,
+                                                   &( pOperation->u.operation.pMqttPacket ),
+                                                   &( pOperation->u.operation.packetSize ),
+                                                   &( pOperation->u.operation.packetIdentifier ),
+                                                   pPacketIdentifierHigh );
+    }
+    else
+    {
+        status = _getMqttPublishSerializer( mqttConnection->pSerializer )( pPublishInfo,
+                                                                           &( pOperation->u.operation.pMqttPacket ),
+                                                                           &( pOperation->u.operation.packetSize ),
+                                                                           &( pOperation->u.operation.packetIdentifier ),
+                                                                           pPacketIdentifierHigh );
+    }
 
     if( status != IOT_MQTT_SUCCESS )
     {
@@ -1862,6 +1928,52 @@ IotMqttError_t IotMqtt_PublishAsync( IotMqttConnection_t mqttConnection,
 
 /*-----------------------------------------------------------*/
 
+IotMqttError_t IotMqtt_PublishAsync( IotMqttConnection_t mqttConnection,
+                                     const IotMqttPublishInfo_t * pPublishInfo,
+                                     uint32_t flags,
+                                     const IotMqttCallbackInfo_t * pCallbackInfo,
+                                     IotMqttOperation_t * const pPublishOperation )
+{
+    return _publishCommon( mqttConnection,
+                           pPublishInfo,
+                           NULL,
+                           NULL,
+                           flags,
+                           pCallbackInfo,
+                           pPublishOperation );
+}
+
+/*-----------------------------------------------------------*/
+
+IotMqttError_t IotMqtt_PublishInPlaceAsync( IotMqttConnection_t mqttConnection,
+                                            const IotMqttPublishInfo_t * pPublishInfo,
+                                            IotMqttPayloadWriter_t payloadWriter,
+                                            void * pWriterContext,
+                                            uint32_t flags,
+                                            const IotMqttCallbackInfo_t * pCallbackInfo,
+                                            IotMqttOperation_t * const pPublishOperation )
+{
+    IotMqttError_t status = IOT_MQTT_BAD_PARAMETER;
+
+    if( payloadWriter == NULL )
+    {
+        IotLogError( "In-place PUBLISH requires a payload writer." );
+    }
+    else
+    {
+        status = _publishCommon( mqttConnection,
+                                 pPublishInfo,
+                                 payloadWriter,
+                                 pWriterContext,
+                                 flags,
+                                 pCallbackInfo,
+                                 pPublishOperation );
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
 IotMqttError_t IotMqtt_PublishSync( IotMqttConnection_t mqttConnection,
                                     const IotMqttPublishInfo_t * pPublishInfo,
                                     uint32_t flags,
@@ -337,6 +337,22 @@ static void _serializeUnsubscribe( const IotMqttSubscription_t * pSubscriptionLi
                             uint8_t * pBuffer,
                             size_t unsubscribePacketSize );
 
+/**
+ * @brief Reserve a free slot of the static PUBLISH arena.
+ *
+ * @return Pointer to the slot, or `NULL` if all slots are in use.
+ */
+static uint8_t * _publishArenaAcquire( void );
+
+/**
+ * @brief Release the PUBLISH arena slot holding a packet.
+ *
+ * @param[in] pPacket Any pointer into the packet.
+ *
+ * @return `true` if the packet was in the arena; `false` otherwise.
+ */
+static bool _publishArenaRelease( const uint8_t * pPacket );
+
 /*-----------------------------------------------------------*/
 
 #if LIBRARY_LOG_LEVEL > IOT_LOG_NONE
@@ -353,6 +369,73 @@ static void _serializeUnsubscribe( const IotMqttSubscription_t * pSubscriptionLi
     };
 #endif
 
+/**
+ * @brief Static buffers for PUBLISH packets whose payload is written in place.
+ *
+ * A slot stays in use until its packet is freed, i.e. after the send of a
+ * QoS 0 PUBLISH or the PUBACK of a QoS 1 PUBLISH.
+ */
+static uint8_t _publishArena[ IOT_MQTT_PUBLISH_ARENA_SLOTS ][ IOT_MQTT_PUBLISH_ARENA_SLOT_SIZE ];
+
+/**
+ * @brief Bitmask of the #_publishArena slots in use.
+ */
+static volatile uint32_t _publishArenaInUse = 0;
+
+/*-----------------------------------------------------------*/
+
+static uint8_t * _publishArenaAcquire( void )
+{
+    uint8_t * pSlot = NULL;
+    uint32_t inUse = 0, slot = 0;
+
+    while( slot < IOT_MQTT_PUBLISH_ARENA_SLOTS )
+    {
+        inUse = _publishArenaInUse;
+
+        if( ( inUse & ( 1UL << slot ) ) != 0 )
+        {
+            slot++;
+        }
+        else if( Atomic_CompareAndSwap_u32( &_publishArenaInUse,
+                                            inUse | ( 1UL << slot ),
+                                            inUse ) == 1 )
+        {
+            pSlot = _publishArena[ slot ];
+            break;
+        }
+        else
+        {
+            /* Lost a race with another task; look at this slot again. */
+            EMPTY_ELSE_MARKER;
+        }
+    }
+
+    return pSlot;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool _publishArenaRelease( const uint8_t * pPacket )
+{
+    bool status = false;
+    uint32_t slot = 0;
+
+    if( ( pPacket >= _publishArena[ 0 ] ) &&
+        ( pPacket < _publishArena[ 0 ] + sizeof( _publishArena ) ) )
+    {
+        slot = ( uint32_t ) ( pPacket - _publishArena[ 0 ] ) / IOT_MQTT_PUBLISH_ARENA_SLOT_SIZE;
+        ( void ) Atomic_AND_u32( &_publishArenaInUse, ~( 1UL << slot ) );
+        status = true;
+    }
+    else
+    {
+        EMPTY_ELSE_MARKER;
+    }
+
+    return status;
+}
+
 /*-----------------------------------------------------------*/
 
 static uint16_t _nextPacketIdentifier( void )
@@ -961,10 +1044,19 @@ static void _serializePublish( const IotMqttPublishInfo_t * pPublishInfo,
         EMPTY_ELSE_MARKER;
     }
 
-    /* The payload is placed after the packet identifier. */
+    /* The payload is placed after the packet identifier. A payload written in
+     * place is already there. */
     if( pPublishInfo->payloadLength > 0 )
     {
-        ( void ) memcpy( pBuffer, pPublishInfo->pPayload, pPublishInfo->payloadLength );
+        if( pPublishInfo->pPayload != pBuffer )
+        {
+            ( void ) memcpy( pBuffer, pPublishInfo->pPayload, pPublishInfo->payloadLength );
+        }
+        else
+        {
+            EMPTY_ELSE_MARKER;
+        }
+
         pBuffer += pPublishInfo->payloadLength;
     }
     else
@@ -1458,6 +1550,147 @@ IotMqttError_t _IotMqtt_SerializePublish( const IotMqttPublishInfo_t * pPublishI
 
 /*-----------------------------------------------------------*/
 
+IotMqttError_t _IotMqtt_SerializePublishInPlace( const IotMqttPublishInfo_t * pPublishInfo,
+                                                 IotMqttPayloadWriter_t payloadWriter,
+                                                 void * pWriterContext,
+                                                 uint8_t ** pPublishPacket,
+                                                 size_t * pPacketSize,
+                                                 uint16_t * pPacketIdentifier,
+                                                 uint8_t ** pPacketIdentifierHigh )
+{
+    IOT_FUNCTION_ENTRY( IotMqttError_t, IOT_MQTT_SUCCESS );
+    IotMqttPublishInfo_t publishInfo = *pPublishInfo;
+    size_t headerSize = 0, payloadSpace = 0, headerOffset = 0;
+    size_t remainingLength = 0, publishPacketSize = 0;
+    uint8_t * pBuffer = NULL, * pPacket = NULL;
+    bool arenaSlot = true;
+
+    /* Reserve room for the largest possible header: packet type, a 4-byte
+     * "Remaining length", the topic name and a packet identifier. */
+    headerSize = 1 + 4 + sizeof( uint16_t ) + pPublishInfo->topicNameLength;
+
+    if( pPublishInfo->qos > IOT_MQTT_QOS_0 )
+    {
+        headerSize += sizeof( uint16_t );
+    }
+    else
+    {
+        EMPTY_ELSE_MARKER;
+    }
+
+    if( headerSize >= IOT_MQTT_PUBLISH_ARENA_SLOT_SIZE )
+    {
+        IotLogError( "PUBLISH topic does not fit in an arena slot of %lu bytes.",
+                     ( unsigned long ) IOT_MQTT_PUBLISH_ARENA_SLOT_SIZE );
+
+        IOT_SET_AND_GOTO_CLEANUP( IOT_MQTT_BAD_PARAMETER );
+    }
+    else
+    {
+        EMPTY_ELSE_MARKER;
+    }
+
+    pBuffer = _publishArenaAcquire();
+
+    if( pBuffer == NULL )
+    {
+        /* Every slot is waiting on a send or PUBACK. */
+        IotLogDebug( "PUBLISH arena exhausted; allocating packet." );
+
+        arenaSlot = false;
+        pBuffer = IotMqtt_MallocMessage( IOT_MQTT_PUBLISH_ARENA_SLOT_SIZE );
+
+        if( pBuffer == NULL )
+        {
+            IotLogError( "Failed to allocate memory for PUBLISH packet." );
+
+            IOT_SET_AND_GOTO_CLEANUP( IOT_MQTT_NO_MEMORY );
+        }
+        else
+        {
+            EMPTY_ELSE_MARKER;
+        }
+    }
+    else
+    {
+        EMPTY_ELSE_MARKER;
+    }
+
+    /* Let the caller write the payload behind the reserved header. */
+    payloadSpace = IOT_MQTT_PUBLISH_ARENA_SLOT_SIZE - headerSize;
+    publishInfo.payloadLength = payloadWriter( pWriterContext,
+                                               pBuffer + headerSize,
+                                               payloadSpace );
+
+    if( publishInfo.payloadLength > payloadSpace )
+    {
+        IotLogError( "PUBLISH payload writer overflowed %lu bytes.",
+                     ( unsigned long ) payloadSpace );
+
+        IOT_SET_AND_GOTO_CLEANUP( IOT_MQTT_BAD_PARAMETER );
+    }
+    else
+    {
+        EMPTY_ELSE_MARKER;
+    }
+
+    /* A slot is much smaller than the MQTT limit, so this always succeeds. */
+    ( void ) _publishPacketSize( &publishInfo, &remainingLength, &publishPacketSize );
+
+    /* The actual header is usually shorter than the reserved one. Start the
+     * packet so that its header ends right where the payload begins. */
+    headerOffset = headerSize - ( publishPacketSize - publishInfo.payloadLength );
+    pPacket = pBuffer + headerOffset;
+
+    /* A heap buffer must be freed through its start, so move the payload down
+     * instead. This only happens when the arena is exhausted. */
+    if( ( arenaSlot == false ) && ( headerOffset > 0 ) )
+    {
+        ( void ) memmove( pBuffer + headerSize - headerOffset,
+                          pBuffer + headerSize,
+                          publishInfo.payloadLength );
+        pPacket = pBuffer;
+    }
+    else
+    {
+        EMPTY_ELSE_MARKER;
+    }
+
+    publishInfo.pPayload = pPacket + publishPacketSize - publishInfo.payloadLength;
+
+    _serializePublish( &publishInfo,
+                       remainingLength,
+                       pPacketIdentifier,
+                       pPacketIdentifierHigh,
+                       pPacket,
+                       publishPacketSize );
+
+    *pPublishPacket = pPacket;
+    *pPacketSize = publishPacketSize;
+
+    IOT_FUNCTION_CLEANUP_BEGIN();
+
+    if( ( status != IOT_MQTT_SUCCESS ) && ( pBuffer != NULL ) )
+    {
+        if( _publishArenaRelease( pBuffer ) == false )
+        {
+            IotMqtt_FreeMessage( pBuffer );
+        }
+        else
+        {
+            EMPTY_ELSE_MARKER;
+        }
+    }
+    else
+    {
+        EMPTY_ELSE_MARKER;
+    }
+
+    IOT_FUNCTION_CLEANUP_END();
+}
+
+/*-----------------------------------------------------------*/
+
 void _IotMqtt_PublishSetDup( uint8_t * pPublishPacket,
                              uint8_t * pPacketIdentifierHigh,
                              uint16_t * pNewPacketIdentifier )
@@ -2165,9 +2398,14 @@ void _IotMqtt_FreePacket( uint8_t * pPacket )
 {
     uint8_t packetType = *pPacket;
 
-    /* Don't call free on DISCONNECT and PINGREQ; those are allocated from static
+    /* PUBLISH packets written in place only give back their arena slot. Don't
+     * call free on DISCONNECT and PINGREQ; those are allocated from static
      * memory. */
-    if( packetType != MQTT_PACKET_TYPE_DISCONNECT )
+    if( _publishArenaRelease( pPacket ) == true )
+    {
+        EMPTY_ELSE_MARKER;
+    }
+    else if( packetType != MQTT_PACKET_TYPE_DISCONNECT )
     {
         if( packetType != MQTT_PACKET_TYPE_PINGREQ )
         {
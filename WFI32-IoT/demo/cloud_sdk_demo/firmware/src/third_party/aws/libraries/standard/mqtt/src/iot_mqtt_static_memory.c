@@ -58,6 +58,9 @@
 #ifndef IOT_MQTT_SUBSCRIPTIONS
     #define IOT_MQTT_SUBSCRIPTIONS                 ( 8 )
 #endif
+#ifndef IOT_MQTT_TOPIC_NODES
+    #define IOT_MQTT_TOPIC_NODES                   ( 4 * IOT_MQTT_SUBSCRIPTIONS )
+#endif
 /** @endcond */
 
 /* Validate static memory configuration settings. */
@@ -70,6 +73,9 @@
 #if IOT_MQTT_SUBSCRIPTIONS <= 0
     #error "IOT_MQTT_SUBSCRIPTIONS cannot be 0 or negative."
 #endif
+#if IOT_MQTT_TOPIC_NODES <= 0
+    #error "IOT_MQTT_TOPIC_NODES cannot be 0 or negative."
+#endif
 
 /**
  * @brief The size of a static memory MQTT subscription.
@@ -80,6 +86,15 @@
  */
 #define MQTT_SUBSCRIPTION_SIZE    ( sizeof( _mqttSubscription_t ) + AWS_IOT_MQTT_SERVER_MAX_TOPIC_LENGTH )
 
+/**
+ * @brief The size of a static memory MQTT topic node.
+ *
+ * A topic level is never longer than a topic, so the constant
+ * #AWS_IOT_MQTT_SERVER_MAX_TOPIC_LENGTH is used for the length of
+ * #_mqttTopicNode_t.pLevel.
+ */
+#define MQTT_TOPIC_NODE_SIZE      ( sizeof( _mqttTopicNode_t ) + AWS_IOT_MQTT_SERVER_MAX_TOPIC_LENGTH )
+
 /*-----------------------------------------------------------*/
 
 /*
@@ -94,6 +109,9 @@ static _mqttOperation_t _pMqttOperations[ IOT_MQTT_MAX_IN_PROGRESS_OPERATIONS ]
 static uint32_t _pInUseMqttSubscriptions[ IOT_MQTT_SUBSCRIPTIONS ] = { 0U };                      /**< @brief MQTT subscription in-use flags. */
 static char _pMqttSubscriptions[ IOT_MQTT_SUBSCRIPTIONS ][ MQTT_SUBSCRIPTION_SIZE ] = { { 0 } };  /**< @brief MQTT subscriptions. */
 
+static uint32_t _pInUseMqttTopicNodes[ IOT_MQTT_TOPIC_NODES ] = { 0U };                           /**< @brief MQTT topic node in-use flags. */
+static char _pMqttTopicNodes[ IOT_MQTT_TOPIC_NODES ][ MQTT_TOPIC_NODE_SIZE ] = { { 0 } };           /**< @brief MQTT topic nodes. */
+
 /*-----------------------------------------------------------*/
 
 void * IotMqtt_MallocConnection( size_t size )
@@ -200,4 +218,38 @@ void IotMqtt_FreeSubscription( void * ptr )
 
 /*-----------------------------------------------------------*/
 
+void * IotMqtt_MallocTopicNode( size_t size )
+{
+    int32_t freeIndex = -1;
+    void * pNewTopicNode = NULL;
+
+    if( size <= MQTT_TOPIC_NODE_SIZE )
+    {
+        /* Get the index of a free MQTT topic node. */
+        freeIndex = IotStaticMemory_FindFree( _pInUseMqttTopicNodes,
+                                              IOT_MQTT_TOPIC_NODES );
+
+        if( freeIndex != -1 )
+        {
+            pNewTopicNode = &( _pMqttTopicNodes[ freeIndex ][ 0 ] );
+        }
+    }
+
+    return pNewTopicNode;
+}
+
+/*-----------------------------------------------------------*/
+
+void IotMqtt_FreeTopicNode( void * ptr )
+{
+    /* Return the in-use MQTT topic node. */
+    IotStaticMemory_ReturnInUse( ptr,
+                                 _pMqttTopicNodes,
+                                 _pInUseMqttTopicNodes,
+                                 IOT_MQTT_TOPIC_NODES,
+                                 MQTT_TOPIC_NODE_SIZE );
+}
+
+/*-----------------------------------------------------------*/
+
 #endif
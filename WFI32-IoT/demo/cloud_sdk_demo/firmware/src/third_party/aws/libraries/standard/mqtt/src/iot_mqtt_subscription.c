@@ -62,6 +62,23 @@ typedef struct _packetMatchParams
     int32_t order;             /**< Order to match. Set to #MQTT_REMOVE_ALL_SUBSCRIPTIONS to ignore. */
 } _packetMatchParams_t;
 
+/**
+ * @brief Last parameter to #_matchTopicLevels.
+ *
+ * Matches are collected in order of their address, which does not change
+ * while the subscription mutex is released between batches. Each batch
+ * resumes after the last subscription of the previous one, so when other
+ * subscriptions are added or removed in between, a subscription that stays
+ * registered still gets exactly one callback.
+ */
+typedef struct _trieMatchParams
+{
+    uintptr_t cursor; /**< @brief Address of the last subscription whose callback was already invoked; `0` for the first batch. */
+    size_t count;     /**< @brief Number of subscriptions in #_trieMatchParams_t.pMatches. */
+    bool more;        /**< @brief Whether more subscriptions matched than fit in #_trieMatchParams_t.pMatches. */
+    _mqttSubscription_t * pMatches[ IOT_MQTT_DISPATCH_BATCH_SIZE ]; /**< @brief Matching subscriptions, sorted by address. */
+} _trieMatchParams_t;
+
 /*-----------------------------------------------------------*/
 
 /**
@@ -89,6 +106,86 @@ static bool _topicMatch( const IotLink_t * pSubscriptionLink,
 static bool _packetMatch( const IotLink_t * pSubscriptionLink,
                           void * pMatch );
 
+/**
+ * @brief Calculates the length of the first level of a topic name or filter.
+ *
+ * @param[in] pTopic The topic name or filter, starting at a level.
+ * @param[in] topicLength Length of `pTopic`.
+ *
+ * @return Length of the level, excluding the '/' that ends it.
+ */
+static uint16_t _topicLevelLength( const char * pTopic,
+                                   uint16_t topicLength );
+
+/**
+ * @brief Finds a topic level among the children of a trie node.
+ *
+ * @param[in] pLevels The list of topic levels to search.
+ * @param[in] pLevel The topic level to find.
+ * @param[in] levelLength Length of `pLevel`.
+ *
+ * @return The matching trie node; `NULL` if not found.
+ */
+static _mqttTopicNode_t * _findTopicLevel( const IotListDouble_t * pLevels,
+                                           const char * pLevel,
+                                           uint16_t levelLength );
+
+/**
+ * @brief Adds a subscription to the subscription trie of an MQTT connection.
+ *
+ * @param[in] pMqttConnection The MQTT connection that owns the trie.
+ * @param[in] pSubscription The subscription to add.
+ *
+ * @return `true` if the subscription was added; `false` if memory allocation
+ * failed.
+ */
+static bool _insertTopicNodes( _mqttConnection_t * pMqttConnection,
+                               _mqttSubscription_t * pSubscription );
+
+/**
+ * @brief Frees trie nodes that no longer lead to a subscription, starting
+ * at a node and moving towards the first level.
+ *
+ * @param[in] pNode The first node to check.
+ */
+static void _pruneTopicNodes( _mqttTopicNode_t * pNode );
+
+/**
+ * @brief Adds a matching subscription to the current dispatch batch.
+ *
+ * The batch keeps the #IOT_MQTT_DISPATCH_BATCH_SIZE lowest addresses after
+ * #_trieMatchParams_t.cursor.
+ *
+ * @param[in,out] pMatch The dispatch batch.
+ * @param[in] pSubscription The matching subscription; may be `NULL`.
+ */
+static void _addMatch( _trieMatchParams_t * pMatch,
+                       _mqttSubscription_t * pSubscription );
+
+/**
+ * @brief Collects the subscriptions whose topic filters match a topic name.
+ *
+ * Each level of the topic name is compared with the matching literal level
+ * and the `+` and `#` wildcards only, so the cost depends on the number of
+ * topic levels rather than the number of subscriptions.
+ *
+ * @param[in] pLevels The trie nodes for the first level of `pTopicName`.
+ * @param[in] pTopicName The topic name, starting at a level.
+ * @param[in] topicNameLength Length of `pTopicName`.
+ * @param[in,out] pMatch Collects the matching subscriptions.
+ */
+static void _matchTopicLevels( const IotListDouble_t * pLevels,
+                               const char * pTopicName,
+                               uint16_t topicNameLength,
+                               _trieMatchParams_t * pMatch );
+
+/**
+ * @brief Frees a subscription removed from the subscription list.
+ *
+ * @param[in] pData The subscription to free.
+ */
+static void _freeSubscription( void * pData );
+
 /*-----------------------------------------------------------*/
 
 static bool _topicMatch( const IotLink_t * pSubscriptionLink,
@@ -307,6 +404,257 @@ static bool _packetMatch( const IotLink_t * pSubscriptionLink,
 
 /*-----------------------------------------------------------*/
 
+static uint16_t _topicLevelLength( const char * pTopic,
+                                   uint16_t topicLength )
+{
+    uint16_t levelLength = 0;
+
+    while( ( levelLength < topicLength ) && ( pTopic[ levelLength ] != '/' ) )
+    {
+        levelLength++;
+    }
+
+    return levelLength;
+}
+
+/*-----------------------------------------------------------*/
+
+static _mqttTopicNode_t * _findTopicLevel( const IotListDouble_t * pLevels,
+                                           const char * pLevel,
+                                           uint16_t levelLength )
+{
+    _mqttTopicNode_t * pNode = NULL;
+    const IotLink_t * pLink = NULL;
+
+    IotContainers_ForEach( pLevels, pLink )
+    {
+        pNode = IotLink_Container( _mqttTopicNode_t, pLink, link );
+
+        if( ( pNode->levelLength == levelLength ) &&
+            ( memcmp( pNode->pLevel, pLevel, levelLength ) == 0 ) )
+        {
+            return pNode;
+        }
+        else
+        {
+            EMPTY_ELSE_MARKER;
+        }
+    }
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool _insertTopicNodes( _mqttConnection_t * pMqttConnection,
+                               _mqttSubscription_t * pSubscription )
+{
+    const char * pLevel = pSubscription->pTopicFilter;
+    uint16_t remainingLength = pSubscription->topicFilterLength, levelLength = 0;
+    IotListDouble_t * pLevels = &( pMqttConnection->subscriptionTrie );
+    _mqttTopicNode_t * pNode = NULL, * pParent = NULL;
+
+    while( true )
+    {
+        levelLength = _topicLevelLength( pLevel, remainingLength );
+
+        /* Reuse the level if another topic filter shares it. */
+        pNode = _findTopicLevel( pLevels, pLevel, levelLength );
+
+        if( pNode == NULL )
+        {
+            pNode = IotMqtt_MallocTopicNode( sizeof( _mqttTopicNode_t ) + levelLength );
+
+            if( pNode == NULL )
+            {
+                /* Free the levels added for this subscription. */
+                if( pParent != NULL )
+                {
+                    _pruneTopicNodes( pParent );
+                }
+                else
+                {
+                    EMPTY_ELSE_MARKER;
+                }
+
+                return false;
+            }
+            else
+            {
+                EMPTY_ELSE_MARKER;
+            }
+
+            ( void ) memset( pNode, 0x00, sizeof( _mqttTopicNode_t ) );
+            pNode->pParent = pParent;
+            IotListDouble_Create( &( pNode->children ) );
+            pNode->levelLength = levelLength;
+            ( void ) memcpy( pNode->pLevel, pLevel, levelLength );
+
+            IotListDouble_InsertTail( pLevels, &( pNode->link ) );
+        }
+        else
+        {
+            EMPTY_ELSE_MARKER;
+        }
+
+        /* Stop at the last level of the topic filter. */
+        if( levelLength == remainingLength )
+        {
+            break;
+        }
+        else
+        {
+            EMPTY_ELSE_MARKER;
+        }
+
+        /* Move past the level and its '/'. */
+        pLevel += levelLength + 1;
+        remainingLength = ( uint16_t ) ( remainingLength - levelLength - 1 );
+        pParent = pNode;
+        pLevels = &( pNode->children );
+    }
+
+    /* Only one subscription exists per topic filter. */
+    IotMqtt_Assert( pNode->pSubscription == NULL );
+
+    pNode->pSubscription = pSubscription;
+    pSubscription->pTopicNode = pNode;
+
+    return true;
+}
+
+/*-----------------------------------------------------------*/
+
+static void _pruneTopicNodes( _mqttTopicNode_t * pNode )
+{
+    _mqttTopicNode_t * pParent = NULL;
+
+    while( ( pNode != NULL ) &&
+           ( pNode->pSubscription == NULL ) &&
+           ( IotListDouble_IsEmpty( &( pNode->children ) ) == true ) )
+    {
+        pParent = pNode->pParent;
+
+        IotListDouble_Remove( &( pNode->link ) );
+        IotMqtt_FreeTopicNode( pNode );
+
+        pNode = pParent;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void _addMatch( _trieMatchParams_t * pMatch,
+                       _mqttSubscription_t * pSubscription )
+{
+    size_t i = 0;
+
+    if( ( pSubscription == NULL ) || ( ( uintptr_t ) pSubscription <= pMatch->cursor ) )
+    {
+        /* No subscription ends at this level, or its callback was invoked
+         * by an earlier batch. */
+        EMPTY_ELSE_MARKER;
+    }
+    else if( ( pMatch->count == IOT_MQTT_DISPATCH_BATCH_SIZE ) &&
+             ( ( uintptr_t ) pSubscription > ( uintptr_t ) pMatch->pMatches[ pMatch->count - 1 ] ) )
+    {
+        /* Left for a later batch. */
+        pMatch->more = true;
+    }
+    else
+    {
+        if( pMatch->count == IOT_MQTT_DISPATCH_BATCH_SIZE )
+        {
+            /* The highest match of a full batch is left for a later batch. */
+            pMatch->more = true;
+            ( pMatch->count )--;
+        }
+        else
+        {
+            EMPTY_ELSE_MARKER;
+        }
+
+        /* Insert in order of address. */
+        for( i = pMatch->count;
+             ( i > 0 ) && ( ( uintptr_t ) pMatch->pMatches[ i - 1 ] > ( uintptr_t ) pSubscription );
+             i-- )
+        {
+            pMatch->pMatches[ i ] = pMatch->pMatches[ i - 1 ];
+        }
+
+        pMatch->pMatches[ i ] = pSubscription;
+        ( pMatch->count )++;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void _matchTopicLevels( const IotListDouble_t * pLevels,
+                               const char * pTopicName,
+                               uint16_t topicNameLength,
+                               _trieMatchParams_t * pMatch )
+{
+    const uint16_t levelLength = _topicLevelLength( pTopicName, topicNameLength );
+    const IotLink_t * pLink = NULL;
+    _mqttTopicNode_t * pNode = NULL, * pMultiLevel = NULL;
+
+    IotContainers_ForEach( pLevels, pLink )
+    {
+        pNode = IotLink_Container( _mqttTopicNode_t, pLink, link );
+
+        if( ( pNode->levelLength == 1 ) && ( pNode->pLevel[ 0 ] == '#' ) )
+        {
+            /* The multi-level wildcard matches this level and all after it. */
+            _addMatch( pMatch, pNode->pSubscription );
+        }
+        else if( ( ( pNode->levelLength == 1 ) && ( pNode->pLevel[ 0 ] == '+' ) ) ||
+                 ( ( pNode->levelLength == levelLength ) &&
+                   ( memcmp( pNode->pLevel, pTopicName, levelLength ) == 0 ) ) )
+        {
+            if( levelLength == topicNameLength )
+            {
+                /* Last level of the topic name. */
+                _addMatch( pMatch, pNode->pSubscription );
+
+                /* Filter "sport/#" also matches "sport" since # includes the parent level. */
+                pMultiLevel = _findTopicLevel( &( pNode->children ), "#", 1 );
+
+                if( pMultiLevel != NULL )
+                {
+                    _addMatch( pMatch, pMultiLevel->pSubscription );
+                }
+                else
+                {
+                    EMPTY_ELSE_MARKER;
+                }
+            }
+            else
+            {
+                _matchTopicLevels( &( pNode->children ),
+                                   pTopicName + levelLength + 1,
+                                   ( uint16_t ) ( topicNameLength - levelLength - 1 ),
+                                   pMatch );
+            }
+        }
+        else
+        {
+            EMPTY_ELSE_MARKER;
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void _freeSubscription( void * pData )
+{
+    _mqttSubscription_t * pSubscription = ( _mqttSubscription_t * ) pData;
+
+    _IotMqtt_RemoveSubscriptionTopicNodes( pSubscription );
+    IotMqtt_FreeSubscription( pSubscription );
+}
+
+/*-----------------------------------------------------------*/
+
 IotMqttError_t _IotMqtt_AddSubscriptions( _mqttConnection_t * pMqttConnection,
                                           uint16_t subscribePacketIdentifier,
                                           const IotMqttSubscription_t * pSubscriptionList,
@@ -369,6 +717,18 @@ IotMqttError_t _IotMqtt_AddSubscriptions( _mqttConnection_t * pMqttConnection,
                                  pSubscriptionList[ i ].pTopicFilter,
                                  ( size_t ) ( pSubscriptionList[ i ].topicFilterLength ) );
 
+                /* Index the topic filter for dispatching incoming PUBLISH messages. */
+                if( _insertTopicNodes( pMqttConnection, pNewSubscription ) == false )
+                {
+                    IotMqtt_FreeSubscription( pNewSubscription );
+                    status = IOT_MQTT_NO_MEMORY;
+                    break;
+                }
+                else
+                {
+                    EMPTY_ELSE_MARKER;
+                }
+
                 IotListDouble_InsertHead( &( pMqttConnection->subscriptionList ),
                                           &( pNewSubscription->link ) );
             }
@@ -398,103 +758,111 @@ void _IotMqtt_InvokeSubscriptionCallback( _mqttConnection_t * pMqttConnection,
                                           IotMqttCallbackParam_t * pCallbackParam )
 {
     _mqttSubscription_t * pSubscription = NULL;
-    IotLink_t * pCurrentLink = NULL, * pNextLink = NULL;
+    size_t i = 0;
     void * pCallbackContext = NULL;
 
     void ( * callbackFunction )( void *,
                                  IotMqttCallbackParam_t * ) = NULL;
-    _topicMatchParams_t topicMatchParams = { 0 };
-
-    /* Set the members of the search parameter. */
-    topicMatchParams.pTopicName = pCallbackParam->u.message.info.pTopicName;
-    topicMatchParams.topicNameLength = pCallbackParam->u.message.info.topicNameLength;
-    topicMatchParams.exactMatchOnly = false;
+    _trieMatchParams_t trieMatchParams = { 0 };
 
-    /* Prevent any other thread from modifying the subscription list while this
-     * function is searching. */
-    IotMutex_Lock( &( pMqttConnection->subscriptionMutex ) );
-
-    /* Search the subscription list for all matching subscriptions starting at
-     * the list head. */
-    while( true )
+    do
     {
-        pCurrentLink = IotListDouble_FindFirstMatch( &( pMqttConnection->subscriptionList ),
-                                                     pCurrentLink,
-                                                     _topicMatch,
-                                                     &topicMatchParams );
+        /* Prevent any other thread from modifying the subscription trie while
+         * this function is searching. */
+        IotMutex_Lock( &( pMqttConnection->subscriptionMutex ) );
 
-        /* No subscription found. Exit loop. */
-        if( pCurrentLink == NULL )
+        /* Collect the next batch of matching subscriptions, after the ones
+         * whose callbacks were already invoked. */
+        trieMatchParams.count = 0;
+        trieMatchParams.more = false;
+        _matchTopicLevels( &( pMqttConnection->subscriptionTrie ),
+                           pCallbackParam->u.message.info.pTopicName,
+                           pCallbackParam->u.message.info.topicNameLength,
+                           &trieMatchParams );
+
+        /* Increment the reference counts so that the subscriptions are not
+         * freed while the mutex is released. */
+        for( i = 0; i < trieMatchParams.count; i++ )
         {
-            break;
+            ( trieMatchParams.pMatches[ i ]->references )++;
+        }
+
+        /* The next batch resumes after the last subscription of this one. */
+        if( trieMatchParams.count > 0 )
+        {
+            trieMatchParams.cursor = ( uintptr_t ) trieMatchParams.pMatches[ trieMatchParams.count - 1 ];
         }
         else
         {
             EMPTY_ELSE_MARKER;
         }
 
-        /* Subscription found. Calculate pointer to subscription object. */
-        pSubscription = IotLink_Container( _mqttSubscription_t, pCurrentLink, link );
-
-        /* Subscription validation should not have allowed a NULL callback function. */
-        IotMqtt_Assert( pSubscription->callback.function != NULL );
+        IotMutex_Unlock( &( pMqttConnection->subscriptionMutex ) );
 
-        /* Increment the subscription's reference count. */
-        ( pSubscription->references )++;
+        for( i = 0; i < trieMatchParams.count; i++ )
+        {
+            pSubscription = trieMatchParams.pMatches[ i ];
 
-        /* Copy the necessary members of the subscription before releasing the
-         * subscription list mutex. */
-        pCallbackContext = pSubscription->callback.pCallbackContext;
-        callbackFunction = pSubscription->callback.function;
+            /* Copy the necessary members of the subscription while holding the
+             * subscription list mutex. Skip subscriptions that were removed
+             * since the search. */
+            IotMutex_Lock( &( pMqttConnection->subscriptionMutex ) );
 
-        /* Unlock the subscription list mutex. */
-        IotMutex_Unlock( &( pMqttConnection->subscriptionMutex ) );
+            /* Subscription validation should not have allowed a NULL callback function. */
+            IotMqtt_Assert( pSubscription->callback.function != NULL );
 
-        /* Set the members of the callback parameter. */
-        pCallbackParam->mqttConnection = pMqttConnection;
-        pCallbackParam->u.message.pTopicFilter = pSubscription->pTopicFilter;
-        pCallbackParam->u.message.topicFilterLength = pSubscription->topicFilterLength;
+            pCallbackContext = pSubscription->callback.pCallbackContext;
+            callbackFunction = pSubscription->callback.function;
 
-        /* Invoke the subscription callback. */
-        callbackFunction( pCallbackContext, pCallbackParam );
+            IotMutex_Unlock( &( pMqttConnection->subscriptionMutex ) );
 
-        /* Lock the subscription list mutex to decrement the reference count. */
-        IotMutex_Lock( &( pMqttConnection->subscriptionMutex ) );
+            if( pSubscription->unsubscribed == false )
+            {
+                /* Set the members of the callback parameter. */
+                pCallbackParam->mqttConnection = pMqttConnection;
+                pCallbackParam->u.message.pTopicFilter = pSubscription->pTopicFilter;
+                pCallbackParam->u.message.topicFilterLength = pSubscription->topicFilterLength;
 
-        /* Decrement the reference count. It must still be positive. */
-        ( pSubscription->references )--;
-        IotMqtt_Assert( pSubscription->references >= 0 );
+                /* Invoke the subscription callback. */
+                callbackFunction( pCallbackContext, pCallbackParam );
+            }
+            else
+            {
+                EMPTY_ELSE_MARKER;
+            }
 
-        /* Save the pointer to the next link in case this subscription is freed. */
-        pNextLink = pCurrentLink->pNext;
+            /* Lock the subscription list mutex to decrement the reference count. */
+            IotMutex_Lock( &( pMqttConnection->subscriptionMutex ) );
 
-        /* Remove this subscription if it has no references and the unsubscribed
-         * flag is set. */
-        if( pSubscription->unsubscribed == true )
-        {
-            /* An unsubscribed subscription should have been removed from the list. */
-            IotMqtt_Assert( IotLink_IsLinked( &( pSubscription->link ) ) == false );
+            /* Decrement the reference count. It must still be positive. */
+            ( pSubscription->references )--;
+            IotMqtt_Assert( pSubscription->references >= 0 );
 
-            /* Free subscriptions with no references. */
-            if( pSubscription->references == 0 )
+            /* Remove this subscription if it has no references and the unsubscribed
+             * flag is set. */
+            if( pSubscription->unsubscribed == true )
             {
-                IotMqtt_FreeSubscription( pSubscription );
+                /* An unsubscribed subscription should have been removed from the list. */
+                IotMqtt_Assert( IotLink_IsLinked( &( pSubscription->link ) ) == false );
+
+                /* Free subscriptions with no references. */
+                if( pSubscription->references == 0 )
+                {
+                    IotMqtt_FreeSubscription( pSubscription );
+                }
+                else
+                {
+                    EMPTY_ELSE_MARKER;
+                }
             }
             else
             {
                 EMPTY_ELSE_MARKER;
             }
-        }
-        else
-        {
-            EMPTY_ELSE_MARKER;
-        }
-
-        /* Move current link pointer. */
-        pCurrentLink = pNextLink;
-    }
 
-    IotMutex_Unlock( &( pMqttConnection->subscriptionMutex ) );
+            IotMutex_Unlock( &( pMqttConnection->subscriptionMutex ) );
+        }
+    } while( trieMatchParams.more == true );
 
     _IotMqtt_DecrementConnectionReferences( pMqttConnection );
 }
@@ -515,7 +883,7 @@ void _IotMqtt_RemoveSubscriptionByPacket( _mqttConnection_t * pMqttConnection,
     IotListDouble_RemoveAllMatches( &( pMqttConnection->subscriptionList ),
                                     _packetMatch,
                                     ( void * ) ( &packetMatchParams ),
-                                    IotMqtt_FreeSubscription,
+                                    _freeSubscription,
                                     offsetof( _mqttSubscription_t, link ) );
     IotMutex_Unlock( &( pMqttConnection->subscriptionMutex ) );
 }
@@ -554,8 +922,9 @@ void _IotMqtt_RemoveSubscriptionByTopicFilter( _mqttConnection_t * pMqttConnecti
             /* Reference count must not be negative. */
             IotMqtt_Assert( pSubscription->references >= 0 );
 
-            /* Remove subscription from list. */
+            /* Remove subscription from list and trie. */
             IotListDouble_Remove( pSubscriptionLink );
+            _IotMqtt_RemoveSubscriptionTopicNodes( pSubscription );
 
             /* Check the reference count. This subscription cannot be removed if
              * there are subscription callbacks using it. */
@@ -582,6 +951,24 @@ void _IotMqtt_RemoveSubscriptionByTopicFilter( _mqttConnection_t * pMqttConnecti
 
 /*-----------------------------------------------------------*/
 
+void _IotMqtt_RemoveSubscriptionTopicNodes( _mqttSubscription_t * pSubscription )
+{
+    _mqttTopicNode_t * pNode = pSubscription->pTopicNode;
+
+    if( pNode != NULL )
+    {
+        pNode->pSubscription = NULL;
+        pSubscription->pTopicNode = NULL;
+        _pruneTopicNodes( pNode );
+    }
+    else
+    {
+        EMPTY_ELSE_MARKER;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
 bool IotMqtt_IsSubscribed( IotMqttConnection_t mqttConnection,
                            const char * pTopicFilter,
                            uint16_t topicFilterLength,
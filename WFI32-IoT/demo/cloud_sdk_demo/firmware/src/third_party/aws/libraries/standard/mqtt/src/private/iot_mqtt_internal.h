@@ -138,6 +138,20 @@
  * (http://pubs.opengroup.org/onlinepubs/9699919799/functions/free.html).
  */
     void IotMqtt_FreeSubscription( void * ptr );
+
+/**
+ * @brief Allocate an #_mqttTopicNode_t. This function should have the
+ * same signature as [malloc]
+ * (http://pubs.opengroup.org/onlinepubs/9699919799/functions/malloc.html).
+ */
+    void * IotMqtt_MallocTopicNode( size_t size );
+
+/**
+ * @brief Free an #_mqttTopicNode_t. This function should have the same
+ * signature as [free]
+ * (http://pubs.opengroup.org/onlinepubs/9699919799/functions/free.html).
+ */
+    void IotMqtt_FreeTopicNode( void * ptr );
 #else /* if IOT_STATIC_MEMORY_ONLY == 1 */
     #ifndef IotMqtt_MallocConnection
         #ifdef Iot_DefaultMalloc
@@ -202,6 +216,22 @@
             #error "No free function defined for IotMqtt_FreeSubscription"
         #endif
     #endif
+
+    #ifndef IotMqtt_MallocTopicNode
+        #ifdef Iot_DefaultMalloc
+            #define IotMqtt_MallocTopicNode    Iot_DefaultMalloc
+        #else
+            #error "No malloc function defined for IotMqtt_MallocTopicNode"
+        #endif
+    #endif
+
+    #ifndef IotMqtt_FreeTopicNode
+        #ifdef Iot_DefaultFree
+            #define IotMqtt_FreeTopicNode    Iot_DefaultFree
+        #else
+            #error "No free function defined for IotMqtt_FreeTopicNode"
+        #endif
+    #endif
 #endif /* if IOT_STATIC_MEMORY_ONLY == 1 */
 
 /**
@@ -222,6 +252,15 @@
 #ifndef IOT_MQTT_RETRY_MS_CEILING
     #define IOT_MQTT_RETRY_MS_CEILING               ( 60000 )
 #endif
+#ifndef IOT_MQTT_PUBLISH_ARENA_SLOTS
+    #define IOT_MQTT_PUBLISH_ARENA_SLOTS            ( 2 )
+#endif
+#ifndef IOT_MQTT_PUBLISH_ARENA_SLOT_SIZE
+    #define IOT_MQTT_PUBLISH_ARENA_SLOT_SIZE        ( 256 )
+#endif
+#ifndef IOT_MQTT_DISPATCH_BATCH_SIZE
+    #define IOT_MQTT_DISPATCH_BATCH_SIZE            ( 8 )
+#endif
 /** @endcond */
 
 /**
@@ -398,7 +437,8 @@ typedef struct _mqttConnection
     IotListDouble_t pendingResponse;                 /**< @brief List of processed operations awaiting a server response. */
 
     IotListDouble_t subscriptionList;                /**< @brief Holds subscriptions associated with this connection. */
-    IotMutex_t subscriptionMutex;                    /**< @brief Grants exclusive access to the subscription list. */
+    IotListDouble_t subscriptionTrie;                /**< @brief First topic levels of the subscription trie, used to dispatch incoming PUBLISH messages. */
+    IotMutex_t subscriptionMutex;                    /**< @brief Grants exclusive access to the subscription list and trie. */
 
     _mqttOperation_t pingreq;                        /**< @brief Operation used for MQTT keep-alive. */
 } _mqttConnection_t;
@@ -430,10 +470,29 @@ typedef struct _mqttSubscription
 
     IotMqttCallbackInfo_t callback; /**< @brief Callback information for this subscription. */
 
+    struct _mqttTopicNode * pTopicNode; /**< @brief Last level of the topic filter in the subscription trie; `NULL` if not in the trie. */
+
     uint16_t topicFilterLength;     /**< @brief Length of #_mqttSubscription_t.pTopicFilter. */
     char pTopicFilter[];            /**< @brief The subscription topic filter. */
 } _mqttSubscription_t;
 
+/**
+ * @brief One topic level in the subscription trie of an MQTT connection.
+ *
+ * Topic filters that share leading levels share nodes, so an incoming PUBLISH
+ * is matched against all subscriptions by walking its topic name level by
+ * level instead of comparing it with every topic filter.
+ */
+typedef struct _mqttTopicNode
+{
+    IotLink_t link;                            /**< @brief Link in the parent's list of child levels. */
+    struct _mqttTopicNode * pParent;           /**< @brief The previous level; `NULL` for a first level. */
+    IotListDouble_t children;                  /**< @brief The next levels. */
+    struct _mqttSubscription * pSubscription;  /**< @brief The subscription whose topic filter ends at this level, if any. */
+    uint16_t levelLength;                      /**< @brief Length of #_mqttTopicNode_t.pLevel. */
+    char pLevel[];                             /**< @brief This topic level, which may be `+` or `#`. Not NUL-terminated. */
+} _mqttTopicNode_t;
+
 /**
  * @brief Represents an MQTT packet received from the network.
  *
@@ -616,6 +675,34 @@ IotMqttError_t _IotMqtt_SerializePublish( const IotMqttPublishInfo_t * pPublishI
                                           uint16_t * pPacketIdentifier,
                                           uint8_t ** pPacketIdentifierHigh );
 
+/**
+ * @brief Generate a PUBLISH packet whose payload is written in place by the
+ * caller.
+ *
+ * The packet is placed in a slot of the static PUBLISH arena, so that the
+ * payload is never copied. If all slots are in use, a buffer of
+ * #IOT_MQTT_PUBLISH_ARENA_SLOT_SIZE bytes is allocated instead.
+ *
+ * @param[in] pPublishInfo User-provided PUBLISH information. Its payload
+ * members are ignored.
+ * @param[in] payloadWriter Writes the payload into the packet.
+ * @param[in] pWriterContext Passed to `payloadWriter`.
+ * @param[out] pPublishPacket Where the PUBLISH packet is written.
+ * @param[out] pPacketSize Size of the packet written to `pPublishPacket`.
+ * @param[out] pPacketIdentifier The packet identifier generated for this PUBLISH.
+ * @param[out] pPacketIdentifierHigh Where the high byte of the packet identifier
+ * is written.
+ *
+ * @return #IOT_MQTT_SUCCESS, #IOT_MQTT_NO_MEMORY, or #IOT_MQTT_BAD_PARAMETER.
+ */
+IotMqttError_t _IotMqtt_SerializePublishInPlace( const IotMqttPublishInfo_t * pPublishInfo,
+                                                 IotMqttPayloadWriter_t payloadWriter,
+                                                 void * pWriterContext,
+                                                 uint8_t ** pPublishPacket,
+                                                 size_t * pPacketSize,
+                                                 uint16_t * pPacketIdentifier,
+                                                 uint8_t ** pPacketIdentifierHigh );
+
 /**
  * @brief Set the DUP bit in a QoS 1 PUBLISH packet.
  *
@@ -956,6 +1043,18 @@ void _IotMqtt_RemoveSubscriptionByTopicFilter( _mqttConnection_t * pMqttConnecti
                                                const IotMqttSubscription_t * pSubscriptionList,
                                                size_t subscriptionCount );
 
+/**
+ * @brief Remove a subscription from the subscription trie of its MQTT
+ * connection, freeing the topic levels no other subscription uses.
+ *
+ * Must be called with the subscription mutex held whenever a subscription
+ * is removed from the subscription list. Subscriptions that are not in the
+ * trie are ignored.
+ *
+ * @param[in] pSubscription The subscription to remove.
+ */
+void _IotMqtt_RemoveSubscriptionTopicNodes( _mqttSubscription_t * pSubscription );
+
 /*------------------ MQTT connection management functions -------------------*/
 
 /**
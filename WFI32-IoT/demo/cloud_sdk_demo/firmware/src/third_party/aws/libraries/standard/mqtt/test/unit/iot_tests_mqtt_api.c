@@ -538,6 +538,25 @@ static IotMqttError_t _getNextByte( void * pNetworkInterface,
 
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief A payload writer that copies the string passed as its context.
+ */
+static size_t _writePayload( void * pContext,
+                             uint8_t * pBuffer,
+                             size_t bufferSize )
+{
+    size_t payloadLength = strlen( ( const char * ) pContext );
+
+    if( payloadLength <= bufferSize )
+    {
+        ( void ) memcpy( pBuffer, pContext, payloadLength );
+    }
+
+    return payloadLength;
+}
+
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Test group for MQTT API tests.
  */
@@ -612,6 +631,7 @@ TEST_GROUP_RUNNER( MQTT_Unit_API )
     RUN_TEST_CASE( MQTT_Unit_API, SerializeUnsubscribeChecks );
     RUN_TEST_CASE( MQTT_Unit_API, GetPublishPacketSizeChecks );
     RUN_TEST_CASE( MQTT_Unit_API, SerializePublishChecks );
+    RUN_TEST_CASE( MQTT_Unit_API, SerializePublishInPlaceChecks );
     RUN_TEST_CASE( MQTT_Unit_API, SerializeDisconnectChecks );
     RUN_TEST_CASE( MQTT_Unit_API, SerializePingReqChecks );
     RUN_TEST_CASE( MQTT_Unit_API, DeserializeResponseChecks );
@@ -2105,6 +2125,98 @@ TEST( MQTT_Unit_API, SerializePublishChecks )
 
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Tests that a PUBLISH packet written in place matches one serialized
+ * from a payload buffer, and that arena slots are given back.
+ */
+TEST( MQTT_Unit_API, SerializePublishInPlaceChecks )
+{
+    IotMqttPublishInfo_t publishInfo = IOT_MQTT_PUBLISH_INFO_INITIALIZER;
+    uint8_t * pPackets[ IOT_MQTT_PUBLISH_ARENA_SLOTS + 1 ] = { NULL };
+    uint8_t * pExpectedPacket = NULL, * pPacket = NULL;
+    size_t expectedPacketSize = 0, packetSize = 0;
+    uint16_t packetIdentifier = 0;
+    char pLargePayload[ IOT_MQTT_PUBLISH_ARENA_SLOT_SIZE + 1 ] = { 0 };
+    int32_t i = 0;
+    IotMqttError_t status = IOT_MQTT_SUCCESS;
+
+    publishInfo.pTopicName = TEST_TOPIC_NAME;
+    publishInfo.topicNameLength = TEST_TOPIC_NAME_LENGTH;
+    publishInfo.pPayload = "payload";
+    publishInfo.payloadLength = 7;
+
+    status = _IotMqtt_SerializePublish( &publishInfo,
+                                        &pExpectedPacket,
+                                        &expectedPacketSize,
+                                        &packetIdentifier,
+                                        NULL );
+    TEST_ASSERT_EQUAL( IOT_MQTT_SUCCESS, status );
+
+    if( TEST_PROTECT() )
+    {
+        /* The in-place packet is identical to the copied one. */
+        status = _IotMqtt_SerializePublishInPlace( &publishInfo,
+                                                   _writePayload,
+                                                   "payload",
+                                                   &pPacket,
+                                                   &packetSize,
+                                                   &packetIdentifier,
+                                                   NULL );
+        TEST_ASSERT_EQUAL( IOT_MQTT_SUCCESS, status );
+        TEST_ASSERT_EQUAL( expectedPacketSize, packetSize );
+        TEST_ASSERT_EQUAL_MEMORY( pExpectedPacket, pPacket, packetSize );
+        _IotMqtt_FreePacket( pPacket );
+
+        /* A payload that does not fit in a slot is rejected. */
+        ( void ) memset( pLargePayload, 'a', IOT_MQTT_PUBLISH_ARENA_SLOT_SIZE );
+        status = _IotMqtt_SerializePublishInPlace( &publishInfo,
+                                                   _writePayload,
+                                                   pLargePayload,
+                                                   &pPacket,
+                                                   &packetSize,
+                                                   &packetIdentifier,
+                                                   NULL );
+        TEST_ASSERT_EQUAL( IOT_MQTT_BAD_PARAMETER, status );
+
+        /* Fill every slot; the next packet comes from the heap but still
+         * matches. Freeing all packets makes the slots available again. */
+        for( i = 0; i <= IOT_MQTT_PUBLISH_ARENA_SLOTS; i++ )
+        {
+            status = _IotMqtt_SerializePublishInPlace( &publishInfo,
+                                                       _writePayload,
+                                                       "payload",
+                                                       &( pPackets[ i ] ),
+                                                       &packetSize,
+                                                       &packetIdentifier,
+                                                       NULL );
+            TEST_ASSERT_EQUAL( IOT_MQTT_SUCCESS, status );
+            TEST_ASSERT_EQUAL_MEMORY( pExpectedPacket, pPackets[ i ], packetSize );
+        }
+
+        for( i = 0; i <= IOT_MQTT_PUBLISH_ARENA_SLOTS; i++ )
+        {
+            _IotMqtt_FreePacket( pPackets[ i ] );
+        }
+
+        UnityMalloc_MakeMallocFailAfterCount( 0 );
+
+        status = _IotMqtt_SerializePublishInPlace( &publishInfo,
+                                                   _writePayload,
+                                                   "payload",
+                                                   &pPacket,
+                                                   &packetSize,
+                                                   &packetIdentifier,
+                                                   NULL );
+        UnityMalloc_MakeMallocFailAfterCount( -1 );
+        TEST_ASSERT_EQUAL( IOT_MQTT_SUCCESS, status );
+        _IotMqtt_FreePacket( pPacket );
+    }
+
+    _IotMqtt_FreePacket( pExpectedPacket );
+}
+
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Tests that IotMqtt_SerializeDisconnect works as intended.
  * to @ref mqtt_function_serializedisconnect.
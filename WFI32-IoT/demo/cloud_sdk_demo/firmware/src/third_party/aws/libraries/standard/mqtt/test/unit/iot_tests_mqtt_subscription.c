@@ -258,6 +258,82 @@ static void _blockingCallback( void * pArgument,
 
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief A subscription callback function that counts its invocations.
+ */
+static void _countingCallback( void * pArgument,
+                               IotMqttCallbackParam_t * pPublish )
+{
+    uint32_t * pInvokeCount = ( uint32_t * ) pArgument;
+
+    /* Silence warnings about unused parameters. */
+    ( void ) pPublish;
+
+    ( *pInvokeCount )++;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Subscriptions changed by #_changingCallback, with their invocation
+ * counts. #_changingCallback changes them on its first invocation only.
+ */
+static IotMqttSubscription_t * _pChangeSubscriptions = NULL;
+static uint32_t * _pChangeInvokeCounts = NULL;
+static size_t _changeCount = 0;
+static bool _changeDone = false;
+
+/**
+ * @brief A subscription callback function that counts its invocations. Its
+ * first invocation also removes every other subscription whose callback was
+ * not invoked yet, and adds a subscription that does not match.
+ */
+static void _changingCallback( void * pArgument,
+                               IotMqttCallbackParam_t * pPublish )
+{
+    size_t i = 0;
+    bool removeNext = true;
+    IotMqttSubscription_t added = IOT_MQTT_SUBSCRIPTION_INITIALIZER;
+
+    _countingCallback( pArgument, pPublish );
+
+    if( _changeDone == false )
+    {
+        _changeDone = true;
+
+        for( i = 0; i < _changeCount; i++ )
+        {
+            if( _pChangeInvokeCounts[ i ] == 0 )
+            {
+                if( removeNext == true )
+                {
+                    _IotMqtt_RemoveSubscriptionByTopicFilter( _pMqttConnection,
+                                                              &( _pChangeSubscriptions[ i ] ),
+                                                              1 );
+
+                    /* Marks a removed subscription for the test. */
+                    _pChangeInvokeCounts[ i ] = UINT32_MAX;
+                }
+
+                removeNext = !removeNext;
+            }
+        }
+
+        added.pTopicFilter = "c/d";
+        added.topicFilterLength = 3;
+        added.callback.function = _countingCallback;
+        added.callback.pCallbackContext = &( _pChangeInvokeCounts[ _changeCount ] );
+
+        TEST_ASSERT_EQUAL( IOT_MQTT_SUCCESS,
+                           _IotMqtt_AddSubscriptions( _pMqttConnection,
+                                                      2,
+                                                      &added,
+                                                      1 ) );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Test group for MQTT subscription tests.
  */
@@ -325,6 +401,10 @@ TEST_GROUP_RUNNER( MQTT_Unit_Subscription )
     RUN_TEST_CASE( MQTT_Unit_Subscription, SubscriptionAddMallocFail );
     RUN_TEST_CASE( MQTT_Unit_Subscription, ProcessPublish );
     RUN_TEST_CASE( MQTT_Unit_Subscription, ProcessPublishMultiple );
+    RUN_TEST_CASE( MQTT_Unit_Subscription, ProcessPublishWildcards );
+    RUN_TEST_CASE( MQTT_Unit_Subscription, ProcessPublishBatches );
+    RUN_TEST_CASE( MQTT_Unit_Subscription, ProcessPublishBatchesChanged );
+    RUN_TEST_CASE( MQTT_Unit_Subscription, SubscriptionTriePrune );
     RUN_TEST_CASE( MQTT_Unit_Subscription, SubscriptionReferences );
     RUN_TEST_CASE( MQTT_Unit_Subscription, TopicFilterMatchTrue );
     RUN_TEST_CASE( MQTT_Unit_Subscription, TopicFilterMatchFalse );
@@ -618,6 +698,7 @@ TEST( MQTT_Unit_Subscription, SubscriptionAddDuplicate )
 
     /* Check that a duplicate entry wasn't created. */
     IotListDouble_Remove( &( pSubscription->link ) );
+    _IotMqtt_RemoveSubscriptionTopicNodes( pSubscription );
     IotMqtt_FreeSubscription( pSubscription );
     pSubscriptionLink = IotListDouble_FindFirstMatch( &( _pMqttConnection->subscriptionList ),
                                                       NULL,
@@ -666,6 +747,7 @@ TEST( MQTT_Unit_Subscription, SubscriptionAddMallocFail )
 
         TEST_ASSERT_EQUAL( IOT_MQTT_NO_MEMORY, status );
         TEST_ASSERT_EQUAL_INT( true, IotListDouble_IsEmpty( &( _pMqttConnection->subscriptionList ) ) );
+        TEST_ASSERT_EQUAL_INT( true, IotListDouble_IsEmpty( &( _pMqttConnection->subscriptionTrie ) ) );
     }
 }
 
@@ -765,6 +847,230 @@ TEST( MQTT_Unit_Subscription, ProcessPublishMultiple )
 
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Tests that only the subscriptions whose topic filters match a PUBLISH
+ * topic name are invoked.
+ */
+TEST( MQTT_Unit_Subscription, ProcessPublishWildcards )
+{
+    size_t i = 0, j = 0;
+    uint32_t invokeCount[ 9 ] = { 0 };
+    IotMqttSubscription_t subscription[ 9 ] = { IOT_MQTT_SUBSCRIPTION_INITIALIZER };
+    IotMqttCallbackParam_t callbackParam = { .u.message = { 0 } };
+    const char * const pTopicFilters[ 9 ] =
+    {
+        "aws", "aws/#", "aws/+", "aws/", "aws/iot/shadow",
+        "aws/+/shadow", "+/+/+", "#", "/+"
+    };
+
+    /* Topic names and the expected invocations of each subscription. */
+    const struct
+    {
+        const char * pTopicName;
+        uint32_t expected[ 9 ];
+    } publishes[] =
+    {
+        { "aws",            { 1, 1, 0, 0, 0, 0, 0, 1, 0 } },
+        { "aws/",           { 0, 1, 1, 1, 0, 0, 0, 1, 0 } },
+        { "aws/iot",        { 0, 1, 1, 0, 0, 0, 0, 1, 0 } },
+        { "aws/iot/shadow", { 0, 1, 0, 0, 1, 1, 1, 1, 0 } },
+        { "aws/iot/jobs",   { 0, 1, 0, 0, 0, 0, 1, 1, 0 } },
+        { "/test",          { 0, 0, 0, 0, 0, 0, 0, 1, 1 } },
+        { "awsiot",         { 0, 0, 0, 0, 0, 0, 0, 1, 0 } }
+    };
+
+    for( i = 0; i < 9; i++ )
+    {
+        subscription[ i ].pTopicFilter = pTopicFilters[ i ];
+        subscription[ i ].topicFilterLength = ( uint16_t ) strlen( pTopicFilters[ i ] );
+        subscription[ i ].callback.function = _countingCallback;
+        subscription[ i ].callback.pCallbackContext = &( invokeCount[ i ] );
+    }
+
+    /* Add the subscriptions. */
+    TEST_ASSERT_EQUAL( IOT_MQTT_SUCCESS,
+                       _IotMqtt_AddSubscriptions( _pMqttConnection,
+                                                  1,
+                                                  subscription,
+                                                  9 ) );
+
+    for( i = 0; i < sizeof( publishes ) / sizeof( publishes[ 0 ] ); i++ )
+    {
+        ( void ) memset( invokeCount, 0x00, sizeof( invokeCount ) );
+
+        callbackParam.u.message.info.pTopicName = publishes[ i ].pTopicName;
+        callbackParam.u.message.info.topicNameLength = ( uint16_t ) strlen( publishes[ i ].pTopicName );
+
+        /* Increment connection reference count for processing subscription callbacks. */
+        TEST_ASSERT_EQUAL_INT( true, _IotMqtt_IncrementConnectionReferences( _pMqttConnection ) );
+
+        _IotMqtt_InvokeSubscriptionCallback( _pMqttConnection,
+                                             &callbackParam );
+
+        for( j = 0; j < 9; j++ )
+        {
+            TEST_ASSERT_EQUAL_UINT32_MESSAGE( publishes[ i ].expected[ j ],
+                                              invokeCount[ j ],
+                                              publishes[ i ].pTopicName );
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Tests that every matching subscription is invoked exactly once when
+ * more subscriptions match than fit in one dispatch batch.
+ */
+TEST( MQTT_Unit_Subscription, ProcessPublishBatches )
+{
+    size_t i = 0;
+    uint32_t invokeCount[ 13 ] = { 0 };
+    IotMqttSubscription_t subscription[ 13 ] = { IOT_MQTT_SUBSCRIPTION_INITIALIZER };
+    IotMqttCallbackParam_t callbackParam = { .u.message = { 0 } };
+
+    /* The first 11 topic filters match "a/b"; the last 2 do not. */
+    const char * const pTopicFilters[ 13 ] =
+    {
+        "#", "a/#", "a/+", "a/b", "+/b", "+/+", "+/#", "a/b/#", "+/b/#", "a/+/#", "+/+/#",
+        "a/c", "b/#"
+    };
+
+    for( i = 0; i < 13; i++ )
+    {
+        subscription[ i ].pTopicFilter = pTopicFilters[ i ];
+        subscription[ i ].topicFilterLength = ( uint16_t ) strlen( pTopicFilters[ i ] );
+        subscription[ i ].callback.function = _countingCallback;
+        subscription[ i ].callback.pCallbackContext = &( invokeCount[ i ] );
+    }
+
+    TEST_ASSERT_EQUAL( IOT_MQTT_SUCCESS,
+                       _IotMqtt_AddSubscriptions( _pMqttConnection,
+                                                  1,
+                                                  subscription,
+                                                  13 ) );
+
+    callbackParam.u.message.info.pTopicName = "a/b";
+    callbackParam.u.message.info.topicNameLength = 3;
+
+    /* Increment connection reference count for processing subscription callbacks. */
+    TEST_ASSERT_EQUAL_INT( true, _IotMqtt_IncrementConnectionReferences( _pMqttConnection ) );
+
+    _IotMqtt_InvokeSubscriptionCallback( _pMqttConnection,
+                                         &callbackParam );
+
+    for( i = 0; i < 13; i++ )
+    {
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE( ( i < 11 ) ? 1 : 0,
+                                          invokeCount[ i ],
+                                          pTopicFilters[ i ] );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Tests that a dispatch over several batches invokes every remaining
+ * subscription exactly once when subscriptions are removed and added between
+ * batches.
+ */
+TEST( MQTT_Unit_Subscription, ProcessPublishBatchesChanged )
+{
+    size_t i = 0;
+    uint32_t invokeCount[ 12 ] = { 0 };
+    IotMqttSubscription_t subscription[ 11 ] = { IOT_MQTT_SUBSCRIPTION_INITIALIZER };
+    IotMqttCallbackParam_t callbackParam = { .u.message = { 0 } };
+
+    /* All of these topic filters match "a/b". */
+    const char * const pTopicFilters[ 11 ] =
+    {
+        "#", "a/#", "a/+", "a/b", "+/b", "+/+", "+/#", "a/b/#", "+/b/#", "a/+/#", "+/+/#"
+    };
+
+    for( i = 0; i < 11; i++ )
+    {
+        subscription[ i ].pTopicFilter = pTopicFilters[ i ];
+        subscription[ i ].topicFilterLength = ( uint16_t ) strlen( pTopicFilters[ i ] );
+        subscription[ i ].callback.function = _changingCallback;
+        subscription[ i ].callback.pCallbackContext = &( invokeCount[ i ] );
+    }
+
+    _pChangeSubscriptions = subscription;
+    _pChangeInvokeCounts = invokeCount;
+    _changeCount = 11;
+    _changeDone = false;
+
+    TEST_ASSERT_EQUAL( IOT_MQTT_SUCCESS,
+                       _IotMqtt_AddSubscriptions( _pMqttConnection,
+                                                  1,
+                                                  subscription,
+                                                  11 ) );
+
+    callbackParam.u.message.info.pTopicName = "a/b";
+    callbackParam.u.message.info.topicNameLength = 3;
+
+    /* Increment connection reference count for processing subscription callbacks. */
+    TEST_ASSERT_EQUAL_INT( true, _IotMqtt_IncrementConnectionReferences( _pMqttConnection ) );
+
+    _IotMqtt_InvokeSubscriptionCallback( _pMqttConnection,
+                                         &callbackParam );
+
+    /* Removed subscriptions keep their mark; all others ran once. */
+    for( i = 0; i < 11; i++ )
+    {
+        if( invokeCount[ i ] != UINT32_MAX )
+        {
+            TEST_ASSERT_EQUAL_UINT32_MESSAGE( 1, invokeCount[ i ], pTopicFilters[ i ] );
+        }
+    }
+
+    /* The added subscription does not match. */
+    TEST_ASSERT_EQUAL_UINT32( 0, invokeCount[ 11 ] );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Tests that topic levels are removed from the subscription trie with
+ * the last subscription that uses them.
+ */
+TEST( MQTT_Unit_Subscription, SubscriptionTriePrune )
+{
+    IotMqttSubscription_t subscription[ 3 ] = { IOT_MQTT_SUBSCRIPTION_INITIALIZER };
+
+    subscription[ 0 ].pTopicFilter = "aws/iot/shadow";
+    subscription[ 0 ].topicFilterLength = 14;
+    subscription[ 0 ].callback.function = SUBSCRIPTION_CALLBACK_FUNCTION;
+
+    subscription[ 1 ].pTopicFilter = "aws/iot";
+    subscription[ 1 ].topicFilterLength = 7;
+    subscription[ 1 ].callback.function = SUBSCRIPTION_CALLBACK_FUNCTION;
+
+    subscription[ 2 ].pTopicFilter = "aws/+/#";
+    subscription[ 2 ].topicFilterLength = 7;
+    subscription[ 2 ].callback.function = SUBSCRIPTION_CALLBACK_FUNCTION;
+
+    TEST_ASSERT_EQUAL( IOT_MQTT_SUCCESS,
+                       _IotMqtt_AddSubscriptions( _pMqttConnection,
+                                                  1,
+                                                  subscription,
+                                                  3 ) );
+
+    /* Removing the subscription for a shared level keeps the longer topic filter. */
+    _IotMqtt_RemoveSubscriptionByTopicFilter( _pMqttConnection, &( subscription[ 1 ] ), 1 );
+    TEST_ASSERT_EQUAL_INT( true, IotMqtt_IsSubscribed( _pMqttConnection, "aws/iot/shadow", 14, NULL ) );
+    TEST_ASSERT_EQUAL_INT( false, IotListDouble_IsEmpty( &( _pMqttConnection->subscriptionTrie ) ) );
+
+    /* Removing the remaining subscriptions empties the trie. */
+    _IotMqtt_RemoveSubscriptionByTopicFilter( _pMqttConnection, &( subscription[ 0 ] ), 1 );
+    TEST_ASSERT_EQUAL_INT( false, IotListDouble_IsEmpty( &( _pMqttConnection->subscriptionTrie ) ) );
+    _IotMqtt_RemoveSubscriptionByPacket( _pMqttConnection, 1, MQTT_REMOVE_ALL_SUBSCRIPTIONS );
+    TEST_ASSERT_EQUAL_INT( true, IotListDouble_IsEmpty( &( _pMqttConnection->subscriptionList ) ) );
+    TEST_ASSERT_EQUAL_INT( true, IotListDouble_IsEmpty( &( _pMqttConnection->subscriptionTrie ) ) );
+}
+
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Tests that subscriptions are properly reference counted.
  */
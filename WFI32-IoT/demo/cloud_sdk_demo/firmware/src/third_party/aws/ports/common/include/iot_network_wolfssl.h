@@ -81,6 +81,40 @@
  */
 #define IOT_NETWORK_CREDENTIALS_WOLFSSL_INITIALIZER    { 0 }
 
+/**
+ * @brief Number of buckets in #IotNetworkLatencyHistogram_t.
+ */
+#define IOT_NETWORK_LATENCY_BUCKET_COUNT               ( 8 )
+
+/**
+ * @brief Upper bounds, in microseconds, of all but the last latency bucket.
+ * The last bucket counts everything above the final bound.
+ */
+#define IOT_NETWORK_LATENCY_BUCKET_LIMITS_US           { 100, 250, 500, 1000, 2000, 5000, 10000 }
+
+/**
+ * @brief Histogram of the time from a TCP receive signal to the invocation of
+ * the network receive callback.
+ */
+typedef struct IotNetworkLatencyHistogram
+{
+    uint32_t count[ IOT_NETWORK_LATENCY_BUCKET_COUNT ]; /**< @brief Samples per bucket. */
+    uint32_t samples;                                   /**< @brief Total number of samples. */
+    uint32_t maxUs;                                     /**< @brief Largest latency seen, in microseconds. */
+} IotNetworkLatencyHistogram_t;
+
+/**
+ * @brief Duration of each stage of the most recent connection attempt.
+ *
+ * Stages not reached by a failed attempt are reported as 0.
+ */
+typedef struct IotNetworkConnectTimings
+{
+    uint32_t dnsMs; /**< @brief Host name resolution. */
+    uint32_t tcpMs; /**< @brief Socket open to TCP connection established. */
+    uint32_t tlsMs; /**< @brief TLS handshake. */
+} IotNetworkConnectTimings_t;
+
 /**
  * @brief Provides a pointer to an #IotNetworkInterface_t that uses the functions
  * declared in this file.
@@ -177,4 +211,23 @@ IotNetworkError_t IotNetworkWolfSSL_Destroy( IotNetworkConnection_t pConnection
  */
 int IotNetworkWolfSSL_GetSocket( IotNetworkConnection_t pConnection );
 
+/**
+ * @brief Copy the receive signal-to-callback latency histogram.
+ *
+ * @param[out] pHistogram Receives a snapshot of the histogram.
+ */
+void IotNetworkWolfSSL_GetReceiveLatency( IotNetworkLatencyHistogram_t * pHistogram );
+
+/**
+ * @brief Clear the receive signal-to-callback latency histogram.
+ */
+void IotNetworkWolfSSL_ResetReceiveLatency( void );
+
+/**
+ * @brief Get the stage durations of the most recent connection attempt.
+ *
+ * @param[out] pTimings Receives the DNS, TCP and TLS stage durations.
+ */
+void IotNetworkWolfSSL_GetConnectTimings( IotNetworkConnectTimings_t * pTimings );
+
 #endif /* ifndef IOT_NETWORK_OPENSSL_H_ */
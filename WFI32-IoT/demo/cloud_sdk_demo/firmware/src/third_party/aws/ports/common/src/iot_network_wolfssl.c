@@ -47,6 +47,51 @@ typedef int socklen_t ;
 
 #define TCP_CLIENT_CONNECTION_TIMEOUT_PERIOD_s 	10
 
+/**
+ * @brief Size of the per-connection receive buffer.
+ *
+ * Decrypted TLS record data is read into this buffer in one NET_PRES call so
+ * that small reads (such as the MQTT fixed header, which is read one byte at a
+ * time) are served from RAM instead of going through NET_PRES and wolfSSL.
+ */
+#ifndef IOT_NETWORK_RECEIVE_BUFFER_SIZE
+    #define IOT_NETWORK_RECEIVE_BUFFER_SIZE    ( 256 )
+#endif
+
+/**
+ * @brief Longest time the receive path blocks waiting for a socket signal.
+ *
+ * The receive thread is woken by the TCP stack signal handler; this timeout
+ * only bounds how long a missed signal can delay detecting a dead socket.
+ */
+#ifndef IOT_NETWORK_RECEIVE_WAIT_MS
+    #define IOT_NETWORK_RECEIVE_WAIT_MS    ( 1000 )
+#endif
+
+/**
+ * @brief Longest time a connection stage sleeps before re-checking its state.
+ *
+ * DNS completion and TCP establishment wake the connecting task through the
+ * connection signal; this only bounds the wait if no event is delivered.
+ */
+#ifndef IOT_NETWORK_CONNECT_POLL_MS
+    #define IOT_NETWORK_CONNECT_POLL_MS    ( 100 )
+#endif
+
+/**
+ * @brief Poll interval for TLS handshake completion, which NET_PRES does not signal.
+ */
+#ifndef IOT_NETWORK_TLS_POLL_MS
+    #define IOT_NETWORK_TLS_POLL_MS    ( 10 )
+#endif
+
+/**
+ * @brief TCP events that wake the connecting task and the receive thread.
+ */
+#define IOT_NETWORK_SOCKET_SIGNALS     ( TCPIP_TCP_SIGNAL_ESTABLISHED | TCPIP_TCP_SIGNAL_RX_DATA | TCPIP_TCP_SIGNAL_RX_FIN | \
+                                         TCPIP_TCP_SIGNAL_RX_RST | TCPIP_TCP_SIGNAL_TX_RST | \
+                                         TCPIP_TCP_SIGNAL_KEEP_ALIVE_TMO | TCPIP_TCP_SIGNAL_IF_DOWN )
+
 
 /* Configure logs for the functions in this file. */
 #ifdef IOT_LOG_LEVEL_NETWORK
@@ -87,6 +132,21 @@ typedef int socklen_t ;
 uint32_t sockConnTimeStamp;
 IP_MULTI_ADDRESS hostAddress;
 
+/**
+ * @brief Upper bounds (in microseconds) of the signal-to-callback latency buckets.
+ */
+static const uint32_t _receiveLatencyLimitsUs[ IOT_NETWORK_LATENCY_BUCKET_COUNT - 1 ] = IOT_NETWORK_LATENCY_BUCKET_LIMITS_US;
+
+/**
+ * @brief Signal-to-callback latency histogram, shared by all connections.
+ */
+static IotNetworkLatencyHistogram_t _receiveLatency;
+
+/**
+ * @brief Stage durations of the most recent connection attempt.
+ */
+static IotNetworkConnectTimings_t _connectTimings;
+
 
 /*-----------------------------------------------------------*/
 
@@ -102,6 +162,12 @@ typedef struct _networkConnection
     void * pReceiveContext;                      /**< @brief The context for the receive callback. */
     IotNetworkCloseCallback_t closeCallback;     /**< @brief Network close callback, if any. */
     void * pCloseContext;                        /**< @brief The context for the close callback. */
+    SemaphoreHandle_t receiveSignal;             /**< @brief Given by the TCP signal handler when the socket has an event. */
+    NET_PRES_SIGNAL_HANDLE receiveSignalHandle;  /**< @brief Registration of the TCP signal handler. */
+    volatile uint32_t signalTimeStamp;           /**< @brief Counter value of the first signal not yet served; 0 if none. */
+    uint16_t receiveHead;                        /**< @brief Index of the next unread byte in receiveBuffer. */
+    uint16_t receiveTail;                        /**< @brief Index one past the last valid byte in receiveBuffer. */
+    uint8_t receiveBuffer[ IOT_NETWORK_RECEIVE_BUFFER_SIZE ]; /**< @brief Buffered decrypted data not yet consumed. */
 } _networkConnection_t;
 
 /*-----------------------------------------------------------*/
@@ -122,11 +188,145 @@ static const IotNetworkInterface_t _networkWolfSSL =
 
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Number of received bytes held in the connection receive buffer.
+ *
+ * @param[in] pConnection The connection to check.
+ *
+ * @return The number of buffered bytes not yet returned to the caller.
+ */
+static size_t _receiveBufferedCount( const _networkConnection_t * pConnection )
+{
+    return ( size_t ) ( pConnection->receiveTail - pConnection->receiveHead );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Refill the connection receive buffer from the socket.
+ *
+ * All data that NET_PRES reports as ready (the remainder of the current
+ * decrypted TLS record) is read at once, up to the free space in the buffer.
+ * Must only be called when the buffer is empty.
+ *
+ * @param[in] pConnection The connection to refill.
+ *
+ * @return The number of bytes now held in the buffer.
+ */
+static size_t _receiveBufferFill( _networkConnection_t * pConnection )
+{
+    uint16_t readyCount = 0;
+    uint16_t readCount = 0;
+
+    pConnection->receiveHead = 0;
+    pConnection->receiveTail = 0;
+
+    readyCount = NET_PRES_SocketReadIsReady( pConnection->socket );
+
+    if( readyCount > 0 )
+    {
+        if( readyCount > IOT_NETWORK_RECEIVE_BUFFER_SIZE )
+        {
+            readyCount = IOT_NETWORK_RECEIVE_BUFFER_SIZE;
+        }
+
+        readCount = NET_PRES_SocketRead( pConnection->socket,
+                                         pConnection->receiveBuffer,
+                                         readyCount );
+        pConnection->receiveTail = readCount;
+    }
+
+    return ( size_t ) readCount;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief TCP stack signal handler for a connection.
+ *
+ * Runs in the TCP/IP task context. Records when the event arrived and wakes
+ * any task blocked in the receive path of this connection.
+ */
+static void _networkSignalHandler( NET_PRES_SKT_HANDLE_T handle,
+                                   NET_PRES_SIGNAL_HANDLE hNet,
+                                   uint16_t sigType,
+                                   const void * param )
+{
+    _networkConnection_t * pConnection = ( _networkConnection_t * ) param;
+
+    if( pConnection->signalTimeStamp == 0 )
+    {
+        pConnection->signalTimeStamp = SYS_TIME_CounterGet();
+    }
+
+    ( void ) xSemaphoreGive( pConnection->receiveSignal );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Wait until the TCP stack signals an event on a connection.
+ *
+ * @param[in] pConnection The connection to wait on.
+ * @param[in] timeoutMs Maximum time to block.
+ */
+static void _receiveSignalWait( _networkConnection_t * pConnection,
+                                uint32_t timeoutMs )
+{
+    if( pConnection->receiveSignal != NULL )
+    {
+        ( void ) xSemaphoreTake( pConnection->receiveSignal, pdMS_TO_TICKS( timeoutMs ) );
+    }
+    else
+    {
+        vTaskDelay( pdMS_TO_TICKS( timeoutMs ) );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Account the time from the last socket signal to the receive callback.
+ *
+ * @param[in] pConnection The connection whose callback is about to run.
+ */
+static void _receiveLatencyRecord( _networkConnection_t * pConnection )
+{
+    uint32_t timeStamp = pConnection->signalTimeStamp;
+    uint32_t latencyUs = 0;
+    uint32_t bucket = 0;
+
+    if( timeStamp == 0 )
+    {
+        /* Data was already buffered; no signal to account for. */
+        return;
+    }
+
+    pConnection->signalTimeStamp = 0;
+    latencyUs = SYS_TIME_CountToUS( SYS_TIME_CounterGet() - timeStamp );
+
+    while( ( bucket < ( IOT_NETWORK_LATENCY_BUCKET_COUNT - 1 ) ) &&
+           ( latencyUs > _receiveLatencyLimitsUs[ bucket ] ) )
+    {
+        bucket++;
+    }
+
+    _receiveLatency.count[ bucket ]++;
+    _receiveLatency.samples++;
+
+    if( latencyUs > _receiveLatency.maxUs )
+    {
+        _receiveLatency.maxUs = latencyUs;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Network receive thread.
  *
- * This thread polls the network socket and reads data when data is available.
- * It then invokes the receive callback, if any.
+ * This thread blocks until the TCP stack signals data, reset or disconnect on
+ * the socket. It then invokes the receive callback while data is available.
  *
  * @param[in] pArgument The connection associated with this receive thread.
  */
@@ -139,7 +339,7 @@ static void * _networkReceiveThread( void * pArgument )
     _networkConnection_t * pConnection = pArgument;
 
     
-    /* Continuously poll the network socket for events. */
+    /* Wait for socket events and serve them. */
     while( true )
     {
 
@@ -151,17 +351,24 @@ static void * _networkReceiveThread( void * pArgument )
             break;
         }
 
-		pollStatus = NET_PRES_SocketReadIsReady(pConnection->socket);
+		pollStatus = _receiveBufferedCount(pConnection);
+
+		if(pollStatus == 0)
+		{
+			pollStatus = NET_PRES_SocketReadIsReady(pConnection->socket);
+		}
 		
 		if(pollStatus>0)
         {
+            _receiveLatencyRecord(pConnection);
+
 	        /* Invoke the callback function. */
 	        pConnection->receiveCallback( pConnection,
 	                                      pConnection->pReceiveContext );
         }
         else
         {
-            vTaskDelay(10 / portTICK_PERIOD_MS);
+            _receiveSignalWait(pConnection, IOT_NETWORK_RECEIVE_WAIT_MS);
         }
     }
 
@@ -276,161 +483,255 @@ static IotNetworkError_t _tlsSetup( _networkConnection_t * pConnection,
 /*-----------------------------------------------------------*/
 
 /**
- * @brief Perform a DNS lookup of a host name and establish a TCP connection.
+ * @brief DNS client event handler used while a connection resolves its host.
  *
- * @param[in] pServerInfo Server host name and port.
- *
- * @return A connected TCP socket number; `-1` if the DNS lookup failed.
+ * Any completion event wakes the connecting task, which then queries the
+ * DNS result itself.
  */
+static void _dnsEventHandler( TCPIP_NET_HANDLE hNet,
+                              TCPIP_DNS_EVENT_TYPE evType,
+                              const char * name,
+                              const void * param )
+{
+    _networkConnection_t * pConnection = ( _networkConnection_t * ) param;
 
+    if( evType != TCPIP_DNS_EVENT_NAME_QUERY )
+    {
+        ( void ) xSemaphoreGive( pConnection->receiveSignal );
+    }
+}
+
+/*-----------------------------------------------------------*/
 
-static int _dnsLookupAndConnect( IotNetworkServerInfo_t pServerInfo, IotNetworkCredentials_t pCredentialInfo)
+/**
+ * @brief Milliseconds elapsed since a SYS_TIME counter value.
+ */
+static uint32_t _elapsedMs( uint32_t startCount )
 {
-    IOT_FUNCTION_ENTRY( int, 0 );
-    int16_t tcpSocket = -1;
-    const uint16_t netPort = ( pServerInfo->port );
-    struct addrinfo * pListHead = NULL, * pAddressInfo = NULL;
-    struct sockaddr * pServer = NULL;
-    socklen_t serverLength = 0;
+    return SYS_TIME_CountToMS( SYS_TIME_CounterGet() - startCount );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Connection stage 1: resolve the server host name.
+ *
+ * Blocks on the connection signal, which the DNS client gives when the query
+ * completes, instead of sleeping between polls.
+ *
+ * @param[in] pConnection The connection being established.
+ * @param[in] pHostName Host name or dotted IPv4 address.
+ *
+ * @return #IOT_NETWORK_SUCCESS or #IOT_NETWORK_FAILURE.
+ */
+static IotNetworkError_t _connectResolve( _networkConnection_t * pConnection,
+                                          const char * pHostName )
+{
+    IOT_FUNCTION_ENTRY( IotNetworkError_t, IOT_NETWORK_SUCCESS );
+    TCPIP_DNS_HANDLE dnsHandle = NULL;
+    TCPIP_DNS_RESULT result;
 
     /* Perform a DNS lookup of host name. */
-    IotLogInfo( "Performing DNS lookup of %s, %d", pServerInfo->pHostName , strlen(pServerInfo->pHostName ));
+    IotLogInfo( "Performing DNS lookup of %s, %d", pHostName, strlen( pHostName ) );
 
 	/* First check to see if host is an IPv4 address*/
-    if (TCPIP_Helper_StringToIPAddress( pServerInfo->pHostName, &hostAddress.v4Add))
+    if (TCPIP_Helper_StringToIPAddress( pHostName, &hostAddress.v4Add))
     {
     	//string is already in IPv4 format
-        IotLogDebug("Using IPv4 Address: %d.%d.%d.%d for host '%s'\r\n", hostAddress.v4Add.v[0], hostAddress.v4Add.v[1], hostAddress.v4Add.v[2], hostAddress.v4Add.v[3], pServerInfo->pHostName);
+        IotLogDebug("Using IPv4 Address: %d.%d.%d.%d for host '%s'\r\n", hostAddress.v4Add.v[0], hostAddress.v4Add.v[1], hostAddress.v4Add.v[2], hostAddress.v4Add.v[3], pHostName);
+        IOT_GOTO_CLEANUP();
     }
-    else
+
+    /* Without DNS user notification the wait below degrades to a timed poll. */
+    dnsHandle = TCPIP_DNS_HandlerRegister( NULL, _dnsEventHandler, pConnection );
+
+    result = TCPIP_DNS_Resolve( pHostName, TCPIP_DNS_TYPE_A );
+
+    if( result < 0 )
     {
-    	//perform DNS query
-
-		TCPIP_DNS_RESULT result;
-        result = TCPIP_DNS_Resolve(pServerInfo->pHostName, TCPIP_DNS_TYPE_A);
-
-		 if (result >= 0)
-         {
-         	result = TCPIP_DNS_RES_PENDING;
-
-			while(result == TCPIP_DNS_RES_PENDING)
-			{
-	            result = TCPIP_DNS_IsResolved(pServerInfo->pHostName, &hostAddress, IP_ADDRESS_TYPE_IPV4);
-
-	            switch (result)
-	            {
-	                case TCPIP_DNS_RES_PENDING:
-	                {
-						// wait a second, not optimum, todo, optimize this 
-						vTaskDelay(1000 / portTICK_PERIOD_MS);
-	                    break;
-	                }
-	                
-	                case TCPIP_DNS_RES_OK:
-	                {
-	                    IotLogDebug("Using IPv4 Address: %d.%d.%d.%d for host '%s'\r\n", hostAddress.v4Add.v[0], hostAddress.v4Add.v[1], hostAddress.v4Add.v[2], hostAddress.v4Add.v[3], pServerInfo->pHostName);
-	                    break;
-	                }
-	                
-	                case TCPIP_DNS_RES_SERVER_TMO:
-	                case TCPIP_DNS_RES_NO_IP_ENTRY:
-	                default:
-	                {
-	                    IotLogError( "DNS lookup failed.. " );
-						IOT_SET_AND_GOTO_CLEANUP( -1 );
-	                    break;
-	                }
-	            }
-			}
-         }
-         else
-         {
-                IotLogError( "DNS lookup failed.. %d", result );
-				IOT_SET_AND_GOTO_CLEANUP( -1 );
-         }            
+        IotLogError( "DNS lookup failed.. %d", result );
+        IOT_SET_AND_GOTO_CLEANUP( IOT_NETWORK_FAILURE );
+    }
 
+    while( ( result = TCPIP_DNS_IsResolved( pHostName, &hostAddress, IP_ADDRESS_TYPE_IPV4 ) ) == TCPIP_DNS_RES_PENDING )
+    {
+        _receiveSignalWait( pConnection, IOT_NETWORK_CONNECT_POLL_MS );
     }
 
-    IotLogDebug( "Successfully received DNS address." );
+    if( result != TCPIP_DNS_RES_OK )
+    {
+        IotLogError( "DNS lookup failed.. %d", result );
+        IOT_SET_AND_GOTO_CLEANUP( IOT_NETWORK_FAILURE );
+    }
 
+    IotLogDebug("Using IPv4 Address: %d.%d.%d.%d for host '%s'\r\n", hostAddress.v4Add.v[0], hostAddress.v4Add.v[1], hostAddress.v4Add.v[2], hostAddress.v4Add.v[3], pHostName);
+
+    IOT_FUNCTION_CLEANUP_BEGIN();
 
-	// If we're here it means that we have a proper address.
+    if( dnsHandle != NULL )
+    {
+        ( void ) TCPIP_DNS_HandlerDeRegister( dnsHandle );
+    }
+
+    IOT_FUNCTION_CLEANUP_END();
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Connection stage 2: open the socket and complete the TCP handshake.
+ *
+ * The socket signal handler is registered as soon as the socket exists, so
+ * the ESTABLISHED event wakes the connecting task.
+ *
+ * @param[in] pConnection The connection being established.
+ * @param[in] port Server port.
+ *
+ * @return #IOT_NETWORK_SUCCESS, #IOT_NETWORK_FAILURE or #IOT_NETWORK_SYSTEM_ERROR.
+ */
+static IotNetworkError_t _connectTcp( _networkConnection_t * pConnection,
+                                      uint16_t port )
+{
+    IOT_FUNCTION_ENTRY( IotNetworkError_t, IOT_NETWORK_SUCCESS );
 	NET_PRES_SKT_ERROR_T error;
-	IotLogDebug("Starting TCP/IPv4 Connection to : %d.%d.%d.%d port '%d'\r\n", hostAddress.v4Add.v[0], hostAddress.v4Add.v[1], hostAddress.v4Add.v[2], hostAddress.v4Add.v[3], netPort);
-	tcpSocket = NET_PRES_SocketOpen(0, NET_PRES_SKT_UNENCRYPTED_STREAM_CLIENT, IP_ADDRESS_TYPE_IPV4, netPort, (NET_PRES_ADDRESS *)&hostAddress, &error);
-    NET_PRES_SocketWasReset(tcpSocket);
-	if (tcpSocket == INVALID_SOCKET)
+
+	IotLogDebug("Starting TCP/IPv4 Connection to : %d.%d.%d.%d port '%d'\r\n", hostAddress.v4Add.v[0], hostAddress.v4Add.v[1], hostAddress.v4Add.v[2], hostAddress.v4Add.v[3], port);
+	pConnection->socket = NET_PRES_SocketOpen(0, NET_PRES_SKT_UNENCRYPTED_STREAM_CLIENT, IP_ADDRESS_TYPE_IPV4, port, (NET_PRES_ADDRESS *)&hostAddress, &error);
+
+	if (pConnection->socket == INVALID_SOCKET)
 	{
 		IotLogError("Error %d: Could not create socket - aborting\r\n", error);
-		IOT_SET_AND_GOTO_CLEANUP( -1 );
-	}
-	else
-	{
-		IotLogDebug("Starting connection\r\n");
-		sockConnTimeStamp = SYS_TMR_TickCountGet();
+        pConnection->socket = -1;
+		IOT_SET_AND_GOTO_CLEANUP( IOT_NETWORK_FAILURE );
 	}
 
-    while( !NET_PRES_SocketIsConnected(tcpSocket))
+    NET_PRES_SocketWasReset(pConnection->socket);
+
+    pConnection->receiveSignalHandle = NET_PRES_SocketSignalHandlerRegister( pConnection->socket,
+                                                                             IOT_NETWORK_SOCKET_SIGNALS,
+                                                                             _networkSignalHandler,
+                                                                             pConnection );
+
+    if( pConnection->receiveSignalHandle == 0 )
+    {
+        IotLogError( "Failed to register signal handler for socket %d.", pConnection->socket );
+
+        IOT_SET_AND_GOTO_CLEANUP( IOT_NETWORK_SYSTEM_ERROR );
+    }
+
+	IotLogDebug("Starting connection\r\n");
+	sockConnTimeStamp = SYS_TMR_TickCountGet();
+
+    while( !NET_PRES_SocketIsConnected(pConnection->socket))
+    {
+        if (SYS_TMR_TickCountGet() - sockConnTimeStamp >= SYS_TMR_TickCounterFrequencyGet() * TCP_CLIENT_CONNECTION_TIMEOUT_PERIOD_s)
         {
-        	// while Socket not connected 
-           if (SYS_TMR_TickCountGet() - sockConnTimeStamp >= SYS_TMR_TickCounterFrequencyGet() * TCP_CLIENT_CONNECTION_TIMEOUT_PERIOD_s)
-            {
-                IotLogError("Socket connect timeout!\r\n");
-                TCPIP_TCP_Close(tcpSocket);
-				IOT_SET_AND_GOTO_CLEANUP( -1 );
-            }
-		   vTaskDelay(100 / portTICK_PERIOD_MS);
-            
+            IotLogError("Socket connect timeout!\r\n");
+			IOT_SET_AND_GOTO_CLEANUP( IOT_NETWORK_FAILURE );
         }
 
+        _receiveSignalWait( pConnection, IOT_NETWORK_CONNECT_POLL_MS );
+    }
 
-	// socket connected, setup TLS
-	//TODO: add support for ALPN and SNI
-    /*if( pCredentialInfo != NULL )
-    {
-        IotLogInfo( "Setting up TLS." );
+    IOT_FUNCTION_EXIT_NO_CLEANUP();
+}
 
+/*-----------------------------------------------------------*/
 
+/**
+ * @brief Connection stage 3: run the TLS handshake on the connected socket.
+ *
+ * The handshake itself runs in the NET_PRES task. Handshake records arriving
+ * from the server wake this task early; the short poll interval covers the
+ * NET_PRES processing that follows them.
+ *
+ * @param[in] pConnection The connection being established.
+ *
+ * @return #IOT_NETWORK_SUCCESS or #IOT_NETWORK_FAILURE.
+ */
+static IotNetworkError_t _connectTls( _networkConnection_t * pConnection )
+{
+    IOT_FUNCTION_ENTRY( IotNetworkError_t, IOT_NETWORK_SUCCESS );
 
-       _tlsSetup( pNewNetworkConnection,
-                            pServerInfo->pHostName,
-                            pCredentialInfo );
-    }*/
-	
-		IotLogDebug("Connection Opened: Starting SSL Negotiation\r\n");
-        
+	//TODO: add support for ALPN and SNI
+	IotLogDebug("Connection Opened: Starting SSL Negotiation\r\n");
 
-		if (!NET_PRES_SocketEncryptSocket(tcpSocket)) 
- 		{
-			IotLogError("SSL Create Connection Failed - Aborting\r\n");
-            TCPIP_TCP_Close(tcpSocket);
-			IOT_SET_AND_GOTO_CLEANUP( -1 );                
-		} 
+	if (!NET_PRES_SocketEncryptSocket(pConnection->socket))
+	{
+		IotLogError("SSL Create Connection Failed - Aborting\r\n");
+		IOT_SET_AND_GOTO_CLEANUP( IOT_NETWORK_FAILURE );
+	}
 
-        
-    while( NET_PRES_SocketIsNegotiatingEncryption(tcpSocket))
-		vTaskDelay(10 / portTICK_PERIOD_MS);
+    while( NET_PRES_SocketIsNegotiatingEncryption(pConnection->socket))
+    {
+        _receiveSignalWait( pConnection, IOT_NETWORK_TLS_POLL_MS );
+    }
 
-	if (!NET_PRES_SocketIsSecure(tcpSocket)) 
+	if (!NET_PRES_SocketIsSecure(pConnection->socket))
 	{
 		IotLogError("SSL Connection Negotiation Failed - Aborting\r\n");
-		TCPIP_TCP_Close(tcpSocket);
-		IOT_SET_AND_GOTO_CLEANUP( -1 );
+		IOT_SET_AND_GOTO_CLEANUP( IOT_NETWORK_FAILURE );
 	}
 
 	IotLogDebug("SSL Connection Opened\r\n");
- 
 
-    IOT_FUNCTION_CLEANUP_BEGIN();
+    IOT_FUNCTION_EXIT_NO_CLEANUP();
+}
+
+/*-----------------------------------------------------------*/
 
+/**
+ * @brief Perform a DNS lookup of a host name and establish a TLS connection.
+ *
+ * Runs the DNS, TCP and TLS stages in order, each blocking on connection
+ * events rather than fixed delays, and records the duration of each stage.
+ *
+ * @param[in] pConnection The connection to establish; its socket is set on return.
+ * @param[in] pServerInfo Server host name and port.
+ * @param[in] pCredentialInfo TLS setup parameters (currently unused).
+ *
+ * @return #IOT_NETWORK_SUCCESS, #IOT_NETWORK_FAILURE or #IOT_NETWORK_SYSTEM_ERROR.
+ */
+static IotNetworkError_t _dnsLookupAndConnect( _networkConnection_t * pConnection,
+                                               IotNetworkServerInfo_t pServerInfo,
+                                               IotNetworkCredentials_t pCredentialInfo )
+{
+    IOT_FUNCTION_ENTRY( IotNetworkError_t, IOT_NETWORK_SUCCESS );
+    uint32_t stageStart = 0;
 
+    ( void ) memset( &_connectTimings, 0x00, sizeof( _connectTimings ) );
 
-    /* Return the socket descriptor on success. */
-    if( status == 0 )
+    stageStart = SYS_TIME_CounterGet();
+    status = _connectResolve( pConnection, pServerInfo->pHostName );
+    _connectTimings.dnsMs = _elapsedMs( stageStart );
+
+    if( status != IOT_NETWORK_SUCCESS )
+    {
+        IOT_GOTO_CLEANUP();
+    }
+
+    IotLogDebug( "Successfully received DNS address." );
+
+    stageStart = SYS_TIME_CounterGet();
+    status = _connectTcp( pConnection, pServerInfo->port );
+    _connectTimings.tcpMs = _elapsedMs( stageStart );
+
+    if( status != IOT_NETWORK_SUCCESS )
     {
-        status = tcpSocket;
+        IOT_GOTO_CLEANUP();
     }
 
+    stageStart = SYS_TIME_CounterGet();
+    status = _connectTls( pConnection );
+    _connectTimings.tlsMs = _elapsedMs( stageStart );
+
+    IOT_FUNCTION_CLEANUP_BEGIN();
+
+    IotLogInfo( "Connect stages: DNS %lu ms, TCP %lu ms, TLS %lu ms.",
+                ( unsigned long ) _connectTimings.dnsMs,
+                ( unsigned long ) _connectTimings.tcpMs,
+                ( unsigned long ) _connectTimings.tlsMs );
+
     IOT_FUNCTION_CLEANUP_END();
 }
 
@@ -451,8 +752,6 @@ IotNetworkError_t IotNetworkWolfSSL_Create( IotNetworkServerInfo_t pServerInfo,
                                             IotNetworkConnection_t * pConnection )
 {
     IOT_FUNCTION_ENTRY( IotNetworkError_t, IOT_NETWORK_SUCCESS );
-    int tcpSocket = -1;
-    bool sslMutexCreated = false;
     _networkConnection_t * pNewNetworkConnection = NULL;
 
     /* Allocate memory for a new connection. */
@@ -467,21 +766,32 @@ IotNetworkError_t IotNetworkWolfSSL_Create( IotNetworkServerInfo_t pServerInfo,
 
     /* Clear connection data. */
     ( void ) memset( pNewNetworkConnection, 0x00, sizeof( _networkConnection_t ) );
+    pNewNetworkConnection->socket = -1;
+
+    /* DNS, socket and receive events all wake the task through this signal. */
+    pNewNetworkConnection->receiveSignal = xSemaphoreCreateBinary();
+
+    if( pNewNetworkConnection->receiveSignal == NULL )
+    {
+        IotLogError( "Failed to create network connection signal." );
+
+        IOT_SET_AND_GOTO_CLEANUP( IOT_NETWORK_NO_MEMORY );
+    }
 
     /* Perform a DNS lookup of pHostName. This also establishes a TCP  & TLS socket. */
-    tcpSocket = _dnsLookupAndConnect( pServerInfo , pCredentialInfo);
+    status = _dnsLookupAndConnect( pNewNetworkConnection, pServerInfo, pCredentialInfo );
 
-    if( tcpSocket == -1 )
+    if( status != IOT_NETWORK_SUCCESS )
     {
-        IOT_SET_AND_GOTO_CLEANUP( IOT_NETWORK_FAILURE );
+        IOT_GOTO_CLEANUP();
     }
     else
     {
         IotLogInfo( "TCP connection successful." );
     }
 
-    /* Set the socket in the network connection. */
-    pNewNetworkConnection->socket = tcpSocket;
+    /* Signals seen during connect are not receive latency samples. */
+    pNewNetworkConnection->signalTimeStamp = 0;
 
 
     /* Clean up on error. */
@@ -489,14 +799,16 @@ IotNetworkError_t IotNetworkWolfSSL_Create( IotNetworkServerInfo_t pServerInfo,
 
     if( status != IOT_NETWORK_SUCCESS )
     {
-        if( tcpSocket != -1 )
-        {
-            ( void ) NET_PRES_SocketClose( tcpSocket );
-            tcpSocket = -1;
-        }
-
         if( pNewNetworkConnection != NULL )
         {
+            /* Deregisters the signal handler and closes the socket, if any. */
+            ( void ) IotNetworkWolfSSL_Close( pNewNetworkConnection );
+
+            if( pNewNetworkConnection->receiveSignal != NULL )
+            {
+                vSemaphoreDelete( pNewNetworkConnection->receiveSignal );
+            }
+
             IotNetwork_Free( pNewNetworkConnection );
         }
     }
@@ -633,17 +945,42 @@ size_t IotNetworkWolfSSL_Receive( IotNetworkConnection_t pConnection,
     /* Loop until all bytes are received. */
     while( bytesRemaining > 0 )
     {
-        if ((!NET_PRES_SocketWasReset(pConnection->socket)) && (NET_PRES_SocketIsConnected(pConnection->socket)))
-        {
-            recv_count = NET_PRES_SocketRead(pConnection->socket, pBuffer+bytesRead, bytesRemaining);
+        /* Serve as much as possible from data already buffered. */
+        recv_count = _receiveBufferedCount(pConnection);
 
-            if (recv_count < bytesRemaining)
+        if (recv_count > 0)
+        {
+            if (recv_count > bytesRemaining)
             {
-                vTaskDelay(10 / portTICK_PERIOD_MS);
+                recv_count = bytesRemaining;
             }
 
+            memcpy(pBuffer+bytesRead, &pConnection->receiveBuffer[pConnection->receiveHead], recv_count);
+            pConnection->receiveHead += recv_count;
             bytesRead += recv_count;
             bytesRemaining -= recv_count;
+            continue;
+        }
+
+        if ((!NET_PRES_SocketWasReset(pConnection->socket)) && (NET_PRES_SocketIsConnected(pConnection->socket)))
+        {
+            if (bytesRemaining >= IOT_NETWORK_RECEIVE_BUFFER_SIZE)
+            {
+                /* Large reads (packet payloads) go straight to the caller's buffer. */
+                recv_count = NET_PRES_SocketRead(pConnection->socket, pBuffer+bytesRead, bytesRemaining);
+
+                bytesRead += recv_count;
+                bytesRemaining -= recv_count;
+            }
+            else
+            {
+                recv_count = _receiveBufferFill(pConnection);
+            }
+
+            if (recv_count == 0)
+            {
+                _receiveSignalWait(pConnection, IOT_NETWORK_RECEIVE_WAIT_MS);
+            }
         }
         else
         {
@@ -688,10 +1025,22 @@ IotNetworkError_t IotNetworkWolfSSL_Close( IotNetworkConnection_t pConnection )
     {
         IotLogInfo( "Connection (socket %d) shutting down.",
                     pConnection->socket );
+
+        if( pConnection->receiveSignalHandle != 0 )
+        {
+            ( void ) NET_PRES_SocketSignalHandlerDeregister( pConnection->socket,
+                                                             pConnection->receiveSignalHandle );
+            pConnection->receiveSignalHandle = 0;
+        }
+
         NET_PRES_SocketClose(pConnection->socket);
         pConnection->socket = -1;
     }
 
+    /* Discard any data buffered from the closed socket. */
+    pConnection->receiveHead = 0;
+    pConnection->receiveTail = 0;
+
 	sockConnTimeStamp = 0;
 
     return IOT_NETWORK_SUCCESS;
@@ -709,6 +1058,12 @@ IotNetworkError_t IotNetworkWolfSSL_Destroy( IotNetworkConnection_t pConnection
     /* Close the socket file descriptor. */
     IotNetworkWolfSSL_Close(pConnection);
 
+    if( pConnection->receiveSignal != NULL )
+    {
+        vSemaphoreDelete( pConnection->receiveSignal );
+        pConnection->receiveSignal = NULL;
+    }
+
     /* Free the connection. */
     IotNetwork_Free( pConnection );
 
@@ -723,3 +1078,28 @@ int IotNetworkWolfSSL_GetSocket( IotNetworkConnection_t pConnection )
 }
 
 /*-----------------------------------------------------------*/
+
+void IotNetworkWolfSSL_GetReceiveLatency( IotNetworkLatencyHistogram_t * pHistogram )
+{
+    taskENTER_CRITICAL();
+    *pHistogram = _receiveLatency;
+    taskEXIT_CRITICAL();
+}
+
+/*-----------------------------------------------------------*/
+
+void IotNetworkWolfSSL_ResetReceiveLatency( void )
+{
+    taskENTER_CRITICAL();
+    ( void ) memset( &_receiveLatency, 0x00, sizeof( _receiveLatency ) );
+    taskEXIT_CRITICAL();
+}
+
+/*-----------------------------------------------------------*/
+
+void IotNetworkWolfSSL_GetConnectTimings( IotNetworkConnectTimings_t * pTimings )
+{
+    *pTimings = _connectTimings;
+}
+
+/*-----------------------------------------------------------*/
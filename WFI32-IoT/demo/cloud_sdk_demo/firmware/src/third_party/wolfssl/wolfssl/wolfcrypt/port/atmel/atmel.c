@@ -71,6 +71,16 @@ static byte mSlotList[ATECC_MAX_SLOT];
 static wolfSSL_Mutex mSlotMutex;
 #endif
 
+#ifdef WOLFSSL_ATECC_KEY_PREFETCH
+/* Ephemeral key generated ahead of the handshake that uses it. Its slot stays
+ * allocated until the key is taken, so each key is handed out only once and
+ * is then freed by the user like any other ephemeral key */
+static int  mPrefetchSlot = ATECC_INVALID_SLOT;
+static byte mPrefetchPubKey[ATECC_PUBKEY_SIZE];
+static word32 mPrefetchHits;
+static word32 mPrefetchMisses;
+#endif
+
 /* Raspberry Pi uses /dev/i2c-1 */
 #ifndef ATECC_I2C_ADDR
     #ifdef WOLFSSL_ATECC_TNGTLS
@@ -447,6 +457,61 @@ int atmel_ecc_create_key(int slotId, byte* peerKey)
     return ret;
 }
 
+#ifdef WOLFSSL_ATECC_KEY_PREFETCH
+/**
+ * \brief Generates the next ephemeral key, if none is waiting. Call it when
+ *        no handshake is running: the new key overwrites the private key last
+ *        used in the ECDHE slot.
+ *
+ * \return 1 if a key was generated, 0 if one was waiting already, or an error
+ */
+int atmel_ecc_prefetch_key(void)
+{
+    int ret, slotId;
+    byte pubKey[ATECC_PUBKEY_SIZE];
+
+    if (!mAtcaInitDone) {
+        return WC_HW_E;
+    }
+    if (mPrefetchSlot != ATECC_INVALID_SLOT) {
+        return 0;
+    }
+
+    /* fails while a handshake still holds the slot */
+    slotId = atmel_ecc_alloc(ATMEL_SLOT_ECDHE);
+    if (slotId == ATECC_INVALID_SLOT) {
+        return WC_HW_WAIT_E;
+    }
+
+    ret = atmel_ecc_create_key(slotId, pubKey);
+    if (ret != 0) {
+        atmel_ecc_free(slotId);
+        return ret;
+    }
+
+#ifndef SINGLE_THREADED
+    wc_LockMutex(&mSlotMutex);
+#endif
+    XMEMCPY(mPrefetchPubKey, pubKey, sizeof(mPrefetchPubKey));
+    mPrefetchSlot = slotId;
+#ifndef SINGLE_THREADED
+    wc_UnLockMutex(&mSlotMutex);
+#endif
+
+    return 1;
+}
+
+/**
+ * \brief Number of ephemeral keys taken from the prefetcher, and of those
+ *        that had to be generated in the handshake
+ */
+void atmel_ecc_prefetch_stats(word32* hits, word32* misses)
+{
+    *hits = mPrefetchHits;
+    *misses = mPrefetchMisses;
+}
+#endif /* WOLFSSL_ATECC_KEY_PREFETCH */
+
 int atmel_ecc_sign(int slotId, const byte* message, byte* signature)
 {
     int ret;
@@ -560,6 +625,11 @@ void atmel_finish(void)
 {
 #if defined(WOLFSSL_ATECC508A) || defined(WOLFSSL_ATECC608A)
     if (mAtcaInitDone) {
+    #ifdef WOLFSSL_ATECC_KEY_PREFETCH
+        /* an unused key is left to the next GenKey on the slot */
+        ForceZero(mPrefetchPubKey, sizeof(mPrefetchPubKey));
+        mPrefetchSlot = ATECC_INVALID_SLOT;
+    #endif
         atcab_release();
 
     #ifndef SINGLE_THREADED
@@ -575,6 +645,60 @@ void atmel_finish(void)
 /* Reference PK Callbacks */
 #ifdef HAVE_PK_CALLBACKS
 
+#ifdef WOLFSSL_ATECC_KEY_PREFETCH
+/* Takes the waiting ephemeral key, returns its slot or ATECC_INVALID_SLOT */
+static int atmel_ecc_take_key(byte* pubKey)
+{
+    int slotId;
+
+#ifndef SINGLE_THREADED
+    wc_LockMutex(&mSlotMutex);
+#endif
+    slotId = mPrefetchSlot;
+    if (slotId != ATECC_INVALID_SLOT) {
+        XMEMCPY(pubKey, mPrefetchPubKey, sizeof(mPrefetchPubKey));
+        ForceZero(mPrefetchPubKey, sizeof(mPrefetchPubKey));
+        mPrefetchSlot = ATECC_INVALID_SLOT;
+        mPrefetchHits++;
+    }
+    else {
+        mPrefetchMisses++;
+    }
+#ifndef SINGLE_THREADED
+    wc_UnLockMutex(&mSlotMutex);
+#endif
+
+    return slotId;
+}
+#endif
+
+/* Gets a new ephemeral key into the ECDHE slot, the prefetched one if there
+ * is one. The slot is allocated on success only */
+static int atmel_ecc_create_ephemeral(byte* peerKey, int* pSlotId)
+{
+    int ret;
+
+#ifdef WOLFSSL_ATECC_KEY_PREFETCH
+    *pSlotId = atmel_ecc_take_key(peerKey);
+    if (*pSlotId != ATECC_INVALID_SLOT) {
+        return 0;
+    }
+#endif
+
+    *pSlotId = atmel_ecc_alloc(ATMEL_SLOT_ECDHE);
+    if (*pSlotId == ATECC_INVALID_SLOT) {
+        return WC_HW_WAIT_E;
+    }
+
+    /* generate new ephemeral key on device */
+    ret = atmel_ecc_create_key(*pSlotId, peerKey);
+    if (ret != 0) {
+        atmel_ecc_free(*pSlotId);
+        *pSlotId = ATECC_INVALID_SLOT;
+    }
+    return ret;
+}
+
 /**
  * \brief Used on the server-side only for creating the ephemeral key for ECDH
  */
@@ -592,12 +716,9 @@ int atcatls_create_key_cb(WOLFSSL* ssl, ecc_key* key, unsigned int keySz,
 
     /* ATECC508A only supports P-256 */
     if (ecc_curve == ECC_SECP256R1) {
-        slotId = atmel_ecc_alloc(ATMEL_SLOT_ECDHE);
-        if (slotId == ATECC_INVALID_SLOT)
-            return WC_HW_WAIT_E;
-
-        /* generate new ephemeral key on device */
-        ret = atmel_ecc_create_key(slotId, peerKey);
+        ret = atmel_ecc_create_ephemeral(peerKey, &slotId);
+        if (ret == WC_HW_WAIT_E)
+            return ret;
 
         /* load generated ECC508A public key into key, used by wolfSSL */
         if (ret == 0) {
@@ -665,16 +786,13 @@ int atcatls_create_pms_cb(WOLFSSL* ssl, ecc_key* otherKey,
 
         /* for client: create and export public key */
         if (side == WOLFSSL_CLIENT_END) {
-            int slotId = atmel_ecc_alloc(ATMEL_SLOT_ECDHE);
-            if (slotId == ATECC_INVALID_SLOT)
-                return WC_HW_WAIT_E;
-            tmpKey.slot = slotId;
+            int slotId;
 
-            /* generate new ephemeral key on device */
-            ret = atmel_ecc_create_key(slotId, peerKey);
-            if (ret != ATCA_SUCCESS) {
+            ret = atmel_ecc_create_ephemeral(peerKey, &slotId);
+            if (ret != 0) {
                 goto exit;
             }
+            tmpKey.slot = slotId;
 
             /* convert raw unsigned public key to X.963 format for TLS */
             ret = wc_ecc_import_unsigned(&tmpKey, qx, qy, NULL, ECC_SECP256R1);
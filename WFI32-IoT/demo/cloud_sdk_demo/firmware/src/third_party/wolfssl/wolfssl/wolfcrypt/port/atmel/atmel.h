@@ -117,6 +117,10 @@ WOLFSSL_API int wolfCrypt_ATECC_SetConfig(ATCAIfaceCfg* cfg);
 int  atmel_get_enc_key_default(byte* enckey, word16 keysize);
 int  atmel_ecc_create_pms(int slotId, const uint8_t* peerKey, uint8_t* pms);
 int  atmel_ecc_create_key(int slotId, byte* peerKey);
+#ifdef WOLFSSL_ATECC_KEY_PREFETCH
+int  atmel_ecc_prefetch_key(void);
+void atmel_ecc_prefetch_stats(word32* hits, word32* misses);
+#endif
 int  atmel_ecc_sign(int slotId, const byte* message, byte* signature);
 int  atmel_ecc_verify(const byte* message, const byte* signature,
     const byte* pubkey, int* pVerified);
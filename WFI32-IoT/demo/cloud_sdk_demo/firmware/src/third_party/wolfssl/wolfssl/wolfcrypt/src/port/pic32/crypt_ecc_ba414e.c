@@ -68,6 +68,8 @@ int Crypt_ECC_HandleReq(int devId, wc_CryptoInfo* info, void* ctx)
     int ret = CRYPTOCB_UNAVAILABLE;
     if (ba414Handle != DRV_HANDLE_INVALID)
     {        
+        // handshakes wait on these, don't queue them behind background work
+        DRV_BA414E_PrioritySet(ba414Handle, DRV_BA414E_PRIORITY_HIGH);
         if (info->pk.type == WC_PK_TYPE_ECDSA_SIGN)
         {
             ret = Crypt_ECC_HandleEccSignReq(devId, info, ctx, ba414Handle);
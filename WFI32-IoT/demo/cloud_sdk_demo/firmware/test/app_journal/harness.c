@@ -0,0 +1,666 @@
+/*
+ * Host harness for the telemetry journal (src/app_journal.c).
+ *
+ * usage: harness <flash image> <seed> <boots>
+ *
+ * The SST26 volume is modelled by a file-backed flash image: 4 KB erase
+ * blocks, 256-byte program pages, and a sector write done the way the SST26
+ * media driver does it (read the block, erase it, program it back). Block 0
+ * stands for the FAT and the root directory; a file's directory entry is
+ * rewritten there when it is created, and when it is synced or closed after
+ * a write, as FatFs does. Whole aligned sectors go straight to flash, partial
+ * ones through a one-sector file buffer.
+ *
+ * Each boot runs the journal from a cold start (all RAM state reset) through
+ * a random mix of offline appends and online replay, and most boots end with
+ * a power cut at a random erase or program step. The seed drives everything.
+ * Checks:
+ *  - no corrupted sample is ever delivered, and delivery is in order within
+ *    a boot;
+ *  - an acknowledged record is only ever lost if a power cut hit its erase
+ *    block, or the FAT block while a file was being created or closed;
+ *  - duplicates after a power cut stay within the cursor interval, unless
+ *    the cut hit the cursor's erase block;
+ *  - appends and replay never rewrite the FAT / directory block, and an open
+ *    that fails for any reason other than a missing file never recreates the
+ *    journal.
+ */
+#include <setjmp.h>
+#include <stdlib.h>
+#include "app_journal.c"
+
+#define SECTOR_SIZE         512
+#define BLOCK_SIZE          4096
+#define PAGE_SIZE           256
+#define SECTORS_PER_BLOCK   (BLOCK_SIZE / SECTOR_SIZE)
+#define FLASH_BLOCKS        64
+#define META_BLOCK          0
+
+/* The config and certificate files sit in front of the journal, which
+ * therefore does not start on an erase block boundary */
+#define FILE_CAPACITY       80      /* sectors */
+#define MAX_DIR_ENTRIES     8
+#define MAX_OPEN_FILES      3
+
+#define MAX_IDS             100000
+
+typedef struct {
+    char name[48];
+    uint32_t start;     /* sector */
+    uint32_t size;      /* bytes */
+} DIR_ENTRY;
+
+typedef struct {
+    bool used;
+    bool modified;
+    bool dirty;
+    int entry;
+    uint32_t pos;
+    uint32_t size;
+    uint32_t bufSector;     /* file sector held in buf, or UINT32_MAX */
+    uint8_t buf[SECTOR_SIZE];
+} OPEN_FILE;
+
+static FILE *image;
+static OPEN_FILE files[MAX_OPEN_FILES];
+static SYS_FS_ERROR fsError;
+static bool failOpen;
+
+/* Power cut injection */
+static jmp_buf powerCut;
+static uint32_t steps, cutAt;
+static int cutBlock;
+
+static uint32_t metaErases, dataErases, creates, metaCuts;
+static uint32_t blockErases[FLASH_BLOCKS];
+
+/* What the harness knows about the records */
+static int32_t ackedSeq[MAX_IDS];           /* journal seq of an acknowledged append, or 0 */
+static uint8_t atRisk[MAX_IDS];             /* its erase block was hit by a power cut */
+static uint16_t delivered[MAX_IDS][APP_JOURNAL_RECORD_SAMPLES];
+static int32_t slotId[APP_JOURNAL_RECORDS]; /* id of the last record acknowledged in a slot */
+static uint32_t nextId = 1;
+static uint64_t lastDelivered;              /* (id, sample) of the last delivery this boot */
+static uint32_t duplicates, dupBudget;
+static uint32_t failures;
+
+#define FAIL(...) do { fprintf(stderr, __VA_ARGS__); failures++; } while (0)
+
+/* Flash model ****************************************************************/
+
+static void flashRead(uint32_t addr, void *buf, uint32_t len)
+{
+    if (fseek(image, addr, SEEK_SET) || fread(buf, 1, len, image) != len) {
+        perror("flash image");
+        exit(2);
+    }
+}
+
+static void flashProgram(uint32_t addr, const void *buf, uint32_t len)
+{
+    if (fseek(image, addr, SEEK_SET) || fwrite(buf, 1, len, image) != len) {
+        perror("flash image");
+        exit(2);
+    }
+    fflush(image);
+}
+
+/* Every erase and page program is one step; the cut happens before step
+ * cutAt, leaving the block as far as it got */
+static void flashStep(int block)
+{
+    if (cutAt && ++steps >= cutAt) {
+        cutBlock = block;
+        longjmp(powerCut, 1);
+    }
+}
+
+static void flashWriteSector(uint32_t sector, const uint8_t *data)
+{
+    static const uint8_t erased[BLOCK_SIZE] = { [0 ... BLOCK_SIZE - 1] = 0xFF };
+    uint8_t block[BLOCK_SIZE];
+    int b = sector / SECTORS_PER_BLOCK;
+    uint32_t page;
+
+    flashRead(b * BLOCK_SIZE, block, BLOCK_SIZE);
+    memcpy(&block[(sector % SECTORS_PER_BLOCK) * SECTOR_SIZE], data, SECTOR_SIZE);
+    flashStep(b);
+    flashProgram(b * BLOCK_SIZE, erased, BLOCK_SIZE);
+    blockErases[b]++;
+    if (b == META_BLOCK) {
+        metaErases++;
+    }
+    else {
+        dataErases++;
+    }
+    for (page = 0; page < BLOCK_SIZE; page += PAGE_SIZE) {
+        flashStep(b);
+        flashProgram(b * BLOCK_SIZE + page, &block[page], PAGE_SIZE);
+    }
+}
+
+/* FAT model ******************************************************************/
+
+static void dirLoad(DIR_ENTRY *dir)
+{
+    flashRead(META_BLOCK * BLOCK_SIZE, dir, sizeof(DIR_ENTRY) * MAX_DIR_ENTRIES);
+}
+
+static void dirStore(const DIR_ENTRY *dir)
+{
+    uint8_t sector[SECTOR_SIZE];
+
+    memset(sector, 0, sizeof(sector));
+    memcpy(sector, dir, sizeof(DIR_ENTRY) * MAX_DIR_ENTRIES);
+    flashWriteSector(META_BLOCK * SECTORS_PER_BLOCK, sector);
+}
+
+static int dirFind(const DIR_ENTRY *dir, const char *name)
+{
+    int i;
+
+    for (i = 0; i < MAX_DIR_ENTRIES; i++) {
+        if ((uint8_t) dir[i].name[0] != 0xFF && dir[i].name[0] != 0 && strcmp(dir[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void imageFormat(void)
+{
+    static const uint8_t erased[BLOCK_SIZE] = { [0 ... BLOCK_SIZE - 1] = 0xFF };
+    DIR_ENTRY dir[MAX_DIR_ENTRIES];
+    uint32_t b;
+
+    for (b = 0; b < FLASH_BLOCKS; b++) {
+        flashProgram(b * BLOCK_SIZE, erased, BLOCK_SIZE);
+    }
+    memset(dir, 0, sizeof(dir));
+    strcpy(dir[0].name, "/mnt/myDrive1/WIFI.CFG");
+    dir[0].start = SECTORS_PER_BLOCK;
+    dir[0].size = 3 * SECTOR_SIZE;
+    strcpy(dir[1].name, "/mnt/myDrive1/cert.pem");
+    dir[1].start = SECTORS_PER_BLOCK + 3;
+    dir[1].size = 8 * SECTOR_SIZE;
+    dirStore(dir);
+}
+
+static OPEN_FILE *fileGet(SYS_FS_HANDLE handle)
+{
+    if (handle >= MAX_OPEN_FILES || !files[handle].used) {
+        fprintf(stderr, "bad file handle %u\n", (unsigned) handle);
+        abort();
+    }
+    return &files[handle];
+}
+
+static uint32_t fileStart(const OPEN_FILE *f)
+{
+    DIR_ENTRY dir[MAX_DIR_ENTRIES];
+
+    dirLoad(dir);
+    return dir[f->entry].start;
+}
+
+static void fileFlush(OPEN_FILE *f)
+{
+    if (f->dirty) {
+        flashWriteSector(fileStart(f) + f->bufSector, f->buf);
+        f->dirty = false;
+    }
+}
+
+static void fileLoad(OPEN_FILE *f, uint32_t sector)
+{
+    if (f->bufSector != sector) {
+        fileFlush(f);
+        flashRead((fileStart(f) + sector) * SECTOR_SIZE, f->buf, SECTOR_SIZE);
+        f->bufSector = sector;
+    }
+}
+
+SYS_FS_HANDLE SYS_FS_FileOpen(const char *fname, SYS_FS_FILE_OPEN_ATTRIBUTES attributes)
+{
+    DIR_ENTRY dir[MAX_DIR_ENTRIES];
+    OPEN_FILE *f = NULL;
+    uint32_t start;
+    int i, entry;
+
+    /* A transient error: the next open works again */
+    if (failOpen) {
+        failOpen = false;
+        fsError = SYS_FS_ERROR_NOT_READY;
+        return SYS_FS_HANDLE_INVALID;
+    }
+    for (i = 0; i < MAX_OPEN_FILES && f == NULL; i++) {
+        if (!files[i].used) {
+            f = &files[i];
+        }
+    }
+    if (f == NULL) {
+        fsError = SYS_FS_ERROR_TOO_MANY_OPEN_FILES;
+        return SYS_FS_HANDLE_INVALID;
+    }
+    dirLoad(dir);
+    entry = dirFind(dir, fname);
+    if (attributes == SYS_FS_FILE_OPEN_WRITE || attributes == SYS_FS_FILE_OPEN_WRITE_PLUS) {
+        /* Create or truncate; the entry is written at once */
+        if (entry < 0) {
+            start = SECTORS_PER_BLOCK;
+            for (i = 0; i < MAX_DIR_ENTRIES; i++) {
+                if (dir[i].name[0] != 0 && (uint8_t) dir[i].name[0] != 0xFF
+                        && dir[i].start + FILE_CAPACITY > start) {
+                    start = dir[i].start + FILE_CAPACITY;
+                }
+            }
+            for (entry = 0; dir[entry].name[0] != 0 && (uint8_t) dir[entry].name[0] != 0xFF; entry++) {
+            }
+            snprintf(dir[entry].name, sizeof(dir[entry].name), "%s", fname);
+            dir[entry].start = start;
+        }
+        else if (strcmp(fname, APP_JOURNAL_FILE_NAME) == 0 && dir[entry].size == APP_JOURNAL_FILE_SIZE) {
+            FAIL("complete journal truncated\n");
+        }
+        dir[entry].size = 0;
+        creates++;
+        dirStore(dir);
+    }
+    else if (entry < 0) {
+        fsError = SYS_FS_ERROR_NO_FILE;
+        return SYS_FS_HANDLE_INVALID;
+    }
+    memset(f, 0, sizeof(*f));
+    f->used = true;
+    f->entry = entry;
+    f->size = dir[entry].size;
+    f->bufSector = UINT32_MAX;
+    return f - files;
+}
+
+SYS_FS_RESULT SYS_FS_FileSync(SYS_FS_HANDLE handle)
+{
+    OPEN_FILE *f = fileGet(handle);
+    DIR_ENTRY dir[MAX_DIR_ENTRIES];
+
+    fileFlush(f);
+    if (f->modified) {
+        /* Size and timestamp */
+        dirLoad(dir);
+        dir[f->entry].size = f->size;
+        dirStore(dir);
+        f->modified = false;
+    }
+    return SYS_FS_RES_SUCCESS;
+}
+
+SYS_FS_RESULT SYS_FS_FileClose(SYS_FS_HANDLE handle)
+{
+    SYS_FS_FileSync(handle);
+    fileGet(handle)->used = false;
+    return SYS_FS_RES_SUCCESS;
+}
+
+size_t SYS_FS_FileRead(SYS_FS_HANDLE handle, void *buffer, size_t nbyte)
+{
+    OPEN_FILE *f = fileGet(handle);
+    uint8_t *out = buffer;
+    uint32_t sector, off, n;
+    size_t done = 0;
+
+    if (nbyte > f->size - f->pos) {
+        nbyte = f->size - f->pos;
+    }
+    while (done < nbyte) {
+        sector = f->pos / SECTOR_SIZE;
+        off = f->pos % SECTOR_SIZE;
+        if (off == 0 && nbyte - done >= SECTOR_SIZE && f->bufSector != sector) {
+            flashRead((fileStart(f) + sector) * SECTOR_SIZE, out + done, SECTOR_SIZE);
+            n = SECTOR_SIZE;
+        }
+        else {
+            fileLoad(f, sector);
+            n = SECTOR_SIZE - off;
+            if (n > nbyte - done) {
+                n = nbyte - done;
+            }
+            memcpy(out + done, &f->buf[off], n);
+        }
+        f->pos += n;
+        done += n;
+    }
+    return done;
+}
+
+size_t SYS_FS_FileWrite(SYS_FS_HANDLE handle, const void *buffer, size_t nbyte)
+{
+    OPEN_FILE *f = fileGet(handle);
+    const uint8_t *in = buffer;
+    uint32_t sector, off, n;
+    size_t done = 0;
+
+    if (f->pos + nbyte > FILE_CAPACITY * SECTOR_SIZE) {
+        fprintf(stderr, "file capacity exceeded\n");
+        abort();
+    }
+    while (done < nbyte) {
+        sector = f->pos / SECTOR_SIZE;
+        off = f->pos % SECTOR_SIZE;
+        if (off == 0 && nbyte - done >= SECTOR_SIZE) {
+            if (f->bufSector == sector) {
+                memcpy(f->buf, in + done, SECTOR_SIZE);
+                f->dirty = false;
+            }
+            flashWriteSector(fileStart(f) + sector, in + done);
+            n = SECTOR_SIZE;
+        }
+        else {
+            fileLoad(f, sector);
+            n = SECTOR_SIZE - off;
+            if (n > nbyte - done) {
+                n = nbyte - done;
+            }
+            memcpy(&f->buf[off], in + done, n);
+            f->dirty = true;
+        }
+        f->pos += n;
+        done += n;
+        if (f->pos > f->size) {
+            f->size = f->pos;
+        }
+        f->modified = true;
+    }
+    return done;
+}
+
+int32_t SYS_FS_FileSeek(SYS_FS_HANDLE handle, int32_t offset, SYS_FS_FILE_SEEK_CONTROL whence)
+{
+    OPEN_FILE *f = fileGet(handle);
+
+    if (whence == SYS_FS_SEEK_CUR) {
+        offset += f->pos;
+    }
+    else if (whence == SYS_FS_SEEK_END) {
+        offset += f->size;
+    }
+    if (offset < 0 || (uint32_t) offset > f->size) {
+        return -1;
+    }
+    f->pos = offset;
+    return offset;
+}
+
+int32_t SYS_FS_FileSize(SYS_FS_HANDLE handle)
+{
+    return fileGet(handle)->size;
+}
+
+SYS_FS_ERROR SYS_FS_Error(void)
+{
+    return fsError;
+}
+
+/* Telemetry encoder stand-in: checks and records the delivered samples ******/
+
+static APP_TELEMETRY_SAMPLE sampleMake(uint32_t id, uint32_t i)
+{
+    APP_TELEMETRY_SAMPLE s;
+
+    memset(&s, 0, sizeof(s));
+    s.timeMs = id;
+    s.temperature = i;
+    s.light = id * 31 + i;
+    return s;
+}
+
+static const APP_TELEMETRY_SAMPLE *encoded;
+static uint32_t encodedCount;
+
+size_t APP_TELEMETRY_Encode(char *pBuffer, size_t bufferSize,
+        const APP_TELEMETRY_SAMPLE *pSamples, uint32_t count, uint32_t *pCount)
+{
+    (void) pBuffer;
+    /* A few samples per PUBLISH, so records go out in several pieces */
+    *pCount = 1 + rand() % 8;
+    if (*pCount > count) {
+        *pCount = count;
+    }
+    encoded = pSamples;
+    encodedCount = *pCount;
+    return bufferSize / 2;
+}
+
+/* A PUBLISH is delivered once it is queued, just before it is committed */
+static void deliver(void)
+{
+    const APP_TELEMETRY_SAMPLE *s;
+    uint32_t i, id, n;
+    uint64_t key;
+
+    for (i = 0; i < encodedCount; i++) {
+        s = &encoded[i];
+        id = s->timeMs;
+        n = (uint16_t) s->temperature;
+        if (id == 0 || id >= nextId || n >= APP_JOURNAL_RECORD_SAMPLES || s->light != id * 31 + n) {
+            FAIL("corrupted sample delivered: %u/%u/%u\n", (unsigned) s->timeMs,
+                    (unsigned) s->temperature, (unsigned) s->light);
+            continue;
+        }
+        key = ((uint64_t) id << 16) | n;
+        if (key <= lastDelivered) {
+            FAIL("sample %u/%u delivered out of order\n", id, n);
+        }
+        lastDelivered = key;
+        if (delivered[id][n]++) {
+            duplicates++;
+        }
+    }
+    encodedCount = 0;
+}
+
+/* Workload *******************************************************************/
+
+static void journalReset(void)
+{
+    /* Power-on state of app_journal.c and of the file system */
+    opened = false;
+    journalFd = SYS_FS_HANDLE_INVALID;
+    headSeq = tailSeq = cursorSeq = 0;
+    replayLoaded = false;
+    replayPos = 0;
+    memset(files, 0, sizeof(files));
+    failOpen = false;
+    lastDelivered = 0;
+    encodedCount = 0;
+}
+
+static void append(void)
+{
+    APP_TELEMETRY_SAMPLE samples[APP_JOURNAL_RECORD_SAMPLES];
+    uint32_t i, count = 1 + rand() % APP_JOURNAL_RECORD_SAMPLES;
+    uint32_t id = nextId++, seq = headSeq;
+
+    if (id >= MAX_IDS) {
+        fprintf(stderr, "too many records\n");
+        exit(2);
+    }
+    for (i = 0; i < APP_JOURNAL_RECORD_SAMPLES; i++) {
+        samples[i] = sampleMake(id, i);
+    }
+    /* Records the harness never delivers get no samples flagged */
+    for (i = count; i < APP_JOURNAL_RECORD_SAMPLES; i++) {
+        delivered[id][i] = 1;
+    }
+    if (!APP_JOURNAL_Append(samples, count)) {
+        FAIL("append %u failed\n", id);
+        return;
+    }
+    ackedSeq[id] = seq;
+    slotId[seq % APP_JOURNAL_RECORDS] = id;
+}
+
+static void replay(void)
+{
+    char buf[256];
+    uint32_t count;
+
+    if (APP_JOURNAL_Backlog() == 0 || !APP_JOURNAL_Load()) {
+        return;
+    }
+    APP_JOURNAL_Write(buf, sizeof(buf), &count);
+    deliver();
+    APP_JOURNAL_Commit(count);
+}
+
+/* A power cut puts the records of all journal slots in the interrupted erase
+ * block at risk. One in the FAT / directory block (only possible while a file
+ * is created or closed) can take the whole journal with it. */
+static void powerCutNoted(uint32_t journalStart)
+{
+    uint32_t sector, slot, id;
+
+    dupBudget += (APP_JOURNAL_CURSOR_INTERVAL + 1) * APP_JOURNAL_RECORD_SAMPLES;
+    if (cutBlock == META_BLOCK) {
+        metaCuts++;
+        for (id = 1; id < nextId; id++) {
+            atRisk[id] = 1;
+        }
+        dupBudget += APP_JOURNAL_RECORDS * APP_JOURNAL_RECORD_SAMPLES;
+        return;
+    }
+    for (sector = cutBlock * SECTORS_PER_BLOCK; sector < (cutBlock + 1u) * SECTORS_PER_BLOCK; sector++) {
+        if (sector < journalStart) {
+            continue;
+        }
+        slot = sector - journalStart;
+        if (slot < APP_JOURNAL_RECORDS) {
+            atRisk[slotId[slot]] = 1;
+        }
+        else if (slot == APP_JOURNAL_CURSOR_SLOT) {
+            /* Torn cursor: every valid record may go out again */
+            dupBudget += APP_JOURNAL_RECORDS * APP_JOURNAL_RECORD_SAMPLES;
+        }
+    }
+}
+
+static uint32_t journalStartGet(void)
+{
+    DIR_ENTRY dir[MAX_DIR_ENTRIES];
+    int entry;
+
+    dirLoad(dir);
+    entry = dirFind(dir, APP_JOURNAL_FILE_NAME);
+    return entry < 0 ? UINT32_MAX : dir[entry].start;
+}
+
+/* One boot; returns true if it ended in a power cut */
+static bool boot(bool cut, bool drain)
+{
+    volatile bool online = drain;
+    uint32_t ops, metaOpen, createsBefore;
+
+    journalReset();
+    steps = 0;
+    cutAt = cut ? 1 + rand() % 600 : 0;
+    if (setjmp(powerCut)) {
+        cutAt = 0;
+        powerCutNoted(journalStartGet());
+        return true;
+    }
+
+    if (!drain && rand() % 8 == 0) {
+        createsBefore = creates;
+        failOpen = true;
+        if (APP_JOURNAL_Open()) {
+            FAIL("open succeeded on a volume that is not ready\n");
+        }
+        if (creates != createsBefore) {
+            FAIL("journal recreated after an open error\n");
+        }
+    }
+    if (!APP_JOURNAL_Open()) {
+        FAIL("open failed\n");
+        return false;
+    }
+    metaOpen = metaErases;
+
+    for (ops = 0; drain ? APP_JOURNAL_Backlog() > 0 && ops < 100000 : ops < 200; ops++) {
+        if (!drain && rand() % 16 == 0) {
+            online = !online;
+        }
+        /* Stay clear of overwriting unsent records */
+        if (online || APP_JOURNAL_Backlog() >= APP_JOURNAL_RECORDS - 2 * APP_JOURNAL_CURSOR_INTERVAL) {
+            replay();
+        }
+        else {
+            append();
+        }
+        if (metaErases != metaOpen) {
+            FAIL("FAT / directory block rewritten during operation\n");
+            metaOpen = metaErases;
+        }
+    }
+    /* A reset without a close loses the unsaved part of the cursor */
+    if (!drain && rand() % 8 == 0) {
+        APP_JOURNAL_Close();
+    }
+    else {
+        dupBudget += (APP_JOURNAL_CURSOR_INTERVAL + 1) * APP_JOURNAL_RECORD_SAMPLES;
+    }
+    return false;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t boots, b, cuts = 0, acked = 0, lost = 0, lostAtRisk = 0, id, i;
+    uint32_t maxErases = 0;
+
+    if (argc != 4) {
+        fprintf(stderr, "usage: %s <flash image> <seed> <boots>\n", argv[0]);
+        return 2;
+    }
+    image = fopen(argv[1], "w+b");
+    if (image == NULL) {
+        perror(argv[1]);
+        return 2;
+    }
+    srand(atoi(argv[2]));
+    boots = atoi(argv[3]);
+    imageFormat();
+
+    for (b = 0; b < boots; b++) {
+        cuts += boot(rand() % 4 != 0, false);
+    }
+    boot(false, true);
+
+    for (id = 1; id < nextId; id++) {
+        if (ackedSeq[id] == 0) {
+            continue;
+        }
+        acked++;
+        for (i = 0; i < APP_JOURNAL_RECORD_SAMPLES && delivered[id][i]; i++) {
+        }
+        if (i < APP_JOURNAL_RECORD_SAMPLES) {
+            lost++;
+            if (atRisk[id]) {
+                lostAtRisk++;
+            }
+            else {
+                FAIL("record %u lost outside any interrupted erase block\n", id);
+            }
+        }
+    }
+    if (duplicates > dupBudget) {
+        FAIL("%u duplicate samples, more than the %u allowed by %u power cuts\n", duplicates, dupBudget, cuts);
+    }
+    for (b = 1; b < FLASH_BLOCKS; b++) {
+        if (blockErases[b] > maxErases) {
+            maxErases = blockErases[b];
+        }
+    }
+    printf("seed %s: %u boots, %u power cuts (%u in the FAT block), %u records, %u lost in cut blocks, "
+            "%u duplicate samples, %u data / %u FAT erases (max %u per block), %u failure(s)\n",
+            argv[2], boots, cuts, metaCuts, acked, lostAtRisk, duplicates, dataErases, metaErases, maxErases, failures);
+    fclose(image);
+    return failures ? 1 : 0;
+}
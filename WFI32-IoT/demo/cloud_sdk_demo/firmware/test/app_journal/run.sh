@@ -0,0 +1,26 @@
+#!/bin/sh
+# Build the telemetry journal harness for the host and run it for COUNT
+# (default 20) seeds of BOOTS (default 300) boots each.
+#
+# usage: run.sh [COUNT] [BOOTS]
+set -e
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+SRC=$HERE/../../src
+COUNT=${1:-20}
+BOOTS=${2:-300}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+CFLAGS="-g -fsanitize=address,undefined -Wall -Wextra -Werror -I$HERE/stub -I$SRC"
+${CC:-cc} $CFLAGS "$HERE/harness.c" -o "$WORK/harness"
+
+fail=0
+seed=1
+while [ "$seed" -le "$COUNT" ]; do
+    "$WORK/harness" "$WORK/flash.bin" "$seed" "$BOOTS" || fail=$((fail + 1))
+    seed=$((seed + 1))
+done
+
+echo "$COUNT seeds, $fail failure(s)"
+[ "$fail" -eq 0 ]
@@ -0,0 +1,9 @@
+#pragma once
+/* Host build stand-in for the Harmony configuration used by app_journal.c */
+#include <stdio.h>
+
+typedef enum { SYS_ERROR_FATAL, SYS_ERROR_ERROR, SYS_ERROR_WARNING, SYS_ERROR_INFO, SYS_ERROR_DEBUG } SYS_ERROR_LEVEL;
+
+/* Format-checked but silent */
+#define SYS_DEBUG_PRINT(level, fmt, ...) do { if (0) fprintf(stderr, fmt, ##__VA_ARGS__); } while (0)
+#define SYS_CONSOLE_PRINT(fmt, ...) do { if (0) fprintf(stderr, fmt, ##__VA_ARGS__); } while (0)
@@ -0,0 +1,39 @@
+#pragma once
+/* Host build stand-in for the SYS_FS calls used by app_journal.c; the
+ * harness implements them over its flash model. */
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uintptr_t SYS_FS_HANDLE;
+#define SYS_FS_HANDLE_INVALID ((SYS_FS_HANDLE)(-1))
+
+typedef enum { SYS_FS_RES_SUCCESS = 0, SYS_FS_RES_FAILURE = -1 } SYS_FS_RESULT;
+typedef enum { SYS_FS_SEEK_SET, SYS_FS_SEEK_CUR, SYS_FS_SEEK_END } SYS_FS_FILE_SEEK_CONTROL;
+typedef enum
+{
+    SYS_FS_FILE_OPEN_READ = 0,
+    SYS_FS_FILE_OPEN_WRITE,
+    SYS_FS_FILE_OPEN_APPEND,
+    SYS_FS_FILE_OPEN_READ_PLUS,
+    SYS_FS_FILE_OPEN_WRITE_PLUS,
+    SYS_FS_FILE_OPEN_APPEND_PLUS
+} SYS_FS_FILE_OPEN_ATTRIBUTES;
+typedef enum
+{
+    SYS_FS_ERROR_OK = 0,
+    SYS_FS_ERROR_DISK_ERR,
+    SYS_FS_ERROR_INT_ERR,
+    SYS_FS_ERROR_NOT_READY,
+    SYS_FS_ERROR_NO_FILE,
+    SYS_FS_ERROR_NO_PATH,
+    SYS_FS_ERROR_TOO_MANY_OPEN_FILES
+} SYS_FS_ERROR;
+
+SYS_FS_HANDLE SYS_FS_FileOpen(const char *fname, SYS_FS_FILE_OPEN_ATTRIBUTES attributes);
+SYS_FS_RESULT SYS_FS_FileClose(SYS_FS_HANDLE handle);
+size_t SYS_FS_FileRead(SYS_FS_HANDLE handle, void *buffer, size_t nbyte);
+size_t SYS_FS_FileWrite(SYS_FS_HANDLE handle, const void *buffer, size_t nbyte);
+int32_t SYS_FS_FileSeek(SYS_FS_HANDLE handle, int32_t offset, SYS_FS_FILE_SEEK_CONTROL whence);
+int32_t SYS_FS_FileSize(SYS_FS_HANDLE handle);
+SYS_FS_RESULT SYS_FS_FileSync(SYS_FS_HANDLE handle);
+SYS_FS_ERROR SYS_FS_Error(void);
@@ -0,0 +1,664 @@
+/*
+ * Host harness for the ATECC608 command execution (calib_execution.c) and the
+ * Harmony I2C HAL (hal_i2c_harmony.c). Both run unchanged against a model of
+ * the I2C plib, the RTOS and the device, in virtual time:
+ *
+ * - the bus runs at the configured 50 kHz and a transfer ends, with the plib
+ *   callback, after the time its bits take;
+ * - task delays and notification waits wake on the 1 ms tick, as FreeRTOS
+ *   does, and hal_delay_us() advances the clock by its argument;
+ * - the device wakes on a general call, executes a command for the time of
+ *   its opcode with 2% jitter, and NACKs its address while it is busy.
+ *
+ * usage: harness
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "cryptoauthlib.h"
+
+static int failures;
+
+#define FAIL(...) do { \
+        printf("FAIL: " __VA_ARGS__); \
+        printf("\n"); \
+        failures++; \
+} while (0)
+
+#define DEVICE_ADDRESS  0x6A
+#define WAKE_DELAY_US   1500
+
+/* Virtual time in microseconds */
+static uint64_t now;
+
+/* What the plib and the RTOS model count */
+static struct
+{
+    uint32_t transfers;
+    uint32_t nacks;
+    uint32_t busyPolls;         /* is_busy() calls that found the bus busy */
+    uint64_t spinUs;            /* hal_delay_us() time spent polling the bus */
+    uint32_t notifyWaits;
+    uint32_t notifyTimeouts;
+} stats;
+
+/* ------------------------------------------------------------------ device */
+
+static struct
+{
+    bool     awake;
+    bool     hung;              /* executes for ever */
+    uint64_t readyAt;           /* wake or command done */
+    uint8_t  out[80];           /* response */
+    uint8_t  outLen;
+    uint8_t  outPos;
+    uint32_t commands;
+    uint32_t badCrcs;
+} dev;
+
+static uint32_t seed = 1;
+
+static uint32_t rnd(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+/* Execution time of an opcode in microseconds, and the length of its
+   response data. Typical ATECC608 times, well below the datasheet maxima */
+static uint32_t execUs(uint8_t opcode, uint8_t* dataLen)
+{
+    switch (opcode) {
+    case ATCA_SIGN:     *dataLen = 64; return 47500;
+    case ATCA_VERIFY:   *dataLen = 1;  return 58000;
+    case ATCA_ECDH:     *dataLen = 32; return 38000;
+    case ATCA_GENKEY:   *dataLen = 64; return 51000;
+    case ATCA_RANDOM:   *dataLen = 32; return 9000;
+    case ATCA_NONCE:    *dataLen = 1;  return 4000;
+    case ATCA_READ:     *dataLen = 32; return 1000;
+    case ATCA_SHA:      *dataLen = 1;  return 1500;
+    case ATCA_INFO:     *dataLen = 4;  return 500;
+    default:            *dataLen = 1;  return 5000;
+    }
+}
+
+static void deviceReset(void)
+{
+    memset(&dev, 0, sizeof(dev));
+}
+
+static void deviceRespond(const uint8_t* data, uint8_t len)
+{
+    dev.out[0] = len + 3;
+    memcpy(&dev.out[1], data, len);
+    atCRC(len + 1, dev.out, &dev.out[len + 1]);
+    dev.outLen = len + 3;
+    dev.outPos = 0;
+}
+
+/* Whether the device acknowledges its address at the start of a transfer */
+static bool deviceAcks(void)
+{
+    return dev.awake && now >= dev.readyAt;
+}
+
+static void deviceWrite(const uint8_t* data, size_t len)
+{
+    uint8_t crc[2];
+    uint8_t dataLen;
+    uint8_t resp[64];
+    uint32_t us;
+
+    switch (data[0]) {
+    case 0x00:          /* reset the address counter */
+        dev.outPos = 0;
+        break;
+    case 0x01:          /* sleep */
+    case 0x02:          /* idle */
+        dev.awake = false;
+        break;
+    case 0x03:          /* command */
+        dev.commands++;
+        atCRC(data[1] - 2, &data[1], crc);
+        if (len != (size_t)data[1] + 1 || memcmp(crc, &data[data[1] - 1], 2)) {
+            dev.badCrcs++;
+        }
+        us = execUs(data[2], &dataLen);
+        /* 2% jitter either way */
+        us = us - us / 50 + rnd() % (us / 25 + 1);
+        dev.readyAt = dev.hung ? UINT64_MAX : now + us;
+        memset(resp, 0xA5, dataLen);
+        if (dataLen == 1) {
+            resp[0] = ATCA_SUCCESS;
+        }
+        deviceRespond(resp, dataLen);
+        break;
+    }
+}
+
+static void deviceRead(uint8_t* data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        data[i] = dev.outPos < dev.outLen ? dev.out[dev.outPos++] : 0xFF;
+    }
+}
+
+/* ------------------------------------------------------------------- plib */
+
+static struct
+{
+    bool         active;
+    bool         read;
+    uint64_t     end;
+    I2C_ERROR    error;
+    uint8_t*     rxBuf;
+    uint8_t      tx[256];
+    size_t       len;
+    uint32_t     baud;
+    I2C_CALLBACK callback;
+    uintptr_t    context;
+    I2C_ERROR    lastError;
+} bus;
+
+/* The plib the device under test was set up with. Both share the bus, but
+   only one with callback_register gets the callback */
+static atca_plib_i2c_api_t* plibInUse;
+
+/* Ends the transfer on the bus if its time has come */
+static void busUpdate(void)
+{
+    if (!bus.active || now < bus.end) {
+        return;
+    }
+    bus.active = false;
+    bus.lastError = bus.error;
+    if (bus.error == I2C_ERROR_NONE) {
+        if (bus.read) {
+            deviceRead(bus.rxBuf, bus.len);
+        }
+        else {
+            deviceWrite(bus.tx, bus.len);
+        }
+    }
+    if (bus.callback && plibInUse->callback_register) {
+        bus.callback(bus.context);
+    }
+}
+
+static void advance(uint64_t to)
+{
+    if (to > now) {
+        now = to;
+    }
+    busUpdate();
+}
+
+static bool busStart(bool read, uint16_t address, uint8_t* data, size_t len)
+{
+    bool ack;
+    size_t bytes;
+
+    if (bus.active || len > sizeof(bus.tx)) {
+        return false;
+    }
+    stats.transfers++;
+    if (address == 0) {
+        /* A general call at 100 kHz or less holds SDA low long enough to
+           wake the device. Nothing acknowledges it */
+        if (!read && bus.baud <= 100000 && !dev.awake) {
+            dev.awake = true;
+            dev.readyAt = now + WAKE_DELAY_US;
+            deviceRespond((const uint8_t[]) { 0x11 }, 1);
+        }
+        ack = false;
+    }
+    else {
+        ack = address == DEVICE_ADDRESS >> 1 && deviceAcks();
+    }
+    bytes = ack ? len + 1 : 1;
+    bus.active = true;
+    bus.read = read;
+    bus.error = ack ? I2C_ERROR_NONE : I2C_ERROR_NACK;
+    bus.rxBuf = data;
+    bus.len = len;
+    if (!read) {
+        memcpy(bus.tx, data, len);
+    }
+    /* 9 bits a byte, start and stop */
+    bus.end = now + ((uint64_t)bytes * 9 + 2) * 1000000 / bus.baud;
+    if (!ack) {
+        stats.nacks++;
+    }
+    return true;
+}
+
+static bool plibRead(uint16_t address, uint8_t* data, size_t len)
+{
+    return busStart(true, address, data, len);
+}
+
+static bool plibWrite(uint16_t address, uint8_t* data, size_t len)
+{
+    return busStart(false, address, data, len);
+}
+
+static bool pollSpin;
+
+static bool plibIsBusy(void)
+{
+    busUpdate();
+    pollSpin = bus.active;
+    if (bus.active) {
+        stats.busyPolls++;
+    }
+    return bus.active;
+}
+
+static I2C_ERROR plibErrorGet(void)
+{
+    return bus.lastError;
+}
+
+static bool plibTransferSetup(I2C_TRANSFER_SETUP* setup, uint32_t srcClkFreq)
+{
+    (void)srcClkFreq;
+    bus.baud = setup->clkSpeed;
+    return true;
+}
+
+static void plibCallbackRegister(I2C_CALLBACK callback, uintptr_t context)
+{
+    bus.callback = callback;
+    bus.context = context;
+}
+
+static atca_plib_i2c_api_t plib = {
+    .read = plibRead,
+    .write = plibWrite,
+    .is_busy = plibIsBusy,
+    .error_get = plibErrorGet,
+    .transfer_setup = plibTransferSetup,
+    .callback_register = plibCallbackRegister,
+};
+
+/* A plib without callbacks, as Harmony generates when interrupts are off */
+static atca_plib_i2c_api_t plibPolled = {
+    .read = plibRead,
+    .write = plibWrite,
+    .is_busy = plibIsBusy,
+    .error_get = plibErrorGet,
+    .transfer_setup = plibTransferSetup,
+};
+
+/* -------------------------------------------------------------------- RTOS */
+
+static bool schedulerRunning = true;
+static int task;
+static uint32_t notified;
+
+void hal_delay_us(uint32_t delay)
+{
+    if (pollSpin) {
+        stats.spinUs += delay;
+    }
+    advance(now + delay);
+}
+
+/* vTaskDelay(pdMS_TO_TICKS(delay) + 1) */
+void hal_rtos_delay_ms(uint32_t delay)
+{
+    pollSpin = false;
+    if (schedulerRunning) {
+        advance((now / 1000 + delay + 1) * 1000);
+    }
+    else {
+        advance(now + (uint64_t)delay * 1000);
+    }
+}
+
+void* hal_rtos_notify_prepare(void)
+{
+    if (!schedulerRunning) {
+        return NULL;
+    }
+    notified = 0;
+    return &task;
+}
+
+ATCA_STATUS hal_rtos_notify_wait(uint32_t delay)
+{
+    uint64_t deadline = (now / 1000 + delay + 1) * 1000;
+
+    stats.notifyWaits++;
+    pollSpin = false;
+    if (!notified && bus.active && bus.end <= deadline) {
+        advance(bus.end);
+    }
+    if (!notified) {
+        advance(deadline);
+    }
+    if (!notified) {
+        stats.notifyTimeouts++;
+        return ATCA_TIMEOUT;
+    }
+    notified--;
+    return ATCA_SUCCESS;
+}
+
+void hal_rtos_notify_from_isr(void* waiter)
+{
+    if (waiter != &task) {
+        FAIL("notified %p, not the waiting task", waiter);
+    }
+    notified++;
+}
+
+/* ------------------------------------------------- basic API, not built */
+
+ATCADeviceType atcab_get_device_type_ext(ATCADevice device)
+{
+    return device->mIface.mIfaceCFG->devtype;
+}
+
+uint8_t atcab_get_device_address(ATCADevice device)
+{
+    return device->mIface.mIfaceCFG->atcai2c.address;
+}
+
+bool atcab_is_ca2_device(ATCADeviceType dev_type)
+{
+    return (dev_type & 0xF0) == 0x20;
+}
+
+/* ------------------------------------------------------------------ tests */
+
+static ATCAIfaceCfg cfg = {
+    .iface_type = ATCA_I2C_IFACE,
+    .devtype = ATECC608,
+    .atcai2c.address = DEVICE_ADDRESS,
+    .atcai2c.bus = 0,
+    .atcai2c.baud = 50000,
+    .wake_delay = WAKE_DELAY_US,
+    .rx_retries = 20,
+};
+
+/* The firmware builds with ATCA_NO_HEAP: the device is static */
+static struct atca_device theDevice;
+
+static ATCADevice start(atca_plib_i2c_api_t* api)
+{
+    ATCADevice device = &theDevice;
+
+    deviceReset();
+    memset(&stats, 0, sizeof(stats));
+    bus.baud = cfg.atcai2c.baud;
+    plibInUse = api;
+    cfg.cfg_data = api;
+    memset(device, 0, sizeof(*device));
+    if (initATCADevice(&cfg, device) != ATCA_SUCCESS) {
+        FAIL("initATCADevice");
+        exit(1);
+    }
+    return device;
+}
+
+/* Runs one command, returning its status and the time it took in us */
+static ATCA_STATUS run(ATCADevice device, uint8_t opcode, uint8_t dataLen, uint64_t* took)
+{
+    ATCAPacket packet;
+    ATCA_STATUS status;
+    uint64_t t0 = now;
+
+    memset(&packet, 0, sizeof(packet));
+    packet.opcode = opcode;
+    packet.txsize = ATCA_CMD_SIZE_MIN + dataLen;
+    atCalcCrc(&packet);
+    status = calib_execute_command(&packet, device);
+    if (took) {
+        *took = now - t0;
+    }
+    if (status == ATCA_SUCCESS && packet.data[0] < 4) {
+        FAIL("opcode %02X: response of %u bytes", opcode, packet.data[0]);
+    }
+    return status;
+}
+
+static atca_exec_time_t* learned(ATCADevice device, uint8_t opcode)
+{
+    for (int i = 0; i < ATCA_POLLING_ADAPTIVE_OPCODES; i++) {
+        if (device->exec_times[i].wait && device->exec_times[i].opcode == opcode) {
+            return &device->exec_times[i];
+        }
+    }
+    return NULL;
+}
+
+/* A sign takes 47.5 ms +/- 2%. The task sleeps whole ticks and one more, so
+   the learned wait goes back and forth within a millisecond of that, and a
+   learned sign is seldom polled more than once */
+static void testConverges(void)
+{
+    ATCADevice device = start(&plib);
+    atca_exec_time_t* entry;
+    uint32_t nacks, firstNacks = 0;
+    uint64_t took, first = 0, mean = 0;
+
+    for (int i = 0; i < 100; i++) {
+        nacks = stats.nacks;
+        if (run(device, ATCA_SIGN, 64, &took) != ATCA_SUCCESS) {
+            FAIL("sign %d failed", i);
+            break;
+        }
+        if (i == 0) {
+            first = took;
+            firstNacks = stats.nacks - nacks;
+        }
+    }
+    entry = learned(device, ATCA_SIGN);
+    if (entry == NULL) {
+        FAIL("sign not learned");
+        releaseATCADevice(device);
+        return;
+    }
+
+    nacks = stats.nacks;
+    for (int i = 0; i < 100; i++) {
+        (void)run(device, ATCA_SIGN, 64, &took);
+        mean += took;
+    }
+    mean /= 100;
+    /* Each command NACKs the wake general call; count the others */
+    nacks = stats.nacks - nacks - 100;
+    firstNacks--;
+    printf("sign: learned %.3f ms; first %.2f ms and %u NACKed polls, "
+           "then %.2f ms and %.2f NACKed polls on average\n",
+           entry->wait / 8.0, first / 1000.0, firstNacks, mean / 1000.0, nacks / 100.0);
+    if (entry->wait < 46 * 8 || entry->wait > 48 * 8) {
+        FAIL("learned wait %.3f ms, not within 1 ms of 47.5 ms", entry->wait / 8.0);
+    }
+    if (nacks > 40) {
+        FAIL("%u NACKed polls in 100 learned signs", nacks);
+    }
+    if (mean >= first) {
+        FAIL("learned signs no faster than the first");
+    }
+    /* Every transfer ends with the callback */
+    if (stats.notifyWaits == 0 || stats.notifyTimeouts) {
+        FAIL("%u of %u notification waits timed out", stats.notifyTimeouts, stats.notifyWaits);
+    }
+    if (dev.badCrcs) {
+        FAIL("%u commands with a bad CRC", dev.badCrcs);
+    }
+
+    /* Re-initialising the device forgets what was learned */
+    if (initATCADevice(&cfg, device) != ATCA_SUCCESS || learned(device, ATCA_SIGN)) {
+        FAIL("learned times kept over initATCADevice()");
+    }
+    releaseATCADevice(device);
+}
+
+/* With every entry taken, a new opcode runs as without learning */
+static void testTableFull(void)
+{
+    ATCADevice device = start(&plib);
+
+    for (int i = 0; i < ATCA_POLLING_ADAPTIVE_OPCODES; i++) {
+        if (run(device, 0x80 + i, 0, NULL) != ATCA_SUCCESS) {
+            FAIL("opcode %02X failed", 0x80 + i);
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        if (run(device, ATCA_SIGN, 64, NULL) != ATCA_SUCCESS) {
+            FAIL("sign with a full table failed");
+        }
+    }
+    if (learned(device, ATCA_SIGN)) {
+        FAIL("sign learned with a full table");
+    }
+    for (int i = 0; i < ATCA_POLLING_ADAPTIVE_OPCODES; i++) {
+        if (!learned(device, 0x80 + i)) {
+            FAIL("opcode %02X lost", 0x80 + i);
+        }
+    }
+    releaseATCADevice(device);
+}
+
+/* A device that never finishes fails the command, learned or not, after no
+   more polls than without learning */
+static void testHung(void)
+{
+    ATCADevice device = start(&plib);
+    const uint32_t maxPolls = ATCA_POLLING_MAX_TIME_MSEC / ATCA_POLLING_FREQUENCY_TIME_MSEC + 1;
+    ATCA_STATUS status;
+    uint32_t nacks;
+    uint64_t took;
+
+    for (int learn = 0; learn < 2; learn++) {
+        if (learn) {
+            dev.hung = false;
+            for (int i = 0; i < 10; i++) {
+                (void)run(device, ATCA_SIGN, 64, NULL);
+            }
+        }
+        dev.hung = true;
+        nacks = stats.nacks;
+        status = run(device, ATCA_SIGN, 64, &took);
+        /* The wake general call and the idle after the failure NACK too */
+        nacks = stats.nacks - nacks - 2;
+        printf("hung device, %s: status %02X after %.2f s and %u polls\n",
+               learn ? "sign learned" : "not learned", status, took / 1e6, nacks);
+        if (status == ATCA_SUCCESS) {
+            FAIL("a hung device succeeded");
+        }
+        if (nacks > maxPolls) {
+            FAIL("%u polls, more than %u", nacks, maxPolls);
+        }
+        if (took < (uint64_t)ATCA_POLLING_MAX_TIME_MSEC * 1000 || took > 2 * (uint64_t)ATCA_POLLING_MAX_TIME_MSEC * 1000) {
+            FAIL("gave up after %.2f s", took / 1e6);
+        }
+        /* Power cycled */
+        deviceReset();
+    }
+    releaseATCADevice(device);
+}
+
+/* Without a plib callback, or before the scheduler runs, the HAL polls the
+   bus for the end of each transfer */
+static void testPolled(void)
+{
+    ATCADevice device;
+
+    for (int mode = 0; mode < 2; mode++) {
+        if (mode == 0) {
+            device = start(&plibPolled);
+        }
+        else {
+            device = start(&plib);
+            schedulerRunning = false;
+        }
+        for (int i = 0; i < 10; i++) {
+            if (run(device, ATCA_SIGN, 64, NULL) != ATCA_SUCCESS) {
+                FAIL("polled sign failed");
+            }
+        }
+        printf("%s: %u bus polls, %u notification waits\n",
+               mode ? "scheduler not running" : "plib without callback",
+               stats.busyPolls, stats.notifyWaits);
+        if (stats.busyPolls == 0 || stats.notifyWaits != 0) {
+            FAIL("not polled");
+        }
+        schedulerRunning = true;
+        releaseATCADevice(device);
+    }
+}
+
+/* The commands of one TLS client handshake */
+static const struct
+{
+    uint8_t opcode;
+    uint8_t dataLen;
+} handshake[] = {
+    { ATCA_INFO, 0 },
+    { ATCA_RANDOM, 0 },
+    { ATCA_READ, 0 }, { ATCA_READ, 0 }, { ATCA_READ, 0 }, { ATCA_READ, 0 },
+    { ATCA_READ, 0 }, { ATCA_READ, 0 }, { ATCA_READ, 0 }, { ATCA_READ, 0 },
+    { ATCA_SHA, 0 }, { ATCA_SHA, 64 }, { ATCA_SHA, 64 }, { ATCA_SHA, 64 },
+    { ATCA_SHA, 64 }, { ATCA_SHA, 0 },
+    { ATCA_NONCE, 32 }, { ATCA_VERIFY, 64 }, { ATCA_NONCE, 32 }, { ATCA_VERIFY, 64 },
+    { ATCA_GENKEY, 0 },
+    { ATCA_ECDH, 64 },
+    { ATCA_NONCE, 32 }, { ATCA_SIGN, 0 },
+    { ATCA_INFO, 0 },
+};
+
+static void runHandshake(ATCADevice device, bool forget, uint64_t* took)
+{
+    uint64_t t0 = now;
+
+    for (size_t i = 0; i < sizeof(handshake) / sizeof(handshake[0]); i++) {
+        if (forget) {
+            memset(device->exec_times, 0, sizeof(device->exec_times));
+        }
+        if (run(device, handshake[i].opcode, handshake[i].dataLen, NULL) != ATCA_SUCCESS) {
+            FAIL("handshake command %zu failed", i);
+        }
+    }
+    *took = now - t0;
+}
+
+/* Not a pass or fail: what one handshake costs, polled with nothing learned
+   as before, and with the plib callback once the times are learned */
+static void reportHandshake(void)
+{
+    ATCADevice device;
+    uint64_t took;
+
+    for (int mode = 0; mode < 2; mode++) {
+        device = start(mode ? &plib : &plibPolled);
+        if (mode) {
+            for (int i = 0; i < 5; i++) {
+                runHandshake(device, false, &took);
+            }
+        }
+        memset(&stats, 0, sizeof(stats));
+        runHandshake(device, !mode, &took);
+        printf("handshake, %-29s %6.1f ms, %3u transfers, %3u NACKed, %6.1f ms spinning\n",
+               mode ? "callback, learned:" : "polled, nothing learned:",
+               took / 1000.0, stats.transfers, stats.nacks, stats.spinUs / 1000.0);
+        releaseATCADevice(device);
+    }
+}
+
+int main(void)
+{
+    testConverges();
+    testTableFull();
+    testHung();
+    testPolled();
+    reportHandshake();
+
+    printf("%d failure(s)\n", failures);
+    return failures ? 1 : 0;
+}
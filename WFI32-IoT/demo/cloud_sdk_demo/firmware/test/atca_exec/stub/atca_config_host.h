@@ -0,0 +1,4 @@
+/* The project's atca_config.h, with cryptoauthlib's own software crypto
+   instead of wolfSSL. Force-included ahead of every source */
+#include "atca_config.h"
+#undef ATCA_WOLFSSL
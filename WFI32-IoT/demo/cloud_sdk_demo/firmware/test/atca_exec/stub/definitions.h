@@ -0,0 +1,28 @@
+/* Host stand-in for the generated definitions.h: only what cryptoauthlib's
+   atca_config.h and the Harmony I2C HAL use */
+#ifndef DEFINITIONS_H
+#define DEFINITIONS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+typedef enum
+{
+    I2C_ERROR_NONE = 0,
+    I2C_ERROR_NACK,
+    I2C_ERROR_BUS,
+} I2C_ERROR;
+
+typedef struct
+{
+    uint32_t clkSpeed;
+} I2C_TRANSFER_SETUP;
+
+typedef void (*I2C_CALLBACK)(uintptr_t contextHandle);
+
+#define OSAL_Malloc malloc
+#define OSAL_Free   free
+
+#endif
@@ -0,0 +1,606 @@
+/*
+ * Host harness for the BA414E driver queue (drv_ba414e.c). The driver runs
+ * unchanged against a simulated engine:
+ *
+ * - the shared crypto memory and the microcode memory are mapped at their
+ *   device addresses, and the PK registers are variables;
+ * - when the driver starts an operation, the engine records it and the curve
+ *   it finds in the domain slots, then raises the done interrupt. A modular
+ *   operation copies operand A to the result; an ECDSA verify fails when the
+ *   first bytes of R and S differ. An operation can be made to fault, in
+ *   which case the engine scribbles over the curve order first;
+ * - whether the domain was loaded for an operation or left resident from the
+ *   previous one is told by a marker the engine keeps in the unused end of
+ *   slot 0, which only a full clear of the crypto memory removes.
+ *
+ * Built without HOST_RTOS, the tests drive DRV_BA414E_Tasks() from one thread
+ * with non-blocking clients. Built with it, a driver thread runs the tasks,
+ * the engine completes operations when that thread is about to block, and
+ * blocking clients submit from their own threads.
+ *
+ * usage: harness
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "configuration.h"
+#include "osal/osal.h"
+#include "driver/ba414e/drv_ba414e.h"
+#include "interrupts.h"
+#include "system/int/sys_int.h"
+
+static int failures;
+
+#define FAIL(...) do { \
+        printf("FAIL: " __VA_ARGS__); \
+        printf("\n"); \
+        failures++; \
+} while (0)
+
+#define KEY_SIZE    32
+#define OP_SIZE     DRV_BA414E_OPSZ_256
+#define SCM         ((uint8_t *)(uintptr_t)__CRYPTO1SCM_BASE)
+#define SLOT(n)     (SCM + ((n) << 6))
+#define UCM_ADDR    ((uintptr_t)(__CRYPTO1UCM_BASE | 0x20000000))
+#define MARKER      0x5A        /* in the last byte of slot 0 */
+
+volatile uint32_t PKCONTROL;
+volatile uint32_t PKCOMMAND;
+volatile uint32_t PKCONFIG;
+volatile uint32_t PKSTATUS;
+
+/* ------------------------------------------------------------------ curves */
+
+static uint8_t curveParams[2][6][KEY_SIZE];
+static DRV_BA414E_ECC_DOMAIN curves[2];
+
+static void curvesInit(void)
+{
+    int c, p, i;
+    for (c = 0; c < 2; c++) {
+        for (p = 0; p < 6; p++) {
+            for (i = 0; i < KEY_SIZE; i++) {
+                curveParams[c][p][i] = (uint8_t)(rand() | 1);
+            }
+        }
+        curves[c].keySize = KEY_SIZE;
+        curves[c].opSize = OP_SIZE;
+        curves[c].primeField = curveParams[c][0];
+        curves[c].order = curveParams[c][1];
+        curves[c].generatorX = curveParams[c][2];
+        curves[c].generatorY = curveParams[c][3];
+        curves[c].a = curveParams[c][4];
+        curves[c].b = curveParams[c][5];
+        curves[c].cofactor = 1;
+    }
+}
+
+/* ------------------------------------------------------------------ engine */
+
+static bool intEnabled[INT_SOURCE_COUNT];
+
+void SYS_INT_SourceEnable(INT_SOURCE source)
+{
+    intEnabled[source] = true;
+}
+
+bool SYS_INT_SourceDisable(INT_SOURCE source)
+{
+    bool was = intEnabled[source];
+    intEnabled[source] = false;
+    return was;
+}
+
+bool SYS_INT_SourceStatusGet(INT_SOURCE source)
+{
+    (void)source;
+    return false;
+}
+
+void SYS_INT_SourceStatusClear(INT_SOURCE source)
+{
+    (void)source;
+}
+
+#define MAX_RUNS    4096
+
+/* One operation the engine ran */
+typedef struct
+{
+    uint8_t operation;
+    int8_t  curve;              /* found in slots 0..5, -1 for none */
+    bool    loaded;             /* the domain was written for it */
+} RUN;
+
+static struct
+{
+    RUN      runs[MAX_RUNS];
+    uint32_t count;
+    uint32_t loads;
+    bool     faultNext;
+} engine;
+
+static bool isEcc(uint8_t operation)
+{
+    return operation >= 0x20;
+}
+
+static int8_t domainCurve(void)
+{
+    int8_t c;
+    int p;
+    for (c = 0; c < 2; c++) {
+        for (p = 0; p < 6; p++) {
+            if (memcmp(SLOT(p), curveParams[c][p], KEY_SIZE) != 0) {
+                break;
+            }
+        }
+        if (p == 6) {
+            return c;
+        }
+    }
+    return -1;
+}
+
+/* Runs the started operation, if any, to its interrupt */
+static void engineStep(void)
+{
+    union { uint32_t v; __PKCOMMANDbits_t s; } cmd = { .v = PKCOMMAND };
+    union { uint32_t v; __PKSTATUSbits_t s; } status = { .v = 0 };
+    RUN run = { .operation = cmd.s.OPERATION, .curve = -1 };
+    uint32_t len = cmd.s.OPSIZE * 8;
+
+    if (PKCONTROL != 1 || !intEnabled[INT_SOURCE_CRYPTO1]) {
+        return;
+    }
+    if (isEcc(run.operation)) {
+        run.curve = domainCurve();
+        run.loaded = SLOT(0)[63] != MARKER;
+        SLOT(0)[63] = MARKER;
+        if (run.loaded) {
+            engine.loads++;
+        }
+    }
+    if (engine.count < MAX_RUNS) {
+        engine.runs[engine.count] = run;
+    }
+    engine.count++;
+
+    if (engine.faultNext) {
+        engine.faultNext = false;
+        memset(SLOT(1), 0xEE, len);
+        PKSTATUS = 0;
+        if (intEnabled[INT_SOURCE_CRYPTO1_FAULT]) {
+            DRV_BA414E_ErrorInterruptHandler();
+        }
+        return;
+    }
+    if (run.operation == 0x31) {            /* ECDSA verify */
+        status.s.SIGINVAL = SLOT(0xA)[0] != SLOT(0xB)[0];
+    }
+    else if (!isEcc(run.operation)) {        /* modular, A to C */
+        memcpy(SLOT(3), SLOT(1), len);
+    }
+    PKSTATUS = status.v;
+    DRV_BA414E_InterruptHandler();
+}
+
+/* ------------------------------------------------------------------ OSAL */
+
+/* Set on the thread that runs DRV_BA414E_Tasks() */
+static __thread bool onDriverThread;
+
+/* Called by a task about to block: on the driver thread, the engine finishes
+   what it was given */
+void osal_idle_hook(void)
+{
+    if (onDriverThread) {
+        engineStep();
+    }
+}
+
+OSAL_RESULT OSAL_SEM_Create(OSAL_SEM_HANDLE_TYPE* semID, OSAL_SEM_TYPE type, uint8_t maxCount, uint8_t initialCount)
+{
+    (void)type;
+    pthread_mutex_init(&semID->lock, NULL);
+    pthread_cond_init(&semID->cond, NULL);
+    semID->count = initialCount;
+    semID->max = maxCount;
+    return OSAL_RESULT_SUCCESS;
+}
+
+OSAL_RESULT OSAL_SEM_Delete(OSAL_SEM_HANDLE_TYPE* semID)
+{
+    pthread_cond_destroy(&semID->cond);
+    pthread_mutex_destroy(&semID->lock);
+    return OSAL_RESULT_SUCCESS;
+}
+
+OSAL_RESULT OSAL_SEM_Pend(OSAL_SEM_HANDLE_TYPE* semID, uint16_t waitMS)
+{
+    (void)waitMS;
+    pthread_mutex_lock(&semID->lock);
+    while (semID->count == 0) {
+        pthread_mutex_unlock(&semID->lock);
+        osal_idle_hook();
+        pthread_mutex_lock(&semID->lock);
+        if (semID->count == 0) {
+            pthread_cond_wait(&semID->cond, &semID->lock);
+        }
+    }
+    semID->count--;
+    pthread_mutex_unlock(&semID->lock);
+    return OSAL_RESULT_SUCCESS;
+}
+
+OSAL_RESULT OSAL_SEM_Post(OSAL_SEM_HANDLE_TYPE* semID)
+{
+    pthread_mutex_lock(&semID->lock);
+    if (semID->count < semID->max) {
+        semID->count++;
+    }
+    pthread_cond_signal(&semID->cond);
+    pthread_mutex_unlock(&semID->lock);
+    return OSAL_RESULT_SUCCESS;
+}
+
+OSAL_RESULT OSAL_SEM_PostISR(OSAL_SEM_HANDLE_TYPE* semID)
+{
+    return OSAL_SEM_Post(semID);
+}
+
+/* ------------------------------------------------------------------ clients */
+
+static SYS_MODULE_OBJ obj = SYS_MODULE_OBJ_INVALID;
+
+static void mapMemories(void)
+{
+    if (mmap(SCM, 4096, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0) != SCM ||
+        mmap((void *)UCM_ADDR, 8192, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0) != (void *)UCM_ADDR) {
+        perror("mmap");
+        exit(2);
+    }
+}
+
+/* Operands of one job */
+typedef struct
+{
+    uint8_t x[KEY_SIZE], y[KEY_SIZE], r[KEY_SIZE], s[KEY_SIZE], hash[KEY_SIZE];
+    uint8_t p[KEY_SIZE], a[KEY_SIZE], b[KEY_SIZE], c[KEY_SIZE];
+} JOB;
+
+static void jobInit(JOB * job, unsigned * seed, bool valid)
+{
+    uint8_t * bytes = (uint8_t *)job;
+    size_t i;
+    for (i = 0; i < sizeof(*job); i++) {
+        bytes[i] = (uint8_t)rand_r(seed);
+    }
+    job->s[0] = valid ? job->r[0] : (uint8_t)~job->r[0];
+    memset(job->c, 0, sizeof(job->c));
+}
+
+static DRV_BA414E_OP_RESULT verify(DRV_HANDLE h, int curve, JOB * job,
+        DRV_BA414E_CALLBACK callback, uintptr_t context)
+{
+    return DRV_BA414E_ECDSA_Verify(h, &curves[curve], job->x, job->y, job->r, job->s,
+            job->hash, KEY_SIZE, callback, context);
+}
+
+static DRV_BA414E_OP_RESULT modAdd(DRV_HANDLE h, JOB * job,
+        DRV_BA414E_CALLBACK callback, uintptr_t context)
+{
+    return DRV_BA414E_PRIM_ModAddition(h, OP_SIZE, job->c, job->p, job->a, job->b,
+            callback, context);
+}
+
+#ifndef HOST_RTOS
+
+#define MAX_JOBS    8
+
+/* Completions of the non-blocking jobs, in order */
+static struct
+{
+    uintptr_t order[MAX_JOBS];
+    DRV_BA414E_OP_RESULT result[MAX_JOBS];
+    unsigned count;
+} done;
+
+static void jobDone(DRV_BA414E_OP_RESULT result, uintptr_t context)
+{
+    if (done.count < MAX_JOBS) {
+        done.order[done.count] = context;
+    }
+    done.result[context] = result;
+    done.count++;
+}
+
+/* A freshly initialised driver with no clients and an idle engine */
+static void restart(void)
+{
+    if (obj != SYS_MODULE_OBJ_INVALID) {
+        DRV_BA414E_Deinitialize(obj);
+    }
+    obj = DRV_BA414E_Initialize(0, NULL);
+    if (obj == SYS_MODULE_OBJ_INVALID) {
+        FAIL("initialize failed");
+    }
+    memset(&engine, 0, sizeof(engine));
+    memset(&done, 0, sizeof(done));
+}
+
+static DRV_HANDLE openClient(void)
+{
+    DRV_HANDLE h = DRV_BA414E_Open(0, DRV_IO_INTENT_READWRITE | DRV_IO_INTENT_NONBLOCKING);
+    if (h == DRV_HANDLE_INVALID) {
+        FAIL("open failed");
+    }
+    return h;
+}
+
+/* Runs the driver and the engine until COUNT jobs have completed */
+static void pump(unsigned count)
+{
+    unsigned i;
+    for (i = 0; i < 10000 && done.count < count; i++) {
+        DRV_BA414E_Tasks(obj);
+        engineStep();
+    }
+    if (done.count < count) {
+        FAIL("%u of %u jobs completed", done.count, count);
+    }
+}
+
+static void expectOrder(const char * test, const uintptr_t * order, unsigned count)
+{
+    unsigned i;
+    for (i = 0; i < count; i++) {
+        if (done.order[i] != order[i]) {
+            FAIL("%s: position %u ran job %lu, expected job %lu",
+                 test, i + 1, (unsigned long)done.order[i], (unsigned long)order[i]);
+        }
+    }
+}
+
+/* A HIGH job submitted behind three NORMAL ones runs first */
+static void testHighFirst(void)
+{
+    static const uintptr_t order[] = { 3, 0, 1, 2 };
+    JOB jobs[4];
+    DRV_HANDLE h[4];
+    unsigned seed = 1;
+    uintptr_t i;
+
+    restart();
+    for (i = 0; i < 4; i++) {
+        h[i] = openClient();
+        jobInit(&jobs[i], &seed, true);
+    }
+    DRV_BA414E_PrioritySet(h[3], DRV_BA414E_PRIORITY_HIGH);
+    for (i = 0; i < 4; i++) {
+        if (verify(h[i], 0, &jobs[i], jobDone, i) != DRV_BA414E_OP_PENDING) {
+            FAIL("high first: job %lu not queued", (unsigned long)i);
+        }
+    }
+    pump(4);
+    expectOrder("high first", order, 4);
+}
+
+/* Within a class jobs run in submission order, whichever client slots they
+   come from; LOW runs after NORMAL. Open hands out the slots from the top,
+   so job 0 is in slot 4 and job 3 in slot 1 */
+static void testFifo(void)
+{
+    static const uintptr_t order[] = { 3, 0, 2, 1 };
+    JOB jobs[4];
+    DRV_HANDLE h[4];
+    unsigned seed = 2;
+    uintptr_t i;
+
+    restart();
+    for (i = 0; i < 4; i++) {
+        h[i] = openClient();
+        jobInit(&jobs[i], &seed, true);
+    }
+    DRV_BA414E_PrioritySet(h[1], DRV_BA414E_PRIORITY_LOW);
+    verify(h[1], 0, &jobs[1], jobDone, 1);
+    verify(h[3], 0, &jobs[3], jobDone, 3);
+    verify(h[0], 0, &jobs[0], jobDone, 0);
+    verify(h[2], 0, &jobs[2], jobDone, 2);
+    pump(4);
+    expectOrder("fifo", order, 4);
+}
+
+/* Three verifies on one curve, from different clients, load it once. The
+   results still follow each job's signature */
+static void testChain(void)
+{
+    JOB jobs[3];
+    DRV_HANDLE h[3];
+    unsigned seed = 3;
+    uintptr_t i;
+
+    restart();
+    for (i = 0; i < 3; i++) {
+        h[i] = openClient();
+        jobInit(&jobs[i], &seed, i != 1);
+        verify(h[i], 1, &jobs[i], jobDone, i);
+    }
+    pump(3);
+    if (engine.loads != 1) {
+        FAIL("chain: the curve was loaded %u times", engine.loads);
+    }
+    for (i = 0; i < 3; i++) {
+        DRV_BA414E_OP_RESULT expected = i != 1 ? DRV_BA414E_OP_SUCCESS : DRV_BA414E_OP_SIGN_VERIFY_FAIL;
+        if (engine.runs[i].curve != 1) {
+            FAIL("chain: job %lu ran on curve %d", (unsigned long)i, engine.runs[i].curve);
+        }
+        if (done.result[i] != expected) {
+            FAIL("chain: job %lu returned %d, expected %d", (unsigned long)i, done.result[i], expected);
+        }
+    }
+}
+
+/* Switching curves, a modular operation and a fault each cost a reload; the
+   engine always sees the curve the job asked for */
+static void testReload(void)
+{
+    /* curve, -1 for a modular addition; fault; domain loaded for it */
+    static const struct { int curve; bool fault; bool loaded; } seq[] = {
+        { 1, false, true },
+        { 1, false, false },
+        { 0, false, true },
+        { -1, false, false },
+        { 0, true, true },
+        { 0, false, true },
+        { 0, false, false },
+    };
+    const unsigned n = sizeof(seq) / sizeof(seq[0]);
+    DRV_HANDLE h;
+    JOB job;
+    unsigned seed = 4;
+    unsigned i;
+
+    restart();
+    h = openClient();
+    for (i = 0; i < n; i++) {
+        DRV_BA414E_OP_RESULT expected = seq[i].fault ? DRV_BA414E_OP_ERROR : DRV_BA414E_OP_SUCCESS;
+        jobInit(&job, &seed, true);
+        engine.faultNext = seq[i].fault;
+        done.count = 0;
+        if (seq[i].curve < 0) {
+            modAdd(h, &job, jobDone, 0);
+        }
+        else {
+            verify(h, seq[i].curve, &job, jobDone, 0);
+        }
+        pump(1);
+        if (done.result[0] != expected) {
+            FAIL("reload: job %u returned %d, expected %d", i, done.result[0], expected);
+        }
+        if (seq[i].curve < 0) {
+            if (memcmp(job.c, job.a, KEY_SIZE) != 0) {
+                FAIL("reload: job %u, wrong sum", i);
+            }
+            continue;
+        }
+        if (engine.runs[i].curve != seq[i].curve) {
+            FAIL("reload: job %u ran on curve %d, expected %d", i, engine.runs[i].curve, seq[i].curve);
+        }
+        if (engine.runs[i].loaded != seq[i].loaded) {
+            FAIL("reload: job %u %s the curve", i, engine.runs[i].loaded ? "loaded" : "did not load");
+        }
+    }
+    if (engine.loads != 4) {
+        FAIL("reload: %u curve loads, expected 4", engine.loads);
+    }
+    printf("reload: %u operations, %u curve loads\n", engine.count, engine.loads);
+}
+
+int main(void)
+{
+    mapMemories();
+    curvesInit();
+    testHighFirst();
+    testFifo();
+    testChain();
+    testReload();
+    printf("%d failure(s)\n", failures);
+    return failures != 0;
+}
+
+#else
+
+#define CLIENTS     4
+#define JOBS        500
+
+static void * driverMain(void * arg)
+{
+    (void)arg;
+    onDriverThread = true;
+    for (;;) {
+        DRV_BA414E_Tasks(obj);
+    }
+    return NULL;
+}
+
+/* One client and the errors it saw */
+typedef struct
+{
+    unsigned id;
+    unsigned wrongResult;
+    unsigned wrongSum;
+} CLIENT_ERRORS;
+
+/* Blocking verifies on its own curve and modular additions, checked */
+static void * clientMain(void * arg)
+{
+    CLIENT_ERRORS * errors = arg;
+    unsigned seed = errors->id + 1;
+    int curve = errors->id & 1;
+    DRV_HANDLE h = DRV_BA414E_Open(0, DRV_IO_INTENT_READWRITE);
+    JOB job;
+    unsigned i;
+
+    if (h == DRV_HANDLE_INVALID) {
+        errors->wrongResult = JOBS;
+        return NULL;
+    }
+    for (i = 0; i < JOBS; i++) {
+        bool valid = rand_r(&seed) & 1;
+        jobInit(&job, &seed, valid);
+        if (i % 3 == 2) {
+            if (modAdd(h, &job, NULL, 0) != DRV_BA414E_OP_SUCCESS) {
+                errors->wrongResult++;
+            }
+            else if (memcmp(job.c, job.a, KEY_SIZE) != 0) {
+                errors->wrongSum++;
+            }
+        }
+        else if (verify(h, curve, &job, NULL, 0) !=
+                 (valid ? DRV_BA414E_OP_SUCCESS : DRV_BA414E_OP_SIGN_VERIFY_FAIL)) {
+            errors->wrongResult++;
+        }
+    }
+    DRV_BA414E_Close(h);
+    return NULL;
+}
+
+int main(void)
+{
+    static CLIENT_ERRORS errors[CLIENTS];
+    pthread_t driver, clients[CLIENTS];
+    unsigned i;
+
+    mapMemories();
+    curvesInit();
+    obj = DRV_BA414E_Initialize(0, NULL);
+    pthread_create(&driver, NULL, driverMain, NULL);
+    for (i = 0; i < CLIENTS; i++) {
+        errors[i].id = i;
+        pthread_create(&clients[i], NULL, clientMain, &errors[i]);
+    }
+    for (i = 0; i < CLIENTS; i++) {
+        pthread_join(clients[i], NULL);
+        if (errors[i].wrongResult != 0 || errors[i].wrongSum != 0) {
+            FAIL("client %u: %u wrong results, %u wrong sums", i, errors[i].wrongResult, errors[i].wrongSum);
+        }
+    }
+    for (i = 0; i < engine.count && i < MAX_RUNS; i++) {
+        if (isEcc(engine.runs[i].operation) && engine.runs[i].curve < 0) {
+            FAIL("operation %u ran on a corrupt curve", i);
+        }
+    }
+    if (engine.count != CLIENTS * JOBS) {
+        FAIL("%u operations ran, expected %u", engine.count, CLIENTS * JOBS);
+    }
+    printf("%u clients: %u operations, %u curve loads\n", CLIENTS, engine.count, engine.loads);
+    printf("%d failure(s)\n", failures);
+    return failures != 0;
+}
+
+#endif
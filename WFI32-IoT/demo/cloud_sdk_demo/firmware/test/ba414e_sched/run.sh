@@ -0,0 +1,52 @@
+#!/bin/sh
+# Build the BA414E driver for the host against the simulated engine in
+# harness.c and run its tests: the queue order and the curve caching with
+# ASan, blocking clients on several threads under ThreadSanitizer, and the
+# same with the submission lock removed, which it must report.
+#
+# usage: run.sh
+set -e
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+CFG=$HERE/../../src/config/aws_sdk_wfi32_iot_freertos
+DRV=$CFG/driver/ba414e/src
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# Without the lock in DRV_BA414E_Submit(), clients race on the sequence
+# number and on the operation the driver task picks from
+sed '/^static DRV_BA414E_OP_RESULT DRV_BA414E_Submit/,/^}/{/clientListSema/d}' \
+    "$DRV/drv_ba414e.c" > "$WORK/drv_ba414e_unlocked.c"
+cmp -s "$DRV/drv_ba414e.c" "$WORK/drv_ba414e_unlocked.c" && { echo "no lock found in DRV_BA414E_Submit"; exit 1; }
+
+# The driver keeps its warnings (enum conversions, pointers from addresses);
+# the harness builds with -Werror.
+CFLAGS="-g -Wall -Wextra -pthread -I$HERE/stub -I$CFG -I$DRV"
+build() {
+    name=$1 src=$2
+    shift 2
+    ${CC:-cc} $CFLAGS "$@" -c "$src" -o "$WORK/$name-drv.o" 2>> "$WORK/warnings"
+    ${CC:-cc} $CFLAGS "$@" -Werror -c "$HERE/harness.c" -o "$WORK/$name-harness.o"
+    ${CC:-cc} -pthread "$@" "$WORK/$name-drv.o" "$WORK/$name-harness.o" -o "$WORK/$name"
+}
+build queue "$DRV/drv_ba414e.c" -fsanitize=address,undefined
+build rtos "$DRV/drv_ba414e.c" -DHOST_RTOS -O1 -fsanitize=thread
+build unlocked "$WORK/drv_ba414e_unlocked.c" -DHOST_RTOS -O1 -fsanitize=thread
+
+fail=0
+echo "== queue order and curve caching"
+"$WORK/queue" || fail=$((fail + 1))
+
+echo "== blocking clients, ThreadSanitizer"
+"$WORK/rtos" || fail=$((fail + 1))
+
+echo "== submission lock removed, must be reported"
+if TSAN_OPTIONS=halt_on_error=1 "$WORK/unlocked" > "$WORK/out" 2>&1; then
+    echo "FAIL: no data race reported"
+    fail=$((fail + 1))
+else
+    grep -m1 'WARNING: ThreadSanitizer' "$WORK/out" || { cat "$WORK/out"; fail=$((fail + 1)); }
+fi
+
+echo "$fail failure(s)"
+[ "$fail" -eq 0 ]
@@ -0,0 +1,14 @@
+/* Host stand-in for the generated configuration.h: the BA414E driver
+   settings, with the RTOS build selected by HOST_RTOS */
+#ifndef CONFIGURATION_H
+#define CONFIGURATION_H
+
+#include "device.h"
+
+#define DRV_BA414E_NUM_CLIENTS 5
+#ifdef HOST_RTOS
+#define DRV_BA414E_RTOS_STACK_SIZE           1024
+#define DRV_BA414E_RTOS_TASK_PRIORITY             1
+#endif
+
+#endif
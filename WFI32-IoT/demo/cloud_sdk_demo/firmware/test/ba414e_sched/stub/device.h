@@ -0,0 +1,48 @@
+/* Host stand-in for the PIC32MZW1 device header: the BA414E registers are
+   variables and its memories are mapped by the harness at these addresses.
+   The register fields are the ones the driver uses, not at their device
+   bit positions */
+#ifndef DEVICE_H
+#define DEVICE_H
+
+#include <stdint.h>
+
+#define __CRYPTO1SCM_BASE   0x10000000u
+#define __CRYPTO1UCM_BASE   0x00100000u     /* the driver ORs in 0x20000000 */
+
+typedef struct
+{
+    uint32_t OPERATION:7;
+    uint32_t FIELD:1;
+    uint32_t OPSIZE:4;
+    uint32_t :4;
+    uint32_t SELCURVE:4;
+    uint32_t :11;
+    uint32_t CALCR2:1;
+} __PKCOMMANDbits_t;
+
+typedef struct
+{
+    uint32_t OPPTRA:4;
+    uint32_t :4;
+    uint32_t OPPTRB:4;
+    uint32_t :4;
+    uint32_t OPPTRC:4;
+    uint32_t :12;
+} __PKCONFIGbits_t;
+
+typedef struct
+{
+    uint32_t :4;
+    uint32_t PXINF:1;
+    uint32_t PXNOC:1;
+    uint32_t SIGINVAL:1;
+    uint32_t :25;
+} __PKSTATUSbits_t;
+
+extern volatile uint32_t PKCONTROL;
+extern volatile uint32_t PKCOMMAND;
+extern volatile uint32_t PKCONFIG;
+extern volatile uint32_t PKSTATUS;
+
+#endif
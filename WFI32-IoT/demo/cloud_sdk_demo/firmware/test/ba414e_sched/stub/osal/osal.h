@@ -0,0 +1,44 @@
+/* Host stand-in for the OSAL semaphores, on POSIX threads. A task that is
+   about to block first calls osal_idle_hook(), where the harness lets the
+   simulated engine raise its interrupt */
+#ifndef OSAL_H
+#define OSAL_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+typedef enum
+{
+    OSAL_RESULT_FAIL = 0,
+    OSAL_RESULT_SUCCESS = 1,
+} OSAL_RESULT;
+
+typedef enum
+{
+    OSAL_SEM_TYPE_BINARY,
+    OSAL_SEM_TYPE_COUNTING,
+} OSAL_SEM_TYPE;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    unsigned        count;
+    unsigned        max;
+} OSAL_SEM_HANDLE_TYPE;
+
+#define OSAL_SEM_DECLARE(semID)     OSAL_SEM_HANDLE_TYPE semID
+#define OSAL_WAIT_FOREVER           ((uint16_t)0xFFFF)
+
+#define OSAL_Malloc                 malloc
+#define OSAL_Free                   free
+
+OSAL_RESULT OSAL_SEM_Create(OSAL_SEM_HANDLE_TYPE* semID, OSAL_SEM_TYPE type, uint8_t maxCount, uint8_t initialCount);
+OSAL_RESULT OSAL_SEM_Delete(OSAL_SEM_HANDLE_TYPE* semID);
+OSAL_RESULT OSAL_SEM_Pend(OSAL_SEM_HANDLE_TYPE* semID, uint16_t waitMS);
+OSAL_RESULT OSAL_SEM_Post(OSAL_SEM_HANDLE_TYPE* semID);
+OSAL_RESULT OSAL_SEM_PostISR(OSAL_SEM_HANDLE_TYPE* semID);
+
+void osal_idle_hook(void);
+
+#endif
@@ -0,0 +1,19 @@
+/* Host stand-in for the interrupt system service: only the crypto sources */
+#ifndef SYS_INT_H
+#define SYS_INT_H
+
+#include <stdbool.h>
+
+typedef enum
+{
+    INT_SOURCE_CRYPTO1,
+    INT_SOURCE_CRYPTO1_FAULT,
+    INT_SOURCE_COUNT
+} INT_SOURCE;
+
+void SYS_INT_SourceEnable(INT_SOURCE source);
+bool SYS_INT_SourceDisable(INT_SOURCE source);
+bool SYS_INT_SourceStatusGet(INT_SOURCE source);
+void SYS_INT_SourceStatusClear(INT_SOURCE source);
+
+#endif
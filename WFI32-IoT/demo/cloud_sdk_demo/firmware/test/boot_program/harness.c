@@ -0,0 +1,502 @@
+/*
+ * Host model of the bootloader copying the image file into the slot:
+ * Bootloader_Task_ProgramImage() of bootloader_wolfcrypt.c and the int_flash.c
+ * job queue, as they are in the bootloader, run in virtual time next to the
+ * serial copy they replaced (e2213c2).
+ *
+ * usage: harness [-e ERASE_MS] [-w ROW_MS] [-c CALL_US] [-s BYTE_NS] RAW LZ [RAW LZ ...]
+ *   -e ERASE_MS  page erase time, 20 ms by default
+ *   -w ROW_MS    row write time, 2 ms by default
+ *   -c CALL_US   time of each SST26 file read call, 200 us by default
+ *   -s BYTE_NS   SST26 file read time per byte, 500 ns by default
+ *   RAW, LZ      an image file and the same packed by hex2bin.py -c
+ *
+ * The model:
+ *  - the NVM runs one page erase or row write at a time, for the times
+ *    given, and calls the int_flash.c completion handler when it is done,
+ *    which may start the next one, as the NVM interrupt does;
+ *  - a file read blocks the task for the call time plus the time per byte;
+ *    completions that fall due meanwhile are handled during the read;
+ *  - the busy-waits of int_flash.c pass time to the next completion;
+ *  - each pass of the main loop through the task takes LOOP_US; the CPU
+ *    time of the task itself, decompression included, is not counted.
+ * The times are assumptions, not measurements of the PIC32MZW1 or the SST26.
+ *
+ * For each image it prints the copy time of both, the NVM busy time and the
+ * file read time of the pipelined copy, and how much of the read time the
+ * NVM was busy. It fails when:
+ *  - a row is programmed without its page being erased, an operation is
+ *    started while the NVM is busy, or one is outside the slot;
+ *  - the slot does not hold the image followed by 0xFF to the end of its
+ *    sector, or for a new image, the header does not give its size;
+ *  - a failing row write or a packed file cut short does not end the task
+ *    with an error, or leaves the queue unable to program a sector;
+ *  - the pipelined copy is slower than the serial one.
+ */
+#include <unistd.h>
+
+#include "definitions.h"
+#include "boot_config.h"
+#include "ota_image.h"
+#include "ota_lz.h"
+#include "int_flash.h"
+#include "boot_types.h"
+
+static int failures;
+
+#define FAIL(...) do { \
+        printf("FAIL: " __VA_ARGS__); \
+        printf("\n"); \
+        failures++; \
+} while (0)
+
+#define LOOP_US         10u
+
+/* ---- NVM in virtual time ---- */
+
+static uint64_t now;                    /* microseconds */
+static uint64_t nvmDue;
+static bool nvmPending;
+static NVM_CALLBACK nvmCallback;
+static uintptr_t nvmContext;
+static uint32_t eraseUs = 20000, rowUs = 2000;
+static uint64_t nvmUs, readUs, hiddenUs;
+static uint32_t rowWrites, rowToFail;   /* counted from 1; 0 for none */
+static uint8_t flash[NVM_FLASH_SIZE];
+
+/* Passes time, handling the NVM completions that fall due. While READING,
+   the time the NVM is busy counts as hidden */
+static void passTime(uint64_t us, bool reading)
+{
+    uint64_t end = now + us;
+
+    while (nvmPending && nvmDue <= end) {
+        if (reading) {
+            hiddenUs += nvmDue - now;
+        }
+        now = nvmDue;
+        nvmPending = false;
+        nvmCallback(nvmContext);
+    }
+    if (reading && nvmPending) {
+        hiddenUs += end - now;
+    }
+    now = end;
+}
+
+static void pass(void)
+{
+    passTime(LOOP_US, false);
+}
+
+void HOST_Spin(void)
+{
+    if (!nvmPending) {
+        printf("FAIL: int_flash.c waits for the NVM while it is idle\n");
+        exit(1);
+    }
+    passTime(nvmDue - now, false);
+}
+
+/* The physical offset of an NVM address in the slot, or -1 */
+static int64_t slotOffset(uint32_t address, uint32_t len)
+{
+    uint32_t start = NVM_FLASH_START_ADDRESS + APP_IMG_SLOT_ADDR;
+
+    if (address < start || address - start > FACTORY_RESET_IMG_SIZE - len) {
+        FAIL("NVM access outside the slot: 0x%08X + %u", (unsigned)address, (unsigned)len);
+        return -1;
+    }
+    return address - NVM_FLASH_START_ADDRESS;
+}
+
+static bool nvmStart(const char *what, uint32_t address, uint32_t align, uint32_t us)
+{
+    if (nvmPending) {
+        FAIL("%s of 0x%08X started while the NVM is busy", what, (unsigned)address);
+        return false;
+    }
+    if (address % align != 0) {
+        FAIL("%s of 0x%08X is not aligned", what, (unsigned)address);
+        return false;
+    }
+    nvmPending = true;
+    nvmDue = now + us;
+    nvmUs += us;
+    return true;
+}
+
+void NVM_Initialize(void)
+{
+}
+
+void NVM_CallbackRegister(NVM_CALLBACK callback, uintptr_t context)
+{
+    nvmCallback = callback;
+    nvmContext = context;
+}
+
+bool NVM_PageErase(uint32_t address)
+{
+    int64_t offset = slotOffset(address, NVM_FLASH_PAGESIZE);
+
+    if (offset < 0 || !nvmStart("page erase", address, NVM_FLASH_PAGESIZE, eraseUs)) {
+        return false;
+    }
+    memset(&flash[offset], 0xFF, NVM_FLASH_PAGESIZE);
+    return true;
+}
+
+bool NVM_RowWrite(uint32_t *data, uint32_t address)
+{
+    int64_t offset = slotOffset(address, NVM_FLASH_ROWSIZE);
+    uint32_t i;
+
+    if (++rowWrites == rowToFail) {
+        return false;
+    }
+    if (offset < 0 || !nvmStart("row write", address, NVM_FLASH_ROWSIZE, rowUs)) {
+        return false;
+    }
+    for (i = 0; i < NVM_FLASH_ROWSIZE; i++) {
+        if (flash[offset + i] != 0xFF) {
+            FAIL("row 0x%08X programmed without being erased", (unsigned)address);
+            return false;
+        }
+    }
+    memcpy(&flash[offset], data, NVM_FLASH_ROWSIZE);
+    return true;
+}
+
+bool NVM_Read(uint32_t *data, uint32_t length, const uint32_t address)
+{
+    int64_t offset = slotOffset(address, length);
+
+    if (offset < 0) {
+        return false;
+    }
+    memcpy(data, &flash[offset], length);
+    return true;
+}
+
+/* ---- the image file on the SST26 ---- */
+
+static const uint8_t *file;
+static size_t fileLen, filePos;
+static bool fileClosed;
+static uint32_t callUs = 200, byteNs = 500;
+
+size_t SYS_FS_FileRead(SYS_FS_HANDLE handle, void *buf, size_t len)
+{
+    uint64_t us;
+
+    (void)handle;
+    if (len > fileLen - filePos) {
+        len = fileLen - filePos;
+    }
+    memcpy(buf, file + filePos, len);
+    filePos += len;
+    us = callUs + (uint64_t)len * byteNs / 1000;
+    readUs += us;
+    passTime(us, true);
+    return len;
+}
+
+int32_t SYS_FS_FileSeek(SYS_FS_HANDLE handle, int32_t offset, SYS_FS_FILE_SEEK_CONTROL whence)
+{
+    (void)handle;
+    (void)whence;
+    filePos = (size_t)offset < fileLen ? (size_t)offset : fileLen;
+    return offset;
+}
+
+int32_t SYS_FS_FileSize(SYS_FS_HANDLE handle)
+{
+    (void)handle;
+    return (int32_t)fileLen;
+}
+
+int SYS_FS_FileClose(SYS_FS_HANDLE handle)
+{
+    (void)handle;
+    fileClosed = true;
+    return 0;
+}
+
+/* ---- what bootloader_wolfcrypt.c has around the task ---- */
+
+#define FACTORY_IMAGE_VERIFICATION_ENABLED
+
+static struct {
+    SYS_FS_HANDLE fileHandle;
+} appFile;
+
+static bool factory_reset = true;
+static bool new_image = false;
+static BOOTLOADER_DATA bootloader;
+
+#include "boot_program.c"
+
+/* ---- the serial copy of e2213c2 ---- */
+
+/* The whole slot is erased, then each sector is read and programmed with
+   busy-waits, and the header sector is read again and programmed last. The
+   task took a pass of the main loop for each step */
+static bool serialCopy(void)
+{
+    uint8_t *buf = bootloader.buf;
+    uint32_t copyLen = SYS_FS_FileSize(appFile.fileHandle), offset;
+
+    SYS_FS_FileSeek(appFile.fileHandle, 0, SYS_FS_SEEK_SET);
+    SYS_FS_FileRead(appFile.fileHandle, buf, FLASH_SECTOR_SIZE);
+    pass();
+    if (!INT_Flash_Erase(APP_IMG_SLOT_ADDR, FACTORY_RESET_IMG_SIZE)) {
+        return false;
+    }
+    pass();
+    for (offset = FLASH_SECTOR_SIZE; offset < copyLen; offset += FLASH_SECTOR_SIZE) {
+        SYS_FS_FileSeek(appFile.fileHandle, offset, SYS_FS_SEEK_SET);
+        SYS_FS_FileRead(appFile.fileHandle, buf, FLASH_SECTOR_SIZE);
+        pass();
+        INT_Flash_Write(APP_IMG_SLOT_ADDR + offset, buf, FLASH_SECTOR_SIZE);
+        pass();
+    }
+    SYS_FS_FileSeek(appFile.fileHandle, 0, SYS_FS_SEEK_SET);
+    SYS_FS_FileRead(appFile.fileHandle, buf, FLASH_SECTOR_SIZE);
+    pass();
+    if (!INT_Flash_Write(APP_IMG_SLOT_ADDR, buf, FLASH_SECTOR_SIZE)) {
+        return false;
+    }
+    pass();
+    SYS_FS_FileClose(appFile.fileHandle);
+    pass();
+    return true;
+}
+
+/* ---- runs ---- */
+
+/* Puts FILE on the SST26 and a programmed image in the slot */
+static void reset(const uint8_t *data, size_t len, bool newImage)
+{
+    if (nvmPending) {
+        FAIL("the NVM is still busy from the previous run");
+        passTime(nvmDue - now, false);
+    }
+    file = data;
+    fileLen = len;
+    filePos = 0;
+    fileClosed = false;
+    new_image = newImage;
+    factory_reset = !newImage;
+    memset(&flash[APP_IMG_SLOT_ADDR], 0x00, FACTORY_RESET_IMG_SIZE);
+    memset(&bootloader, 0, sizeof(bootloader));
+    now = nvmUs = readUs = hiddenUs = 0;
+    rowWrites = 0;
+}
+
+static BOOTLOADER_STATUS pipelinedCopy(void)
+{
+    BOOTLOADER_STATUS status;
+    uint32_t passes = 0;
+
+    bootloader.task.state = TASK_STATE_P_INIT;
+    do {
+        status = Bootloader_Task_ProgramImage();
+        pass();
+        if (++passes > 10000000) {
+            FAIL("the task does not finish");
+            break;
+        }
+    } while (status == BOOTLOADER_STATUS_MORE_PROCESSING_REQUIRED);
+    return status;
+}
+
+static void checkSlot(const char *name, const uint8_t *raw, size_t rawLen, bool newImage)
+{
+    const uint8_t *slot = &flash[APP_IMG_SLOT_ADDR];
+    size_t end = (rawLen + FLASH_SECTOR_SIZE - 1) / FLASH_SECTOR_SIZE * FLASH_SECTOR_SIZE;
+    size_t from = 0, i;
+
+    if (newImage) {
+        FIRMWARE_IMAGE_HEADER hdr;
+
+        memcpy(&hdr, slot, sizeof(hdr));
+        if (hdr.sz != rawLen || hdr.type != IMG_TYPE_PRODUCTION || hdr.boot_addr != APP_IMG_BOOT_ADDR) {
+            FAIL("%s: the header gives %u bytes, type %u, boot address 0x%08X", name,
+                 (unsigned)hdr.sz, hdr.type, (unsigned)hdr.boot_addr);
+        }
+        from = sizeof(hdr);
+    }
+    if (memcmp(slot + from, raw + from, rawLen - from) != 0) {
+        FAIL("%s: the slot does not hold the image", name);
+    }
+    for (i = rawLen; i < end; i++) {
+        if (slot[i] != 0xFF) {
+            FAIL("%s: the last sector is not padded with 0xFF", name);
+            break;
+        }
+    }
+}
+
+/* Erases and programs the first sector through the queue */
+static void checkQueueReusable(const char *what)
+{
+    static uint8_t sector[FLASH_SECTOR_SIZE];
+    uint32_t ticket;
+
+    if (nvmPending || INT_Flash_QueueTasks() != INT_FLASH_QUEUE_IDLE) {
+        FAIL("%s: the queue is left busy", what);
+        return;
+    }
+    memset(sector, 0x5A, sizeof(sector));
+    if (INT_Flash_QueueErase(APP_IMG_SLOT_ADDR, FLASH_SECTOR_SIZE) == 0
+            || (ticket = INT_Flash_QueueWrite(APP_IMG_SLOT_ADDR, sector, FLASH_SECTOR_SIZE)) == 0) {
+        FAIL("%s: the queue takes no more jobs", what);
+        return;
+    }
+    while (INT_Flash_QueueTasks() == INT_FLASH_QUEUE_BUSY) {
+        pass();
+    }
+    if (!INT_Flash_QueueDone(ticket) || memcmp(&flash[APP_IMG_SLOT_ADDR], sector, sizeof(sector)) != 0) {
+        FAIL("%s: the queue does not program a sector afterwards", what);
+    }
+}
+
+static void checkFailures(const char *name, const uint8_t *raw, size_t rawLen, const uint8_t *lz, size_t lzLen)
+{
+    char what[128];
+
+    /* A row write halfway through the image fails */
+    reset(raw, rawLen, false);
+    rowToFail = rawLen / NVM_FLASH_ROWSIZE / 2 + 1;
+    snprintf(what, sizeof(what), "%s: row write %u failing", name, (unsigned)rowToFail);
+    if (pipelinedCopy() != (BOOTLOADER_STATUS)BOOTLOADER_STATUS_ERROR) {
+        FAIL("%s does not end the task with an error", what);
+    }
+    rowToFail = 0;
+    checkQueueReusable(what);
+
+    /* The packed file ends halfway */
+    reset(lz, lzLen / 2, true);
+    snprintf(what, sizeof(what), "%s: packed file cut short", name);
+    if (pipelinedCopy() != (BOOTLOADER_STATUS)BOOTLOADER_STATUS_ERROR) {
+        FAIL("%s does not end the task with an error", what);
+    }
+    checkQueueReusable(what);
+}
+
+static uint8_t *load(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    uint8_t *p;
+    long n;
+
+    if (f == NULL || fseek(f, 0, SEEK_END) != 0 || (n = ftell(f)) < 0) {
+        perror(path);
+        exit(2);
+    }
+    /* One byte more, so an empty file has an address */
+    p = malloc(n + 1);
+    rewind(f);
+    if (p == NULL || fread(p, 1, n, f) != (size_t)n) {
+        perror(path);
+        exit(2);
+    }
+    fclose(f);
+    *len = n;
+    return p;
+}
+
+static void report(const char *name, const char *kind, size_t len, const char *serial, double pipelined)
+{
+    printf("%-10s %-6s %7u %10s %10.0f %10.0f %10.0f %9.0f %%\n", name, kind, (unsigned)len, serial,
+           pipelined, nvmUs / 1e3, readUs / 1e3, readUs ? 100.0 * hiddenUs / readUs : 0.0);
+}
+
+static void run(const char *rawPath, const char *lzPath)
+{
+    const char *base = strrchr(rawPath, '/') ? strrchr(rawPath, '/') + 1 : rawPath;
+    char name[32];
+    size_t rawLen, lzLen;
+    uint8_t *raw = load(rawPath, &rawLen);
+    uint8_t *lz = load(lzPath, &lzLen);
+    double serial, pipelined;
+    char serialMs[16];
+
+    snprintf(name, sizeof(name), "%.*s", (int)strcspn(base, "."), base);
+    /* The serial copy took the raw file */
+    reset(raw, rawLen, false);
+    if (!serialCopy()) {
+        FAIL("%s: the serial copy fails", name);
+    }
+    serial = now / 1e3;
+    snprintf(serialMs, sizeof(serialMs), "%.0f", serial);
+
+    reset(raw, rawLen, false);
+    if (pipelinedCopy() != BOOTLOADER_STATUS_SUCCESS) {
+        FAIL("%s: the copy fails", name);
+    }
+    pipelined = now / 1e3;
+    checkSlot(name, raw, rawLen, false);
+    if (!fileClosed) {
+        FAIL("%s: the factory reset file is not closed", name);
+    }
+    report(name, "raw", rawLen, serialMs, pipelined);
+    if (pipelined > serial) {
+        FAIL("%s: the pipelined copy is slower than the serial one", name);
+    }
+
+    /* A new image, packed */
+    reset(lz, lzLen, true);
+    if (pipelinedCopy() != BOOTLOADER_STATUS_SUCCESS) {
+        FAIL("%s: the copy of the packed file fails", name);
+    }
+    pipelined = now / 1e3;
+    checkSlot(name, raw, rawLen, true);
+    report(name, "packed", lzLen, "-", pipelined);
+    if (pipelined > serial) {
+        FAIL("%s: the pipelined copy of the packed file is slower than the serial one", name);
+    }
+
+    checkFailures(name, raw, rawLen, lz, lzLen);
+    free(raw);
+    free(lz);
+}
+
+int main(int argc, char **argv)
+{
+    int c, i;
+
+    while ((c = getopt(argc, argv, "e:w:c:s:")) != -1) {
+        switch (c) {
+        case 'e':
+            eraseUs = (uint32_t)(atof(optarg) * 1000);
+            break;
+        case 'w':
+            rowUs = (uint32_t)(atof(optarg) * 1000);
+            break;
+        case 'c':
+            callUs = (uint32_t)atoi(optarg);
+            break;
+        case 's':
+            byteNs = (uint32_t)atoi(optarg);
+            break;
+        default:
+            return 2;
+        }
+    }
+    if ((argc - optind) % 2 != 0 || argc == optind) {
+        printf("usage: harness [-e ERASE_MS] [-w ROW_MS] [-c CALL_US] [-s BYTE_NS] RAW LZ [RAW LZ ...]\n");
+        return 2;
+    }
+    INT_Flash_Initialize();
+
+    printf("page erase %.1f ms, row write %.1f ms; file reads %u us a call and %u ns a byte; %u us a loop pass\n",
+           eraseUs / 1e3, rowUs / 1e3, (unsigned)callUs, (unsigned)byteNs, LOOP_US);
+    printf("image      file     bytes  serial ms   piped ms     NVM ms    read ms  read hidden\n");
+    for (i = optind; i < argc; i += 2) {
+        run(argv[i], argv[i + 1]);
+    }
+    printf("%d failure(s)\n", failures);
+    return failures != 0;
+}
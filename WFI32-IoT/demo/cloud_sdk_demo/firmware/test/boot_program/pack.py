@@ -0,0 +1,52 @@
+#!/usr/bin/env python3
+"""Make the images for the bootloader programming model with
+tools/hex2bin/hex2bin.py.
+
+usage: pack.py <repo root> <out dir>
+
+The images are the application of the prebuilt unified hex, converted as
+hex2bin.py does to fill the 0xDF000 slot, its first 600 kB and its first
+2000 bytes. Each is also packed with a 12-bit window. Writes <name>.bin and
+<name>.lz and prints the list "raw lz" for the harness on stdout.
+"""
+import os
+import sys
+import types
+
+ROOT, OUT = sys.argv[1], sys.argv[2]
+DEMO = os.path.join(ROOT, 'WFI32-IoT', 'demo', 'cloud_sdk_demo')
+SLOT_START, SLOT_SIZE = 0x10020000, 0xDF000
+
+# hex2bin.py colours its messages; the model does not need colorama
+try:
+    import colorama  # noqa: F401
+except ImportError:
+    plain = types.SimpleNamespace(GREEN='', RED='', YELLOW='')
+    sys.modules['colorama'] = types.SimpleNamespace(init=lambda **kw: None, Fore=plain)
+sys.path.insert(0, os.path.join(DEMO, 'tools', 'hex2bin'))
+import hex2bin  # noqa: E402
+
+
+def main():
+    os.makedirs(OUT, exist_ok=True)
+    slot = os.path.join(OUT, 'prebuilt.bin')
+    hex_file = os.path.join(ROOT, 'WFI32-IoT', 'prebuilt', 'aws_sdk_wfi32_iot_freertos.X.production.unified.hex')
+    stdout, sys.stdout = sys.stdout, sys.stderr
+    status = hex2bin.hex2bin(hex_file, slot, SLOT_START + SLOT_SIZE, SLOT_START, 1)
+    sys.stdout = stdout
+    if status != 0:
+        sys.exit('hex2bin failed on ' + hex_file)
+    with open(slot, 'rb') as f:
+        app = f.read()
+
+    for name, raw in (('app_2000', app[:2000]), ('app_600k', app[:600 * 1024]), ('app_slot', app)):
+        raw_path = os.path.join(OUT, name + '.bin')
+        with open(raw_path, 'wb') as f:
+            f.write(raw)
+        lz_path = os.path.join(OUT, name + '.lz')
+        with open(lz_path, 'wb') as f:
+            f.write(hex2bin.lz_compress(raw, 12))
+        print(raw_path, lz_path)
+
+
+main()
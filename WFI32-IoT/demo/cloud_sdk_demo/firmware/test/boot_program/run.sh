@@ -0,0 +1,53 @@
+#!/bin/sh
+# Build the bootloader image programming model for the host and run it: the
+# pipelined copy of the image into the slot against the serial copy it
+# replaced, with the default flash and SPI times, slower flash, and a slower
+# SPI flash.
+#
+# usage: run.sh
+set -e
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+ROOT=$(cd "$HERE/../../../../../.." && pwd)
+BOOT=$ROOT/ota_bootloader/firmware/src/bootloader
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# The slot layout, the task data and the image programming task, as they are
+# in the bootloader
+sed '/^#ifdef SYS_OTA_BOOTLOAD_FROM_DEDICATED_BOOTFLASH_ENABLED/,/^#else/d' "$BOOT/ota_config.h" |
+    grep -E '^#define (FLASH_SECTOR_SIZE|APP_IMG_SLOT_ADDR|APP_IMG_BOOT_ADDR|FACTORY_RESET_IMG_SIZE) ' > "$WORK/boot_config.h"
+sed -n '/^typedef uint32_t BOOTLOADER_STATUS;$/p; /^#define BOOTLOADER_STATUS_/p' \
+    "$BOOT/bootloader_wolfcrypt.c" > "$WORK/boot_types.h"
+sed -n '/^#define __woraround_unused_variable/,/^} BOOTLOADER_DATA;$/p' \
+    "$BOOT/bootloader_wolfcrypt.c" | sed 1d >> "$WORK/boot_types.h"
+awk '/^\/\* The image is copied in blocks/ { p = 1 }
+     p { print }
+     /^static BOOTLOADER_STATUS Bootloader_Task_ProgramImage\(void\) \{$/ { f = 1 }
+     f && /^}$/ { exit }' "$BOOT/bootloader_wolfcrypt.c" > "$WORK/boot_program.c"
+[ "$(wc -l < "$WORK/boot_config.h")" -eq 4 ] || { echo "slot layout not found in ota_config.h"; exit 1; }
+grep -q '^} BOOTLOADER_DATA;$' "$WORK/boot_types.h" || { echo "task data not found in bootloader_wolfcrypt.c"; exit 1; }
+grep -q '^    return BOOTLOADER_STATUS_MORE_PROCESSING_REQUIRED;$' "$WORK/boot_program.c" ||
+    { echo "image programming task not found in bootloader_wolfcrypt.c"; exit 1; }
+
+# int_flash.c, with its busy-waits passing virtual time
+sed -e 's/while(OpDone == false);/while (OpDone == false) HOST_Spin();/' \
+    -e 's/while (flash_queue_running) ;/while (flash_queue_running) HOST_Spin();/' \
+    "$BOOT/int_flash.c" > "$WORK/int_flash.c"
+[ "$(grep -c 'HOST_Spin();' "$WORK/int_flash.c")" -eq 3 ] || { echo "busy-waits not found in int_flash.c"; exit 1; }
+
+python3 "$HERE/pack.py" "$ROOT" "$WORK/images" > "$WORK/list"
+
+# The firmware sources keep their warnings; the harness builds with -Werror
+CFLAGS="-O1 -g -fsanitize=address,undefined -Wall -Wextra -I$HERE/stub -I$BOOT -I$WORK"
+${CC:-cc} $CFLAGS -Wno-attributes -c "$WORK/int_flash.c" -o "$WORK/int_flash.o" 2>> "$WORK/warnings"
+${CC:-cc} $CFLAGS -c "$BOOT/ota_lz.c" -o "$WORK/ota_lz.o" 2>> "$WORK/warnings"
+${CC:-cc} $CFLAGS -Werror -Wno-sign-compare -Wno-unused-function -c "$HERE/harness.c" -o "$WORK/harness.o"
+${CC:-cc} -fsanitize=address,undefined "$WORK"/*.o -o "$WORK/harness"
+
+export ASAN_OPTIONS=detect_leaks=0
+"$WORK/harness" $(cat "$WORK/list")
+echo "-- flash twice as slow"
+"$WORK/harness" -e 40 -w 8 $(cat "$WORK/list")
+echo "-- SPI flash four times as slow"
+"$WORK/harness" -s 2000 -c 800 $(cat "$WORK/list")
@@ -0,0 +1,35 @@
+#pragma once
+/* Host build stand-in for the Harmony definitions used by int_flash.c and
+   the image programming task of bootloader_wolfcrypt.c */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+
+/* peripheral/nvm/plib_nvm.h of pic32mz_w1_curiosity_wolfcrypt */
+#define NVM_FLASH_START_ADDRESS    (0x90000000U)
+#define NVM_FLASH_SIZE             (0x200000U)
+#define NVM_FLASH_ROWSIZE          (1024U)
+#define NVM_FLASH_PAGESIZE         (4096U)
+
+typedef void (*NVM_CALLBACK)(uintptr_t context);
+
+void NVM_Initialize(void);
+bool NVM_Read(uint32_t *data, uint32_t length, const uint32_t address);
+bool NVM_RowWrite(uint32_t *data, uint32_t address);
+bool NVM_PageErase(uint32_t address);
+void NVM_CallbackRegister(NVM_CALLBACK callback, uintptr_t context);
+
+/* What run.sh puts in the busy-waits of int_flash.c: passes virtual time up
+   to the completion of the NVM operation in progress */
+void HOST_Spin(void);
+
+typedef int SYS_FS_HANDLE;
+#define SYS_FS_HANDLE_INVALID   (-1)
+typedef enum { SYS_FS_SEEK_SET, SYS_FS_SEEK_CUR, SYS_FS_SEEK_END } SYS_FS_FILE_SEEK_CONTROL;
+size_t SYS_FS_FileRead(SYS_FS_HANDLE handle, void *buf, size_t len);
+int32_t SYS_FS_FileSeek(SYS_FS_HANDLE handle, int32_t offset, SYS_FS_FILE_SEEK_CONTROL whence);
+int32_t SYS_FS_FileSize(SYS_FS_HANDLE handle);
+int SYS_FS_FileClose(SYS_FS_HANDLE handle);
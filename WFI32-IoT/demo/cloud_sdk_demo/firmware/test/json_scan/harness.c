@@ -0,0 +1,380 @@
+/*
+ * Host harness and benchmark for the JSON path scanner (src/app_json.c)
+ * against the cJSON tree it replaced in the shadow delta callback.
+ *
+ * usage: harness FIXTURES ITERATIONS
+ *
+ * FIXTURES/queries.txt lists a document and a path per line. Each document
+ * is loaded into a buffer of its exact size, without a NUL, as the MQTT
+ * payload is. cJSON is the OTA copy (OTA_cJSON_*), parsing a NUL terminated
+ * copy and walking the path with OTA_cJSON_GetObjectItemCaseSensitive() and
+ * OTA_cJSON_GetArrayItem(). Its allocations are counted. It fails when:
+ *  - the scanner and cJSON differ on whether the path is there, on the type
+ *    of its value, or on the value of a literal, number or string;
+ *  - the scanner allocates;
+ *  - with ITERATIONS 0, under ASan: the scanner reads outside a document
+ *    cut short at any length, or with any byte replaced by a character
+ *    that means something to JSON.
+ *
+ * With ITERATIONS above 0 it then times each query ITERATIONS times with
+ * both, the typed getter the firmware would call for the scanner and parse,
+ * walk, read and delete for cJSON, and fails when the scanner is slower.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "app_json.h"
+#include "cJSON.h"
+
+static int failures;
+
+#define FAIL(...) do { \
+        printf("FAIL: " __VA_ARGS__); \
+        printf("\n"); \
+        failures++; \
+} while (0)
+
+#define MAX_QUERIES     64
+
+typedef struct
+{
+    char        file[64];
+    char        path[64];
+    char*       doc;                    /* exact size, no NUL */
+    char*       text;                   /* NUL terminated, for cJSON */
+    size_t      length;
+} QUERY;
+
+static QUERY queries[MAX_QUERIES];
+static int nQueries;
+
+/* ------------------------------------------------------- counting allocator */
+
+static struct
+{
+    uint32_t    count;
+    size_t      live;
+    size_t      peak;
+} heap;
+
+void* OSAL_Malloc(size_t size)
+{
+    size_t* block = malloc(sizeof(max_align_t) + size);
+
+    if (block == NULL) {
+        return NULL;
+    }
+    *block = size;
+    heap.count++;
+    heap.live += size;
+    if (heap.live > heap.peak) {
+        heap.peak = heap.live;
+    }
+    return (char*)block + sizeof(max_align_t);
+}
+
+void OSAL_Free(void* pData)
+{
+    size_t* block;
+
+    if (pData == NULL) {
+        return;
+    }
+    block = (size_t*)((char*)pData - sizeof(max_align_t));
+    heap.live -= *block;
+    free(block);
+}
+
+/* ------------------------------------------------------------------ loading */
+
+static void loadQueries(const char* dir)
+{
+    char name[512], line[256];
+    FILE* f;
+    int i;
+
+    if (snprintf(name, sizeof(name), "%s/queries.txt", dir) >= (int)sizeof(name)) {
+        exit(2);
+    }
+    f = fopen(name, "r");
+    if (f == NULL) {
+        perror(name);
+        exit(2);
+    }
+    while (fgets(line, sizeof(line), f) != NULL && nQueries < MAX_QUERIES) {
+        QUERY* q = &queries[nQueries];
+        if (line[0] == '#' || sscanf(line, "%63s %63s", q->file, q->path) != 2) {
+            continue;
+        }
+        nQueries++;
+    }
+    fclose(f);
+
+    for (i = 0; i < nQueries; i++) {
+        QUERY* q = &queries[i];
+        long size;
+
+        if (snprintf(name, sizeof(name), "%s/%s", dir, q->file) >= (int)sizeof(name)) {
+            exit(2);
+        }
+        f = fopen(name, "rb");
+        if (f == NULL || fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) <= 0) {
+            perror(name);
+            exit(2);
+        }
+        rewind(f);
+        q->length = (size_t)size;
+        q->doc = malloc(q->length);
+        q->text = malloc(q->length + 1);
+        if (q->doc == NULL || q->text == NULL || fread(q->doc, 1, q->length, f) != q->length) {
+            perror(name);
+            exit(2);
+        }
+        fclose(f);
+        memcpy(q->text, q->doc, q->length);
+        q->text[q->length] = '\0';
+    }
+}
+
+/* -------------------------------------------------------------------- cJSON */
+
+/* The same path syntax as APP_JSON_Find() */
+static cJSON* cjsonFind(cJSON* item, const char* path)
+{
+    char key[64];
+    size_t n;
+
+    while (item != NULL && *path != '\0') {
+        if (*path == '[') {
+            item = OTA_cJSON_GetArrayItem(item, (int)strtoul(path + 1, (char**)&path, 10));
+            path++;
+        }
+        else {
+            n = strcspn(path, ".[");
+            memcpy(key, path, n);
+            key[n] = '\0';
+            item = OTA_cJSON_GetObjectItemCaseSensitive(item, key);
+            path += n;
+        }
+        if (*path == '.') {
+            path++;
+        }
+    }
+    return item;
+}
+
+static APP_JSON_TYPE cjsonType(const cJSON* item)
+{
+    switch (item->type & 0xFF) {
+    case cJSON_False:   return APP_JSON_TYPE_FALSE;
+    case cJSON_True:    return APP_JSON_TYPE_TRUE;
+    case cJSON_NULL:    return APP_JSON_TYPE_NULL;
+    case cJSON_Number:  return APP_JSON_TYPE_NUMBER;
+    case cJSON_String:  return APP_JSON_TYPE_STRING;
+    case cJSON_Array:   return APP_JSON_TYPE_ARRAY;
+    case cJSON_Object:  return APP_JSON_TYPE_OBJECT;
+    default:            return APP_JSON_TYPE_INVALID;
+    }
+}
+
+/* ------------------------------------------------------------------- checks */
+
+static void compare(const QUERY* q)
+{
+    APP_JSON_VALUE value;
+    cJSON* root = OTA_cJSON_Parse(q->text);
+    cJSON* item = cjsonFind(root, q->path);
+    bool found;
+    uint32_t allocations = heap.count;
+
+    found = APP_JSON_Find(q->doc, q->length, q->path, &value);
+    if (heap.count != allocations) {
+        FAIL("%s %s: the scanner allocated", q->file, q->path);
+    }
+    if (root == NULL) {
+        FAIL("%s: cJSON does not parse it", q->file);
+    }
+    else if (found != (item != NULL)) {
+        FAIL("%s %s: scanner %s, cJSON %s", q->file, q->path,
+             found ? "found it" : "did not find it", item ? "found it" : "did not find it");
+    }
+    else if (found && value.type != cjsonType(item)) {
+        FAIL("%s %s: scanner type %d, cJSON type %d", q->file, q->path, value.type, cjsonType(item));
+    }
+    else if (found && value.type == APP_JSON_TYPE_STRING) {
+        char buffer[256];
+        if (!APP_JSON_GetString(q->doc, q->length, q->path, buffer, sizeof(buffer))
+                || strcmp(buffer, item->valuestring) != 0) {
+            FAIL("%s %s: scanner \"%s\", cJSON \"%s\"", q->file, q->path, buffer, item->valuestring);
+        }
+    }
+    else if (found && value.type == APP_JSON_TYPE_NUMBER) {
+        char buffer[64];
+        int32_t number;
+        snprintf(buffer, sizeof(buffer), "%.*s", (int)value.length, value.pValue);
+        if (strtod(buffer, NULL) != item->valuedouble) {
+            FAIL("%s %s: scanner %s, cJSON %g", q->file, q->path, buffer, item->valuedouble);
+        }
+        if (APP_JSON_GetInt(q->doc, q->length, q->path, &number) && number != item->valueint) {
+            FAIL("%s %s: scanner int %d, cJSON %d", q->file, q->path, number, item->valueint);
+        }
+    }
+    if (found && (value.type == APP_JSON_TYPE_TRUE || value.type == APP_JSON_TYPE_FALSE
+            || value.type == APP_JSON_TYPE_NUMBER)) {
+        bool b;
+        if (!APP_JSON_GetBool(q->doc, q->length, q->path, &b)
+                || b != (value.type == APP_JSON_TYPE_NUMBER ? item->valueint != 0 : value.type == APP_JSON_TYPE_TRUE)) {
+            FAIL("%s %s: GetBool differs from cJSON", q->file, q->path);
+        }
+    }
+    OTA_cJSON_Delete(root);
+}
+
+/* Every query of the document, on a copy of exactly LENGTH bytes */
+static void findAll(const QUERY* q, const char* doc, size_t length)
+{
+    char* copy = malloc(length ? length : 1);
+    APP_JSON_VALUE value;
+    char buffer[256];
+    int i;
+
+    memcpy(copy, doc, length);
+    for (i = 0; i < nQueries; i++) {
+        if (strcmp(queries[i].file, q->file) == 0) {
+            APP_JSON_Find(copy, length, queries[i].path, &value);
+            APP_JSON_GetString(copy, length, queries[i].path, buffer, sizeof(buffer));
+        }
+    }
+    free(copy);
+}
+
+static void mangle(const QUERY* q)
+{
+    static const char special[] = "\"\\{}[],:.-0etfn \x1f";
+    char* doc = malloc(q->length);
+    size_t i, k;
+
+    for (i = 0; i <= q->length; i++) {
+        findAll(q, q->doc, i);
+    }
+    for (i = 0; i < q->length; i++) {
+        memcpy(doc, q->doc, q->length);
+        for (k = 0; k < sizeof(special); k++) {
+            doc[i] = special[k];
+            findAll(q, doc, q->length);
+        }
+    }
+    free(doc);
+}
+
+/* ---------------------------------------------------------------- benchmark */
+
+static double seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* What the firmware does with the value: the typed getter of its type */
+static bool scanQuery(const QUERY* q, APP_JSON_TYPE type)
+{
+    APP_JSON_VALUE value;
+    char buffer[128];
+    int32_t number;
+    bool b;
+
+    switch (type) {
+    case APP_JSON_TYPE_STRING:
+        return APP_JSON_GetString(q->doc, q->length, q->path, buffer, sizeof(buffer));
+    case APP_JSON_TYPE_NUMBER:
+        return APP_JSON_GetInt(q->doc, q->length, q->path, &number);
+    case APP_JSON_TYPE_TRUE:
+    case APP_JSON_TYPE_FALSE:
+        return APP_JSON_GetBool(q->doc, q->length, q->path, &b);
+    default:
+        return APP_JSON_Find(q->doc, q->length, q->path, &value);
+    }
+}
+
+static bool cjsonQuery(const QUERY* q)
+{
+    cJSON* root = OTA_cJSON_Parse(q->text);
+    cJSON* item = cjsonFind(root, q->path);
+    volatile int sink = item != NULL ? item->valueint : 0;
+
+    (void)sink;
+    OTA_cJSON_Delete(root);
+    return item != NULL;
+}
+
+static void benchmark(int iterations)
+{
+    int i, n;
+
+    printf("%-18s %-30s %5s  %10s  %10s  %6s  %11s  %9s\n", "document", "path", "bytes",
+           "scanner ns", "cJSON ns", "ratio", "allocations", "peak heap");
+    for (i = 0; i < nQueries; i++) {
+        const QUERY* q = &queries[i];
+        APP_JSON_VALUE value;
+        APP_JSON_TYPE type = APP_JSON_Find(q->doc, q->length, q->path, &value) ? value.type : APP_JSON_TYPE_INVALID;
+        double scan, cjson, t;
+        uint32_t count;
+        int found = 0;
+
+        t = seconds();
+        for (n = 0; n < iterations; n++) {
+            found += scanQuery(q, type);
+        }
+        scan = (seconds() - t) / iterations;
+
+        heap.peak = heap.live = 0;
+        count = heap.count;
+        cjsonQuery(q);
+        count = heap.count - count;
+        t = seconds();
+        for (n = 0; n < iterations; n++) {
+            found += cjsonQuery(q);
+        }
+        cjson = (seconds() - t) / iterations;
+
+        printf("%-18s %-30s %5zu  %10.0f  %10.0f  %5.1fx  %11u  %9zu\n", q->file, q->path, q->length,
+               scan * 1e9, cjson * 1e9, cjson / scan, count, heap.peak);
+        if (scan > cjson) {
+            FAIL("%s %s: the scanner is slower", q->file, q->path);
+        }
+        (void)found;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = argc > 2 ? atoi(argv[2]) : 0;
+    int i;
+
+    if (argc < 2) {
+        printf("usage: %s FIXTURES ITERATIONS\n", argv[0]);
+        return 2;
+    }
+    loadQueries(argv[1]);
+    for (i = 0; i < nQueries; i++) {
+        compare(&queries[i]);
+    }
+    if (iterations == 0) {
+        for (i = 0; i < nQueries; i++) {
+            if (i == 0 || strcmp(queries[i].file, queries[i - 1].file) != 0) {
+                mangle(&queries[i]);
+            }
+        }
+        printf("%d queries checked against cJSON; documents cut short and mangled\n", nQueries);
+    }
+    else {
+        benchmark(iterations);
+    }
+    printf("%d failure(s)\n", failures);
+    return failures != 0;
+}
@@ -0,0 +1,29 @@
+#!/bin/sh
+# Build the JSON scanner harness for the host, check app_json.c against cJSON
+# on the committed shadow documents under ASan/UBSan, then benchmark both.
+#
+# usage: run.sh [ITERATIONS]
+set -e
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+SRC=$HERE/../../src
+CJSON=$SRC/config/aws_sdk_wfi32_iot_freertos/system/ota/framework/cjson
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# The OTA copy of cJSON includes its header as "cJSON.h"
+cp "$CJSON/cjson.h" "$WORK/cJSON.h"
+
+build()
+{
+    ${CC:-cc} $1 -Wall -Wextra -I"$HERE/stub" -I"$WORK" -c "$CJSON/cjson.c" -o "$WORK/cjson.o"
+    ${CC:-cc} $1 -Wall -Wextra -Werror -I"$SRC" -c "$SRC/app_json.c" -o "$WORK/app_json.o"
+    ${CC:-cc} $1 -Wall -Wextra -Werror -I"$SRC" -I"$WORK" -c "$HERE/harness.c" -o "$WORK/harness.o"
+    ${CC:-cc} $1 "$WORK/harness.o" "$WORK/app_json.o" "$WORK/cjson.o" -lm -o "$2"
+}
+
+build "-g -O1 -fsanitize=address,undefined" "$WORK/check"
+build "-O2" "$WORK/bench"
+
+"$WORK/check" "$HERE/fixtures" 0
+"$WORK/bench" "$HERE/fixtures" "${1:-20000}"
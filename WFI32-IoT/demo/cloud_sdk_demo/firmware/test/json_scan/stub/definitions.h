@@ -0,0 +1,6 @@
+#pragma once
+/* Host build stand-in for the Harmony definitions used by the OTA cJSON copy:
+   its allocations go to the counting allocator of harness.c */
+#include <stddef.h>
+void* OSAL_Malloc(size_t size);
+void OSAL_Free(void* pData);
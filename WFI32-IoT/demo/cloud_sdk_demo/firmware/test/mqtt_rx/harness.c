@@ -0,0 +1,492 @@
+/*
+ * Host benchmark for the MQTT receive path: the fixed header decoder of the
+ * MQTT library reading through IotNetworkWolfSSL_Receive() and its
+ * per-connection buffer (ports/common/src/iot_network_wolfssl.c).
+ *
+ * usage: harness [SECONDS]
+ *
+ * run.sh extracts the receive functions of the port and the decoder
+ * (_IotMqtt_GetNextByte(), _IotMqtt_GetPacketType(),
+ * _IotMqtt_GetRemainingLength()) from the firmware sources. For comparison,
+ * receiveUnbuffered() below is the port's receive loop before the buffer.
+ *
+ * NET_PRES is a model of wolfSSL over TCP, in virtual time: a TLS record can
+ * be decrypted once all of it has arrived, and one NET_PRES_SocketRead()
+ * returns data of one record at most. It counts the NET_PRES calls, the
+ * signal waits and the 10 ms task delays.
+ *
+ * The stream, generated from a fixed seed over SECONDS (3600 by default) of
+ * a connected demo, has:
+ *  - a shadow delta PUBLISH every 1 to 3 s, 150 to 450 bytes of JSON;
+ *  - a PUBACK for the telemetry published every second; one in six shares
+ *    its TLS record with the packet after it;
+ *  - a PINGRESP every 30 s;
+ *  - a job notification PUBLISH of 1 to 2 kB every 5 minutes, and a 20 kB
+ *    job document, in two records, every 20 minutes.
+ * Records arrive at 500 kB/s.
+ *
+ * The receive thread starts on a packet when its first record is in. The
+ * harness then reads the packet as the MQTT library does and prints, per
+ * kind of packet, the NET_PRES reads it took and the time from its last
+ * record to its last byte read. It fails when a packet is decoded wrong, or
+ * when the buffered receive takes more reads or more time than before.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int failures;
+
+#define FAIL(...) do { \
+        printf("FAIL: " __VA_ARGS__); \
+        printf("\n"); \
+        failures++; \
+} while (0)
+
+/* ------------------------------------------------------------------ stream */
+
+#define MAX_PACKETS     16384
+#define MAX_RECORDS     16384
+#define STREAM_SIZE     (4 * 1024 * 1024)
+#define RECORD_MAX      16384
+#define LINK_RATE       500             /* bytes per ms */
+
+typedef enum
+{
+    KIND_DELTA,
+    KIND_PUBACK,
+    KIND_PINGRESP,
+    KIND_JOB,
+    KIND_JOB_DOCUMENT,
+    KIND_COUNT
+} KIND;
+
+static const char* kindName[KIND_COUNT] = {
+    "shadow delta", "PUBACK", "PINGRESP", "job notification", "job document"
+};
+
+typedef struct
+{
+    KIND        kind;
+    uint8_t     type;
+    uint32_t    remainingLength;
+    uint32_t    offset;                 /* of the payload in the stream */
+    uint32_t    firstRecord;
+    uint32_t    lastRecord;
+} PACKET;
+
+typedef struct
+{
+    uint32_t    offset;
+    uint32_t    length;
+    uint64_t    arrival;                /* in us, all of it */
+} RECORD;
+
+static uint8_t stream[STREAM_SIZE];
+static uint32_t streamLength;
+static PACKET packets[MAX_PACKETS];
+static uint32_t nPackets;
+static RECORD records[MAX_RECORDS];
+static uint32_t nRecords;
+static uint64_t seed = 0x2545F4914F6CDD1Dull;
+
+static uint32_t rnd(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return (uint32_t)(seed >> 16);
+}
+
+static uint32_t between(uint32_t lo, uint32_t hi)
+{
+    return lo + rnd() % (hi - lo + 1);
+}
+
+static void addPacket(KIND kind, uint8_t type, uint32_t remainingLength)
+{
+    PACKET* p = &packets[nPackets++];
+    uint32_t n = remainingLength;
+    uint32_t i;
+
+    p->kind = kind;
+    p->type = type;
+    p->remainingLength = remainingLength;
+    stream[streamLength++] = type;
+    do {
+        stream[streamLength++] = (uint8_t)((n & 0x7F) | (n > 0x7F ? 0x80 : 0));
+        n >>= 7;
+    } while (n != 0);
+    p->offset = streamLength;
+    for (i = 0; i < remainingLength; i++) {
+        stream[streamLength++] = (uint8_t)rnd();
+    }
+}
+
+/* Puts the bytes from the end of the last record up to END in records that
+   start arriving at START, and returns when the last one is in */
+static uint64_t addRecords(uint32_t end, uint64_t start)
+{
+    uint32_t offset = nRecords ? records[nRecords - 1].offset + records[nRecords - 1].length : 0;
+
+    while (offset < end) {
+        RECORD* r = &records[nRecords++];
+        r->offset = offset;
+        r->length = end - offset < RECORD_MAX ? end - offset : RECORD_MAX;
+        /* 29 bytes of TLS header, IV and tag */
+        start += (uint64_t)(r->length + 29) * 1000 / LINK_RATE;
+        r->arrival = start;
+        offset += r->length;
+    }
+    return start;
+}
+
+/* Sends packets from FIRST on at T */
+static void holdRecords(uint32_t first, uint64_t t)
+{
+    uint32_t firstRecord = nRecords;
+
+    addRecords(streamLength, t);
+    for (; first < nPackets; first++) {
+        packets[first].firstRecord = firstRecord;
+        packets[first].lastRecord = nRecords - 1;
+    }
+}
+
+static void generate(uint32_t seconds)
+{
+    uint64_t t, nextDelta = 1000000, nextAck = 1000000, nextPing = 30000000;
+    uint64_t nextJob = 300000000, nextDocument = 1200000000;
+    uint64_t end = (uint64_t)seconds * 1000000;
+    uint32_t held = MAX_PACKETS;        /* first packet held for a record */
+
+    while (nPackets < MAX_PACKETS - 1 && streamLength < STREAM_SIZE - 32768) {
+        KIND kind;
+        uint32_t first = nPackets;
+
+        t = nextDelta;
+        kind = KIND_DELTA;
+        if (nextAck < t) {
+            t = nextAck;
+            kind = KIND_PUBACK;
+        }
+        if (nextPing < t) {
+            t = nextPing;
+            kind = KIND_PINGRESP;
+        }
+        if (nextJob < t) {
+            t = nextJob;
+            kind = KIND_JOB;
+        }
+        if (nextDocument < t) {
+            t = nextDocument;
+            kind = KIND_JOB_DOCUMENT;
+        }
+        if (t > end) {
+            break;
+        }
+        switch (kind) {
+        case KIND_DELTA:
+            /* topic $aws/things/<name>/shadow/update/delta, packet id, JSON */
+            addPacket(kind, 0x32, 2 + 58 + 2 + between(150, 450));
+            nextDelta += between(1000, 3000) * 1000;
+            break;
+        case KIND_PUBACK:
+            addPacket(kind, 0x40, 2);
+            nextAck += 1000000;
+            break;
+        case KIND_PINGRESP:
+            addPacket(kind, 0xD0, 0);
+            nextPing += 30000000;
+            break;
+        case KIND_JOB:
+            addPacket(kind, 0x30, 2 + 48 + between(1000, 2000));
+            nextJob += 300000000;
+            break;
+        default:
+            addPacket(kind, 0x30, 2 + 56 + 20000);
+            nextDocument += 1200000000;
+            break;
+        }
+        if (held == MAX_PACKETS) {
+            held = first;
+        }
+        if (kind == KIND_PUBACK && rnd() % 6 == 0) {
+            /* Sent with the next packet, in one record */
+            continue;
+        }
+        holdRecords(held, t);
+        held = MAX_PACKETS;
+    }
+    if (held != MAX_PACKETS) {
+        holdRecords(held, t);
+    }
+}
+
+/* ------------------------------------------------------- NET_PRES and RTOS */
+
+typedef int16_t NET_PRES_SKT_HANDLE_T;
+typedef void* NET_PRES_SIGNAL_HANDLE;
+typedef void* TaskHandle_t;
+typedef void* SemaphoreHandle_t;
+typedef void (*IotNetworkReceiveCallback_t)(void*, void*);
+typedef void (*IotNetworkCloseCallback_t)(void*, int, void*);
+typedef struct _networkConnection* IotNetworkConnection_t;
+
+#define IotLogDebug(...)
+#define IotLogWarn(...)
+#define portTICK_PERIOD_MS          1
+#define pdMS_TO_TICKS(ms)           (ms)
+
+/* Virtual time in us */
+static uint64_t now;
+
+static struct
+{
+    uint32_t    reads;                  /* NET_PRES_SocketRead() */
+    uint32_t    readyChecks;            /* NET_PRES_SocketReadIsReady() */
+    uint32_t    waits;                  /* signal waits */
+    uint32_t    delays;                 /* task delays */
+} calls;
+
+/* wolfSSL: the record being read, and how much of it was read */
+static struct
+{
+    int32_t     record;
+    uint32_t    position;
+} tls;
+
+/* The plain text of the current record left to read, decrypting the next
+   record if the current one is done and the next one is all in */
+static uint32_t tlsPending(void)
+{
+    if (tls.record >= 0 && tls.position < records[tls.record].length) {
+        return records[tls.record].length - tls.position;
+    }
+    if ((uint32_t)(tls.record + 1) < nRecords && records[tls.record + 1].arrival <= now) {
+        tls.record++;
+        tls.position = 0;
+        return records[tls.record].length;
+    }
+    return 0;
+}
+
+static uint16_t NET_PRES_SocketReadIsReady(NET_PRES_SKT_HANDLE_T handle)
+{
+    uint32_t pending = tlsPending();
+
+    (void)handle;
+    calls.readyChecks++;
+    return pending > 0xFFFF ? 0xFFFF : (uint16_t)pending;
+}
+
+static uint16_t NET_PRES_SocketRead(NET_PRES_SKT_HANDLE_T handle, void* buffer, uint16_t size)
+{
+    uint32_t pending = tlsPending();
+    uint32_t n = size < pending ? size : pending;
+
+    (void)handle;
+    calls.reads++;
+    memcpy(buffer, &stream[records[tls.record].offset + tls.position], n);
+    tls.position += n;
+    return (uint16_t)n;
+}
+
+static bool NET_PRES_SocketWasReset(NET_PRES_SKT_HANDLE_T handle)
+{
+    (void)handle;
+    return false;
+}
+
+/* The stream ends with the last record: then the peer has gone */
+static bool NET_PRES_SocketIsConnected(NET_PRES_SKT_HANDLE_T handle)
+{
+    (void)handle;
+    return tls.record + 1 < (int32_t)nRecords || tlsPending() > 0;
+}
+
+/* Wakes when the next record is in, or at the timeout */
+static int xSemaphoreTake(SemaphoreHandle_t semaphore, uint32_t ticks)
+{
+    uint64_t timeout = now + (uint64_t)ticks * 1000;
+    uint32_t next = (uint32_t)(tls.record + 1);
+
+    (void)semaphore;
+    calls.waits++;
+    now = next < nRecords && records[next].arrival < timeout
+          ? (records[next].arrival > now ? records[next].arrival : now) : timeout;
+    return 1;
+}
+
+static void vTaskDelay(uint32_t ticks)
+{
+    calls.delays++;
+    now += (uint64_t)ticks * 1000;
+}
+
+#include "port.c"
+
+/* The receive loop of the port before the buffer */
+static size_t receiveUnbuffered(IotNetworkConnection_t pConnection, uint8_t* pBuffer, size_t bytesRequested)
+{
+    int recv_count = 0;
+    int bytesRead = 0;
+    int bytesRemaining = (int)bytesRequested;
+
+    while (bytesRemaining > 0) {
+        if ((!NET_PRES_SocketWasReset(pConnection->socket)) && (NET_PRES_SocketIsConnected(pConnection->socket))) {
+            recv_count = NET_PRES_SocketRead(pConnection->socket, pBuffer + bytesRead, bytesRemaining);
+            if (recv_count < bytesRemaining) {
+                vTaskDelay(10 / portTICK_PERIOD_MS);
+            }
+            bytesRead += recv_count;
+            bytesRemaining -= recv_count;
+        }
+        else {
+            break;
+        }
+    }
+    return bytesRead;
+}
+
+/* ----------------------------------------------------------------- decoder */
+
+typedef struct
+{
+    size_t (*receive)(void* pConnection, uint8_t* pBuffer, size_t bytesRequested);
+} IotNetworkInterface_t;
+
+#define IotMqtt_Assert(expression)  do { if (!(expression)) { FAIL("assert %s", #expression); } } while (0)
+#define EMPTY_ELSE_MARKER
+#define MQTT_MAX_REMAINING_LENGTH   (268435455UL)
+
+#include "decoder.c"
+
+static size_t receiveBuffered(void* pConnection, uint8_t* pBuffer, size_t bytesRequested)
+{
+    return IotNetworkWolfSSL_Receive(pConnection, pBuffer, bytesRequested);
+}
+
+static size_t receiveBefore(void* pConnection, uint8_t* pBuffer, size_t bytesRequested)
+{
+    return receiveUnbuffered(pConnection, pBuffer, bytesRequested);
+}
+
+/* ------------------------------------------------------------------- runs */
+
+typedef struct
+{
+    uint32_t    packets;
+    uint64_t    reads;
+    uint64_t    latencyUs;
+    uint64_t    maxLatencyUs;
+} KIND_STATS;
+
+typedef struct
+{
+    KIND_STATS  kind[KIND_COUNT];
+    uint64_t    reads;
+    uint64_t    readyChecks;
+    uint64_t    waits;
+    uint64_t    delays;
+    uint64_t    latencyUs;
+} RUN;
+
+static void run(const IotNetworkInterface_t* network, RUN* result)
+{
+    static uint8_t payload[32768];
+    static _networkConnection_t connection;
+    static int signal;
+    uint32_t i;
+
+    memset(result, 0, sizeof(*result));
+    memset(&connection, 0, sizeof(connection));
+    memset(&calls, 0, sizeof(calls));
+    connection.receiveSignal = &signal;
+    tls.record = -1;
+    tls.position = 0;
+    now = 0;
+
+    for (i = 0; i < nPackets; i++) {
+        const PACKET* p = &packets[i];
+        KIND_STATS* k = &result->kind[p->kind];
+        uint32_t reads = calls.reads;
+        uint64_t arrived = records[p->lastRecord].arrival;
+        uint8_t type;
+        size_t length;
+
+        /* The receive thread is woken by the first record, unless the
+           packet is in a record it has already read */
+        if (now < records[p->firstRecord].arrival && tls.record < (int32_t)p->firstRecord) {
+            now = records[p->firstRecord].arrival;
+        }
+        type = _IotMqtt_GetPacketType(&connection, network);
+        length = _IotMqtt_GetRemainingLength(&connection, network);
+        if (type != p->type || length != p->remainingLength) {
+            FAIL("packet %u: type %02X, length %zu; sent %02X, %u", i, type, length, p->type, p->remainingLength);
+            return;
+        }
+        if (network->receive(&connection, payload, length) != length
+                || memcmp(payload, &stream[p->offset], length) != 0) {
+            FAIL("packet %u: payload not received", i);
+            return;
+        }
+        k->packets++;
+        k->reads += calls.reads - reads;
+        if (now > arrived) {
+            k->latencyUs += now - arrived;
+            if (now - arrived > k->maxLatencyUs) {
+                k->maxLatencyUs = now - arrived;
+            }
+            result->latencyUs += now - arrived;
+        }
+    }
+    result->reads = calls.reads;
+    result->readyChecks = calls.readyChecks;
+    result->waits = calls.waits;
+    result->delays = calls.delays;
+}
+
+static void report(const char* name, const RUN* r)
+{
+    int k;
+
+    printf("%s: %llu NET_PRES reads, %llu ready checks, %llu signal waits, %llu task delays\n",
+           name, (unsigned long long)r->reads, (unsigned long long)r->readyChecks,
+           (unsigned long long)r->waits, (unsigned long long)r->delays);
+    for (k = 0; k < KIND_COUNT; k++) {
+        const KIND_STATS* s = &r->kind[k];
+        if (s->packets == 0) {
+            continue;
+        }
+        printf("  %-17s %5u packets: reads per packet %5.2f; latency avg %6.2f ms, max %6.2f ms\n",
+               kindName[k], s->packets, (double)s->reads / s->packets,
+               s->latencyUs / 1000.0 / s->packets, s->maxLatencyUs / 1000.0);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    static const IotNetworkInterface_t before = { receiveBefore };
+    static const IotNetworkInterface_t buffered = { receiveBuffered };
+    uint32_t seconds = argc > 1 ? (uint32_t)strtoul(argv[1], 0, 0) : 3600;
+    RUN a, b;
+
+    generate(seconds);
+    printf("%u packets, %u bytes in %u records over %u s; receive buffer %u bytes\n",
+           nPackets, streamLength, nRecords, seconds, IOT_NETWORK_RECEIVE_BUFFER_SIZE);
+    run(&before, &a);
+    report("before", &a);
+    run(&buffered, &b);
+    report("buffered", &b);
+    if (b.reads >= a.reads) {
+        FAIL("the buffered receive takes no fewer reads");
+    }
+    if (b.latencyUs > a.latencyUs) {
+        FAIL("the buffered receive takes longer");
+    }
+    printf("%d failure(s)\n", failures);
+    return failures != 0;
+}
@@ -0,0 +1,42 @@
+#!/bin/sh
+# Build the MQTT receive benchmark for the host and run it.
+#
+# usage: run.sh [SECONDS]
+set -e
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+AWS=$HERE/../../src/third_party/aws
+PORT=$AWS/ports/common/src/iot_network_wolfssl.c
+MQTT=$AWS/libraries/standard/mqtt/src
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# The receive path of the network port and the MQTT fixed header decoder, as
+# they are in the firmware
+{
+    sed -n '/^#ifndef IOT_NETWORK_RECEIVE_BUFFER_SIZE$/,/^#endif$/p' "$PORT"
+    sed -n '/^#ifndef IOT_NETWORK_RECEIVE_WAIT_MS$/,/^#endif$/p' "$PORT"
+    sed -n '/^typedef struct _networkConnection$/,/^} _networkConnection_t;$/p' "$PORT"
+    for fn in 'static size_t _receiveBufferedCount(' 'static size_t _receiveBufferFill(' \
+              'static void _receiveSignalWait(' 'size_t IotNetworkWolfSSL_Receive('; do
+        sed -n "/^$fn/,/^}/p" "$PORT"
+    done
+} > "$WORK/port.c"
+{
+    grep '^#define MQTT_REMAINING_LENGTH_INVALID ' "$MQTT/private/iot_mqtt_internal.h"
+    sed -n '/^static size_t _remainingLengthEncodedSize( size_t length )$/,/^}/p' "$MQTT/iot_mqtt_serialize.c"
+    sed -n '/^bool _IotMqtt_GetNextByte(/,/^}/p' "$MQTT/iot_mqtt_network.c"
+    sed -n '/^uint8_t _IotMqtt_GetPacketType(/,/^}/p' "$MQTT/iot_mqtt_serialize.c"
+    sed -n '/^size_t _IotMqtt_GetRemainingLength(/,/^}/p' "$MQTT/iot_mqtt_serialize.c"
+} > "$WORK/decoder.c"
+for fn in _receiveBufferFill _receiveSignalWait IotNetworkWolfSSL_Receive; do
+    grep -q "$fn" "$WORK/port.c" || { echo "$fn not found in iot_network_wolfssl.c"; exit 1; }
+done
+for fn in _remainingLengthEncodedSize _IotMqtt_GetNextByte _IotMqtt_GetRemainingLength; do
+    grep -q "$fn" "$WORK/decoder.c" || { echo "$fn not found in the MQTT sources"; exit 1; }
+done
+
+# The port compares its signed byte counts with size_t
+CFLAGS="-g -O1 -fsanitize=address,undefined -Wall -Wextra -Werror -Wno-sign-compare -I$WORK"
+${CC:-cc} $CFLAGS "$HERE/harness.c" -o "$WORK/harness"
+"$WORK/harness" "$@"
@@ -0,0 +1,20 @@
+/*
+ * The bootloader side of the OTA digest harness: the check of the downloaded
+ * image, cut out of bootloader_wolfcrypt.c by run.sh, built with the
+ * bootloader's SHA-256. It is a translation unit of its own because the
+ * bootloader and the OTA framework sha256.h share their include guard.
+ */
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ota_image.h"
+#include "sha256.h"
+#include "boot_config.h"
+
+#include "boot_check.c"
+
+bool boot_image_valid(void)
+{
+    return Bootloader_DownloadedImageValid();
+}
@@ -0,0 +1,285 @@
+/*
+ * Host harness for the OTA image digest: sys_ota hashes each sector of a file
+ * as it is queued for programming, OTA_UpdateBootctl() stores the size and
+ * digest in the boot control header, and the bootloader hashes the download
+ * slot once more before it jumps to the image.
+ *
+ * usage: harness [IMAGE_BYTES]
+ *
+ * The boot control sector and the download slot are mapped at their kseg1
+ * addresses. Hashing uses the OTA framework sha256.c, as sys_ota does, and
+ * the bootloader check is built with the bootloader sha256.c (boot.c). It
+ * fails when:
+ *  - the slot or the boot control layout of the bootloader does not match
+ *    the application configuration;
+ *  - the digest streamed sector by sector differs from the one of the slot;
+ *  - the bootloader refuses the image with the header the application
+ *    writes, or one without a digest;
+ *  - the bootloader accepts a slot with one bit flipped, a size one byte
+ *    short, or a size of 0 or bigger than the slot.
+ *
+ * It then measures, on this host, what hashing an image of IMAGE_BYTES
+ * (615633 by default) costs, sector by sector while it downloads and in one
+ * read-back pass of the slot afterwards, and models the OTA time of both:
+ *  - sectors arrive at the link rate; programming is queued behind the
+ *    download the same way in both, so it is left out;
+ *  - hashing while downloading takes the CPU between two sectors, and only
+ *    adds to the OTA time what the link leaves no time for;
+ *  - the read-back pass starts once the last sector is in.
+ * The model runs with the host hash times, and with them 50 times longer as
+ * a rough stand-in for the C SHA-256 on the 200 MHz PIC32MZ, which was not
+ * measured.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#include "ota_image.h"
+#include "sha256.h"
+#include "app_config.h"
+#include "boot_config.h"
+
+static int failures;
+
+#define FAIL(...) do { \
+        printf("FAIL: " __VA_ARGS__); \
+        printf("\n"); \
+        failures++; \
+} while (0)
+
+#define SECTOR          4096
+#define SLOWDOWN        50
+
+bool boot_image_valid(void);
+
+#define HEADER          ((FIRMWARE_IMAGE_HEADER *)(uintptr_t)APP_IMG_BOOT_CTL)
+#define SLOT            ((uint8_t *)(uintptr_t)APP_IMG_DOWNLOAD_ADDR)
+
+static void mapFlash(void)
+{
+    if (mmap(HEADER, SECTOR, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0) != HEADER ||
+        mmap(SLOT, APP_IMG_DOWNLOAD_SIZE, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0) != SLOT) {
+        perror("mmap");
+        exit(2);
+    }
+}
+
+static uint8_t* randomImage(uint32_t size)
+{
+    uint8_t* image = malloc(size);
+    uint32_t x = size;
+    uint32_t i;
+
+    if (image == NULL) {
+        perror("malloc");
+        exit(2);
+    }
+    for (i = 0; i < size; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        image[i] = (uint8_t)x;
+    }
+    return image;
+}
+
+/* As sys_ota: the size is set before the first sector, each sector is added
+   when it is queued for programming */
+static void streamHash(uint8_t* dst, const uint8_t* image, uint32_t size, uint8_t* digest)
+{
+    OTA_CRYPT_SHA256_CTX sha256;
+    uint32_t offset, len;
+
+    OTA_CRYPT_SHA256_Initialize(&sha256);
+    for (offset = 0; offset < size; offset += len) {
+        len = size - offset < SECTOR ? size - offset : SECTOR;
+        if (offset == 0) {
+            OTA_CRYPT_SHA256_DataSizeSet(&sha256, size);
+        }
+        OTA_CRYPT_SHA256_DataAdd(&sha256, image + offset, len);
+        if (dst != NULL) {
+            memcpy(dst + offset, image + offset, len);
+        }
+    }
+    OTA_CRYPT_SHA256_Finalize(&sha256, digest);
+}
+
+/* The pass this replaces: the slot read back a sector at a time */
+static void readBackHash(const uint8_t* slot, uint32_t size, uint8_t* digest)
+{
+    static uint8_t buf[SECTOR];
+    OTA_CRYPT_SHA256_CTX sha256;
+    uint32_t offset, len;
+
+    OTA_CRYPT_SHA256_Initialize(&sha256);
+    OTA_CRYPT_SHA256_DataSizeSet(&sha256, size);
+    for (offset = 0; offset < size; offset += len) {
+        len = size - offset < SECTOR ? size - offset : SECTOR;
+        memcpy(buf, slot + offset, len);
+        OTA_CRYPT_SHA256_DataAdd(&sha256, buf, len);
+    }
+    OTA_CRYPT_SHA256_Finalize(&sha256, digest);
+}
+
+/* The header as OTA_UpdateBootctl() writes it */
+static void writeHeader(uint32_t size, const uint8_t* digest)
+{
+    memset(HEADER, 0xFF, SECTOR);
+    HEADER->status = IMG_STATUS_DOWNLOADED;
+    HEADER->order = 0xFF;
+    HEADER->type = IMG_TYPE_PRODUCTION;
+    HEADER->boot_addr = 0xb0000200 + (uint32_t)SYS_OTA_JUMP_TO_ADDRESS;
+    if (digest != NULL) {
+        HEADER->sz = size;
+        memcpy(HEADER->digest, digest, sizeof(HEADER->digest));
+    }
+}
+
+static void expectBoot(const char* name, bool expected)
+{
+    if (boot_image_valid() != expected) {
+        FAIL("%s: the bootloader %s the image", name, expected ? "refused" : "accepted");
+    }
+}
+
+static void testBootCheck(void)
+{
+    /* The slot less a short last sector */
+    const uint32_t size = APP_IMG_DOWNLOAD_SIZE - 1000;
+    uint8_t* image = randomImage(size);
+    uint8_t streamed[32], readBack[32];
+
+    if (APP_IMG_DOWNLOAD_ADDR != 0xb0000000 + SYS_OTA_JUMP_TO_ADDRESS
+            || APP_IMG_DOWNLOAD_SIZE != SYS_OTA_SLOT_0_SIZE) {
+        FAIL("bootloader slot %#x, %u bytes; application slot %#x, %u bytes",
+             APP_IMG_DOWNLOAD_ADDR, APP_IMG_DOWNLOAD_SIZE,
+             0xb0000000 + SYS_OTA_JUMP_TO_ADDRESS, SYS_OTA_SLOT_0_SIZE);
+    }
+    memset(SLOT, 0xFF, APP_IMG_DOWNLOAD_SIZE);
+    streamHash(SLOT, image, size, streamed);
+    readBackHash(SLOT, size, readBack);
+    if (memcmp(streamed, readBack, sizeof(streamed)) != 0) {
+        FAIL("the streamed digest is not the digest of the slot");
+    }
+
+    writeHeader(size, streamed);
+    if (HEADER->boot_addr != 0xb0170200) {
+        FAIL("boot address %#x, the bootloader starts 0xb0170200", HEADER->boot_addr);
+    }
+    expectBoot("written by the application", true);
+
+    SLOT[size / 2] ^= 0x10;
+    expectBoot("one bit flipped", false);
+    SLOT[size / 2] ^= 0x10;
+
+    HEADER->sz = size - 1;
+    expectBoot("one byte short", false);
+    HEADER->sz = 0;
+    expectBoot("size 0", false);
+    HEADER->sz = APP_IMG_DOWNLOAD_SIZE + 1;
+    expectBoot("bigger than the slot", false);
+
+    writeHeader(size, NULL);
+    expectBoot("no digest, an older application", true);
+    free(image);
+}
+
+static double seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Both ways of hashing, their digests and the best of five times */
+static void measure(const uint8_t* image, uint32_t size, double* streamTime, double* readBackTime)
+{
+    uint8_t* slot = malloc(size);
+    uint8_t streamed[32], readBack[32];
+    double t;
+    int i;
+
+    if (slot == NULL) {
+        perror("malloc");
+        exit(2);
+    }
+    memcpy(slot, image, size);
+    *streamTime = *readBackTime = 1e9;
+    for (i = 0; i < 5; i++) {
+        t = seconds();
+        streamHash(NULL, image, size, streamed);
+        t = seconds() - t;
+        if (t < *streamTime) {
+            *streamTime = t;
+        }
+        t = seconds();
+        readBackHash(slot, size, readBack);
+        t = seconds() - t;
+        if (t < *readBackTime) {
+            *readBackTime = t;
+        }
+    }
+    if (memcmp(streamed, readBack, sizeof(streamed)) != 0) {
+        FAIL("benchmark: the digests differ");
+    }
+    free(slot);
+}
+
+/* OTA time in seconds, hashing while downloading or in a pass afterwards */
+static double otaTime(uint32_t size, double rate, double sectorHash, double readBack, bool stream)
+{
+    uint32_t sectors = (size + SECTOR - 1) / SECTOR;
+    double cpu = 0, arrived = 0;
+    uint32_t i;
+
+    for (i = 0; i < sectors; i++) {
+        arrived = (double)(i + 1 == sectors ? size : (i + 1) * SECTOR) / rate;
+        if (stream) {
+            cpu = (cpu > arrived ? cpu : arrived) + sectorHash;
+        }
+    }
+    return stream ? cpu : arrived + readBack;
+}
+
+static void benchmark(uint32_t size)
+{
+    static const double rates[] = { 100e3, 400e3, 1600e3 };
+    uint8_t* image = randomImage(size);
+    uint32_t sectors = (size + SECTOR - 1) / SECTOR;
+    double streamTime, readBackTime;
+    unsigned r, slow;
+
+    measure(image, size, &streamTime, &readBackTime);
+    printf("%u bytes on this host: hashed while downloading %.2f ms, read back and hashed %.2f ms\n",
+           size, streamTime * 1e3, readBackTime * 1e3);
+    for (slow = 1; slow <= SLOWDOWN; slow += SLOWDOWN - 1) {
+        printf("hash times x%-2u      link      with read-back  hashed while downloading  saved\n", slow);
+        for (r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+            double with = otaTime(size, rates[r], 0, readBackTime * slow, false);
+            double without = otaTime(size, rates[r], streamTime * slow / sectors, 0, true);
+            printf("                 %5.0f kB/s  %11.3f s  %21.3f s  %7.1f ms\n",
+                   rates[r] / 1e3, with, without, (with - without) * 1e3);
+            if (without > with) {
+                FAIL("%.0f kB/s: hashing while downloading is slower", rates[r] / 1e3);
+            }
+        }
+    }
+    free(image);
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t size = argc > 1 ? (uint32_t)strtoul(argv[1], 0, 0) : 615633;
+
+    mapFlash();
+    testBootCheck();
+    benchmark(size);
+    printf("%d failure(s)\n", failures);
+    return failures != 0;
+}
@@ -0,0 +1,31 @@
+#!/bin/sh
+# Build the OTA digest harness for the host and run it: the bootloader check
+# of the downloaded image, and the OTA time with and without a read-back pass.
+#
+# usage: run.sh [IMAGE_BYTES]
+set -e
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+CFG=$HERE/../../src/config/aws_sdk_wfi32_iot_freertos
+OTA=$CFG/system/ota/framework
+BOOT=$HERE/../../../../../../ota_bootloader/firmware/src/bootloader
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# The slot of the application and the boot control layout of the bootloader
+grep -E '^#define SYS_OTA_(JUMP_TO_ADDRESS|SLOT_0_SIZE) ' "$CFG/configuration.h" > "$WORK/app_config.h"
+sed '/^#ifdef SYS_OTA_BOOTLOAD_FROM_DEDICATED_BOOTFLASH_ENABLED/,/^#else/d' "$BOOT/ota_config.h" |
+    grep -E '^#define (APP_IMG_BOOT_CTL|APP_IMG_DOWNLOAD_(ADDR|SIZE)) ' > "$WORK/boot_config.h"
+sed -n '/^static bool Bootloader_DownloadedImageValid(void) {$/,/^}$/p' \
+    "$BOOT/bootloader_wolfcrypt.c" > "$WORK/boot_check.c"
+[ "$(wc -l < "$WORK/app_config.h")" -eq 2 ] || { echo "slot not found in configuration.h"; exit 1; }
+[ "$(wc -l < "$WORK/boot_config.h")" -eq 3 ] || { echo "boot control not found in ota_config.h"; exit 1; }
+[ -s "$WORK/boot_check.c" ] || { echo "image check not found in bootloader_wolfcrypt.c"; exit 1; }
+
+CFLAGS="-O2 -g -Wall -Wextra -Werror -I$HERE/stub -I$WORK"
+${CC:-cc} $CFLAGS -I"$BOOT" -c "$HERE/boot.c" -o "$WORK/boot.o"
+${CC:-cc} $CFLAGS -I"$BOOT" -c "$BOOT/sha256.c" -o "$WORK/boot_sha256.o"
+${CC:-cc} $CFLAGS -I"$OTA" -c "$OTA/sha256.c" -o "$WORK/ota_sha256.o"
+${CC:-cc} $CFLAGS -I"$OTA" -c "$HERE/harness.c" -o "$WORK/harness.o"
+${CC:-cc} "$WORK"/*.o -o "$WORK/harness"
+"$WORK/harness" "$@"
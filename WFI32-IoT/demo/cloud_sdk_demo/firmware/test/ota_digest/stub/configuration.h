@@ -0,0 +1,2 @@
+/* Host build stub: the bootloader sha256.h picks its backend from the
+   configuration, and without the wolfCrypt PIC32MZ settings it is the C one */
@@ -0,0 +1,423 @@
+/*
+ * Host harness for the compressed OTA container: the ota_lz.c decoder, the
+ * bootloader read path (Bootloader_ImageOpen/Bootloader_ImageRead of
+ * bootloader_wolfcrypt.c) and the download path (SYS_OTA_Download_Probe/
+ * SYS_OTA_Download_Decompress of sys_ota.c), on containers packed by
+ * tools/hex2bin/hex2bin.py.
+ *
+ * usage: harness check|bench RAW LZ [RAW LZ ...]
+ *
+ * With check it fails, for each pair, when:
+ *  - the header does not give the raw and packed lengths;
+ *  - decoding in pieces of 1 byte, of 1 kB in and 4 kB out, or of random
+ *    sizes (1 to 700 in, 1 to 5000 out) does not give RAW, or does not end
+ *    exactly at the end of the stream;
+ *  - the bootloader or the download path, reading 4 kB sectors, does not
+ *    give RAW padded with 0xFF;
+ *  - a window buffer one byte short or a window over OTA_LZ_WINDOW_BITS_MAX
+ *    is accepted;
+ *  - one of 500 containers with a random bit flipped, or one of 100 cut
+ *    short, is decoded to the full length with other bytes, or is said to
+ *    be complete when it is not. Faults are for AddressSanitizer to find:
+ *    buffers are allocated to their exact size.
+ *
+ * With bench it prints the packed size and the decode speed on this host,
+ * in the 1 kB in and 4 kB out pieces both paths use, best of five.
+ */
+#include <time.h>
+
+#include "definitions.h"
+#include "system/ota/framework/ota_config.h"
+#include "system/ota/framework/ota.h"
+#include "system/ota/framework/sha256.h"
+#include "system/ota/framework/ota_lz.h"
+#include "boot_config.h"
+
+static int failures;
+
+#define FAIL(...) do { \
+        printf("FAIL: " __VA_ARGS__); \
+        printf("\n"); \
+        failures++; \
+} while (0)
+
+static const uint8_t *file;
+static size_t fileLen, filePos;
+static uint32_t seed = 1;
+static unsigned flipped, flippedChanged;
+
+static uint32_t rnd(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+/* ---- the bootloader read path ---- */
+
+size_t SYS_FS_FileRead(SYS_FS_HANDLE handle, void *buf, size_t len)
+{
+    (void)handle;
+    if (len > fileLen - filePos) {
+        len = fileLen - filePos;
+    }
+    memcpy(buf, file + filePos, len);
+    filePos += len;
+    return len;
+}
+
+int32_t SYS_FS_FileSeek(SYS_FS_HANDLE handle, int32_t offset, SYS_FS_FILE_SEEK_CONTROL whence)
+{
+    (void)handle;
+    (void)whence;
+    filePos = (size_t)offset < fileLen ? (size_t)offset : fileLen;
+    return offset;
+}
+
+static struct {
+    SYS_FS_HANDLE fileHandle;
+} appFile;
+
+#include "boot_lz.c"
+
+/* ---- the download path ---- */
+
+#include "sys_ota_types.h"
+
+SYS_OTA_FILE_DATA g_SysFileData;
+
+/* What has arrived so far, in random amounts */
+int DOWNLOADER_Read(DRV_HANDLE handle, unsigned char *buffer, int maxsize)
+{
+    size_t n = rnd() % 1500;
+
+    (void)handle;
+    if (n > (size_t)maxsize) {
+        n = maxsize;
+    }
+    if (n > fileLen - filePos) {
+        n = fileLen - filePos;
+    }
+    memcpy(buffer, file + filePos, n);
+    filePos += n;
+    return (int)n;
+}
+
+#include "sys_ota_lz.c"
+
+/* ---- checks ---- */
+
+static uint8_t *load(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    uint8_t *p;
+    long n;
+
+    if (f == NULL || fseek(f, 0, SEEK_END) != 0 || (n = ftell(f)) < 0) {
+        perror(path);
+        exit(2);
+    }
+    /* One byte more, so an empty file has an address */
+    p = malloc(n + 1);
+    rewind(f);
+    if (p == NULL || fread(p, 1, n, f) != (size_t)n) {
+        perror(path);
+        exit(2);
+    }
+    fclose(f);
+    *len = n;
+    return p;
+}
+
+static uint32_t piece(uint32_t max, bool random)
+{
+    return random ? 1 + rnd() % max : max;
+}
+
+/* Decodes a stream in pieces of up to IN_MAX and OUT_MAX bytes into OUT, of
+   OUT_LEN bytes; returns the bytes produced, or -1 for a corrupt stream.
+   *CONSUMED receives the stream bytes used. */
+static int64_t decode(const OTA_LZ_HEADER *hdr, const uint8_t *in, uint32_t inLen, uint8_t *out, uint32_t outLen,
+                      uint32_t inMax, uint32_t outMax, bool random, uint32_t *consumed, bool *done)
+{
+    uint8_t *window = malloc(1u << hdr->window_bits);
+    OTA_LZ_CTX lz;
+    uint32_t inPos = 0, outPos = 0;
+    int64_t result;
+
+    if (window == NULL || !OTA_LZ_Init(&lz, hdr, window, 1u << hdr->window_bits)) {
+        free(window);
+        return -1;
+    }
+    for (;;) {
+        uint32_t n = piece(inMax, random);
+        uint32_t m = piece(outMax, random);
+        int32_t r;
+
+        n = n < inLen - inPos ? n : inLen - inPos;
+        m = m < outLen - outPos ? m : outLen - outPos;
+        r = OTA_LZ_Decompress(&lz, in + inPos, &n, out + outPos, m);
+        if (r < 0) {
+            result = -1;
+            break;
+        }
+        inPos += n;
+        outPos += r;
+        if (lz.out_len != outPos) {
+            FAIL("the context says %u bytes out, %u were", (unsigned)lz.out_len, (unsigned)outPos);
+        }
+        if (OTA_LZ_Done(&lz) || (n == 0 && r == 0 && (inPos == inLen || outPos == outLen))) {
+            result = outPos;
+            break;
+        }
+    }
+    *consumed = inPos;
+    *done = OTA_LZ_Done(&lz);
+    free(window);
+    return result;
+}
+
+/* The bootloader copy: 4 kB sectors from the image file */
+static void checkBoot(const char *name, const uint8_t *raw, size_t rawLen, const uint8_t *lz, size_t lzLen)
+{
+    uint8_t sector[FLASH_SECTOR_SIZE];
+    uint32_t size = 0, off, n;
+
+    file = lz;
+    fileLen = lzLen;
+    filePos = 0;
+    if (!Bootloader_ImageOpen(&size) || !image_lz.compressed || size != rawLen) {
+        FAIL("%s: the bootloader opens it as %u bytes", name, (unsigned)size);
+        return;
+    }
+    for (off = 0; off < size; off += FLASH_SECTOR_SIZE) {
+        n = size - off < FLASH_SECTOR_SIZE ? size - off : FLASH_SECTOR_SIZE;
+        if (!Bootloader_ImageRead(off, sector, FLASH_SECTOR_SIZE)) {
+            FAIL("%s: the bootloader fails at %u", name, (unsigned)off);
+            return;
+        }
+        if (memcmp(sector, raw + off, n) != 0) {
+            FAIL("%s: the bootloader reads other bytes at %u", name, (unsigned)off);
+            return;
+        }
+        for (; n < FLASH_SECTOR_SIZE; n++) {
+            if (sector[n] != 0xFF) {
+                FAIL("%s: the bootloader does not pad the last sector", name);
+                return;
+            }
+        }
+    }
+}
+
+/* The download: the header, then 4 kB sectors as the downloader delivers */
+static void checkDownload(const char *name, const uint8_t *raw, size_t rawLen, const uint8_t *lz, size_t lzLen)
+{
+    OTA_FILE_DOWNLOAD_TASK_CONTEXT cntx;
+    uint32_t copied, req, len, calls = 0;
+    int n;
+
+    memset(&cntx, 0, sizeof(cntx));
+    g_SysFileData.slot_number = 0;
+    g_SysFileData.slot_info.slot_size[0] = FACTORY_RESET_IMG_SIZE;
+    cntx.total_len = lzLen;
+    file = lz;
+    fileLen = lzLen;
+    filePos = OTA_LZ_HEADER_SIZE;
+    if (!SYS_OTA_Download_Probe(&cntx, lz) || cntx.lz == NULL) {
+        if (rawLen != 0) {
+            FAIL("%s: the download does not take it", name);
+        }
+        goto out;
+    }
+    if (cntx.image_len != rawLen) {
+        FAIL("%s: the download takes it as %u bytes", name, (unsigned)cntx.image_len);
+        goto out;
+    }
+    for (copied = 0; copied < rawLen; copied += req) {
+        req = rawLen - copied < FLASH_SECTOR_SIZE ? rawLen - copied : FLASH_SECTOR_SIZE;
+        for (len = 0; len < req; len += n) {
+            n = SYS_OTA_Download_Decompress(&cntx, 1, &cntx.buf[len], req - len);
+            if (n < 0 || ++calls > 10 * lzLen + 1000) {
+                FAIL("%s: the download fails at %u", name, (unsigned)(copied + len));
+                goto out;
+            }
+        }
+        if (memcmp(cntx.buf, raw + copied, req) != 0) {
+            FAIL("%s: the download gives other bytes at %u", name, (unsigned)copied);
+            goto out;
+        }
+    }
+    if (!OTA_LZ_Done(&cntx.lz->ctx)) {
+        FAIL("%s: the download is not done after %u bytes", name, (unsigned)rawLen);
+    }
+out:
+    free(cntx.buf);
+    free(cntx.lz);
+}
+
+static void checkDamaged(const char *name, const OTA_LZ_HEADER *hdr, const uint8_t *raw, const uint8_t *lz, uint32_t lzLen)
+{
+    uint8_t *out = malloc(hdr->raw_len + 1);
+    uint8_t *copy = malloc(lzLen);
+    uint32_t consumed, i, cut, bit;
+    int64_t n;
+    bool done;
+
+    for (i = 0; i < 500 && lzLen > 0; i++) {
+        memcpy(copy, lz, lzLen);
+        bit = rnd() % (lzLen * 8);
+        copy[bit / 8] ^= 1 << (bit % 8);
+        n = decode(hdr, copy, lzLen, out, hdr->raw_len, 700, 5000, true, &consumed, &done);
+        if (done && n != hdr->raw_len) {
+            FAIL("%s: bit %u flipped, done after %lld bytes", name, (unsigned)bit, (long long)n);
+        }
+        flipped++;
+        if (n == hdr->raw_len && memcmp(out, raw, hdr->raw_len) != 0) {
+            flippedChanged++;
+        }
+    }
+    for (i = 0; i < 100 && lzLen > 1; i++) {
+        cut = rnd() % lzLen;
+        n = decode(hdr, lz, cut, out, hdr->raw_len, 700, 5000, true, &consumed, &done);
+        if (done) {
+            FAIL("%s: cut to %u of %u bytes, said to be complete", name, (unsigned)cut, (unsigned)lzLen);
+        }
+        if (n > 0 && memcmp(out, raw, n) != 0) {
+            FAIL("%s: cut to %u bytes, the %lld bytes out are wrong", name, (unsigned)cut, (long long)n);
+        }
+    }
+    free(out);
+    free(copy);
+}
+
+static void check(const char *rawPath, const char *lzPath)
+{
+    static const struct { uint32_t in, out; bool random; } pieces[] = {
+        { 1, 1, false }, { 1024, 4096, false }, { 700, 5000, true }, { 700, 5000, true }
+    };
+    const char *name = strrchr(lzPath, '/') ? strrchr(lzPath, '/') + 1 : lzPath;
+    size_t rawLen, lzLen;
+    uint8_t *raw = load(rawPath, &rawLen);
+    uint8_t *lz = load(lzPath, &lzLen);
+    uint8_t *out = malloc(rawLen + 1);
+    uint8_t *window;
+    OTA_LZ_HEADER hdr, bad;
+    OTA_LZ_CTX ctx;
+    uint32_t consumed;
+    unsigned i;
+    bool done;
+
+    if (!OTA_LZ_HeaderParse(lz, lzLen, &hdr) || hdr.raw_len != rawLen
+            || hdr.packed_len != lzLen - OTA_LZ_HEADER_SIZE) {
+        FAIL("%s: bad header", name);
+        goto out;
+    }
+    for (i = 0; i < sizeof(pieces) / sizeof(pieces[0]); i++) {
+        int64_t n = decode(&hdr, lz + OTA_LZ_HEADER_SIZE, hdr.packed_len, out, rawLen,
+                           pieces[i].in, pieces[i].out, pieces[i].random, &consumed, &done);
+        if (n != (int64_t)rawLen || !done || consumed != hdr.packed_len || memcmp(out, raw, rawLen) != 0) {
+            FAIL("%s: in pieces of %u/%u%s: %lld bytes, %u of %u consumed, %s", name,
+                 pieces[i].in, pieces[i].out, pieces[i].random ? " at most" : "", (long long)n,
+                 (unsigned)consumed, (unsigned)hdr.packed_len, done ? "done" : "not done");
+        }
+    }
+    checkBoot(name, raw, rawLen, lz, lzLen);
+    checkDownload(name, raw, rawLen, lz, lzLen);
+
+    window = malloc(OTA_LZ_WINDOW_SIZE * 2);
+    if (OTA_LZ_Init(&ctx, &hdr, window, (1u << hdr.window_bits) - 1)) {
+        FAIL("%s: a window one byte short is accepted", name);
+    }
+    bad = hdr;
+    bad.window_bits = OTA_LZ_WINDOW_BITS_MAX + 1;
+    if (OTA_LZ_Init(&ctx, &bad, window, OTA_LZ_WINDOW_SIZE * 2)) {
+        FAIL("%s: a %u bit window is accepted", name, bad.window_bits);
+    }
+    free(window);
+
+    checkDamaged(name, &hdr, raw, lz + OTA_LZ_HEADER_SIZE, hdr.packed_len);
+out:
+    free(raw);
+    free(lz);
+    free(out);
+}
+
+/* ---- benchmark ---- */
+
+static double seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench(const char *rawPath, const char *lzPath)
+{
+    const char *name = strrchr(lzPath, '/') ? strrchr(lzPath, '/') + 1 : lzPath;
+    size_t rawLen, lzLen;
+    uint8_t *raw = load(rawPath, &rawLen);
+    uint8_t *lz = load(lzPath, &lzLen);
+    uint8_t sector[FLASH_SECTOR_SIZE], window[OTA_LZ_WINDOW_SIZE];
+    double best = 1e9, t;
+    OTA_LZ_HEADER hdr;
+    OTA_LZ_CTX ctx;
+    int i;
+
+    if (!OTA_LZ_HeaderParse(lz, lzLen, &hdr)) {
+        FAIL("%s: bad header", name);
+        return;
+    }
+    for (i = 0; i < 5; i++) {
+        uint32_t inPos = OTA_LZ_HEADER_SIZE, n;
+        int32_t r;
+
+        t = seconds();
+        OTA_LZ_Init(&ctx, &hdr, window, sizeof(window));
+        while (!OTA_LZ_Done(&ctx)) {
+            n = lzLen - inPos < 1024 ? lzLen - inPos : 1024;
+            r = OTA_LZ_Decompress(&ctx, lz + inPos, &n, sector, sizeof(sector));
+            if (r < 0 || (r == 0 && n == 0)) {
+                FAIL("%s: does not decode", name);
+                return;
+            }
+            inPos += n;
+        }
+        t = seconds() - t;
+        best = t < best ? t : best;
+    }
+    printf("%-24s %8zu %8zu %7.1f %% %9.0f\n", name, rawLen, lzLen,
+           rawLen ? 100.0 * lzLen / rawLen : 0.0, best > 0 ? rawLen / best / 1e6 : 0.0);
+    free(raw);
+    free(lz);
+}
+
+int main(int argc, char **argv)
+{
+    bool benchmark = argc > 1 && strcmp(argv[1], "bench") == 0;
+    int i;
+
+    if (argc < 4 || argc % 2 != 0) {
+        fprintf(stderr, "usage: harness check|bench RAW LZ [RAW LZ ...]\n");
+        return 2;
+    }
+    if (benchmark) {
+        printf("container                     raw   packed    ratio  decode MB/s\n");
+    }
+    for (i = 2; i < argc; i += 2) {
+        if (benchmark) {
+            bench(argv[i], argv[i + 1]);
+        }
+        else {
+            check(argv[i], argv[i + 1]);
+        }
+    }
+    /* Not failures: the container carries no checksum, the image digest is
+       what catches these */
+    if (flipped != 0) {
+        printf("%u of %u containers with a bit flipped decoded to a full image with other bytes\n",
+               flippedChanged, flipped);
+    }
+    printf("%d failure(s)\n", failures);
+    return failures != 0;
+}
@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+"""Pack the images for the OTA compression harness with the encoder of
+tools/hex2bin/hex2bin.py.
+
+usage: pack.py <repo root> <out dir>
+
+The images are the shipped binary/test_app.bin, the same padded with 0xFF
+to the 0xDF000 slot, the application of the prebuilt unified hex converted
+as hex2bin.py does, and a few generated ones: empty, one byte, a run of
+0xFF, random bytes and C source text. Each is packed with windows of 8, 10
+and 12 bits and unpacked again by hex2bin.py. Writes <name>.bin and
+<name>.w<bits>.lz, and prints the list "raw lz" for the harness on stdout
+and the encode times on stderr.
+"""
+import os
+import random
+import sys
+import time
+import types
+
+ROOT, OUT = sys.argv[1], sys.argv[2]
+DEMO = os.path.join(ROOT, 'WFI32-IoT', 'demo', 'cloud_sdk_demo')
+SLOT_START, SLOT_SIZE = 0x10020000, 0xDF000
+
+# hex2bin.py colours its messages; the harness does not need colorama
+try:
+    import colorama  # noqa: F401
+except ImportError:
+    plain = types.SimpleNamespace(GREEN='', RED='', YELLOW='')
+    sys.modules['colorama'] = types.SimpleNamespace(init=lambda **kw: None, Fore=plain)
+sys.path.insert(0, os.path.join(DEMO, 'tools', 'hex2bin'))
+import hex2bin  # noqa: E402
+
+
+def images():
+    with open(os.path.join(ROOT, 'binary', 'test_app.bin'), 'rb') as f:
+        app = f.read()
+    yield 'test_app', app
+    yield 'test_app_slot', app + b'\xff' * (SLOT_SIZE - len(app))
+
+    prebuilt = os.path.join(OUT, 'prebuilt_app.bin')
+    hex_file = os.path.join(ROOT, 'WFI32-IoT', 'prebuilt', 'aws_sdk_wfi32_iot_freertos.X.production.unified.hex')
+    stdout, sys.stdout = sys.stdout, sys.stderr
+    status = hex2bin.hex2bin(hex_file, prebuilt, SLOT_START + SLOT_SIZE, SLOT_START, 1)
+    sys.stdout = stdout
+    if status != 0:
+        sys.exit('hex2bin failed on ' + hex_file)
+    with open(prebuilt, 'rb') as f:
+        yield 'prebuilt_app', f.read()
+
+    r = random.Random(1)
+    yield 'empty', b''
+    yield 'one_byte', b'\x5a'
+    yield 'ff_run', b'\xff' * 65536
+    yield 'random', bytes(r.getrandbits(8) for _ in range(65536))
+    with open(os.path.join(DEMO, 'firmware', 'src', 'config', 'aws_sdk_wfi32_iot_freertos',
+                           'system', 'ota', 'sys_ota.c'), 'rb') as f:
+        yield 'text', f.read()
+
+
+def main():
+    os.makedirs(OUT, exist_ok=True)
+    for name, raw in images():
+        raw_path = os.path.join(OUT, name + '.bin')
+        with open(raw_path, 'wb') as f:
+            f.write(raw)
+        for bits in (8, 10, 12):
+            t = time.time()
+            packed = hex2bin.lz_compress(raw, bits)
+            t = time.time() - t
+            if hex2bin.lz_decompress(packed) != raw:
+                sys.exit('%s: hex2bin.py round trip failed with a %d bit window' % (name, bits))
+            lz_path = os.path.join(OUT, '%s.w%d.lz' % (name, bits))
+            with open(lz_path, 'wb') as f:
+                f.write(packed)
+            print(raw_path, lz_path)
+            sys.stderr.write('%-14s %2d bits  %7d -> %7d bytes  encoded in %.2f s\n'
+                             % (name, bits, len(raw), len(packed), t))
+
+
+main()
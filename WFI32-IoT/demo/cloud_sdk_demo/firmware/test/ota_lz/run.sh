@@ -0,0 +1,53 @@
+#!/bin/sh
+# Pack the shipped and some generated images with hex2bin.py, check that the
+# OTA decoder and both of its callers give them back, then report the packed
+# sizes and the decode speed.
+#
+# usage: run.sh
+set -e
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+ROOT=$(cd "$HERE/../../../../../.." && pwd)
+CFG=$HERE/../../src/config/aws_sdk_wfi32_iot_freertos
+OTA=$CFG/system/ota
+BOOT=$ROOT/ota_bootloader/firmware/src/bootloader
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# The bootloader builds the same decoder
+for f in ota_lz.c ota_lz.h; do
+    cmp -s "$OTA/framework/$f" "$BOOT/$f" || { echo "$f differs between the application and the bootloader"; exit 1; }
+done
+
+# The compressed image code, as it is in sys_ota and the bootloader
+sed -n '/^ *\/\* Structure for slot information\*\/$/,/^ *} SYS_OTA_FILE_DOWNLOAD_STATE;$/p' \
+    "$OTA/sys_ota.h" > "$WORK/sys_ota_types.h"
+sed -n '/^\/\* To switch to decompression if the file starts/,/^\/\* To compute the CRC-32 of the download cursor \*\/$/p' \
+    "$OTA/sys_ota.c" | sed '$d' > "$WORK/sys_ota_lz.c"
+sed -n '/^\/\* Compressed images (see ota_lz.h)/,/^typedef enum {$/p' \
+    "$BOOT/bootloader_wolfcrypt.c" | sed '$d' > "$WORK/boot_lz.c"
+sed -n '/^#define FACTORY_RESET_IMG_SIZE/p' "$BOOT/ota_config.h" > "$WORK/boot_config.h"
+[ -s "$WORK/sys_ota_types.h" ] || { echo "types not found in sys_ota.h"; exit 1; }
+[ -s "$WORK/sys_ota_lz.c" ] || { echo "decompression code not found in sys_ota.c"; exit 1; }
+[ -s "$WORK/boot_lz.c" ] || { echo "decompression code not found in bootloader_wolfcrypt.c"; exit 1; }
+[ -s "$WORK/boot_config.h" ] || { echo "FACTORY_RESET_IMG_SIZE not found in the bootloader ota_config.h"; exit 1; }
+
+python3 "$HERE/pack.py" "$ROOT" "$WORK/images" > "$WORK/list"
+
+# The firmware sources keep their warnings; the harness builds with -Werror
+INC="-I$HERE/stub -I$CFG -I$CFG/system -I$OTA/framework -I$WORK"
+CHECK="-g -fsanitize=address,undefined -Wall -Wextra $INC"
+BENCH="-O2 -Wall -Wextra $INC"
+mkdir "$WORK/check" "$WORK/bench"
+for src in ota_lz.c sha256.c; do
+    ${CC:-cc} $CHECK -c "$OTA/framework/$src" -o "$WORK/check/${src%.c}.o" 2>> "$WORK/warnings"
+    ${CC:-cc} $BENCH -c "$OTA/framework/$src" -o "$WORK/bench/${src%.c}.o" 2>> "$WORK/warnings"
+done
+${CC:-cc} $CHECK -Werror -Wno-sign-compare -Wno-unused-function -c "$HERE/harness.c" -o "$WORK/check/harness.o"
+${CC:-cc} $BENCH -Werror -Wno-sign-compare -Wno-unused-function -c "$HERE/harness.c" -o "$WORK/bench/harness.o"
+${CC:-cc} -fsanitize=address,undefined "$WORK/check"/*.o -o "$WORK/check/harness"
+${CC:-cc} "$WORK/bench"/*.o -o "$WORK/bench/harness"
+
+export ASAN_OPTIONS=detect_leaks=0
+"$WORK/check/harness" check $(cat "$WORK/list")
+"$WORK/bench/harness" bench $(cat "$WORK/list")
@@ -0,0 +1,29 @@
+#pragma once
+/* Host build stand-in for the Harmony definitions used by the compressed
+   image code of sys_ota.c and bootloader_wolfcrypt.c */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include "driver/driver_common.h"
+#include "system/ota/framework/downloader.h"
+
+typedef enum { SYS_STATUS_ERROR = -1, SYS_STATUS_UNINITIALIZED = 0, SYS_STATUS_BUSY = 1, SYS_STATUS_READY = 2 } SYS_STATUS;
+
+#define SYS_OTA_NUM_OF_SLOTS    2
+#define SYS_CONSOLE_PRINT(...)  ((void)0)
+#define TERM_RED    ""
+#define TERM_GREEN  ""
+#define TERM_YELLOW ""
+#define TERM_RESET  ""
+
+#define OSAL_Malloc malloc
+#define OSAL_Free   free
+
+typedef int SYS_FS_HANDLE;
+#define SYS_FS_HANDLE_INVALID   (-1)
+typedef enum { SYS_FS_SEEK_SET, SYS_FS_SEEK_CUR, SYS_FS_SEEK_END } SYS_FS_FILE_SEEK_CONTROL;
+size_t SYS_FS_FileRead(SYS_FS_HANDLE handle, void *buf, size_t len);
+int32_t SYS_FS_FileSeek(SYS_FS_HANDLE handle, int32_t offset, SYS_FS_FILE_SEEK_CONTROL whence);
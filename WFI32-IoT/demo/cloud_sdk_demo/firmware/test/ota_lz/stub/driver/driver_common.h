@@ -0,0 +1,4 @@
+#pragma once
+#include <stdint.h>
+typedef uintptr_t DRV_HANDLE;
+#define DRV_HANDLE_INVALID  ((DRV_HANDLE)(-1))
@@ -0,0 +1,511 @@
+/*
+ * Host simulation of the OTA file download against the time the flash takes:
+ * SYS_OTA_Download_File() and the int_flash.c job queue, as they are in the
+ * firmware, run in virtual time next to the serial download they replaced
+ * (e2213c2), which erased and programmed each sector with busy-waits.
+ *
+ * usage: harness [-e ERASE_MS] [-w ROW_MS] [-v]
+ *   -e ERASE_MS  page erase time, 20 ms by default
+ *   -w ROW_MS    row write time, 2 ms by default
+ *   -v           print what the download code prints
+ *
+ * The model:
+ *  - the OTA task runs one step of the download, then sleeps for
+ *    OTA_TASK_PERIOD_MS, as _SYS_OTA_Tasks() does; a busy-wait on the NVM
+ *    holds the task, so it adds to the period;
+ *  - the NVM runs one page erase or row write at a time, for the times
+ *    given; NVM_IsBusy() is true until it completes;
+ *  - the server sends at the link rate into a socket of
+ *    HTTP_TCP_RX_WINDOW_SIZE bytes and stops while it is full; each task
+ *    step moves what is in the socket into a DOWNLOADER_BUFFER_SIZE ring;
+ *  - the CPU time of the task itself, hashing included, is not counted.
+ * The erase and write times are assumptions, not measurements of the
+ * PIC32MZW1.
+ *
+ * For each link rate it prints the download time of both, the bound the
+ * link and the task period set, and the part of the flash busy time the
+ * queue takes off the download. It fails when:
+ *  - a row is programmed without its page being erased, an operation is
+ *    started while the NVM is busy, or one is outside the slot;
+ *  - the slot does not hold the image, or the digest or size is wrong;
+ *  - a released part of the download ring is programmed;
+ *  - the download is more than a task period slower than the serial one.
+ */
+#include <stdarg.h>
+#include <unistd.h>
+
+#include "definitions.h"
+#include "system/ota/framework/ota_config.h"
+#include "system/ota/framework/ota.h"
+#include "system/ota/framework/sha256.h"
+#include "system/ota/framework/ota_lz.h"
+#include "model.h"
+
+static int failures;
+
+#define FAIL(...) do { \
+        printf("FAIL: " __VA_ARGS__); \
+        printf("\n"); \
+        failures++; \
+} while (0)
+
+#define SLOT_ADDRESS    0x00100000u
+#define SLOT_SIZE       (1024u * 1024u)
+#define IMAGE_SIZE      615633u
+#define RTT_US          40000u
+
+/* ---- what sys_ota.c has around the download code ---- */
+
+#include "sys_ota_types.h"
+
+size_t field_content_length;
+SYS_OTA_FILE_DATA g_SysFileData;
+static uint8_t g_formulated_digest[32];
+static SYS_OTA_FILE_DOWNLOAD_STATUS File_Dnld_Status = SYS_OTA_DOWNLOAD_FILE;
+static bool verbose;
+
+static inline bool SYS_OTA_ConnectedToNtwrk(void)
+{
+    return true;
+}
+
+void SYS_CONSOLE_Print(const char *format, ...)
+{
+    va_list ap;
+
+    if (verbose) {
+        va_start(ap, format);
+        vprintf(format, ap);
+        va_end(ap);
+    }
+}
+
+/* No file system: the download cursor is not kept */
+SYS_FS_HANDLE SYS_FS_FileOpen(const char *name, SYS_FS_FILE_OPEN_ATTRIBUTES attr)
+{
+    (void)name;
+    (void)attr;
+    return SYS_FS_HANDLE_INVALID;
+}
+
+size_t SYS_FS_FileRead(SYS_FS_HANDLE h, void *buf, size_t len)
+{
+    (void)h;
+    (void)buf;
+    (void)len;
+    return 0;
+}
+
+size_t SYS_FS_FileWrite(SYS_FS_HANDLE h, const void *buf, size_t len)
+{
+    (void)h;
+    (void)buf;
+    (void)len;
+    return 0;
+}
+
+int SYS_FS_FileClose(SYS_FS_HANDLE h)
+{
+    (void)h;
+    return 0;
+}
+
+int SYS_FS_FileRemove(const char *name)
+{
+    (void)name;
+    return 0;
+}
+
+#include "sys_ota_download.c"
+
+/* ---- NVM in virtual time ---- */
+
+static uint64_t now;                    /* microseconds */
+static uint64_t busyUntil;
+static uint32_t eraseUs = 20000, rowUs = 2000;
+static uint64_t flashUs, blockedUs;
+static uint8_t flash[SLOT_SIZE];
+
+/* The slot offset of an NVM address, or -1 */
+static int64_t slotOffset(uint32_t address, uint32_t len)
+{
+    uint32_t start = NVM_FLASH_START_ADDRESS + SLOT_ADDRESS;
+
+    if (address < start || address - start > SLOT_SIZE - len) {
+        FAIL("NVM access outside the slot: 0x%08X + %u", (unsigned)address, (unsigned)len);
+        return -1;
+    }
+    return address - start;
+}
+
+static bool nvmStart(const char *what, uint32_t address, uint32_t align, uint32_t us)
+{
+    if (now < busyUntil) {
+        FAIL("%s of 0x%08X started while the NVM is busy", what, (unsigned)address);
+        return false;
+    }
+    if (address % align != 0) {
+        FAIL("%s of 0x%08X is not aligned", what, (unsigned)address);
+        return false;
+    }
+    busyUntil = now + us;
+    flashUs += us;
+    return true;
+}
+
+void NVM_Initialize(void)
+{
+}
+
+bool NVM_IsBusy(void)
+{
+    /* A poll takes a microsecond of the caller's time */
+    if (now < busyUntil) {
+        now++;
+        blockedUs++;
+        return true;
+    }
+    return false;
+}
+
+bool NVM_PageErase(uint32_t address)
+{
+    int64_t offset = slotOffset(address, NVM_FLASH_PAGESIZE);
+
+    if (offset < 0 || !nvmStart("page erase", address, NVM_FLASH_PAGESIZE, eraseUs)) {
+        return false;
+    }
+    memset(&flash[offset], 0xFF, NVM_FLASH_PAGESIZE);
+    return true;
+}
+
+bool NVM_RowWrite(uint32_t *data, uint32_t address)
+{
+    int64_t offset = slotOffset(address, NVM_FLASH_ROWSIZE);
+    uint32_t i;
+
+    if (offset < 0 || !nvmStart("row write", address, NVM_FLASH_ROWSIZE, rowUs)) {
+        return false;
+    }
+    for (i = 0; i < NVM_FLASH_ROWSIZE; i++) {
+        if (flash[offset + i] != 0xFF) {
+            FAIL("row 0x%08X programmed without being erased", (unsigned)address);
+            return false;
+        }
+    }
+    memcpy(&flash[offset], data, NVM_FLASH_ROWSIZE);
+    return true;
+}
+
+bool NVM_Read(uint32_t *data, uint32_t length, const uint32_t address)
+{
+    int64_t offset = slotOffset(address, length);
+
+    if (offset < 0) {
+        return false;
+    }
+    memcpy(data, &flash[offset], length);
+    return true;
+}
+
+/* ---- link, socket and downloader ring ---- */
+
+static const uint8_t *image;
+static uint32_t linkRate;               /* bytes a second */
+static uint8_t ring[DOWNLOADER_BUFFER_SIZE];
+static uint32_t ringIn, ringOut;        /* file offsets */
+static uint32_t sent, socketLen;
+static uint64_t linkFrom;
+static double linkCredit;
+static bool linkOpen;
+
+/* What the server has sent into the socket by now */
+static void linkAdvance(void)
+{
+    uint32_t n;
+
+    if (!linkOpen || now <= linkFrom) {
+        return;
+    }
+    linkCredit += (double)(now - linkFrom) * linkRate / 1e6;
+    linkFrom = now;
+    n = (uint32_t)linkCredit;
+    if (n > HTTP_TCP_RX_WINDOW_SIZE - socketLen) {
+        n = HTTP_TCP_RX_WINDOW_SIZE - socketLen;
+    }
+    if (n > IMAGE_SIZE - sent) {
+        n = IMAGE_SIZE - sent;
+    }
+    sent += n;
+    socketLen += n;
+    /* The server does not send ahead of a full window */
+    linkCredit = (n == (uint32_t)linkCredit) ? linkCredit - n : 0;
+}
+
+/* DOWNLOADER_Tasks(), from OTA_Tasks() after the download step */
+static void downloaderTasks(void)
+{
+    uint32_t n, i;
+
+    linkAdvance();
+    n = DOWNLOADER_BUFFER_SIZE - (ringIn - ringOut);
+    if (n > socketLen) {
+        n = socketLen;
+    }
+    for (i = 0; i < n; i++) {
+        ring[(ringIn + i) % DOWNLOADER_BUFFER_SIZE] = image[ringIn + i];
+    }
+    ringIn += n;
+    socketLen -= n;
+    if (n != 0) {
+        field_content_length = IMAGE_SIZE;
+    }
+}
+
+DRV_HANDLE DOWNLOADER_OpenRange(void *param, uint32_t offset)
+{
+    (void)param;
+    ringIn = ringOut = sent = offset;
+    socketLen = 0;
+    linkCredit = 0;
+    /* Connection, TLS and request */
+    linkFrom = now + 3 * RTT_US;
+    linkOpen = true;
+    return 1;
+}
+
+DRV_HANDLE DOWNLOADER_Open(void *param)
+{
+    return DOWNLOADER_OpenRange(param, 0);
+}
+
+int DOWNLOADER_Peek(DRV_HANDLE handle, int offset, int size, unsigned char **buffer)
+{
+    uint32_t start = (ringOut + offset) % DOWNLOADER_BUFFER_SIZE;
+
+    (void)handle;
+    if (start + size > DOWNLOADER_BUFFER_SIZE) {
+        FAIL("peek of %d bytes at %u crosses the end of the ring", size, (unsigned)(ringOut + offset));
+        return -1;
+    }
+    if (ringIn - ringOut < (uint32_t)(offset + size)) {
+        return 0;
+    }
+    *buffer = &ring[start];
+    return size;
+}
+
+void DOWNLOADER_Release(DRV_HANDLE handle, int size)
+{
+    uint32_t i;
+
+    (void)handle;
+    if ((uint32_t)size > ringIn - ringOut) {
+        FAIL("%d bytes released, %u buffered", size, (unsigned)(ringIn - ringOut));
+        size = ringIn - ringOut;
+    }
+    /* Released memory no longer holds the image */
+    for (i = 0; i < (uint32_t)size; i++) {
+        ring[(ringOut + i) % DOWNLOADER_BUFFER_SIZE] = (uint8_t)~image[ringOut + i];
+    }
+    ringOut += size;
+}
+
+int DOWNLOADER_Read(DRV_HANDLE handle, unsigned char *buffer, int maxsize)
+{
+    uint32_t n = ringIn - ringOut;
+    uint32_t i;
+
+    if (n > (uint32_t)maxsize) {
+        n = maxsize;
+    }
+    for (i = 0; i < n; i++) {
+        buffer[i] = ring[(ringOut + i) % DOWNLOADER_BUFFER_SIZE];
+    }
+    DOWNLOADER_Release(handle, n);
+    return n;
+}
+
+void DOWNLOADER_Close(DRV_HANDLE handle)
+{
+    (void)handle;
+    linkOpen = false;
+}
+
+/* ---- the serial download of e2213c2 ---- */
+
+/* One step of it; true once the file is programmed */
+static bool serialDownload(void)
+{
+    static uint8_t buf[FLASH_SECTOR_SIZE];
+    static uint32_t copied, bufLen, addr;
+    static bool writing;
+    static DRV_HANDLE downloader = DRV_HANDLE_INVALID;
+    uint32_t req;
+
+    if (downloader == DRV_HANDLE_INVALID) {
+        downloader = DOWNLOADER_Open(NULL);
+        copied = bufLen = 0;
+        addr = SLOT_ADDRESS;
+        writing = false;
+        return false;
+    }
+    if (!writing) {
+        req = IMAGE_SIZE - copied < FLASH_SECTOR_SIZE ? IMAGE_SIZE - copied : FLASH_SECTOR_SIZE;
+        bufLen += DOWNLOADER_Read(downloader, &buf[bufLen], req - bufLen);
+        writing = (bufLen == req);
+        return false;
+    }
+    while (NVM_IsBusy()) ;
+    if (!INT_Flash_Erase(addr, FLASH_SECTOR_SIZE) || !INT_Flash_Write(addr, buf, FLASH_SECTOR_SIZE)) {
+        FAIL("serial: NVM write error");
+    }
+    copied += bufLen;
+    bufLen = 0;
+    addr += FLASH_SECTOR_SIZE;
+    writing = false;
+    if (copied < IMAGE_SIZE) {
+        return false;
+    }
+    DOWNLOADER_Close(downloader);
+    downloader = DRV_HANDLE_INVALID;
+    return true;
+}
+
+/* ---- runs ---- */
+
+static bool queuedDownload(void)
+{
+    SYS_OTA_Download_File(g_SysFileData.file_url);
+    return g_SysFileData.file_index != 0 || g_SysFileData.error;
+}
+
+/* Runs a download to the end, in seconds */
+static double run(const char *name, bool (*step)(void))
+{
+    uint64_t start;
+    bool done;
+
+    memset(flash, 0, sizeof(flash));
+    now = busyUntil = 0;
+    flashUs = blockedUs = 0;
+    start = now;
+    do {
+        done = step();
+        downloaderTasks();
+        if (!done) {
+            now += OTA_TASK_PERIOD_MS * 1000;
+        }
+    } while (!done && now - start < 3600000000u);
+
+    if (!done) {
+        FAIL("%s: not done after an hour", name);
+    }
+    while (NVM_IsBusy()) ;
+    if (memcmp(flash, image, IMAGE_SIZE) != 0) {
+        FAIL("%s: the slot does not hold the image", name);
+    }
+    return (now - start) / 1e6;
+}
+
+static double runQueued(void)
+{
+    double t;
+
+    memset(&g_SysFileData, 0, sizeof(g_SysFileData));
+    g_SysFileData.slot_info.slot_address[0] = SLOT_ADDRESS;
+    g_SysFileData.slot_info.slot_size[0] = SLOT_SIZE;
+    g_SysFileData.slot_info.file_size_in_slot[0] = IMAGE_SIZE;
+    strcpy(g_SysFileData.file_url, "https://example.com/image.bin");
+    strcpy(g_SysFileData.file_digest_string, "set");
+    File_Dnld_Status = SYS_OTA_DOWNLOAD_FILE;
+
+    t = run("queued", queuedDownload);
+    if (g_SysFileData.error || File_Dnld_Status != SYS_OTA_PARSE_JSON) {
+        FAIL("queued: the download failed");
+    }
+    else if (g_SysFileData.slot_info.file_size_in_slot[0] != IMAGE_SIZE) {
+        FAIL("queued: %u bytes in the slot", (unsigned)g_SysFileData.slot_info.file_size_in_slot[0]);
+    }
+    return t;
+}
+
+static uint8_t *randomImage(void)
+{
+    uint8_t *p = malloc(IMAGE_SIZE);
+    uint32_t x = IMAGE_SIZE;
+    uint32_t i;
+
+    if (p == NULL) {
+        perror("malloc");
+        exit(2);
+    }
+    for (i = 0; i < IMAGE_SIZE; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        p[i] = (uint8_t)x;
+    }
+    return p;
+}
+
+int main(int argc, char **argv)
+{
+    static const uint32_t rates[] = { 25000, 100000, 400000, 1600000 };
+    uint32_t sectors = (IMAGE_SIZE + FLASH_SECTOR_SIZE - 1) / FLASH_SECTOR_SIZE;
+    OTA_CRYPT_SHA256_CTX sha256;
+    double serial, queued, bound, flashTotal, serialBlocked;
+    unsigned i;
+    int c;
+
+    while ((c = getopt(argc, argv, "e:w:v")) != -1) {
+        switch (c) {
+        case 'e':
+            eraseUs = (uint32_t)(atof(optarg) * 1000);
+            break;
+        case 'w':
+            rowUs = (uint32_t)(atof(optarg) * 1000);
+            break;
+        case 'v':
+            verbose = true;
+            break;
+        default:
+            return 2;
+        }
+    }
+    image = randomImage();
+    OTA_CRYPT_SHA256_Initialize(&sha256);
+    OTA_CRYPT_SHA256_DataSizeSet(&sha256, IMAGE_SIZE);
+    OTA_CRYPT_SHA256_DataAdd(&sha256, image, IMAGE_SIZE);
+    OTA_CRYPT_SHA256_Finalize(&sha256, g_formulated_digest);
+    INT_Flash_Initialize();
+
+    flashTotal = sectors * (eraseUs + (double)rowUs * FLASH_SECTOR_SIZE / NVM_FLASH_ROWSIZE) / 1e6;
+    printf("%u sector buffer(s), %u erased ahead, %u byte ring; page erase %.1f ms, row write %.1f ms\n",
+           SYS_OTA_FILE_DOWNLOAD_BUFFERS, SYS_OTA_FILE_ERASE_AHEAD, DOWNLOADER_BUFFER_SIZE,
+           eraseUs / 1e3, rowUs / 1e3);
+    printf("%u byte image, %u sectors, %.2f s of flash operations, OTA task period %u ms\n",
+           IMAGE_SIZE, sectors, flashTotal, OTA_TASK_PERIOD_MS);
+    printf("      link     serial  blocked     queued  blocked      bound   flash time hidden\n");
+    for (i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        linkRate = rates[i];
+        serial = run("serial", serialDownload);
+        serialBlocked = blockedUs / 1e6;
+        queued = runQueued();
+        if (memcmp(g_SysFileData.slot_info.file_digest_in_slot[0], g_formulated_digest, 32) != 0) {
+            FAIL("queued: wrong digest");
+        }
+        /* Two task steps a sector, and the link */
+        bound = 3 * RTT_US / 1e6 + (double)IMAGE_SIZE / linkRate;
+        if (bound < sectors * 2 * OTA_TASK_PERIOD_MS / 1e3) {
+            bound = sectors * 2 * OTA_TASK_PERIOD_MS / 1e3;
+        }
+        printf("%5u kB/s %8.2f s %6.2f s %8.2f s %6.2f s %8.2f s %18.0f %%\n", linkRate / 1000,
+               serial, serialBlocked, queued, blockedUs / 1e6, bound, (serial - queued) / flashTotal * 100);
+        if (queued > serial + OTA_TASK_PERIOD_MS / 1e3) {
+            FAIL("%u kB/s: the queued download is slower than the serial one", linkRate / 1000);
+        }
+    }
+    printf("%d failure(s)\n", failures);
+    return failures != 0;
+}
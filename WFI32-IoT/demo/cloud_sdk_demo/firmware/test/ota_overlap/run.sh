@@ -0,0 +1,56 @@
+#!/bin/sh
+# Build the OTA download overlap simulation for the host and run it with one
+# sector buffer and no erase ahead, with the defaults, and with three
+# buffers; the defaults also with slower flash.
+#
+# usage: run.sh
+set -e
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+CFG=$HERE/../../src/config/aws_sdk_wfi32_iot_freertos
+OTA=$CFG/system/ota
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# The slot and cursor types and the file download code, as they are in sys_ota
+sed -n '/^ *\/\* Structure for slot information\*\/$/,/^ *} SYS_OTA_FILE_DOWNLOAD_STATE;$/p' \
+    "$OTA/sys_ota.h" > "$WORK/sys_ota_types.h"
+sed -n '/^\/\* To Read from NVM \*\/$/,/^ *void SYS_OTA_Print_Server_Data/p' \
+    "$OTA/sys_ota.c" | sed '$d' > "$WORK/sys_ota_download.c"
+[ -s "$WORK/sys_ota_types.h" ] || { echo "types not found in sys_ota.h"; exit 1; }
+[ -s "$WORK/sys_ota_download.c" ] || { echo "download code not found in sys_ota.c"; exit 1; }
+
+# The OTA task period and the socket receive window of the firmware
+period=$(sed -n '/^ *SYS_OTA_Tasks();$/{n;s/^ *vTaskDelay(\([0-9]*\) *\/ *portTICK_PERIOD_MS);$/\1/p}' "$CFG/tasks.c")
+window=$(sed -n 's/^#define HTTP_TCP_RX_WINDOW_SIZE *\([0-9]*\)$/\1/p' "$OTA/framework/http_client/http_client.c")
+[ -n "$period" ] || { echo "OTA task period not found in tasks.c"; exit 1; }
+[ -n "$window" ] || { echo "HTTP_TCP_RX_WINDOW_SIZE not found in http_client.c"; exit 1; }
+printf '#define OTA_TASK_PERIOD_MS %s\n#define HTTP_TCP_RX_WINDOW_SIZE %s\n' "$period" "$window" > "$WORK/model.h"
+
+# build NAME [-D...]: the firmware sources keep their warnings; the harness
+# builds with -Werror
+build() {
+    name=$1
+    shift
+    flags="-g -O1 -fsanitize=address,undefined -Wall -Wextra -I$HERE/stub -I$CFG -I$CFG/system -I$OTA/framework -I$WORK $*"
+    mkdir -p "$WORK/$name"
+    for src in int_flash.c ota_lz.c sha256.c; do
+        ${CC:-cc} $flags -Wno-attributes -c "$OTA/framework/$src" -o "$WORK/$name/$(basename "$src" .c).o" 2>> "$WORK/warnings"
+    done
+    ${CC:-cc} $flags -Werror -Wno-sign-compare -Wno-unused-function -c "$HERE/harness.c" -o "$WORK/$name/harness.o"
+    ${CC:-cc} -fsanitize=address,undefined "$WORK/$name"/*.o -o "$WORK/$name/harness"
+}
+
+build single -DSYS_OTA_FILE_DOWNLOAD_BUFFERS=1 -DSYS_OTA_FILE_ERASE_AHEAD=0
+build default
+build triple -DSYS_OTA_FILE_DOWNLOAD_BUFFERS=3 -DSYS_OTA_FILE_ERASE_AHEAD=2 -DDOWNLOADER_BUFFER_SIZE=32768
+
+fail=0
+for run in "single" "default" "triple" "default -e 40 -w 8"; do
+    set -- $run
+    name=$1
+    shift
+    echo "== $name $*"
+    "$WORK/$name/harness" "$@" || fail=1
+done
+exit $fail
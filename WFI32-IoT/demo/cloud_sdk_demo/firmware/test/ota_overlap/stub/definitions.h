@@ -0,0 +1,52 @@
+#pragma once
+/* Host build stand-in for the Harmony definitions used by int_flash.c and
+   the download code of sys_ota.c */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include "driver/driver_common.h"
+#include "system/ota/framework/downloader.h"
+#include "system/ota/framework/int_flash.h"
+
+typedef enum { SYS_STATUS_ERROR = -1, SYS_STATUS_UNINITIALIZED = 0, SYS_STATUS_BUSY = 1, SYS_STATUS_READY = 2 } SYS_STATUS;
+
+#define SYS_OTA_ENFORCE_TLS     false
+#define SYS_OTA_NUM_OF_SLOTS    2
+#define SYS_CONSOLE_PRINT(...)  SYS_CONSOLE_Print(__VA_ARGS__)
+#define TERM_RED    ""
+#define TERM_GREEN  ""
+#define TERM_YELLOW ""
+#define TERM_RESET  ""
+void SYS_CONSOLE_Print(const char *format, ...);
+
+#define OSAL_Malloc malloc
+#define OSAL_Free   free
+typedef enum { OSAL_RESULT_FALSE = 0, OSAL_RESULT_TRUE = 1 } OSAL_RESULT;
+typedef int OSAL_MUTEX_HANDLE_TYPE;
+#define OSAL_WAIT_FOREVER       ((uint16_t)0xFFFF)
+#define OSAL_MUTEX_Create(m)    (*(m) = 0, OSAL_RESULT_TRUE)
+#define OSAL_MUTEX_Lock(m, w)   (*(m) = 1, OSAL_RESULT_TRUE)
+#define OSAL_MUTEX_Unlock(m)    (*(m) = 0, OSAL_RESULT_TRUE)
+
+/* The NVM of the PIC32MZW1; harness.c simulates it */
+#define NVM_FLASH_START_ADDRESS (0x90000000U)
+#define NVM_FLASH_SIZE          (0x100000U)
+#define NVM_FLASH_PAGESIZE      (4096U)
+#define NVM_FLASH_ROWSIZE       (1024U)
+void NVM_Initialize(void);
+bool NVM_Read(uint32_t *data, uint32_t length, const uint32_t address);
+bool NVM_RowWrite(uint32_t *data, uint32_t address);
+bool NVM_PageErase(uint32_t address);
+bool NVM_IsBusy(void);
+
+typedef int SYS_FS_HANDLE;
+#define SYS_FS_HANDLE_INVALID   (-1)
+typedef enum { SYS_FS_FILE_OPEN_READ, SYS_FS_FILE_OPEN_WRITE } SYS_FS_FILE_OPEN_ATTRIBUTES;
+SYS_FS_HANDLE SYS_FS_FileOpen(const char *name, SYS_FS_FILE_OPEN_ATTRIBUTES attr);
+size_t SYS_FS_FileRead(SYS_FS_HANDLE h, void *buf, size_t len);
+size_t SYS_FS_FileWrite(SYS_FS_HANDLE h, const void *buf, size_t len);
+int SYS_FS_FileClose(SYS_FS_HANDLE h);
+int SYS_FS_FileRemove(const char *name);
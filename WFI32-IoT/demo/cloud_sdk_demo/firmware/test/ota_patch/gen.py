@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+"""Generate a random source image, a janpatch (JojoDiff) patch and the
+expected target image for the OTA patch harness.
+
+usage: gen.py <seed> <out dir>
+
+Writes src.bin, patch.bin and tgt.bin. Images are biased towards the
+escape and operation bytes, and lengths towards the boundaries of the
+length encoding, so the decoder corner cases are hit often.
+"""
+import os
+import random
+import sys
+
+ESC, MOD, INS, DEL, EQL, BKT = 0xa7, 0xa6, 0xa5, 0xa4, 0xa3, 0xa2
+
+
+def enc_len(n):
+    # Same encoding as janpatch find_length()
+    if 1 <= n <= 252:
+        return bytes([n - 1])
+    if 253 <= n <= 508:
+        return bytes([252, n - 253])
+    if n <= 0xffff:
+        return bytes([253, n >> 8, n & 255])
+    return bytes([254]) + n.to_bytes(4, 'big')
+
+
+def enc_data(r, d):
+    out = bytearray()
+    i = 0
+    while i < len(d):
+        b = d[i]
+        if b == ESC:
+            nxt = d[i + 1] if i + 1 < len(d) else None
+            # ESC followed by a byte that is neither ESC nor an operation
+            # may also go out as a raw pair
+            if nxt is not None and nxt != ESC and not (BKT <= nxt <= MOD) and r.random() < 0.5:
+                out += bytes([ESC, nxt])
+                i += 2
+                continue
+            out += bytes([ESC, ESC])
+            i += 1
+            continue
+        out.append(b)
+        i += 1
+    return out
+
+
+def gen(seed):
+    r = random.Random(seed)
+    pool = [ESC, MOD, BKT, EQL, 0, 1, 2, 0xff]
+
+    def blob(n, bias):
+        return bytes(r.choice(pool) if r.random() < bias else r.randrange(256) for _ in range(n))
+
+    src = blob(r.choice([100, 3000, 20000, 70000]), 0.3)
+    patch = bytearray()
+    tgt = bytearray()
+    pos = 0
+    for _ in range(r.randrange(1, 60)):
+        k = r.randrange(5)
+        if k == 0 and pos < len(src):
+            n = min(r.choice([1, 5, 252, 253, 300, 508, 509, 4000, 70000]), len(src) - pos)
+            patch += bytes([ESC, EQL]) + enc_len(n)
+            tgt += src[pos:pos + n]
+            pos += n
+        elif k in (1, 2):
+            d = blob(r.choice([1, 3, 50, 5000]), 0.4)
+            patch += bytes([ESC, MOD if k == 1 else INS]) + enc_data(r, d)
+            tgt += d
+            if k == 1:
+                pos += len(d)
+        elif k == 3:
+            n = r.choice([1, 10, 300, 70000])
+            patch += bytes([ESC, DEL]) + enc_len(n)
+            pos += n
+        elif k == 4 and pos > 0:
+            n = min(r.choice([1, 10, 300, 70000]), pos)
+            patch += bytes([ESC, BKT]) + enc_len(n)
+            pos -= n
+    return src, bytes(patch), bytes(tgt)
+
+
+def main():
+    seed, out = int(sys.argv[1]), sys.argv[2]
+    os.makedirs(out, exist_ok=True)
+    for name, data in zip(('src.bin', 'patch.bin', 'tgt.bin'), gen(seed)):
+        with open(os.path.join(out, name), 'wb') as f:
+            f.write(data)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,289 @@
+/*
+ * Host harness for the OTA patcher (system/ota/framework/ota_patch.c).
+ *
+ * usage: harness <fixture dir> <seed>
+ *
+ * Applies <dir>/patch.bin to <dir>/src.bin twice and compares both results
+ * with <dir>/tgt.bin:
+ *  - with OTA_ProcessPatch (janpatch over files), as the reference;
+ *  - with OTA_PatchStreamTask, the source in a simulated internal flash and
+ *    the patch coming from a simulated downloader.
+ * The seed drives the downloader chunk sizes and the flash queue stalls.
+ * The flash model aborts on unaligned erases / writes and on writes to
+ * flash which is not erased.
+ */
+#include "definitions.h"
+#include "driver/driver_common.h"
+#include "ota_patch.h"
+#include "int_flash.h"
+
+#define FLASH_SIZE      0x200000
+#define SRC_ADDR        0x1000
+#define DST_ADDR        0x100000
+#define DST_SIZE        0xE0000
+
+static uint8_t flash[FLASH_SIZE];
+static int flash_reads;
+
+static uint8_t *load(const char *dir, const char *name, uint32_t *len)
+{
+    char path[512];
+    FILE *f;
+    uint8_t *buf;
+
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    f = fopen(path, "rb");
+    if (f == NULL) {
+        perror(path);
+        exit(2);
+    }
+    fseek(f, 0, SEEK_END);
+    *len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    buf = malloc(*len + 1);
+    if (fread(buf, 1, *len, f) != *len) {
+        exit(2);
+    }
+    fclose(f);
+    return buf;
+}
+
+/* Internal flash queue: one job completes per INT_Flash_QueueTasks call at most */
+typedef struct {
+    bool erase;
+    uint32_t addr;
+    uint8_t *buf;
+    uint32_t len;
+} FLASH_JOB;
+
+static FLASH_JOB queue[INT_FLASH_QUEUE_DEPTH];
+static uint32_t queue_head, queue_tail;
+
+static uint32_t queue_add(bool erase, uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    FLASH_JOB *job;
+
+    if (queue_head - queue_tail == INT_FLASH_QUEUE_DEPTH || rand() % 5 == 0) {
+        return 0;
+    }
+    job = &queue[queue_head % INT_FLASH_QUEUE_DEPTH];
+    job->erase = erase;
+    job->addr = addr;
+    job->buf = buf;
+    job->len = len;
+    return ++queue_head;
+}
+
+uint32_t INT_Flash_QueueErase(uint32_t addr, uint32_t len)
+{
+    if (addr % FLASH_SECTOR_SIZE || len % FLASH_SECTOR_SIZE) {
+        abort();
+    }
+    return queue_add(true, addr, NULL, len);
+}
+
+uint32_t INT_Flash_QueueWrite(uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    if (len % 1024) {
+        abort();
+    }
+    return queue_add(false, addr, buf, len);
+}
+
+bool INT_Flash_QueueDone(uint32_t ticket)
+{
+    return ticket <= queue_tail;
+}
+
+INT_FLASH_QUEUE_STATUS INT_Flash_QueueTasks(void)
+{
+    FLASH_JOB *job;
+    uint32_t i;
+
+    if (queue_tail == queue_head) {
+        return INT_FLASH_QUEUE_IDLE;
+    }
+    if (rand() % 2) {
+        return INT_FLASH_QUEUE_BUSY;
+    }
+    job = &queue[queue_tail % INT_FLASH_QUEUE_DEPTH];
+    if (job->erase) {
+        memset(&flash[job->addr], 0xFF, job->len);
+    }
+    else {
+        for (i = 0; i < job->len; i++) {
+            if (flash[job->addr + i] != 0xFF) {
+                fprintf(stderr, "write to unerased flash at %x\n", job->addr + i);
+                abort();
+            }
+            flash[job->addr + i] = job->buf[i];
+        }
+    }
+    queue_tail++;
+    return (queue_tail == queue_head) ? INT_FLASH_QUEUE_IDLE : INT_FLASH_QUEUE_BUSY;
+}
+
+void INT_Flash_QueueFlush(void)
+{
+    queue_tail = queue_head;
+}
+
+bool INT_Flash_Open(void)
+{
+    return true;
+}
+
+void INT_Flash_Close(void)
+{
+}
+
+bool INT_Flash_Read(uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    flash_reads++;
+    memcpy(buf, &flash[addr], len);
+    return true;
+}
+
+/* Downloader: the patch arrives in random chunks, with empty reads in between */
+static uint8_t *patch_buf;
+static uint32_t patch_len, patch_pos;
+
+int DOWNLOADER_Read(DRV_HANDLE handle, unsigned char *buf, int size)
+{
+    int n;
+
+    (void)handle;
+    if (size == 0) {
+        return 0;
+    }
+    n = (rand() % 3 == 0) ? 0 : (rand() % size) + 1;
+    if (n > (int)(patch_len - patch_pos)) {
+        n = patch_len - patch_pos;
+    }
+    memcpy(buf, &patch_buf[patch_pos], n);
+    patch_pos += n;
+    return n;
+}
+
+/* In-memory files for OTA_ProcessPatch; the file name is the index */
+typedef struct {
+    uint8_t *buf;
+    uint32_t len;
+    uint32_t cap;
+    int32_t pos;
+} MEM_FILE;
+
+static MEM_FILE files[3];
+
+SYS_FS_HANDLE SYS_FS_FileOpen(const char *name, SYS_FS_FILE_OPEN_ATTRIBUTES attr)
+{
+    int i = name[0] - '0';
+
+    (void)attr;
+    files[i].pos = 0;
+    return i;
+}
+
+size_t SYS_FS_FileRead(SYS_FS_HANDLE h, void *buf, size_t n)
+{
+    MEM_FILE *f = &files[h];
+
+    if (f->pos >= (int32_t)f->len) {
+        return 0;
+    }
+    if (n > f->len - f->pos) {
+        n = f->len - f->pos;
+    }
+    memcpy(buf, &f->buf[f->pos], n);
+    f->pos += n;
+    return n;
+}
+
+size_t SYS_FS_FileWrite(SYS_FS_HANDLE h, const void *buf, size_t n)
+{
+    MEM_FILE *f = &files[h];
+
+    if (f->pos + n > f->cap) {
+        abort();
+    }
+    memcpy(&f->buf[f->pos], buf, n);
+    f->pos += n;
+    if ((uint32_t)f->pos > f->len) {
+        f->len = f->pos;
+    }
+    return n;
+}
+
+int SYS_FS_FileSeek(SYS_FS_HANDLE h, int32_t off, SYS_FS_FILE_SEEK_CONTROL whence)
+{
+    MEM_FILE *f = &files[h];
+
+    f->pos = off + ((whence == SYS_FS_SEEK_SET) ? 0 : (whence == SYS_FS_SEEK_CUR) ? f->pos : (int32_t)f->len);
+    return 0;
+}
+
+int32_t SYS_FS_FileTell(SYS_FS_HANDLE h)
+{
+    return files[h].pos;
+}
+
+int SYS_FS_FileSync(SYS_FS_HANDLE h)
+{
+    (void)h;
+    return 0;
+}
+
+int SYS_FS_FileClose(SYS_FS_HANDLE h)
+{
+    (void)h;
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    static OTA_PATCH_STREAM ps;
+    OTA_PATCH_PARAMS_t params;
+    uint32_t src_len, tgt_len, i;
+    uint8_t *src, *tgt;
+    SYS_STATUS status;
+    bool ref_ok, stream_ok;
+
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s <fixture dir> <seed>\n", argv[0]);
+        return 2;
+    }
+    src = load(argv[1], "src.bin", &src_len);
+    patch_buf = load(argv[1], "patch.bin", &patch_len);
+    tgt = load(argv[1], "tgt.bin", &tgt_len);
+    srand(atoi(argv[2]));
+
+    /* Reference: janpatch over files */
+    files[0] = (MEM_FILE){ src, src_len, src_len, 0 };
+    files[1] = (MEM_FILE){ patch_buf, patch_len, patch_len, 0 };
+    files[2] = (MEM_FILE){ calloc(1, DST_SIZE), 0, DST_SIZE, 0 };
+    strcpy(params.source_file, "0");
+    strcpy(params.patch_file, "1");
+    strcpy(params.target_file, "2");
+    status = OTA_ProcessPatch(&params);
+    ref_ok = (status == SYS_STATUS_READY) && (files[2].len == tgt_len) && !memcmp(files[2].buf, tgt, tgt_len);
+
+    /* Streaming from the downloader into flash */
+    memset(flash, 0x5A, sizeof(flash));
+    memcpy(&flash[SRC_ADDR], src, src_len);
+    if (OTA_PatchStreamOpen(&ps, SRC_ADDR, src_len, DST_ADDR, DST_SIZE, patch_len) != SYS_STATUS_READY) {
+        return 2;
+    }
+    while ((status = OTA_PatchStreamTask(&ps, 0)) == SYS_STATUS_BUSY) {
+    }
+    OTA_PatchStreamAbort(&ps);
+    stream_ok = (status == SYS_STATUS_READY) && (ps.dst_len == tgt_len) && !memcmp(&flash[DST_ADDR], tgt, tgt_len);
+    /* The rest of the last sector is padded */
+    for (i = tgt_len; stream_ok && i < ((tgt_len + FLASH_SECTOR_SIZE - 1) & ~(FLASH_SECTOR_SIZE - 1)); i++) {
+        stream_ok = (flash[DST_ADDR + i] == 0xFF);
+    }
+
+    printf("%s seed %s: src %u patch %u tgt %u, reference %s, stream %s, flash reads %d\n",
+           argv[1], argv[2], src_len, patch_len, tgt_len,
+           ref_ok ? "ok" : "FAIL", stream_ok ? "ok" : "FAIL", flash_reads);
+    return (ref_ok && stream_ok) ? 0 : 1;
+}
@@ -0,0 +1,36 @@
+#!/bin/sh
+# Build the OTA patch harness for the host and run it over the committed
+# fixtures, then over COUNT (default 200) freshly generated patches.
+#
+# usage: run.sh [COUNT]
+set -e
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+CFG=$HERE/../../src/config/aws_sdk_wfi32_iot_freertos
+COUNT=${1:-200}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# ota_patch.c keeps the warnings of the vendored janpatch.h and of its
+# baseline janpatch setup; everything else builds with -Werror.
+CFLAGS="-g -fsanitize=address,undefined -Wall -Wextra -I$HERE/stub -I$CFG -I$CFG/system/ota/framework"
+${CC:-cc} $CFLAGS -c "$CFG/system/ota/framework/ota_patch.c" -o "$WORK/ota_patch.o"
+${CC:-cc} $CFLAGS -Werror -c "$CFG/system/ota/framework/sha256.c" -o "$WORK/sha256.o"
+${CC:-cc} $CFLAGS -Werror -c "$HERE/harness.c" -o "$WORK/harness.o"
+${CC:-cc} -fsanitize=address,undefined "$WORK/harness.o" "$WORK/ota_patch.o" "$WORK/sha256.o" -o "$WORK/harness"
+
+export ASAN_OPTIONS=detect_leaks=0
+fail=0
+for dir in "$HERE"/fixtures/*/; do
+    "$WORK/harness" "${dir%/}" 1 || fail=$((fail + 1))
+done
+
+seed=1
+while [ "$seed" -le "$COUNT" ]; do
+    python3 "$HERE/gen.py" "$seed" "$WORK/gen"
+    "$WORK/harness" "$WORK/gen" "$seed" > "$WORK/out" || { cat "$WORK/out"; fail=$((fail + 1)); }
+    seed=$((seed + 1))
+done
+
+echo "$COUNT generated patches, $fail failure(s)"
+[ "$fail" -eq 0 ]
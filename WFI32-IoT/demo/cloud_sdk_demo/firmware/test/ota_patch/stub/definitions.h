@@ -0,0 +1,22 @@
+#pragma once
+/* Host build stand-in for the Harmony definitions used by ota_patch.c */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#define SYS_OTA_PATCH_ENABLE
+typedef enum { SYS_STATUS_ERROR = -1, SYS_STATUS_UNINITIALIZED = 0, SYS_STATUS_BUSY = 1, SYS_STATUS_READY = 2 } SYS_STATUS;
+#define SYS_CONSOLE_PRINT(...) fprintf(stderr, __VA_ARGS__)
+typedef int SYS_FS_HANDLE;
+typedef enum { SYS_FS_SEEK_SET, SYS_FS_SEEK_CUR, SYS_FS_SEEK_END } SYS_FS_FILE_SEEK_CONTROL;
+typedef enum { SYS_FS_FILE_OPEN_READ, SYS_FS_FILE_OPEN_WRITE_PLUS } SYS_FS_FILE_OPEN_ATTRIBUTES;
+size_t SYS_FS_FileRead(SYS_FS_HANDLE h, void *b, size_t n);
+size_t SYS_FS_FileWrite(SYS_FS_HANDLE h, const void *b, size_t n);
+int SYS_FS_FileSeek(SYS_FS_HANDLE h, int32_t off, SYS_FS_FILE_SEEK_CONTROL w);
+int32_t SYS_FS_FileTell(SYS_FS_HANDLE h);
+int SYS_FS_FileSync(SYS_FS_HANDLE h);
+int SYS_FS_FileClose(SYS_FS_HANDLE h);
+SYS_FS_HANDLE SYS_FS_FileOpen(const char *n, SYS_FS_FILE_OPEN_ATTRIBUTES a);
+#define OSAL_Malloc malloc
+#define OSAL_Free free
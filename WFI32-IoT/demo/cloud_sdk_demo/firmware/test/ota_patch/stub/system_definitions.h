@@ -0,0 +1 @@
+#include "definitions.h"
@@ -0,0 +1,630 @@
+/*
+ * Host harness for the resumable OTA download: the file download state
+ * machine of sys_ota.c (SYS_OTA_Download_File and the download cursor), the
+ * downloader and the HTTP client, as they are in the firmware, talking to a
+ * local server through a NET_PRES built on POSIX sockets. The slot lives in
+ * a simulated flash whose queued jobs complete at random; it is kept in a
+ * file, and so is the cursor, so a run can be stopped part way ("reset")
+ * and started again.
+ *
+ * usage: harness URL IMAGE DIR [-r BYTES] [-s SCALE] [-m BYTES] [-e]
+ *   -r BYTES  reset once BYTES of the slot are programmed (exit status 3)
+ *   -s SCALE  run the millisecond timer SCALE times faster than real time
+ *   -m BYTES  fail if more than BYTES are received from the server
+ *   -e        expect the download to fail
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+
+#include "definitions.h"
+#include "system/ota/framework/ota_config.h"
+#include "system/ota/framework/ota.h"
+#include "system/ota/framework/int_flash.h"
+#include "system/ota/framework/sha256.h"
+#include "system/ota/framework/ota_lz.h"
+#include "system/ota/framework/downloader.h"
+#include "system/ota/framework/http_client/http_client.h"
+
+#define SLOT_ADDRESS    0x00100000u
+#define SLOT_SIZE       (1024u * 1024u)
+
+static int failures;
+#define FAIL(...) do { fprintf(stderr, "FAIL: " __VA_ARGS__); fputc('\n', stderr); failures++; } while (0)
+
+/* ---- what sys_ota.c has around the download code ---- */
+
+#include "sys_ota_types.h"
+
+extern size_t field_content_length;
+SYS_OTA_FILE_DATA g_SysFileData;
+static uint8_t g_formulated_digest[32];
+static SYS_OTA_FILE_DOWNLOAD_STATUS File_Dnld_Status = SYS_OTA_DOWNLOAD_FILE;
+
+static inline bool SYS_OTA_ConnectedToNtwrk(void)
+{
+    return true;
+}
+
+static bool NVM_IsBusy(void)
+{
+    return false;
+}
+
+/* ---- millisecond timer ---- */
+
+static TMR_CALLBACK tmrCallback;
+static uintptr_t tmrContext;
+static struct timespec tmrLast;
+static unsigned timeScale = 1;
+
+void TMR2_CallbackRegister(TMR_CALLBACK callback, uintptr_t context)
+{
+    tmrCallback = callback;
+    tmrContext = context;
+}
+
+void TMR2_Start(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &tmrLast);
+}
+
+static void tick(void)
+{
+    struct timespec now;
+    long ms;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    ms = (now.tv_sec - tmrLast.tv_sec) * 1000 + (now.tv_nsec - tmrLast.tv_nsec) / 1000000;
+    if (ms <= 0) {
+        return;
+    }
+    tmrLast.tv_sec += ms / 1000;
+    tmrLast.tv_nsec += (ms % 1000) * 1000000;
+    if (tmrLast.tv_nsec >= 1000000000) {
+        tmrLast.tv_sec++;
+        tmrLast.tv_nsec -= 1000000000;
+    }
+    for (long i = 0; i < ms * (long)timeScale && tmrCallback != NULL; i++) {
+        tmrCallback(0, tmrContext);
+    }
+}
+
+/* ---- NET_PRES on a POSIX socket; only IP literals, no TLS ---- */
+
+static struct {
+    int fd;
+    bool connected;
+    bool closed;
+    NET_PRES_SIGNAL_FUNCTION sigFn;
+    const void *sigParam;
+} sock = { .fd = -1 };
+static size_t rxBytes;
+static unsigned connections;
+
+TCPIP_DNS_RESULT TCPIP_DNS_Resolve(const char *hostName, TCPIP_DNS_RESOLVE_TYPE type)
+{
+    (void)hostName;
+    (void)type;
+    return TCPIP_DNS_RES_NO_NAME_ENTRY;
+}
+
+TCPIP_DNS_RESULT TCPIP_DNS_IsResolved(const char *hostName, IP_MULTI_ADDRESS *hostIP, int type)
+{
+    (void)hostName;
+    (void)hostIP;
+    (void)type;
+    return TCPIP_DNS_RES_NO_NAME_ENTRY;
+}
+
+bool TCPIP_Helper_StringToIPAddress(const char *str, IPV4_ADDR *addr)
+{
+    struct in_addr in;
+
+    if (inet_pton(AF_INET, str, &in) != 1) {
+        return false;
+    }
+    addr->Val = in.s_addr;
+    return true;
+}
+
+NET_PRES_SKT_HANDLE_T NET_PRES_SocketOpen(int index, NET_PRES_SKT_T socketType, IP_ADDRESS_TYPE addrType, uint16_t port, NET_PRES_ADDRESS *addr, NET_PRES_SKT_ERROR_T *error)
+{
+    struct sockaddr_in sa;
+
+    (void)index;
+    (void)addrType;
+    *error = 0;
+    if (socketType != NET_PRES_SKT_UNENCRYPTED_STREAM_CLIENT || sock.fd >= 0) {
+        return NET_PRES_INVALID_SOCKET;
+    }
+    sock.fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock.fd < 0) {
+        return NET_PRES_INVALID_SOCKET;
+    }
+    fcntl(sock.fd, F_SETFL, fcntl(sock.fd, F_GETFL) | O_NONBLOCK);
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(port);
+    sa.sin_addr.s_addr = addr->v4Add.Val;
+    if (connect(sock.fd, (struct sockaddr *)&sa, sizeof(sa)) != 0 && errno != EINPROGRESS) {
+        close(sock.fd);
+        sock.fd = -1;
+        return NET_PRES_INVALID_SOCKET;
+    }
+    sock.connected = false;
+    sock.closed = false;
+    sock.sigFn = NULL;
+    connections++;
+    return 1;
+}
+
+void NET_PRES_SocketClose(NET_PRES_SKT_HANDLE_T handle)
+{
+    (void)handle;
+    if (sock.fd >= 0) {
+        close(sock.fd);
+    }
+    sock.fd = -1;
+}
+
+/* A reset connection is signalled, as the TCP/IP stack does */
+static void sockLost(void)
+{
+    if (!sock.closed && errno == ECONNRESET && sock.sigFn != NULL) {
+        sock.sigFn(1, NULL, TCPIP_TCP_SIGNAL_RX_RST, sock.sigParam);
+    }
+    sock.closed = true;
+}
+
+bool NET_PRES_SocketIsConnected(NET_PRES_SKT_HANDLE_T handle)
+{
+    struct pollfd p = { .fd = sock.fd, .events = POLLOUT };
+    uint8_t c;
+
+    (void)handle;
+    if (sock.fd < 0) {
+        return false;
+    }
+    if (!sock.connected) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+
+        if (poll(&p, 1, 0) != 1) {
+            return false;
+        }
+        getsockopt(sock.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+        sock.connected = (err == 0);
+        sock.closed = (err != 0);
+        return sock.connected;
+    }
+    /* Closed by the peer once all that it sent has been read */
+    if (!sock.closed) {
+        ssize_t n = recv(sock.fd, &c, 1, MSG_PEEK);
+
+        if (n == 0) {
+            sock.closed = true;
+        }
+        else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            sockLost();
+        }
+    }
+    return !sock.closed;
+}
+
+bool NET_PRES_SocketIsNegotiatingEncryption(NET_PRES_SKT_HANDLE_T handle)
+{
+    (void)handle;
+    return false;
+}
+
+bool NET_PRES_SocketIsSecure(NET_PRES_SKT_HANDLE_T handle)
+{
+    (void)handle;
+    return false;
+}
+
+bool NET_PRES_SocketWasReset(NET_PRES_SKT_HANDLE_T handle)
+{
+    (void)handle;
+    return false;
+}
+
+bool NET_PRES_SocketOptionsSet(NET_PRES_SKT_HANDLE_T handle, TCP_SOCKET_OPTION option, void *optParam)
+{
+    (void)handle;
+    (void)option;
+    (void)optParam;
+    return true;
+}
+
+bool NET_PRES_SocketOptionsGet(NET_PRES_SKT_HANDLE_T handle, TCP_SOCKET_OPTION option, void *optParam)
+{
+    (void)handle;
+    (void)option;
+    (void)optParam;
+    return true;
+}
+
+uint16_t NET_PRES_SocketReadIsReady(NET_PRES_SKT_HANDLE_T handle)
+{
+    int n = 0;
+
+    (void)handle;
+    if (sock.fd < 0 || !sock.connected || ioctl(sock.fd, FIONREAD, &n) != 0) {
+        return 0;
+    }
+    return (n > UINT16_MAX) ? UINT16_MAX : (uint16_t)n;
+}
+
+uint16_t NET_PRES_SocketRead(NET_PRES_SKT_HANDLE_T handle, void *buffer, uint16_t size)
+{
+    ssize_t n;
+
+    (void)handle;
+    n = recv(sock.fd, buffer, size, 0);
+    if (n < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            sockLost();
+        }
+        return 0;
+    }
+    rxBytes += n;
+    return (uint16_t)n;
+}
+
+uint16_t NET_PRES_SocketWriteIsReady(NET_PRES_SKT_HANDLE_T handle, uint16_t reqSize, uint16_t minSize)
+{
+    (void)handle;
+    (void)minSize;
+    return sock.connected ? reqSize : 0;
+}
+
+uint16_t NET_PRES_SocketWrite(NET_PRES_SKT_HANDLE_T handle, const void *buffer, uint16_t size)
+{
+    ssize_t n;
+
+    (void)handle;
+    n = send(sock.fd, buffer, size, MSG_NOSIGNAL);
+    return (n < 0) ? 0 : (uint16_t)n;
+}
+
+NET_PRES_SIGNAL_HANDLE NET_PRES_SocketSignalHandlerRegister(NET_PRES_SKT_HANDLE_T handle, uint16_t sigMask, NET_PRES_SIGNAL_FUNCTION handler, const void *hParam)
+{
+    (void)handle;
+    (void)sigMask;
+    sock.sigFn = handler;
+    sock.sigParam = hParam;
+    return &sock;
+}
+
+bool NET_PRES_SocketSignalHandlerDeregister(NET_PRES_SKT_HANDLE_T handle, NET_PRES_SIGNAL_HANDLE hSig)
+{
+    (void)handle;
+    (void)hSig;
+    sock.sigFn = NULL;
+    return true;
+}
+
+/* ---- SYS_FS on files in DIR ---- */
+
+static const char *dir;
+static FILE *files[2];
+
+static void fsPath(char *path, size_t size, const char *name)
+{
+    const char *base = strrchr(name, '/');
+
+    snprintf(path, size, "%s/%s", dir, (base != NULL) ? base + 1 : name);
+}
+
+SYS_FS_HANDLE SYS_FS_FileOpen(const char *name, SYS_FS_FILE_OPEN_ATTRIBUTES attr)
+{
+    char path[512];
+
+    for (int i = 0; i < 2; i++) {
+        if (files[i] == NULL) {
+            fsPath(path, sizeof(path), name);
+            files[i] = fopen(path, (attr == SYS_FS_FILE_OPEN_READ) ? "rb" : "wb");
+            return (files[i] != NULL) ? i : SYS_FS_HANDLE_INVALID;
+        }
+    }
+    return SYS_FS_HANDLE_INVALID;
+}
+
+size_t SYS_FS_FileRead(SYS_FS_HANDLE h, void *buf, size_t len)
+{
+    return fread(buf, 1, len, files[h]);
+}
+
+size_t SYS_FS_FileWrite(SYS_FS_HANDLE h, const void *buf, size_t len)
+{
+    return fwrite(buf, 1, len, files[h]);
+}
+
+int SYS_FS_FileClose(SYS_FS_HANDLE h)
+{
+    fclose(files[h]);
+    files[h] = NULL;
+    return 0;
+}
+
+int SYS_FS_FileRemove(const char *name)
+{
+    char path[512];
+
+    fsPath(path, sizeof(path), name);
+    return remove(path);
+}
+
+/* ---- the slot in a simulated flash; queued jobs complete at random ---- */
+
+typedef struct {
+    bool erase;
+    uint32_t addr;
+    uint8_t *buf;
+    uint32_t len;
+    uint32_t ticket;
+} FLASH_JOB;
+
+static uint8_t slot[SLOT_SIZE];
+static FLASH_JOB queue[INT_FLASH_QUEUE_DEPTH];
+static unsigned queueHead, queueCount;
+static uint32_t lastTicket, doneTicket;
+static bool flashError;
+static uint32_t programmed;
+static uint32_t resetAt;
+
+static void slotSave(void)
+{
+    char path[512];
+    FILE *f;
+
+    snprintf(path, sizeof(path), "%s/slot.bin", dir);
+    f = fopen(path, "wb");
+    if (f == NULL || fwrite(slot, 1, sizeof(slot), f) != sizeof(slot)) {
+        perror(path);
+        exit(2);
+    }
+    fclose(f);
+}
+
+static void slotLoad(void)
+{
+    char path[512];
+    FILE *f;
+
+    snprintf(path, sizeof(path), "%s/slot.bin", dir);
+    f = fopen(path, "rb");
+    if (f == NULL) {
+        memset(slot, 0xFF, sizeof(slot));
+        return;
+    }
+    if (fread(slot, 1, sizeof(slot), f) != sizeof(slot)) {
+        fprintf(stderr, "%s: short\n", path);
+        exit(2);
+    }
+    fclose(f);
+}
+
+static bool slotRange(uint32_t addr, uint32_t len)
+{
+    return addr >= SLOT_ADDRESS && addr - SLOT_ADDRESS <= SLOT_SIZE && len <= SLOT_SIZE - (addr - SLOT_ADDRESS);
+}
+
+static void flashRun(const FLASH_JOB *job)
+{
+    uint8_t *p = &slot[job->addr - SLOT_ADDRESS];
+
+    if (job->erase) {
+        memset(p, 0xFF, job->len);
+        return;
+    }
+    for (uint32_t i = 0; i < job->len; i++) {
+        if (p[i] != 0xFF) {
+            FAIL("programmed 0x%08X without erasing it", (unsigned)(job->addr + i));
+            flashError = true;
+            return;
+        }
+        p[i] = job->buf[i];
+    }
+    programmed += job->len;
+    if (resetAt != 0 && programmed >= resetAt) {
+        /* What is not programmed yet is lost with the reset */
+        slotSave();
+        printf("reset after %u bytes programmed, %zu received\n", (unsigned)programmed, rxBytes);
+        exit(3);
+    }
+}
+
+static uint32_t flashQueue(bool erase, uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    FLASH_JOB *job;
+
+    if (!slotRange(addr, len)) {
+        FAIL("flash job outside the slot: 0x%08X + %u", (unsigned)addr, (unsigned)len);
+        flashError = true;
+        return 0;
+    }
+    if (queueCount == INT_FLASH_QUEUE_DEPTH) {
+        return 0;
+    }
+    job = &queue[(queueHead + queueCount++) % INT_FLASH_QUEUE_DEPTH];
+    job->erase = erase;
+    job->addr = addr;
+    job->buf = buf;
+    job->len = len;
+    job->ticket = ++lastTicket;
+    return job->ticket;
+}
+
+uint32_t INT_Flash_QueueErase(uint32_t addr, uint32_t len)
+{
+    return flashQueue(true, addr, NULL, len);
+}
+
+uint32_t INT_Flash_QueueWrite(uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    return flashQueue(false, addr, buf, len);
+}
+
+bool INT_Flash_QueueDone(uint32_t ticket)
+{
+    return ticket <= doneTicket;
+}
+
+INT_FLASH_QUEUE_STATUS INT_Flash_QueueTasks(void)
+{
+    if (flashError) {
+        return INT_FLASH_QUEUE_ERROR;
+    }
+    /* A write reads its data when it runs, not when it is queued */
+    if (queueCount != 0 && (rand() % 4) == 0) {
+        FLASH_JOB *job = &queue[queueHead];
+
+        flashRun(job);
+        doneTicket = job->ticket;
+        queueHead = (queueHead + 1) % INT_FLASH_QUEUE_DEPTH;
+        queueCount--;
+    }
+    return (queueCount != 0) ? INT_FLASH_QUEUE_BUSY : INT_FLASH_QUEUE_IDLE;
+}
+
+void INT_Flash_QueueFlush(void)
+{
+    queueCount = 0;
+    doneTicket = lastTicket;
+}
+
+bool INT_Flash_Open(void)
+{
+    return true;
+}
+
+void INT_Flash_Close(void)
+{
+}
+
+bool INT_Flash_Read(uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    if (!slotRange(addr, len)) {
+        return false;
+    }
+    memcpy(buf, &slot[addr - SLOT_ADDRESS], len);
+    return true;
+}
+
+/* ---- the code under test ---- */
+
+#include "sys_ota_download.c"
+
+static uint8_t *imageLoad(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    uint8_t *buf;
+
+    if (f == NULL) {
+        perror(path);
+        exit(2);
+    }
+    fseek(f, 0, SEEK_END);
+    *len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    buf = malloc(*len);
+    if (buf == NULL || fread(buf, 1, *len, f) != *len) {
+        fprintf(stderr, "%s: read error\n", path);
+        exit(2);
+    }
+    fclose(f);
+    return buf;
+}
+
+int main(int argc, char **argv)
+{
+    const char *url;
+    uint8_t *image;
+    size_t imageLen;
+    size_t maxRx = 0;
+    bool expectError = false;
+    OTA_SHA256_CTX sha;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:s:m:e")) != -1) {
+        switch (opt) {
+            case 'r': resetAt = strtoul(optarg, NULL, 0); break;
+            case 's': timeScale = strtoul(optarg, NULL, 0); break;
+            case 'm': maxRx = strtoul(optarg, NULL, 0); break;
+            case 'e': expectError = true; break;
+            default: return 2;
+        }
+    }
+    if (argc - optind != 3) {
+        fprintf(stderr, "usage: %s URL IMAGE DIR [-r BYTES] [-s SCALE] [-m BYTES] [-e]\n", argv[0]);
+        return 2;
+    }
+    url = argv[optind];
+    image = imageLoad(argv[optind + 1], &imageLen);
+    dir = argv[optind + 2];
+    srand(getpid());
+    slotLoad();
+
+    /* The file as the manifest describes it */
+    ota_sha256_init(&sha);
+    ota_sha256_update(&sha, image, imageLen);
+    ota_sha256_final(&sha, g_formulated_digest);
+    for (int i = 0; i < 32; i++) {
+        sprintf(&g_SysFileData.file_digest_string[2 * i], "%02x", g_formulated_digest[i]);
+    }
+    strncpy(g_SysFileData.file_url, url, sizeof(g_SysFileData.file_url) - 1);
+    g_SysFileData.slot_number = 1;
+    g_SysFileData.slot_info.slot_address[1] = SLOT_ADDRESS;
+    g_SysFileData.slot_info.slot_size[1] = SLOT_SIZE;
+    g_SysFileData.slot_info.file_size_in_slot[1] = imageLen;
+
+    HTTP_Client_Init();
+    DOWNLOADER_Initialize();
+    while (g_SysFileData.file_index == 0 && !g_SysFileData.error) {
+        tick();
+        DOWNLOADER_Tasks();
+        SYS_OTA_Download_File(g_SysFileData.file_url);
+        INT_Flash_QueueTasks();
+        usleep(20);
+    }
+    slotSave();
+    printf("%s: %zu of %zu bytes received over %u connection(s)\n",
+            g_SysFileData.error ? "download failed" : "downloaded", rxBytes, imageLen, connections);
+
+    if (g_SysFileData.error) {
+        if (!expectError) {
+            FAIL("download failed");
+        }
+    }
+    else {
+        if (expectError) {
+            FAIL("download did not fail");
+        }
+        if (File_Dnld_Status != SYS_OTA_PARSE_JSON) {
+            FAIL("download did not complete");
+        }
+        if (g_SysFileData.slot_info.file_size_in_slot[1] != imageLen) {
+            FAIL("length %u, file is %zu", (unsigned)g_SysFileData.slot_info.file_size_in_slot[1], imageLen);
+        }
+        if (memcmp(slot, image, imageLen) != 0) {
+            FAIL("slot does not hold the file");
+        }
+        if (memcmp(g_SysFileData.slot_info.file_digest_in_slot[1], g_formulated_digest, 32) != 0) {
+            FAIL("digest of the slot is wrong");
+        }
+    }
+    if (maxRx != 0 && rxBytes > maxRx) {
+        FAIL("received %zu bytes, at most %zu expected", rxBytes, maxRx);
+    }
+    free(image);
+    return failures ? 1 : 0;
+}
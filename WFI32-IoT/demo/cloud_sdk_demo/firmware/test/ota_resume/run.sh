@@ -0,0 +1,114 @@
+#!/bin/sh
+# Build the OTA resume harness for the host and run it against server.py in
+# each of the fault scenarios.
+#
+# usage: run.sh
+set -e
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+CFG=$HERE/../../src/config/aws_sdk_wfi32_iot_freertos
+OTA=$CFG/system/ota
+WORK=$(mktemp -d)
+SERVER=
+trap '[ -n "$SERVER" ] && kill $SERVER; rm -rf "$WORK"' EXIT
+
+# The slot and cursor types and the file download code, as they are in sys_ota
+sed -n '/^ *\/\* Structure for slot information\*\/$/,/^ *} SYS_OTA_FILE_DOWNLOAD_STATE;$/p' \
+    "$OTA/sys_ota.h" > "$WORK/sys_ota_types.h"
+sed -n '/^\/\* To Read from NVM \*\/$/,/^ *void SYS_OTA_Print_Server_Data/p' \
+    "$OTA/sys_ota.c" | sed '$d' > "$WORK/sys_ota_download.c"
+[ -s "$WORK/sys_ota_types.h" ] || { echo "types not found in sys_ota.h"; exit 1; }
+[ -s "$WORK/sys_ota_download.c" ] || { echo "download code not found in sys_ota.c"; exit 1; }
+
+# The firmware sources keep their warnings (unused parameters, signed and
+# unsigned lengths compared); the harness builds with -Werror.
+CFLAGS="-g -fsanitize=address,undefined -Wall -Wextra -I$HERE/stub -I$CFG -I$CFG/system -I$OTA/framework -I$WORK"
+for src in http_client/http_client.c downloader.c ota_ring.c ota_lz.c sha256.c; do
+    ${CC:-cc} $CFLAGS -c "$OTA/framework/$src" -o "$WORK/$(basename "$src" .c).o" 2>> "$WORK/warnings"
+done
+${CC:-cc} $CFLAGS -Werror -Wno-sign-compare -Wno-unused-function -c "$HERE/harness.c" -o "$WORK/harness.o"
+${CC:-cc} -fsanitize=address,undefined "$WORK"/*.o -o "$WORK/harness"
+
+# 600 kB and a bit, so the last sector is short
+head -c 615633 /dev/urandom > "$WORK/image.bin"
+SIZE=615633
+# What one download of it takes, response headers included
+ONCE=$((SIZE + 512))
+export ASAN_OPTIONS=detect_leaks=0
+fail=0
+
+# server [options]: restart server.py with the given faults
+server() {
+    [ -n "$SERVER" ] && kill $SERVER && wait $SERVER 2>/dev/null || true
+    rm -f "$WORK/port"
+    python3 "$HERE/server.py" "$WORK/image.bin" "$WORK/port" "$@" &
+    SERVER=$!
+    while [ ! -s "$WORK/port" ]; do sleep 0.1; done
+    URL=http://127.0.0.1:$(cat "$WORK/port")/image.bin
+}
+
+# scenario NAME: start a new device
+scenario() {
+    echo "== $1"
+    rm -rf "$WORK/dev"
+    mkdir "$WORK/dev"
+}
+
+# run [harness options] [-- grep pattern]: one boot of the device
+run() {
+    status=0
+    "$WORK/harness" "$@" "$URL" "$WORK/image.bin" "$WORK/dev" > "$WORK/out" 2>&1 || status=$?
+    grep -v '^\s*$' "$WORK/out" | grep -v "Downloading to Slot" | tail -n 4
+}
+
+check() {
+    if [ "$status" -ne "$1" ]; then
+        echo "FAIL: exit status $status, expected $1"
+        fail=$((fail + 1))
+    fi
+}
+
+expect() {
+    if ! grep -q "$1" "$WORK/out"; then
+        echo "FAIL: no \"$1\" in the output"
+        fail=$((fail + 1))
+    fi
+}
+
+scenario "no faults"
+server
+run -m $ONCE; check 0
+
+scenario "connection dropped every 100 kB"
+server --drop-every 102400
+run; check 0
+expect "Download interrupted"
+
+scenario "reset after 300 kB, resumed from the cursor"
+server
+run -r 307200; check 3
+# The cursor is at most SYS_OTA_FILE_CURSOR_INTERVAL (64 kB) behind
+run -m $((ONCE - 307200 + 65536)); check 0
+expect "Resuming download at"
+
+scenario "slot corrupted after the reset, started over"
+run -r 307200; check 3
+python3 -c 'import sys; f = open(sys.argv[1], "r+b"); f.seek(5000); b = f.read(1); f.seek(5000); f.write(bytes([b[0] ^ 1]))' "$WORK/dev/slot.bin"
+run; check 0
+expect "Slot does not match the download cursor"
+
+scenario "server ignores Range, given up and started over"
+server --drop-once 307200 --ignore-range
+run -e; check 0
+[ ! -e "$WORK/dev/ota_cursor.bin" ] || { echo "FAIL: cursor kept"; fail=$((fail + 1)); }
+run -m $ONCE; check 0
+
+scenario "connection stalled for 40 s"
+# 50 times real time: the 30 s receive timeout takes 0.6 s
+server --stall-at 204800 --stall 0.8
+run -s 50; check 0
+expect "Socket receive timeout"
+expect "Resuming download at"
+
+echo "$fail failure(s)"
+[ "$fail" -eq 0 ]
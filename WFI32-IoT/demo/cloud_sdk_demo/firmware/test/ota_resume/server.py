@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""Local HTTP/1.1 server for the OTA resume harness.
+
+Serves one file at any path, honouring "Range: bytes=N-" with a 206, and
+injects the faults the download has to survive:
+
+  --drop-every N    close each connection after N bytes of body
+  --drop-once N     close the first connection after N bytes of body
+  --stall-at N      stop sending after N bytes of body of the first
+  --stall S         connection for S seconds, keeping it open
+  --ignore-range    answer every request with the whole file (200)
+
+The port it listens on is written to PORTFILE once it is ready.
+
+usage: server.py FILE PORTFILE [options]
+"""
+import argparse
+import http.server
+import os
+import re
+import socket
+import struct
+import threading
+import time
+
+CHUNK = 1460
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    connections = 0
+    lock = threading.Lock()
+
+    def log_message(self, fmt, *args):
+        pass
+
+    def do_GET(self):
+        opt = self.server.opt
+        data = self.server.data
+        with Handler.lock:
+            Handler.connections += 1
+            first = Handler.connections == 1
+
+        start = 0
+        m = re.match(r"bytes=(\d+)-$", self.headers.get("Range", ""))
+        if m and not opt.ignore_range:
+            start = int(m.group(1))
+        if start >= len(data):
+            self.send_response(416)
+            self.send_header("Content-Range", "bytes */%d" % len(data))
+            self.send_header("Content-Length", "0")
+            self.end_headers()
+            return
+
+        if m and not opt.ignore_range:
+            self.send_response(206)
+            self.send_header("Content-Range",
+                             "bytes %d-%d/%d" % (start, len(data) - 1, len(data)))
+        else:
+            self.send_response(200)
+        self.send_header("Content-Length", str(len(data) - start))
+        self.end_headers()
+
+        drop = opt.drop_every
+        if first and opt.drop_once:
+            drop = opt.drop_once
+        stall = opt.stall_at if first and opt.stall else None
+        sent = 0
+        pos = start
+        try:
+            while pos < len(data):
+                if drop and sent >= drop:
+                    # An abortive close, as a lost connection looks to the device
+                    self.connection.setsockopt(socket.SOL_SOCKET, socket.SO_LINGER,
+                                               struct.pack("ii", 1, 0))
+                    self.close_connection = True
+                    return
+                if stall is not None and sent >= stall:
+                    time.sleep(opt.stall)
+                    stall = None
+                n = min(CHUNK, len(data) - pos)
+                self.wfile.write(data[pos:pos + n])
+                pos += n
+                sent += n
+        except (BrokenPipeError, ConnectionResetError):
+            self.close_connection = True
+
+
+class Server(http.server.ThreadingHTTPServer):
+    daemon_threads = True
+
+    def handle_error(self, request, client_address):
+        # Connections the device drops are expected
+        pass
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("file")
+    ap.add_argument("portfile")
+    ap.add_argument("--drop-every", type=int, default=0)
+    ap.add_argument("--drop-once", type=int, default=0)
+    ap.add_argument("--stall-at", type=int, default=0)
+    ap.add_argument("--stall", type=float, default=0)
+    ap.add_argument("--ignore-range", action="store_true")
+    opt = ap.parse_args()
+
+    srv = Server(("127.0.0.1", 0), Handler)
+    srv.opt = opt
+    with open(opt.file, "rb") as f:
+        srv.data = f.read()
+    with open(opt.portfile + ".tmp", "w") as f:
+        f.write("%d\n" % srv.server_address[1])
+    os.rename(opt.portfile + ".tmp", opt.portfile)
+    srv.serve_forever()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,47 @@
+#pragma once
+/* Host build stand-in for the Harmony definitions used by http_client.c,
+   downloader.c and the download code of sys_ota.c */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include "tcpip/tcpip.h"
+#include "net_pres/pres/net_pres.h"
+#include "driver/driver_common.h"
+#include "system/ota/framework/downloader.h"
+
+typedef enum { SYS_STATUS_ERROR = -1, SYS_STATUS_UNINITIALIZED = 0, SYS_STATUS_BUSY = 1, SYS_STATUS_READY = 2 } SYS_STATUS;
+
+#define SYS_OTA_ENFORCE_TLS     false
+#define SYS_OTA_NUM_OF_SLOTS    2
+#define SYS_CONSOLE_PRINT(...)  fprintf(stderr, __VA_ARGS__)
+#define TERM_RED    ""
+#define TERM_GREEN  ""
+#define TERM_YELLOW ""
+#define TERM_RESET  ""
+
+#define OSAL_Malloc malloc
+#define OSAL_Free   free
+typedef int OSAL_SEM_HANDLE_TYPE;
+typedef enum { OSAL_RESULT_FALSE = 0, OSAL_RESULT_TRUE = 1 } OSAL_RESULT;
+#define OSAL_SEM_TYPE_BINARY    0
+#define OSAL_WAIT_FOREVER       ((uint16_t)0xFFFF)
+#define OSAL_SEM_Create(s, t, m, i) (*(s) = (i), OSAL_RESULT_TRUE)
+#define OSAL_SEM_Pend(s, w)     (*(s) = 0, OSAL_RESULT_TRUE)
+#define OSAL_SEM_Post(s)        (*(s) = 1, OSAL_RESULT_TRUE)
+
+/* The millisecond timer of http_client.c; harness.c ticks it */
+typedef void (*TMR_CALLBACK)(uint32_t status, uintptr_t context);
+void TMR2_CallbackRegister(TMR_CALLBACK callback, uintptr_t context);
+void TMR2_Start(void);
+
+typedef int SYS_FS_HANDLE;
+#define SYS_FS_HANDLE_INVALID   (-1)
+typedef enum { SYS_FS_FILE_OPEN_READ, SYS_FS_FILE_OPEN_WRITE } SYS_FS_FILE_OPEN_ATTRIBUTES;
+SYS_FS_HANDLE SYS_FS_FileOpen(const char *name, SYS_FS_FILE_OPEN_ATTRIBUTES attr);
+size_t SYS_FS_FileRead(SYS_FS_HANDLE h, void *buf, size_t len);
+size_t SYS_FS_FileWrite(SYS_FS_HANDLE h, const void *buf, size_t len);
+int SYS_FS_FileClose(SYS_FS_HANDLE h);
+int SYS_FS_FileRemove(const char *name);
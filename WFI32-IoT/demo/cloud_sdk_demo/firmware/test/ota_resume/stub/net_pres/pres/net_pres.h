@@ -0,0 +1,26 @@
+#pragma once
+/* Host build stand-in for NET_PRES; harness.c implements it on POSIX sockets */
+#include <stdint.h>
+#include <stdbool.h>
+#include "tcpip/tcpip.h"
+typedef int16_t NET_PRES_SKT_HANDLE_T;
+#define NET_PRES_INVALID_SOCKET         (-1)
+typedef const void *NET_PRES_SIGNAL_HANDLE;
+typedef void (*NET_PRES_SIGNAL_FUNCTION)(NET_PRES_SKT_HANDLE_T handle, NET_PRES_SIGNAL_HANDLE hNet, uint16_t sigType, const void *param);
+typedef enum { NET_PRES_SKT_UNENCRYPTED_STREAM_CLIENT = 1, NET_PRES_SKT_ENCRYPTED_STREAM_CLIENT = 2 } NET_PRES_SKT_T;
+typedef int NET_PRES_SKT_ERROR_T;
+typedef IP_MULTI_ADDRESS NET_PRES_ADDRESS;
+NET_PRES_SKT_HANDLE_T NET_PRES_SocketOpen(int index, NET_PRES_SKT_T socketType, IP_ADDRESS_TYPE addrType, uint16_t port, NET_PRES_ADDRESS *addr, NET_PRES_SKT_ERROR_T *error);
+void NET_PRES_SocketClose(NET_PRES_SKT_HANDLE_T handle);
+bool NET_PRES_SocketIsConnected(NET_PRES_SKT_HANDLE_T handle);
+bool NET_PRES_SocketIsNegotiatingEncryption(NET_PRES_SKT_HANDLE_T handle);
+bool NET_PRES_SocketIsSecure(NET_PRES_SKT_HANDLE_T handle);
+bool NET_PRES_SocketWasReset(NET_PRES_SKT_HANDLE_T handle);
+bool NET_PRES_SocketOptionsSet(NET_PRES_SKT_HANDLE_T handle, TCP_SOCKET_OPTION option, void *optParam);
+bool NET_PRES_SocketOptionsGet(NET_PRES_SKT_HANDLE_T handle, TCP_SOCKET_OPTION option, void *optParam);
+uint16_t NET_PRES_SocketReadIsReady(NET_PRES_SKT_HANDLE_T handle);
+uint16_t NET_PRES_SocketRead(NET_PRES_SKT_HANDLE_T handle, void *buffer, uint16_t size);
+uint16_t NET_PRES_SocketWriteIsReady(NET_PRES_SKT_HANDLE_T handle, uint16_t reqSize, uint16_t minSize);
+uint16_t NET_PRES_SocketWrite(NET_PRES_SKT_HANDLE_T handle, const void *buffer, uint16_t size);
+NET_PRES_SIGNAL_HANDLE NET_PRES_SocketSignalHandlerRegister(NET_PRES_SKT_HANDLE_T handle, uint16_t sigMask, NET_PRES_SIGNAL_FUNCTION handler, const void *hParam);
+bool NET_PRES_SocketSignalHandlerDeregister(NET_PRES_SKT_HANDLE_T handle, NET_PRES_SIGNAL_HANDLE hSig);
@@ -0,0 +1 @@
+/* Host build stub, see definitions.h */
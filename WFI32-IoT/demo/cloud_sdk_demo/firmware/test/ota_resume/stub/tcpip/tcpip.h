@@ -0,0 +1,17 @@
+#pragma once
+/* Host build stand-in for the Harmony TCP/IP types used by http_client.c */
+#include <stdint.h>
+#include <stdbool.h>
+typedef union { uint32_t Val; uint8_t v[4]; } IPV4_ADDR;
+typedef union { IPV4_ADDR v4Add; } IP_MULTI_ADDRESS;
+typedef enum { IP_ADDRESS_TYPE_ANY = 0, IP_ADDRESS_TYPE_IPV4 = 1 } IP_ADDRESS_TYPE;
+typedef enum { TCP_OPTION_RX_BUFF = 1 } TCP_SOCKET_OPTION;
+#define TCPIP_TCP_SIGNAL_RX_RST         0x0100
+typedef enum { TCPIP_DNS_TYPE_A = 1 } TCPIP_DNS_RESOLVE_TYPE;
+typedef enum {
+    TCPIP_DNS_RES_OK = 0, TCPIP_DNS_RES_PENDING = 1, TCPIP_DNS_RES_NAME_IS_IPADDRESS = 2,
+    TCPIP_DNS_RES_NO_NAME_ENTRY = -1
+} TCPIP_DNS_RESULT;
+TCPIP_DNS_RESULT TCPIP_DNS_Resolve(const char *hostName, TCPIP_DNS_RESOLVE_TYPE type);
+TCPIP_DNS_RESULT TCPIP_DNS_IsResolved(const char *hostName, IP_MULTI_ADDRESS *hostIP, int type);
+bool TCPIP_Helper_StringToIPAddress(const char *str, IPV4_ADDR *addr);
@@ -0,0 +1,508 @@
+/*
+ * Host benchmark for the TCP/IP packet pools (library/tcpip/src/tcpip_packet.c).
+ *
+ * usage: harness [TICKS]
+ *
+ * run.sh extracts the pool code (TCPIP_PKT_Deinitialize() to
+ * _TCPIP_PKT_BlockFree()), its types and the TCPIP_PKT_POOL_* settings from
+ * the firmware sources, so this builds the code that runs on the board.
+ *
+ * The heap is a model of the external TCP/IP heap: a 96 kB first-fit heap
+ * that coalesces on free, shared by the stack and the application. It counts
+ * the free blocks each allocation visits.
+ *
+ * The workload, in 1 ms ticks, is generated from a fixed seed, so both runs
+ * see the same one:
+ *  - MAC RX: full 1500 byte frames of the OTA download and short frames,
+ *    freed after 1 to 8 ticks;
+ *  - TCP: data packet headers held until the ACK, 20 to 80 ticks, and ACKs;
+ *  - ARP, and DNS/SNTP datagrams;
+ *  - MQTT and cJSON: bursts of 24 to 640 byte blocks, held up to 400 ms;
+ *  - wolfSSL: a reconnect every 40 s, which allocates the handshake buffers
+ *    for up to 2 s and keeps the session until the next one.
+ * A packet allocation asks for its payload plus the packet descriptor, the
+ * segment, the segment gap and the cache alignment, 160 bytes in all.
+ *
+ * It runs the workload on the heap only, then with the pools, and prints the
+ * free blocks visited per packet allocation, the smallest "largest free
+ * block" seen, the most free memory scattered outside it, and the pool
+ * fallbacks. The pools hold their blocks for good, so the largest free
+ * block is smaller with them by about their size. It fails when:
+ *  - an allocation fails, or two live allocations overlap;
+ *  - a pool block is not cache aligned or smaller than the allocation;
+ *  - with the pools, a packet allocation visits as many free blocks as without;
+ *  - a block is not back in its pool at the end;
+ *  - TCPIP_PKT_Deinitialize() does not give the pool back to its heap when
+ *    blocks are still out, or the next initialization does not take a new
+ *    pool from the new heap.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "pool_config.h"
+
+static int failures;
+
+#define FAIL(...) do { \
+        printf("FAIL: " __VA_ARGS__); \
+        printf("\n"); \
+        failures++; \
+} while (0)
+
+/* ------------------------------------------------------------------ heap */
+
+#define HEAP_SIZE       (96 * 1024)
+#define HEAP_ALIGN      16
+#define HEAP_HDR        16          /* block header: size and owner check */
+#define HEAP_EXTENTS    1024
+#define HEAP_MAGIC      0x48454150u
+
+typedef struct
+{
+    uint32_t    off;
+    uint32_t    len;
+} EXTENT;
+
+typedef struct
+{
+    uint8_t*    base;
+    EXTENT      free[HEAP_EXTENTS];     /* in address order */
+    int         nFree;
+    int         nLive;
+    uint32_t    lastVisits;             /* by the last allocation */
+} HEAP;
+
+typedef const void* TCPIP_STACK_HEAP_HANDLE;
+
+static void heapCreate(HEAP* h)
+{
+    memset(h, 0, sizeof(*h));
+    /* Low enough for the 32 bit address arithmetic of the pool code */
+    h->base = mmap(0, HEAP_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+    if (h->base == MAP_FAILED) {
+        perror("mmap");
+        exit(2);
+    }
+    h->free[0].len = HEAP_SIZE;
+    h->nFree = 1;
+}
+
+static void heapDelete(HEAP* h, const char* name)
+{
+    if (h->nLive != 0) {
+        FAIL("%s: %d blocks still allocated when the heap is deleted", name, h->nLive);
+    }
+    munmap(h->base, HEAP_SIZE);
+    h->base = 0;
+}
+
+static void* heapMalloc(TCPIP_STACK_HEAP_HANDLE heapH, size_t nBytes)
+{
+    HEAP* h = (HEAP*)heapH;
+    uint32_t len = (nBytes + HEAP_HDR + HEAP_ALIGN - 1) & ~(HEAP_ALIGN - 1);
+    int i;
+
+    h->lastVisits = 0;
+    for (i = 0; i < h->nFree; i++) {
+        h->lastVisits++;
+        if (h->free[i].len >= len) {
+            uint8_t* p = h->base + h->free[i].off;
+            h->free[i].off += len;
+            h->free[i].len -= len;
+            if (h->free[i].len == 0) {
+                memmove(&h->free[i], &h->free[i + 1], (h->nFree - i - 1) * sizeof(EXTENT));
+                h->nFree--;
+            }
+            ((uint32_t*)p)[0] = len;
+            ((uint32_t*)p)[1] = HEAP_MAGIC;
+            h->nLive++;
+            return p + HEAP_HDR;
+        }
+    }
+    return 0;
+}
+
+static void heapFree(TCPIP_STACK_HEAP_HANDLE heapH, void* ptr)
+{
+    HEAP* h = (HEAP*)heapH;
+    uint8_t* p = (uint8_t*)ptr - HEAP_HDR;
+    uint32_t off, len;
+    int i;
+
+    if (h == 0 || h->base == 0 || p < h->base || p >= h->base + HEAP_SIZE || ((uint32_t*)p)[1] != HEAP_MAGIC) {
+        FAIL("free of %p, not a block of this heap", ptr);
+        return;
+    }
+    ((uint32_t*)p)[1] = 0;
+    off = p - h->base;
+    len = ((uint32_t*)p)[0];
+    for (i = 0; i < h->nFree && h->free[i].off < off; i++) {
+    }
+    if (i > 0 && h->free[i - 1].off + h->free[i - 1].len == off) {
+        h->free[i - 1].len += len;
+        if (i < h->nFree && off + len == h->free[i].off) {
+            h->free[i - 1].len += h->free[i].len;
+            memmove(&h->free[i], &h->free[i + 1], (h->nFree - i - 1) * sizeof(EXTENT));
+            h->nFree--;
+        }
+    }
+    else if (i < h->nFree && off + len == h->free[i].off) {
+        h->free[i].off = off;
+        h->free[i].len += len;
+    }
+    else {
+        if (h->nFree == HEAP_EXTENTS) {
+            FAIL("heap model: too many free extents");
+            exit(2);
+        }
+        memmove(&h->free[i + 1], &h->free[i], (h->nFree - i) * sizeof(EXTENT));
+        h->free[i].off = off;
+        h->free[i].len = len;
+        h->nFree++;
+    }
+    h->nLive--;
+}
+
+/* The largest free block, and the free bytes outside it */
+static void heapFreeStats(const HEAP* h, uint32_t* largest, uint32_t* scattered)
+{
+    uint32_t total = 0;
+    int i;
+    *largest = 0;
+    for (i = 0; i < h->nFree; i++) {
+        total += h->free[i].len;
+        if (h->free[i].len > *largest) {
+            *largest = h->free[i].len;
+        }
+    }
+    *scattered = total - *largest;
+}
+
+/* --------------------------------------------------------- stack stand-ins */
+
+typedef int OSAL_CRITSECT_DATA_TYPE;
+#define OSAL_CRIT_TYPE_LOW              0
+#define OSAL_CRIT_Enter(type)           0
+#define OSAL_CRIT_Leave(type, status)   (void)(status)
+#define TCPIP_HEAP_Malloc               heapMalloc
+#define TCPIP_HEAP_Free                 heapFree
+#define CACHE_LINE_SIZE                 (16u)
+
+static int sysWarnings;
+#define SYS_ERROR_WARNING               2
+#define SYS_ERROR_PRINT(level, fmt, ...) (sysWarnings++, printf(fmt, ##__VA_ARGS__))
+
+#include "pool_types.h"
+#include "pool.c"
+
+/* ------------------------------------------------------------------ workload */
+
+#define PKT_OVERHEAD    160
+#define MAX_LIVE        4096
+#define TLS_PERIOD      40000
+
+typedef enum
+{
+    KIND_PACKET,
+    KIND_APP,
+    KIND_TLS_SESSION,
+} KIND;
+
+typedef struct
+{
+    uint8_t*    ptr;
+    uint32_t    size;
+    uint32_t    freeAt;
+    KIND        kind;
+    uint8_t     tag;
+} LIVE;
+
+static struct
+{
+    LIVE        live[MAX_LIVE];
+    int         nLive;
+    uint64_t    seed;
+    /* results */
+    uint32_t    pktAllocs;
+    uint64_t    pktVisits;
+    uint32_t    maxVisits;
+    uint32_t    minLargest;
+    uint32_t    maxScattered;
+    uint32_t    failed;
+} run;
+
+static HEAP runHeap;
+
+static uint32_t rnd(void)
+{
+    run.seed ^= run.seed << 13;
+    run.seed ^= run.seed >> 7;
+    run.seed ^= run.seed << 17;
+    return (uint32_t)(run.seed >> 16);
+}
+
+static uint32_t between(uint32_t lo, uint32_t hi)
+{
+    return lo + rnd() % (hi - lo + 1);
+}
+
+/* A packet block must lie in one class of the pool, cache aligned, and hold
+   the allocation */
+static void checkPoolBlock(const uint8_t* p, uint32_t size)
+{
+    int poolIx;
+    if (p < _pktPoolStart || p >= _pktPoolEnd) {
+        return;
+    }
+    if (((uintptr_t)p % CACHE_LINE_SIZE) != 0) {
+        FAIL("pool block %p not cache aligned", (const void*)p);
+    }
+    for (poolIx = 0; poolIx < TCPIP_PKT_POOL_CLASSES; poolIx++) {
+        if (p < _pktPoolTbl[poolIx].blockEnd) {
+            if (size > _pktPoolTbl[poolIx].info.blockSize) {
+                FAIL("%u bytes in a %u byte block", size, _pktPoolTbl[poolIx].info.blockSize);
+            }
+            return;
+        }
+    }
+}
+
+static void allocate(KIND kind, uint32_t size, uint32_t now, uint32_t life)
+{
+    uint8_t tag = (uint8_t)(rnd() | 1);
+    LIVE* l;
+    uint8_t* p;
+
+    if (run.nLive == MAX_LIVE) {
+        FAIL("workload: too many live blocks");
+        exit(2);
+    }
+    if (kind == KIND_PACKET) {
+        runHeap.lastVisits = 0;
+        p = _TCPIP_PKT_BlockAlloc(size, 0, __LINE__);
+        run.pktAllocs++;
+        run.pktVisits += runHeap.lastVisits;
+        if (runHeap.lastVisits > run.maxVisits) {
+            run.maxVisits = runHeap.lastVisits;
+        }
+        if (p) {
+            checkPoolBlock(p, size);
+        }
+    }
+    else {
+        p = heapMalloc(&runHeap, size);
+    }
+    if (p == 0) {
+        run.failed++;
+        return;
+    }
+    l = &run.live[run.nLive++];
+    l->ptr = p;
+    l->size = size;
+    l->freeAt = now + life;
+    l->kind = kind;
+    l->tag = tag;
+    memset(p, l->tag, size);
+}
+
+static void release(int ix)
+{
+    LIVE* l = &run.live[ix];
+    uint32_t i;
+    for (i = 0; i < l->size; i++) {
+        if (l->ptr[i] != l->tag) {
+            FAIL("block %p overwritten at %u", (void*)l->ptr, i);
+            break;
+        }
+    }
+    if (l->kind == KIND_PACKET) {
+        _TCPIP_PKT_BlockFree(l->ptr, 0);
+    }
+    else {
+        heapFree(&runHeap, l->ptr);
+    }
+    *l = run.live[--run.nLive];
+}
+
+static void tick(uint32_t now)
+{
+    uint32_t largest, scattered;
+    int i, n;
+
+    for (i = run.nLive - 1; i >= 0; i--) {
+        if (run.live[i].freeAt <= now) {
+            release(i);
+        }
+    }
+
+    /* MAC RX: the OTA download and short frames */
+    if (rnd() % 100 < 45) {
+        allocate(KIND_PACKET, PKT_OVERHEAD + 1500, now, between(1, 8));
+    }
+    if (rnd() % 100 < 20) {
+        allocate(KIND_PACKET, PKT_OVERHEAD + between(60, 200), now, between(1, 4));
+    }
+    /* TCP data headers, held until the ACK, and ACKs */
+    if (rnd() % 100 < 8) {
+        allocate(KIND_PACKET, PKT_OVERHEAD + between(54, 200), now, between(20, 80));
+    }
+    if (rnd() % 100 < 30) {
+        allocate(KIND_PACKET, PKT_OVERHEAD + 54, now, between(1, 3));
+    }
+    /* ARP, DNS and SNTP */
+    if (rnd() % 1000 < 10) {
+        allocate(KIND_PACKET, PKT_OVERHEAD + 42, now, between(1, 2));
+    }
+    if (rnd() % 1000 < 5) {
+        allocate(KIND_PACKET, PKT_OVERHEAD + between(300, 600), now, between(5, 50));
+    }
+    /* MQTT and cJSON */
+    if (rnd() % 100 < 2) {
+        for (n = between(3, 10), i = 0; i < n; i++) {
+            allocate(KIND_APP, between(24, 640), now, between(10, 400));
+        }
+    }
+    /* wolfSSL reconnect */
+    if (now % TLS_PERIOD == 1000) {
+        for (i = run.nLive - 1; i >= 0; i--) {
+            if (run.live[i].kind == KIND_TLS_SESSION) {
+                release(i);
+            }
+        }
+        for (i = 0; i < 6; i++) {
+            allocate(KIND_APP, between(512, 6144), now, between(300, 2000));
+        }
+        allocate(KIND_TLS_SESSION, 4096, now, ~now);
+        allocate(KIND_TLS_SESSION, 2048, now, ~now);
+    }
+
+    heapFreeStats(&runHeap, &largest, &scattered);
+    if (largest < run.minLargest) {
+        run.minLargest = largest;
+    }
+    if (scattered > run.maxScattered) {
+        run.maxScattered = scattered;
+    }
+}
+
+/* Runs the workload, with or without the pools */
+static void runWorkload(uint32_t ticks, bool pools)
+{
+    uint32_t now;
+
+    memset(&run, 0, sizeof(run));
+    run.seed = 0x9E3779B97F4A7C15ull;
+    run.minLargest = HEAP_SIZE;
+    heapCreate(&runHeap);
+    pktMemH = &runHeap;
+    if (pools) {
+        _TCPIP_PKT_PoolCreate(&runHeap);
+        if (_pktPoolAllocPtr == 0) {
+            FAIL("no pool");
+        }
+    }
+    for (now = 1; now <= ticks; now++) {
+        tick(now);
+    }
+    while (run.nLive) {
+        release(run.nLive - 1);
+    }
+    if (run.failed) {
+        FAIL("%s: %u allocations failed", pools ? "pools" : "heap only", run.failed);
+    }
+}
+
+static void report(const char* name)
+{
+    printf("%-10s packet allocations: %7u, free blocks visited: avg %5.2f, max %3u; "
+           "largest free block: min %5u; free bytes outside it: max %5u\n",
+           name, run.pktAllocs, (double)run.pktVisits / run.pktAllocs, run.maxVisits,
+           run.minLargest, run.maxScattered);
+}
+
+static void testWorkload(uint32_t ticks)
+{
+    static const char* className[TCPIP_PKT_POOL_CLASSES] = { "small", "tx", "rx" };
+    double heapAvg;
+    int poolIx;
+
+    runWorkload(ticks, false);
+    heapAvg = (double)run.pktVisits / run.pktAllocs;
+    report("heap only");
+    heapDelete(&runHeap, "heap only");
+
+    runWorkload(ticks, true);
+    report("pools");
+    for (poolIx = 0; poolIx < TCPIP_PKT_POOL_CLASSES; poolIx++) {
+        TCPIP_PKT_POOL_INFO info;
+        if (!TCPIP_PKT_PoolGetInfo(poolIx, &info)) {
+            FAIL("no info for class %d", poolIx);
+            continue;
+        }
+        printf("  %-5s %2u x %4u bytes: allocations %7u, fallbacks %6u, min free %u\n", className[poolIx],
+               info.nBlocks, info.blockSize, info.nAllocs, info.nFallbacks, info.minFree);
+        if (info.nFree != info.nBlocks) {
+            FAIL("class %s: %u of %u blocks back", className[poolIx], info.nFree, info.nBlocks);
+        }
+    }
+    if ((double)run.pktVisits / run.pktAllocs >= heapAvg) {
+        FAIL("pools: no fewer free blocks visited per packet allocation");
+    }
+    TCPIP_PKT_Deinitialize();
+    heapDelete(&runHeap, "pools");
+}
+
+/* The stack deletes its heap after TCPIP_PKT_Deinitialize() and creates a
+   new one at the next initialization */
+static void testDeinit(void)
+{
+    HEAP first, second;
+    void* held[3];
+    int i;
+
+    heapCreate(&first);
+    pktMemH = &first;
+    _TCPIP_PKT_PoolCreate(&first);
+    held[0] = _TCPIP_PKT_BlockAlloc(PKT_OVERHEAD + 54, 0, __LINE__);
+    held[1] = _TCPIP_PKT_BlockAlloc(PKT_OVERHEAD + 54, 0, __LINE__);
+    held[2] = _TCPIP_PKT_BlockAlloc(PKT_OVERHEAD + 1500, 0, __LINE__);
+    for (i = 0; i < 3; i++) {
+        if (held[i] == 0 || (uint8_t*)held[i] < _pktPoolStart || (uint8_t*)held[i] >= _pktPoolEnd) {
+            FAIL("deinit: block %d not from the pool", i);
+        }
+    }
+    sysWarnings = 0;
+    TCPIP_PKT_Deinitialize();
+    if (sysWarnings != 1) {
+        FAIL("deinit: %d warnings for the blocks still out, expected 1", sysWarnings);
+    }
+    heapDelete(&first, "deinit with blocks out");
+
+    heapCreate(&second);
+    pktMemH = &second;
+    _TCPIP_PKT_PoolCreate(&second);
+    if ((uint8_t*)_pktPoolAllocPtr < second.base || (uint8_t*)_pktPoolAllocPtr >= second.base + HEAP_SIZE) {
+        FAIL("reinit: the pool is not from the new heap");
+    }
+    held[0] = _TCPIP_PKT_BlockAlloc(PKT_OVERHEAD + 54, 0, __LINE__);
+    _TCPIP_PKT_BlockFree(held[0], 0);
+    sysWarnings = 0;
+    TCPIP_PKT_Deinitialize();
+    if (sysWarnings != 0) {
+        FAIL("deinit: warned with every block back");
+    }
+    heapDelete(&second, "deinit with every block back");
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t ticks = argc > 1 ? (uint32_t)strtoul(argv[1], 0, 0) : 400000;
+
+    testDeinit();
+    testWorkload(ticks);
+    printf("%d failure(s)\n", failures);
+    return failures != 0;
+}
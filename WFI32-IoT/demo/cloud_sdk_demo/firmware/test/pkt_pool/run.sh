@@ -0,0 +1,32 @@
+#!/bin/sh
+# Build the TCP/IP packet pool benchmark for the host and run it.
+#
+# usage: run.sh [TICKS]
+set -e
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+CFG=$HERE/../../src/config/aws_sdk_wfi32_iot_freertos
+TCPIP=$CFG/library/tcpip/src
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# The pool code, its types and its settings, as they are in the firmware
+grep '^#define TCPIP_PKT_POOL_' "$CFG/configuration.h" > "$WORK/pool_config.h"
+sed -n '/^\/\/ only if TCPIP_PKT_POOL_ENABLE is enabled$/,/^}TCPIP_PKT_POOL_INFO;$/p' \
+    "$TCPIP/tcpip_packet.h" > "$WORK/pool_types.h"
+{
+    grep '^#define TCPIP_SEGMENT_CACHE_ALIGN_SIZE' "$TCPIP/tcpip_packet.c"
+    sed -n '/^static TCPIP_STACK_HEAP_HANDLE    pktMemH = 0;$/,/^#endif  \/\/ (_TCPIP_PKT_POOL_ENABLE != 0)$/p' \
+        "$TCPIP/tcpip_packet.c"
+    sed -n '/^void TCPIP_PKT_Deinitialize(void)$/,/^\/\/ acknowledges a packet$/p' \
+        "$TCPIP/tcpip_packet.c" | sed '$d'
+} > "$WORK/pool.c"
+[ -s "$WORK/pool_config.h" ] || { echo "pool settings not found in configuration.h"; exit 1; }
+[ -s "$WORK/pool_types.h" ] || { echo "pool types not found in tcpip_packet.h"; exit 1; }
+grep -q '_TCPIP_PKT_BlockFree' "$WORK/pool.c" || { echo "pool code not found in tcpip_packet.c"; exit 1; }
+
+# The pool code keeps its warnings: addresses cast to 32 bits, a class
+# compared with 0, the module and line used only by the heap debug build
+CFLAGS="-g -O1 -fsanitize=address,undefined -Wall -Wextra -Werror -Wno-pointer-to-int-cast -Wno-int-to-pointer-cast -Wno-type-limits -Wno-unused-parameter -I$WORK"
+${CC:-cc} $CFLAGS "$HERE/harness.c" -o "$WORK/harness"
+"$WORK/harness" "$@"
@@ -0,0 +1,510 @@
+/*
+ * Host loopback harness for the TCP RX buffer tuning (library/tcpip/src/tcp.c).
+ *
+ * usage: harness
+ *
+ * run.sh extracts the tuning functions (_TcpRxAutoBudgetUsed() to
+ * _TcpRxAutoResize()) and the TCPIP_TCP_RX_AUTO_* settings from the firmware
+ * sources, so this builds the code that runs on the board.
+ *
+ * The model, in 1 ms steps:
+ *  - 5 sockets: the OTA download (1 MB), MQTT (100 bytes per second) and
+ *    3 listening sockets, opened the way TCPIP_TCP_ClientOpen() sizes them;
+ *  - the peer sends MSS segments over a 1.25 MB/s link and never past the
+ *    right edge of the last window it was told; data and ACKs each take
+ *    half the RTT;
+ *  - the receiver ACKs every segment, and updates the window when the
+ *    application frees at least one MSS;
+ *  - the OTA application reads 5000 bytes every 5 ms (1 MB/s), MQTT reads
+ *    everything;
+ *  - the tuning runs from the TCP tick (TCPIP_TCP_TASK_TICK_RATE, 5 ms).
+ *
+ * For an RTT of 20, 40 and 100 ms, it prints the OTA throughput and RX RAM
+ * with no tuning, and with tuning, the OTA socket set by TCP_OPTION_RX_BUFF
+ * or by TCP_OPTION_RX_BUFF_MAX. It fails when:
+ *  - the right edge of a window advertised on an established socket moves
+ *    left (RFC 1122 4.2.2.16), or the peer's data does not fit;
+ *  - tuning grows a socket past TCPIP_TCP_RX_AUTO_BUDGET;
+ *  - a socket set by TCP_OPTION_RX_BUFF changes size;
+ *  - the download does not complete.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rx_auto_config.h"
+
+typedef enum
+{
+    TCPIP_TCP_STATE_LISTEN,
+    TCPIP_TCP_STATE_SYN_SENT,
+    TCPIP_TCP_STATE_SYN_RECEIVED,
+    TCPIP_TCP_STATE_ESTABLISHED,
+    TCPIP_TCP_STATE_FIN_WAIT_1,
+    TCPIP_TCP_STATE_FIN_WAIT_2,
+    TCPIP_TCP_STATE_CLOSING,
+    TCPIP_TCP_STATE_TIME_WAIT,
+    TCPIP_TCP_STATE_CLOSE_WAIT,
+    TCPIP_TCP_STATE_LAST_ACK,
+    TCPIP_TCP_STATE_CLIENT_WAIT_DISCONNECT,
+    TCPIP_TCP_STATE_CLIENT_WAIT_CONNECT,
+    TCPIP_TCP_STATE_KILLED,
+} TCPIP_TCP_STATE;
+
+/* The TCB_STUB fields the tuning uses */
+typedef struct
+{
+    uint8_t*            rxStart;
+    uint8_t*            rxEnd;
+    uint8_t*            rxHead;
+    uint8_t*            rxTail;
+    int32_t             sHoleSize;
+    TCPIP_TCP_STATE     smState;
+    uint32_t            rxAutoBytes;
+    uint32_t            rxAutoTime;
+    uint16_t            rxAutoMax;
+    uint16_t            rxAutoTarget;
+} TCB_STUB;
+
+typedef int16_t TCP_SOCKET;
+typedef int OSAL_CRITSECT_DATA_TYPE;
+#define OSAL_CRIT_TYPE_LOW              0
+#define OSAL_CRIT_Enter(type)           0
+#define OSAL_CRIT_Leave(type, status)   (void)(status)
+#define TCPIP_HEAP_Malloc(h, size)      ((void)(h), malloc(size))
+#define TCPIP_HEAP_Free(h, ptr)         ((void)(h), free(ptr))
+#define ACK                             0x10
+#define SENDTCP_RESET_TIMERS            0x01
+#define TCP_MIN_BUFF_CHANGE             32
+
+#define N_SOCKETS       5
+#define SKT_OTA         0
+#define SKT_MQTT        1
+#define MSS             1460
+#define LINK_RATE       1250        /* bytes per ms */
+#define APP_PERIOD      5           /* ms */
+#define APP_READ        5000        /* bytes per APP_PERIOD */
+#define TCP_TICK        5           /* ms, TCPIP_TCP_TASK_TICK_RATE */
+#define OTA_SIZE        (1024 * 1024)
+#define OTA_RX_SIZE     11680       /* HTTP_TCP_RX_WINDOW_SIZE */
+#define MQTT_RATE       100         /* bytes per second */
+#define IDLE_TIME       3000        /* ms measured after the download */
+#define SIM_LIMIT       60000       /* ms */
+#define QUEUE_SIZE      4096
+#define RTO_MIN         200         /* ms */
+
+static TCB_STUB* TCBStubs[N_SOCKETS];
+static unsigned int TcpSockets = N_SOCKETS;
+static uint16_t tcpDefRxSize = 1460;
+static uint32_t sysTickFreq = 1000;
+static uint32_t tcpRxAutoTime;
+static int tcpHeapH;
+static uint32_t now;
+
+static uint32_t SYS_TMR_TickCountGet(void)
+{
+    return now;
+}
+
+static int _TcpSend(TCB_STUB* pSkt, uint8_t vTCPFlags, uint8_t vSendFlags);
+static bool _TcpRxAutoResize(TCB_STUB* pSkt, uint16_t rxSize);
+
+#include "rx_auto.c"
+
+/* Network model ***************************************************************/
+
+typedef struct
+{
+    uint32_t at;        /* arrival time */
+    int skt;
+    uint32_t seq;       /* data: first byte; ACK: acknowledged byte */
+    uint32_t len;       /* data: length; ACK: window */
+} EVENT;
+
+typedef struct
+{
+    EVENT ev[QUEUE_SIZE];
+    uint32_t head, tail;
+} QUEUE;
+
+typedef struct
+{
+    /* receiver */
+    uint32_t used;          /* bytes in the RX FIFO */
+    uint32_t rcvNxt;
+    uint32_t rightEdge;     /* rcvNxt + window of the last ACK */
+    uint32_t lastWnd;
+    uint32_t read;          /* bytes read by the application */
+    /* peer */
+    uint32_t toSend;
+    uint32_t sndNxt, sndUna, sndRight;
+    uint32_t inFlight;
+    uint32_t ackTime;       /* when sndUna last moved */
+} SIM;
+
+static QUEUE dataQ, ackQ;
+static SIM sim[N_SOCKETS];
+static uint32_t halfRtt;
+static uint32_t failures;
+
+#define FAIL(...) do { fprintf(stderr, __VA_ARGS__); failures++; } while (0)
+
+static void queuePut(QUEUE* q, int skt, uint32_t seq, uint32_t len)
+{
+    EVENT* e;
+
+    if(q->head - q->tail == QUEUE_SIZE)
+    {
+        fprintf(stderr, "event queue full\n");
+        exit(2);
+    }
+    e = &q->ev[q->head++ % QUEUE_SIZE];
+    e->at = now + halfRtt;
+    e->skt = skt;
+    e->seq = seq;
+    e->len = len;
+}
+
+static EVENT* queueGet(QUEUE* q)
+{
+    if(q->head == q->tail || q->ev[q->tail % QUEUE_SIZE].at > now)
+    {
+        return 0;
+    }
+    return &q->ev[q->tail++ % QUEUE_SIZE];
+}
+
+static uint32_t rxSize(int skt)
+{
+    return TCBStubs[skt]->rxEnd - TCBStubs[skt]->rxStart;
+}
+
+static uint32_t rxFree(int skt)
+{
+    return rxSize(skt) - sim[skt].used;
+}
+
+static void sendAck(int skt)
+{
+    sim[skt].lastWnd = rxFree(skt);
+    sim[skt].rightEdge = sim[skt].rcvNxt + sim[skt].lastWnd;
+    queuePut(&ackQ, skt, sim[skt].rcvNxt, sim[skt].lastWnd);
+}
+
+static int _TcpSend(TCB_STUB* pSkt, uint8_t vTCPFlags, uint8_t vSendFlags)
+{
+    int skt;
+
+    (void)vTCPFlags;
+    (void)vSendFlags;
+    for(skt = 0; skt < N_SOCKETS; skt++)
+    {
+        if(TCBStubs[skt] == pSkt)
+        {
+            sendAck(skt);
+        }
+    }
+    return 0;
+}
+
+/* The FIFO content is not modelled; head != tail just means "not empty" */
+static void fifoSet(int skt)
+{
+    TCB_STUB* pSkt = TCBStubs[skt];
+
+    pSkt->rxTail = pSkt->rxStart;
+    pSkt->rxHead = pSkt->rxStart + (sim[skt].used ? 1 : 0);
+}
+
+static void socketOpen(int skt, TCPIP_TCP_STATE state, uint16_t size)
+{
+    TCB_STUB* pSkt = calloc(1, sizeof(*pSkt));
+
+    pSkt->rxStart = malloc(size + 1);
+    pSkt->rxEnd = pSkt->rxStart + size;
+    pSkt->sHoleSize = -1;
+    pSkt->smState = state;
+    pSkt->rxAutoMax = TCPIP_TCP_RX_AUTO_MAX_SIZE;
+    TCBStubs[skt] = pSkt;
+    memset(&sim[skt], 0, sizeof(sim[skt]));
+    fifoSet(skt);
+    if(state == TCPIP_TCP_STATE_ESTABLISHED)
+    {
+        sendAck(skt);
+    }
+}
+
+static void socketClose(int skt)
+{
+    free(TCBStubs[skt]->rxStart);
+    free(TCBStubs[skt]);
+    TCBStubs[skt] = 0;
+}
+
+/* TCPIP_TCP_FifoSizeAdjust() on an empty socket, for TCP_OPTION_RX_BUFF */
+static void socketRxBuffSet(int skt, uint16_t size)
+{
+    TCB_STUB* pSkt = TCBStubs[skt];
+
+    free(pSkt->rxStart);
+    pSkt->rxStart = malloc(size + 1);
+    pSkt->rxEnd = pSkt->rxStart + size;
+    fifoSet(skt);
+    sendAck(skt);
+}
+
+static uint32_t rxRam(void)
+{
+    uint32_t skt, total = 0;
+
+    for(skt = 0; skt < N_SOCKETS; skt++)
+    {
+        if(TCBStubs[skt])
+        {
+            total += rxSize(skt);
+        }
+    }
+    return total;
+}
+
+/* One step ********************************************************************/
+
+static void receive(void)
+{
+    EVENT* e;
+    SIM* s;
+    uint32_t n;
+
+    while((e = queueGet(&dataQ)) != 0)
+    {
+        s = &sim[e->skt];
+        s->inFlight--;
+        if(TCBStubs[e->skt] == 0 || e->seq != s->rcvNxt)
+        {   // after a drop; the peer goes back
+            continue;
+        }
+        n = e->len <= rxFree(e->skt) ? e->len : rxFree(e->skt);
+        if(n < e->len)
+        {
+            FAIL("socket %d: %u bytes inside the advertised window dropped\n", e->skt, e->len - n);
+        }
+        s->used += n;
+        s->rcvNxt += n;
+        TCBStubs[e->skt]->rxAutoBytes += n;
+        TCBStubs[e->skt]->rxAutoTime = now;
+        fifoSet(e->skt);
+        sendAck(e->skt);
+    }
+
+    while((e = queueGet(&ackQ)) != 0)
+    {
+        s = &sim[e->skt];
+        if(e->seq > s->sndUna)
+        {
+            s->sndUna = e->seq;
+            s->ackTime = now;
+        }
+        s->sndRight = e->seq + e->len;
+    }
+}
+
+static void peerSend(uint32_t* pLink)
+{
+    int skt;
+    SIM* s;
+    uint32_t len;
+
+    for(skt = 0; skt < N_SOCKETS; skt++)
+    {
+        s = &sim[skt];
+        if(s->sndUna < s->sndNxt && s->inFlight == 0 && now - s->ackTime > RTO_MIN + 2 * halfRtt)
+        {   // lost data; retransmit
+            s->sndNxt = s->sndUna;
+            s->ackTime = now;
+        }
+        while(TCBStubs[skt] && s->sndNxt < s->toSend && s->sndNxt < s->sndRight)
+        {
+            len = s->toSend - s->sndNxt;
+            if(len > MSS)
+            {
+                len = MSS;
+            }
+            if(len > s->sndRight - s->sndNxt)
+            {
+                len = s->sndRight - s->sndNxt;
+            }
+            if(*pLink < len)
+            {
+                return;
+            }
+            *pLink -= len;
+            queuePut(&dataQ, skt, s->sndNxt, len);
+            s->sndNxt += len;
+            s->inFlight++;
+        }
+    }
+}
+
+static void appRead(int skt, uint32_t max)
+{
+    SIM* s = &sim[skt];
+    uint32_t n = s->used < max ? s->used : max;
+
+    s->used -= n;
+    s->read += n;
+    fifoSet(skt);
+    if(n && rxFree(skt) >= s->lastWnd + MSS)
+    {   // window update
+        sendAck(skt);
+    }
+}
+
+/* Right edge and budget checks after the tuning ran */
+static void check(uint32_t ramBefore, const uint32_t* pinned)
+{
+    int skt;
+    uint32_t ram = rxRam();
+
+    for(skt = 0; skt < N_SOCKETS; skt++)
+    {
+        if(TCBStubs[skt] == 0)
+        {
+            continue;
+        }
+        if(TCBStubs[skt]->smState == TCPIP_TCP_STATE_ESTABLISHED
+                && sim[skt].rcvNxt + rxFree(skt) < sim[skt].rightEdge)
+        {
+            FAIL("socket %d: advertised window shrunk by %u bytes at %u ms\n", skt,
+                    sim[skt].rightEdge - sim[skt].rcvNxt - rxFree(skt), now);
+            sim[skt].rightEdge = sim[skt].rcvNxt + rxFree(skt);
+        }
+        if(pinned[skt] && rxSize(skt) != pinned[skt])
+        {
+            FAIL("socket %d: TCP_OPTION_RX_BUFF size %u changed to %u\n", skt, pinned[skt], rxSize(skt));
+        }
+    }
+    if(ram > ramBefore && ram > TCPIP_TCP_RX_AUTO_BUDGET)
+    {
+        FAIL("RX buffers grew to %u bytes, over the %u byte budget\n", ram, TCPIP_TCP_RX_AUTO_BUDGET);
+    }
+}
+
+/* Runs one download; returns the throughput in kB/s */
+typedef enum
+{
+    MODE_NO_TUNING,
+    MODE_RX_BUFF,
+    MODE_RX_BUFF_MAX,
+} MODE;
+
+static uint32_t run(MODE mode, uint32_t rtt, uint32_t* pPeakRam, uint32_t* pIdleRam)
+{
+    bool tune = mode != MODE_NO_TUNING;
+    uint32_t pinned[N_SOCKETS] = { 0 };
+    uint32_t link = 0, done = 0, ram, skt;
+
+    memset(&dataQ, 0, sizeof(dataQ));
+    memset(&ackQ, 0, sizeof(ackQ));
+    halfRtt = rtt / 2;
+    now = 0;
+    tcpRxAutoTime = 0;
+
+    socketOpen(SKT_OTA, TCPIP_TCP_STATE_ESTABLISHED, tune ? _TcpRxAutoOpenSize() : tcpDefRxSize);
+    socketOpen(SKT_MQTT, TCPIP_TCP_STATE_ESTABLISHED, tune ? _TcpRxAutoOpenSize() : tcpDefRxSize);
+    for(skt = SKT_MQTT + 1; skt < N_SOCKETS; skt++)
+    {
+        socketOpen(skt, TCPIP_TCP_STATE_LISTEN, tune ? _TcpRxAutoOpenSize() : tcpDefRxSize);
+    }
+    if(mode == MODE_RX_BUFF_MAX)
+    {   // TCPIP_TCP_OptionsSet(TCP_OPTION_RX_BUFF_MAX)
+        TCBStubs[SKT_OTA]->rxAutoMax = OTA_RX_SIZE;
+    }
+    else
+    {   // TCPIP_TCP_OptionsSet(TCP_OPTION_RX_BUFF), as the HTTP client does
+        TCBStubs[SKT_OTA]->rxAutoMax = 0;
+        TCBStubs[SKT_OTA]->rxAutoTarget = 0;
+        socketRxBuffSet(SKT_OTA, OTA_RX_SIZE);
+        pinned[SKT_OTA] = OTA_RX_SIZE;
+    }
+    sim[SKT_OTA].toSend = OTA_SIZE;
+    *pPeakRam = 0;
+
+    for(now = 1; now < SIM_LIMIT; now++)
+    {
+        link += LINK_RATE;
+        if(link > 2 * MSS)
+        {
+            link = 2 * MSS;
+        }
+        if(now % 1000 == 0)
+        {
+            sim[SKT_MQTT].toSend += MQTT_RATE;
+        }
+        receive();
+        peerSend(&link);
+        if(now % APP_PERIOD == 0)
+        {
+            if(TCBStubs[SKT_OTA])
+            {
+                appRead(SKT_OTA, APP_READ);
+            }
+            appRead(SKT_MQTT, UINT32_MAX);
+        }
+        if(tune && now % TCP_TICK == 0)
+        {
+            ram = rxRam();
+            _TcpRxAutoTune();
+            check(ram, pinned);
+        }
+        ram = rxRam();
+        if(ram > *pPeakRam)
+        {
+            *pPeakRam = ram;
+        }
+        if(!done && sim[SKT_OTA].read == OTA_SIZE)
+        {   // the OTA client closes its socket
+            done = now;
+            socketClose(SKT_OTA);
+            pinned[SKT_OTA] = 0;
+        }
+        if(done && now == done + IDLE_TIME)
+        {
+            break;
+        }
+    }
+    *pIdleRam = rxRam();
+    for(skt = 0; skt < N_SOCKETS; skt++)
+    {
+        if(TCBStubs[skt])
+        {
+            socketClose(skt);
+        }
+    }
+
+    if(!done)
+    {
+        FAIL("download incomplete after %u ms\n", SIM_LIMIT);
+        return 0;
+    }
+    return (uint32_t)((uint64_t)OTA_SIZE * 1000 / 1024 / done);
+}
+
+int main(void)
+{
+    static const uint32_t rtts[] = { 20, 40, 100 };
+    static const char* const modes[] = { "no tuning", "RX_BUFF", "RX_BUFF_MAX" };
+    uint32_t i, m, kbps, peak, idle;
+
+    printf("RTT   mode          OTA kB/s   peak RX   idle RX\n");
+    for(i = 0; i < sizeof(rtts) / sizeof(rtts[0]); i++)
+    {
+        for(m = MODE_NO_TUNING; m <= MODE_RX_BUFF_MAX; m++)
+        {
+            kbps = run((MODE)m, rtts[i], &peak, &idle);
+            printf("%-5u %-13s %8u %9u %9u\n", rtts[i], modes[m], kbps, peak, idle);
+        }
+    }
+    printf("%u failure(s)\n", failures);
+    return failures ? 1 : 0;
+}
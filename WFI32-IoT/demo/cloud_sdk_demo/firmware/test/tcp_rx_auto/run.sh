@@ -0,0 +1,21 @@
+#!/bin/sh
+# Build the TCP RX buffer tuning harness for the host and run it.
+#
+# usage: run.sh
+set -e
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+CFG=$HERE/../../src/config/aws_sdk_wfi32_iot_freertos
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# The tuning functions and their settings, as they are in the firmware
+grep '^#define TCPIP_TCP_RX_AUTO_' "$CFG/configuration.h" > "$WORK/rx_auto_config.h"
+sed -n '/^\/\/ RX memory the sockets hold/,/^#endif  \/\/ (TCPIP_TCP_RX_AUTO_TUNE != 0)$/p' \
+    "$CFG/library/tcpip/src/tcp.c" | sed '$d' > "$WORK/rx_auto.c"
+[ -s "$WORK/rx_auto.c" ] || { echo "tuning code not found in tcp.c"; exit 1; }
+
+# tcp.c compares TCP_SOCKET indexes with unsigned counts throughout
+CFLAGS="-g -fsanitize=address,undefined -Wall -Wextra -Werror -Wno-sign-compare -I$WORK"
+${CC:-cc} $CFLAGS "$HERE/harness.c" -o "$WORK/harness"
+"$WORK/harness"
@@ -0,0 +1,271 @@
+/*
+ * Host harness for the telemetry batch encodings of src/app_telemetry.c:
+ * text JSON against CBOR, written with the bundled tinycbor.
+ *
+ * usage: harness ITERATIONS
+ *
+ * Samples are generated from a fixed seed: one a second with some jitter,
+ * an hour after boot, the temperature wandering between -10 and 45 C and
+ * the light between 0 and 4000 lux. For every batch of 1 to the ring size,
+ * pushed through APP_TELEMETRY_Push(), it fails when:
+ *  - batchLength() is not the length APP_TELEMETRY_Write() then writes, in
+ *    either format, or the batch does not take all samples;
+ *  - the CBOR batch, converted to JSON by tinycbor, is not the JSON batch;
+ *  - with a buffer of any smaller size, the encoder writes past it, does not
+ *    take as many samples as fit, or writes a batch that is not the one of
+ *    the samples it took;
+ *  - APP_TELEMETRY_Encode(), as used for the journal replay, writes another
+ *    batch than APP_TELEMETRY_Write() for the same samples.
+ *
+ * With ITERATIONS above 0 it then prints, per batch size, the payload and
+ * the bytes sent with APP_TELEMETRY_BATCH_OVERHEAD_BYTES per PUBLISH for
+ * single samples, JSON and CBOR, and the time to encode a batch in each
+ * format on this host. It fails when a CBOR batch is not smaller than the
+ * JSON one.
+ */
+#include <stdlib.h>
+#include <time.h>
+
+#include "app_telemetry.c"
+#include "cborjson.h"
+#include "single.h"
+
+static int failures;
+
+#define FAIL(...) do { \
+        printf("FAIL: " __VA_ARGS__); \
+        printf("\n"); \
+        failures++; \
+} while (0)
+
+#define SAMPLES         4096
+
+static APP_TELEMETRY_SAMPLE samples[SAMPLES];
+static uint32_t clockMs;
+static uint32_t seed = 0x1F2E3D4C;
+
+uint64_t SYS_TIME_Counter64Get(void)
+{
+    return clockMs;
+}
+
+uint32_t SYS_TIME_FrequencyGet(void)
+{
+    return 1000;
+}
+
+static uint32_t rnd(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static void generate(void)
+{
+    uint32_t t = 3600000;
+    int32_t temperature = 24;
+    int32_t light = 300;
+    uint32_t i;
+
+    for (i = 0; i < SAMPLES; i++) {
+        t += 980 + rnd() % 41;
+        temperature += (int32_t)(rnd() % 3) - 1;
+        temperature = temperature < -10 ? -10 : temperature > 45 ? 45 : temperature;
+        light += (int32_t)(rnd() % 201) - 100;
+        light = light < 0 ? 0 : light > 4000 ? 4000 : light;
+        samples[i].timeMs = t;
+        samples[i].temperature = (int16_t)temperature;
+        samples[i].light = (uint32_t)light;
+    }
+}
+
+/* Empties the ring and queues COUNT samples from FIRST on, at their times.
+   This also sets the format back to its default. */
+static void queue(uint32_t first, uint32_t count)
+{
+    uint32_t i;
+
+    APP_TELEMETRY_Initialize();
+    for (i = 0; i < count; i++) {
+        clockMs = samples[first + i].timeMs;
+        APP_TELEMETRY_Push(samples[first + i].temperature, samples[first + i].light);
+    }
+}
+
+/* The JSON batch of COUNT samples from FIRST on, NUL terminated */
+static size_t jsonOf(uint32_t first, uint32_t count, char* pBuffer, size_t bufferSize)
+{
+    APP_TELEMETRY_FORMAT saved = format;
+    uint32_t taken;
+    size_t len;
+
+    format = APP_TELEMETRY_FORMAT_JSON;
+    len = APP_TELEMETRY_Encode(pBuffer, bufferSize - 1, &samples[first], count, &taken);
+    format = saved;
+    if (len >= bufferSize || taken != count) {
+        return 0;
+    }
+    pBuffer[len] = '\0';
+    return len;
+}
+
+/* The CBOR batch as JSON text, converted by tinycbor */
+static bool cborToJson(const uint8_t* pBatch, size_t len, char* pBuffer, size_t bufferSize)
+{
+    CborParser parser;
+    CborValue value;
+    FILE* f = fmemopen(pBuffer, bufferSize, "w");
+    bool ok;
+
+    if (f == NULL) {
+        return false;
+    }
+    ok = cbor_parser_init(pBatch, len, 0, &parser, &value) == CborNoError
+         && cbor_value_to_json_advance(f, &value, 0) == CborNoError
+         && cbor_value_at_end(&value);
+    ok = fputc('\0', f) != EOF && ok;
+    fclose(f);
+    return ok;
+}
+
+/* Checks a batch of COUNT samples from FIRST on, in the current format, for
+   every buffer size up to the one it needs */
+static void checkBatch(uint32_t first, uint32_t count, APP_TELEMETRY_FORMAT newFormat)
+{
+    static char json[8192], converted[8192], encoded[8192];
+    const char* name = newFormat == APP_TELEMETRY_FORMAT_CBOR ? "CBOR" : "JSON";
+    size_t predicted, len, size;
+    uint32_t taken;
+    char* buffer;
+
+    queue(first, count);
+    APP_TELEMETRY_FormatSet(newFormat);
+    predicted = batchLength(count);
+    for (size = 0; size <= predicted; size++) {
+        buffer = malloc(size ? size : 1);
+        len = APP_TELEMETRY_Write(buffer, size, &taken);
+        if (len == size + 1) {
+            if (taken != 0 || batchLength(1) <= size) {
+                FAIL("%s %u samples, %zu bytes: nothing written, though %zu bytes take a sample",
+                     name, count, size, batchLength(1));
+            }
+        }
+        else if (len > size || taken == 0 || taken > count) {
+            FAIL("%s %u samples, %zu bytes: %zu bytes and %u samples written", name, count, size, len, taken);
+        }
+        else if (len != batchLength(taken) || (taken < count && batchLength(taken + 1) <= size)) {
+            FAIL("%s %u samples, %zu bytes: %u samples in %zu bytes, batchLength() %zu, %zu with one more",
+                 name, count, size, taken, len, batchLength(taken), batchLength(taken + 1));
+        }
+        else if (jsonOf(first, taken, json, sizeof(json)) == 0) {
+            FAIL("%s %u samples: no JSON batch", name, taken);
+        }
+        else if (format == APP_TELEMETRY_FORMAT_CBOR) {
+            if (!cborToJson((const uint8_t*)buffer, len, converted, sizeof(converted))
+                    || strcmp(converted, json) != 0) {
+                FAIL("CBOR %u samples: %s as JSON, the JSON batch is %s", taken, converted, json);
+            }
+        }
+        else if (len != strlen(json) || memcmp(buffer, json, len) != 0) {
+            FAIL("JSON %u samples: %.*s, replayed %s", taken, (int)len, buffer, json);
+        }
+        if (size == predicted) {
+            if (len != predicted || taken != count) {
+                FAIL("%s %u samples: %zu bytes and %u samples written, batchLength() %zu",
+                     name, count, len, taken, predicted);
+            }
+            else if (APP_TELEMETRY_Encode(encoded, sizeof(encoded), &samples[first], count, &taken) != len
+                     || memcmp(encoded, buffer, len) != 0) {
+                FAIL("%s %u samples: the replayed batch differs", name, count);
+            }
+        }
+        free(buffer);
+    }
+}
+
+static void check(void)
+{
+    uint32_t count, first = 0;
+
+    for (count = 1; count <= APP_TELEMETRY_RING_SIZE; count++) {
+        checkBatch(first, count, APP_TELEMETRY_FORMAT_JSON);
+        checkBatch(first, count, APP_TELEMETRY_FORMAT_CBOR);
+        first = (first + 97) % (SAMPLES - APP_TELEMETRY_RING_SIZE);
+    }
+    printf("batches of 1 to %u samples checked in JSON and CBOR, for every buffer size\n",
+           APP_TELEMETRY_RING_SIZE);
+}
+
+/* ---------------------------------------------------------------- benchmark */
+
+static double seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Average payload of batches of COUNT, and the time to encode one */
+static double measure(APP_TELEMETRY_FORMAT newFormat, uint32_t count, int iterations, double* pTime)
+{
+    static char buffer[8192];
+    uint64_t bytes = 0;
+    uint32_t taken, first;
+    double t;
+    int n;
+
+    APP_TELEMETRY_FormatSet(newFormat);
+    t = seconds();
+    for (n = 0; n < iterations; n++) {
+        first = (uint32_t)n * 31 % (SAMPLES - count);
+        bytes += APP_TELEMETRY_Encode(buffer, sizeof(buffer), &samples[first], count, &taken);
+    }
+    *pTime = (seconds() - t) / iterations;
+    return (double)bytes / iterations;
+}
+
+static void benchmark(int iterations)
+{
+    static const uint32_t counts[] = { 1, 4, 8, 16, 32, 64 };
+    char buffer[128];
+    double single = 0, json, cbor, jsonTime, cborTime;
+    unsigned i;
+
+    for (i = 0; i < SAMPLES; i++) {
+        single += snprintf(buffer, sizeof(buffer), APP_AWS_TELEMETRY_MSG_TEMPLATE,
+                           samples[i].temperature, (int)samples[i].light);
+    }
+    single /= SAMPLES;
+    printf("single sample payload %.1f bytes, %.1f sent with the PUBLISH overhead\n",
+           single, single + APP_TELEMETRY_BATCH_OVERHEAD_BYTES);
+    printf("samples   payload JSON  CBOR   sent: single    JSON    CBOR   bytes/sample: JSON  CBOR   encode ns: JSON   CBOR\n");
+    for (i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        uint32_t n = counts[i];
+        json = measure(APP_TELEMETRY_FORMAT_JSON, n, iterations, &jsonTime);
+        cbor = measure(APP_TELEMETRY_FORMAT_CBOR, n, iterations, &cborTime);
+        printf("%7u   %12.1f %5.1f   %12.0f %7.0f %7.0f   %18.1f %5.1f   %15.0f %6.0f\n", n, json, cbor,
+               n * (single + APP_TELEMETRY_BATCH_OVERHEAD_BYTES),
+               json + APP_TELEMETRY_BATCH_OVERHEAD_BYTES, cbor + APP_TELEMETRY_BATCH_OVERHEAD_BYTES,
+               json / n, cbor / n, jsonTime * 1e9, cborTime * 1e9);
+        if (cbor >= json) {
+            FAIL("%u samples: CBOR is not smaller", n);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 0;
+
+    generate();
+    if (iterations == 0) {
+        check();
+    }
+    else {
+        benchmark(iterations);
+    }
+    printf("%d failure(s)\n", failures);
+    return failures != 0;
+}
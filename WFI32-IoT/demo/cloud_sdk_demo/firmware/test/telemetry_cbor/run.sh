@@ -0,0 +1,34 @@
+#!/bin/sh
+# Build the telemetry encoding harness for the host, check the JSON and CBOR
+# batches of app_telemetry.c under ASan/UBSan, then compare their size and
+# encoding time.
+#
+# usage: run.sh [ITERATIONS]
+set -e
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+SRC=$HERE/../../src
+CBOR=$SRC/third_party/aws/libraries/cbor
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# The single-sample payload of app_aws.h, without the rest of that header
+grep '#define APP_AWS_TELEMETRY_MSG_TEMPLATE' "$SRC/app_aws.h" > "$WORK/single.h"
+[ -s "$WORK/single.h" ] || { echo "APP_AWS_TELEMETRY_MSG_TEMPLATE not found in app_aws.h"; exit 1; }
+
+build()
+{
+    for f in cborencoder cborparser cborparser_dup_string cbortojson cborpretty cborpretty_stdio cborerrorstrings; do
+        ${CC:-cc} $1 -w -I"$CBOR" -c "$CBOR/$f.c" -o "$WORK/$f.o"
+    done
+    ${CC:-cc} $1 -Wall -Wextra -Werror -I"$HERE/stub" -I"$SRC" -I"$CBOR" -I"$WORK" \
+        -c "$HERE/harness.c" -o "$WORK/harness.o"
+    ${CC:-cc} $1 "$WORK"/*.o -o "$2"
+}
+
+build "-g -O1 -fsanitize=address,undefined" "$WORK/check"
+rm -f "$WORK"/*.o
+build "-O2" "$WORK/bench"
+
+"$WORK/check" 0
+"$WORK/bench" "${1:-20000}"
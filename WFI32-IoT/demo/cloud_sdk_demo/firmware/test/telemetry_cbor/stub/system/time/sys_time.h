@@ -0,0 +1,6 @@
+#pragma once
+/* Host build stand-in for the Harmony timer service: harness.c sets the time */
+#include <stdint.h>
+
+uint64_t SYS_TIME_Counter64Get(void);
+uint32_t SYS_TIME_FrequencyGet(void);
@@ -6,9 +6,53 @@
 # Accepts a PEM encoded key and a data file and generates a signature. 
 # The signature is the raw 64 bytes (r|s) in base64 encoded format. It is not ASN.1 encoded (DER/PEM)
 # If a signature is provided, the tool verifies the signature. 
+# A compressed OTA image (hex2bin -c) is signed / verified over the raw image it holds,
+# which is what the device hashes after decompressing it.
 # A web version of this tool writen using webcrypto APIs can be found at https://vppillai.github.io/cryptoScript/FileSigner.html
 
 
+def unpack_ota_image(data):
+    import struct
+    # Compressed OTA container, see ota_lz.h
+    if len(data) < 16 or data[0:4] != b'OTAZ' or data[4] != 1:
+        return data
+    window_bits = data[5]
+    raw_len, packed_len = struct.unpack('<II', data[8:16])
+    stream = data[16:16 + packed_len]
+    out = bytearray()
+    p = 0
+
+    def get_length(n):
+        nonlocal p
+        if n == 15:
+            while True:
+                b = stream[p]
+                p += 1
+                n += b
+                if b != 255:
+                    break
+        return n
+
+    while len(out) < raw_len:
+        token = stream[p]
+        p += 1
+        lit_n = get_length(token >> 4)
+        out += stream[p:p + lit_n]
+        p += lit_n
+        if len(out) >= raw_len:
+            break
+        offset = stream[p] | (stream[p + 1] << 8)
+        p += 2
+        match_len = get_length(token & 0x0F) + 4
+        if offset == 0 or offset > (1 << window_bits) or offset > len(out):
+            raise ValueError('corrupt compressed OTA image')
+        src = out[len(out) - offset:]
+        out += (src * (match_len // offset + 1))[:match_len]
+    if len(out) != raw_len:
+        raise ValueError('corrupt compressed OTA image')
+    return bytes(out)
+
+
 def main():
     import base64
     import ecdsa
@@ -27,7 +71,7 @@ def main():
     args = parser.parse_args()
 
     with open(args.file, 'rb') as f:
-        data = f.read()
+        data = unpack_ota_image(f.read())
 
     with open(args.key, 'r') as f:
         key = f.read()
@@ -37,6 +37,138 @@ def strtoul(str, base):
     return int(str, base)
 
 
+# Compressed OTA container, decompressed on the fly by the OTA downloader and
+# the bootloader (see ota_lz.h for the format)
+LZ_MAGIC = b'OTAZ'
+LZ_VERSION = 1
+LZ_MIN_MATCH = 4
+LZ_HEADER_SIZE = 16
+
+
+def lz_put_length(out, n):
+    while n >= 255:
+        out.append(255)
+        n -= 255
+    out.append(n)
+
+
+def lz_put_sequence(out, literals, match_len, offset):
+    lit_n = len(literals)
+    m = match_len - LZ_MIN_MATCH if match_len else 0
+    out.append((min(lit_n, 15) << 4) | min(m, 15))
+    if lit_n >= 15:
+        lz_put_length(out, lit_n - 15)
+    out += literals
+    if match_len:
+        out += struct.pack('<H', offset)
+        if m >= 15:
+            lz_put_length(out, m - 15)
+
+
+def lz_match_len(data, a, b, limit):
+    l = 0
+    while l + 64 <= limit and data[a+l:a+l+64] == data[b+l:b+l+64]:
+        l += 64
+    while l < limit and data[a+l] == data[b+l]:
+        l += 1
+    return l
+
+
+def lz_compress(data, window_bits=12, max_chain=32):
+    window = 1 << window_bits
+    n = len(data)
+    head = {}
+    chain = [-1] * n
+    out = bytearray()
+    inserted = 0
+
+    def insert_upto(end):
+        nonlocal inserted
+        end = min(end, n - LZ_MIN_MATCH + 1)
+        while inserted < end:
+            key = data[inserted:inserted + LZ_MIN_MATCH]
+            chain[inserted] = head.get(key, -1)
+            head[key] = inserted
+            inserted += 1
+
+    def find(i):
+        best_len, best_off = 0, 0
+        if i + LZ_MIN_MATCH > n:
+            return best_len, best_off
+        insert_upto(i)
+        c = head.get(data[i:i + LZ_MIN_MATCH], -1)
+        depth = 0
+        while c >= 0 and i - c <= window and depth < max_chain:
+            l = lz_match_len(data, c, i, n - i)
+            if l > best_len:
+                best_len, best_off = l, i - c
+                if i + l == n:
+                    break
+            c = chain[c]
+            depth += 1
+        return best_len, best_off
+
+    i = 0
+    anchor = 0
+    while i < n:
+        l, off = find(i)
+        if l < LZ_MIN_MATCH:
+            i += 1
+            continue
+        # Lazy evaluation: prefer a clearly longer match one byte later
+        if i + 1 < n:
+            l2, off2 = find(i + 1)
+            if l2 > l + 1:
+                i += 1
+                l, off = l2, off2
+        lz_put_sequence(out, data[anchor:i], l, off)
+        i += l
+        anchor = i
+    if anchor < n:
+        lz_put_sequence(out, data[anchor:n], 0, 0)
+
+    return LZ_MAGIC + struct.pack('<BBHII', LZ_VERSION, window_bits, 0, n, len(out)) + out
+
+
+def lz_decompress(blob):
+    magic, version, window_bits, rsvd, raw_len, packed_len = struct.unpack('<4sBBHII', blob[0:LZ_HEADER_SIZE])
+    if magic != LZ_MAGIC or version != LZ_VERSION:
+        raise ValueError("not a compressed OTA image")
+    data = blob[LZ_HEADER_SIZE:LZ_HEADER_SIZE + packed_len]
+    out = bytearray()
+    p = 0
+
+    def get_length(n):
+        nonlocal p
+        if n == 15:
+            while True:
+                b = data[p]
+                p += 1
+                n += b
+                if b != 255:
+                    break
+        return n
+
+    while len(out) < raw_len:
+        token = data[p]
+        p += 1
+        lit_n = get_length(token >> 4)
+        out += data[p:p + lit_n]
+        p += lit_n
+        if len(out) >= raw_len:
+            break
+        offset = data[p] | (data[p + 1] << 8)
+        p += 2
+        match_len = get_length(token & 0x0F) + LZ_MIN_MATCH
+        if offset == 0 or offset > (1 << window_bits) or offset > len(out):
+            raise ValueError("corrupt compressed OTA image")
+        src = out[len(out) - offset:]
+        out += (src * (match_len // offset + 1))[:match_len]
+    if len(out) != raw_len:
+        raise ValueError("corrupt compressed OTA image")
+    return out
+
+
 class INTEL_HEX(object):
 
     RECORD_TYPE_DATA = 0x00
@@ -170,7 +302,7 @@ def find_file(pattern, path):
 
 if __name__ == "__main__":
     init(autoreset=True)
-    print(Fore.GREEN+"hex2bin V1.2")
+    print(Fore.GREEN+"hex2bin V1.3")
     parser = argparse.ArgumentParser(
         description="Tool to convert hex file into an OTA bin file for WFI32", prog="hex2bin")
     parser.add_argument('-i', '--input-hex', dest='production_hex', action='store', metavar='',
@@ -183,6 +315,10 @@ if __name__ == "__main__":
                         metavar='', help='Start address of application image in hex', default="0x01")                    
     parser.add_argument('-o', '--output-bin', dest='production_bin',
                         action='store', metavar='', help='Location of the output ota bin file')
+    parser.add_argument('-c', '--compress', dest='compress', action='store_true',
+                        help='Also generate a compressed OTA image (<output>_lz.bin)')
+    parser.add_argument('-w', '--window-bits', dest='window_bits', action='store', metavar='',
+                        help='Compression window, log2 bytes (max 12 for the shipped bootloader)', default="12")
     args = parser.parse_args()
 
     APP_IMG_SLOT_END = int(args.APP_IMG_SLOT_START, base=16) + \
@@ -216,3 +352,16 @@ if __name__ == "__main__":
             bytes = f.read()
             readable_hash = hashlib.sha256(bytes).hexdigest()
             print(f'{Fore.YELLOW}"Digest":"{readable_hash}"\n')
+
+        # The digest and signature always cover the raw image, the
+        # compressed file only changes what is transferred and stored
+        if args.compress:
+            production_lz = os.path.splitext(production_bin)[0] + '_lz.bin'
+            packed = lz_compress(bytes, int(args.window_bits))
+            if lz_decompress(packed) != bytes:
+                print(Fore.RED+"Compression round trip failed\n")
+                exit(1)
+            with open(production_lz, "wb") as f:
+                f.write(packed)
+            print(Fore.GREEN+"Generating %s (%d bytes, %.1f%% of %d)\n" %
+                  (production_lz, len(packed), 100.0 * len(packed) / len(bytes), len(bytes)))
@@ -0,0 +1,126 @@
+/*******************************************************************************
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    ba414e.h
+
+  Summary:
+    Polled ECDSA P-256 verification on the BA414E public key engine.
+
+  Description:
+    A minimal, RTOS free counterpart of the application's BA414E driver for
+    the bootloader. It only verifies P-256 signatures: the engine microcode is
+    loaded, the operands are written to the crypto memory, the operation is
+    started and its completion is polled. Operands are passed big-endian, as
+    they appear in the public key and in the signature.
+ *******************************************************************************/
+
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+Copyright (c) 2020-2021 released Microchip Technology Inc.  All rights reserved.
+
+Microchip licenses to you the right to use, modify, copy and distribute
+Software only when embedded on a Microchip microcontroller or digital signal
+controller that is integrated into your product or third party product
+(pursuant to the sublicense terms in the accompanying license agreement).
+
+You should refer to the license agreement accompanying this Software for
+additional information regarding your rights and obligations.
+
+SOFTWARE AND DOCUMENTATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF
+MERCHANTABILITY, TITLE, NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE.
+IN NO EVENT SHALL MICROCHIP OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER
+CONTRACT, NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR
+OTHER LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE OR
+CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT OF
+SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+(INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+ *******************************************************************************/
+// DOM-IGNORE-END
+
+#ifndef _BA414E_H
+#define _BA414E_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Constants
+// *****************************************************************************
+// *****************************************************************************
+
+/* P-256 operand size in bytes */
+#define BA414E_P256_SIZE            32
+
+/* Longest a verification may take before the engine is given up on */
+#ifndef BA414E_VERIFY_TIMEOUT_MS
+#define BA414E_VERIFY_TIMEOUT_MS    100
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+
+typedef enum {
+    /* The engine faulted or did not finish; the result is unknown */
+    BA414E_VERIFY_ERROR = -1,
+
+    /* The signature does not match */
+    BA414E_VERIFY_FAIL = 0,
+
+    /* The signature matches */
+    BA414E_VERIFY_PASS = 1,
+} BA414E_VERIFY_RESULT;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+// *****************************************************************************
+/* Function:
+    BA414E_VERIFY_RESULT BA414E_ECDSA_P256_Verify(const uint8_t *pubKeyX,
+            const uint8_t *pubKeyY, const uint8_t *sig, const uint8_t *hash);
+
+  Summary:
+    Verifies an ECDSA P-256 signature on the BA414E engine.
+
+  Description:
+    Loads the engine microcode, runs the verification and polls for its
+    end, with interrupts of the engine left disabled.
+
+  Parameters:
+    pubKeyX - X coordinate of the public key, BA414E_P256_SIZE bytes.
+    pubKeyY - Y coordinate of the public key, BA414E_P256_SIZE bytes.
+    sig     - r followed by s, 2 * BA414E_P256_SIZE bytes.
+    hash    - SHA-256 digest the signature was made over.
+
+  Returns:
+    BA414E_VERIFY_PASS or BA414E_VERIFY_FAIL, or BA414E_VERIFY_ERROR if
+    the engine could not give an answer and the signature has to be
+    verified in software instead.
+*/
+BA414E_VERIFY_RESULT BA414E_ECDSA_P256_Verify(const uint8_t *pubKeyX,
+        const uint8_t *pubKeyY, const uint8_t *sig, const uint8_t *hash);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BA414E_H */
@@ -139,6 +139,9 @@ typedef enum {
 
 //#define SYS_OTA_SECURE_BOOT_ENABLED
 
+/* Verify the image signature on the BA414E engine; wolfcrypt is only used if the engine gives no answer */
+#define SYS_OTA_SECURE_BOOT_BA414E_ENABLED
+
 /* Should be defined if the user wants to use the External flash memory to download the file  */
 //#define SYS_OTA_FS_ENABLED
 
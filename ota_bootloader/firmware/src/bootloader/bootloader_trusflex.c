@@ -58,7 +58,7 @@ static int selected_row;
 static char digest_str[66];
 static char digest_gl[4];
 static uint8_t digest_g[32];
-static OTA_DB_BUFFER *imageDB;
+static OTA_DB imageDB;
 static bool database_found;
 
 typedef uint32_t BOOTLOADER_STATUS;
@@ -123,8 +123,9 @@ static BOOTLOADER_DATA __attribute__((coherent, aligned(128))) bootloader;
 #define APP_MOUNT_NAME          "/mnt/myDrive1"
 #define APP_DEVICE_NAME         "/dev/mtda1"
 #define APP_FS_TYPE             FAT
-#define APP_OTA_DATABASE_NAME   "image_database.csv"
-#define APP_OTA_DATABASE_PATH   "/mnt/myDrive1/ota/image_database.csv"
+#define APP_OTA_DATABASE_NAME   "image_database.bin"
+#define APP_OTA_DATABASE_PATH   "/mnt/myDrive1/ota/image_database.bin"
+#define APP_OTA_DATABASE_CSV_PATH   "/mnt/myDrive1/ota/image_database.csv"
 #define APP_FILE_NAME           "ota/factory_reset.bin"
 #define APP_FACTORY_IMAGE_DIGEST_FILE_NAME  "ota/factory_reset_digest.txt"
 #define APP_FACTORY_IMAGE_SIGNATURE_FILE_NAME  "ota/factory_image_sign.txt"
@@ -556,13 +557,13 @@ static BOOTLOADER_STATUS Bootloader_Task_CheckImage(void) {
             }
             
             factory_reset = false;
-            imageDB = OTA_GetDBBuffer();
-            int ret_db_status = OTAGetDb(imageDB, APP_OTA_DATABASE_PATH);
+            /*Load the database, converting a CSV database left by an older release*/
+            int ret_db_status = OTA_DbLoad(&imageDB, APP_OTA_DATABASE_PATH, APP_OTA_DATABASE_CSV_PATH);
 
             /*check for error code*/
-            if (ret_db_status > 1)
+            if (ret_db_status == OTA_DB_LOAD_ERROR)
                 return SYS_STATUS_ERROR;
-            else if (ret_db_status == OTA_DB_NOT_FOUND) {
+            else if (ret_db_status == OTA_DB_LOAD_EMPTY) {
                 database_found = false;
 #ifdef OTA_DEBUG
                 printf("no database found");
@@ -586,32 +587,21 @@ static BOOTLOADER_STATUS Bootloader_Task_CheckImage(void) {
 #ifdef OTA_DEBUG
                 SYS_CONSOLE_DEBUG1("\n\nDatabase found\n\n");
 #endif
-                selected_row = GetImageRow(APP_IMG_BOOT_CTL->version, imageDB);
+                selected_row = OTA_DbFindVersion(&imageDB, APP_IMG_BOOT_CTL->version);
                 if (selected_row == -1) {
 #ifdef OTA_DEBUG
                     SYS_CONSOLE_DEBUG1("\n\nImage version is not found\n\n");
 #endif
                     return SYS_STATUS_ERROR;
                 }
-                if (GetFieldValue(imageDB, OTA_IMAGE_STATUS, selected_row, &img->status) != 0) {
-#ifdef OTA_DEBUG
-                    SYS_CONSOLE_DEBUG1("Image status field not read properly\n");
-#endif
-                    return SYS_STATUS_ERROR;
-                }
-                if (GetFieldValue_32Bit(imageDB, OTA_IMAGE_VERSION, selected_row, &img->version) != 0) {
-#ifdef OTA_DEBUG
-                    SYS_CONSOLE_DEBUG1("Image version field not read properly\n");
-#endif
-                    return SYS_STATUS_ERROR;
-                }
+                img->status = OTA_DbRecord(&imageDB, selected_row)->status;
+                img->version = OTA_DbRecord(&imageDB, selected_row)->version;
 
                 /*If highest version is already present in internal flash, no need to copy it again*/
                 if (APP_IMG_BOOT_CTL->status == IMG_STATUS_VALID) {
                     if (img->version == APP_IMG_BOOT_CTL->version
                             && img->status == IMG_STATUS_VALID) {
                         if (img->status == IMG_STATUS_VALID) {
-                            csv_destroy_buffer(imageDB);
                             return BOOTLOADER_STATUS_SUCCESS;
                         }
                     }
@@ -766,7 +756,8 @@ static BOOTLOADER_STATUS Bootloader_Task_SelectImage(void) {
         #ifdef OTA_DEBUG
             printf("file is opened successfully");
         #endif
-        SYS_FS_FileDirectoryRemove(APP_OTA_DATABASE_PATH);      
+        SYS_FS_FileDirectoryRemove(APP_OTA_DATABASE_PATH);
+        SYS_FS_FileDirectoryRemove(APP_OTA_DATABASE_CSV_PATH);
     }
     switch (bootloader.task.state) {
         case TASK_STATE_S_INIT:
@@ -782,35 +773,27 @@ static BOOTLOADER_STATUS Bootloader_Task_SelectImage(void) {
         {
             if (factory_reset == false) {
                 /*Get the row of the best image in the DB*/
-                uint8_t total_images = GetTotalImgs(imageDB);
+                uint8_t total_images = OTA_DbSlots(&imageDB);
 #ifdef OTA_DEBUG
                 SYS_CONSOLE_DEBUG1("total_images : %d\n", total_images);
 #endif
                 selected_row = -1;
                 /*set version variables to zero initially, and go through the image database to 
                  get the latest version of image */
+                const OTA_DB_RECORD *rec;
                 uint32_t ver = 0;
                 param->img.version = 0;
 
                 uint8_t i;
                 /*gothrough the image DB to get the latest and best image version */
                 for (i = 0; i < total_images; i++) {
-                    if (GetFieldValue_32Bit(imageDB, OTA_IMAGE_VERSION, i, &ver) != 0) {
-#ifdef OTA_DEBUG
-                        SYS_CONSOLE_DEBUG1("Image version field not read properly\n");
-#endif
-                        /*if database file is present , but empty  */
-                        if(total_images == 1)
-                            factory_reset = true;
-                        return SYS_STATUS_ERROR;
-                    }
+                    rec = OTA_DbRecord(&imageDB, i);
+                    /*free slot*/
+                    if (rec == NULL)
+                        continue;
+                    ver = rec->version;
                     if (param->img.version < ver) {
-                        if (GetFieldValue(imageDB, OTA_IMAGE_STATUS, i, &param->img.status) != 0) {
-#ifdef OTA_DEBUG
-                            SYS_CONSOLE_DEBUG1("Image status field not read properly\n");
-#endif
-                            return SYS_STATUS_ERROR;
-                        }
+                        param->img.status = rec->status;
 #ifdef OTA_DEBUG
                         SYS_CONSOLE_DEBUG1("Image status : %d\n\r",param->img.status);
 #endif
@@ -843,19 +826,11 @@ static BOOTLOADER_STATUS Bootloader_Task_SelectImage(void) {
                     char image_name[100];
                     char image_path[100];
                     strcpy(image_path, APP_MOUNT_NAME"/ota/");
-                    if (GetFieldString(imageDB, OTA_IMAGE_NAME, selected_row, image_name) != 0) {
-#ifdef OTA_DEBUG
-                        printf("Image name field not read properly\n");
-#endif
-                        return SYS_STATUS_ERROR;
-                    }
+                    rec = OTA_DbRecord(&imageDB, selected_row);
+                    strcpy(image_name, rec->name);
                     strcat(image_path, image_name);
-                    if (GetFieldString(imageDB, OTA_IMAGE_DIGEST, selected_row, digest_str) != 0) {
-#ifdef OTA_DEBUG
-                        SYS_CONSOLE_DEBUG1("Image Digest field not read properly\n");
-#endif
-                        return SYS_STATUS_ERROR;
-                    }
+                    memcpy(digest_str, rec->digest, OTA_DB_DIGEST_LEN);
+                    digest_str[OTA_DB_DIGEST_LEN] = '\0';
 #ifdef SYS_OTA_SECURE_BOOT_ENABLED                    
                     char image_signature_file[100];
                     strcpy(image_signature_file, image_path);
@@ -944,11 +919,6 @@ static BOOTLOADER_STATUS Bootloader_Task_SelectImage(void) {
             } else {
                 #ifdef OTA_DEBUG
                 SYS_CONSOLE_DEBUG1("Selected row : %d\n",selected_row);
-                if (GetFieldString(imageDB, OTA_IMAGE_DIGEST, selected_row, digest_str) != 0) {
-                    SYS_CONSOLE_DEBUG1("Image status field not read properly\n");
-                    while(1);
-                    return SYS_STATUS_ERROR;
-                }
                 
                 SYS_CONSOLE_DEBUG1("image digest : %s\n digest_str : %s\n", param->img.digest, digest_str);
                 #endif
@@ -1434,11 +1404,8 @@ static BOOTLOADER_STATUS Bootloader_Task_InvalidateImage(void) {
         case TASK_STATE_I_INVALIDATE:
         {
             param->img.status = IMG_STATUS_DISABLED;
-            char status[4];
-            sprintf(status, "%x", param->img.status);
-            SetFieldValue(imageDB, OTA_IMAGE_STATUS, selected_row, status);
-            OTADbDeleteEntry(imageDB,selected_row);
-            OTASaveDb(imageDB, APP_OTA_DATABASE_PATH);
+            /*Clear the status bits in place, this also frees the slot*/
+            OTA_DbSetStatus(&imageDB, selected_row, param->img.status);
             /*if (param->img.order == 0) {
                 printf("The golden image is broken!!\n");
                 bootloader.task.state = TASK_STATE_I_DONE;
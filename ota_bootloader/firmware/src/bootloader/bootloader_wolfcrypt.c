@@ -44,10 +44,12 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 #include "bootloader.h"
 #include "int_flash.h"
 #include "sha256.h"
+#include "ota_lz.h"
 #include "system/fs/sys_fs.h"
 #include "../bootloader/csv/csv.h"
 #include "ota_database_parser.h"
 #include "../bootloader/pub_key.h"
+#include "ba414e.h"
 #ifdef SYS_OTA_FS_ENABLED 
 #include "wolfssl/wolfcrypt/coding.h"
 #include "wolfssl/wolfcrypt/ecc.h"
@@ -72,7 +74,7 @@ static char digest_str[66];
 
 static char digest_gl[4];
 static uint8_t digest_g[32];
-static OTA_DB_BUFFER *imageDB;
+static OTA_DB imageDB;
 static bool database_found;
 #endif
 
@@ -98,6 +100,14 @@ typedef uint32_t BOOTLOADER_STATUS;
 
 #ifdef OTA_DEBUG
 #define FIRMWARE_IMAGE_HEADER_SIGNATURE_BYTE (4095)
+
+/* Boot time spent in each step, in core timer ticks (half the CPU clock) */
+static struct {
+    uint32_t program;
+    uint32_t hash;
+    uint32_t verify;
+} boot_ticks;
+#define BOOT_TICKS_TO_MS(t) ((unsigned long) ((t) / (CPU_CLOCK_FREQUENCY / 2000)))
 #endif
 
 #define __woraround_unused_variable(x) ((void)x)
@@ -141,8 +151,9 @@ static BOOTLOADER_DATA __attribute__((coherent, aligned(128))) bootloader;
 #define APP_MOUNT_NAME          "/mnt/myDrive1"
 #define APP_DEVICE_NAME         "/dev/mtda1"
 #define APP_FS_TYPE             FAT
-#define APP_OTA_DATABASE_NAME   "image_database.csv"
-#define APP_OTA_DATABASE_PATH   "/mnt/myDrive1/ota/image_database.csv"
+#define APP_OTA_DATABASE_NAME   "image_database.bin"
+#define APP_OTA_DATABASE_PATH   "/mnt/myDrive1/ota/image_database.bin"
+#define APP_OTA_DATABASE_CSV_PATH   "/mnt/myDrive1/ota/image_database.csv"
 #define APP_FILE_NAME           "ota/factory_reset.bin"
 #define APP_FACTORY_IMAGE_DIGEST_FILE_NAME  "ota/factory_image_digest.txt"
 #define APP_FACTORY_IMAGE_SIGNATURE_FILE_NAME  "ota/factory_image_sign.txt"
@@ -260,6 +271,23 @@ void Bootloader_Hash_Signature_Verify(const byte* sigBuf, word32 sigLen)
     
     mp_int *r = NULL, *s = NULL;
     
+    verify = 0;
+#ifdef SYS_OTA_SECURE_BOOT_BA414E_ENABLED
+    /* The key ends with the uncompressed point, 0x04 X Y */
+    if (sigLen == 2 * BA414E_P256_SIZE && pubKey[sizeof(pubKey) - 2 * BA414E_P256_SIZE - 1] == 0x04) {
+        BA414E_VERIFY_RESULT res = BA414E_ECDSA_P256_Verify(&pubKey[sizeof(pubKey) - 2 * BA414E_P256_SIZE],
+                &pubKey[sizeof(pubKey) - BA414E_P256_SIZE], sigBuf, digest_g);
+        if (res != BA414E_VERIFY_ERROR) {
+            verify = (res == BA414E_VERIFY_PASS) ? 1 : 0;
+            #ifdef OTA_DEBUG
+            printf("BA414E verify : %d\n\r", verify);
+            #endif
+            return;
+        }
+        printf("BA414E verify error, verifying in software\n\r");
+    }
+#endif
+    
     r = (mp_int*)XMALLOC(sizeof(mp_int), key->heap, DYNAMIC_TYPE_ECC);
     if (r == NULL){
         #ifdef OTA_DEBUG
@@ -636,13 +664,13 @@ static BOOTLOADER_STATUS Bootloader_Task_CheckImage(void) {
             }
             
             factory_reset = false;
-            imageDB = OTA_GetDBBuffer();
-            int ret_db_status = OTAGetDb(imageDB, APP_OTA_DATABASE_PATH);
+            /*Load the database, converting a CSV database left by an older release*/
+            int ret_db_status = OTA_DbLoad(&imageDB, APP_OTA_DATABASE_PATH, APP_OTA_DATABASE_CSV_PATH);
 
             /*check for error code*/
-            if (ret_db_status > 1)
+            if (ret_db_status == OTA_DB_LOAD_ERROR)
                 return SYS_STATUS_ERROR;
-            else if (ret_db_status == OTA_DB_NOT_FOUND) {
+            else if (ret_db_status == OTA_DB_LOAD_EMPTY) {
                 database_found = false;
 #ifdef OTA_DEBUG
                 printf("no database found");
@@ -666,32 +694,21 @@ static BOOTLOADER_STATUS Bootloader_Task_CheckImage(void) {
 #ifdef OTA_DEBUG
                 SYS_CONSOLE_DEBUG1("\n\nDatabase found\n\n");
 #endif
-                selected_row = GetImageRow(APP_IMG_BOOT_CTL->version, imageDB);
+                selected_row = OTA_DbFindVersion(&imageDB, APP_IMG_BOOT_CTL->version);
                 if (selected_row == -1) {
 #ifdef OTA_DEBUG
                     SYS_CONSOLE_DEBUG1("\n\nImage version is not found\n\n");
 #endif
                     return SYS_STATUS_ERROR;
                 }
-                if (GetFieldValue(imageDB, OTA_IMAGE_STATUS, selected_row, &img->status) != 0) {
-#ifdef OTA_DEBUG
-                    SYS_CONSOLE_DEBUG1("Image status field not read properly\n");
-#endif
-                    return SYS_STATUS_ERROR;
-                }
-                if (GetFieldValue_32Bit(imageDB, OTA_IMAGE_VERSION, selected_row, &img->version) != 0) {
-#ifdef OTA_DEBUG
-                    SYS_CONSOLE_DEBUG1("Image version field not read properly\n");
-#endif
-                    return SYS_STATUS_ERROR;
-                }
+                img->status = OTA_DbRecord(&imageDB, selected_row)->status;
+                img->version = OTA_DbRecord(&imageDB, selected_row)->version;
 
                 /*If highest version is already present in internal flash, no need to copy it again*/
                 if (APP_IMG_BOOT_CTL->status == IMG_STATUS_VALID) {
                     if (img->version == APP_IMG_BOOT_CTL->version
                             && img->status == IMG_STATUS_VALID) {
                         if (img->status == IMG_STATUS_VALID) {
-                            csv_destroy_buffer(imageDB);
                             return BOOTLOADER_STATUS_SUCCESS;
                         }
                     }
@@ -843,7 +860,8 @@ static BOOTLOADER_STATUS Bootloader_Task_SelectImage(void) {
         #ifdef OTA_DEBUG
             printf("file is opened successfully");
         #endif
-        SYS_FS_FileDirectoryRemove(APP_OTA_DATABASE_PATH);      
+        SYS_FS_FileDirectoryRemove(APP_OTA_DATABASE_PATH);
+        SYS_FS_FileDirectoryRemove(APP_OTA_DATABASE_CSV_PATH);
     }
     switch (bootloader.task.state) {
         case TASK_STATE_S_INIT:
@@ -859,35 +877,27 @@ static BOOTLOADER_STATUS Bootloader_Task_SelectImage(void) {
         {
             if (factory_reset == false) {
                 /*Get the row of the best image in the DB*/
-                uint8_t total_images = GetTotalImgs(imageDB);
+                uint8_t total_images = OTA_DbSlots(&imageDB);
 #ifdef OTA_DEBUG
                 SYS_CONSOLE_DEBUG1("total_images : %d\n", total_images);
 #endif
                 selected_row = -1;
                 /*set version variables to zero initially, and go through the image database to 
                  get the latest version of image */
+                const OTA_DB_RECORD *rec;
                 uint32_t ver = 0;
                 param->img.version = 0;
 
                 uint8_t i;
                 /*go through the image DB to get the latest and best image version */
                 for (i = 0; i < total_images; i++) {
-                    if (GetFieldValue_32Bit(imageDB, OTA_IMAGE_VERSION, i, &ver) != 0) {
-#ifdef OTA_DEBUG
-                        SYS_CONSOLE_DEBUG1("Image version field not read properly\n");
-#endif
-                        /*if database file is present , but empty  */
-                        if(total_images == 1)
-                            factory_reset = true;
-                        return SYS_STATUS_ERROR;
-                    }
+                    rec = OTA_DbRecord(&imageDB, i);
+                    /*free slot*/
+                    if (rec == NULL)
+                        continue;
+                    ver = rec->version;
                     if (param->img.version < ver) {
-                        if (GetFieldValue(imageDB, OTA_IMAGE_STATUS, i, &param->img.status) != 0) {
-#ifdef OTA_DEBUG
-                            SYS_CONSOLE_DEBUG1("Image status field not read properly\n");
-#endif
-                            return SYS_STATUS_ERROR;
-                        }
+                        param->img.status = rec->status;
 #ifdef OTA_DEBUG
                         SYS_CONSOLE_DEBUG1("Image status : %d\n\r",param->img.status);
 #endif
@@ -919,19 +929,11 @@ static BOOTLOADER_STATUS Bootloader_Task_SelectImage(void) {
                     char image_name[100];
                     char image_path[100];
                     strcpy(image_path, APP_MOUNT_NAME"/ota/");
-                    if (GetFieldString(imageDB, OTA_IMAGE_NAME, selected_row, image_name) != 0) {
-#ifdef OTA_DEBUG
-                        printf("Image name field not read properly\n");
-#endif
-                        return SYS_STATUS_ERROR;
-                    }
+                    rec = OTA_DbRecord(&imageDB, selected_row);
+                    strcpy(image_name, rec->name);
                     strcat(image_path, image_name);
-                    if (GetFieldString(imageDB, OTA_IMAGE_DIGEST, selected_row, digest_str) != 0) {
-#ifdef OTA_DEBUG
-                        SYS_CONSOLE_DEBUG1("Image Digest field not read properly\n");
-#endif
-                        return SYS_STATUS_ERROR;
-                    }
+                    memcpy(digest_str, rec->digest, OTA_DB_DIGEST_LEN);
+                    digest_str[OTA_DB_DIGEST_LEN] = '\0';
 #ifdef SYS_OTA_SECURE_BOOT_ENABLED                    
                     
                     
@@ -1025,11 +1027,6 @@ static BOOTLOADER_STATUS Bootloader_Task_SelectImage(void) {
             } else {
                 #ifdef OTA_DEBUG
                 SYS_CONSOLE_DEBUG1("Selected row : %d\n",selected_row);
-                if (GetFieldString(imageDB, OTA_IMAGE_DIGEST, selected_row, digest_str) != 0) {
-                    SYS_CONSOLE_DEBUG1("Image status field not read properly\n");
-                    while(1);
-                    return SYS_STATUS_ERROR;
-                }
                 
                 SYS_CONSOLE_DEBUG1("image digest : %s\n digest_str : %s\n", param->img.digest, digest_str);
                 #endif
@@ -1076,13 +1073,101 @@ static BOOTLOADER_STATUS Bootloader_Task_SelectImage(void) {
  */
 //---------------------------------------------------------------------------
 
+/* The image is copied in blocks of several sectors. While one block is
+   being programmed by the NVM controller the next one is read from the file
+   system into the other buffer */
+#define PROGRAM_BLOCK_SIZE         (2U * FLASH_SECTOR_SIZE)
+#define PROGRAM_BUFFERS            2
+
+static uint8_t __attribute__((aligned(32))) program_buf[PROGRAM_BUFFERS][PROGRAM_BLOCK_SIZE];
+
 typedef struct {
     uint8_t *buf;
     uint32_t offset;
     uint32_t len;
     uint32_t copy_len;
+    uint32_t erased;                        /* Slot is erased up to here */
+    uint32_t ticket[PROGRAM_BUFFERS];       /* Write of the block in each buffer */
+    uint32_t next;                          /* Buffer for the next block */
 } BOOTLOADER_PROGRAM_IMAGE_TASK_CONTEXT;
 
+/* Compressed images (see ota_lz.h) are decompressed while they are copied */
+#define LZ_INPUT_SIZE              (1024U)
+
+static struct {
+    bool compressed;
+    OTA_LZ_CTX ctx;
+    uint32_t in_pos;
+    uint32_t in_len;
+    uint8_t in[LZ_INPUT_SIZE];
+    uint8_t window[OTA_LZ_WINDOW_SIZE];
+} image_lz;
+
+/* Checks whether the image file is compressed and leaves the file positioned
+   at the first byte of the image data */
+static bool Bootloader_ImageOpen(uint32_t *img_sz) {
+    OTA_LZ_HEADER hdr;
+    uint8_t buf[OTA_LZ_HEADER_SIZE];
+
+    image_lz.compressed = false;
+    SYS_FS_FileSeek(appFile.fileHandle, 0, SYS_FS_SEEK_SET);
+    if (SYS_FS_FileRead(appFile.fileHandle, buf, OTA_LZ_HEADER_SIZE) == OTA_LZ_HEADER_SIZE
+            && OTA_LZ_HeaderParse(buf, OTA_LZ_HEADER_SIZE, &hdr)) {
+        if (hdr.raw_len > FACTORY_RESET_IMG_SIZE
+                || OTA_LZ_Init(&image_lz.ctx, &hdr, image_lz.window, sizeof (image_lz.window)) == false) {
+            printf("Unsupported compressed image\n");
+            return false;
+        }
+        image_lz.compressed = true;
+        image_lz.in_pos = 0;
+        image_lz.in_len = 0;
+        *img_sz = hdr.raw_len;
+        return true;
+    }
+    SYS_FS_FileSeek(appFile.fileHandle, 0, SYS_FS_SEEK_SET);
+    return true;
+}
+
+/* Reads the image bytes at offset, which must follow those read before */
+static bool Bootloader_ImageRead(uint32_t offset, uint8_t *buf, uint32_t len) {
+    uint32_t got = 0;
+
+    if (image_lz.compressed == false) {
+        size_t rd;
+
+        SYS_FS_FileSeek(appFile.fileHandle, offset, SYS_FS_SEEK_SET);
+        rd = SYS_FS_FileRead(appFile.fileHandle, buf, len);
+        if (rd == (size_t) -1) {
+            return false;
+        }
+        memset(&buf[rd], 0xFF, len - rd);
+        return true;
+    }
+    while (got < len && OTA_LZ_Done(&image_lz.ctx) == false) {
+        uint32_t in_len = image_lz.in_len - image_lz.in_pos;
+        int32_t out_len;
+
+        /* A long match may still be pending when all input has been consumed */
+        out_len = OTA_LZ_Decompress(&image_lz.ctx, &image_lz.in[image_lz.in_pos], &in_len, &buf[got], len - got);
+        if (out_len < 0) {
+            return false;
+        }
+        image_lz.in_pos += in_len;
+        got += out_len;
+        if (got < len && OTA_LZ_Done(&image_lz.ctx) == false && image_lz.in_pos == image_lz.in_len) {
+            size_t rd = SYS_FS_FileRead(appFile.fileHandle, image_lz.in, LZ_INPUT_SIZE);
+            if (rd == 0 || rd == (size_t) -1) {
+                return false;
+            }
+            image_lz.in_pos = 0;
+            image_lz.in_len = rd;
+        }
+    }
+    /* Past the end of the image, as for a raw file shorter than the sector */
+    memset(&buf[got], 0xFF, len - got);
+    return true;
+}
+
 typedef enum {
     TASK_STATE_P_INIT = 0,
     TASK_STATE_P_ERASE_SLOT,
@@ -1131,9 +1216,25 @@ static BOOTLOADER_STATUS Bootloader_Task_ProgramImage(void) {
             } else
                 ctx->copy_len = (FACTORY_RESET_IMG_SIZE + FLASH_SECTOR_SIZE - 1) / FLASH_SECTOR_SIZE * FLASH_SECTOR_SIZE;
 #endif
+            /*A compressed file holds the image size in its header*/
+            if (Bootloader_ImageOpen(&ctx->copy_len) == false) {
+                ctx->buf = NULL;
+                return BOOTLOADER_STATUS_ERROR;
+            }
+            if (image_lz.compressed == true) {
+                param->img.sz = ctx->copy_len;
+            }
+            if (ctx->copy_len > FACTORY_RESET_IMG_SIZE) {
+                printf("Image does not fit the slot\n");
+                ctx->buf = NULL;
+                return BOOTLOADER_STATUS_ERROR;
+            }
             /*header area will be used during image verification , copy it in buffer "boot_ctl" */
-            SYS_FS_FileSeek(appFile.fileHandle, 0, SYS_FS_SEEK_SET);
-            SYS_FS_FileRead(appFile.fileHandle, ctx->buf, ctx->len);
+            if (Bootloader_ImageRead(0, ctx->buf, ctx->len) == false) {
+                printf("Broken Image : decompression failed\n");
+                ctx->buf = NULL;
+                return BOOTLOADER_STATUS_ERROR;
+            }
             memcpy(boot_ctl, ctx->buf, ctx->len);
 
 #ifdef OTA_DEBUG
@@ -1144,6 +1245,9 @@ static BOOTLOADER_STATUS Bootloader_Task_ProgramImage(void) {
             }
 #endif
 
+            ctx->erased = 0;
+            ctx->next = 0;
+            memset(ctx->ticket, 0, sizeof (ctx->ticket));
             bootloader.task.state = TASK_STATE_P_ERASE_SLOT;
             break;
         }
@@ -1152,42 +1256,98 @@ static BOOTLOADER_STATUS Bootloader_Task_ProgramImage(void) {
 #ifdef OTA_DEBUG
             SYS_CONSOLE_DEBUG1("TASK_STATE_P_ERASE_SLOT\n");
 #endif
-            if (INT_Flash_Erase(APP_IMG_SLOT_ADDR, FACTORY_RESET_IMG_SIZE) == false) {
+            /*Only the header sector is erased here, the rest of the image area is
+              erased a block ahead of programming*/
+            if (INT_Flash_QueueErase(APP_IMG_SLOT_ADDR, FLASH_SECTOR_SIZE) == 0) {
                 ctx->buf = NULL;
                 return BOOTLOADER_STATUS_ERROR;
             }
-            bootloader.task.state = TASK_STATE_P_READ_IMAGE;
+            ctx->erased = FLASH_SECTOR_SIZE;
+            INT_Flash_QueueTasks();
+            if (ctx->offset >= ctx->copy_len) {
+                bootloader.task.state = TASK_STATE_P_PROGRAM_IMAGE;
+            } else {
+                bootloader.task.state = TASK_STATE_P_READ_IMAGE;
+            }
             break;
         }
         case TASK_STATE_P_READ_IMAGE:
         {
-            if (INT_Flash_Busy()) {
+            uint8_t *buf = program_buf[ctx->next];
+            /*End of the image rounded up to a whole sector*/
+            uint32_t last = (ctx->copy_len + FLASH_SECTOR_SIZE - 1) / FLASH_SECTOR_SIZE * FLASH_SECTOR_SIZE;
+            uint32_t end;
+
+            if (INT_Flash_QueueTasks() == INT_FLASH_QUEUE_ERROR) {
+                INT_Flash_QueueFlush();
+                ctx->buf = NULL;
+                return BOOTLOADER_STATUS_ERROR;
+            }
+            /*The buffer is free once the block last programmed from it is written*/
+            if (INT_Flash_QueueDone(ctx->ticket[ctx->next]) == false) {
                 break;
             }
 #ifdef OTA_DEBUG
             SYS_CONSOLE_DEBUG1("TASK_STATE_P_READ_IMAGE\n");
 #endif
+            ctx->len = last - ctx->offset;
+            if (ctx->len > PROGRAM_BLOCK_SIZE) {
+                ctx->len = PROGRAM_BLOCK_SIZE;
+            }
+
+            /*Keep the erase one block ahead of the block being read*/
+            end = ctx->offset + ctx->len + PROGRAM_BLOCK_SIZE;
+            if (end > last) {
+                end = last;
+            }
+            if (end > ctx->erased) {
+                if (INT_Flash_QueueErase(APP_IMG_SLOT_ADDR + ctx->erased, end - ctx->erased) == 0) {
+                    INT_Flash_QueueFlush();
+                    ctx->buf = NULL;
+                    return BOOTLOADER_STATUS_ERROR;
+                }
+                ctx->erased = end;
+                INT_Flash_QueueTasks();
+            }
 
-            SYS_FS_FileSeek(appFile.fileHandle, ctx->offset, SYS_FS_SEEK_SET);
-            SYS_FS_FileRead(appFile.fileHandle, ctx->buf, ctx->len);
-            bootloader.task.state = TASK_STATE_P_PROGRAM_IMAGE;
+            /*The flash keeps erasing and programming from its interrupt while this blocks*/
+            if (Bootloader_ImageRead(ctx->offset, buf, ctx->len) == false) {
+                printf("Broken Image : decompression failed\n");
+                INT_Flash_QueueFlush();
+                ctx->buf = NULL;
+                return BOOTLOADER_STATUS_ERROR;
+            }
+            ctx->ticket[ctx->next] = INT_Flash_QueueWrite(APP_IMG_SLOT_ADDR + ctx->offset, buf, ctx->len);
+            if (ctx->ticket[ctx->next] == 0) {
+                INT_Flash_QueueFlush();
+                ctx->buf = NULL;
+                return BOOTLOADER_STATUS_ERROR;
+            }
+            INT_Flash_QueueTasks();
+            ctx->next = (ctx->next + 1) % PROGRAM_BUFFERS;
+            ctx->offset += ctx->len;
+            if (ctx->offset >= ctx->copy_len) {
+                bootloader.task.state = TASK_STATE_P_PROGRAM_IMAGE;
+            }
             break;
         }
         case TASK_STATE_P_PROGRAM_IMAGE:
         {
-            if (INT_Flash_Busy()) {
+            /*Wait for the last blocks to be programmed*/
+            INT_FLASH_QUEUE_STATUS status = INT_Flash_QueueTasks();
+
+            if (status == INT_FLASH_QUEUE_ERROR) {
+                INT_Flash_QueueFlush();
+                ctx->buf = NULL;
+                return BOOTLOADER_STATUS_ERROR;
+            }
+            if (status == INT_FLASH_QUEUE_BUSY) {
                 break;
             }
 #ifdef OTA_DEBUG
             SYS_CONSOLE_DEBUG1("TASK_STATE_P_PROGRAM_IMAGE\n");
 #endif
-            INT_Flash_Write(APP_IMG_SLOT_ADDR + ctx->offset, ctx->buf, FLASH_SECTOR_SIZE);
-            ctx->offset += ctx->len;
-            if (ctx->offset >= ctx->copy_len) {
-                bootloader.task.state = TASK_STATE_P_FORMULATE_BOOT_CTL;
-            } else {
-                bootloader.task.state = TASK_STATE_P_READ_IMAGE;
-            }
+            bootloader.task.state = TASK_STATE_P_FORMULATE_BOOT_CTL;
             break;
         }
         case TASK_STATE_P_FORMULATE_BOOT_CTL:
@@ -1207,9 +1367,8 @@ static BOOTLOADER_STATUS Bootloader_Task_ProgramImage(void) {
                 break;
             }
 
-            /*If factory reset image, extract the header information from factory reset image file*/
-            SYS_FS_FileSeek(appFile.fileHandle, 0, SYS_FS_SEEK_SET);
-            SYS_FS_FileRead(appFile.fileHandle, ctx->buf, FLASH_SECTOR_SIZE);
+            /*If factory reset image, take the header information from the first sector of the image file*/
+            memcpy(ctx->buf, boot_ctl, FLASH_SECTOR_SIZE);
 #ifdef OTA_DEBUG
             Bootloader_TraceHeader((void*) ctx->buf);
 #endif
@@ -1227,7 +1386,6 @@ static BOOTLOADER_STATUS Bootloader_Task_ProgramImage(void) {
 #ifdef OTA_DEBUG            
             Bootloader_TraceHeader((void*) ctx->buf);
 #endif
-            CRYPT_SHA256_DataSizeSet(&ctx->sha256, param->img.sz);
 #ifdef SYS_OTA_BOOTLOAD_FROM_DEDICATED_BOOTFLASH_ENABLED
             if (INT_Flash_Write(APP_BOOT_CTL_SLOT_ADDR, ctx->buf, FLASH_SECTOR_SIZE) == false)
 #else
@@ -1357,8 +1515,14 @@ static BOOTLOADER_STATUS Bootloader_Task_VerifyImageDigest(void) {
             {
                 printf("%x ",decoded_signature[j]);
             }
+#endif
+#ifdef OTA_DEBUG
+            uint32_t verify_start = _CP0_GET_COUNT();
 #endif
             Bootloader_Hash_Signature_Verify((byte*)decoded_signature,outLen);
+#ifdef OTA_DEBUG
+            boot_ticks.verify += _CP0_GET_COUNT() - verify_start;
+#endif
             
             if(verify != 1)
             {
@@ -1495,7 +1659,6 @@ static BOOTLOADER_STATUS Bootloader_Task_SetImageStatus(void) {
 #ifdef OTA_DEBUG
             ctx->buf[FIRMWARE_IMAGE_HEADER_SIGNATURE_BYTE] = param->img.status;
 #endif
-            CRYPT_SHA256_DataSizeSet(&ctx->sha256, param->img.sz);
 #ifdef SYS_OTA_BOOTLOAD_FROM_DEDICATED_BOOTFLASH_ENABLED
             INT_Flash_Write(APP_BOOT_CTL_SLOT_ADDR, ctx->buf, FLASH_SECTOR_SIZE);
 #else
@@ -1557,11 +1720,8 @@ static BOOTLOADER_STATUS Bootloader_Task_InvalidateImage(void) {
         case TASK_STATE_I_INVALIDATE:
         {
             param->img.status = IMG_STATUS_DISABLED;
-            char status[4];
-            sprintf(status, "%x", param->img.status);
-            SetFieldValue(imageDB, OTA_IMAGE_STATUS, selected_row, status);
-            OTADbDeleteEntry(imageDB,selected_row);
-            OTASaveDb(imageDB, APP_OTA_DATABASE_PATH);
+            /*Clear the status bits in place, this also frees the slot*/
+            OTA_DbSetStatus(&imageDB, selected_row, param->img.status);
             /*if (param->img.order == 0) {
                 printf("The golden image is broken!!\n");
                 bootloader.task.state = TASK_STATE_I_DONE;
@@ -1580,6 +1740,47 @@ static BOOTLOADER_STATUS Bootloader_Task_InvalidateImage(void) {
 
 #endif 
 
+#ifdef SYS_OTA_FILE_JUMP_ENABLE
+//---------------------------------------------------------------------------
+/*
+  bool Bootloader_DownloadedImageValid(void)
+
+  Description:
+  The application hashes the image while it downloads it and stores the size
+  and digest in the boot control header. The image in the download slot is
+  hashed once more and compared with them. A header without them, written by
+  an older application, is accepted as before.
+
+  Task Parameters:
+    None
+  Return:
+    true if the image may be started.
+ */
+//---------------------------------------------------------------------------
+static bool Bootloader_DownloadedImageValid(void) {
+    static CRYPT_SHA256_CTX sha256;
+    uint8_t digest[CRYPT_SHA256_DIGEST_SIZE];
+    uint32_t sz = APP_IMG_BOOT_CTL->sz;
+
+    if (sz == 0xFFFFFFFF) {
+        return true;
+    }
+    if (sz == 0 || sz > APP_IMG_DOWNLOAD_SIZE) {
+        printf("Downloaded image size %lu not in the slot\r\n", (unsigned long) sz);
+        return false;
+    }
+    CRYPT_SHA256_Initialize(&sha256);
+    CRYPT_SHA256_DataSizeSet(&sha256, sz);
+    CRYPT_SHA256_DataAdd(&sha256, (const uint8_t *) APP_IMG_DOWNLOAD_ADDR, sz);
+    CRYPT_SHA256_Finalize(&sha256, digest);
+    if (memcmp(digest, (const uint8_t *) APP_IMG_BOOT_CTL->digest, CRYPT_SHA256_DIGEST_SIZE) != 0) {
+        printf("Downloaded image digest mismatch\r\n");
+        return false;
+    }
+    return true;
+}
+#endif
+
 // *****************************************************************************
 // *****************************************************************************
 // Section:To jump to application code
@@ -1627,7 +1828,12 @@ static BOOTLOADER_STATUS Bootloader_Task_InvalidateImage(void) {
                 }
                 else if( ch == 'b')
                 {
-                    fptr = (void(*)(void)) (APP_IMG_BOOT_CTL->boot_addr);
+                    if (Bootloader_DownloadedImageValid()) {
+                        fptr = (void(*)(void)) (APP_IMG_BOOT_CTL->boot_addr);
+                    } else {
+                        printf("Starting the Cloud Image\r\n");
+                        fptr = (void(*)(void)) (APP_IMG_BOOT_ADDR);
+                    }
                 }
 
             }
@@ -1711,30 +1917,37 @@ static BOOTLOADER_STATUS Bootloader_Task_FactoryReset(void) {
         }
         case TASK_STATE_FR_READ_IMAGE:
         {
-            
-            INT_Flash_Read(APP_IMG_SLOT_ADDR + ctx->offset, ctx->buf, FLASH_SECTOR_SIZE); 
+            /*Copy several sectors per file system write*/
+            ctx->len = ctx->copy_len - ctx->offset;
+            if (ctx->len > PROGRAM_BLOCK_SIZE) {
+                ctx->len = PROGRAM_BLOCK_SIZE;
+            }
+            INT_Flash_Read(APP_IMG_SLOT_ADDR + ctx->offset, program_buf[0], ctx->len); 
             bootloader.task.state = TASK_STATE_FR_PROGRAM_IMAGE;
             break;
         }
         case TASK_STATE_FR_PROGRAM_IMAGE:
         {
-            
+            uint8_t *buf = program_buf[0];
+
             if (INT_Flash_Busy()) {
                 break;
             }
             if (ctx->offset == 0) {
                 FIRMWARE_IMAGE_HEADER *img;
-                img = (FIRMWARE_IMAGE_HEADER *) ctx->buf;
+                img = (FIRMWARE_IMAGE_HEADER *) buf;
                 img->type = IMG_TYPE_FACTORY_RESET;
-                ctx->buf[FIRMWARE_IMAGE_HEADER_STATUS_BYTE] = 0xF8; //img->status;
+                buf[FIRMWARE_IMAGE_HEADER_STATUS_BYTE] = 0xF8; //img->status;
             }
 			#ifdef FACTORY_IMAGE_VERIFICATION_ENABLED
-            CRYPT_SHA256_DataAdd(&ctx->sha256, ctx->buf, FLASH_SECTOR_SIZE);
+            CRYPT_SHA256_DataAdd(&ctx->sha256, buf, ctx->len);
 			#endif
-            SYS_FS_FileWrite(appFile.fileHandle, ctx->buf, FLASH_SECTOR_SIZE);
+            SYS_FS_FileWrite(appFile.fileHandle, buf, ctx->len);
             bootloader.task.state = TASK_STATE_FR_READ_IMAGE;
-            ctx->offset += FLASH_SECTOR_SIZE;
+            ctx->offset += ctx->len;
             if (ctx->offset >= ctx->copy_len) {
+                /*The boot control sector is formed from the last sector copied, as before*/
+                memcpy(ctx->buf, &buf[ctx->len - FLASH_SECTOR_SIZE], FLASH_SECTOR_SIZE);
                 bootloader.task.state = TASK_STATE_FR_ERASE_BOOT_CTL;
             }
             break;
@@ -1959,7 +2172,13 @@ void Bootloader_Tasks(void) {
         case BOOTLOADER_TASK_PROGRAM_IMAGE:
         {
 #ifdef SYS_OTA_FS_ENABLED            
+#ifdef OTA_DEBUG
+            uint32_t start = _CP0_GET_COUNT();
+#endif
             status = Bootloader_Task_ProgramImage();
+#ifdef OTA_DEBUG
+            boot_ticks.program += _CP0_GET_COUNT() - start;
+#endif
             if (status == BOOTLOADER_STATUS_SUCCESS) {
 #ifdef OTA_DEBUG                
                 printf("BOOTLOADER_TASK_PROGRAM_IMAGE success\n");
@@ -1985,11 +2204,22 @@ void Bootloader_Tasks(void) {
             printf("BOOTLOADER_TASK_VERIFY_IMAGE\n");
 #endif
 #ifdef SYS_OTA_FS_ENABLED         
+#ifdef OTA_DEBUG
+            uint32_t start = _CP0_GET_COUNT();
+#endif
             status = Bootloader_Task_VerifyImageDigest();
+#ifdef OTA_DEBUG
+            boot_ticks.hash += _CP0_GET_COUNT() - start;
+#endif
 
             if (status == BOOTLOADER_STATUS_SUCCESS) {
 #ifdef OTA_DEBUG
                 printf("BOOTLOADER_TASK_VERIFY_IMAGE success\n");
+                /* The signature is checked within the verify task */
+                printf("Boot time : program %lu ms, hash %lu ms, verify %lu ms\n",
+                        BOOT_TICKS_TO_MS(boot_ticks.program),
+                        BOOT_TICKS_TO_MS(boot_ticks.hash - boot_ticks.verify),
+                        BOOT_TICKS_TO_MS(boot_ticks.verify));
 #endif
                 next = BOOTLOADER_TASK_SET_IMAGE_STATUS;
             }
@@ -52,6 +52,7 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 */
 
 #include "definitions.h"
+#include "int_flash.h"
 #include <string.h>
 
 typedef struct 
@@ -59,13 +60,92 @@ typedef struct
     uint32_t buf[NVM_FLASH_PAGESIZE/sizeof(uint32_t)];
 }INT_FLASH_DATA;
 
+typedef struct
+{
+    bool        erase;
+    uint32_t    addr;
+    uint8_t*    buf;
+    uint32_t    len;
+}INT_FLASH_JOB;
+
 static INT_FLASH_DATA  __attribute__((coherent, aligned(32))) int_flash;
 static volatile bool OpDone = false;
 
+/* Queued jobs; tickets are issued from head and retired at tail. The head is
+   only moved by the caller, the tail only by the operation in progress */
+static INT_FLASH_JOB flash_queue[INT_FLASH_QUEUE_DEPTH];
+static volatile uint32_t flash_queue_head = 0;
+static volatile uint32_t flash_queue_tail = 0;
+static volatile bool flash_queue_running = false;
+static volatile bool flash_queue_error = false;
+
+//---------------------------------------------------------------------------
+/* Starts the next page erase or row write of a job. The job is advanced
+   first, as the completion interrupt may look at it before this returns */
+static bool INT_Flash_OpStart(INT_FLASH_JOB* job)
+{
+    uint32_t addr = job->addr;
+
+    OpDone = false;
+    if (job->erase)
+    {
+        job->addr += NVM_FLASH_PAGESIZE;
+        job->len  -= NVM_FLASH_PAGESIZE;
+        if (NVM_PageErase(addr))
+        {
+            return true;
+        }
+    }
+    else
+    {
+        memcpy(int_flash.buf, job->buf, NVM_FLASH_ROWSIZE);
+        job->buf  += NVM_FLASH_ROWSIZE;
+        job->addr += NVM_FLASH_ROWSIZE;
+        job->len  -= NVM_FLASH_ROWSIZE;
+        if (NVM_RowWrite(int_flash.buf, addr))
+        {
+            return true;
+        }
+    }
+    OpDone = true;
+    return false;
+}
+
+//---------------------------------------------------------------------------
+/* Retires finished jobs and starts the next operation, if any. Called from
+   the completion interrupt, or by the caller while nothing is running */
+static void INT_Flash_QueueAdvance(void)
+{
+    INT_FLASH_JOB* job;
+
+    while (flash_queue_tail != flash_queue_head && flash_queue_error == false)
+    {
+        job = &flash_queue[flash_queue_tail % INT_FLASH_QUEUE_DEPTH];
+        if (job->len == 0)
+        {
+            /* The last page or row of this job has completed */
+            flash_queue_tail++;
+            continue;
+        }
+        flash_queue_running = true;
+        if (INT_Flash_OpStart(job))
+        {
+            return;
+        }
+        flash_queue_error = true;
+        break;
+    }
+    flash_queue_running = false;
+}
+
 //---------------------------------------------------------------------------
 static void INT_Flash_EventHandler(uintptr_t context)
 {
     OpDone = true;
+    if (flash_queue_running)
+    {
+        INT_Flash_QueueAdvance();
+    }
 }
 //---------------------------------------------------------------------------
 bool INT_Flash_Initialize(void)
@@ -146,6 +226,75 @@ bool INT_Flash_Busy()
     return false;
 }
 
+//---------------------------------------------------------------------------
+static uint32_t INT_Flash_Queue(bool erase, uint32_t addr, uint8_t* buf, uint32_t len)
+{
+    INT_FLASH_JOB* job;
+    uint32_t head = flash_queue_head;
+
+    if (flash_queue_error || (head - flash_queue_tail) == INT_FLASH_QUEUE_DEPTH)
+    {
+        return 0;
+    }
+
+    job = &flash_queue[head % INT_FLASH_QUEUE_DEPTH];
+    job->erase = erase;
+    job->addr  = addr + NVM_FLASH_START_ADDRESS;
+    job->buf   = buf;
+    job->len   = len;
+
+    /* Publish the job only once it is complete. Tickets start at 1, so
+       callers can use 0 for "nothing queued" */
+    flash_queue_head = head + 1;
+    return head + 1;
+}
+
+//---------------------------------------------------------------------------
+uint32_t INT_Flash_QueueErase(uint32_t addr, uint32_t len)
+{
+    return INT_Flash_Queue(true, addr, NULL, len);
+}
+
+//---------------------------------------------------------------------------
+uint32_t INT_Flash_QueueWrite(uint32_t addr, uint8_t* buf, uint32_t len)
+{
+    return INT_Flash_Queue(false, addr, buf, len);
+}
+
+//---------------------------------------------------------------------------
+bool INT_Flash_QueueDone(uint32_t ticket)
+{
+    return ((int32_t)(flash_queue_tail - ticket) >= 0);
+}
+
+//---------------------------------------------------------------------------
+INT_FLASH_QUEUE_STATUS INT_Flash_QueueTasks(void)
+{
+    /* While an operation runs the interrupt chains the next one; otherwise
+       no interrupt is pending and the queue can be started from here */
+    if (flash_queue_running == false && flash_queue_error == false)
+    {
+        INT_Flash_QueueAdvance();
+    }
+    if (flash_queue_error)
+    {
+        return INT_FLASH_QUEUE_ERROR;
+    }
+    return (flash_queue_tail != flash_queue_head) ? INT_FLASH_QUEUE_BUSY : INT_FLASH_QUEUE_IDLE;
+}
+
+//---------------------------------------------------------------------------
+void INT_Flash_QueueFlush(void)
+{
+    /* Stop the chain, then let the page or row in progress finish before
+       its job is dropped */
+    flash_queue_error = true;
+    while (flash_queue_running) ;
+
+    flash_queue_tail = flash_queue_head;
+    flash_queue_error = false;
+}
+
 //---------------------------------------------------------------------------
 uint32_t INT_Flash_Capacity(void)
 {
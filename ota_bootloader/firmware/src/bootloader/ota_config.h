@@ -84,6 +84,9 @@ extern "C" {
 #ifdef SYS_OTA_FILE_JUMP_ENABLE
 /*Jump address of the new image.This shall be updated with the proper memory calculation*/
 #define APP_IMG_BOOT_ADDR_2      0x900f8200
+/*Slot the application downloads the new image to, SYS_OTA_JUMP_TO_ADDRESS and SYS_OTA_SLOT_0_SIZE of its configuration*/
+#define APP_IMG_DOWNLOAD_ADDR    0xb0170000
+#define APP_IMG_DOWNLOAD_SIZE    61440
 #endif
 #endif
 
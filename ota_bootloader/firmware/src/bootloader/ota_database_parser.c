@@ -30,10 +30,11 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
     database_parser.c
     
   Summary:
-    Interface for the Bootloader library.
+    OTA image database.
 
   Description:
-    This file contains the interface definition for the OTA library.
+    Fixed-record binary image database. See ota_database_parser.h for the
+    file layout.
  *******************************************************************************/
 
 
@@ -51,222 +52,298 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 #include "../bootloader/csv/csv.h"
 #include "ota_database_parser.h"
 #include "bootloader.h"
+#include <stddef.h>
 #include <string.h>
-#define APP_MOUNT_NAME          "/mnt/myDrive1"
 #define SYS_CONSOLE_DEBUG1      printf /*To Do*/
 
 #ifdef SYS_OTA_FS_ENABLED
-/*
- ** Get buffer for image data base in the external flash
- */
-OTA_DB_BUFFER *OTA_GetDBBuffer() {
-    OTA_DB_BUFFER *imageDB = (OTA_DB_BUFFER *) csv_create_buffer();
-    return imageDB;
+#define OTA_DB_CRC_START        offsetof(OTA_DB_RECORD, version)
+
+static uint32_t OTA_DbCrc32(const void *data, size_t len) {
+    const uint8_t *p = data;
+    uint32_t crc = 0xFFFFFFFF;
+    uint8_t bit;
+
+    while (len--) {
+        crc ^= *p++;
+        for (bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+    return ~crc;
+}
+
+static uint32_t OTA_DbRecordCrc(const OTA_DB_RECORD *rec) {
+    return OTA_DbCrc32((const uint8_t *) rec + OTA_DB_CRC_START, offsetof(OTA_DB_RECORD, crc) - OTA_DB_CRC_START);
+}
+
+static bool OTA_DbRecordUsed(const OTA_DB_RECORD *rec) {
+    return rec->status != OTA_DB_STATUS_ERASED
+            && rec->status > OTA_DB_STATUS_DISABLED
+            && rec->crc == OTA_DbRecordCrc(rec);
+}
+
+static bool OTA_DbHeaderValid(const OTA_DB_HEADER *hdr) {
+    return hdr->magic == OTA_DB_MAGIC
+            && hdr->format == OTA_DB_FORMAT_VERSION
+            && hdr->record_size == sizeof (OTA_DB_RECORD)
+            && hdr->slots != 0 && hdr->slots <= OTA_DB_MAX_IMAGES
+            && hdr->crc == OTA_DbCrc32(hdr, offsetof(OTA_DB_HEADER, crc));
+}
+
+static void OTA_DbRecordFill(OTA_DB_RECORD *rec, uint8_t status, uint32_t version,
+        const char *name, const char *type, const char *digest) {
+    const char *base = strrchr(name, '/');
+
+    memset(rec, 0, sizeof (OTA_DB_RECORD));
+    rec->status = status;
+    memset(rec->reserved, 0xFF, sizeof (rec->reserved));
+    rec->version = version;
+    strncpy(rec->name, (base != NULL) ? base + 1 : name, OTA_DB_NAME_LEN - 1);
+    if (type != NULL)
+        strncpy(rec->type, type, OTA_DB_TYPE_LEN - 1);
+    if (digest != NULL)
+        strncpy(rec->digest, digest, OTA_DB_DIGEST_LEN);
+    rec->crc = OTA_DbRecordCrc(rec);
 }
 
 /*
- ** Get row nuber of a particular image
+ ** Write the whole database. The header goes last so that an interrupted
+ ** write leaves a file without a valid header.
  */
-int GetImageRow(uint32_t ImgVersion, OTA_DB_BUFFER *imageDB) {
-    int selected_row = -1;
-    size_t csv_field_read_size = 30;
-    char *csv_field_read = malloc(csv_field_read_size + 1);
-    if (csv_field_read == NULL)
+static int OTA_DbWriteAll(OTA_DB *db) {
+    SYS_FS_HANDLE fd;
+    OTA_DB_HEADER blank;
+    size_t len = db->hdr.slots * sizeof (OTA_DB_RECORD);
+    int ret = -1;
+
+    fd = SYS_FS_FileOpen(db->file_name, SYS_FS_FILE_OPEN_WRITE);
+    if (fd == SYS_FS_HANDLE_INVALID)
         return -1;
-    uint8_t num_rows = csv_get_height((CSV_BUFFER *) imageDB);
-    int r;
-    uint32_t ver = 0;
-    for (r = 0; r < num_rows; r++) {
-
-        csv_get_field(csv_field_read, csv_field_read_size, (CSV_BUFFER *) imageDB, r, OTA_IMAGE_VERSION);
-        ver = (uint8_t) strtol(csv_field_read, NULL, 16);
-        if (ver == ImgVersion) {
-            selected_row = r;
-        }
-    }
-    return selected_row;
+    memset(&blank, 0xFF, sizeof (blank));
+    if (SYS_FS_FileWrite(fd, &blank, sizeof (blank)) == sizeof (blank)
+            && SYS_FS_FileWrite(fd, db->rec, len) == len
+            && SYS_FS_FileSeek(fd, 0, SYS_FS_SEEK_SET) == 0
+            && SYS_FS_FileWrite(fd, &db->hdr, sizeof (db->hdr)) == sizeof (db->hdr))
+        ret = 0;
+    SYS_FS_FileClose(fd);
+    return ret;
 }
 
 /*
- ** Get the database entry into a buffer
+ ** Write part of one record in place
  */
-int OTAGetDb(OTA_DB_BUFFER *imageDB, char *file_name) {
-    return (csv_load((CSV_BUFFER *) imageDB, file_name));
+static int OTA_DbWriteAt(OTA_DB *db, uint32_t offset, const void *data, size_t len) {
+    SYS_FS_HANDLE fd;
+    int ret = -1;
+
+    fd = SYS_FS_FileOpen(db->file_name, SYS_FS_FILE_OPEN_READ_PLUS);
+    if (fd == SYS_FS_HANDLE_INVALID)
+        return -1;
+    if (SYS_FS_FileSeek(fd, offset, SYS_FS_SEEK_SET) == (int32_t) offset
+            && SYS_FS_FileWrite(fd, data, len) == len)
+        ret = 0;
+    SYS_FS_FileClose(fd);
+    return ret;
 }
 
-/*
- ** Get the database entry into a buffer
- */
-int OTASaveDb(OTA_DB_BUFFER *imageDB, char *file_name) {
-    return (csv_save(file_name, (CSV_BUFFER *) imageDB));
+static void OTA_DbCreate(OTA_DB *db) {
+    memset(&db->hdr, 0, sizeof (db->hdr));
+    db->hdr.magic = OTA_DB_MAGIC;
+    db->hdr.format = OTA_DB_FORMAT_VERSION;
+    db->hdr.slots = OTA_DB_MAX_IMAGES;
+    db->hdr.record_size = sizeof (OTA_DB_RECORD);
+    db->hdr.crc = OTA_DbCrc32(&db->hdr, offsetof(OTA_DB_HEADER, crc));
+    memset(db->rec, 0xFF, sizeof (db->rec));
+    db->used = 0;
+}
+
+/* csv_get_field terminates at dest[dest_len], truncation is accepted */
+static bool OTA_DbCsvField(CSV_BUFFER *csv, int row, int entry, char *dest, size_t size) {
+    return csv_get_field(dest, size - 1, csv, row, entry) <= 1;
 }
 
 /*
- ** Make a new entry in external flash OTA database
+ ** Convert a CSV database written by an older release
  */
-int OTADbNewEntry(char *file_name, OTA_DB_ENTRY *image_data) {
+static OTA_DB_LOAD_RESULT OTA_DbMigrate(OTA_DB *db, const char *csv_name) {
+    CSV_BUFFER *csv;
+    char field[OTA_DB_DIGEST_LEN + 2];
+    char name[OTA_DB_NAME_LEN];
+    char type[OTA_DB_TYPE_LEN];
+    uint8_t status;
+    uint32_t version;
+    int rows, r;
+    uint8_t slot = 0;
 
-    if (file_name == NULL || image_data == NULL)
-        return -1;
-
-    CSV_BUFFER *imageDB = csv_create_buffer();
-    if (imageDB == NULL)
-        return -1;
+    csv = csv_create_buffer();
+    if (csv == NULL)
+        return OTA_DB_LOAD_ERROR;
+    r = csv_load(csv, (char *) csv_name);
+    if (r != 0) {
+        csv_destroy_buffer(csv);
+        return (r == 1) ? OTA_DB_LOAD_EMPTY : OTA_DB_LOAD_ERROR;
+    }
 
-    char data_entry[1000];
-    int row = 0;
-    int status = csv_load(imageDB, file_name);
-    if (status == 1)
-        row = 0;
-    else if (status == 0) {
-        row = csv_get_height(imageDB);
-        if (image_data->db_full == true) {
-            uint8_t total_images = GetTotalImgs(imageDB);
-            #ifdef DEBUG
-            SYS_CONSOLE_DEBUG1("total_images : %d\n", total_images);
-            #endif
-            uint32_t ver = 0;
-            uint32_t version_l = 255;
-            uint8_t i;
-            for (i = 0; i < total_images; i++) {
-                if (GetFieldValue_32Bit((OTA_DB_BUFFER *)imageDB, OTA_IMAGE_VERSION, i, &ver) != 0) {
-                    #ifdef DEBUG
-                    SYS_CONSOLE_DEBUG1("Image version field not read properly\n");
-                    #endif
-                    return SYS_STATUS_ERROR;
-                }
-                if (version_l > ver) {
-                    version_l = ver;
-                    row = i;
-                }
-            }
-        }
-    } else {
-        csv_destroy_buffer(imageDB);
-        return -1;
+    OTA_DbCreate(db);
+    rows = csv_get_height(csv);
+    for (r = 0; r < rows && slot < OTA_DB_MAX_IMAGES; r++) {
+        if (!OTA_DbCsvField(csv, r, 0, name, sizeof (name))
+                || !OTA_DbCsvField(csv, r, 1, field, sizeof (field)))
+            continue;
+        status = (uint8_t) strtol(field, NULL, 16);
+        if (!OTA_DbCsvField(csv, r, 2, field, sizeof (field)))
+            continue;
+        version = strtol(field, NULL, 16);
+        if (!OTA_DbCsvField(csv, r, 3, type, sizeof (type)))
+            type[0] = '\0';
+        if (!OTA_DbCsvField(csv, r, 4, field, sizeof (field)))
+            field[0] = '\0';
+        OTA_DbRecordFill(&db->rec[slot], status, version, name, type, field);
+        if (OTA_DbRecordUsed(&db->rec[slot]))
+            db->used |= 1UL << slot;
+        slot++;
     }
+    csv_destroy_buffer(csv);
     #ifdef DEBUG
-    SYS_CONSOLE_DEBUG1("\n\n row : %d\n\n", row);
+    SYS_CONSOLE_DEBUG1("migrated %d of %d CSV rows\n", slot, rows);
     #endif
-    char ver[4];
-    sprintf(ver, "%d", image_data->version);
-    strcpy(data_entry, strrchr(image_data->image_name, '/') + 1);
-    if (csv_set_field(imageDB, row, 0, data_entry) != 0) {
-        csv_destroy_buffer(imageDB);
-        return -1;
-    }
-    if (csv_set_field(imageDB, row, 1, "FE") != 0) {
-        csv_destroy_buffer(imageDB);
-        return -1;
-    }
-    if (csv_set_field(imageDB, row, 2, ver) != 0) {
-        csv_destroy_buffer(imageDB);
-        return -1;
-    }
-    if (csv_set_field(imageDB, row, 3, image_data->type) != 0) {
-        csv_destroy_buffer(imageDB);
-        return -1;
-    }
-    if (csv_set_field(imageDB, row, 4, image_data->digest) != 0) {
-        csv_destroy_buffer(imageDB);
-        return -1;
-    }
-    if (csv_save(file_name, imageDB) != 0) {
-        csv_destroy_buffer(imageDB);
-        return -1;
-    }
-    csv_destroy_buffer(imageDB);
-    return 0;
+
+    if (OTA_DbWriteAll(db) != 0)
+        return OTA_DB_LOAD_ERROR;
+    SYS_FS_FileDirectoryRemove(csv_name);
+    return OTA_DB_LOAD_OK;
 }
 
 /*
- ** Get number of images
+ ** Load the image database
  */
-uint8_t GetTotalImgs(OTA_DB_BUFFER *imageDB) {
-    return (csv_get_height((CSV_BUFFER *) imageDB));
+OTA_DB_LOAD_RESULT OTA_DbLoad(OTA_DB *db, const char *file_name, const char *csv_name) {
+    SYS_FS_HANDLE fd;
+    size_t len;
+    uint8_t slot;
+
+    memset(db, 0, sizeof (OTA_DB));
+    db->file_name = file_name;
+
+    fd = SYS_FS_FileOpen(file_name, SYS_FS_FILE_OPEN_READ);
+    if (fd != SYS_FS_HANDLE_INVALID) {
+        /* Header and records are contiguous in OTA_DB */
+        len = SYS_FS_FileRead(fd, &db->hdr, sizeof (db->hdr) + sizeof (db->rec));
+        SYS_FS_FileClose(fd);
+        if (len != (size_t) -1 && len >= sizeof (db->hdr) && OTA_DbHeaderValid(&db->hdr)) {
+            len -= sizeof (db->hdr);
+            for (slot = 0; slot < db->hdr.slots; slot++) {
+                if ((slot + 1) * sizeof (OTA_DB_RECORD) > len)
+                    memset(&db->rec[slot], 0xFF, sizeof (OTA_DB_RECORD));
+                else if (OTA_DbRecordUsed(&db->rec[slot]))
+                    db->used |= 1UL << slot;
+            }
+            return OTA_DB_LOAD_OK;
+        }
+    }
+
+    memset(&db->hdr, 0, sizeof (db->hdr));
+    if (csv_name == NULL)
+        return OTA_DB_LOAD_EMPTY;
+    return OTA_DbMigrate(db, csv_name);
 }
 
 /*
- ** Get Image Field value
+ ** Number of slots in the database
  */
-uint8_t GetFieldValue(OTA_DB_BUFFER *imageDB, OTA_DB_FIELD_TYPE field, uint8_t selected_row, uint8_t *field_value) {
-    uint8_t field_status = 0;
-    size_t csv_field_read_size = 30;
-    char *csv_field_read = malloc(csv_field_read_size + 1);
-    if (csv_get_field(csv_field_read, csv_field_read_size, (CSV_BUFFER *) imageDB, selected_row, (size_t) field) == 0) {
-        field_status = 0;
-        *field_value = (uint8_t) strtol(csv_field_read, NULL, 16);
-        #ifdef DEBUG
-        printf("ctx->img.status : %x\n", (uint8_t) strtol(csv_field_read, NULL, 16));
-        printf("*field_value : %x\n", *field_value);
-        #endif
-    } else {
-        field_status = 1;
-    }
-    free(csv_field_read);
-    return field_status;
+uint8_t OTA_DbSlots(const OTA_DB *db) {
+    return db->hdr.slots;
 }
 
 /*
- ** Get Image 32 bit Field value 
+ ** Record held by a slot
  */
-uint8_t GetFieldValue_32Bit(OTA_DB_BUFFER *imageDB, OTA_DB_FIELD_TYPE field, uint8_t selected_row, uint32_t *field_value) {
-    uint8_t field_status = 0;
-    size_t csv_field_read_size = 30;
-    char *csv_field_read = OSAL_Malloc(csv_field_read_size + 1);
-    if (csv_get_field(csv_field_read, csv_field_read_size, (CSV_BUFFER *) imageDB, selected_row, (size_t) field) == 0) {
-        field_status = 0;
-        *field_value =  strtol(csv_field_read, NULL, 16);
-        #ifdef OTA_DB_DEBUG
-        SYS_CONSOLE_PRINT("SYS_OTA_DB : ctx->img.status : %x\r\n", (uint8_t) strtol(csv_field_read, NULL, 16));
-        SYS_CONSOLE_PRINT("SYS_OTA_DB : *field_value : %x\r\n", *field_value);
-        #endif
-    } else {
-        field_status = 1;
-    }
-    OSAL_Free(csv_field_read);
-    return field_status;
+const OTA_DB_RECORD *OTA_DbRecord(const OTA_DB *db, uint8_t slot) {
+    if (slot >= db->hdr.slots || (db->used & (1UL << slot)) == 0)
+        return NULL;
+    return &db->rec[slot];
 }
 
 /*
- ** Get Image Field string
+ ** Slot holding an image version
  */
-uint8_t GetFieldString(OTA_DB_BUFFER *imageDB, OTA_DB_FIELD_TYPE field, uint8_t selected_row, char *field_value) {
-    uint8_t field_status = 0;
-    size_t csv_field_read_size = 100;
-    char *csv_field_read = malloc(csv_field_read_size + 1);
-    if (csv_get_field(csv_field_read, csv_field_read_size, (CSV_BUFFER *) imageDB, selected_row, (size_t) field) == 0) {
-        field_status = 0;
-        strcpy(field_value, csv_field_read);
-        #ifdef DEBUG
-        SYS_CONSOLE_DEBUG1("*field_value : %s\n", field_value);
-        #endif
-    } else {
-        field_status = 1;
+int OTA_DbFindVersion(const OTA_DB *db, uint32_t version) {
+    uint32_t used = db->used;
+    int slot;
+
+    for (slot = 0; used != 0; slot++, used >>= 1) {
+        if ((used & 1) && db->rec[slot].version == version)
+            return slot;
     }
-    free(csv_field_read);
-    return field_status;
+    return -1;
 }
 
 /*
- ** Set Image Field value
+ ** Update the status of an image in place
  */
-uint8_t SetFieldValue(OTA_DB_BUFFER *imageDB, OTA_DB_FIELD_TYPE field, uint8_t selected_row, char *field_value) {
-    uint8_t field_status = 0;
-    if (csv_set_field((CSV_BUFFER *) imageDB, selected_row, 1, field_value) == 0) {
-        field_status = 0;
-    } else {
-        field_status = 1;
-    }
-    return field_status;
+int OTA_DbSetStatus(OTA_DB *db, uint8_t slot, uint8_t status) {
+    OTA_DB_RECORD *rec;
+
+    if (OTA_DbRecord(db, slot) == NULL)
+        return -1;
+    rec = &db->rec[slot];
+    if ((rec->status & status) != status)
+        return -1;
+    if (rec->status == status)
+        return 0;
+    if (OTA_DbWriteAt(db, OTA_DB_RECORD_OFFSET(slot) + offsetof(OTA_DB_RECORD, status), &status, 1) != 0)
+        return -1;
+    rec->status = status;
+    if (status <= OTA_DB_STATUS_DISABLED)
+        db->used &= ~(1UL << slot);
+    return 0;
 }
 
 /*
- ** Delete entry from external flash OTA database
+ ** Make a new entry in the image database
  */
-int OTADbDeleteEntry(OTA_DB_BUFFER *imageDB, uint8_t selected_row) {
-    if (csv_remove_row((CSV_BUFFER *) imageDB, selected_row) == -1)
+int OTA_DbNewEntry(OTA_DB *db, OTA_DB_ENTRY *image_data) {
+    uint32_t version_l = 0xFFFFFFFF;
+    int slot = -1;
+    uint8_t i;
+
+    if (db == NULL || image_data == NULL || image_data->image_name == NULL)
         return -1;
-    return 0;
+
+    if (db->hdr.slots == 0) {
+        OTA_DbCreate(db);
+        if (OTA_DbWriteAll(db) != 0)
+            return -1;
+    }
+
+    for (i = 0; i < db->hdr.slots; i++) {
+        if ((db->used & (1UL << i)) == 0) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot == -1) {
+        if (image_data->db_full == false)
+            return -1;
+        for (i = 0; i < db->hdr.slots; i++) {
+            if (version_l > db->rec[i].version) {
+                version_l = db->rec[i].version;
+                slot = i;
+            }
+        }
+    }
+    #ifdef DEBUG
+    SYS_CONSOLE_DEBUG1("\n\n slot : %d\n\n", slot);
+    #endif
+
+    /* A torn write fails the record CRC, leaving the slot free */
+    OTA_DbRecordFill(&db->rec[slot], OTA_DB_STATUS_DOWNLOADED, image_data->version,
+            image_data->image_name, image_data->type, image_data->digest);
+    if (OTA_DbWriteAt(db, OTA_DB_RECORD_OFFSET(slot), &db->rec[slot], sizeof (OTA_DB_RECORD)) != 0) {
+        db->used &= ~(1UL << slot);
+        return -1;
+    }
+    db->used |= 1UL << slot;
+    return slot;
 }
-#endif
\ No newline at end of file
+#endif
@@ -30,10 +30,24 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
     database_parser.c
     
   Summary:
-    Interface for the Bootloader library.
+    Interface for the OTA image database.
 
   Description:
-    This file contains the interface definition for the OTA library.
+    The image database lives next to the images in the OTA directory. It is
+    a fixed-record binary file:
+
+      offset  size             field
+      0       16               OTA_DB_HEADER
+      16      128 per slot     OTA_DB_RECORD, one per image slot
+
+    Each record carries its own CRC, so a record torn by a power cut reads
+    back as a free slot instead of corrupting its neighbours. The status byte
+    sits outside the CRC and only ever moves along the IMG_STATUS bit-clear
+    sequence (0xFF -> 0xFE -> 0xFC -> 0xF8 -> 0xF0), which is done in place
+    by rewriting that single byte.
+
+    Older releases kept the database as a CSV file. OTA_DbLoad converts it to
+    the binary format the first time it finds one and removes the CSV.
 *******************************************************************************/
 
 
@@ -52,128 +66,143 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 #include "osal/osal.h"
 #include "../bootloader/csv/csv.h"
 
-typedef struct OTA_DB_FIELD {
-        char *text;
-        size_t length;
-} OTA_DB_FIELD;
-typedef struct OTA_DB_BUFFER {
-        OTA_DB_FIELD ***field;
-        size_t rows;
-        size_t *width; 
-        char field_delim;
-        char text_delim;
-} OTA_DB_BUFFER;
+#define OTA_DB_MAGIC                0x4244544FUL    /* "OTDB" */
+#define OTA_DB_FORMAT_VERSION       1
+
+/* Number of image slots a new database is created with */
+#ifndef OTA_DB_MAX_IMAGES
+#define OTA_DB_MAX_IMAGES           8
+#endif
+
+#define OTA_DB_TYPE_LEN             8
+#define OTA_DB_NAME_LEN             44
+#define OTA_DB_DIGEST_LEN           64
+
+/* Record status values, same encoding as IMG_STATUS */
+#define OTA_DB_STATUS_ERASED        0xFF
+#define OTA_DB_STATUS_DOWNLOADED    0xFE
+#define OTA_DB_STATUS_DISABLED      0xF0
+
+typedef struct OTA_DB_HEADER {
+        uint32_t magic;
+        uint8_t format;
+        uint8_t slots;
+        uint16_t record_size;
+        uint32_t reserved;
+        uint32_t crc;                       /* CRC-32 of the fields above */
+} OTA_DB_HEADER;
+
+typedef struct OTA_DB_RECORD {
+        uint8_t status;                     /* IMG_STATUS, not covered by crc */
+        uint8_t reserved[3];
+        uint32_t version;
+        char type[OTA_DB_TYPE_LEN];         /* NUL terminated */
+        char name[OTA_DB_NAME_LEN];         /* NUL terminated, no directory */
+        char digest[OTA_DB_DIGEST_LEN];     /* SHA-256 in hex, not terminated */
+        uint32_t crc;                       /* CRC-32 of version..digest */
+} OTA_DB_RECORD;
+
+#define OTA_DB_RECORD_OFFSET(slot)  (sizeof (OTA_DB_HEADER) + (slot) * sizeof (OTA_DB_RECORD))
+
+/* Image database loaded into RAM */
+typedef struct OTA_DB {
+        const char *file_name;
+        OTA_DB_HEADER hdr;
+        OTA_DB_RECORD rec[OTA_DB_MAX_IMAGES];
+        uint32_t used;                      /* Bit n set if slot n holds an image */
+} OTA_DB;
+
 typedef struct OTA_DB_ENTRY {
         char *image_name;
-        char *status;
         uint32_t version;
         char *type;
         char *digest;
+        char *digest_sign;
         bool db_full;
 } OTA_DB_ENTRY;
+
 typedef enum {
-    OTA_IMAGE_NAME = 0,
-    OTA_IMAGE_STATUS,
-    OTA_IMAGE_VERSION,
-    OTA_IMAGE_TYPE,
-    OTA_IMAGE_DIGEST        
-} OTA_DB_FIELD_TYPE;
+    /* Database loaded */
+    OTA_DB_LOAD_OK = 0,
+
+    /* Neither the database nor a CSV database to migrate exists */
+    OTA_DB_LOAD_EMPTY,
+
+    /* File system error */
+    OTA_DB_LOAD_ERROR
+} OTA_DB_LOAD_RESULT;
+
 /*******************************************************************************
   Function:
-    void open_data_base ( void )
+    OTA_DB_LOAD_RESULT OTA_DbLoad(OTA_DB *db, const char *file_name, const char *csv_name)
 
   Summary:
- Open ota database file
+    Loads the image database.
 
   Description:
- This routine will create a database file 
-
-  Precondition:
-    
+    Reads the header and all records of file_name in a single read. If
+    file_name is missing or has no valid header and csv_name exists, the CSV
+    database is converted to file_name and then removed.
 
   Parameters:
-    None.
+    db        - Database to fill. file_name is kept for later updates.
+    file_name - Path of the binary database.
+    csv_name  - Path of a CSV database left by an older release, or NULL.
 
   Returns:
-    0: success
-    1: error opening database file
-
-  Example:
-    <code>
-    APP_Tasks();
-    </code>
-
-  Remarks:
-    This routine must be called from SYS_Tasks() routine.
- */
-    
-    
-// int open_data_base();
-/* Function: modify_field
- * -----------------------
- * modify a field text to the string provided. . 
- * 
- * Returns:
- *  0: success
- *  1: error allocating space to the string
- */
- int modify_field(size_t row, size_t entry,char *field);
- 
- 
- /*
- ** Get buffer for image data base in the external flash
- */
- OTA_DB_BUFFER *OTA_GetDBBuffer();
- 
- 
- /*
- ** Get row nuber of a particular image
+    OTA_DB_LOAD_RESULT
  */
-int GetImageRow(uint32_t ImgVersion, OTA_DB_BUFFER *imageDB);
-
+OTA_DB_LOAD_RESULT OTA_DbLoad(OTA_DB *db, const char *file_name, const char *csv_name);
 
 /*
- ** Get the database entry into a buffer
+ ** Number of slots in the database
  */
-int OTAGetDb(OTA_DB_BUFFER *imageDB, char *file_name);
+uint8_t OTA_DbSlots(const OTA_DB *db);
 
 /*
- ** Get the database entry into a buffer
+ ** Record held by a slot, NULL if the slot is free
  */
-int OTASaveDb(OTA_DB_BUFFER *imageDB, char *file_name);
+const OTA_DB_RECORD *OTA_DbRecord(const OTA_DB *db, uint8_t slot);
 
 /*
- ** Get number of images
+ ** Slot holding an image version, -1 if there is none
  */
-uint8_t GetTotalImgs();
+int OTA_DbFindVersion(const OTA_DB *db, uint32_t version);
 
-/*
- ** Get Image Field value
- */
-uint8_t GetFieldValue(OTA_DB_BUFFER *imageDB, OTA_DB_FIELD_TYPE field, uint8_t selected_row, uint8_t *field_value );
+/*******************************************************************************
+  Function:
+    int OTA_DbSetStatus(OTA_DB *db, uint8_t slot, uint8_t status)
 
-/*
- ** Get Image 32 bit Field value 
- */
-uint8_t GetFieldValue_32Bit(OTA_DB_BUFFER *imageDB, OTA_DB_FIELD_TYPE field, uint8_t selected_row, uint32_t *field_value);
+  Summary:
+    Updates the status of an image in place.
 
-/*
- ** Set Image Field value
- */
-uint8_t SetFieldValue(OTA_DB_BUFFER *imageDB, OTA_DB_FIELD_TYPE field, uint8_t selected_row, char *field_value );
+  Description:
+    Only the status byte of the record is written. Setting
+    OTA_DB_STATUS_DISABLED frees the slot.
 
-/*
- ** Make a new entry in external flash OTA database
+  Returns:
+    0: success
+    -1: the slot is free, the new status would set bits that are already
+        cleared, or the write failed
  */
-int OTADbNewEntry(char *file_name, OTA_DB_ENTRY *image_data);
+int OTA_DbSetStatus(OTA_DB *db, uint8_t slot, uint8_t status);
 
-/*
- ** Get Image Field string
- */
-uint8_t GetFieldString(OTA_DB_BUFFER *imageDB, OTA_DB_FIELD_TYPE field, uint8_t selected_row, char *field_value);
+/*******************************************************************************
+  Function:
+    int OTA_DbNewEntry(OTA_DB *db, OTA_DB_ENTRY *image_data)
 
-int OTADbDeleteEntry(OTA_DB_BUFFER *imageDB, uint8_t selected_row) ;
+  Summary:
+    Makes a new entry in the image database.
 
+  Description:
+    The entry is marked OTA_DB_STATUS_DOWNLOADED and goes into the first free
+    slot. If all slots are in use and
+    image_data->db_full is set, the image with the lowest version is
+    replaced. The database file is created if it does not exist yet.
 
+  Returns:
+    Slot of the new entry, or -1 on error or if the database is full.
+ */
+int OTA_DbNewEntry(OTA_DB *db, OTA_DB_ENTRY *image_data);
 
-#endif
\ No newline at end of file
+#endif
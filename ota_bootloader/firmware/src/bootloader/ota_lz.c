@@ -0,0 +1,263 @@
+/*******************************************************************************
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    ota_lz.c
+
+  Summary:
+    Streaming decompressor for the compressed OTA image container.
+
+  Description:
+    See ota_lz.h for the container format.
+ *******************************************************************************/
+
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+Copyright (c) 2020-2021 released Microchip Technology Inc.  All rights reserved.
+
+Microchip licenses to you the right to use, modify, copy and distribute
+Software only when embedded on a Microchip microcontroller or digital signal
+controller that is integrated into your product or third party product
+(pursuant to the sublicense terms in the accompanying license agreement).
+
+You should refer to the license agreement accompanying this Software for
+additional information regarding your rights and obligations.
+
+SOFTWARE AND DOCUMENTATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF
+MERCHANTABILITY, TITLE, NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE.
+IN NO EVENT SHALL MICROCHIP OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER
+CONTRACT, NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR
+OTHER LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE OR
+CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT OF
+SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+(INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+ *******************************************************************************/
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <string.h>
+#include "ota_lz.h"
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Functions
+// *****************************************************************************
+// *****************************************************************************
+
+static uint32_t ota_lz_get32(const uint8_t *p) {
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+/* Copy literals to the output and into the window */
+static void ota_lz_literals(OTA_LZ_CTX *lz, uint8_t *out, const uint8_t *in, uint32_t n) {
+    uint32_t pos = lz->window_pos;
+    uint32_t room = lz->window_mask + 1 - pos;
+
+    memcpy(out, in, n);
+    if (n > lz->window_mask + 1) {
+        /* Only the tail stays in the window */
+        in += n - (lz->window_mask + 1);
+        n = lz->window_mask + 1;
+    }
+    if (n <= room) {
+        memcpy(&lz->window[pos], in, n);
+    } else {
+        memcpy(&lz->window[pos], in, room);
+        memcpy(lz->window, in + room, n - room);
+    }
+    lz->window_pos = (pos + n) & lz->window_mask;
+}
+
+/* Copy match bytes from the window; source and destination may overlap */
+static void ota_lz_match(OTA_LZ_CTX *lz, uint8_t *out, uint32_t n) {
+    uint8_t *window = lz->window;
+    uint32_t mask = lz->window_mask;
+    uint32_t dst = lz->window_pos;
+    uint32_t src = (dst - lz->offset) & mask;
+
+    while (n--) {
+        uint8_t c = window[src];
+        window[dst] = c;
+        *out++ = c;
+        src = (src + 1) & mask;
+        dst = (dst + 1) & mask;
+    }
+    lz->window_pos = dst;
+}
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Routines
+// *****************************************************************************
+// *****************************************************************************
+
+bool OTA_LZ_HeaderParse(const uint8_t *buf, uint32_t len, OTA_LZ_HEADER *hdr) {
+    if (len < OTA_LZ_HEADER_SIZE || memcmp(buf, "OTAZ", 4) != 0 || buf[4] != OTA_LZ_VERSION) {
+        return false;
+    }
+    hdr->window_bits = buf[5];
+    hdr->raw_len = ota_lz_get32(&buf[8]);
+    hdr->packed_len = ota_lz_get32(&buf[12]);
+    return true;
+}
+
+bool OTA_LZ_Init(OTA_LZ_CTX *lz, const OTA_LZ_HEADER *hdr, uint8_t *window, uint32_t window_size) {
+    if (hdr->window_bits == 0 || hdr->window_bits > OTA_LZ_WINDOW_BITS_MAX
+            || window_size < (1UL << hdr->window_bits)) {
+        return false;
+    }
+    memset(lz, 0, sizeof (OTA_LZ_CTX));
+    lz->raw_len = hdr->raw_len;
+    lz->window = window;
+    lz->window_mask = (1UL << hdr->window_bits) - 1;
+    lz->state = (hdr->raw_len == 0) ? OTA_LZ_STATE_DONE : OTA_LZ_STATE_TOKEN;
+    return true;
+}
+
+int32_t OTA_LZ_Decompress(OTA_LZ_CTX *lz, const uint8_t *in, uint32_t *in_len, uint8_t *out, uint32_t out_len) {
+    const uint8_t *ip = in;
+    const uint8_t *iend = in + *in_len;
+    uint8_t *op = out;
+    uint8_t *oend = out + out_len;
+    uint32_t n;
+
+    for (;;) {
+        switch (lz->state) {
+            case OTA_LZ_STATE_TOKEN:
+            {
+                if (ip == iend) {
+                    goto out;
+                }
+                lz->literals = *ip >> 4;
+                lz->match = *ip & 0x0F;
+                ip++;
+                lz->state = (lz->literals == 15) ? OTA_LZ_STATE_LITERAL_LENGTH : OTA_LZ_STATE_LITERALS;
+                break;
+            }
+            case OTA_LZ_STATE_LITERAL_LENGTH:
+            {
+                if (ip == iend) {
+                    goto out;
+                }
+                lz->literals += *ip;
+                if (*ip++ != 255) {
+                    lz->state = OTA_LZ_STATE_LITERALS;
+                }
+                break;
+            }
+            case OTA_LZ_STATE_LITERALS:
+            {
+                if (lz->literals > lz->raw_len - lz->out_len) {
+                    lz->state = OTA_LZ_STATE_ERROR;
+                    break;
+                }
+                n = lz->literals;
+                if (n > (uint32_t) (iend - ip)) {
+                    n = iend - ip;
+                }
+                if (n > (uint32_t) (oend - op)) {
+                    n = oend - op;
+                }
+                if (n != 0) {
+                    ota_lz_literals(lz, op, ip, n);
+                    ip += n;
+                    op += n;
+                    lz->out_len += n;
+                    lz->literals -= n;
+                }
+                if (lz->literals != 0) {
+                    goto out;
+                }
+                lz->state = (lz->out_len == lz->raw_len) ? OTA_LZ_STATE_DONE : OTA_LZ_STATE_OFFSET_LO;
+                break;
+            }
+            case OTA_LZ_STATE_OFFSET_LO:
+            {
+                if (ip == iend) {
+                    goto out;
+                }
+                lz->offset = *ip++;
+                lz->state = OTA_LZ_STATE_OFFSET_HI;
+                break;
+            }
+            case OTA_LZ_STATE_OFFSET_HI:
+            {
+                if (ip == iend) {
+                    goto out;
+                }
+                lz->offset |= (uint32_t) *ip++ << 8;
+                if (lz->offset == 0 || lz->offset > lz->window_mask + 1 || lz->offset > lz->out_len) {
+                    lz->state = OTA_LZ_STATE_ERROR;
+                    break;
+                }
+                if (lz->match == 15) {
+                    lz->state = OTA_LZ_STATE_MATCH_LENGTH;
+                } else {
+                    lz->match += OTA_LZ_MIN_MATCH;
+                    lz->state = OTA_LZ_STATE_MATCH;
+                }
+                break;
+            }
+            case OTA_LZ_STATE_MATCH_LENGTH:
+            {
+                if (ip == iend) {
+                    goto out;
+                }
+                lz->match += *ip;
+                if (*ip++ != 255) {
+                    lz->match += OTA_LZ_MIN_MATCH;
+                    lz->state = OTA_LZ_STATE_MATCH;
+                }
+                break;
+            }
+            case OTA_LZ_STATE_MATCH:
+            {
+                if (lz->match > lz->raw_len - lz->out_len) {
+                    lz->state = OTA_LZ_STATE_ERROR;
+                    break;
+                }
+                n = lz->match;
+                if (n > (uint32_t) (oend - op)) {
+                    n = oend - op;
+                }
+                if (n != 0) {
+                    ota_lz_match(lz, op, n);
+                    op += n;
+                    lz->out_len += n;
+                    lz->match -= n;
+                }
+                if (lz->match != 0) {
+                    goto out;
+                }
+                lz->state = (lz->out_len == lz->raw_len) ? OTA_LZ_STATE_DONE : OTA_LZ_STATE_TOKEN;
+                break;
+            }
+            case OTA_LZ_STATE_DONE:
+            {
+                goto out;
+            }
+            case OTA_LZ_STATE_ERROR:
+            default:
+            {
+                *in_len = ip - in;
+                return -1;
+            }
+        }
+    }
+
+out:
+    *in_len = ip - in;
+    return op - out;
+}
+
+bool OTA_LZ_Done(const OTA_LZ_CTX *lz) {
+    return (lz->state == OTA_LZ_STATE_DONE);
+}
@@ -47,13 +47,25 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 #define ROTLEFT(a,b) (((a) << (b)) | ((a) >> (32-(b))))
 #define ROTRIGHT(a,b) (((a) >> (b)) | ((a) << (32-(b))))
 
-#define CH(x,y,z) (((x) & (y)) ^ (~(x) & (z)))
-#define MAJ(x,y,z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define CH(x,y,z) ((z) ^ ((x) & ((y) ^ (z))))
+#define MAJ(x,y,z) (((x) & (y)) | ((z) & ((x) | (y))))
 #define EP0(x) (ROTRIGHT(x,2) ^ ROTRIGHT(x,13) ^ ROTRIGHT(x,22))
 #define EP1(x) (ROTRIGHT(x,6) ^ ROTRIGHT(x,11) ^ ROTRIGHT(x,25))
 #define SIG0(x) (ROTRIGHT(x,7) ^ ROTRIGHT(x,18) ^ ((x) >> 3))
 #define SIG1(x) (ROTRIGHT(x,17) ^ ROTRIGHT(x,19) ^ ((x) >> 10))
 
+#define LOAD32_BE(p) (((uint32_t)(p)[0] << 24) | ((uint32_t)(p)[1] << 16) | \
+                      ((uint32_t)(p)[2] << 8) | ((uint32_t)(p)[3]))
+
+// One compression round. Instead of shifting the eight working variables
+// down, the caller rotates the argument order, so after eight rounds every
+// variable is back in its own slot.
+#define ROUND(a,b,c,d,e,f,g,h,i) do { \
+	t1 = (h) + EP1(e) + CH(e,f,g) + k[i] + m[i]; \
+	(d) += t1; \
+	(h) = t1 + EP0(a) + MAJ(a,b,c); \
+} while (0)
+
 /**************************** VARIABLES *****************************/
 static const uint32_t k[64] = {
 	0x428a2f98,0x71374491,0xb5c0fbcf,0xe9b5dba5,0x3956c25b,0x59f111f1,0x923f82a4,0xab1c5ed5,
@@ -67,12 +79,12 @@ static const uint32_t k[64] = {
 };
 
 /*********************** FUNCTION DEFINITIONS ***********************/
-void sha256_transform(SHA256_CTX *ctx, const uint8_t data[])
+static void sha256_transform(SHA256_SW_CTX *ctx, const uint8_t data[])
 {
-	uint32_t a, b, c, d, e, f, g, h, i, j, t1, t2, m[64];
+	uint32_t a, b, c, d, e, f, g, h, i, t1, m[64];
 
-	for (i = 0, j = 0; i < 16; ++i, j += 4)
-		m[i] = (data[j] << 24) | (data[j + 1] << 16) | (data[j + 2] << 8) | (data[j + 3]);
+	for (i = 0; i < 16; ++i)
+		m[i] = LOAD32_BE(&data[i * 4]);
 	for ( ; i < 64; ++i)
 		m[i] = SIG1(m[i - 2]) + m[i - 7] + SIG0(m[i - 15]) + m[i - 16];
 
@@ -85,6 +97,10 @@ void sha256_transform(SHA256_CTX *ctx, const uint8_t data[])
 	g = ctx->state[6];
 	h = ctx->state[7];
 
+#ifdef SHA256_SMALL
+	// Compact variant for builds where code size matters more than speed.
+	uint32_t t2;
+
 	for (i = 0; i < 64; ++i) {
 		t1 = h + EP1(e) + CH(e,f,g) + k[i] + m[i];
 		t2 = EP0(a) + MAJ(a,b,c);
@@ -97,6 +113,18 @@ void sha256_transform(SHA256_CTX *ctx, const uint8_t data[])
 		b = a;
 		a = t1 + t2;
 	}
+#else
+	for (i = 0; i < 64; i += 8) {
+		ROUND(a,b,c,d,e,f,g,h,i);
+		ROUND(h,a,b,c,d,e,f,g,i + 1);
+		ROUND(g,h,a,b,c,d,e,f,i + 2);
+		ROUND(f,g,h,a,b,c,d,e,i + 3);
+		ROUND(e,f,g,h,a,b,c,d,i + 4);
+		ROUND(d,e,f,g,h,a,b,c,i + 5);
+		ROUND(c,d,e,f,g,h,a,b,i + 6);
+		ROUND(b,c,d,e,f,g,h,a,i + 7);
+	}
+#endif
 
 	ctx->state[0] += a;
 	ctx->state[1] += b;
@@ -108,7 +136,7 @@ void sha256_transform(SHA256_CTX *ctx, const uint8_t data[])
 	ctx->state[7] += h;
 }
 
-void sha256_init(SHA256_CTX *ctx)
+static void sha256_sw_init(SHA256_SW_CTX *ctx)
 {
 	ctx->datalen = 0;
 	ctx->bitlen = 0;
@@ -122,22 +150,39 @@ void sha256_init(SHA256_CTX *ctx)
 	ctx->state[7] = 0x5be0cd19;
 }
 
-void sha256_update(SHA256_CTX *ctx, const uint8_t data[], size_t len)
+static void sha256_sw_update(SHA256_SW_CTX *ctx, const uint8_t data[], size_t len)
 {
-	uint32_t i;
+	size_t n;
 
-	for (i = 0; i < len; ++i) {
-		ctx->data[ctx->datalen] = data[i];
-		ctx->datalen++;
-		if (ctx->datalen == 64) {
-			sha256_transform(ctx, ctx->data);
-			ctx->bitlen += 512;
-			ctx->datalen = 0;
-		}
+	// Top up a partially filled block first.
+	if (ctx->datalen) {
+		n = 64 - ctx->datalen;
+		if (n > len)
+			n = len;
+		memcpy(&ctx->data[ctx->datalen], data, n);
+		ctx->datalen += n;
+		data += n;
+		len -= n;
+		if (ctx->datalen < 64)
+			return;
+		sha256_transform(ctx, ctx->data);
+		ctx->bitlen += 512;
+		ctx->datalen = 0;
 	}
+
+	// Whole blocks are hashed straight from the caller's buffer.
+	while (len >= 64) {
+		sha256_transform(ctx, data);
+		ctx->bitlen += 512;
+		data += 64;
+		len -= 64;
+	}
+
+	memcpy(ctx->data, data, len);
+	ctx->datalen = len;
 }
 
-void sha256_final(SHA256_CTX *ctx, uint8_t hash[])
+static void sha256_sw_final(SHA256_SW_CTX *ctx, uint8_t hash[])
 {
 	uint32_t i;
 
@@ -182,3 +227,63 @@ void sha256_final(SHA256_CTX *ctx, uint8_t hash[])
 		hash[i + 28] = (ctx->state[7] >> (24 - i * 8)) & 0x000000ff;
 	}
 }
+
+void sha256_init(SHA256_CTX *ctx)
+{
+	ctx->hw_len = 0;
+	sha256_sw_init(&ctx->u.sw);
+}
+
+void sha256_size_set(SHA256_CTX *ctx, uint32_t len)
+{
+#if (SHA256_BACKEND == SHA256_BACKEND_PIC32MZ)
+	if (len == 0)
+		return;
+
+	if (ctx->hw_len == 0) {
+		// Too late to move to the engine once the C backend has seen data.
+		if (ctx->u.sw.datalen != 0 || ctx->u.sw.bitlen != 0)
+			return;
+		if (wc_InitSha256(&ctx->u.hw) != 0) {
+			sha256_sw_init(&ctx->u.sw);
+			return;
+		}
+	}
+	wc_Sha256SizeSet(&ctx->u.hw, len);
+	ctx->hw_len = len;
+#else
+	(void)ctx;
+	(void)len;
+#endif
+}
+
+void sha256_update(SHA256_CTX *ctx, const uint8_t data[], size_t len)
+{
+#if (SHA256_BACKEND == SHA256_BACKEND_PIC32MZ)
+	if (ctx->hw_len) {
+		wc_Sha256Update(&ctx->u.hw, data, len);
+		return;
+	}
+#endif
+	sha256_sw_update(&ctx->u.sw, data, len);
+}
+
+int sha256_final(SHA256_CTX *ctx, uint8_t hash[])
+{
+#if (SHA256_BACKEND == SHA256_BACKEND_PIC32MZ)
+	if (ctx->hw_len) {
+		int ret;
+
+		ctx->hw_len = 0;
+		ret = wc_Sha256Final(&ctx->u.hw, hash);
+		if (ret != 0) {
+			// The engine refuses to finish when the data added does not
+			// match the announced size; never hand back a usable digest.
+			memset(hash, 0, CRYPT_SHA256_DIGEST_SIZE);
+		}
+		return ret;
+	}
+#endif
+	sha256_sw_final(&ctx->u.sw, hash);
+	return 0;
+}
@@ -36,8 +36,39 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 /*************************** HEADER FILES ***************************/
 #include <stddef.h>
 #include <stdint.h>
+#include "configuration.h"
 /****************************** MACROS ******************************/
+/* Hash backends behind the CRYPT_SHA256_* interface below.
+ *
+ * SHA256_BACKEND_C       - portable C implementation in sha256.c.
+ * SHA256_BACKEND_PIC32MZ - streams the message through the crypto engine
+ *                          buffer descriptor ring (wolfCrypt PIC32MZ large
+ *                          hash). The engine has to know the message length
+ *                          up front, so a context only runs on the engine
+ *                          when CRYPT_SHA256_DataSizeSet() is called before
+ *                          the first CRYPT_SHA256_DataAdd(); everything else
+ *                          falls back to the C backend. The engine is held
+ *                          from the first DataAdd until Finalize. Needs the
+ *                          wolfCrypt PIC32MZ port, i.e. WOLFSSL_PIC32MZ_HASH
+ *                          and WOLFSSL_MICROCHIP_PIC32MZ.
+ *
+ * The bootloader configuration builds the C backend.
+ */
+#define SHA256_BACKEND_C            0
+#define SHA256_BACKEND_PIC32MZ      1
 
+#ifndef SHA256_BACKEND
+#if defined(WOLFSSL_PIC32MZ_HASH) && defined(WOLFSSL_MICROCHIP_PIC32MZ)
+#define SHA256_BACKEND              SHA256_BACKEND_PIC32MZ
+#else
+#define SHA256_BACKEND              SHA256_BACKEND_C
+#endif
+#endif
+
+#if (SHA256_BACKEND == SHA256_BACKEND_PIC32MZ)
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/wolfcrypt/sha256.h>
+#endif
 
 /**************************** DATA TYPES ****************************/
 //typedef unsigned char BYTE;             // 8-bit byte
@@ -48,18 +79,29 @@ typedef struct {
 	uint32_t datalen;
 	unsigned long long bitlen;
 	uint32_t state[8];
+} SHA256_SW_CTX;
+
+typedef struct {
+	uint32_t hw_len;          // Message length handed to the engine, 0 when on the C backend
+	union {
+		SHA256_SW_CTX sw;
+#if (SHA256_BACKEND == SHA256_BACKEND_PIC32MZ)
+		wc_Sha256 hw;
+#endif
+	} u;
 } SHA256_CTX;
 
 /*********************** FUNCTION DECLARATIONS **********************/
 void sha256_init(SHA256_CTX *ctx);
+void sha256_size_set(SHA256_CTX *ctx, uint32_t len);
 void sha256_update(SHA256_CTX *ctx, const uint8_t data[], size_t len);
-void sha256_final(SHA256_CTX *ctx, uint8_t hash[]);
+int sha256_final(SHA256_CTX *ctx, uint8_t hash[]);
 
 
 #define CRYPT_SHA256_CTX                        SHA256_CTX
 #define CRYPT_SHA256_DIGEST_SIZE 				32
 #define CRYPT_SHA256_Initialize(ctx)			sha256_init(ctx)
-#define CRYPT_SHA256_DataSizeSet(ctx, len)
+#define CRYPT_SHA256_DataSizeSet(ctx, len)		sha256_size_set(ctx, len)
 #define CRYPT_SHA256_DataAdd(ctx, buf, len)		sha256_update(ctx, buf, len)
 #define CRYPT_SHA256_Finalize(ctx, digest)		sha256_final(ctx, digest)
 